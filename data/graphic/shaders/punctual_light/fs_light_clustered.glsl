@@ -0,0 +1,141 @@
+
+#ifndef __INCLUDE_FS_LIGHT_CLUSTERED_GLSL__
+#define __INCLUDE_FS_LIGHT_CLUSTERED_GLSL__
+
+#include "common.glsl"
+#include "common_global.glsl"
+#include "common_light.glsl"
+#include "common_gbuffer.glsl"
+
+// -----------------------------------------------------------------------------
+// Input from engine
+// -----------------------------------------------------------------------------
+struct SPunctualLight
+{
+    vec4 m_Position;
+    vec4 m_Direction;
+    vec4 m_Color;
+    vec4 m_Settings; // InvSqrAttenuationRadius, AngleScale, AngleOffset, Unused
+};
+
+layout(std140, binding = 1) uniform UB1
+{
+    uvec4 ps_ClusterGrid;        // TilesX, TilesY, Slices, ExposureHistoryIndex
+    vec4  ps_ClusterSliceParams; // Scale, Bias, Unused, Unused
+};
+
+layout(std430, binding = 0) buffer UExposureHistoryBuffer
+{
+    float ps_ExposureHistory[8];
+};
+
+layout(std430, binding = 1) readonly buffer ULightBuffer
+{
+    SPunctualLight ps_Lights[];
+};
+
+layout(std430, binding = 2) readonly buffer UClusterBuffer
+{
+    uvec2 ps_Clusters[]; // Offset, NumberOfLights
+};
+
+layout(std430, binding = 3) readonly buffer ULightIndexBuffer
+{
+    uint ps_LightIndices[];
+};
+
+layout(binding = 0) uniform sampler2D ps_GBuffer0;
+layout(binding = 1) uniform sampler2D ps_GBuffer1;
+layout(binding = 2) uniform sampler2D ps_GBuffer2;
+layout(binding = 3) uniform sampler2D ps_Depth;
+
+// -----------------------------------------------------------------------------
+// Input
+// -----------------------------------------------------------------------------
+layout(location = 2) in vec2 in_UV;
+
+// -----------------------------------------------------------------------------
+// Output
+// -----------------------------------------------------------------------------
+layout (location = 0) out vec4 out_Output;
+
+// -----------------------------------------------------------------------------
+// Cluster of a pixel; has to match Gfx::CLightClusterBinner
+// -----------------------------------------------------------------------------
+uint GetClusterIndex(in vec2 _UV, in float _ViewDepth)
+{
+    uvec2 Tile  = min(uvec2(_UV * vec2(ps_ClusterGrid.xy)), ps_ClusterGrid.xy - 1u);
+    int   Slice = int(floor(log(max(_ViewDepth, 1e-4f)) * ps_ClusterSliceParams.x + ps_ClusterSliceParams.y));
+
+    uint ClampedSlice = uint(clamp(Slice, 0, int(ps_ClusterGrid.z) - 1));
+
+    return (ClampedSlice * ps_ClusterGrid.y + Tile.y) * ps_ClusterGrid.x + Tile.x;
+}
+
+// -----------------------------------------------------------------------------
+// Main
+// -----------------------------------------------------------------------------
+void main()
+{
+    // -----------------------------------------------------------------------------
+    // Get data
+    // -----------------------------------------------------------------------------
+    vec4  GBuffer0 = texture(ps_GBuffer0, in_UV);
+    vec4  GBuffer1 = texture(ps_GBuffer1, in_UV);
+    vec4  GBuffer2 = texture(ps_GBuffer2, in_UV);
+    float VSDepth  = texture(ps_Depth   , in_UV).r;
+
+    // -----------------------------------------------------------------------------
+    // VS position
+    // -----------------------------------------------------------------------------
+    vec3 VSPosition = GetViewSpacePositionFromDepth(VSDepth, in_UV, g_ScreenToView);
+
+    // -----------------------------------------------------------------------------
+    // WS position
+    // -----------------------------------------------------------------------------
+    vec3 WSPosition = (g_ViewToWorld * vec4(VSPosition, 1.0f)).xyz;
+
+    // -----------------------------------------------------------------------------
+    // Surface data
+    // -----------------------------------------------------------------------------
+    SSurfaceData Data;
+
+    UnpackGBuffer(GBuffer0, GBuffer1, GBuffer2, WSPosition.xyz, VSDepth, Data);
+
+    // -----------------------------------------------------------------------------
+    // Exposure data
+    // -----------------------------------------------------------------------------
+    float AverageExposure = ps_ExposureHistory[ps_ClusterGrid.w];
+
+    // -----------------------------------------------------------------------------
+    // Only the lights binned into the cluster of this pixel are shaded
+    // -----------------------------------------------------------------------------
+    uvec2 Cluster = ps_Clusters[GetClusterIndex(in_UV, -VSPosition.z)];
+
+    vec3 WSViewDirection = normalize(g_ViewPosition.xyz - Data.m_WSPosition);
+
+    vec3 Luminance = vec3(0.0f);
+
+    for (uint IndexOfLight = 0u; IndexOfLight < Cluster.y; ++ IndexOfLight)
+    {
+        SPunctualLight Light = ps_Lights[ps_LightIndices[Cluster.x + IndexOfLight]];
+
+        float LightInvSqrAttenuationRadius = Light.m_Settings.x;
+        float LightAngleScale              = Light.m_Settings.y;
+        float LightAngleOffset             = Light.m_Settings.z;
+
+        vec3 UnnormalizedLightVector = Light.m_Position.xyz - Data.m_WSPosition;
+        vec3 NormalizedLightVector   = normalize(UnnormalizedLightVector);
+
+        float Attenuation = 1.0f;
+
+        Attenuation *= GetDistanceAttenuation(UnnormalizedLightVector, LightInvSqrAttenuationRadius);
+        Attenuation *= GetAngleAttenuation(NormalizedLightVector, -Light.m_Direction.xyz, LightAngleScale, LightAngleOffset);
+
+        Luminance += BRDF(NormalizedLightVector, WSViewDirection, Data.m_WSNormal, Data) * clamp(dot(Data.m_WSNormal, NormalizedLightVector), 0.0f, 1.0f) * Light.m_Color.xyz * Attenuation;
+    }
+
+    out_Output = vec4(Luminance * Data.m_AmbientOcclusion * AverageExposure, 0.0f);
+}
+
+#endif // __INCLUDE_FS_LIGHT_CLUSTERED_GLSL__
@@ -0,0 +1,81 @@
+#include "benchmark_precompiled.h"
+
+#include "benchmark_defines.h"
+
+#include "base/base_compression.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+    const unsigned int g_NumberOfBytes = 16 * 1024 * 1024;
+
+    // -----------------------------------------------------------------------------
+    // RGBA texture with smooth gradients and a little noise
+    // -----------------------------------------------------------------------------
+    std::vector<char> CreateTexture()
+    {
+        std::vector<char> Texture(g_NumberOfBytes);
+
+        std::mt19937 Generator(1);
+
+        for (unsigned int IndexOfByte = 0; IndexOfByte < g_NumberOfBytes; ++IndexOfByte)
+        {
+            Texture[IndexOfByte] = static_cast<char>(((IndexOfByte >> 4) & 0xFF) + (Generator() % 4 == 0 ? 1 : 0));
+        }
+
+        return Texture;
+    }
+} // namespace
+
+BASE_BENCHMARK(Benchmark_Base_Compression_Compress_16MB)
+{
+    const std::vector<char> Texture = CreateTexture();
+
+    std::vector<char> Compressed;
+
+    _rState.SetNumberOfBytesPerIteration(g_NumberOfBytes);
+
+    while (_rState.Run())
+    {
+        Base::Compress(Texture, Compressed, 1);
+
+        Base::Benchmark::DoNotOptimize(Compressed.data());
+    }
+}
+
+BASE_BENCHMARK(Benchmark_Base_Compression_CompressParallel_16MB)
+{
+    const std::vector<char> Texture = CreateTexture();
+
+    std::vector<char> Compressed;
+
+    _rState.SetNumberOfBytesPerIteration(g_NumberOfBytes);
+
+    while (_rState.Run())
+    {
+        Base::CompressParallel(Texture.data(), Texture.size(), Compressed, 1);
+
+        Base::Benchmark::DoNotOptimize(Compressed.data());
+    }
+}
+
+BASE_BENCHMARK(Benchmark_Base_Compression_Decompress_16MB)
+{
+    const std::vector<char> Texture = CreateTexture();
+
+    std::vector<char> Compressed;
+    std::vector<char> Decompressed;
+
+    Base::Compress(Texture, Compressed, 1);
+
+    _rState.SetNumberOfBytesPerIteration(g_NumberOfBytes);
+
+    while (_rState.Run())
+    {
+        Base::Decompress(Compressed, Decompressed);
+
+        Base::Benchmark::DoNotOptimize(Decompressed.data());
+    }
+}
@@ -0,0 +1,38 @@
+
+#include "benchmark_precompiled.h"
+
+#include "benchmark_defines.h"
+
+#include "base/base_crc.h"
+
+#include <vector>
+
+namespace
+{
+    void HashBuffer(Base::Benchmark::CState& _rState, unsigned int _NumberOfBytes)
+    {
+        std::vector<unsigned char> Buffer(_NumberOfBytes);
+
+        for (unsigned int IndexOfByte = 0; IndexOfByte < _NumberOfBytes; ++IndexOfByte)
+        {
+            Buffer[IndexOfByte] = static_cast<unsigned char>(IndexOfByte * 31);
+        }
+
+        _rState.SetNumberOfBytesPerIteration(_NumberOfBytes);
+
+        while (_rState.Run())
+        {
+            Base::Benchmark::DoNotOptimize(Base::CRC32(Buffer.data(), _NumberOfBytes));
+        }
+    }
+} // namespace
+
+BASE_BENCHMARK(Benchmark_Base_CRC32_64B)
+{
+    HashBuffer(_rState, 64);
+}
+
+BASE_BENCHMARK(Benchmark_Base_CRC32_1MB)
+{
+    HashBuffer(_rState, 1 << 20);
+}
@@ -0,0 +1,70 @@
+
+#include "benchmark_precompiled.h"
+
+#include "benchmark_defines.h"
+
+#include "base/base_memory.h"
+#include "base/base_memory_arena.h"
+
+namespace
+{
+    const unsigned int g_NumberOfChunks = 64;
+    const unsigned int g_NumberOfBytes  = 4096;
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Temporary buffers like the ones of the mesh generators
+// -----------------------------------------------------------------------------
+BASE_BENCHMARK(Benchmark_Base_Memory_Heap)
+{
+    void* pChunks[g_NumberOfChunks];
+
+    _rState.SetNumberOfItemsPerIteration(g_NumberOfChunks);
+
+    while (_rState.Run())
+    {
+        for (void*& rpChunk : pChunks) rpChunk = Base::CMemory::Allocate(g_NumberOfBytes);
+
+        Base::Benchmark::DoNotOptimize(pChunks);
+
+        for (void* pChunk : pChunks) Base::CMemory::Free(pChunk);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_BENCHMARK(Benchmark_Base_Memory_Scratch)
+{
+    void* pChunks[g_NumberOfChunks];
+
+    _rState.SetNumberOfItemsPerIteration(g_NumberOfChunks);
+
+    while (_rState.Run())
+    {
+        Base::CScratchScope Scratch;
+
+        for (void*& rpChunk : pChunks) rpChunk = Scratch.Allocate(g_NumberOfBytes);
+
+        Base::Benchmark::DoNotOptimize(pChunks);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_BENCHMARK(Benchmark_Base_Memory_FrameArena)
+{
+    Base::CMemoryArena Arena(64 * 1024, Base::CMemory::Frame);
+
+    void* pChunks[g_NumberOfChunks];
+
+    _rState.SetNumberOfItemsPerIteration(g_NumberOfChunks);
+
+    while (_rState.Run())
+    {
+        for (void*& rpChunk : pChunks) rpChunk = Arena.Allocate(g_NumberOfBytes);
+
+        Base::Benchmark::DoNotOptimize(pChunks);
+
+        Arena.Reset();
+    }
+}
@@ -0,0 +1,76 @@
+
+#include "benchmark_precompiled.h"
+
+#include "benchmark_defines.h"
+
+#include "base/base_pool.h"
+
+#include <vector>
+
+namespace
+{
+    struct SItem
+    {
+        float m_Values[16];
+    };
+
+    const unsigned int g_NumberOfItems = 1024;
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Items are recycled through the free list, pages are only allocated once
+// -----------------------------------------------------------------------------
+BASE_BENCHMARK(Benchmark_Base_Pool_AllocateFree)
+{
+    Base::CPool<SItem> Pool;
+
+    std::vector<SItem*> Items(g_NumberOfItems);
+
+    _rState.SetNumberOfItemsPerIteration(g_NumberOfItems);
+
+    while (_rState.Run())
+    {
+        for (SItem*& rpItem : Items) rpItem = &Pool.Allocate();
+
+        Base::Benchmark::DoNotOptimize(Items.data());
+
+        for (SItem* pItem : Items) Pool.Free(pItem);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Reference for the pool above
+// -----------------------------------------------------------------------------
+BASE_BENCHMARK(Benchmark_Base_Pool_NewDelete)
+{
+    std::vector<SItem*> Items(g_NumberOfItems);
+
+    _rState.SetNumberOfItemsPerIteration(g_NumberOfItems);
+
+    while (_rState.Run())
+    {
+        for (SItem*& rpItem : Items) rpItem = new SItem;
+
+        Base::Benchmark::DoNotOptimize(Items.data());
+
+        for (SItem* pItem : Items) delete pItem;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// A new pool allocates its pages through Base::CMemory on every iteration
+// -----------------------------------------------------------------------------
+BASE_BENCHMARK(Benchmark_Base_Pool_Fill)
+{
+    _rState.SetNumberOfItemsPerIteration(g_NumberOfItems);
+
+    while (_rState.Run())
+    {
+        Base::CPool<SItem> Pool;
+
+        for (unsigned int IndexOfItem = 0; IndexOfItem < g_NumberOfItems; ++IndexOfItem)
+        {
+            Base::Benchmark::DoNotOptimize(Pool.Allocate());
+        }
+    }
+}
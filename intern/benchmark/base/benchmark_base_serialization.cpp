@@ -0,0 +1,137 @@
+
+#include "benchmark_precompiled.h"
+
+#include "benchmark_defines.h"
+
+#include "base/base_serialize_std_vector.h"
+#include "base/base_serialize_text_reader.h"
+#include "base/base_serialize_text_writer.h"
+#include "base/base_serialize_binary_reader.h"
+#include "base/base_serialize_binary_writer.h"
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const unsigned int g_NumberOfValues = 100000;
+
+    std::vector<float> CreateValues()
+    {
+        std::mt19937 Generator(17);
+
+        std::uniform_real_distribution<float> Distribution(-1000.0f, 1000.0f);
+
+        std::vector<float> Values(g_NumberOfValues);
+
+        for (float& rValue : Values) rValue = Distribution(Generator);
+
+        return Values;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    std::string WriteText(const std::vector<float>& _rValues)
+    {
+        std::stringstream Stream;
+
+        {
+            Base::CTextWriter Writer(Stream, 1);
+
+            Writer.WritePrimitives(_rValues.data(), static_cast<unsigned int>(_rValues.size()));
+        }
+
+        return Stream.str();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    std::string WriteBinary(const std::vector<float>& _rValues)
+    {
+        std::stringstream Stream;
+
+        {
+            Base::CBinaryWriter Writer(Stream, 1);
+
+            Base::Write(Writer, _rValues);
+        }
+
+        return Stream.str();
+    }
+} // namespace
+
+BASE_BENCHMARK(Benchmark_Base_Serialize_Text_Write)
+{
+    const std::vector<float> Values = CreateValues();
+
+    _rState.SetNumberOfItemsPerIteration(g_NumberOfValues);
+    _rState.SetNumberOfBytesPerIteration(WriteText(Values).size());
+
+    while (_rState.Run())
+    {
+        Base::Benchmark::DoNotOptimize(WriteText(Values));
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_BENCHMARK(Benchmark_Base_Serialize_Text_Read)
+{
+    std::vector<float> Values = CreateValues();
+
+    const std::string Text = WriteText(Values);
+
+    _rState.SetNumberOfItemsPerIteration(g_NumberOfValues);
+    _rState.SetNumberOfBytesPerIteration(Text.size());
+
+    while (_rState.Run())
+    {
+        std::istringstream Stream(Text);
+
+        Base::CTextReader Reader(Stream, 1);
+
+        Reader.ReadPrimitives(Values.data(), g_NumberOfValues);
+
+        Base::Benchmark::DoNotOptimize(Values.data());
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_BENCHMARK(Benchmark_Base_Serialize_Binary_Write)
+{
+    const std::vector<float> Values = CreateValues();
+
+    _rState.SetNumberOfItemsPerIteration(g_NumberOfValues);
+    _rState.SetNumberOfBytesPerIteration(WriteBinary(Values).size());
+
+    while (_rState.Run())
+    {
+        Base::Benchmark::DoNotOptimize(WriteBinary(Values));
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_BENCHMARK(Benchmark_Base_Serialize_Binary_Read)
+{
+    std::vector<float> Values = CreateValues();
+
+    const std::string Data = WriteBinary(Values);
+
+    _rState.SetNumberOfItemsPerIteration(g_NumberOfValues);
+    _rState.SetNumberOfBytesPerIteration(Data.size());
+
+    while (_rState.Run())
+    {
+        std::istringstream Stream(Data);
+
+        Base::CBinaryReader Reader(Stream, 1);
+
+        Base::Read(Reader, Values);
+
+        Base::Benchmark::DoNotOptimize(Values.data());
+    }
+}
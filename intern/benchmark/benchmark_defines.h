@@ -0,0 +1,30 @@
+
+#pragma once
+
+#include "benchmark_suite.h"
+
+#include "base/base_defines.h"
+
+// -----------------------------------------------------------------------------
+// Only the loop is measured:
+//
+//     BASE_BENCHMARK(Benchmark_Base_Something)
+//     {
+//         Setup();
+//
+//         while (_rState.Run())
+//         {
+//             Base::Benchmark::DoNotOptimize(Something());
+//         }
+//     }
+// -----------------------------------------------------------------------------
+#define BASE_BENCHMARK(BenchmarkFunction)                                                               \
+    void BenchmarkFunction(::UT::Benchmark::CState& _rState);                                           \
+    struct BASE_CONCAT(SReg, BenchmarkFunction)                                                         \
+    {                                                                                                   \
+        BASE_CONCAT(SReg, BenchmarkFunction)()                                                          \
+        {                                                                                               \
+            ::UT::Benchmark::RegisterBenchmark(#BenchmarkFunction, BenchmarkFunction);                  \
+        }                                                                                               \
+    } const BASE_CONCAT(g_Reg, BenchmarkFunction);                                                      \
+    void BenchmarkFunction(::UT::Benchmark::CState& _rState)                                            \
@@ -0,0 +1,158 @@
+
+#include "benchmark_precompiled.h"
+
+#include "benchmark_suite.h"
+
+#include "base/base_getopt.h"
+
+#include "engine/core/core_program_parameters.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+// -----------------------------------------------------------------------------
+// Containers and other std allocations never pass Base::CMemory, so the
+// global operator new of the benchmark executable counts them, on every
+// thread. Only this file replaces it, so the libraries the benchmarks link
+// keep the default one. Where the executable's operator new is used by the
+// shared libraries (Linux, Android, macOS) this includes the engine module;
+// on Windows a DLL keeps its own operator new and only the allocations of
+// the benchmark executable and the code compiled into it are counted.
+// -----------------------------------------------------------------------------
+void* operator new(std::size_t _NumberOfBytes)
+{
+    Base::Benchmark::CountAllocation(_NumberOfBytes);
+
+    void* pChunk = std::malloc(_NumberOfBytes > 0 ? _NumberOfBytes : 1);
+
+    if (pChunk == nullptr) throw std::bad_alloc();
+
+    return pChunk;
+}
+
+// -----------------------------------------------------------------------------
+
+void* operator new[](std::size_t _NumberOfBytes)
+{
+    return operator new(_NumberOfBytes);
+}
+
+// -----------------------------------------------------------------------------
+
+void* operator new(std::size_t _NumberOfBytes, const std::nothrow_t&) noexcept
+{
+    Base::Benchmark::CountAllocation(_NumberOfBytes);
+
+    return std::malloc(_NumberOfBytes > 0 ? _NumberOfBytes : 1);
+}
+
+// -----------------------------------------------------------------------------
+
+void* operator new[](std::size_t _NumberOfBytes, const std::nothrow_t& _rNoThrow) noexcept
+{
+    return operator new(_NumberOfBytes, _rNoThrow);
+}
+
+// -----------------------------------------------------------------------------
+
+void operator delete(void* _pChunk) noexcept
+{
+    std::free(_pChunk);
+}
+
+// -----------------------------------------------------------------------------
+
+void operator delete[](void* _pChunk) noexcept
+{
+    std::free(_pChunk);
+}
+
+// -----------------------------------------------------------------------------
+
+void operator delete(void* _pChunk, std::size_t) noexcept
+{
+    std::free(_pChunk);
+}
+
+// -----------------------------------------------------------------------------
+
+void operator delete[](void* _pChunk, std::size_t) noexcept
+{
+    std::free(_pChunk);
+}
+
+// -----------------------------------------------------------------------------
+
+void operator delete(void* _pChunk, const std::nothrow_t&) noexcept
+{
+    std::free(_pChunk);
+}
+
+// -----------------------------------------------------------------------------
+
+void operator delete[](void* _pChunk, const std::nothrow_t&) noexcept
+{
+    std::free(_pChunk);
+}
+
+int main(int _Argc, char* _pArgv[])
+{
+    Base::Benchmark::SOptions Options;
+
+    // -----------------------------------------------------------------------------
+    // -f filter, -j path to JSON, -s samples, -t min time per sample and
+    // -w warm-up time, both in milliseconds, -p option=value sets a program
+    // parameter for the benchmarks (like in the editor)
+    // -----------------------------------------------------------------------------
+    int MoreArguments;
+    for (; (MoreArguments = Base::GetOption(_Argc, _pArgv, "f:j:p:s:t:w:")) != -1; )
+    {
+        switch (MoreArguments)
+        {
+        case 'f':
+            Options.m_Filter = Base::GetArgument();
+            break;
+
+        case 'j':
+            Options.m_PathToJSON = Base::GetArgument();
+            break;
+
+        case 'p':
+        {
+            std::string Argument = Base::GetArgument();
+
+            size_t PositionOfEqual = Argument.find_first_of('=');
+
+            Core::CProgramParameters::GetInstance().Add(Argument.substr(0, PositionOfEqual), Argument.substr(PositionOfEqual + 1));
+            break;
+        }
+
+        case 's':
+            Options.m_NumberOfSamples = static_cast<unsigned int>(std::atoi(Base::GetArgument()));
+            break;
+
+        case 't':
+            Options.m_MinTimePerSample = std::atof(Base::GetArgument()) / 1000.0;
+            break;
+
+        case 'w':
+            Options.m_WarmUpTime = std::atof(Base::GetArgument()) / 1000.0;
+            break;
+
+        default:
+            std::cerr << "Usage: " << _pArgv[0] << " [-f filter] [-j results.json] [-p option=value] [-s samples] [-t ms per sample] [-w warm-up ms]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (Options.m_NumberOfSamples == 0) Options.m_NumberOfSamples = 1;
+
+    // -----------------------------------------------------------------------------
+    // Run benchmarks
+    // -----------------------------------------------------------------------------
+    unsigned int NumberOfBenchmarks = Base::Benchmark::RunBenchmarks(Options, std::cout);
+
+    return NumberOfBenchmarks > 0 ? 0 : 1;
+}
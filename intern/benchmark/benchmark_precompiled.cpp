@@ -0,0 +1,2 @@
+
+#include "benchmark_precompiled.h"
@@ -0,0 +1,787 @@
+
+#include "benchmark_precompiled.h"
+
+#include "benchmark_suite.h"
+
+#include "base/base_json.h"
+#include "base/base_memory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    std::atomic<Base::Size> g_NumberOfAllocations(0);
+    std::atomic<Base::Size> g_NumberOfAllocatedBytes(0);
+
+    const void* volatile g_pOptimizationSink = nullptr;
+
+    // -----------------------------------------------------------------------------
+
+    void OnAllocate(void* _pChunk, Base::Size _NumberOfBytes)
+    {
+        BASE_UNUSED(_pChunk);
+
+        UT::Benchmark::CountAllocation(_NumberOfBytes);
+    }
+} // namespace
+
+namespace
+{
+    class CBenchmarkSuite
+    {
+    public:
+
+        static CBenchmarkSuite& GetInstance();
+
+    public:
+
+        void RegisterBenchmark(const char* _pName, void (*_BenchmarkFtr)(UT::Benchmark::CState&));
+
+        unsigned int RunBenchmarks(const UT::Benchmark::SOptions& _rOptions, std::ostream& _rStream);
+
+    private:
+
+        struct SBenchmark
+        {
+            const char* m_pName;
+            void (*m_BenchmarkFtr)(UT::Benchmark::CState&);
+        };
+
+        struct SResult
+        {
+            const char*  m_pName;
+            unsigned int m_NumberOfIterations;      //< Per sample
+            double       m_MinTime;                 //< Seconds per iteration
+            double       m_MedianTime;
+            double       m_P95Time;
+            double       m_NumberOfAllocations;     //< Per iteration
+            double       m_NumberOfAllocatedBytes;
+            double       m_BytesPerSecond;          //< Zero if the benchmark does not report its work
+            double       m_ItemsPerSecond;
+            unsigned int m_NumberOfHistograms;
+            const char*  m_pHistogramNames[UT::Benchmark::CState::s_MaxNumberOfHistograms];
+            UT::Benchmark::CHistogram m_Histograms[UT::Benchmark::CState::s_MaxNumberOfHistograms];     //< Of all samples
+            unsigned int m_NumberOfCounters;
+            const char*  m_pCounterNames[UT::Benchmark::CState::s_MaxNumberOfCounters];
+            double       m_Counters[UT::Benchmark::CState::s_MaxNumberOfCounters];                      //< Of the last sample
+        };
+
+        using CBenchmarks = std::vector<SBenchmark>;
+        using CResults    = std::vector<SResult>;
+
+    private:
+
+        static const unsigned int s_MaxNumberOfIterations = 1000000000;
+
+    private:
+
+        CBenchmarks m_Benchmarks;
+
+    private:
+
+        bool RunBenchmark(const SBenchmark& _rBenchmark, const UT::Benchmark::SOptions& _rOptions, SResult& _rResult);
+
+        void LogResult(const SResult& _rResult, std::ostream& _rStream);
+        void WriteJSON(const CResults& _rResults, const UT::Benchmark::SOptions& _rOptions);
+
+        static void FormatTime(double _Time, char* _pText, int _MaxNumberOfChars);
+    };
+} // namespace
+
+namespace
+{
+    CBenchmarkSuite& CBenchmarkSuite::GetInstance()
+    {
+        static CBenchmarkSuite s_Instance;
+
+        return s_Instance;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CBenchmarkSuite::RegisterBenchmark(const char* _pName, void (*_BenchmarkFtr)(UT::Benchmark::CState&))
+    {
+        m_Benchmarks.push_back({ _pName, _BenchmarkFtr });
+    }
+
+    // -----------------------------------------------------------------------------
+
+    unsigned int CBenchmarkSuite::RunBenchmarks(const UT::Benchmark::SOptions& _rOptions, std::ostream& _rStream)
+    {
+        CResults Results;
+
+        Base::CMemory::SetHooks(&OnAllocate, nullptr);
+
+        char Header[256];
+
+        snprintf(Header, sizeof(Header), "%-48s %12s %10s %10s %10s %10s %12s %14s", "Benchmark", "Iterations", "Min", "Median", "P95", "Allocs/It", "Bytes/It", "Throughput");
+
+        _rStream << Header << std::endl;
+
+        for (const SBenchmark& rBenchmark : m_Benchmarks)
+        {
+            if (!_rOptions.m_Filter.empty() && std::string(rBenchmark.m_pName).find(_rOptions.m_Filter) == std::string::npos) continue;
+
+            SResult Result;
+
+            try
+            {
+                if (!RunBenchmark(rBenchmark, _rOptions, Result))
+                {
+                    _rStream << rBenchmark.m_pName << ": the benchmark has to loop until Run() returns false" << std::endl;
+
+                    continue;
+                }
+            }
+            catch (std::exception& _rException)
+            {
+                _rStream << rBenchmark.m_pName << ": " << _rException.what() << std::endl;
+
+                continue;
+            }
+
+            LogResult(Result, _rStream);
+
+            Results.push_back(Result);
+        }
+
+        Base::CMemory::SetHooks(nullptr, nullptr);
+
+        if (!_rOptions.m_PathToJSON.empty())
+        {
+            WriteJSON(Results, _rOptions);
+        }
+
+        return static_cast<unsigned int>(Results.size());
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CBenchmarkSuite::RunBenchmark(const SBenchmark& _rBenchmark, const UT::Benchmark::SOptions& _rOptions, SResult& _rResult)
+    {
+        // -----------------------------------------------------------------------------
+        // Warm up caches and lazy initializations while the number of
+        // iterations grows until one sample takes long enough to be measured
+        // reliably.
+        // -----------------------------------------------------------------------------
+        unsigned int NumberOfIterations = 1;
+
+        double WarmUpTime = 0.0;
+
+        for (;;)
+        {
+            UT::Benchmark::CState State(NumberOfIterations);
+
+            _rBenchmark.m_BenchmarkFtr(State);
+
+            if (!State.IsFinished()) return false;
+
+            const double Time = State.GetElapsedTime();
+
+            WarmUpTime += Time;
+
+            if (Time >= _rOptions.m_MinTimePerSample)
+            {
+                if (WarmUpTime >= _rOptions.m_WarmUpTime) break;
+
+                continue;
+            }
+
+            if (NumberOfIterations >= s_MaxNumberOfIterations) break;
+
+            double Factor = _rOptions.m_MinTimePerSample * 1.2 / std::max(Time, 1.0e-9);
+
+            Factor = std::min(std::max(Factor, 1.5), 10.0);
+
+            NumberOfIterations = static_cast<unsigned int>(std::min(std::ceil(NumberOfIterations * Factor), static_cast<double>(s_MaxNumberOfIterations)));
+        }
+
+        // -----------------------------------------------------------------------------
+        // Samples
+        // -----------------------------------------------------------------------------
+        std::vector<double> Times;
+
+        Base::Size NumberOfAllocations    = 0;
+        Base::Size NumberOfAllocatedBytes = 0;
+        Base::Size NumberOfBytes          = 0;
+        Base::Size NumberOfItems          = 0;
+
+        _rResult.m_NumberOfHistograms = 0;
+        _rResult.m_NumberOfCounters   = 0;
+
+        for (unsigned int IndexOfSample = 0; IndexOfSample < std::max(_rOptions.m_NumberOfSamples, 1u); ++IndexOfSample)
+        {
+            UT::Benchmark::CState State(NumberOfIterations);
+
+            _rBenchmark.m_BenchmarkFtr(State);
+
+            if (!State.IsFinished()) return false;
+
+            Times.push_back(State.GetReportedTime() / NumberOfIterations);
+
+            NumberOfAllocations    += State.GetNumberOfAllocations();
+            NumberOfAllocatedBytes += State.GetNumberOfAllocatedBytes();
+            NumberOfBytes           = State.GetNumberOfBytesPerIteration();
+            NumberOfItems           = State.GetNumberOfItemsPerIteration();
+
+            for (unsigned int IndexOfHistogram = 0; IndexOfHistogram < State.GetNumberOfHistograms(); ++IndexOfHistogram)
+            {
+                const char* pName = State.GetHistogramName(IndexOfHistogram);
+
+                unsigned int IndexOfResult = 0;
+
+                while (IndexOfResult < _rResult.m_NumberOfHistograms && std::strcmp(_rResult.m_pHistogramNames[IndexOfResult], pName) != 0) ++IndexOfResult;
+
+                if (IndexOfResult == _rResult.m_NumberOfHistograms)
+                {
+                    _rResult.m_pHistogramNames[IndexOfResult] = pName;
+
+                    _rResult.m_Histograms[IndexOfResult].Clear();
+
+                    ++_rResult.m_NumberOfHistograms;
+                }
+
+                _rResult.m_Histograms[IndexOfResult].Merge(State.GetHistogram(IndexOfHistogram));
+            }
+
+            _rResult.m_NumberOfCounters = State.GetNumberOfCounters();
+
+            for (unsigned int IndexOfCounter = 0; IndexOfCounter < State.GetNumberOfCounters(); ++IndexOfCounter)
+            {
+                _rResult.m_pCounterNames[IndexOfCounter] = State.GetCounterName(IndexOfCounter);
+                _rResult.m_Counters     [IndexOfCounter] = State.GetCounter(IndexOfCounter);
+            }
+        }
+
+        std::sort(Times.begin(), Times.end());
+
+        const double NumberOfMeasuredIterations = static_cast<double>(NumberOfIterations) * Times.size();
+
+        _rResult.m_pName                  = _rBenchmark.m_pName;
+        _rResult.m_NumberOfIterations     = NumberOfIterations;
+        _rResult.m_MinTime                = Times.front();
+        _rResult.m_MedianTime             = Times[Times.size() / 2];
+        _rResult.m_P95Time                = Times[static_cast<size_t>(std::ceil(0.95 * Times.size())) - 1];
+        _rResult.m_NumberOfAllocations    = NumberOfAllocations    / NumberOfMeasuredIterations;
+        _rResult.m_NumberOfAllocatedBytes = NumberOfAllocatedBytes / NumberOfMeasuredIterations;
+        _rResult.m_BytesPerSecond         = _rResult.m_MedianTime > 0.0 ? NumberOfBytes / _rResult.m_MedianTime : 0.0;
+        _rResult.m_ItemsPerSecond         = _rResult.m_MedianTime > 0.0 ? NumberOfItems / _rResult.m_MedianTime : 0.0;
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CBenchmarkSuite::LogResult(const SResult& _rResult, std::ostream& _rStream)
+    {
+        char MinTime   [32];
+        char MedianTime[32];
+        char P95Time   [32];
+        char Throughput[32] = "";
+
+        FormatTime(_rResult.m_MinTime   , MinTime   , sizeof(MinTime));
+        FormatTime(_rResult.m_MedianTime, MedianTime, sizeof(MedianTime));
+        FormatTime(_rResult.m_P95Time   , P95Time   , sizeof(P95Time));
+
+        if (_rResult.m_BytesPerSecond > 0.0)
+        {
+            snprintf(Throughput, sizeof(Throughput), "%.1f MiB/s", _rResult.m_BytesPerSecond / (1024.0 * 1024.0));
+        }
+        else if (_rResult.m_ItemsPerSecond >= 1.0e4)
+        {
+            snprintf(Throughput, sizeof(Throughput), "%.2f M/s", _rResult.m_ItemsPerSecond / 1.0e6);
+        }
+        else if (_rResult.m_ItemsPerSecond > 0.0)
+        {
+            snprintf(Throughput, sizeof(Throughput), "%.1f /s", _rResult.m_ItemsPerSecond);
+        }
+
+        char Line[256];
+
+        snprintf(Line, sizeof(Line), "%-48s %12u %10s %10s %10s %10.2f %12.1f %14s", _rResult.m_pName, _rResult.m_NumberOfIterations, MinTime, MedianTime, P95Time, _rResult.m_NumberOfAllocations, _rResult.m_NumberOfAllocatedBytes, Throughput);
+
+        _rStream << Line << std::endl;
+
+        // -----------------------------------------------------------------------------
+        // One line per histogram below the benchmark
+        // -----------------------------------------------------------------------------
+        for (unsigned int IndexOfHistogram = 0; IndexOfHistogram < _rResult.m_NumberOfHistograms; ++IndexOfHistogram)
+        {
+            const UT::Benchmark::CHistogram& rHistogram = _rResult.m_Histograms[IndexOfHistogram];
+
+            char P50Time[32];
+            char P95Time[32];
+            char P99Time[32];
+            char MaxTime[32];
+
+            FormatTime(rHistogram.GetPercentile(0.50), P50Time, sizeof(P50Time));
+            FormatTime(rHistogram.GetPercentile(0.95), P95Time, sizeof(P95Time));
+            FormatTime(rHistogram.GetPercentile(0.99), P99Time, sizeof(P99Time));
+            FormatTime(rHistogram.GetMax()           , MaxTime, sizeof(MaxTime));
+
+            snprintf(Line, sizeof(Line), "  %-46s %12llu p50 %10s p95 %10s p99 %10s max %10s", _rResult.m_pHistogramNames[IndexOfHistogram], static_cast<unsigned long long>(rHistogram.GetNumberOfSamples()), P50Time, P95Time, P99Time, MaxTime);
+
+            _rStream << Line << std::endl;
+        }
+
+        for (unsigned int IndexOfCounter = 0; IndexOfCounter < _rResult.m_NumberOfCounters; ++IndexOfCounter)
+        {
+            snprintf(Line, sizeof(Line), "  %-46s %12.4g", _rResult.m_pCounterNames[IndexOfCounter], _rResult.m_Counters[IndexOfCounter]);
+
+            _rStream << Line << std::endl;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CBenchmarkSuite::WriteJSON(const CResults& _rResults, const UT::Benchmark::SOptions& _rOptions)
+    {
+        nlohmann::json Benchmarks = nlohmann::json::array();
+
+        for (const SResult& rResult : _rResults)
+        {
+            nlohmann::json Benchmark;
+
+            Benchmark["name"]                          = rResult.m_pName;
+            Benchmark["iterations"]                    = rResult.m_NumberOfIterations;
+            Benchmark["min_ns"]                        = rResult.m_MinTime    * 1.0e9;
+            Benchmark["median_ns"]                     = rResult.m_MedianTime * 1.0e9;
+            Benchmark["p95_ns"]                        = rResult.m_P95Time    * 1.0e9;
+            Benchmark["allocations_per_iteration"]     = rResult.m_NumberOfAllocations;
+            Benchmark["allocated_bytes_per_iteration"] = rResult.m_NumberOfAllocatedBytes;
+            Benchmark["bytes_per_second"]              = rResult.m_BytesPerSecond;
+            Benchmark["items_per_second"]              = rResult.m_ItemsPerSecond;
+
+            if (rResult.m_NumberOfHistograms > 0)
+            {
+                nlohmann::json Latencies;
+
+                for (unsigned int IndexOfHistogram = 0; IndexOfHistogram < rResult.m_NumberOfHistograms; ++IndexOfHistogram)
+                {
+                    const UT::Benchmark::CHistogram& rHistogram = rResult.m_Histograms[IndexOfHistogram];
+
+                    nlohmann::json Latency;
+
+                    Latency["samples"] = rHistogram.GetNumberOfSamples();
+                    Latency["mean_ns"] = rHistogram.GetMean()              * 1.0e9;
+                    Latency["p50_ns"]  = rHistogram.GetPercentile(0.50) * 1.0e9;
+                    Latency["p95_ns"]  = rHistogram.GetPercentile(0.95) * 1.0e9;
+                    Latency["p99_ns"]  = rHistogram.GetPercentile(0.99) * 1.0e9;
+                    Latency["max_ns"]  = rHistogram.GetMax()               * 1.0e9;
+
+                    Latencies[rResult.m_pHistogramNames[IndexOfHistogram]] = Latency;
+                }
+
+                Benchmark["latencies"] = Latencies;
+            }
+
+            if (rResult.m_NumberOfCounters > 0)
+            {
+                nlohmann::json Counters;
+
+                for (unsigned int IndexOfCounter = 0; IndexOfCounter < rResult.m_NumberOfCounters; ++IndexOfCounter)
+                {
+                    Counters[rResult.m_pCounterNames[IndexOfCounter]] = rResult.m_Counters[IndexOfCounter];
+                }
+
+                Benchmark["counters"] = Counters;
+            }
+
+            Benchmarks.push_back(Benchmark);
+        }
+
+        nlohmann::json Document;
+
+        Document["samples"]    = _rOptions.m_NumberOfSamples;
+        Document["benchmarks"] = Benchmarks;
+
+        std::ofstream oStream(_rOptions.m_PathToJSON);
+
+        oStream << Document.dump(4) << std::endl;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CBenchmarkSuite::FormatTime(double _Time, char* _pText, int _MaxNumberOfChars)
+    {
+        if (_Time < 1.0e-6)
+        {
+            snprintf(_pText, _MaxNumberOfChars, "%.1f ns", _Time * 1.0e9);
+        }
+        else if (_Time < 1.0e-3)
+        {
+            snprintf(_pText, _MaxNumberOfChars, "%.2f us", _Time * 1.0e6);
+        }
+        else if (_Time < 1.0)
+        {
+            snprintf(_pText, _MaxNumberOfChars, "%.2f ms", _Time * 1.0e3);
+        }
+        else
+        {
+            snprintf(_pText, _MaxNumberOfChars, "%.2f s", _Time);
+        }
+    }
+} // namespace
+
+namespace UT
+{
+namespace Benchmark
+{
+    CHistogram::CHistogram()
+        : m_NumberOfSamples(0)
+        , m_SumOfTimes     (0.0)
+        , m_MaxTime        (0.0)
+    {
+        std::fill(m_Buckets, m_Buckets + s_NumberOfBuckets, 0);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CHistogram::Add(double _Time)
+    {
+        // -----------------------------------------------------------------------------
+        // The first bucket starts at 1 ns, shorter times are counted there
+        // -----------------------------------------------------------------------------
+        const double Octave = std::log2(std::max(_Time, 1.0e-9) * 1.0e9);
+
+        const unsigned int IndexOfBucket = static_cast<unsigned int>(std::min(Octave * s_NumberOfBucketsPerOctave, static_cast<double>(s_NumberOfBuckets - 1)));
+
+        ++m_Buckets[IndexOfBucket];
+
+        ++m_NumberOfSamples;
+
+        m_SumOfTimes += _Time;
+        m_MaxTime     = std::max(m_MaxTime, _Time);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CHistogram::Merge(const CHistogram& _rOther)
+    {
+        for (unsigned int IndexOfBucket = 0; IndexOfBucket < s_NumberOfBuckets; ++IndexOfBucket)
+        {
+            m_Buckets[IndexOfBucket] += _rOther.m_Buckets[IndexOfBucket];
+        }
+
+        m_NumberOfSamples += _rOther.m_NumberOfSamples;
+        m_SumOfTimes      += _rOther.m_SumOfTimes;
+        m_MaxTime          = std::max(m_MaxTime, _rOther.m_MaxTime);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CHistogram::Clear()
+    {
+        std::fill(m_Buckets, m_Buckets + s_NumberOfBuckets, 0);
+
+        m_NumberOfSamples = 0;
+        m_SumOfTimes      = 0.0;
+        m_MaxTime         = 0.0;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Size CHistogram::GetNumberOfSamples() const
+    {
+        return m_NumberOfSamples;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    double CHistogram::GetMean() const
+    {
+        return m_NumberOfSamples > 0 ? m_SumOfTimes / m_NumberOfSamples : 0.0;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    double CHistogram::GetMax() const
+    {
+        return m_MaxTime;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    double CHistogram::GetPercentile(double _Fraction) const
+    {
+        if (m_NumberOfSamples == 0) return 0.0;
+
+        const Size Rank = std::max(static_cast<Size>(std::ceil(_Fraction * m_NumberOfSamples)), static_cast<Size>(1));
+
+        Size NumberOfSamples = 0;
+
+        unsigned int IndexOfBucket = 0;
+
+        for (; IndexOfBucket < s_NumberOfBuckets - 1; ++IndexOfBucket)
+        {
+            NumberOfSamples += m_Buckets[IndexOfBucket];
+
+            if (NumberOfSamples >= Rank) break;
+        }
+
+        const double UpperBound = 1.0e-9 * std::exp2(static_cast<double>(IndexOfBucket + 1) / s_NumberOfBucketsPerOctave);
+
+        return std::min(UpperBound, m_MaxTime);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CState::CState(unsigned int _NumberOfIterations)
+        : m_NumberOfIterations         (_NumberOfIterations)
+        , m_NumberOfRemainingIterations(_NumberOfIterations)
+        , m_IsRunning                  (false)
+        , m_IsFinished                 (false)
+        , m_StartTime                  ()
+        , m_EndTime                    ()
+        , m_NumberOfBytesPerIteration  (0)
+        , m_NumberOfItemsPerIteration  (0)
+        , m_ManualTime                 (-1.0)
+        , m_NumberOfAllocations        (0)
+        , m_NumberOfAllocatedBytes     (0)
+        , m_Histograms                 ()
+        , m_NumberOfHistograms         (0)
+        , m_Counters                   ()
+        , m_NumberOfCounters           (0)
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    unsigned int CState::GetNumberOfIterations() const
+    {
+        return m_NumberOfIterations;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CState::SetNumberOfBytesPerIteration(Size _NumberOfBytes)
+    {
+        m_NumberOfBytesPerIteration = _NumberOfBytes;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CState::SetNumberOfItemsPerIteration(Size _NumberOfItems)
+    {
+        m_NumberOfItemsPerIteration = _NumberOfItems;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Size CState::GetNumberOfBytesPerIteration() const
+    {
+        return m_NumberOfBytesPerIteration;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Size CState::GetNumberOfItemsPerIteration() const
+    {
+        return m_NumberOfItemsPerIteration;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CState::SetManualTime(double _Time)
+    {
+        m_ManualTime = _Time;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CState::IsFinished() const
+    {
+        return m_IsFinished;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    double CState::GetElapsedTime() const
+    {
+        return std::chrono::duration<double>(m_EndTime - m_StartTime).count();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    double CState::GetReportedTime() const
+    {
+        return m_ManualTime >= 0.0 ? m_ManualTime : GetElapsedTime();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Size CState::GetNumberOfAllocations() const
+    {
+        return m_NumberOfAllocations;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Size CState::GetNumberOfAllocatedBytes() const
+    {
+        return m_NumberOfAllocatedBytes;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CHistogram& CState::GetHistogram(const char* _pName)
+    {
+        for (unsigned int IndexOfHistogram = 0; IndexOfHistogram < m_NumberOfHistograms; ++IndexOfHistogram)
+        {
+            SNamedHistogram& rHistogram = m_Histograms[IndexOfHistogram];
+
+            if (rHistogram.m_pName == _pName || std::strcmp(rHistogram.m_pName, _pName) == 0) return rHistogram.m_Histogram;
+        }
+
+        // -----------------------------------------------------------------------------
+        // Thrown as a standard exception, so the suite reports it for this
+        // benchmark and goes on with the next one
+        // -----------------------------------------------------------------------------
+        if (m_NumberOfHistograms == s_MaxNumberOfHistograms)
+        {
+            throw std::length_error("too many histograms in one benchmark");
+        }
+
+        SNamedHistogram& rHistogram = m_Histograms[m_NumberOfHistograms ++];
+
+        rHistogram.m_pName = _pName;
+
+        return rHistogram.m_Histogram;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    unsigned int CState::GetNumberOfHistograms() const
+    {
+        return m_NumberOfHistograms;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    const char* CState::GetHistogramName(unsigned int _Index) const
+    {
+        return m_Histograms[_Index].m_pName;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    const CHistogram& CState::GetHistogram(unsigned int _Index) const
+    {
+        return m_Histograms[_Index].m_Histogram;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CState::SetCounter(const char* _pName, double _Value)
+    {
+        unsigned int IndexOfCounter = 0;
+
+        while (IndexOfCounter < m_NumberOfCounters && m_Counters[IndexOfCounter].m_pName != _pName && std::strcmp(m_Counters[IndexOfCounter].m_pName, _pName) != 0) ++IndexOfCounter;
+
+        if (IndexOfCounter == m_NumberOfCounters)
+        {
+            if (m_NumberOfCounters == s_MaxNumberOfCounters)
+            {
+                throw std::length_error("too many counters in one benchmark");
+            }
+
+            m_Counters[m_NumberOfCounters ++].m_pName = _pName;
+        }
+
+        m_Counters[IndexOfCounter].m_Value = _Value;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    unsigned int CState::GetNumberOfCounters() const
+    {
+        return m_NumberOfCounters;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    const char* CState::GetCounterName(unsigned int _Index) const
+    {
+        return m_Counters[_Index].m_pName;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    double CState::GetCounter(unsigned int _Index) const
+    {
+        return m_Counters[_Index].m_Value;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CState::Start()
+    {
+        m_IsRunning = true;
+
+        m_NumberOfAllocations    = g_NumberOfAllocations   .load(std::memory_order_relaxed);
+        m_NumberOfAllocatedBytes = g_NumberOfAllocatedBytes.load(std::memory_order_relaxed);
+
+        m_StartTime = CClock::now();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CState::Stop()
+    {
+        m_EndTime = CClock::now();
+
+        m_NumberOfAllocations    = g_NumberOfAllocations   .load(std::memory_order_relaxed) - m_NumberOfAllocations;
+        m_NumberOfAllocatedBytes = g_NumberOfAllocatedBytes.load(std::memory_order_relaxed) - m_NumberOfAllocatedBytes;
+
+        m_IsRunning  = false;
+        m_IsFinished = true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    SOptions::SOptions()
+        : m_Filter          ()
+        , m_PathToJSON      ()
+        , m_WarmUpTime      (0.1)
+        , m_MinTimePerSample(0.01)
+        , m_NumberOfSamples (20)
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void RegisterBenchmark(const char* _pName, void (*_BenchmarkFtr)(CState&))
+    {
+        CBenchmarkSuite::GetInstance().RegisterBenchmark(_pName, _BenchmarkFtr);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    unsigned int RunBenchmarks(const SOptions& _rOptions, std::ostream& _rStream)
+    {
+        return CBenchmarkSuite::GetInstance().RunBenchmarks(_rOptions, _rStream);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void DoNotOptimize(const void* _pValue)
+    {
+        g_pOptimizationSink = _pValue;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CountAllocation(Size _NumberOfBytes)
+    {
+        g_NumberOfAllocations   .fetch_add(1, std::memory_order_relaxed);
+        g_NumberOfAllocatedBytes.fetch_add(_NumberOfBytes, std::memory_order_relaxed);
+    }
+} // namespace Benchmark
+} // namespace UT
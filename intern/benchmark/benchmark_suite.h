@@ -0,0 +1,237 @@
+
+#pragma once
+
+#include "base/base_defines.h"
+#include "base/base_typedef.h"
+
+#include <chrono>
+#include <ostream>
+#include <string>
+
+namespace UT
+{
+namespace Benchmark
+{
+    // -----------------------------------------------------------------------------
+    // Latencies of single steps inside an iteration (e.g. the stages of a
+    // pipeline) in logarithmic buckets of about 9 percent from 1 ns up to
+    // minutes. The buckets are fixed, so adding a sample never allocates.
+    // Not thread-safe; samples are added by one thread.
+    // -----------------------------------------------------------------------------
+    class CHistogram
+    {
+    public:
+
+        CHistogram();
+
+    public:
+
+        void Add(double _Time);                     //< Seconds
+
+        void Merge(const CHistogram& _rOther);
+
+        void Clear();
+
+        Size GetNumberOfSamples() const;
+
+        double GetMean() const;
+        double GetMax() const;
+
+        // -----------------------------------------------------------------------------
+        // Upper bound of the bucket that holds the given fraction (0..1) of
+        // the samples, but never more than the largest sample
+        // -----------------------------------------------------------------------------
+        double GetPercentile(double _Fraction) const;
+
+    private:
+
+        static const unsigned int s_NumberOfBucketsPerOctave = 8;
+        static const unsigned int s_NumberOfBuckets          = 8 * 40;
+
+    private:
+
+        Size   m_Buckets[s_NumberOfBuckets];
+        Size   m_NumberOfSamples;
+        double m_SumOfTimes;
+        double m_MaxTime;
+    };
+
+    // -----------------------------------------------------------------------------
+    // Handed to every benchmark. Only the loop over Run() is measured, so the
+    // setup in front of it is free; allocations are counted through the hooks
+    // of Base::CMemory while the loop runs.
+    // -----------------------------------------------------------------------------
+    class CState
+    {
+    public:
+
+        using CClock = std::chrono::steady_clock;
+
+    public:
+
+        CState(unsigned int _NumberOfIterations);
+
+    public:
+
+        inline bool Run();
+
+        unsigned int GetNumberOfIterations() const;
+
+        // -----------------------------------------------------------------------------
+        // Optional work per iteration that is reported as throughput
+        // -----------------------------------------------------------------------------
+        void SetNumberOfBytesPerIteration(Size _NumberOfBytes);
+        void SetNumberOfItemsPerIteration(Size _NumberOfItems);
+
+        Size GetNumberOfBytesPerIteration() const;
+        Size GetNumberOfItemsPerIteration() const;
+
+        // -----------------------------------------------------------------------------
+        // Reports the given time of the whole loop (e.g. CPU time) instead of
+        // the measured wall time. The calibration still uses the wall time.
+        // -----------------------------------------------------------------------------
+        void SetManualTime(double _Time);
+
+        bool IsFinished() const;
+
+        double GetElapsedTime() const;
+        double GetReportedTime() const;
+
+        Size GetNumberOfAllocations() const;
+        Size GetNumberOfAllocatedBytes() const;
+
+        // -----------------------------------------------------------------------------
+        // Histograms are looked up by name, which has to be a string literal.
+        // The benchmarks can use a few of them; they are created on first use
+        // without allocating and reported in that order.
+        // -----------------------------------------------------------------------------
+        CHistogram& GetHistogram(const char* _pName);
+
+        unsigned int GetNumberOfHistograms() const;
+
+        const char* GetHistogramName(unsigned int _Index) const;
+        const CHistogram& GetHistogram(unsigned int _Index) const;
+
+        // -----------------------------------------------------------------------------
+        // Values that describe the work instead of the time (e.g. a ratio of
+        // the result). Like histograms they are named by string literals; the
+        // value of the last sample is reported.
+        // -----------------------------------------------------------------------------
+        void SetCounter(const char* _pName, double _Value);
+
+        unsigned int GetNumberOfCounters() const;
+
+        const char* GetCounterName(unsigned int _Index) const;
+        double GetCounter(unsigned int _Index) const;
+
+    public:
+
+        static const unsigned int s_MaxNumberOfHistograms = 6;
+        static const unsigned int s_MaxNumberOfCounters   = 8;
+
+    private:
+
+        struct SNamedHistogram
+        {
+            const char* m_pName;
+            CHistogram  m_Histogram;
+        };
+
+        struct SNamedCounter
+        {
+            const char* m_pName;
+            double      m_Value;
+        };
+
+    private:
+
+        unsigned int       m_NumberOfIterations;
+        unsigned int       m_NumberOfRemainingIterations;
+        bool               m_IsRunning;
+        bool               m_IsFinished;
+        CClock::time_point m_StartTime;
+        CClock::time_point m_EndTime;
+        Size               m_NumberOfBytesPerIteration;
+        Size               m_NumberOfItemsPerIteration;
+        double             m_ManualTime;                   //< Negative if the wall time is reported
+        Size               m_NumberOfAllocations;          //< Counted while the loop runs
+        Size               m_NumberOfAllocatedBytes;
+        SNamedHistogram    m_Histograms[s_MaxNumberOfHistograms];
+        unsigned int       m_NumberOfHistograms;
+        SNamedCounter      m_Counters[s_MaxNumberOfCounters];
+        unsigned int       m_NumberOfCounters;
+
+    private:
+
+        void Start();
+        void Stop();
+    };
+
+    // -----------------------------------------------------------------------------
+
+    struct SOptions
+    {
+        std::string  m_Filter;                      //< Runs benchmarks whose name contains the filter
+        std::string  m_PathToJSON;                  //< Results are written as JSON if not empty
+        double       m_WarmUpTime;                  //< Seconds
+        double       m_MinTimePerSample;            //< Seconds, the iterations are calibrated to this
+        unsigned int m_NumberOfSamples;
+
+        SOptions();
+    };
+
+    // -----------------------------------------------------------------------------
+
+    void RegisterBenchmark(const char* _pName, void (*_BenchmarkFtr)(CState&));
+
+    // -----------------------------------------------------------------------------
+    // Returns the number of benchmarks that were run
+    // -----------------------------------------------------------------------------
+    unsigned int RunBenchmarks(const SOptions& _rOptions, std::ostream& _rStream);
+
+    // -----------------------------------------------------------------------------
+    // Keeps the compiler from removing a result that is not used otherwise
+    // -----------------------------------------------------------------------------
+    void DoNotOptimize(const void* _pValue);
+
+    template<typename TValue>
+    inline void DoNotOptimize(const TValue& _rValue);
+
+    // -----------------------------------------------------------------------------
+    // Counts an allocation for the loop that runs at the moment. Base::CMemory
+    // reports through it; the benchmark executable also calls it from its
+    // global operator new.
+    // -----------------------------------------------------------------------------
+    void CountAllocation(Size _NumberOfBytes);
+} // namespace Benchmark
+} // namespace UT
+
+namespace UT
+{
+namespace Benchmark
+{
+    inline bool CState::Run()
+    {
+        if (m_NumberOfRemainingIterations > 0)
+        {
+            if (!m_IsRunning) Start();
+
+            -- m_NumberOfRemainingIterations;
+
+            return true;
+        }
+
+        if (m_IsRunning) Stop();
+
+        return false;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<typename TValue>
+    inline void DoNotOptimize(const TValue& _rValue)
+    {
+        DoNotOptimize(static_cast<const void*>(&_rValue));
+    }
+} // namespace Benchmark
+} // namespace UT
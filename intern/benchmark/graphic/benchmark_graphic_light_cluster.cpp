@@ -0,0 +1,75 @@
+
+#include "benchmark_precompiled.h"
+
+#include "benchmark_defines.h"
+
+#include "engine/graphic/gfx_light_cluster_binner.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+    const float g_Near = 0.1f;
+    const float g_Far  = 200.0f;
+
+    // -----------------------------------------------------------------------------
+    // Point and spot lights scattered over the view frustum (view space)
+    // -----------------------------------------------------------------------------
+    std::vector<Gfx::CLightClusterBinner::SLight> CreateLights(int _NumberOfLights)
+    {
+        std::mt19937 Generator(7);
+
+        std::uniform_real_distribution<float> Depth(1.0f, 120.0f);
+        std::uniform_real_distribution<float> Side(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> Radius(1.0f, 12.0f);
+        std::uniform_real_distribution<float> Angle(0.2f, 1.4f);
+
+        std::vector<Gfx::CLightClusterBinner::SLight> Lights(_NumberOfLights);
+
+        for (int IndexOfLight = 0; IndexOfLight < _NumberOfLights; ++IndexOfLight)
+        {
+            Gfx::CLightClusterBinner::SLight& rLight = Lights[IndexOfLight];
+
+            const float Z = Depth(Generator);
+
+            rLight.m_Position     = glm::vec3(Side(Generator) * Z, Side(Generator) * Z * 0.6f, -Z);
+            rLight.m_Radius       = Radius(Generator);
+            rLight.m_Direction    = glm::normalize(glm::vec3(Side(Generator), Side(Generator), Side(Generator)) + glm::vec3(0.0f, 0.0f, 0.01f));
+            rLight.m_CosHalfAngle = IndexOfLight % 2 == 0 ? -1.0f : std::cos(Angle(Generator));
+        }
+
+        return Lights;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void BinLights(Base::Benchmark::CState& _rState, int _NumberOfLights)
+    {
+        Gfx::CLightClusterBinner Binner;
+
+        Binner.SetProjection(glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, g_Near, g_Far), g_Near, g_Far);
+        Binner.SetMaxLightsPerCluster(1024);
+
+        const std::vector<Gfx::CLightClusterBinner::SLight> Lights = CreateLights(_NumberOfLights);
+
+        _rState.SetNumberOfItemsPerIteration(_NumberOfLights);
+
+        while (_rState.Run())
+        {
+            Binner.Bin(Lights.data(), _NumberOfLights);
+
+            Base::Benchmark::DoNotOptimize(Binner.GetClusters());
+        }
+    }
+} // namespace
+
+BASE_BENCHMARK(Benchmark_Graphic_LightCluster_Bin_256)
+{
+    BinLights(_rState, 256);
+}
+
+BASE_BENCHMARK(Benchmark_Graphic_LightCluster_Bin_1024)
+{
+    BinLights(_rState, 1024);
+}
@@ -0,0 +1,314 @@
+
+#include "benchmark_precompiled.h"
+
+#include "benchmark_defines.h"
+
+#include "graphic/test_graphic_icosphere.h"
+
+#include "base/base_include_glm.h"
+
+#include "engine/core/core_program_parameters.h"
+
+#include "engine/graphic/gfx_mesh_optimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using CClock = std::chrono::steady_clock;
+
+    const float g_OverdrawThreshold = 1.05f;
+
+    // -----------------------------------------------------------------------------
+    // Position and normal like most of the imported meshes
+    // -----------------------------------------------------------------------------
+    struct SVertex
+    {
+        glm::vec3 m_Position;
+        glm::vec3 m_Normal;
+    };
+
+    struct SMesh
+    {
+        std::vector<SVertex>      m_Vertices;
+        std::vector<unsigned int> m_Indices;
+    };
+
+    using CMeshes = std::vector<SMesh>;
+
+    // -----------------------------------------------------------------------------
+    // Reads the triangles of a Wavefront OBJ in file order. Every distinct
+    // combination of position, texture coordinate and normal of a corner is
+    // one vertex, as the importer does it; polygons become fans.
+    // -----------------------------------------------------------------------------
+    SMesh ReadOBJ(const std::string& _rPathToFile)
+    {
+        std::ifstream File(_rPathToFile);
+
+        if (!File.is_open())
+        {
+            throw std::runtime_error("cannot open the model " + _rPathToFile);
+        }
+
+        std::vector<glm::vec3> Positions;
+        std::vector<glm::vec3> Normals;
+
+        std::map<std::string, unsigned int> VertexOfCorner;
+
+        SMesh Mesh;
+
+        std::string Line;
+
+        while (std::getline(File, Line))
+        {
+            std::istringstream Stream(Line);
+
+            std::string Keyword;
+
+            Stream >> Keyword;
+
+            if (Keyword == "v" || Keyword == "vn")
+            {
+                glm::vec3 Value(0.0f);
+
+                Stream >> Value.x >> Value.y >> Value.z;
+
+                (Keyword == "v" ? Positions : Normals).push_back(Value);
+            }
+            else if (Keyword == "f")
+            {
+                std::vector<unsigned int> Polygon;
+
+                std::string Corner;
+
+                while (Stream >> Corner)
+                {
+                    auto Vertex = VertexOfCorner.find(Corner);
+
+                    if (Vertex == VertexOfCorner.end())
+                    {
+                        // -----------------------------------------------------------------------------
+                        // position/texture/normal with 1-based or negative
+                        // (relative) indices
+                        // -----------------------------------------------------------------------------
+                        auto GetIndex = [](const std::string& _rIndex, size_t _NumberOfElements)
+                        {
+                            const int Index = std::stoi(_rIndex);
+
+                            return static_cast<size_t>(Index < 0 ? static_cast<int>(_NumberOfElements) + Index : Index - 1);
+                        };
+
+                        const size_t PositionOfSlash  = Corner.find('/');
+                        const size_t PositionOfNormal = Corner.rfind('/');
+
+                        const size_t IndexOfPosition = GetIndex(Corner.substr(0, PositionOfSlash), Positions.size());
+
+                        if (IndexOfPosition >= Positions.size())
+                        {
+                            throw std::runtime_error("invalid face in the model " + _rPathToFile);
+                        }
+
+                        SVertex NewVertex = { Positions[IndexOfPosition], glm::vec3(0.0f) };
+
+                        if (PositionOfSlash != PositionOfNormal && PositionOfNormal + 1 < Corner.size())
+                        {
+                            const size_t IndexOfNormal = GetIndex(Corner.substr(PositionOfNormal + 1), Normals.size());
+
+                            if (IndexOfNormal < Normals.size()) NewVertex.m_Normal = Normals[IndexOfNormal];
+                        }
+
+                        Mesh.m_Vertices.push_back(NewVertex);
+
+                        Vertex = VertexOfCorner.emplace(Corner, static_cast<unsigned int>(Mesh.m_Vertices.size()) - 1).first;
+                    }
+
+                    Polygon.push_back(Vertex->second);
+                }
+
+                for (size_t IndexOfCorner = 2; IndexOfCorner < Polygon.size(); ++IndexOfCorner)
+                {
+                    Mesh.m_Indices.insert(Mesh.m_Indices.end(), { Polygon[0], Polygon[IndexOfCorner - 1], Polygon[IndexOfCorner] });
+                }
+            }
+        }
+
+        return Mesh;
+    }
+
+    // -----------------------------------------------------------------------------
+    // The models in "graphics:mesh_optimizer:models" (pass it with -p), by
+    // default the bundled ones next to the binaries
+    // -----------------------------------------------------------------------------
+    CMeshes ReadBundledModels()
+    {
+        const std::string PathToModels = Core::CProgramParameters::GetInstance().Get("graphics:mesh_optimizer:models", "../data/graphic/models");
+
+        std::vector<std::string> PathsToFiles;
+
+        if (std::filesystem::is_directory(PathToModels))
+        {
+            for (const auto& rEntry : std::filesystem::directory_iterator(PathToModels))
+            {
+                if (rEntry.path().extension() == ".obj") PathsToFiles.push_back(rEntry.path().string());
+            }
+        }
+
+        if (PathsToFiles.empty())
+        {
+            throw std::runtime_error("no models in " + PathToModels);
+        }
+
+        std::sort(PathsToFiles.begin(), PathsToFiles.end());
+
+        CMeshes Meshes;
+
+        for (const std::string& rPathToFile : PathsToFiles)
+        {
+            Meshes.push_back(ReadOBJ(rPathToFile));
+        }
+
+        return Meshes;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Unit sphere of an icosahedron with every triangle split into four for
+    // the given number of times, with the triangles in random order like a
+    // mesh of a scan.
+    // -----------------------------------------------------------------------------
+    CMeshes CreateScannedSphere(unsigned int _Refinement)
+    {
+        std::vector<glm::vec3>    Positions;
+        std::vector<unsigned int> Indices;
+
+        Base::AddIcosphere(1.0f, _Refinement, Positions, Indices);
+
+        std::vector<std::array<unsigned int, 3>> Triangles(Indices.size() / 3);
+
+        std::copy(Indices.begin(), Indices.end(), &Triangles[0][0]);
+
+        std::shuffle(Triangles.begin(), Triangles.end(), std::mt19937(13));
+
+        std::copy(&Triangles[0][0], &Triangles[0][0] + Indices.size(), Indices.begin());
+
+        SMesh Mesh;
+
+        for (const glm::vec3& rPosition : Positions) Mesh.m_Vertices.push_back({ rPosition, rPosition });
+
+        Mesh.m_Indices.swap(Indices);
+
+        return CMeshes(1, Mesh);
+    }
+
+    // -----------------------------------------------------------------------------
+    // The passes of the import on copies of the meshes. ACMR and ATVR of the
+    // FIFO cache model are reported before and after, weighted by the
+    // triangles and vertices of all meshes.
+    // -----------------------------------------------------------------------------
+    void OptimizeMeshes(Base::Benchmark::CState& _rState, const CMeshes& _rMeshes)
+    {
+        Gfx::CMeshOptimizer Optimizer;
+
+        Base::Benchmark::CHistogram& rVertexCacheHistogram = _rState.GetHistogram("vertex_cache");
+        Base::Benchmark::CHistogram& rOverdrawHistogram    = _rState.GetHistogram("overdraw");
+        Base::Benchmark::CHistogram& rVertexFetchHistogram = _rState.GetHistogram("vertex_fetch");
+
+        CMeshes Meshes = _rMeshes;
+
+        Base::Size NumberOfTriangles = 0;
+        Base::Size NumberOfVertices  = 0;
+
+        double MissesBefore = 0.0;
+        double MissesAfter  = 0.0;
+
+        for (const SMesh& rMesh : _rMeshes)
+        {
+            const unsigned int NumberOfMeshVertices = static_cast<unsigned int>(rMesh.m_Vertices.size());
+            const unsigned int NumberOfMeshIndices  = static_cast<unsigned int>(rMesh.m_Indices.size());
+
+            MissesBefore += Optimizer.AnalyzeVertexCache(rMesh.m_Indices.data(), NumberOfMeshIndices, NumberOfMeshVertices).m_ACMR * NumberOfMeshIndices / 3;
+
+            NumberOfTriangles += NumberOfMeshIndices / 3;
+            NumberOfVertices  += NumberOfMeshVertices;
+        }
+
+        _rState.SetNumberOfItemsPerIteration(NumberOfTriangles);
+
+        while (_rState.Run())
+        {
+            for (size_t IndexOfMesh = 0; IndexOfMesh < Meshes.size(); ++IndexOfMesh)
+            {
+                SMesh& rMesh = Meshes[IndexOfMesh];
+
+                rMesh.m_Vertices = _rMeshes[IndexOfMesh].m_Vertices;
+                rMesh.m_Indices  = _rMeshes[IndexOfMesh].m_Indices;
+
+                const unsigned int NumberOfMeshVertices = static_cast<unsigned int>(rMesh.m_Vertices.size());
+                const unsigned int NumberOfMeshIndices  = static_cast<unsigned int>(rMesh.m_Indices.size());
+
+                unsigned int* pIndices = rMesh.m_Indices.data();
+
+                CClock::time_point Start = CClock::now();
+
+                Optimizer.OptimizeVertexCache(pIndices, NumberOfMeshIndices, NumberOfMeshVertices, pIndices);
+
+                CClock::time_point End = CClock::now();
+
+                rVertexCacheHistogram.Add(std::chrono::duration<double>(End - Start).count());
+
+                Start = End;
+
+                Optimizer.OptimizeOverdraw(pIndices, NumberOfMeshIndices, &rMesh.m_Vertices[0].m_Position.x, NumberOfMeshVertices, sizeof(SVertex), g_OverdrawThreshold, pIndices);
+
+                End = CClock::now();
+
+                rOverdrawHistogram.Add(std::chrono::duration<double>(End - Start).count());
+
+                Start = End;
+
+                Optimizer.OptimizeVertexFetch(rMesh.m_Vertices.data(), NumberOfMeshVertices, sizeof(SVertex), pIndices, NumberOfMeshIndices);
+
+                End = CClock::now();
+
+                rVertexFetchHistogram.Add(std::chrono::duration<double>(End - Start).count());
+            }
+
+            Base::Benchmark::DoNotOptimize(Meshes);
+        }
+
+        for (const SMesh& rMesh : Meshes)
+        {
+            const unsigned int NumberOfMeshIndices = static_cast<unsigned int>(rMesh.m_Indices.size());
+
+            MissesAfter += Optimizer.AnalyzeVertexCache(rMesh.m_Indices.data(), NumberOfMeshIndices, static_cast<unsigned int>(rMesh.m_Vertices.size())).m_ACMR * NumberOfMeshIndices / 3;
+        }
+
+        _rState.SetCounter("acmr_before", MissesBefore / NumberOfTriangles);
+        _rState.SetCounter("acmr_after" , MissesAfter  / NumberOfTriangles);
+        _rState.SetCounter("atvr_before", MissesBefore / NumberOfVertices);
+        _rState.SetCounter("atvr_after" , MissesAfter  / NumberOfVertices);
+    }
+} // namespace
+
+BASE_BENCHMARK(Benchmark_Graphic_MeshOptimizer_BundledModels)
+{
+    static const CMeshes s_Meshes = ReadBundledModels();
+
+    OptimizeMeshes(_rState, s_Meshes);
+}
+
+BASE_BENCHMARK(Benchmark_Graphic_MeshOptimizer_ScannedSphere)
+{
+    static const CMeshes s_Meshes = CreateScannedSphere(6);
+
+    OptimizeMeshes(_rState, s_Meshes);
+}
@@ -0,0 +1,234 @@
+
+#include "benchmark_precompiled.h"
+
+#include "benchmark_defines.h"
+
+#include "base/base_compression.h"
+
+#include "engine/network/core_network_codec.h"
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const int g_FrameWidth  = 640;
+    const int g_FrameHeight = 480;
+
+    // -----------------------------------------------------------------------------
+    // Frames like the ones the SLAM streams: depth is a smooth 16 bit surface
+    // with sensor noise in the lowest bits, color is a textured RGBA image.
+    // Consecutive frames differ slightly, like a moving camera.
+    // -----------------------------------------------------------------------------
+    std::vector<char> CreateDepthFrame(int _IndexOfFrame)
+    {
+        std::vector<char> Frame(g_FrameWidth * g_FrameHeight * sizeof(uint16_t));
+
+        std::mt19937 Generator(_IndexOfFrame);
+
+        for (int Y = 0; Y < g_FrameHeight; ++ Y)
+        {
+            for (int X = 0; X < g_FrameWidth; ++ X)
+            {
+                const int Surface = 800 + (X + _IndexOfFrame) / 2 + (Y * Y) / 512;
+
+                const uint16_t Depth = static_cast<uint16_t>(Surface + Generator() % 3);
+
+                std::memcpy(Frame.data() + (Y * g_FrameWidth + X) * sizeof(uint16_t), &Depth, sizeof(Depth));
+            }
+        }
+
+        return Frame;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    std::vector<char> CreateColorFrame(int _IndexOfFrame)
+    {
+        std::vector<char> Frame(g_FrameWidth * g_FrameHeight * 4);
+
+        std::mt19937 Generator(_IndexOfFrame);
+
+        for (int Y = 0; Y < g_FrameHeight; ++ Y)
+        {
+            for (int X = 0; X < g_FrameWidth; ++ X)
+            {
+                char* pPixel = Frame.data() + (Y * g_FrameWidth + X) * 4;
+
+                const bool IsWall = ((X + _IndexOfFrame) / 64 + Y / 64) % 2 == 0;
+
+                pPixel[0] = static_cast<char>(IsWall ? 180 : 90 + (X >> 3));
+                pPixel[1] = static_cast<char>(IsWall ? 170 : 60 + (Y >> 3));
+                pPixel[2] = static_cast<char>((IsWall ? 160 : 40) + Generator() % 2);
+                pPixel[3] = static_cast<char>(255);
+            }
+        }
+
+        return Frame;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Encodes a sequence of frames with the reused codec context of a socket.
+    // Bytes are the raw frames, items the bytes on the wire, so the ratio of
+    // items_per_second to bytes_per_second in the report is the compression
+    // ratio.
+    // -----------------------------------------------------------------------------
+    void EncodeFrames(Base::Benchmark::CState& _rState, std::vector<char> (*_CreateFrame)(int), Net::SCodec::Enum _Codec)
+    {
+        const int NumberOfFrames = 8;
+
+        std::vector<std::vector<char>> Frames;
+
+        for (int IndexOfFrame = 0; IndexOfFrame < NumberOfFrames; ++ IndexOfFrame)
+        {
+            Frames.emplace_back(_CreateFrame(IndexOfFrame));
+        }
+
+        Net::CEncoder Encoder(1);
+
+        std::vector<char> Encoded;
+
+        Base::Size NumberOfRawBytes  = 0;
+        Base::Size NumberOfWireBytes = 0;
+
+        for (const std::vector<char>& rFrame : Frames)
+        {
+            NumberOfRawBytes  += rFrame.size();
+            NumberOfWireBytes += Encoder.Encode(_Codec, rFrame.data(), rFrame.size(), Encoded) ? Encoded.size() : rFrame.size();
+        }
+
+        _rState.SetNumberOfBytesPerIteration(NumberOfRawBytes);
+        _rState.SetNumberOfItemsPerIteration(NumberOfWireBytes);
+
+        while (_rState.Run())
+        {
+            for (const std::vector<char>& rFrame : Frames)
+            {
+                Encoder.Encode(_Codec, rFrame.data(), rFrame.size(), Encoded);
+
+                Base::Benchmark::DoNotOptimize(Encoded.data());
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // Only LZ is decoded, the zlib stream cannot be decoded a second time
+    // -----------------------------------------------------------------------------
+    void DecodeFrames(Base::Benchmark::CState& _rState, std::vector<char> (*_CreateFrame)(int))
+    {
+        const int NumberOfFrames = 8;
+
+        Net::CEncoder Encoder(1);
+        Net::CDecoder Decoder;
+
+        std::vector<std::vector<char>> EncodedFrames(NumberOfFrames);
+
+        Base::Size NumberOfRawBytes = 0;
+
+        for (int IndexOfFrame = 0; IndexOfFrame < NumberOfFrames; ++ IndexOfFrame)
+        {
+            const std::vector<char> Frame = _CreateFrame(IndexOfFrame);
+
+            Encoder.Encode(Net::SCodec::LZ, Frame.data(), Frame.size(), EncodedFrames[IndexOfFrame]);
+
+            NumberOfRawBytes = Frame.size();
+        }
+
+        std::vector<char> Decoded(NumberOfRawBytes);
+
+        _rState.SetNumberOfBytesPerIteration(NumberOfFrames * NumberOfRawBytes);
+
+        while (_rState.Run())
+        {
+            for (const std::vector<char>& rEncoded : EncodedFrames)
+            {
+                Decoder.Decode(rEncoded.data(), rEncoded.size(), Decoded.data(), Decoded.size());
+
+                Base::Benchmark::DoNotOptimize(Decoded.data());
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // What the applications did before: one gzip stream per frame
+    // -----------------------------------------------------------------------------
+    void CompressFrames(Base::Benchmark::CState& _rState, std::vector<char> (*_CreateFrame)(int))
+    {
+        const int NumberOfFrames = 8;
+
+        std::vector<std::vector<char>> Frames;
+
+        for (int IndexOfFrame = 0; IndexOfFrame < NumberOfFrames; ++ IndexOfFrame)
+        {
+            Frames.emplace_back(_CreateFrame(IndexOfFrame));
+        }
+
+        std::vector<char> Compressed;
+
+        Base::Size NumberOfRawBytes  = 0;
+        Base::Size NumberOfWireBytes = 0;
+
+        for (const std::vector<char>& rFrame : Frames)
+        {
+            Base::Compress(rFrame, Compressed, 1);
+
+            NumberOfRawBytes  += rFrame.size();
+            NumberOfWireBytes += Compressed.size();
+        }
+
+        _rState.SetNumberOfBytesPerIteration(NumberOfRawBytes);
+        _rState.SetNumberOfItemsPerIteration(NumberOfWireBytes);
+
+        while (_rState.Run())
+        {
+            for (const std::vector<char>& rFrame : Frames)
+            {
+                Base::Compress(rFrame, Compressed, 1);
+
+                Base::Benchmark::DoNotOptimize(Compressed.data());
+            }
+        }
+    }
+} // namespace
+
+BASE_BENCHMARK(Benchmark_Network_Codec_Encode_Depth_LZ)
+{
+    EncodeFrames(_rState, &CreateDepthFrame, Net::SCodec::LZ);
+}
+
+BASE_BENCHMARK(Benchmark_Network_Codec_Encode_Depth_Zlib)
+{
+    EncodeFrames(_rState, &CreateDepthFrame, Net::SCodec::Zlib);
+}
+
+BASE_BENCHMARK(Benchmark_Network_Codec_Encode_Depth_Gzip)
+{
+    CompressFrames(_rState, &CreateDepthFrame);
+}
+
+BASE_BENCHMARK(Benchmark_Network_Codec_Encode_Color_LZ)
+{
+    EncodeFrames(_rState, &CreateColorFrame, Net::SCodec::LZ);
+}
+
+BASE_BENCHMARK(Benchmark_Network_Codec_Encode_Color_Zlib)
+{
+    EncodeFrames(_rState, &CreateColorFrame, Net::SCodec::Zlib);
+}
+
+BASE_BENCHMARK(Benchmark_Network_Codec_Encode_Color_Gzip)
+{
+    CompressFrames(_rState, &CreateColorFrame);
+}
+
+BASE_BENCHMARK(Benchmark_Network_Codec_Decode_Depth_LZ)
+{
+    DecodeFrames(_rState, &CreateDepthFrame);
+}
+
+BASE_BENCHMARK(Benchmark_Network_Codec_Decode_Color_LZ)
+{
+    DecodeFrames(_rState, &CreateColorFrame);
+}
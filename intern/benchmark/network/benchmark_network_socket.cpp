@@ -0,0 +1,331 @@
+
+#include "benchmark_precompiled.h"
+
+#include "benchmark_defines.h"
+
+#include "engine/network/core_network_manager.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#ifdef PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace
+{
+    const Base::Size g_NumberOfBytesPerIteration = 8 * 1024 * 1024;
+    const Base::Size g_NumberOfHeaderBytes       = 12;
+
+    // -----------------------------------------------------------------------------
+    // CPU time of all threads of the process in seconds
+    // -----------------------------------------------------------------------------
+    double GetProcessTime()
+    {
+#ifdef PLATFORM_WINDOWS
+        FILETIME CreationTime, ExitTime, KernelTime, UserTime;
+
+        GetProcessTimes(GetCurrentProcess(), &CreationTime, &ExitTime, &KernelTime, &UserTime);
+
+        auto ToSeconds = [](const FILETIME& _rTime)
+        {
+            return ((static_cast<uint64_t>(_rTime.dwHighDateTime) << 32) | _rTime.dwLowDateTime) * 1.0e-7;
+        };
+
+        return ToSeconds(KernelTime) + ToSeconds(UserTime);
+#else
+        timespec Time;
+
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &Time);
+
+        return Time.tv_sec + Time.tv_nsec * 1.0e-9;
+#endif
+    }
+
+    // -----------------------------------------------------------------------------
+    // Loopback peer that counts what arrives and optionally sends it back. It
+    // is a plain asio socket, because the network manager keys its sockets by
+    // port and cannot hold both ends of one connection.
+    // -----------------------------------------------------------------------------
+    class CSink
+    {
+    public:
+
+        CSink(bool _IsEcho)
+            : m_IOService       ()
+            , m_Acceptor        (m_IOService, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0))
+            , m_Socket          (m_IOService)
+            , m_NumberOfBytes   (0)
+            , m_IsEcho          (_IsEcho)
+        {
+            m_Thread = std::thread(&CSink::Run, this);
+        }
+
+        ~CSink()
+        {
+            m_Thread.join();
+        }
+
+    public:
+
+        int GetPort() const
+        {
+            return m_Acceptor.local_endpoint().port();
+        }
+
+        Base::Size GetNumberOfBytes() const
+        {
+            return m_NumberOfBytes;
+        }
+
+    private:
+
+        void Run()
+        {
+            std::error_code Error;
+
+            m_Acceptor.accept(m_Socket, Error);
+
+            std::vector<char> Buffer(1024 * 1024);
+
+            while (!Error)
+            {
+                const Base::Size NumberOfBytes = m_Socket.read_some(asio::buffer(Buffer), Error);
+
+                if (m_IsEcho && !Error)
+                {
+                    asio::write(m_Socket, asio::buffer(Buffer.data(), NumberOfBytes), Error);
+                }
+
+                m_NumberOfBytes += NumberOfBytes;
+            }
+        }
+
+    private:
+
+        asio::io_service        m_IOService;
+        asio::ip::tcp::acceptor m_Acceptor;
+        asio::ip::tcp::socket   m_Socket;
+        std::atomic<Base::Size> m_NumberOfBytes;
+        bool                    m_IsEcho;
+        std::thread             m_Thread;
+    };
+
+    // -----------------------------------------------------------------------------
+    // The connections are shared by all benchmarks of the run, so the
+    // repeated calls of a benchmark do not connect again. One peer only
+    // receives, the other one echoes every message.
+    // -----------------------------------------------------------------------------
+    class CLoopback
+    {
+    public:
+
+        static CLoopback& GetInstance()
+        {
+            static CLoopback s_Loopback;
+
+            return s_Loopback;
+        }
+
+    public:
+
+        Net::SocketHandle GetSocket() const
+        {
+            return m_Socket;
+        }
+
+        const CSink& GetSink() const
+        {
+            return m_Sink;
+        }
+
+        Net::SocketHandle GetEchoSocket() const
+        {
+            return m_EchoSocket;
+        }
+
+        Base::Size GetNumberOfEchoes() const
+        {
+            return m_NumberOfEchoes;
+        }
+
+    private:
+
+        CLoopback()
+            : m_Sink          (false)
+            , m_Echo          (true)
+            , m_Socket        (0)
+            , m_EchoSocket    (0)
+            , m_EchoHandlerPtr()
+            , m_NumberOfEchoes(0)
+        {
+            Net::CNetworkManager& rNetworkManager = Net::CNetworkManager::GetInstance();
+
+            rNetworkManager.OnStart();
+
+            m_Socket     = rNetworkManager.CreateClientSocket("127.0.0.1", m_Sink.GetPort());
+            m_EchoSocket = rNetworkManager.CreateClientSocket("127.0.0.1", m_Echo.GetPort());
+
+            m_EchoHandlerPtr = rNetworkManager.RegisterMessageHandler(m_EchoSocket, [this](const Net::CMessage& _rMessage, Net::SocketHandle)
+            {
+                if (_rMessage.m_MessageType == 0) ++ m_NumberOfEchoes;
+            });
+
+            while (!rNetworkManager.IsConnected(m_Socket) || !rNetworkManager.IsConnected(m_EchoSocket))
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        ~CLoopback()
+        {
+            // -----------------------------------------------------------------------------
+            // Closing the client ends the connection and lets the sink return
+            // -----------------------------------------------------------------------------
+            Net::CNetworkManager::GetInstance().OnExit();
+        }
+
+    private:
+
+        CSink                                              m_Sink;
+        CSink                                              m_Echo;
+        Net::SocketHandle                                  m_Socket;
+        Net::SocketHandle                                  m_EchoSocket;
+        Net::CNetworkManager::CMessageDelegate::HandleType m_EchoHandlerPtr;
+        Base::Size                                         m_NumberOfEchoes;          //< Counted on the main thread by Update()
+    };
+
+    // -----------------------------------------------------------------------------
+    // Every iteration sends the same amount of data split into messages of the
+    // given size and waits until the peer received all of it.
+    // -----------------------------------------------------------------------------
+    void SendMessages(Base::Benchmark::CState& _rState, Base::Size _NumberOfBytesPerMessage)
+    {
+        Net::CNetworkManager& rNetworkManager = Net::CNetworkManager::GetInstance();
+
+        CLoopback& rLoopback = CLoopback::GetInstance();
+
+        const Net::SocketHandle Socket = rLoopback.GetSocket();
+
+        const Net::CPayload Payload(std::vector<char>(_NumberOfBytesPerMessage, 7));
+
+        const Base::Size NumberOfMessages = g_NumberOfBytesPerIteration / _NumberOfBytesPerMessage;
+
+        Base::Size NumberOfExpectedBytes = rLoopback.GetSink().GetNumberOfBytes();
+
+        _rState.SetNumberOfBytesPerIteration(NumberOfMessages * _NumberOfBytesPerMessage);
+        _rState.SetNumberOfItemsPerIteration(NumberOfMessages);
+
+        while (_rState.Run())
+        {
+            for (Base::Size IndexOfMessage = 0; IndexOfMessage < NumberOfMessages; )
+            {
+                Net::CMessage Message;
+
+                Message.m_Category = 1;
+                Message.m_Payload  = Payload;
+
+                if (rNetworkManager.SendMessage(Socket, std::move(Message)))
+                {
+                    ++ IndexOfMessage;
+                }
+                else
+                {
+                    rNetworkManager.Update();
+
+                    std::this_thread::yield();
+                }
+            }
+
+            NumberOfExpectedBytes += NumberOfMessages * (g_NumberOfHeaderBytes + _NumberOfBytesPerMessage);
+
+            while (rLoopback.GetSink().GetNumberOfBytes() < NumberOfExpectedBytes)
+            {
+                std::this_thread::yield();
+            }
+
+            rNetworkManager.Update();
+        }
+    }
+} // namespace
+
+BASE_BENCHMARK(Benchmark_Network_Socket_Idle)
+{
+    // -----------------------------------------------------------------------------
+    // Reports the CPU time of the process while the connections are open but
+    // nothing is sent. Each iteration idles for one millisecond, so a spinning
+    // IO thread shows up with about one millisecond per iteration.
+    // -----------------------------------------------------------------------------
+    CLoopback::GetInstance();
+
+    const double StartTime = GetProcessTime();
+
+    while (_rState.Run())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    _rState.SetManualTime(GetProcessTime() - StartTime);
+}
+
+BASE_BENCHMARK(Benchmark_Network_Socket_RoundTrip_64B)
+{
+    // -----------------------------------------------------------------------------
+    // Latency of one message that is sent, echoed by the peer and handled
+    // -----------------------------------------------------------------------------
+    Net::CNetworkManager& rNetworkManager = Net::CNetworkManager::GetInstance();
+
+    CLoopback& rLoopback = CLoopback::GetInstance();
+
+    const Net::CPayload Payload(std::vector<char>(64, 7));
+
+    Base::Size NumberOfExpectedEchoes = rLoopback.GetNumberOfEchoes();
+
+    _rState.SetNumberOfItemsPerIteration(1);
+
+    while (_rState.Run())
+    {
+        Net::CMessage Message;
+
+        Message.m_Category = 1;
+        Message.m_Payload  = Payload;
+
+        rNetworkManager.SendMessage(rLoopback.GetEchoSocket(), std::move(Message));
+
+        ++ NumberOfExpectedEchoes;
+
+        while (rLoopback.GetNumberOfEchoes() < NumberOfExpectedEchoes)
+        {
+            rNetworkManager.Update();
+        }
+    }
+}
+
+BASE_BENCHMARK(Benchmark_Network_Socket_Send_64B)
+{
+    SendMessages(_rState, 64);
+}
+
+BASE_BENCHMARK(Benchmark_Network_Socket_Send_4KB)
+{
+    SendMessages(_rState, 4 * 1024);
+}
+
+BASE_BENCHMARK(Benchmark_Network_Socket_Send_64KB)
+{
+    SendMessages(_rState, 64 * 1024);
+}
+
+BASE_BENCHMARK(Benchmark_Network_Socket_Send_1MB)
+{
+    SendMessages(_rState, 1024 * 1024);
+}
+
+BASE_BENCHMARK(Benchmark_Network_Socket_Send_8MB)
+{
+    SendMessages(_rState, 8 * 1024 * 1024);
+}
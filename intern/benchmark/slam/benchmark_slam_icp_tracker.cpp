@@ -0,0 +1,100 @@
+
+#include "benchmark_precompiled.h"
+
+#include "benchmark_defines.h"
+
+#include "slam/test_slam_box_scene.h"
+
+#include "plugin/slam/mr_icp_tracker_cpu.h"
+
+#include <vector>
+
+namespace
+{
+    const int g_Width  = 640;
+    const int g_Height = 480;
+
+    const glm::vec2 g_FocalLength(600.0f, 600.0f);
+    const glm::vec2 g_FocalPoint(320.0f, 240.0f);
+
+    // -----------------------------------------------------------------------------
+    // Same settings as the tracker tests
+    // -----------------------------------------------------------------------------
+    MR::SReconstructionSettings GetSettings()
+    {
+        MR::SReconstructionSettings Settings = {};
+
+        Settings.m_TruncatedDistance = 30.0f;
+        Settings.m_PyramidLevelCount = 3;
+        Settings.m_PyramidLevelIterations = glm::ivec3(10, 10, 10);
+
+        return Settings;
+    }
+
+    // -----------------------------------------------------------------------------
+    // The camera moved by a few centimeters between the raycast and the new
+    // depth frame
+    // -----------------------------------------------------------------------------
+    class CTrackerScene
+    {
+    public:
+
+        CTrackerScene()
+            : m_Settings(GetSettings())
+            , m_Tracker (g_Width, g_Height, m_Settings)
+        {
+            const glm::mat4 CurrentPoseMatrix = glm::translate(glm::vec3(0.01f, -0.005f, 0.02f)) * glm::rotate(0.008f, glm::normalize(glm::vec3(0.3f, 1.0f, 0.2f)));
+
+            m_Tracker.SetIntrinsics(g_FocalLength, g_FocalPoint);
+
+            MR::RenderBoxDepth(CurrentPoseMatrix, g_FocalLength, g_FocalPoint, g_Width, g_Height, m_Depth);
+
+            MR::RenderBoxRaycastPyramid(glm::mat4(1.0f), g_FocalLength, g_FocalPoint, g_Width, g_Height, m_Settings.m_PyramidLevelCount, m_RaycastPyramid);
+
+            m_Tracker.CreateReferencePyramid(m_Depth.data(), m_ReferencePyramid);
+        }
+
+    public:
+
+        MR::SReconstructionSettings  m_Settings;
+        MR::CICPTrackerCPU           m_Tracker;
+        std::vector<unsigned short>  m_Depth;
+        MR::CICPTrackerCPU::CPyramid m_ReferencePyramid;
+        MR::CICPTrackerCPU::CPyramid m_RaycastPyramid;
+    };
+} // namespace
+
+BASE_BENCHMARK(Benchmark_SLAM_ICPTrackerCPU_ReferencePyramid_640x480)
+{
+    CTrackerScene Scene;
+
+    _rState.SetNumberOfBytesPerIteration(Scene.m_Depth.size() * sizeof(unsigned short));
+    _rState.SetNumberOfItemsPerIteration(1);
+
+    while (_rState.Run())
+    {
+        Scene.m_Tracker.CreateReferencePyramid(Scene.m_Depth.data(), Scene.m_ReferencePyramid);
+
+        Base::Benchmark::DoNotOptimize(Scene.m_ReferencePyramid);
+    }
+}
+
+BASE_BENCHMARK(Benchmark_SLAM_ICPTrackerCPU_Track_640x480)
+{
+    CTrackerScene Scene;
+
+    _rState.SetNumberOfItemsPerIteration(1);
+
+    glm::mat4 PoseMatrix(1.0f);
+
+    while (_rState.Run())
+    {
+        PoseMatrix = Scene.m_Tracker.Track(glm::mat4(1.0f), Scene.m_ReferencePyramid, Scene.m_RaycastPyramid);
+
+        Base::Benchmark::DoNotOptimize(PoseMatrix);
+    }
+
+    _rState.SetCounter("iterations", Scene.m_Tracker.GetNumberOfIterations());
+    _rState.SetCounter("correspondences", Scene.m_Tracker.GetNumberOfCorrespondences());
+    _rState.SetCounter("tracking_lost", Scene.m_Tracker.IsTrackingLost() ? 1.0 : 0.0);
+}
@@ -0,0 +1,130 @@
+
+#include "benchmark_precompiled.h"
+
+#include "benchmark_defines.h"
+
+#include "slam/test_slam_sphere_bricks.h"
+
+#include "plugin/slam/mr_mesh_extractor.h"
+
+#include <vector>
+
+namespace
+{
+    const float g_VoxelSize         = 0.01f;
+    const float g_TruncatedDistance = 0.04f;
+    const float g_Radius            = 0.6f;
+
+    const glm::vec3 g_SphereCenter(0.013f, -0.021f, 0.007f);
+
+    // -----------------------------------------------------------------------------
+    // A sphere of 1.2 m like a small scanned room, about 1650 bricks
+    // -----------------------------------------------------------------------------
+    class CSphereVolume
+    {
+    public:
+
+        CSphereVolume()
+            : m_Keys  ()
+            , m_Voxels()
+        {
+            MR::CreateSphereBricks(g_SphereCenter, g_Radius, g_VoxelSize, g_TruncatedDistance, m_Keys, m_Voxels);
+        }
+
+    public:
+
+        void SetBricks(MR::CMeshExtractor& _rExtractor) const
+        {
+            for (size_t IndexOfBrick = 0; IndexOfBrick < m_Keys.size(); ++IndexOfBrick)
+            {
+                _rExtractor.SetBrick(m_Keys[IndexOfBrick], &m_Voxels[IndexOfBrick * MR::CMeshExtractor::s_VoxelsPerBrick]);
+            }
+        }
+
+        Base::Size GetNumberOfBricks() const
+        {
+            return m_Keys.size();
+        }
+
+    private:
+
+        std::vector<glm::ivec3>                 m_Keys;
+        std::vector<MR::CMeshExtractor::SVoxel> m_Voxels;
+    };
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Every brick is new, so all of them are meshed. The bricks are copied in
+// every iteration, which is part of the measurement.
+// -----------------------------------------------------------------------------
+BASE_BENCHMARK(Benchmark_SLAM_MeshExtractor_Extract_Sphere)
+{
+    const CSphereVolume Volume;
+
+    MR::CMeshExtractor Extractor(g_VoxelSize);
+
+    _rState.SetNumberOfItemsPerIteration(Volume.GetNumberOfBricks());
+
+    while (_rState.Run())
+    {
+        Extractor.Clear();
+
+        Volume.SetBricks(Extractor);
+
+        Base::Benchmark::DoNotOptimize(Extractor.Extract());
+    }
+
+    _rState.SetCounter("bricks", static_cast<double>(Volume.GetNumberOfBricks()));
+    _rState.SetCounter("triangles", Extractor.GetNumberOfTriangles());
+}
+
+// -----------------------------------------------------------------------------
+// The integration hands over the same voxels again: nothing is re-meshed
+// -----------------------------------------------------------------------------
+BASE_BENCHMARK(Benchmark_SLAM_MeshExtractor_Extract_Unchanged_Sphere)
+{
+    const CSphereVolume Volume;
+
+    MR::CMeshExtractor Extractor(g_VoxelSize);
+
+    Volume.SetBricks(Extractor);
+
+    Extractor.Extract();
+
+    _rState.SetNumberOfItemsPerIteration(Volume.GetNumberOfBricks());
+
+    while (_rState.Run())
+    {
+        Volume.SetBricks(Extractor);
+
+        Base::Benchmark::DoNotOptimize(Extractor.Extract());
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Welding the meshes of all bricks into one indexed mesh
+// -----------------------------------------------------------------------------
+BASE_BENCHMARK(Benchmark_SLAM_MeshExtractor_GetMesh_Sphere)
+{
+    const CSphereVolume Volume;
+
+    MR::CMeshExtractor Extractor(g_VoxelSize);
+
+    Volume.SetBricks(Extractor);
+
+    Extractor.Extract();
+
+    MR::CMeshExtractor::CVertices Vertices;
+    MR::CMeshExtractor::CIndices  Indices;
+
+    _rState.SetNumberOfItemsPerIteration(Extractor.GetNumberOfTriangles());
+
+    while (_rState.Run())
+    {
+        Extractor.GetMesh(Vertices, Indices);
+
+        Base::Benchmark::DoNotOptimize(Indices.data());
+    }
+
+    _rState.SetCounter("vertices", static_cast<double>(Vertices.size()));
+}
@@ -0,0 +1,655 @@
+#include "benchmark_precompiled.h"
+
+#include "benchmark_defines.h"
+
+#include "base/base_compression.h"
+#include "base/base_serialize_record_reader.h"
+
+#include "engine/core/core_program_parameters.h"
+
+#include "engine/network/core_network_manager.h"
+
+#include "plugin/slam/mr_slam_stream_parser.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using CClock = std::chrono::steady_clock;
+    using CParser = MR::CSLAMStreamParser;
+
+    const glm::ivec2 g_FrameSize(640, 480);
+
+    const int        g_NumberOfSyntheticFrames = 30;
+    const double     g_SyntheticFrameRate      = 30.0;
+
+    // -----------------------------------------------------------------------------
+    // A message of the recording as the device sent it
+    // -----------------------------------------------------------------------------
+    struct SRecord
+    {
+        double        m_Timecode;                   //< Seconds
+        int           m_Category;
+        int           m_CompressedSize;
+        int           m_DecompressedSize;
+        Net::CPayload m_Payload;
+    };
+
+    using CRecords = std::vector<SRecord>;
+
+    // -----------------------------------------------------------------------------
+
+    template<typename TValue>
+    void Append(std::vector<char>& _rBytes, const TValue& _rValue)
+    {
+        const char* pValue = reinterpret_cast<const char*>(&_rValue);
+
+        _rBytes.insert(_rBytes.end(), pValue, pValue + sizeof(_rValue));
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void AddRecord(CRecords& _rRecords, double _Timecode, std::vector<char>&& _rBytes, bool _IsCompressed)
+    {
+        SRecord Record;
+
+        Record.m_Timecode         = _Timecode;
+        Record.m_Category         = 0;
+        Record.m_DecompressedSize = static_cast<int>(_rBytes.size());
+
+        if (_IsCompressed)
+        {
+            std::vector<char> Compressed;
+
+            Base::Compress(_rBytes, Compressed, 1);
+
+            _rBytes.swap(Compressed);
+        }
+
+        Record.m_CompressedSize   = static_cast<int>(_rBytes.size());
+        Record.m_Payload          = Net::CPayload(std::move(_rBytes));
+
+        _rRecords.push_back(std::move(Record));
+    }
+
+    // -----------------------------------------------------------------------------
+    // Recording of a device that moves around a wavy surface: the intrinsics
+    // followed by a pose, a depth and a color frame per frame. The frames are
+    // gzip compressed like the ones of the device.
+    // -----------------------------------------------------------------------------
+    CRecords CreateSyntheticRecording()
+    {
+        CRecords Records;
+
+        const glm::vec2 FocalLength(525.0f, 525.0f);
+        const glm::vec2 FocalPoint(g_FrameSize.x / 2.0f, g_FrameSize.y / 2.0f);
+
+        CParser::SIntrinsicsMessage Intrinsics;
+
+        Intrinsics.m_FocalLength             = FocalLength;
+        Intrinsics.m_FocalPoint              = FocalPoint;
+        Intrinsics.m_DepthSize               = g_FrameSize;
+        Intrinsics.m_ColorSize               = g_FrameSize;
+        Intrinsics.m_DeviceResolution        = g_FrameSize;
+        Intrinsics.m_DeviceProjectionMatrix  = glm::mat4(1.0f);
+        Intrinsics.m_RelativeCameraTransform = glm::mat4(1.0f);
+
+        std::vector<char> Command;
+
+        Append(Command, static_cast<int32_t>(CParser::COMMAND));
+        Append(Command, static_cast<int32_t>(1));
+        Append(Command, Intrinsics);
+
+        AddRecord(Records, 0.0, std::move(Command), false);
+
+        const int NumberOfPixels = g_FrameSize.x * g_FrameSize.y;
+
+        uint32_t Noise = 1;
+
+        for (int IndexOfFrame = 0; IndexOfFrame < g_NumberOfSyntheticFrames; ++IndexOfFrame)
+        {
+            const double Timecode = (IndexOfFrame + 1) / g_SyntheticFrameRate;
+
+            const float Phase = IndexOfFrame * 0.1f;
+
+            std::vector<char> Transform;
+
+            Append(Transform, static_cast<int32_t>(CParser::TRANSFORM));
+            Append(Transform, glm::rotate(glm::mat4(1.0f), Phase * 0.1f, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+            AddRecord(Records, Timecode, std::move(Transform), false);
+
+            // -----------------------------------------------------------------------------
+            // Depth in millimeters with a little sensor noise
+            // -----------------------------------------------------------------------------
+            std::vector<char> Depth;
+
+            Depth.reserve(28 + NumberOfPixels * sizeof(uint16_t));
+
+            Append(Depth, static_cast<int32_t>(CParser::DEPTHFRAME));
+            Append(Depth, static_cast<int32_t>(g_FrameSize.x));
+            Append(Depth, static_cast<int32_t>(g_FrameSize.y));
+            Append(Depth, FocalLength);
+            Append(Depth, FocalPoint);
+
+            for (int y = 0; y < g_FrameSize.y; ++y)
+            {
+                for (int x = 0; x < g_FrameSize.x; ++x)
+                {
+                    Noise = Noise * 1664525u + 1013904223u;
+
+                    const float Distance = 1500.0f + 300.0f * std::sin(x * 0.02f + Phase) * std::cos(y * 0.02f);
+
+                    Append(Depth, static_cast<uint16_t>(Distance + (Noise >> 29)));
+                }
+            }
+
+            AddRecord(Records, Timecode, std::move(Depth), true);
+
+            // -----------------------------------------------------------------------------
+            // YUV 4:2:0 of the same surface
+            // -----------------------------------------------------------------------------
+            std::vector<char> Color;
+
+            Color.reserve(92 + NumberOfPixels + NumberOfPixels / 2);
+
+            Append(Color, static_cast<int32_t>(CParser::COLORFRAME));
+            Append(Color, static_cast<int32_t>(g_FrameSize.x));
+            Append(Color, static_cast<int32_t>(g_FrameSize.y));
+            Append(Color, FocalLength);
+            Append(Color, FocalPoint);
+            Append(Color, glm::mat4(1.0f));
+
+            for (int y = 0; y < g_FrameSize.y; ++y)
+            {
+                for (int x = 0; x < g_FrameSize.x; ++x)
+                {
+                    Color.push_back(static_cast<char>(128 + 100 * std::sin(x * 0.05f + Phase) * std::cos(y * 0.03f)));
+                }
+            }
+
+            Color.insert(Color.end(), NumberOfPixels / 2, static_cast<char>(128));
+
+            AddRecord(Records, Timecode, std::move(Color), true);
+        }
+
+        return Records;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Reads the network messages of a recording of the SLAM control into
+    // memory, so the replay does not wait for the disk.
+    // -----------------------------------------------------------------------------
+    CRecords ReadRecording(const std::string& _rPathToRecording)
+    {
+        std::ifstream File(_rPathToRecording, std::ios::binary);
+
+        if (!File.is_open())
+        {
+            throw std::runtime_error("cannot open the recording " + _rPathToRecording);
+        }
+
+        Base::CRecordReader Reader(File, 1);
+
+        CRecords Records;
+
+        while (!Reader.IsEnd())
+        {
+            SRecord Record;
+
+            int MessageType;
+
+            Record.m_Timecode = Reader.PeekTimecode();
+
+            Reader >> Record.m_Category;
+            Reader >> MessageType;
+            Reader >> Record.m_CompressedSize;
+            Reader >> Record.m_DecompressedSize;
+            Base::Read(Reader, Record.m_Payload);
+
+            if (MessageType != 0 || Record.m_Payload.GetNumberOfBytes() == 0) continue;
+
+            Record.m_CompressedSize = static_cast<int>(Record.m_Payload.GetNumberOfBytes());
+
+            Records.push_back(std::move(Record));
+        }
+
+        return Records;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Replays a recording through a server socket of the network manager.
+    // The device is a plain asio socket on its own thread that writes the
+    // messages at the recorded times or as fast as the handlers keep up; at
+    // most a few messages are in flight, so the latencies do not pile up.
+    // The recording is taken from "mr:slam:replay:recording" (pass it with
+    // -p) and is synthetic otherwise.
+    //
+    // The handler does the CPU side of the SLAM control: decompression,
+    // parsing and the handoff of the frames, where the upload to the GPU is
+    // replaced by a copy into a staging buffer. Payloads are decompressed on
+    // the IO thread if the socket knows their codec, so that time shows up in
+    // the receive latency.
+    // -----------------------------------------------------------------------------
+    class CReplay
+    {
+    public:
+
+        static CReplay& GetInstance(bool _IsRealTime)
+        {
+            if (_IsRealTime)
+            {
+                static CReplay s_RealTimeReplay(true);
+
+                return s_RealTimeReplay;
+            }
+
+            static CReplay s_UnlimitedReplay(false);
+
+            return s_UnlimitedReplay;
+        }
+
+    public:
+
+        // -----------------------------------------------------------------------------
+        // The device only streams while a benchmark is bound
+        // -----------------------------------------------------------------------------
+        void Bind(Base::Benchmark::CState& _rState)
+        {
+            m_pReceiveHistogram    = &_rState.GetHistogram("receive");
+            m_pDecompressHistogram = &_rState.GetHistogram("decompress");
+            m_pParseHistogram      = &_rState.GetHistogram("parse");
+            m_pHandoffHistogram    = &_rState.GetHistogram("handoff");
+
+            m_IsStreaming = true;
+        }
+
+        void Unbind()
+        {
+            m_IsStreaming = false;
+
+            m_pReceiveHistogram    = nullptr;
+            m_pDecompressHistogram = nullptr;
+            m_pParseHistogram      = nullptr;
+            m_pHandoffHistogram    = nullptr;
+        }
+
+        Base::Size GetNumberOfFrames() const
+        {
+            return m_NumberOfFrames;
+        }
+
+        Base::Size GetNumberOfInvalidMessages() const
+        {
+            return m_NumberOfInvalidMessages;
+        }
+
+    private:
+
+        static const Base::Size s_MaxNumberOfMessagesInFlight = 8; 
+        static const Base::Size s_NumberOfSendTimes           = 1024;     //< Power of two above the messages in flight
+
+    private:
+
+        CReplay(bool _IsRealTime)
+            : m_Records                 ()
+            , m_Duration                (0.0)
+            , m_IsRealTime              (_IsRealTime)
+            , m_IOService               ()
+            , m_Socket                  (m_IOService)
+            , m_Thread                  ()
+            , m_IsRunning               (true)
+            , m_IsStreaming             (false)
+            , m_SendTimes               ()
+            , m_NumberOfSentMessages    (0)
+            , m_NumberOfReceivedMessages(0)
+            , m_ServerSocket            (0)
+            , m_HandlerPtr              ()
+            , m_Parser                  ()
+            , m_Message                 ()
+            , m_StagingBytes            (2 * g_FrameSize.x * g_FrameSize.y * sizeof(uint16_t))
+            , m_NumberOfFrames          (0)
+            , m_NumberOfInvalidMessages (0)
+            , m_pReceiveHistogram       (nullptr)
+            , m_pDecompressHistogram    (nullptr)
+            , m_pParseHistogram         (nullptr)
+            , m_pHandoffHistogram       (nullptr)
+        {
+            const std::string PathToRecording = Core::CProgramParameters::GetInstance().Get("mr:slam:replay:recording", "");
+
+            m_Records = PathToRecording.empty() ? CreateSyntheticRecording() : ReadRecording(PathToRecording);
+
+            // -----------------------------------------------------------------------------
+            // The staging buffer holds the largest message, so the handoff
+            // never allocates
+            // -----------------------------------------------------------------------------
+            int NumberOfDepthFrames = 0;
+
+            Base::Size MaxNumberOfBytes = m_StagingBytes.size();
+
+            for (const SRecord& rRecord : m_Records)
+            {
+                Net::CMessage Message;
+
+                Message.m_Category         = rRecord.m_Category;
+                Message.m_CompressedSize   = rRecord.m_CompressedSize;
+                Message.m_DecompressedSize = rRecord.m_DecompressedSize;
+                Message.m_Payload          = rRecord.m_Payload;
+
+                if (m_Parser.Parse(Message, m_Message) && m_Message.m_Type == CParser::DEPTHFRAME) ++NumberOfDepthFrames;
+
+                MaxNumberOfBytes = std::max(MaxNumberOfBytes, static_cast<Base::Size>(rRecord.m_DecompressedSize));
+            }
+
+            m_StagingBytes.resize(MaxNumberOfBytes);
+
+            if (NumberOfDepthFrames == 0)
+            {
+                throw std::runtime_error("the recording has no depth frames");
+            }
+
+            // -----------------------------------------------------------------------------
+            // The recording is looped; the gap to the first message is the
+            // average distance of two frames.
+            // -----------------------------------------------------------------------------
+            const double Length = m_Records.back().m_Timecode - m_Records.front().m_Timecode;
+
+            m_Duration = Length + Length / NumberOfDepthFrames;
+
+            // -----------------------------------------------------------------------------
+            // The server listens on a port that was free a moment ago
+            // -----------------------------------------------------------------------------
+            Net::CNetworkManager& rNetworkManager = Net::CNetworkManager::GetInstance();
+
+            rNetworkManager.OnStart();
+
+            int Port;
+
+            {
+                asio::ip::tcp::acceptor Acceptor(m_IOService, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+
+                Port = Acceptor.local_endpoint().port();
+            }
+
+            m_ServerSocket = rNetworkManager.CreateServerSocket(Port);
+
+            m_HandlerPtr = rNetworkManager.RegisterMessageHandler(m_ServerSocket, std::bind(&CReplay::OnMessage, this, std::placeholders::_1, std::placeholders::_2));
+
+            m_Thread = std::thread(&CReplay::Run, this, Port);
+
+            while (!rNetworkManager.IsConnected(m_ServerSocket))
+            {
+                rNetworkManager.Update();
+
+                std::this_thread::yield();
+            }
+        }
+
+        ~CReplay()
+        {
+            // -----------------------------------------------------------------------------
+            // Closing the server ends a write of the device that waits for it
+            // -----------------------------------------------------------------------------
+            m_IsRunning = false;
+
+            Net::CNetworkManager::GetInstance().OnExit();
+
+            m_Thread.join();
+        }
+
+    private:
+
+        void Run(int _Port)
+        {
+            std::error_code Error;
+
+            do
+            {
+                m_Socket.close(Error);
+
+                m_Socket.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), static_cast<unsigned short>(_Port)), Error);
+
+                if (Error) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            while (Error && m_IsRunning);
+
+            // -----------------------------------------------------------------------------
+            // Small messages would otherwise wait for the delayed ACK of the
+            // previous one
+            // -----------------------------------------------------------------------------
+            m_Socket.set_option(asio::ip::tcp::no_delay(true), Error);
+
+            Base::Size IndexOfRecord = 0;
+
+            CClock::time_point StartTime = CClock::now();
+
+            bool IsPaused = true;
+
+            while (m_IsRunning && !Error)
+            {
+                if (!m_IsStreaming)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+                    IsPaused = true;
+
+                    continue;
+                }
+
+                const SRecord& rRecord = m_Records[IndexOfRecord];
+
+                const CClock::duration Offset = std::chrono::duration_cast<CClock::duration>(std::chrono::duration<double>(rRecord.m_Timecode - m_Records.front().m_Timecode));
+
+                // -----------------------------------------------------------------------------
+                // A pause does not make up for the missed messages later
+                // -----------------------------------------------------------------------------
+                if (IsPaused)
+                {
+                    StartTime = CClock::now() - Offset;
+
+                    IsPaused = false;
+                }
+
+                if (m_IsRealTime)
+                {
+                    std::this_thread::sleep_until(StartTime + Offset);
+                }
+
+                const Base::Size IndexOfMessage = m_NumberOfSentMessages;
+
+                if (IndexOfMessage - m_NumberOfReceivedMessages >= s_MaxNumberOfMessagesInFlight)
+                {
+                    std::this_thread::yield();
+
+                    continue;
+                }
+
+                const std::array<int32_t, 3> Header = { { rRecord.m_Category, rRecord.m_CompressedSize, rRecord.m_DecompressedSize } };
+
+                const std::array<asio::const_buffer, 2> Buffers = { { asio::buffer(Header), asio::buffer(rRecord.m_Payload.GetData(), rRecord.m_Payload.GetNumberOfBytes()) } };
+
+                m_SendTimes[IndexOfMessage % s_NumberOfSendTimes] = CClock::now().time_since_epoch().count();
+
+                m_NumberOfSentMessages = IndexOfMessage + 1;
+
+                asio::write(m_Socket, Buffers, Error);
+
+                if (++IndexOfRecord == m_Records.size())
+                {
+                    IndexOfRecord = 0;
+
+                    StartTime += std::chrono::duration_cast<CClock::duration>(std::chrono::duration<double>(m_Duration));
+                }
+            }
+
+            m_Socket.close(Error);
+        }
+
+        // -----------------------------------------------------------------------------
+
+        void OnMessage(const Net::CMessage& _rMessage, Net::SocketHandle _SocketHandle)
+        {
+            BASE_UNUSED(_SocketHandle);
+
+            if (_rMessage.m_MessageType != 0) return;
+
+            const Base::Size IndexOfMessage = m_NumberOfReceivedMessages;
+
+            const CClock::time_point SendTime = CClock::time_point(CClock::duration(m_SendTimes[IndexOfMessage % s_NumberOfSendTimes]));
+
+            const CClock::time_point ReceiveTime = CClock::now();
+
+            m_NumberOfReceivedMessages = IndexOfMessage + 1;
+
+            const char* pData = nullptr;
+            Base::Size NumberOfBytes = 0;
+
+            bool IsValid = m_Parser.Decompress(_rMessage, pData, NumberOfBytes);
+
+            const CClock::time_point DecompressTime = CClock::now();
+
+            IsValid = IsValid && m_Parser.ParsePayload(pData, NumberOfBytes, m_Message);
+
+            const CClock::time_point ParseTime = CClock::now();
+
+            if (!IsValid)
+            {
+                ++m_NumberOfInvalidMessages;
+
+                return;
+            }
+
+            Handoff(m_Message);
+
+            const CClock::time_point HandoffTime = CClock::now();
+
+            if (m_Message.m_Type == CParser::DEPTHFRAME) ++m_NumberOfFrames;
+
+            if (m_pReceiveHistogram == nullptr) return;
+
+            m_pReceiveHistogram   ->Add(std::chrono::duration<double>(ReceiveTime    - SendTime      ).count());
+            m_pDecompressHistogram->Add(std::chrono::duration<double>(DecompressTime - ReceiveTime   ).count());
+            m_pParseHistogram     ->Add(std::chrono::duration<double>(ParseTime      - DecompressTime).count());
+            m_pHandoffHistogram   ->Add(std::chrono::duration<double>(HandoffTime    - ParseTime     ).count());
+        }
+
+        // -----------------------------------------------------------------------------
+        // Stands in for the upload to the textures and buffers of the GPU
+        // -----------------------------------------------------------------------------
+        void Handoff(const CParser::SMessage& _rMessage)
+        {
+            char* pStaging = m_StagingBytes.data();
+
+            if (_rMessage.m_Type == CParser::DEPTHFRAME)
+            {
+                const CParser::SDepthFrame& rFrame = _rMessage.m_DepthFrame;
+
+                std::memcpy(pStaging, rFrame.m_pPixels, rFrame.m_Size.x * rFrame.m_Size.y * sizeof(uint16_t));
+            }
+            else if (_rMessage.m_Type == CParser::COLORFRAME)
+            {
+                const CParser::SColorFrame& rFrame = _rMessage.m_ColorFrame;
+
+                const Base::Size NumberOfPixels = rFrame.m_Size.x * rFrame.m_Size.y;
+
+                std::memcpy(pStaging, rFrame.m_pY, NumberOfPixels);
+                std::memcpy(pStaging + NumberOfPixels, rFrame.m_pUV, NumberOfPixels / 2);
+            }
+            else if (_rMessage.m_Type == CParser::PLANE && _rMessage.m_Plane.m_NumberOfVertices > 0)
+            {
+                const CParser::SPlane& rPlane = _rMessage.m_Plane;
+
+                std::memcpy(pStaging, rPlane.m_pVertices, rPlane.m_NumberOfVertices * sizeof(glm::vec4));
+                std::memcpy(pStaging + rPlane.m_NumberOfVertices * sizeof(glm::vec4), rPlane.m_pIndices, rPlane.m_NumberOfIndices * sizeof(uint16_t));
+            }
+
+            Base::Benchmark::DoNotOptimize(pStaging);
+        }
+
+    private:
+
+        CRecords                                           m_Records;
+        double                                             m_Duration;                  //< Seconds of one pass through the recording
+        bool                                               m_IsRealTime;
+
+        asio::io_service                                   m_IOService;
+        asio::ip::tcp::socket                              m_Socket;                    //< Of the device
+        std::thread                                        m_Thread;
+        std::atomic<bool>                                  m_IsRunning;
+        std::atomic<bool>                                  m_IsStreaming;
+        std::atomic<CClock::rep>                           m_SendTimes[s_NumberOfSendTimes];
+        std::atomic<Base::Size>                            m_NumberOfSentMessages;
+        std::atomic<Base::Size>                            m_NumberOfReceivedMessages;
+
+        Net::SocketHandle                                  m_ServerSocket;
+        Net::CNetworkManager::CMessageDelegate::HandleType m_HandlerPtr;
+        CParser                                            m_Parser;
+        CParser::SMessage                                  m_Message;
+        std::vector<char>                                  m_StagingBytes;
+        Base::Size                                         m_NumberOfFrames;            //< Counted on the main thread by Update()
+        Base::Size                                         m_NumberOfInvalidMessages;
+
+        Base::Benchmark::CHistogram*                         m_pReceiveHistogram;         //< Of the bound benchmark
+        Base::Benchmark::CHistogram*                         m_pDecompressHistogram;
+        Base::Benchmark::CHistogram*                         m_pParseHistogram;
+        Base::Benchmark::CHistogram*                         m_pHandoffHistogram;
+    };
+
+    // -----------------------------------------------------------------------------
+    // Every iteration runs the main thread until the next depth frame was
+    // handed off, so the items are frames and the allocations are counted per
+    // frame. They are counted on all threads, but on Windows only in the
+    // benchmark executable (the parser), not in the engine DLL (payload pool,
+    // decoder); see the operator new in benchmark_main.cpp.
+    // -----------------------------------------------------------------------------
+    void ReplayFrames(Base::Benchmark::CState& _rState, bool _IsRealTime)
+    {
+        Net::CNetworkManager& rNetworkManager = Net::CNetworkManager::GetInstance();
+
+        CReplay& rReplay = CReplay::GetInstance(_IsRealTime);
+
+        rReplay.Bind(_rState);
+
+        _rState.SetNumberOfItemsPerIteration(1);
+
+        while (_rState.Run())
+        {
+            const Base::Size NumberOfFrames = rReplay.GetNumberOfFrames() + 1;
+
+            while (rReplay.GetNumberOfFrames() < NumberOfFrames)
+            {
+                rNetworkManager.Update();
+
+                std::this_thread::yield();
+            }
+        }
+
+        rReplay.Unbind();
+
+        if (rReplay.GetNumberOfInvalidMessages() > 0)
+        {
+            throw std::runtime_error("the recording has messages that cannot be parsed");
+        }
+    }
+} // namespace
+
+BASE_BENCHMARK(Benchmark_SLAM_Replay_RealTime)
+{
+    ReplayFrames(_rState, true);
+}
+
+BASE_BENCHMARK(Benchmark_SLAM_Replay_Unlimited)
+{
+    ReplayFrames(_rState, false);
+}
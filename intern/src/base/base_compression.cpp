@@ -1,11 +1,15 @@
 
 #include "base/base_precompiled.h"
 
+#include "base/base_compression.h"
 #include "base/base_exception.h"
+#include "base/base_thread_pool.h"
 
 #include <zlib.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 
 namespace
 {
@@ -24,70 +28,317 @@ namespace
         Z_BEST_COMPRESSION,
         Z_DEFAULT_COMPRESSION
     };
+
+    const int NumberOfCompressionLevels = sizeof(CompressionLevels) / sizeof(CompressionLevels[0]);
+
+    // -----------------------------------------------------------------------------
+    // Outputs grow by at least this many bytes, so a stream of small chunks
+    // does not resize them for every chunk.
+    // -----------------------------------------------------------------------------
+    const Base::Size MinNumberOfBytesToGrow = 4 * 1024;
+
+    // -----------------------------------------------------------------------------
+    // The vector grows its capacity geometrically, the size only by what the
+    // next pass needs.
+    // -----------------------------------------------------------------------------
+    void Grow(std::vector<char>& _rData, Base::Size _NumberOfUsedBytes, Base::Size _NumberOfRequiredBytes)
+    {
+        if (_rData.size() - _NumberOfUsedBytes >= MinNumberOfBytesToGrow) return;
+
+        _rData.resize(_NumberOfUsedBytes + std::max(_NumberOfRequiredBytes, MinNumberOfBytesToGrow));
+    }
+
+    // -----------------------------------------------------------------------------
+    // Every thread keeps one compressor per level
+    // -----------------------------------------------------------------------------
+    Base::CCompressor& GetCompressor(int _Level)
+    {
+        static thread_local std::unique_ptr<Base::CCompressor> s_pCompressors[NumberOfCompressionLevels];
+
+        assert(_Level >= 0 && _Level < NumberOfCompressionLevels);
+
+        if (s_pCompressors[_Level] == nullptr)
+        {
+            s_pCompressors[_Level].reset(new Base::CCompressor(_Level));
+        }
+
+        return *s_pCompressors[_Level];
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Base::CDecompressor& GetDecompressor()
+    {
+        static thread_local Base::CDecompressor s_Decompressor;
+
+        return s_Decompressor;
+    }
 }
 
 namespace Base
 {
+    void Decompress(const char* _pCompressedData, int _Size, std::vector<char>& _rDecompressedData)
+    {
+        GetDecompressor().Decompress(_pCompressedData, static_cast<Size>(_Size), _rDecompressedData);
+    }
+
+    // -----------------------------------------------------------------------------
+
     void Decompress(const std::vector<char>& _rCompressedData, std::vector<char>& _rDecompressedData)
     {
-        assert(_rDecompressedData.size() >= _rCompressedData.size()); // TODO: allow empty result vector and figure out output length with zlib
+        GetDecompressor().Decompress(_rCompressedData.data(), _rCompressedData.size(), _rDecompressedData);
+    }
 
-        z_stream infstream;
-        infstream.zalloc = Z_NULL;
-        infstream.zfree = Z_NULL;
-        infstream.opaque = Z_NULL;
-        infstream.avail_in = static_cast<uInt>(_rCompressedData.size());
-        infstream.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(_rCompressedData.data()));
-        infstream.avail_out = static_cast<uInt>(_rDecompressedData.size());
-        infstream.next_out = reinterpret_cast<Bytef*>(_rDecompressedData.data());
-        
-        CheckResult(inflateInit2(&infstream, 16 + MAX_WBITS));
-        CheckResult(inflate(&infstream, Z_SYNC_FLUSH));
-        CheckResult(inflateEnd(&infstream));
+    // -----------------------------------------------------------------------------
+
+    void Compress(const std::vector<char>& _rDecompressedData, std::vector<char>& _rCompressedData, int _Level)
+    {
+        GetCompressor(_Level).Compress(_rDecompressedData.data(), _rDecompressedData.size(), _rCompressedData);
     }
 
     // -----------------------------------------------------------------------------
 
-    void Compress(const std::vector<char>& _rDecompressedData, std::vector<char>& _rCompressedData, int _Level = 1)
+    void Compress(const char* _pDecompressedData, int _Size, std::vector<char>& _rCompressedData, int _Level)
     {
-        _rCompressedData.resize(_rDecompressedData.size());
+        GetCompressor(_Level).Compress(_pDecompressedData, static_cast<Size>(_Size), _rCompressedData);
+    }
 
-        z_stream defstream;
-        defstream.zalloc = Z_NULL;
-        defstream.zfree = Z_NULL;
-        defstream.opaque = Z_NULL;
-        defstream.avail_in = static_cast<uInt>(_rDecompressedData.size());
-        defstream.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(_rDecompressedData.data()));
-        defstream.avail_out = static_cast<uInt>(_rCompressedData.size());
-        defstream.next_out = reinterpret_cast<Bytef*>(_rCompressedData.data());
+    // -----------------------------------------------------------------------------
+
+    void CompressParallel(const char* _pDecompressedData, Size _NumberOfBytes, std::vector<char>& _rCompressedData, int _Level, Size _NumberOfBytesPerBlock)
+    {
+        assert(_NumberOfBytesPerBlock > 0);
+
+        const Size NumberOfBlocks = std::max<Size>((_NumberOfBytes + _NumberOfBytesPerBlock - 1) / _NumberOfBytesPerBlock, 1);
+
+        CThreadPool& rThreadPool = CThreadPool::GetInstance();
+
+        if (NumberOfBlocks == 1 || rThreadPool.GetNumberOfWorkers() == 0)
+        {
+            GetCompressor(_Level).Compress(_pDecompressedData, _NumberOfBytes, _rCompressedData);
+
+            return;
+        }
+
+        // -----------------------------------------------------------------------------
+        // Every block is a gzip member on its own. The blocks do not share a
+        // window, which costs a little ratio at the start of every block.
+        // -----------------------------------------------------------------------------
+        std::vector<std::vector<char>> Blocks(NumberOfBlocks);
+
+        rThreadPool.ParallelFor(static_cast<int>(NumberOfBlocks), 1, [&](int _Begin, int _End)
+        {
+            for (int IndexOfBlock = _Begin; IndexOfBlock < _End; ++ IndexOfBlock)
+            {
+                const Size Offset = IndexOfBlock * _NumberOfBytesPerBlock;
+
+                GetCompressor(_Level).Compress(_pDecompressedData + Offset, std::min(_NumberOfBytesPerBlock, _NumberOfBytes - Offset), Blocks[IndexOfBlock]);
+            }
+        });
+
+        Size NumberOfCompressedBytes = 0;
+
+        for (const std::vector<char>& rBlock : Blocks)
+        {
+            NumberOfCompressedBytes += rBlock.size();
+        }
+
+        _rCompressedData.resize(NumberOfCompressedBytes);
 
-        CheckResult(deflateInit2(&defstream, CompressionLevels[_Level], Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY));
-        CheckResult(deflate(&defstream, Z_FINISH));
-        CheckResult(deflateEnd(&defstream));
+        char* pCompressedData = _rCompressedData.data();
 
-        _rCompressedData.resize(defstream.total_out);
+        for (const std::vector<char>& rBlock : Blocks)
+        {
+            std::memcpy(pCompressedData, rBlock.data(), rBlock.size());
+
+            pCompressedData += rBlock.size();
+        }
+    }
+} // namespace Base
+
+namespace Base
+{
+    CCompressor::CCompressor(int _Level)
+        : m_pStream(new z_stream())
+    {
+        assert(_Level >= 0 && _Level < NumberOfCompressionLevels);
+
+        CheckResult(deflateInit2(m_pStream.get(), CompressionLevels[_Level], Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY));
     }
 
     // -----------------------------------------------------------------------------
 
-    void Compress(const char* _pDecompressedData, int _Size, std::vector<char>& _rCompressedData, int _Level = 1)
+    CCompressor::~CCompressor()
     {
-        _rCompressedData.resize(_Size);
+        deflateEnd(m_pStream.get());
+    }
 
-        z_stream defstream;
-        defstream.zalloc = Z_NULL;
-        defstream.zfree = Z_NULL;
-        defstream.opaque = Z_NULL;
-        defstream.avail_in = static_cast<uInt>(_Size);
-        defstream.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(_pDecompressedData));
-        defstream.avail_out = static_cast<uInt>(_rCompressedData.size());
-        defstream.next_out = reinterpret_cast<Bytef*>(_rCompressedData.data());
+    // -----------------------------------------------------------------------------
 
-        CheckResult(deflateInit2(&defstream, CompressionLevels[_Level], Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY));
-        CheckResult(deflate(&defstream, Z_FINISH));
-        CheckResult(deflateEnd(&defstream));
+    void CCompressor::Write(const char* _pData, Size _NumberOfBytes, std::vector<char>& _rCompressedData)
+    {
+        m_pStream->next_in  = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(_pData));
+        m_pStream->avail_in = static_cast<uInt>(_NumberOfBytes);
 
-        _rCompressedData.resize(defstream.total_out);
+        Deflate(Z_NO_FLUSH, _rCompressedData);
     }
 
-} // namespace Base
\ No newline at end of file
+    // -----------------------------------------------------------------------------
+
+    void CCompressor::Finish(std::vector<char>& _rCompressedData)
+    {
+        m_pStream->next_in  = Z_NULL;
+        m_pStream->avail_in = 0;
+
+        Deflate(Z_FINISH, _rCompressedData);
+
+        CheckResult(deflateReset(m_pStream.get()));
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CCompressor::Compress(const char* _pData, Size _NumberOfBytes, std::vector<char>& _rCompressedData)
+    {
+        _rCompressedData.clear();
+
+        m_pStream->next_in  = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(_pData));
+        m_pStream->avail_in = static_cast<uInt>(_NumberOfBytes);
+
+        Deflate(Z_FINISH, _rCompressedData);
+
+        CheckResult(deflateReset(m_pStream.get()));
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CCompressor::Deflate(int _Flush, std::vector<char>& _rCompressedData)
+    {
+        z_stream& rStream = *m_pStream;
+
+        Size NumberOfBytes = _rCompressedData.size();
+
+        int Result;
+
+        // -----------------------------------------------------------------------------
+        // The bound of the pending input is enough for all of it, so
+        // incompressible data needs one more pass at most.
+        // -----------------------------------------------------------------------------
+        do
+        {
+            Grow(_rCompressedData, NumberOfBytes, deflateBound(&rStream, rStream.avail_in));
+
+            rStream.next_out  = reinterpret_cast<Bytef*>(_rCompressedData.data() + NumberOfBytes);
+            rStream.avail_out = static_cast<uInt>(_rCompressedData.size() - NumberOfBytes);
+
+            Result = deflate(&rStream, _Flush);
+
+            NumberOfBytes = _rCompressedData.size() - rStream.avail_out;
+
+            if (Result == Z_STREAM_ERROR)
+            {
+                _rCompressedData.resize(NumberOfBytes);
+
+                BASE_THROWM("Failed to compress")
+            }
+        }
+        while (rStream.avail_in > 0 || (_Flush == Z_FINISH && Result != Z_STREAM_END));
+
+        _rCompressedData.resize(NumberOfBytes);
+    }
+} // namespace Base
+
+namespace Base
+{
+    CDecompressor::CDecompressor()
+        : m_pStream    (new z_stream())
+        , m_IsStreamEnd(false)
+    {
+        CheckResult(inflateInit2(m_pStream.get(), 16 + MAX_WBITS));
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CDecompressor::~CDecompressor()
+    {
+        inflateEnd(m_pStream.get());
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CDecompressor::Write(const char* _pData, Size _NumberOfBytes, std::vector<char>& _rDecompressedData)
+    {
+        z_stream& rStream = *m_pStream;
+
+        rStream.next_in  = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(_pData));
+        rStream.avail_in = static_cast<uInt>(_NumberOfBytes);
+
+        Size NumberOfBytes = _rDecompressedData.size();
+
+        do
+        {
+            // -----------------------------------------------------------------------------
+            // Input behind the end of a member is the next member
+            // -----------------------------------------------------------------------------
+            if (m_IsStreamEnd)
+            {
+                if (rStream.avail_in == 0) break;
+
+                CheckResult(inflateReset(&rStream));
+
+                m_IsStreamEnd = false;
+            }
+
+            Grow(_rDecompressedData, NumberOfBytes, 2 * rStream.avail_in);
+
+            rStream.next_out  = reinterpret_cast<Bytef*>(_rDecompressedData.data() + NumberOfBytes);
+            rStream.avail_out = static_cast<uInt>(_rDecompressedData.size() - NumberOfBytes);
+
+            const int Result = inflate(&rStream, Z_NO_FLUSH);
+
+            NumberOfBytes = _rDecompressedData.size() - rStream.avail_out;
+
+            if (Result == Z_STREAM_END)
+            {
+                m_IsStreamEnd = true;
+            }
+            else if (Result != Z_OK && (Result != Z_BUF_ERROR || rStream.avail_in > 0))
+            {
+                _rDecompressedData.resize(NumberOfBytes);
+
+                BASE_THROWM("Failed to decompress")
+            }
+        }
+        while (rStream.avail_in > 0 || rStream.avail_out == 0);
+
+        _rDecompressedData.resize(NumberOfBytes);
+
+        return m_IsStreamEnd;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CDecompressor::Reset()
+    {
+        CheckResult(inflateReset(m_pStream.get()));
+
+        m_IsStreamEnd = false;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CDecompressor::Decompress(const char* _pData, Size _NumberOfBytes, std::vector<char>& _rDecompressedData)
+    {
+        Reset();
+
+        // -----------------------------------------------------------------------------
+        // A presized output keeps its memory, so the expected size costs no
+        // further allocation.
+        // -----------------------------------------------------------------------------
+        _rDecompressedData.clear();
+
+        if (!Write(_pData, _NumberOfBytes, _rDecompressedData))
+        {
+            BASE_THROWM("Failed to decompress, the data is incomplete")
+        }
+    }
+} // namespace Base
@@ -1,11 +1,99 @@
 
 #pragma once
 
+#include "base/base_typedef.h"
+#include "base/base_uncopyable.h"
+
+#include <memory>
 #include <vector>
 
+struct z_stream_s;
+
 namespace Base
 {
+    // -----------------------------------------------------------------------------
+    // Gzip compression. The level is an index into none, fastest, best and
+    // the zlib default. The outputs are resized to the data, so they do not
+    // have to be presized; data that does not shrink is handled as well.
+    // The functions reuse a context per thread.
+    // -----------------------------------------------------------------------------
     void Decompress(const std::vector<char>& _rCompressedData, std::vector<char>& _rDecompressedData);
+    void Decompress(const char* _pCompressedData, int _Size, std::vector<char>& _rDecompressedData);
     void Compress(const std::vector<char>& _rDecompressedData, std::vector<char>& _rCompressedData, int _Level = 1);
     void Compress(const char* _pDecompressedData, int _Size, std::vector<char>& _rCompressedData, int _Level = 1);
+
+    // -----------------------------------------------------------------------------
+    // Compresses independent blocks on the thread pool and joins them to one
+    // gzip stream of several members (like pigz). Any gzip reader, including
+    // Decompress, reads the result. Small data is compressed as one block.
+    // -----------------------------------------------------------------------------
+    void CompressParallel(const char* _pDecompressedData, Size _NumberOfBytes, std::vector<char>& _rCompressedData, int _Level = 1, Size _NumberOfBytesPerBlock = 1024 * 1024);
+} // namespace Base
+
+namespace Base
+{
+    // -----------------------------------------------------------------------------
+    // Streaming gzip compressor. Chunks are fed one after another and the
+    // compressed bytes are appended to the output; Finish ends the stream.
+    // The context is reused for the next stream.
+    // -----------------------------------------------------------------------------
+    class CCompressor : private CUncopyable
+    {
+    public:
+
+        CCompressor(int _Level = 1);
+        ~CCompressor();
+
+    public:
+
+        void Write(const char* _pData, Size _NumberOfBytes, std::vector<char>& _rCompressedData);
+
+        void Finish(std::vector<char>& _rCompressedData);
+
+        // -----------------------------------------------------------------------------
+        // Replaces the output with the whole stream of the data
+        // -----------------------------------------------------------------------------
+        void Compress(const char* _pData, Size _NumberOfBytes, std::vector<char>& _rCompressedData);
+
+    private:
+
+        std::unique_ptr<z_stream_s> m_pStream;
+
+    private:
+
+        void Deflate(int _Flush, std::vector<char>& _rCompressedData);
+    };
+
+    // -----------------------------------------------------------------------------
+    // Streaming gzip decompressor. Chunks may be split anywhere; the
+    // decompressed bytes are appended to the output. Streams of several
+    // members are read completely. Corrupt data throws.
+    // -----------------------------------------------------------------------------
+    class CDecompressor : private CUncopyable
+    {
+    public:
+
+        CDecompressor();
+        ~CDecompressor();
+
+    public:
+
+        // -----------------------------------------------------------------------------
+        // Returns true once the input ended with a complete member
+        // -----------------------------------------------------------------------------
+        bool Write(const char* _pData, Size _NumberOfBytes, std::vector<char>& _rDecompressedData);
+
+        void Reset();
+
+        // -----------------------------------------------------------------------------
+        // Replaces the output with the decompressed data, which has to be
+        // complete. The size of the output is a hint only.
+        // -----------------------------------------------------------------------------
+        void Decompress(const char* _pData, Size _NumberOfBytes, std::vector<char>& _rDecompressedData);
+
+    private:
+
+        std::unique_ptr<z_stream_s> m_pStream;
+        bool m_IsStreamEnd;
+    };
 } // namespace Base
@@ -6,49 +6,369 @@
 #include <array>
 #include <algorithm>
 #include <cassert>
-#include <functional>
+#include <cstddef>
+#include <iterator>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace PAT
 {
+    // -----------------------------------------------------------------------------
+    // Type erased callable similar to std::function. Functors up to _TSize bytes
+    // (lambdas capturing a few pointers) are stored inside the object, bigger
+    // ones fall back to the heap.
+    // -----------------------------------------------------------------------------
+    template<class TSignature, std::size_t _TSize = 6 * sizeof(void*)>
+    class CInplaceFunction;
+
+    template<class TReturn, class ... Args, std::size_t _TSize>
+    class CInplaceFunction<TReturn(Args...), _TSize>
+    {
+    public:
+
+        CInplaceFunction()
+            : m_pInvoke(nullptr)
+            , m_pManage(nullptr)
+        {
+        }
+
+        template<class TFunctor, class = std::enable_if_t<!std::is_same<std::decay_t<TFunctor>, CInplaceFunction>::value>>
+        CInplaceFunction(TFunctor&& _rFunctor)
+            : m_pInvoke(nullptr)
+            , m_pManage(nullptr)
+        {
+            using CStorage = SStorage<std::decay_t<TFunctor>>;
+
+            CStorage::Create(&m_Storage, std::forward<TFunctor>(_rFunctor));
+
+            m_pInvoke = &CStorage::Invoke;
+            m_pManage = &CStorage::Manage;
+        }
+
+        CInplaceFunction(const CInplaceFunction& _rOther)
+            : m_pInvoke(_rOther.m_pInvoke)
+            , m_pManage(_rOther.m_pManage)
+        {
+            if (m_pManage != nullptr) m_pManage(Copy, &m_Storage, const_cast<void*>(static_cast<const void*>(&_rOther.m_Storage)));
+        }
+
+        CInplaceFunction(CInplaceFunction&& _rOther) noexcept
+            : m_pInvoke(_rOther.m_pInvoke)
+            , m_pManage(_rOther.m_pManage)
+        {
+            if (m_pManage != nullptr) m_pManage(Move, &m_Storage, &_rOther.m_Storage);
+
+            _rOther.Reset();
+        }
+
+       ~CInplaceFunction()
+        {
+            Reset();
+        }
+
+        CInplaceFunction& operator = (const CInplaceFunction& _rOther)
+        {
+            if (this != &_rOther)
+            {
+                CInplaceFunction Copy(_rOther);
+
+                *this = std::move(Copy);
+            }
+
+            return *this;
+        }
+
+        CInplaceFunction& operator = (CInplaceFunction&& _rOther) noexcept
+        {
+            if (this != &_rOther)
+            {
+                Reset();
+
+                m_pInvoke = _rOther.m_pInvoke;
+                m_pManage = _rOther.m_pManage;
+
+                if (m_pManage != nullptr) m_pManage(Move, &m_Storage, &_rOther.m_Storage);
+
+                _rOther.Reset();
+            }
+
+            return *this;
+        }
+
+        TReturn operator () (Args... _Args) const
+        {
+            assert(m_pInvoke != nullptr);
+
+            return m_pInvoke(const_cast<void*>(static_cast<const void*>(&m_Storage)), std::forward<Args>(_Args)...);
+        }
+
+        explicit operator bool () const
+        {
+            return m_pInvoke != nullptr;
+        }
+
+        void Reset()
+        {
+            if (m_pManage != nullptr) m_pManage(Destroy, &m_Storage, nullptr);
+
+            m_pInvoke = nullptr;
+            m_pManage = nullptr;
+        }
+
+    private:
+
+        enum EOperation
+        {
+            Copy,
+            Move,
+            Destroy,
+        };
+
+        using CInvokeFunction = TReturn(*)(void*, Args&&...);
+        using CManageFunction = void(*)(EOperation, void*, void*);
+
+        using CBuffer = std::aligned_storage_t<_TSize, alignof(std::max_align_t)>;
+
+        template<class TFunctor, bool _TIsInplace = sizeof(TFunctor) <= _TSize && alignof(TFunctor) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible<TFunctor>::value>
+        struct SStorage
+        {
+            template<class TArgument>
+            static void Create(void* _pStorage, TArgument&& _rFunctor)
+            {
+                new (_pStorage) TFunctor(std::forward<TArgument>(_rFunctor));
+            }
+
+            static TReturn Invoke(void* _pStorage, Args&&... _Args)
+            {
+                return (*static_cast<TFunctor*>(_pStorage))(std::forward<Args>(_Args)...);
+            }
+
+            static void Manage(EOperation _Operation, void* _pStorage, void* _pOther)
+            {
+                switch (_Operation)
+                {
+                case Copy:    new (_pStorage) TFunctor(*static_cast<const TFunctor*>(_pOther)); break;
+                case Move:    new (_pStorage) TFunctor(std::move(*static_cast<TFunctor*>(_pOther))); break;
+                case Destroy: static_cast<TFunctor*>(_pStorage)->~TFunctor(); break;
+                }
+            }
+        };
+
+        template<class TFunctor>
+        struct SStorage<TFunctor, false>
+        {
+            template<class TArgument>
+            static void Create(void* _pStorage, TArgument&& _rFunctor)
+            {
+                *static_cast<TFunctor**>(_pStorage) = new TFunctor(std::forward<TArgument>(_rFunctor));
+            }
+
+            static TReturn Invoke(void* _pStorage, Args&&... _Args)
+            {
+                return (**static_cast<TFunctor**>(_pStorage))(std::forward<Args>(_Args)...);
+            }
+
+            static void Manage(EOperation _Operation, void* _pStorage, void* _pOther)
+            {
+                switch (_Operation)
+                {
+                case Copy:    *static_cast<TFunctor**>(_pStorage) = new TFunctor(**static_cast<TFunctor**>(_pOther)); break;
+                case Move:    *static_cast<TFunctor**>(_pStorage) = *static_cast<TFunctor**>(_pOther); *static_cast<TFunctor**>(_pOther) = nullptr; break;
+                case Destroy: delete *static_cast<TFunctor**>(_pStorage); break;
+                }
+            }
+        };
+
+    private:
+
+        CBuffer         m_Storage;
+        CInvokeFunction m_pInvoke;
+        CManageFunction m_pManage;
+    };
+} // namespace PAT
+
+namespace PAT
+{
+    // -----------------------------------------------------------------------------
+    // List of listeners that are invoked in place on Notify. Releasing the handle
+    // returned by Register only marks the listener as removed and bumps the
+    // generation; the list is compacted on the next Notify that sees a new
+    // generation, so notifying never allocates or copies a listener.
+    //
+    // Listeners may register or release handles (and notify again) from inside
+    // a notification. New listeners are called from the next Notify on.
+    // -----------------------------------------------------------------------------
     template<class ... Args>
     class CDelegate
     {
+    private:
+
+        class CState;
+
+        // -----------------------------------------------------------------------------
+        // Removes the listener when the last copy of the handle is released.
+        // -----------------------------------------------------------------------------
+        class CHandle
+        {
+        public:
+
+            CHandle(const std::shared_ptr<CState>& _rStatePtr, unsigned int _ID)
+                : m_StatePtr(_rStatePtr)
+                , m_ID      (_ID)
+            {
+            }
+
+           ~CHandle()
+            {
+                if (auto StatePtr = m_StatePtr.lock()) StatePtr->Unregister(m_ID);
+            }
+
+        private:
+
+            std::weak_ptr<CState> m_StatePtr;
+            unsigned int m_ID;
+        };
+
     public:
 
-        using FunctionType = std::function<void(Args...)>;
-        using HandleType = std::shared_ptr<FunctionType>;
+        using FunctionType = CInplaceFunction<void(Args...)>;
+        using HandleType = std::shared_ptr<CHandle>;
 
         void Notify(Args... _Args)
         {
-            Clean();
+            CState& rState = *m_StatePtr;
+
+            if (rState.m_NotifyDepth == 0) rState.Clean();
+
+            ++ rState.m_NotifyDepth;
 
-            for (auto& rDelegate : m_Container)
+            const std::size_t NumberOfListeners = rState.m_Listeners.size();
+
+            for (std::size_t IndexOfListener = 0; IndexOfListener < NumberOfListeners; ++ IndexOfListener)
             {
-                assert(!rDelegate.expired());
-                auto Delegate = *(rDelegate.lock());
-                Delegate(_Args...);
+                SListener& rListener = rState.m_Listeners[IndexOfListener];
+
+                if (rListener.m_IsAlive) rListener.m_Function(_Args...);
             }
+
+            -- rState.m_NotifyDepth;
+
+            if (rState.m_NotifyDepth == 0) rState.Clean();
         }
 
         void Clean()
         {
-            m_Container.erase(std::remove_if(m_Container.begin(), m_Container.end(), [](const auto& _Handle) { return _Handle.expired(); }), m_Container.end());
+            if (m_StatePtr->m_NotifyDepth == 0) m_StatePtr->Clean();
+        }
+
+        HandleType Register(FunctionType _Function)
+        {
+            return m_StatePtr->Register(std::move(_Function));
+        }
+
+        int GetNumberOfListeners() const
+        {
+            return m_StatePtr->m_NumberOfListeners;
         }
 
-        auto Register(FunctionType _Function)
+    public:
+
+        CDelegate()
+            : m_StatePtr(std::make_shared<CState>())
         {
-            auto Ptr = std::make_shared<FunctionType>(_Function);
-            m_Container.push_back(Ptr);
-            return Ptr;
         }
 
     private:
 
-        using ContainerType = std::vector<std::weak_ptr<FunctionType>>;
+        struct SListener
+        {
+            FunctionType m_Function;
+            unsigned int m_ID;
+            bool         m_IsAlive;
+        };
 
-        ContainerType m_Container;
+        using ContainerType = std::vector<SListener>;
+
+        // -----------------------------------------------------------------------------
+        // Shared with the handles, so a handle may outlive its delegate.
+        // -----------------------------------------------------------------------------
+        class CState : public std::enable_shared_from_this<CState>
+        {
+        public:
+
+            HandleType Register(FunctionType&& _rFunction)
+            {
+                const unsigned int ID = m_NextID ++;
+
+                // -----------------------------------------------------------------------------
+                // Inside a notification the listeners must not move, so new ones
+                // are parked until the outermost Notify is done.
+                // -----------------------------------------------------------------------------
+                ContainerType& rContainer = m_NotifyDepth == 0 ? m_Listeners : m_PendingListeners;
+
+                rContainer.push_back({ std::move(_rFunction), ID, true });
+
+                ++ m_NumberOfListeners;
+
+                return std::make_shared<CHandle>(this->shared_from_this(), ID);
+            }
+
+            void Unregister(unsigned int _ID)
+            {
+                // -----------------------------------------------------------------------------
+                // IDs are increasing and compaction keeps the order, so both lists
+                // are sorted by ID.
+                // -----------------------------------------------------------------------------
+                for (ContainerType* pContainer : { &m_Listeners, &m_PendingListeners })
+                {
+                    auto Iterator = std::lower_bound(pContainer->begin(), pContainer->end(), _ID, [](const SListener& _rListener, unsigned int _ID) { return _rListener.m_ID < _ID; });
+
+                    if (Iterator != pContainer->end() && Iterator->m_ID == _ID && Iterator->m_IsAlive)
+                    {
+                        Iterator->m_IsAlive = false;
+
+                        -- m_NumberOfListeners;
+                        ++ m_Generation;
+
+                        return;
+                    }
+                }
+            }
+
+            void Clean()
+            {
+                if (!m_PendingListeners.empty())
+                {
+                    std::move(m_PendingListeners.begin(), m_PendingListeners.end(), std::back_inserter(m_Listeners));
+
+                    m_PendingListeners.clear();
+                }
+
+                if (m_CleanGeneration == m_Generation) return;
+
+                m_Listeners.erase(std::remove_if(m_Listeners.begin(), m_Listeners.end(), [](const SListener& _rListener) { return !_rListener.m_IsAlive; }), m_Listeners.end());
+
+                m_CleanGeneration = m_Generation;
+            }
+
+        public:
+
+            ContainerType m_Listeners;
+            ContainerType m_PendingListeners;
+
+            unsigned int m_NextID = 0;
+            unsigned int m_Generation = 0;
+            unsigned int m_CleanGeneration = 0;
+            int m_NotifyDepth = 0;
+            int m_NumberOfListeners = 0;
+        };
+
+    private:
+
+        std::shared_ptr<CState> m_StatePtr;
     };
 
     // -----------------------------------------------------------------------------
@@ -58,37 +378,28 @@ namespace PAT
     {
     public:
 
-        using FunctionType = std::function<void(Args...)>;
-        using HandleType = std::shared_ptr<FunctionType>;
+        using FunctionType = typename CDelegate<Args...>::FunctionType;
+        using HandleType = typename CDelegate<Args...>::HandleType;
 
         void Notify(int _Container, Args... _Args)
         {
-            Clean(_Container);
-
-            for (auto& rDelegate : m_Container[_Container])
-            {
-                assert(!rDelegate.expired());
-                auto Delegate = *(rDelegate.lock());
-                Delegate(_Args...);
-            }
+            m_Container[_Container].Notify(_Args...);
         }
 
         void Clean(int _Container)
         {
-            m_Container[_Container].erase(std::remove_if(m_Container[_Container].begin(), m_Container[_Container].end(), [](const auto& _Handle) { return _Handle.expired(); }), m_Container[_Container].end());
+            m_Container[_Container].Clean();
         }
 
-        auto Register(int _Container, FunctionType _Function)
+        HandleType Register(int _Container, FunctionType _Function)
         {
-            auto Ptr = std::make_shared<FunctionType>(_Function);
-            m_Container[_Container].push_back(Ptr);
-            return Ptr;
+            return m_Container[_Container].Register(std::move(_Function));
         }
 
     private:
 
-        using ContainerType = std::array<std::vector<std::weak_ptr<FunctionType>>, _TAmount>;
+        using ContainerType = std::array<CDelegate<Args...>, _TAmount>;
 
         ContainerType m_Container;
     };
-} // namespace PAT
\ No newline at end of file
+} // namespace PAT
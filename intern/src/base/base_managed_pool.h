@@ -725,7 +725,7 @@ namespace CON
         // -----------------------------------------------------------------------------
         for (ppPage = m_ppFirstPage; ppPage != m_ppLastPage; ++ ppPage)
         {
-            Base::CMemory::Free(*ppPage);
+            Base::CMemory::Free(*ppPage, Base::CMemory::Pool);
         }
         
         // -----------------------------------------------------------------------------
@@ -733,7 +733,7 @@ namespace CON
         // -----------------------------------------------------------------------------
         if (m_ppFirstPage != 0)
         {
-            Base::CMemory::Free(m_ppFirstPage);
+            Base::CMemory::Free(m_ppFirstPage, Base::CMemory::Pool);
         }
         
         // -----------------------------------------------------------------------------
@@ -781,7 +781,7 @@ namespace CON
             // -----------------------------------------------------------------------------
             ppFirstPage = 0;
             
-            pPage = static_cast<SPage*>(Base::CMemory::Allocate(sizeof(SPage)));
+            pPage = static_cast<SPage*>(Base::CMemory::Allocate(sizeof(SPage), Base::CMemory::Pool));
             
             if (pPage == 0)
             {
@@ -806,7 +806,7 @@ namespace CON
                     OldNumberOfPages = static_cast<BSize>(m_ppLastPage - m_ppFirstPage);
                     NewNumberOfPages = (OldNumberOfPages != 0) ? OldNumberOfPages + (OldNumberOfPages >> 1) : 8;
                     
-                    ppFirstPage = static_cast<SPage**>(Base::CMemory::Allocate(NewNumberOfPages * sizeof(SPage)));
+                    ppFirstPage = static_cast<SPage**>(Base::CMemory::Allocate(NewNumberOfPages * sizeof(SPage), Base::CMemory::Pool));
                     
                     if (ppFirstPage == 0)
                     {
@@ -820,7 +820,7 @@ namespace CON
                     {
                         ::memcpy(ppFirstPage, m_ppFirstPage, OldNumberOfPages * sizeof(*m_ppFirstPage));
                         
-                        Base::CMemory::Free(m_ppFirstPage);
+                        Base::CMemory::Free(m_ppFirstPage, Base::CMemory::Pool);
                     }
                     
                     // -----------------------------------------------------------------------------
@@ -836,8 +836,8 @@ namespace CON
                 // -----------------------------------------------------------------------------
                 // Free the allocated chunks again.
                 // -----------------------------------------------------------------------------
-                Base::CMemory::Free(ppFirstPage);
-                Base::CMemory::Free(pPage);
+                Base::CMemory::Free(ppFirstPage, Base::CMemory::Pool);
+                Base::CMemory::Free(pPage, Base::CMemory::Pool);
                 
                 throw;
             }
@@ -12,6 +12,7 @@
 #include "base/base_typedef.h"
 
 #include <assert.h>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
 #include <new>
@@ -21,6 +22,41 @@ namespace MEM
     class CMemory
     {
 
+    public:
+
+        // -----------------------------------------------------------------------------
+        // Hooks see every chunk that passes Allocate and Free (e.g. to count
+        // the allocations of a benchmark) and have to be thread-safe.
+        // -----------------------------------------------------------------------------
+        using CAllocateHook = void (*)(void* _pChunk, Size _NumberOfBytes);
+        using CFreeHook     = void (*)(void* _pChunk);
+
+        // -----------------------------------------------------------------------------
+        // Chunks allocated with a tag carry a small header and are accounted
+        // per tag. They have to be released with the tagged Free.
+        // -----------------------------------------------------------------------------
+        enum ETag
+        {
+            General,
+            Pool,
+            Map,
+            Mesh,
+            Network,
+            Frame,
+            Scratch,
+            NumberOfTags,
+        };
+
+        struct SStatistics
+        {
+            Size m_NumberOfBytes;                   //< Live bytes
+            Size m_PeakNumberOfBytes;
+            Size m_NumberOfAllocations;             //< All allocations so far
+            Size m_NumberOfLiveAllocations;
+        };
+
+        static constexpr Size s_Alignment = 16;     //< Of tagged chunks
+
     public:
         
         inline static void* Allocate(Size _NumberOfBytes);
@@ -28,6 +64,14 @@ namespace MEM
         inline static void Copy(void* _pChunkTo, const void* _pChunkFrom, Size _NumberOfBytes);
         inline static void Free(void* _pChunk);
         inline static void Zero(void* _pChunk, Size _NumberOfBytes);
+
+    public:
+
+        inline static void* Allocate(Size _NumberOfBytes, ETag _Tag);
+        inline static void Free(void* _pChunk, ETag _Tag);
+
+        inline static SStatistics GetStatistics(ETag _Tag);
+        inline static const char* GetTagName(ETag _Tag);
         
     public:
         
@@ -47,6 +91,37 @@ namespace MEM
         
         template<class T>
         inline static void DeleteObject(T* _pObject);
+
+    public:
+
+        inline static void SetHooks(CAllocateHook _pAllocateHook, CFreeHook _pFreeHook);
+
+    private:
+
+        struct SHooks
+        {
+            std::atomic<CAllocateHook> m_pAllocate;
+            std::atomic<CFreeHook>     m_pFree;
+        };
+
+        struct STagStatistics
+        {
+            std::atomic<Size> m_NumberOfBytes;
+            std::atomic<Size> m_PeakNumberOfBytes;
+            std::atomic<Size> m_NumberOfAllocations;
+            std::atomic<Size> m_NumberOfLiveAllocations;
+        };
+
+        struct alignas(s_Alignment) SHeader
+        {
+            Size         m_NumberOfBytes;
+            unsigned int m_Tag;
+        };
+
+    private:
+
+        inline static SHooks& GetHooks();
+        inline static STagStatistics& GetTagStatistics(ETag _Tag);
     };
 } // namespace MEM
 
@@ -54,7 +129,13 @@ namespace MEM
 {
     void* CMemory::Allocate(Size _NumberOfBytes)
     {
-        return std::malloc(_NumberOfBytes);
+        void* pChunk = std::malloc(_NumberOfBytes);
+
+        CAllocateHook pAllocateHook = GetHooks().m_pAllocate.load(std::memory_order_relaxed);
+
+        if (pAllocateHook != nullptr) pAllocateHook(pChunk, _NumberOfBytes);
+
+        return pChunk;
     }
     
     // -----------------------------------------------------------------------------
@@ -79,6 +160,10 @@ namespace MEM
     
     void CMemory::Free(void* _pChunk)
     {
+        CFreeHook pFreeHook = GetHooks().m_pFree.load(std::memory_order_relaxed);
+
+        if (pFreeHook != nullptr && _pChunk != nullptr) pFreeHook(_pChunk);
+
         std::free(_pChunk);
     }
     
@@ -88,6 +173,79 @@ namespace MEM
     {
         std::memset(_pChunk, 0, _NumberOfBytes);
     }
+
+    // -----------------------------------------------------------------------------
+
+    void* CMemory::Allocate(Size _NumberOfBytes, ETag _Tag)
+    {
+        assert(_Tag < NumberOfTags);
+
+        SHeader* pHeader = static_cast<SHeader*>(Allocate(sizeof(SHeader) + _NumberOfBytes));
+
+        if (pHeader == nullptr) return nullptr;
+
+        pHeader->m_NumberOfBytes = _NumberOfBytes;
+        pHeader->m_Tag           = _Tag;
+
+        STagStatistics& rStatistics = GetTagStatistics(_Tag);
+
+        Size NumberOfBytes     = rStatistics.m_NumberOfBytes.fetch_add(_NumberOfBytes, std::memory_order_relaxed) + _NumberOfBytes;
+        Size PeakNumberOfBytes = rStatistics.m_PeakNumberOfBytes.load(std::memory_order_relaxed);
+
+        while (PeakNumberOfBytes < NumberOfBytes && !rStatistics.m_PeakNumberOfBytes.compare_exchange_weak(PeakNumberOfBytes, NumberOfBytes, std::memory_order_relaxed))
+        {
+        }
+
+        rStatistics.m_NumberOfAllocations    .fetch_add(1, std::memory_order_relaxed);
+        rStatistics.m_NumberOfLiveAllocations.fetch_add(1, std::memory_order_relaxed);
+
+        return pHeader + 1;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMemory::Free(void* _pChunk, ETag _Tag)
+    {
+        if (_pChunk == nullptr) return;
+
+        SHeader* pHeader = static_cast<SHeader*>(_pChunk) - 1;
+
+        assert(pHeader->m_Tag == static_cast<unsigned int>(_Tag));
+
+        STagStatistics& rStatistics = GetTagStatistics(_Tag);
+
+        rStatistics.m_NumberOfBytes          .fetch_sub(pHeader->m_NumberOfBytes, std::memory_order_relaxed);
+        rStatistics.m_NumberOfLiveAllocations.fetch_sub(1, std::memory_order_relaxed);
+
+        Free(pHeader);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CMemory::SStatistics CMemory::GetStatistics(ETag _Tag)
+    {
+        const STagStatistics& rStatistics = GetTagStatistics(_Tag);
+
+        SStatistics Statistics;
+
+        Statistics.m_NumberOfBytes           = rStatistics.m_NumberOfBytes          .load(std::memory_order_relaxed);
+        Statistics.m_PeakNumberOfBytes       = rStatistics.m_PeakNumberOfBytes      .load(std::memory_order_relaxed);
+        Statistics.m_NumberOfAllocations     = rStatistics.m_NumberOfAllocations    .load(std::memory_order_relaxed);
+        Statistics.m_NumberOfLiveAllocations = rStatistics.m_NumberOfLiveAllocations.load(std::memory_order_relaxed);
+
+        return Statistics;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    const char* CMemory::GetTagName(ETag _Tag)
+    {
+        static const char* s_pNames[NumberOfTags] = { "General", "Pool", "Map", "Mesh", "Network", "Frame", "Scratch" };
+
+        assert(_Tag < NumberOfTags);
+
+        return s_pNames[_Tag];
+    }
     
     // -----------------------------------------------------------------------------
     
@@ -147,4 +305,32 @@ namespace MEM
         
         Free(_pObject);
     }
+
+    // -----------------------------------------------------------------------------
+
+    void CMemory::SetHooks(CAllocateHook _pAllocateHook, CFreeHook _pFreeHook)
+    {
+        GetHooks().m_pAllocate.store(_pAllocateHook);
+        GetHooks().m_pFree    .store(_pFreeHook);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CMemory::SHooks& CMemory::GetHooks()
+    {
+        static SHooks s_Hooks = { { nullptr }, { nullptr } };
+
+        return s_Hooks;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CMemory::STagStatistics& CMemory::GetTagStatistics(ETag _Tag)
+    {
+        static STagStatistics s_Statistics[NumberOfTags] = {};
+
+        assert(_Tag < NumberOfTags);
+
+        return s_Statistics[_Tag];
+    }
 } // namespace MEM
\ No newline at end of file
@@ -0,0 +1,366 @@
+
+#pragma once
+
+#include "base/base_defines.h"
+#include "base/base_memory.h"
+#include "base/base_typedef.h"
+#include "base/base_uncopyable.h"
+
+#include <assert.h>
+#include <cstdint>
+
+namespace MEM
+{
+    // -----------------------------------------------------------------------------
+    // Linear allocator on top of tagged blocks of Base::CMemory. Allocations
+    // are only released all at once, either completely or back to a marker.
+    // Blocks are kept on reset, so a warmed up arena does not touch the heap
+    // anymore. An arena is not thread-safe.
+    // -----------------------------------------------------------------------------
+    class CMemoryArena : private Base::CUncopyable
+    {
+    public:
+
+        struct SMarker
+        {
+            void* m_pBlock;
+            Size  m_Offset;
+            Size  m_NumberOfBytes;
+        };
+
+    public:
+
+        inline CMemoryArena(Size _NumberOfBytesPerBlock, CMemory::ETag _Tag);
+        inline ~CMemoryArena();
+
+    public:
+
+        inline void* Allocate(Size _NumberOfBytes, Size _Alignment = CMemory::s_Alignment);
+
+        template<class T>
+        inline T* AllocateArray(Size _NumberOfElements);
+
+    public:
+
+        inline SMarker GetMarker() const;
+
+        inline void Reset(const SMarker& _rMarker);
+
+        // -----------------------------------------------------------------------------
+        // Releases everything. If the last round needed more than one block,
+        // the blocks are merged into one that holds all of them.
+        // -----------------------------------------------------------------------------
+        inline void Reset();
+
+    public:
+
+        inline Size GetNumberOfBytes() const;
+        inline Size GetPeakNumberOfBytes() const;
+        inline Size GetCapacity() const;
+
+    private:
+
+        struct SBlock
+        {
+            SBlock* m_pNext;
+            Size    m_NumberOfBytes;
+        };
+
+    private:
+
+        SBlock*       m_pFirstBlock;
+        SBlock*       m_pCurrentBlock;
+        Size          m_Offset;                     //< In the current block
+        Size          m_NumberOfBytes;              //< Including padding
+        Size          m_PeakNumberOfBytes;
+        Size          m_Capacity;
+        Size          m_NumberOfBytesPerBlock;
+        CMemory::ETag m_Tag;
+
+    private:
+
+        inline static char* GetData(SBlock* _pBlock);
+
+        inline SBlock* CreateBlock(Size _NumberOfBytes);
+        inline void ReleaseBlocks();
+
+        inline void* AllocateFromNextBlock(Size _NumberOfBytes, Size _Alignment);
+    };
+} // namespace MEM
+
+namespace MEM
+{
+    // -----------------------------------------------------------------------------
+    // Temporary memory of the calling thread for the lifetime of the scope.
+    // Scopes can be nested, but must not be passed to other threads.
+    // -----------------------------------------------------------------------------
+    class CScratchScope : private Base::CUncopyable
+    {
+    public:
+
+        inline CScratchScope();
+        inline ~CScratchScope();
+
+    public:
+
+        inline void* Allocate(Size _NumberOfBytes, Size _Alignment = CMemory::s_Alignment);
+
+        template<class T>
+        inline T* AllocateArray(Size _NumberOfElements);
+
+    public:
+
+        inline static CMemoryArena& GetArena();
+
+    private:
+
+        static const Size s_NumberOfBytesPerBlock = 256 * 1024;
+
+    private:
+
+        CMemoryArena&         m_rArena;
+        CMemoryArena::SMarker m_Marker;
+    };
+} // namespace MEM
+
+namespace MEM
+{
+    inline CMemoryArena::CMemoryArena(Size _NumberOfBytesPerBlock, CMemory::ETag _Tag)
+        : m_pFirstBlock          (nullptr)
+        , m_pCurrentBlock        (nullptr)
+        , m_Offset               (0)
+        , m_NumberOfBytes        (0)
+        , m_PeakNumberOfBytes    (0)
+        , m_Capacity             (0)
+        , m_NumberOfBytesPerBlock(_NumberOfBytesPerBlock)
+        , m_Tag                  (_Tag)
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline CMemoryArena::~CMemoryArena()
+    {
+        ReleaseBlocks();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline void* CMemoryArena::Allocate(Size _NumberOfBytes, Size _Alignment)
+    {
+        assert(_Alignment > 0 && (_Alignment & (_Alignment - 1)) == 0);
+
+        if (m_pCurrentBlock != nullptr)
+        {
+            std::uintptr_t Begin   = reinterpret_cast<std::uintptr_t>(GetData(m_pCurrentBlock)) + m_Offset;
+            std::uintptr_t Aligned = (Begin + _Alignment - 1) & ~static_cast<std::uintptr_t>(_Alignment - 1);
+
+            Size Offset = m_Offset + static_cast<Size>(Aligned - Begin);
+
+            if (Offset + _NumberOfBytes <= m_pCurrentBlock->m_NumberOfBytes)
+            {
+                m_NumberOfBytes    += Offset + _NumberOfBytes - m_Offset;
+                m_Offset            = Offset + _NumberOfBytes;
+                m_PeakNumberOfBytes = m_NumberOfBytes > m_PeakNumberOfBytes ? m_NumberOfBytes : m_PeakNumberOfBytes;
+
+                return reinterpret_cast<void*>(Aligned);
+            }
+        }
+
+        return AllocateFromNextBlock(_NumberOfBytes, _Alignment);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<class T>
+    inline T* CMemoryArena::AllocateArray(Size _NumberOfElements)
+    {
+        return static_cast<T*>(Allocate(sizeof(T) * _NumberOfElements, alignof(T) > CMemory::s_Alignment ? alignof(T) : CMemory::s_Alignment));
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline CMemoryArena::SMarker CMemoryArena::GetMarker() const
+    {
+        SMarker Marker;
+
+        Marker.m_pBlock        = m_pCurrentBlock;
+        Marker.m_Offset        = m_Offset;
+        Marker.m_NumberOfBytes = m_NumberOfBytes;
+
+        return Marker;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline void CMemoryArena::Reset(const SMarker& _rMarker)
+    {
+        assert(_rMarker.m_NumberOfBytes <= m_NumberOfBytes);
+
+        m_pCurrentBlock = static_cast<SBlock*>(_rMarker.m_pBlock);
+        m_Offset        = _rMarker.m_Offset;
+        m_NumberOfBytes = _rMarker.m_NumberOfBytes;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline void CMemoryArena::Reset()
+    {
+        if (m_pFirstBlock != nullptr && m_pFirstBlock->m_pNext != nullptr)
+        {
+            Size Capacity = m_Capacity;
+
+            ReleaseBlocks();
+
+            m_pFirstBlock = CreateBlock(Capacity);
+        }
+
+        m_pCurrentBlock = nullptr;
+        m_Offset        = 0;
+        m_NumberOfBytes = 0;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Size CMemoryArena::GetNumberOfBytes() const
+    {
+        return m_NumberOfBytes;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Size CMemoryArena::GetPeakNumberOfBytes() const
+    {
+        return m_PeakNumberOfBytes;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Size CMemoryArena::GetCapacity() const
+    {
+        return m_Capacity;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline char* CMemoryArena::GetData(SBlock* _pBlock)
+    {
+        return reinterpret_cast<char*>(_pBlock) + CMemory::s_Alignment;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline CMemoryArena::SBlock* CMemoryArena::CreateBlock(Size _NumberOfBytes)
+    {
+        static_assert(sizeof(SBlock) <= CMemory::s_Alignment, "Block header has to fit in front of the aligned data");
+
+        SBlock* pBlock = static_cast<SBlock*>(CMemory::Allocate(CMemory::s_Alignment + _NumberOfBytes, m_Tag));
+
+        if (pBlock == nullptr) throw std::bad_alloc();
+
+        pBlock->m_pNext         = nullptr;
+        pBlock->m_NumberOfBytes = _NumberOfBytes;
+
+        m_Capacity += _NumberOfBytes;
+
+        return pBlock;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline void CMemoryArena::ReleaseBlocks()
+    {
+        for (SBlock* pBlock = m_pFirstBlock; pBlock != nullptr; )
+        {
+            SBlock* pNextBlock = pBlock->m_pNext;
+
+            CMemory::Free(pBlock, m_Tag);
+
+            pBlock = pNextBlock;
+        }
+
+        m_pFirstBlock   = nullptr;
+        m_pCurrentBlock = nullptr;
+        m_Capacity      = 0;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline void* CMemoryArena::AllocateFromNextBlock(Size _NumberOfBytes, Size _Alignment)
+    {
+        // -----------------------------------------------------------------------------
+        // The rest of the current block is skipped and counted as used. A kept
+        // block is reused if it is large enough, otherwise a new one is put
+        // in front of it.
+        // -----------------------------------------------------------------------------
+        const Size NumberOfBytesNeeded = _NumberOfBytes + _Alignment;
+
+        SBlock* pPreviousBlock = m_pCurrentBlock;
+        SBlock* pNextBlock     = pPreviousBlock != nullptr ? pPreviousBlock->m_pNext : m_pFirstBlock;
+
+        if (pPreviousBlock != nullptr) m_NumberOfBytes += pPreviousBlock->m_NumberOfBytes - m_Offset;
+
+        if (pNextBlock == nullptr || pNextBlock->m_NumberOfBytes < NumberOfBytesNeeded)
+        {
+            SBlock* pBlock = CreateBlock(NumberOfBytesNeeded > m_NumberOfBytesPerBlock ? NumberOfBytesNeeded : m_NumberOfBytesPerBlock);
+
+            pBlock->m_pNext = pNextBlock;
+
+            if (pPreviousBlock != nullptr)
+            {
+                pPreviousBlock->m_pNext = pBlock;
+            }
+            else
+            {
+                m_pFirstBlock = pBlock;
+            }
+
+            pNextBlock = pBlock;
+        }
+
+        m_pCurrentBlock = pNextBlock;
+        m_Offset        = 0;
+
+        return Allocate(_NumberOfBytes, _Alignment);
+    }
+} // namespace MEM
+
+namespace MEM
+{
+    inline CScratchScope::CScratchScope()
+        : m_rArena(GetArena())
+        , m_Marker(m_rArena.GetMarker())
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline CScratchScope::~CScratchScope()
+    {
+        m_rArena.Reset(m_Marker);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline void* CScratchScope::Allocate(Size _NumberOfBytes, Size _Alignment)
+    {
+        return m_rArena.Allocate(_NumberOfBytes, _Alignment);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<class T>
+    inline T* CScratchScope::AllocateArray(Size _NumberOfElements)
+    {
+        return m_rArena.AllocateArray<T>(_NumberOfElements);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline CMemoryArena& CScratchScope::GetArena()
+    {
+        static thread_local CMemoryArena s_Arena(s_NumberOfBytesPerBlock, CMemory::Scratch);
+
+        return s_Arena;
+    }
+} // namespace MEM
@@ -260,7 +260,7 @@ namespace CON
         // -----------------------------------------------------------------------------
         for (ppPage = m_ppFirstPage; ppPage != m_ppLastPage; ++ ppPage)
         {
-            Base::CMemory::Free(*ppPage);
+            Base::CMemory::Free(*ppPage, Base::CMemory::Pool);
         }
         
         // -----------------------------------------------------------------------------
@@ -268,7 +268,7 @@ namespace CON
         // -----------------------------------------------------------------------------
         if (m_ppFirstPage != nullptr)
         {
-            Base::CMemory::Free(m_ppFirstPage);
+            Base::CMemory::Free(m_ppFirstPage, Base::CMemory::Pool);
         }
         
         // -----------------------------------------------------------------------------
@@ -316,7 +316,7 @@ namespace CON
             // -----------------------------------------------------------------------------
             ppFirstPage = nullptr;
             
-            pPage = static_cast<SNode*>(Base::CMemory::Allocate(TNumberOfItemsPerPage * sizeof(*pPage)));
+            pPage = static_cast<SNode*>(Base::CMemory::Allocate(TNumberOfItemsPerPage * sizeof(*pPage), Base::CMemory::Pool));
             
             if (pPage == nullptr)
             {
@@ -333,7 +333,7 @@ namespace CON
                     OldNumberOfPages = m_ppLastPage - m_ppFirstPage;
                     NewNumberOfPages = (OldNumberOfPages != 0) ? OldNumberOfPages + (OldNumberOfPages >> 1) : 8;
                     
-                    ppFirstPage = static_cast<SNode**>(Base::CMemory::Allocate(NewNumberOfPages * sizeof(*ppFirstPage)));
+                    ppFirstPage = static_cast<SNode**>(Base::CMemory::Allocate(NewNumberOfPages * sizeof(*ppFirstPage), Base::CMemory::Pool));
                     
                     if (ppFirstPage == nullptr)
                     {
@@ -355,7 +355,7 @@ namespace CON
                     // -----------------------------------------------------------------------------
                     if (m_ppFirstPage != nullptr)
                     {
-                        Base::CMemory::Free(m_ppFirstPage);
+                        Base::CMemory::Free(m_ppFirstPage, Base::CMemory::Pool);
                     }
                     
                     // -----------------------------------------------------------------------------
@@ -378,8 +378,8 @@ namespace CON
                 // -----------------------------------------------------------------------------
                 // Free the allocated chunks again.
                 // -----------------------------------------------------------------------------
-                Base::CMemory::Free(ppFirstPage);
-                Base::CMemory::Free(pPage);
+                Base::CMemory::Free(ppFirstPage, Base::CMemory::Pool);
+                Base::CMemory::Free(pPage, Base::CMemory::Pool);
                 
                 throw;
             }
@@ -8,6 +8,16 @@
 
 namespace SER
 {
+    // -----------------------------------------------------------------------------
+    // Components are passed as one array, archives with a bulk path (e.g. the
+    // text archive) overload these; all others get one element after another.
+    // -----------------------------------------------------------------------------
+    template<class TArchive, typename TElement>
+    inline void WritePrimitives(TArchive& _rArchive, const TElement* _pElements, unsigned int _NumberOfElements);
+
+    template<class TArchive, typename TElement>
+    inline void ReadPrimitives(TArchive& _rArchive, TElement* _pElements, unsigned int _NumberOfElements);
+
     template<class TArchive, typename T, glm::precision P>
     inline void Write(TArchive & _rArchive, const glm::tvec2<T, P> & _rVec);
 
@@ -64,12 +74,32 @@ namespace SER
 
 namespace SER
 {
+    template<class TArchive, typename TElement>
+    inline void WritePrimitives(TArchive& _rArchive, const TElement* _pElements, unsigned int _NumberOfElements)
+    {
+        for (unsigned int IndexOfElement = 0; IndexOfElement < _NumberOfElements; ++IndexOfElement)
+        {
+            _rArchive << _pElements[IndexOfElement];
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<class TArchive, typename TElement>
+    inline void ReadPrimitives(TArchive& _rArchive, TElement* _pElements, unsigned int _NumberOfElements)
+    {
+        for (unsigned int IndexOfElement = 0; IndexOfElement < _NumberOfElements; ++IndexOfElement)
+        {
+            _rArchive >> _pElements[IndexOfElement];
+        }
+    }
+
+    // -----------------------------------------------------------------------------
 
     template<class TArchive, typename T, glm::precision P>
     inline void Write(TArchive& _rArchive, const glm::tvec2<T, P>& _rVec)
     {
-        _rArchive << _rVec[0];
-        _rArchive << _rVec[1];
+        WritePrimitives(_rArchive, &_rVec[0], 2);
     }
 
     // -----------------------------------------------------------------------------
@@ -77,8 +107,7 @@ namespace SER
     template<class TArchive, typename T, glm::precision P>
     inline void Read(TArchive& _rArchive, glm::tvec2<T, P>& _rVec)
     {
-        _rArchive >> _rVec[0];
-        _rArchive >> _rVec[1];
+        ReadPrimitives(_rArchive, &_rVec[0], 2);
     }
 
     // -----------------------------------------------------------------------------
@@ -94,9 +123,7 @@ namespace SER
     template<class TArchive, typename T, glm::precision P>
     inline void Write(TArchive& _rArchive, const glm::tvec3<T, P>& _rVec)
     {
-        _rArchive << _rVec[0];
-        _rArchive << _rVec[1];
-        _rArchive << _rVec[2];
+        WritePrimitives(_rArchive, &_rVec[0], 3);
     }
 
     // -----------------------------------------------------------------------------
@@ -104,9 +131,7 @@ namespace SER
     template<class TArchive, typename T, glm::precision P>
     inline void Read(TArchive& _rArchive, glm::tvec3<T, P>& _rVec)
     {
-        _rArchive >> _rVec[0];
-        _rArchive >> _rVec[1];
-        _rArchive >> _rVec[2];
+        ReadPrimitives(_rArchive, &_rVec[0], 3);
     }
 
     // -----------------------------------------------------------------------------
@@ -122,10 +147,7 @@ namespace SER
     template<class TArchive, typename T, glm::precision P>
     inline void Write(TArchive & _rArchive, const glm::tvec4<T, P> & _rVec)
     {
-        _rArchive << _rVec[0];
-        _rArchive << _rVec[1];
-        _rArchive << _rVec[2];
-        _rArchive << _rVec[3];
+        WritePrimitives(_rArchive, &_rVec[0], 4);
     }
 
     // -----------------------------------------------------------------------------
@@ -133,10 +155,7 @@ namespace SER
     template<class TArchive, typename T, glm::precision P>
     inline void Read(TArchive & _rArchive, glm::tvec4<T, P> & _rVec)
     {
-        _rArchive >> _rVec[0];
-        _rArchive >> _rVec[1];
-        _rArchive >> _rVec[2];
-        _rArchive >> _rVec[3];
+        ReadPrimitives(_rArchive, &_rVec[0], 4);
     }
 
     // -----------------------------------------------------------------------------
@@ -152,10 +171,7 @@ namespace SER
     template<class TArchive, typename T, glm::precision P>
     inline void Write(TArchive& _rArchive, const glm::tquat<T, P>& _rQuat)
     {
-        _rArchive << _rQuat[0];
-        _rArchive << _rQuat[1];
-        _rArchive << _rQuat[2];
-        _rArchive << _rQuat[3];
+        WritePrimitives(_rArchive, &_rQuat[0], 4);
     }
 
     // -----------------------------------------------------------------------------
@@ -163,10 +179,7 @@ namespace SER
     template<class TArchive, typename T, glm::precision P>
     inline void Read(TArchive& _rArchive, glm::tquat<T, P>& _rQuat)
     {
-        _rArchive >> _rQuat[0];
-        _rArchive >> _rQuat[1];
-        _rArchive >> _rQuat[2];
-        _rArchive >> _rQuat[3];
+        ReadPrimitives(_rArchive, &_rQuat[0], 4);
     }
 
     // -----------------------------------------------------------------------------
@@ -182,17 +195,7 @@ namespace SER
     template<class TArchive, typename T, glm::precision P>
     inline void Write(TArchive& _rArchive, const glm::tmat3x3<T, P>& _rMat)
     {
-        _rArchive << _rMat[0][0];
-        _rArchive << _rMat[0][1];
-        _rArchive << _rMat[0][2];
-
-        _rArchive << _rMat[1][0];
-        _rArchive << _rMat[1][1];
-        _rArchive << _rMat[1][2];
-
-        _rArchive << _rMat[2][0];
-        _rArchive << _rMat[2][1];
-        _rArchive << _rMat[2][2];
+        WritePrimitives(_rArchive, &_rMat[0][0], 9);
     }
 
     // -----------------------------------------------------------------------------
@@ -200,17 +203,7 @@ namespace SER
     template<class TArchive, typename T, glm::precision P>
     inline void Read(TArchive& _rArchive, glm::tmat3x3<T, P>& _rMat)
     {
-        _rArchive >> _rMat[0][0];
-        _rArchive >> _rMat[0][1];
-        _rArchive >> _rMat[0][2];
-
-        _rArchive >> _rMat[1][0];
-        _rArchive >> _rMat[1][1];
-        _rArchive >> _rMat[1][2];
-
-        _rArchive >> _rMat[2][0];
-        _rArchive >> _rMat[2][1];
-        _rArchive >> _rMat[2][2];
+        ReadPrimitives(_rArchive, &_rMat[0][0], 9);
     }
 
     // -----------------------------------------------------------------------------
@@ -226,25 +219,7 @@ namespace SER
     template<class TArchive, typename T, glm::precision P>
     inline void Write(TArchive& _rArchive, const glm::tmat4x4<T, P>& _rMat)
     {
-        _rArchive << _rMat[0][0];
-        _rArchive << _rMat[0][1];
-        _rArchive << _rMat[0][2];
-        _rArchive << _rMat[0][3];
-
-        _rArchive << _rMat[1][0];
-        _rArchive << _rMat[1][1];
-        _rArchive << _rMat[1][2];
-        _rArchive << _rMat[1][3];
-
-        _rArchive << _rMat[2][0];
-        _rArchive << _rMat[2][1];
-        _rArchive << _rMat[2][2];
-        _rArchive << _rMat[2][3];
-
-        _rArchive << _rMat[3][0];
-        _rArchive << _rMat[3][1];
-        _rArchive << _rMat[3][2];
-        _rArchive << _rMat[3][3];
+        WritePrimitives(_rArchive, &_rMat[0][0], 16);
     }
 
     // -----------------------------------------------------------------------------
@@ -252,25 +227,7 @@ namespace SER
     template<class TArchive, typename T, glm::precision P>
     inline void Read(TArchive& _rArchive, glm::tmat4x4<T, P>& _rMat)
     {
-        _rArchive >> _rMat[0][0];
-        _rArchive >> _rMat[0][1];
-        _rArchive >> _rMat[0][2];
-        _rArchive >> _rMat[0][3];
-
-        _rArchive >> _rMat[1][0];
-        _rArchive >> _rMat[1][1];
-        _rArchive >> _rMat[1][2];
-        _rArchive >> _rMat[1][3];
-
-        _rArchive >> _rMat[2][0];
-        _rArchive >> _rMat[2][1];
-        _rArchive >> _rMat[2][2];
-        _rArchive >> _rMat[2][3];
-
-        _rArchive >> _rMat[3][0];
-        _rArchive >> _rMat[3][1];
-        _rArchive >> _rMat[3][2];
-        _rArchive >> _rMat[3][3];
+        ReadPrimitives(_rArchive, &_rMat[0][0], 16);
     }
 
     // -----------------------------------------------------------------------------
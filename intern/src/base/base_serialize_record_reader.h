@@ -9,6 +9,8 @@
 #include "base/base_serialize_recorder.h"
 #include "base/base_timer.h"
 
+#include <istream>
+
 using namespace Base;
 
 namespace SER
@@ -3,6 +3,14 @@
 
 #include "base/base_defines.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
 namespace SER
 {
 namespace Private
@@ -23,4 +31,256 @@ namespace Code
     static const char* s_Version       = "Version";
 } // namespace Code
 } // namespace Private
-} // namespace SER
\ No newline at end of file
+} // namespace SER
+
+namespace SER
+{
+namespace Private
+{
+namespace Number
+{
+    // -----------------------------------------------------------------------------
+    // Numbers are formatted and parsed on plain character ranges without any
+    // locale. Floating point values are written like the default stream
+    // output as long as six significant digits are exact, otherwise with the
+    // fewest digits that read back to the same value.
+    // -----------------------------------------------------------------------------
+    static const unsigned int s_MaxNumberOfChars = 64;
+    static const int          s_StreamPrecision  = 6;
+
+    template<typename TElement>
+    inline char* Format(char* _pBegin, char* _pEnd, const TElement& _rElement);
+
+    template<typename TElement>
+    inline const char* Parse(const char* _pBegin, const char* _pEnd, TElement& _rElement);
+} // namespace Number
+} // namespace Private
+} // namespace SER
+
+namespace SER
+{
+namespace Private
+{
+namespace Number
+{
+    template<typename TElement>
+    inline bool IsByte()
+    {
+        return std::is_same<TElement, signed char>::value || std::is_same<TElement, unsigned char>::value;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline bool IsSpace(char _Char)
+    {
+        return _Char == ' ' || _Char == '\r' || _Char == '\n' || _Char == '\t' || _Char == '\v' || _Char == '\f';
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<typename TElement>
+    inline char* FormatFloatingPoint(char* _pBegin, char* _pEnd, TElement _Element)
+    {
+#if defined(__cpp_lib_to_chars)
+        // -----------------------------------------------------------------------------
+        // The shortest digits are laid out like "%g" with a precision of at
+        // least six digits. If six digits are enough, no other six digit
+        // decimal is close enough to read back to the same value, so the
+        // stream would have written exactly these digits.
+        // -----------------------------------------------------------------------------
+        if (std::fpclassify(_Element) == FP_SUBNORMAL)
+        {
+            // -----------------------------------------------------------------------------
+            // Denormals are too coarse for this, so they are checked directly
+            // -----------------------------------------------------------------------------
+            std::to_chars_result Result = std::to_chars(_pBegin, _pEnd, _Element, std::chars_format::general, s_StreamPrecision);
+
+            TElement Element = 0;
+
+            if (std::from_chars(_pBegin, Result.ptr, Element).ptr == Result.ptr && Element == _Element) return Result.ptr;
+
+            return std::to_chars(_pBegin, _pEnd, _Element, std::chars_format::general).ptr;
+        }
+
+        char Text[s_MaxNumberOfChars];
+
+        const char* pText    = Text;
+        const char* pTextEnd = std::to_chars(Text, Text + s_MaxNumberOfChars, _Element, std::chars_format::scientific).ptr;
+
+        const char* pExponent = static_cast<const char*>(memchr(Text, 'e', pTextEnd - Text));
+
+        if (pExponent == nullptr)
+        {
+            // -----------------------------------------------------------------------------
+            // Infinity and NaN
+            // -----------------------------------------------------------------------------
+            return std::copy(pText, pTextEnd, _pBegin);
+        }
+
+        char* pOutput = _pBegin;
+
+        if (*pText == '-') *pOutput++ = *pText++;
+
+        char Digits[s_MaxNumberOfChars];
+        int  NumberOfDigits = 0;
+
+        for (; pText != pExponent; ++pText)
+        {
+            if (*pText != '.') Digits[NumberOfDigits++] = *pText;
+        }
+
+        int Exponent = 0;
+
+        std::from_chars(pExponent + (pExponent[1] == '+' ? 2 : 1), pTextEnd, Exponent);
+
+        const int Precision = std::max(NumberOfDigits, s_StreamPrecision);
+
+        if (Exponent < -4 || Exponent >= Precision)
+        {
+            *pOutput++ = Digits[0];
+
+            if (NumberOfDigits > 1)
+            {
+                *pOutput++ = '.';
+
+                pOutput = std::copy(Digits + 1, Digits + NumberOfDigits, pOutput);
+            }
+
+            *pOutput++ = 'e';
+            *pOutput++ = Exponent < 0 ? '-' : '+';
+
+            if (std::abs(Exponent) < 10) *pOutput++ = '0';
+
+            return std::to_chars(pOutput, _pEnd, std::abs(Exponent)).ptr;
+        }
+
+        if (Exponent < 0)
+        {
+            *pOutput++ = '0';
+            *pOutput++ = '.';
+
+            pOutput = std::fill_n(pOutput, -Exponent - 1, '0');
+
+            return std::copy(Digits, Digits + NumberOfDigits, pOutput);
+        }
+
+        const int NumberOfIntegerDigits = Exponent + 1;
+
+        if (NumberOfDigits <= NumberOfIntegerDigits)
+        {
+            pOutput = std::copy(Digits, Digits + NumberOfDigits, pOutput);
+
+            return std::fill_n(pOutput, NumberOfIntegerDigits - NumberOfDigits, '0');
+        }
+
+        pOutput = std::copy(Digits, Digits + NumberOfIntegerDigits, pOutput);
+
+        *pOutput++ = '.';
+
+        return std::copy(Digits + NumberOfIntegerDigits, Digits + NumberOfDigits, pOutput);
+#else
+        // -----------------------------------------------------------------------------
+        // Standard libraries without floating point support in <charconv>
+        // -----------------------------------------------------------------------------
+        int NumberOfChars = snprintf(_pBegin, _pEnd - _pBegin, "%.*g", s_StreamPrecision, static_cast<double>(_Element));
+
+        if (static_cast<TElement>(strtod(_pBegin, nullptr)) != _Element)
+        {
+            NumberOfChars = snprintf(_pBegin, _pEnd - _pBegin, "%.*g", sizeof(TElement) == sizeof(float) ? 9 : 17, static_cast<double>(_Element));
+        }
+
+        return _pBegin + NumberOfChars;
+#endif // defined(__cpp_lib_to_chars)
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<typename TElement>
+    inline const char* ParseFloatingPoint(const char* _pBegin, const char* _pEnd, TElement& _rElement)
+    {
+#if defined(__cpp_lib_to_chars)
+        std::from_chars_result Result = std::from_chars(_pBegin, _pEnd, _rElement);
+
+        return Result.ec == std::errc() ? Result.ptr : nullptr;
+#else
+        char Text[s_MaxNumberOfChars];
+
+        size_t NumberOfChars = std::min(static_cast<size_t>(_pEnd - _pBegin), static_cast<size_t>(s_MaxNumberOfChars - 1));
+
+        memcpy(Text, _pBegin, NumberOfChars);
+
+        Text[NumberOfChars] = '\0';
+
+        char* pEnd = nullptr;
+
+        _rElement = static_cast<TElement>(strtod(Text, &pEnd));
+
+        return pEnd == Text ? nullptr : _pBegin + (pEnd - Text);
+#endif // defined(__cpp_lib_to_chars)
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<typename TElement>
+    inline char* Format(char* _pBegin, char* _pEnd, const TElement& _rElement)
+    {
+        if (std::is_floating_point<TElement>::value)
+        {
+            return FormatFloatingPoint(_pBegin, _pEnd, static_cast<typename std::conditional<std::is_same<TElement, float>::value, float, double>::type>(_rElement));
+        }
+
+        // -----------------------------------------------------------------------------
+        // Single bytes are written as characters like a stream does
+        // -----------------------------------------------------------------------------
+        if (IsByte<TElement>())
+        {
+            *_pBegin = static_cast<char>(_rElement);
+
+            return _pBegin + 1;
+        }
+
+        using XInteger = typename std::conditional<std::is_signed<TElement>::value, long long, unsigned long long>::type;
+
+        return std::to_chars(_pBegin, _pEnd, static_cast<XInteger>(_rElement)).ptr;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<typename TElement>
+    inline const char* Parse(const char* _pBegin, const char* _pEnd, TElement& _rElement)
+    {
+        if (IsByte<TElement>())
+        {
+            if (_pBegin == _pEnd) return nullptr;
+
+            _rElement = static_cast<TElement>(*_pBegin);
+
+            return _pBegin + 1;
+        }
+
+        while (_pBegin != _pEnd && IsSpace(*_pBegin)) ++_pBegin;
+
+        if (std::is_floating_point<TElement>::value)
+        {
+            typename std::conditional<std::is_same<TElement, float>::value, float, double>::type Element = 0;
+
+            const char* pEnd = ParseFloatingPoint(_pBegin, _pEnd, Element);
+
+            _rElement = static_cast<TElement>(Element);
+
+            return pEnd;
+        }
+
+        using XInteger = typename std::conditional<std::is_signed<TElement>::value, long long, unsigned long long>::type;
+
+        XInteger Element = 0;
+
+        std::from_chars_result Result = std::from_chars(_pBegin, _pEnd, Element);
+
+        _rElement = static_cast<TElement>(Element);
+
+        return Result.ec == std::errc() ? Result.ptr : nullptr;
+    }
+} // namespace Number
+} // namespace Private
+} // namespace SER
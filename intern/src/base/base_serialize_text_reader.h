@@ -8,6 +8,7 @@
 
 #include <assert.h>
 #include <sstream>
+#include <vector>
 
 namespace SER
 {
@@ -50,6 +51,9 @@ namespace SER
 
         template<typename TElement>
         inline void ReadPrimitive(TElement& _rElement);
+
+        template<typename TElement>
+        inline void ReadPrimitives(TElement* _pElements, unsigned int _NumberOfElements);
         
         inline void ReadBinary(void* _pBytes, unsigned int _NumberOfBytes);
 
@@ -68,9 +72,16 @@ namespace SER
         };
 
     private:
-        CStream*     m_pStream;
-        unsigned int m_NumberOfIdents;
-        EStatus      m_State;
+
+        static const unsigned int s_BlockSize = 65536;
+
+    private:
+        CStream*          m_pStream;
+        std::vector<char> m_Buffer;                 //< Remaining stream, read at once by the constructor
+        const char*       m_pCurrent;
+        const char*       m_pEnd;
+        unsigned int      m_NumberOfIdents;
+        EStatus           m_State;
 
     private:
         template<typename TElement>
@@ -108,7 +119,12 @@ namespace SER
         inline void InternReadIndent();
 
         inline void InternIgnore(unsigned int _NumberOfBytes);
+
+        inline void InternReadStream();
     };
+
+    template<typename TElement>
+    inline void ReadPrimitives(CTextReader& _rArchive, TElement* _pElements, unsigned int _NumberOfElements);
 } // namespace SER
 
 namespace SER
@@ -116,9 +132,14 @@ namespace SER
     inline CTextReader::CTextReader(CStream& _rStream, unsigned int _Version)
         : CArchive        (_Version)
         , m_pStream       (&_rStream)
+        , m_Buffer        ()
+        , m_pCurrent      (nullptr)
+        , m_pEnd          (nullptr)
         , m_NumberOfIdents(0)
         , m_State         (Root)
     {
+        InternReadStream();
+
         // -----------------------------------------------------------------------------
         // Read header information (internal format, version)
         // -----------------------------------------------------------------------------        
@@ -207,9 +228,24 @@ namespace SER
 
     // -----------------------------------------------------------------------------
 
+    template<typename TElement>
+    inline void CTextReader::ReadPrimitives(TElement* _pElements, unsigned int _NumberOfElements)
+    {
+        for (unsigned int IndexOfElement = 0; IndexOfElement < _NumberOfElements; ++IndexOfElement)
+        {
+            InternReadPrimitive(_pElements[IndexOfElement]);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
     inline void CTextReader::ReadBinary(void* _pBytes, unsigned int _NumberOfBytes)
     {
-        m_pStream->read(static_cast<char*>(_pBytes), _NumberOfBytes);
+        size_t NumberOfBytes = std::min(static_cast<size_t>(_NumberOfBytes), static_cast<size_t>(m_pEnd - m_pCurrent));
+
+        memcpy(_pBytes, m_pCurrent, NumberOfBytes);
+
+        m_pCurrent += NumberOfBytes;
 
         InternReadEOL();
     }
@@ -394,39 +430,39 @@ namespace SER
         case Root:
             {
                 InternReadIndent();
-                (*m_pStream) >> _rElement;
+                InternReadValue(_rElement);
             }
             break;
         case Pair:
             {
                 InternReadIndent();
-                (*m_pStream) >> _rElement;
+                InternReadValue(_rElement);
                 InternReadChar(Private::Code::s_PairSeperator);
             }
             break;
         case List:
             {
                 InternReadIndent();
-                (*m_pStream) >> _rElement;
+                InternReadValue(_rElement);
                 InternReadChar(Private::Code::s_ListSeperator);
             }
             break;
         case Array:
             {
                 InternReadIndent();
-                (*m_pStream) >> _rElement;
+                InternReadValue(_rElement);
             }
             break;
         case Class:
             {
                 InternReadIndent();
-                (*m_pStream) >> _rElement;
+                InternReadValue(_rElement);
             }
             break;
         default:
             {
                 InternReadIndent();
-                (*m_pStream) >> _rElement;
+                InternReadValue(_rElement);
             }
         }
 
@@ -437,8 +473,11 @@ namespace SER
 
     inline void CTextReader::InternReadPrimitive(char& _rElement)
     {
-        (*m_pStream) >> std::noskipws;
-        (*m_pStream) >> _rElement;
+        if (m_pCurrent == m_pEnd) return;
+
+        _rElement = *m_pCurrent;
+
+        ++ m_pCurrent;
     }
 
     // -----------------------------------------------------------------------------
@@ -456,7 +495,14 @@ namespace SER
     template<typename TElement>
     inline void CTextReader::InternReadValue(TElement& _rElement)
     {
-        (*m_pStream) >> _rElement;
+        const char* pEnd = Private::Number::Parse(m_pCurrent, m_pEnd, _rElement);
+
+        if (pEnd == nullptr)
+        {
+            BASE_THROWM("Bad resource because of a malformed number.");
+        }
+
+        m_pCurrent = pEnd;
     }
 
     // -----------------------------------------------------------------------------
@@ -491,7 +537,9 @@ namespace SER
 
     inline void CTextReader::InternJumpEOL()
     {
-        m_pStream->ignore(std::numeric_limits<std::streamsize>::max(), Private::Code::s_EOL);
+        const char* pEOL = static_cast<const char*>(memchr(m_pCurrent, Private::Code::s_EOL, m_pEnd - m_pCurrent));
+
+        m_pCurrent = pEOL != nullptr ? pEOL + 1 : m_pEnd;
     }
 
     // -----------------------------------------------------------------------------
@@ -505,6 +553,39 @@ namespace SER
 
     inline void CTextReader::InternIgnore(unsigned int _NumberOfBytes)
     {
-        m_pStream->ignore(_NumberOfBytes);
+        m_pCurrent += std::min(static_cast<size_t>(_NumberOfBytes), static_cast<size_t>(m_pEnd - m_pCurrent));
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline void CTextReader::InternReadStream()
+    {
+        std::streambuf* pStreamBuffer = m_pStream->rdbuf();
+
+        std::streamsize NumberOfBytes = s_BlockSize;
+
+        while (pStreamBuffer != nullptr && NumberOfBytes == s_BlockSize)
+        {
+            size_t Offset = m_Buffer.size();
+
+            m_Buffer.resize(Offset + s_BlockSize);
+
+            NumberOfBytes = pStreamBuffer->sgetn(m_Buffer.data() + Offset, s_BlockSize);
+
+            m_Buffer.resize(Offset + static_cast<size_t>(NumberOfBytes));
+        }
+
+        m_pStream->setstate(std::ios::eofbit);
+
+        m_pCurrent = m_Buffer.data();
+        m_pEnd     = m_Buffer.data() + m_Buffer.size();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<typename TElement>
+    inline void ReadPrimitives(CTextReader& _rArchive, TElement* _pElements, unsigned int _NumberOfElements)
+    {
+        _rArchive.ReadPrimitives(_pElements, _NumberOfElements);
     }
 } // namespace SER
\ No newline at end of file
@@ -8,6 +8,7 @@
 
 #include <assert.h>
 #include <sstream>
+#include <string>
 #include <fstream>
 
 namespace SER
@@ -51,6 +52,9 @@ namespace SER
         
         template<typename TElement>
         inline void WritePrimitive(const TElement& _rElement);
+
+        template<typename TElement>
+        inline void WritePrimitives(const TElement* _pElements, unsigned int _NumberOfElements);
                 
         inline void WriteBinary(const void* _pBytes, const unsigned int _NumberOfBytes);
 
@@ -67,6 +71,7 @@ namespace SER
 
     private:
         CStream*     m_pStream;
+        std::string  m_Buffer;                      //< Text that is not yet passed to the stream
         unsigned int m_NumberOfIdents;
         EStatus      m_State;
 
@@ -102,7 +107,12 @@ namespace SER
         inline void InternWriteEOL();
 
         inline void InternWriteIndent();
+
+        inline void InternFlush();
     };
+
+    template<typename TElement>
+    inline void WritePrimitives(CTextWriter& _rArchive, const TElement* _pElements, unsigned int _NumberOfElements);
 } // namespace SER
 
 namespace SER
@@ -110,6 +120,7 @@ namespace SER
     inline CTextWriter::CTextWriter(CStream& _rStream, unsigned int _Version)
         : CArchive        (_Version)
         , m_pStream       (&_rStream)
+        , m_Buffer        ()
         , m_NumberOfIdents(0)
         , m_State         (Default)
     {
@@ -127,7 +138,7 @@ namespace SER
 
     inline CTextWriter::~CTextWriter()
     {
-
+        InternFlush();
     }
 
     // -----------------------------------------------------------------------------
@@ -196,9 +207,22 @@ namespace SER
 
     // -----------------------------------------------------------------------------
 
+    template<typename TElement>
+    inline void CTextWriter::WritePrimitives(const TElement* _pElements, unsigned int _NumberOfElements)
+    {
+        m_Buffer.reserve(m_Buffer.size() + _NumberOfElements * (m_NumberOfIdents + 16));
+
+        for (unsigned int IndexOfElement = 0; IndexOfElement < _NumberOfElements; ++IndexOfElement)
+        {
+            InternWritePrimitive(_pElements[IndexOfElement]);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
     inline void CTextWriter::WriteBinary(const void* _pBytes, const unsigned int _NumberOfBytes)
     {
-        m_pStream->write(static_cast<const char*>(_pBytes), _NumberOfBytes);
+        m_Buffer.append(static_cast<const char*>(_pBytes), _NumberOfBytes);
 
         InternWriteEOL();
     }
@@ -383,20 +407,20 @@ namespace SER
         case Default:
             {
                 InternWriteIndent();
-                (*m_pStream) << _rElement;
+                InternWriteValue(_rElement);
             }
             break;
         case List:
             {
                 InternWriteIndent();
-                (*m_pStream) << _rElement;
+                InternWriteValue(_rElement);
                 InternWriteChar(Private::Code::s_ListSeperator);
             }
             break;
         default:
             {
                 InternWriteIndent();
-                (*m_pStream) << _rElement;
+                InternWriteValue(_rElement);
             }
         }
         
@@ -407,14 +431,14 @@ namespace SER
 
     inline void CTextWriter::InternWritePrimitive(const char& _rElement)
     {
-        (*m_pStream) << _rElement;
+        m_Buffer.push_back(_rElement);
     }
 
     // -----------------------------------------------------------------------------
 
     inline void CTextWriter::InternWritePrimitive(const wchar_t& _rElement)
     {
-        (*m_pStream) << _rElement;
+        InternWriteValue(_rElement);
     }
 
     // -----------------------------------------------------------------------------
@@ -422,31 +446,30 @@ namespace SER
     template<typename TElement>
     inline void CTextWriter::InternWriteValue(const TElement& _rElement)
     {
-        (*m_pStream) << _rElement;
+        char Text[Private::Number::s_MaxNumberOfChars];
+
+        m_Buffer.append(Text, Private::Number::Format(Text, Text + Private::Number::s_MaxNumberOfChars, _rElement));
     }
 
     // -----------------------------------------------------------------------------
 
     inline void CTextWriter::InternWriteChar(const char _Char)
     {
-        (*m_pStream) << _Char;
+        m_Buffer.push_back(_Char);
     }
 
     // -----------------------------------------------------------------------------
    
     inline void CTextWriter::InternWriteChar(const char _Char, unsigned int _NumberOfChars)
     {
-        for (unsigned int IndexOfChar = 0; IndexOfChar < _NumberOfChars; ++ IndexOfChar)
-        {
-            InternWriteChar(_Char);
-        }
+        m_Buffer.append(_NumberOfChars, _Char);
     }
 
     // -----------------------------------------------------------------------------
 
     inline void CTextWriter::InternWriteName(const char* _pChar)
     {
-        (*m_pStream) << _pChar;
+        m_Buffer.append(_pChar);
     }
 
     // -----------------------------------------------------------------------------
@@ -454,6 +477,12 @@ namespace SER
     inline void CTextWriter::InternWriteEOL()
     {
         InternWriteChar(Private::Code::s_EOL);
+
+        // -----------------------------------------------------------------------------
+        // A line without indent ends everything the caller has written, so
+        // the stream is complete between two calls.
+        // -----------------------------------------------------------------------------
+        if (m_NumberOfIdents == 0) InternFlush();
     }
 
     // -----------------------------------------------------------------------------
@@ -462,4 +491,23 @@ namespace SER
     {
         InternWriteChar(Private::Code::s_Indent, m_NumberOfIdents);
     }
+
+    // -----------------------------------------------------------------------------
+
+    inline void CTextWriter::InternFlush()
+    {
+        if (m_Buffer.empty()) return;
+
+        m_pStream->write(m_Buffer.data(), m_Buffer.size());
+
+        m_Buffer.clear();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<typename TElement>
+    inline void WritePrimitives(CTextWriter& _rArchive, const TElement* _pElements, unsigned int _NumberOfElements)
+    {
+        _rArchive.WritePrimitives(_pElements, _NumberOfElements);
+    }
 } // namespace SER
\ No newline at end of file
@@ -0,0 +1,245 @@
+#pragma once
+
+#include "base/base_defines.h"
+
+// -----------------------------------------------------------------------------
+// Instruction set
+// -----------------------------------------------------------------------------
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BASE_SIMD_SSE 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BASE_SIMD_NEON 1
+#include <arm_neon.h>
+#else
+#define BASE_SIMD_SCALAR 1
+#endif
+
+namespace Base
+{
+namespace SIMD
+{
+#if BASE_SIMD_SSE
+    using Float4 = __m128;
+#elif BASE_SIMD_NEON
+    using Float4 = float32x4_t;
+#else
+    struct Float4
+    {
+        float m_Values[4];
+    };
+#endif
+
+    inline Float4 Zero();
+    inline Float4 Set(float _Value);
+    inline Float4 Set(float _X, float _Y, float _Z, float _W);
+    inline Float4 Load(const float* _pValues);
+    inline void Store(float* _pValues, Float4 _Value);
+
+    inline Float4 Add(Float4 _Left, Float4 _Right);
+    inline Float4 Sub(Float4 _Left, Float4 _Right);
+    inline Float4 Mul(Float4 _Left, Float4 _Right);
+    inline Float4 MulAdd(Float4 _Left, Float4 _Right, Float4 _Add);
+} // namespace SIMD
+} // namespace Base
+
+namespace Base
+{
+namespace SIMD
+{
+#if BASE_SIMD_SSE
+
+    inline Float4 Zero()
+    {
+        return _mm_setzero_ps();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Set(float _Value)
+    {
+        return _mm_set1_ps(_Value);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Set(float _X, float _Y, float _Z, float _W)
+    {
+        return _mm_setr_ps(_X, _Y, _Z, _W);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Load(const float* _pValues)
+    {
+        return _mm_loadu_ps(_pValues);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline void Store(float* _pValues, Float4 _Value)
+    {
+        _mm_storeu_ps(_pValues, _Value);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Add(Float4 _Left, Float4 _Right)
+    {
+        return _mm_add_ps(_Left, _Right);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Sub(Float4 _Left, Float4 _Right)
+    {
+        return _mm_sub_ps(_Left, _Right);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Mul(Float4 _Left, Float4 _Right)
+    {
+        return _mm_mul_ps(_Left, _Right);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 MulAdd(Float4 _Left, Float4 _Right, Float4 _Add)
+    {
+        return _mm_add_ps(_mm_mul_ps(_Left, _Right), _Add);
+    }
+
+#elif BASE_SIMD_NEON
+
+    inline Float4 Zero()
+    {
+        return vdupq_n_f32(0.0f);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Set(float _Value)
+    {
+        return vdupq_n_f32(_Value);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Set(float _X, float _Y, float _Z, float _W)
+    {
+        const float Values[4] = { _X, _Y, _Z, _W };
+
+        return vld1q_f32(Values);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Load(const float* _pValues)
+    {
+        return vld1q_f32(_pValues);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline void Store(float* _pValues, Float4 _Value)
+    {
+        vst1q_f32(_pValues, _Value);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Add(Float4 _Left, Float4 _Right)
+    {
+        return vaddq_f32(_Left, _Right);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Sub(Float4 _Left, Float4 _Right)
+    {
+        return vsubq_f32(_Left, _Right);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Mul(Float4 _Left, Float4 _Right)
+    {
+        return vmulq_f32(_Left, _Right);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 MulAdd(Float4 _Left, Float4 _Right, Float4 _Add)
+    {
+        return vmlaq_f32(_Add, _Left, _Right);
+    }
+
+#else
+
+    inline Float4 Zero()
+    {
+        return Set(0.0f);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Set(float _Value)
+    {
+        return Set(_Value, _Value, _Value, _Value);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Set(float _X, float _Y, float _Z, float _W)
+    {
+        Float4 Result = { { _X, _Y, _Z, _W } };
+
+        return Result;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Load(const float* _pValues)
+    {
+        return Set(_pValues[0], _pValues[1], _pValues[2], _pValues[3]);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline void Store(float* _pValues, Float4 _Value)
+    {
+        for (int Index = 0; Index < 4; ++Index) _pValues[Index] = _Value.m_Values[Index];
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Add(Float4 _Left, Float4 _Right)
+    {
+        return Set(_Left.m_Values[0] + _Right.m_Values[0], _Left.m_Values[1] + _Right.m_Values[1], _Left.m_Values[2] + _Right.m_Values[2], _Left.m_Values[3] + _Right.m_Values[3]);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Sub(Float4 _Left, Float4 _Right)
+    {
+        return Set(_Left.m_Values[0] - _Right.m_Values[0], _Left.m_Values[1] - _Right.m_Values[1], _Left.m_Values[2] - _Right.m_Values[2], _Left.m_Values[3] - _Right.m_Values[3]);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 Mul(Float4 _Left, Float4 _Right)
+    {
+        return Set(_Left.m_Values[0] * _Right.m_Values[0], _Left.m_Values[1] * _Right.m_Values[1], _Left.m_Values[2] * _Right.m_Values[2], _Left.m_Values[3] * _Right.m_Values[3]);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Float4 MulAdd(Float4 _Left, Float4 _Right, Float4 _Add)
+    {
+        return Add(Mul(_Left, _Right), _Add);
+    }
+
+#endif
+} // namespace SIMD
+} // namespace Base
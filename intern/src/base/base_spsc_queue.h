@@ -0,0 +1,138 @@
+
+#pragma once
+
+#include "base/base_typedef.h"
+#include "base/base_uncopyable.h"
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace Base
+{
+    // -----------------------------------------------------------------------------
+    // Bounded lock-free queue for exactly one producer and one consumer
+    // thread. The slots are allocated once; the capacity is rounded up to a
+    // power of two. Head and tail live on their own cache lines, so the two
+    // threads only share a line when they touch the same slot.
+    // -----------------------------------------------------------------------------
+    template<typename TItem>
+    class CSPSCQueue : private CUncopyable
+    {
+    public:
+
+        explicit CSPSCQueue(Size _Capacity);
+
+    public:
+
+        // -----------------------------------------------------------------------------
+        // Producer only. The item is left untouched if the queue is full.
+        // -----------------------------------------------------------------------------
+        bool TryPush(TItem& _rItem);
+
+        // -----------------------------------------------------------------------------
+        // Consumer only. The slot keeps the moved-from item until it is reused.
+        // -----------------------------------------------------------------------------
+        bool TryPop(TItem& _rItem);
+
+        // -----------------------------------------------------------------------------
+        // Exact on either thread for its own side, a snapshot otherwise
+        // -----------------------------------------------------------------------------
+        Size GetSize() const;
+        Size GetCapacity() const;
+        bool IsEmpty() const;
+
+    private:
+
+        static const Size s_SizeOfCacheLine = 64;
+
+    private:
+
+        std::vector<TItem> m_Items;
+        Size m_Mask;
+
+        char m_HeadPadding[s_SizeOfCacheLine];
+        std::atomic<Size> m_Head;                   //< Written by the producer only
+        char m_TailPadding[s_SizeOfCacheLine - sizeof(std::atomic<Size>)];
+        std::atomic<Size> m_Tail;                   //< Written by the consumer only
+        char m_EndPadding[s_SizeOfCacheLine - sizeof(std::atomic<Size>)];
+    };
+} // namespace Base
+
+namespace Base
+{
+    template<typename TItem>
+    CSPSCQueue<TItem>::CSPSCQueue(Size _Capacity)
+        : m_Items()
+        , m_Mask (0)
+        , m_Head (0)
+        , m_Tail (0)
+    {
+        Size Capacity = 1;
+
+        while (Capacity < _Capacity) Capacity <<= 1;
+
+        m_Items.resize(Capacity);
+
+        m_Mask = Capacity - 1;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<typename TItem>
+    bool CSPSCQueue<TItem>::TryPush(TItem& _rItem)
+    {
+        const Size Head = m_Head.load(std::memory_order_relaxed);
+
+        if (Head - m_Tail.load(std::memory_order_acquire) > m_Mask) return false;
+
+        m_Items[Head & m_Mask] = std::move(_rItem);
+
+        m_Head.store(Head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<typename TItem>
+    bool CSPSCQueue<TItem>::TryPop(TItem& _rItem)
+    {
+        const Size Tail = m_Tail.load(std::memory_order_relaxed);
+
+        if (Tail == m_Head.load(std::memory_order_acquire)) return false;
+
+        _rItem = std::move(m_Items[Tail & m_Mask]);
+
+        m_Tail.store(Tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<typename TItem>
+    Size CSPSCQueue<TItem>::GetSize() const
+    {
+        const Size Tail = m_Tail.load(std::memory_order_acquire);
+        const Size Head = m_Head.load(std::memory_order_acquire);
+
+        return Head - Tail;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<typename TItem>
+    Size CSPSCQueue<TItem>::GetCapacity() const
+    {
+        return m_Mask + 1;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<typename TItem>
+    bool CSPSCQueue<TItem>::IsEmpty() const
+    {
+        return GetSize() == 0;
+    }
+} // namespace Base
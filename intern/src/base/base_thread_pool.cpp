@@ -0,0 +1,196 @@
+
+#include "base/base_precompiled.h"
+
+#include "base/base_thread_pool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+
+namespace
+{
+    struct SParallelForState
+    {
+        std::atomic_int m_NextChunk;
+        std::atomic_int m_FinishedChunks;
+
+        int m_NumberOfChunks;
+        int m_GrainSize;
+        int m_Count;
+
+        const Base::CThreadPool::CRangeTask* m_pTask;
+
+        std::mutex m_Mutex;
+        std::condition_variable m_FinishedCondition;
+    };
+
+    // -----------------------------------------------------------------------------
+
+    void ProcessChunks(SParallelForState& _rState)
+    {
+        // -----------------------------------------------------------------------------
+        // Late helpers see an exhausted counter and never touch the task, so it is
+        // safe for the caller to return as soon as all chunks are finished.
+        // -----------------------------------------------------------------------------
+        int Chunk;
+
+        while ((Chunk = _rState.m_NextChunk.fetch_add(1)) < _rState.m_NumberOfChunks)
+        {
+            const int Begin = Chunk * _rState.m_GrainSize;
+            const int End = std::min(Begin + _rState.m_GrainSize, _rState.m_Count);
+
+            (*_rState.m_pTask)(Begin, End);
+
+            if (_rState.m_FinishedChunks.fetch_add(1) + 1 == _rState.m_NumberOfChunks)
+            {
+                std::lock_guard<std::mutex> Lock(_rState.m_Mutex);
+
+                _rState.m_FinishedCondition.notify_all();
+            }
+        }
+    }
+} // namespace
+
+namespace Base
+{
+    CThreadPool& CThreadPool::GetInstance()
+    {
+        static CThreadPool s_Instance;
+        return s_Instance;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CThreadPool::ParallelFor(int _Count, int _GrainSize, const CRangeTask& _rTask)
+    {
+        assert(_GrainSize > 0);
+
+        if (_Count <= 0) return;
+
+        const int NumberOfChunks = (_Count + _GrainSize - 1) / _GrainSize;
+
+        if (NumberOfChunks == 1 || m_Workers.empty())
+        {
+            _rTask(0, _Count);
+
+            return;
+        }
+
+        auto pState = std::make_shared<SParallelForState>();
+
+        pState->m_NextChunk = 0;
+        pState->m_FinishedChunks = 0;
+        pState->m_NumberOfChunks = NumberOfChunks;
+        pState->m_GrainSize = _GrainSize;
+        pState->m_Count = _Count;
+        pState->m_pTask = &_rTask;
+
+        const int NumberOfHelpers = std::min(static_cast<int>(m_Workers.size()), NumberOfChunks - 1);
+
+        {
+            std::lock_guard<std::mutex> Lock(m_Mutex);
+
+            for (int IndexOfHelper = 0; IndexOfHelper < NumberOfHelpers; ++IndexOfHelper)
+            {
+                m_Tasks.emplace_back([pState]() { ProcessChunks(*pState); });
+            }
+        }
+
+        m_TaskCondition.notify_all();
+
+        ProcessChunks(*pState);
+
+        std::unique_lock<std::mutex> Lock(pState->m_Mutex);
+
+        pState->m_FinishedCondition.wait(Lock, [&]() { return pState->m_FinishedChunks == NumberOfChunks; });
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CThreadPool::Enqueue(CTask _Task)
+    {
+        if (m_Workers.empty())
+        {
+            _Task();
+
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> Lock(m_Mutex);
+
+            m_Tasks.emplace_back(std::move(_Task));
+        }
+
+        m_TaskCondition.notify_one();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CThreadPool::GetNumberOfWorkers() const
+    {
+        return static_cast<int>(m_Workers.size());
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CThreadPool::Run()
+    {
+        for (;;)
+        {
+            CTask Task;
+
+            {
+                std::unique_lock<std::mutex> Lock(m_Mutex);
+
+                m_TaskCondition.wait(Lock, [this]() { return !m_IsRunning || !m_Tasks.empty(); });
+
+                if (!m_IsRunning && m_Tasks.empty()) return;
+
+                Task = std::move(m_Tasks.front());
+
+                m_Tasks.pop_front();
+            }
+
+            Task();
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CThreadPool::CThreadPool(int _NumberOfWorkers)
+        : m_IsRunning(true)
+    {
+        int NumberOfWorkers = _NumberOfWorkers;
+
+        if (NumberOfWorkers <= 0)
+        {
+            NumberOfWorkers = std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 0);
+        }
+
+        m_Workers.reserve(NumberOfWorkers);
+
+        for (int IndexOfWorker = 0; IndexOfWorker < NumberOfWorkers; ++IndexOfWorker)
+        {
+            m_Workers.emplace_back(&CThreadPool::Run, this);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CThreadPool::~CThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> Lock(m_Mutex);
+
+            m_IsRunning = false;
+        }
+
+        m_TaskCondition.notify_all();
+
+        for (auto& rWorker : m_Workers)
+        {
+            rWorker.join();
+        }
+    }
+} // namespace Base
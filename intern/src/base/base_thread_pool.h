@@ -0,0 +1,58 @@
+#pragma once
+
+#include "base/base_defines.h"
+#include "base/base_uncopyable.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Base
+{
+    class CThreadPool : private CUncopyable
+    {
+    public:
+
+        using CTask = std::function<void()>;
+        using CRangeTask = std::function<void(int _Begin, int _End)>;
+
+    public:
+
+        static CThreadPool& GetInstance();
+
+    public:
+
+        // -----------------------------------------------------------------------------
+        // Splits [0, _Count) into chunks of _GrainSize elements and processes them
+        // on the workers and the calling thread. Returns after every chunk is done.
+        // -----------------------------------------------------------------------------
+        void ParallelFor(int _Count, int _GrainSize, const CRangeTask& _rTask);
+
+        void Enqueue(CTask _Task);
+
+        int GetNumberOfWorkers() const;
+
+    public:
+
+        CThreadPool(int _NumberOfWorkers = 0);
+       ~CThreadPool();
+
+    private:
+
+        void Run();
+
+    private:
+
+        std::vector<std::thread> m_Workers;
+        std::deque<CTask> m_Tasks;
+
+        std::mutex m_Mutex;
+        std::condition_variable m_TaskCondition;
+
+        bool m_IsRunning;
+    };
+} // namespace Base
@@ -325,7 +325,7 @@ namespace
                     BASE_THROWM("Could not initialise controller.");
                 }
 
-                ENGINE_CONSOLE_INFOV(SDL_JoystickName(m_pGamePad));
+                ENGINE_CONSOLE_INFOV("%s", SDL_JoystickName(m_pGamePad));
             }
         }
     }
@@ -962,7 +962,7 @@ namespace
             {
                 BASE_THROWM("Could not initialise controller");
             }
-            ENGINE_CONSOLE_INFOV(SDL_JoystickName(m_pGamePad));
+            ENGINE_CONSOLE_INFOV("%s", SDL_JoystickName(m_pGamePad));
             break;
 
         case SDL_JOYDEVICEREMOVED:
@@ -5,6 +5,7 @@
 
 #include "editor/edit_edit_state.h"
 #include "editor/edit_load_map_state.h"
+#include "editor/edit_scene_journal.h"
 #include "editor/edit_unload_map_state.h"
 
 #include "engine/core/core_asset_manager.h"
@@ -101,8 +102,10 @@ namespace Edit
         }
 
         // -----------------------------------------------------------------------------
-        // Load
+        // Load (the previous scene might still be written in the background)
         // -----------------------------------------------------------------------------
+        CSceneJournal::GetInstance().Wait();
+
         std::ifstream oStream;
 
         oStream.open(Core::AssetManager::GetPathToAssets() + "/" + m_Filename);
@@ -119,6 +122,8 @@ namespace Edit
 
             oStream.close();
 
+            CSceneJournal::GetInstance().Begin(m_Filename, true);
+
             CUnloadMapState::GetInstance().SaveToFile(m_Filename);
 
             ENGINE_CONSOLE_INFOV("Sucessfully opened scene '%s.'", m_Filename.c_str());
@@ -161,6 +166,8 @@ namespace Edit
                 CreatePixMixScene();
             }
 
+            CSceneJournal::GetInstance().Begin(m_Filename, false);
+
             CEditState::GetInstance().SetDirty(true);
         }
     }
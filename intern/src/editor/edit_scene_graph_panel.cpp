@@ -21,20 +21,43 @@
 
 #include "imgui/imgui.h"
 
+#include <algorithm>
+#include <cctype>
+#include <functional>
+
+namespace
+{
+    std::string GetSearchName(const std::string& _rName)
+    {
+        std::string SearchName = _rName;
+
+        std::transform(SearchName.begin(), SearchName.end(), SearchName.begin(), [](unsigned char _Character) { return static_cast<char>(std::tolower(_Character)); });
+
+        return SearchName;
+    }
+} // namespace
+
 namespace Edit
 {
 namespace GUI
 {
     CSceneGraphPanel::CSceneGraphPanel()
+        : m_Nodes         ()
+        , m_RootEntities  ()
+        , m_Rows          ()
+        , m_IsModelValid  (false)
+        , m_IsRowsDirty   (true)
     {
+        m_Filter[0] = '\0';
 
+        m_OnDirtyEntityDelegate = Dt::CEntityManager::GetInstance().RegisterDirtyEntityHandler(std::bind(&CSceneGraphPanel::OnDirtyEntity, this, std::placeholders::_1));
     }
 
     // -----------------------------------------------------------------------------
 
     CSceneGraphPanel::~CSceneGraphPanel()
     {
-
+        m_OnDirtyEntityDelegate = nullptr;
     }
 
     // -----------------------------------------------------------------------------
@@ -42,55 +65,12 @@ namespace GUI
     void CSceneGraphPanel::Render()
     {
         // -----------------------------------------------------------------------------
-        // Build graph
+        // Entities that existed before the first frame or a reset are taken
+        // from the map once; everything else comes from the notifications.
         // -----------------------------------------------------------------------------
-        m_ItemState.clear();
-
-        std::function<void(Dt::CEntity*, int&)> RecursiveTree = [&](Dt::CEntity* _pEntity, int& _rDepth)->void
+        if (!m_IsModelValid)
         {
-            Dt::CEntity* pSibling = _pEntity;
-
-            while (pSibling != nullptr)
-            {
-                SItemState ItemState;
-
-                ItemState.Depth      = _rDepth;
-                ItemState.pEntity    = pSibling;
-
-                m_ItemState.push_back(ItemState);
-
-                auto pHierarchyFacet = pSibling->GetHierarchyFacet();
-
-                if (pHierarchyFacet->GetFirstChild() != nullptr)
-                {
-                    ++ _rDepth;
-
-                    RecursiveTree(pHierarchyFacet->GetFirstChild(), _rDepth);
-
-                    -- _rDepth;
-                }
-
-                pSibling = pHierarchyFacet->GetSibling();
-            }
-        };
-
-        auto CurrentEntity = Dt::Map::EntitiesBegin();
-        auto EndOfEntities = Dt::Map::EntitiesEnd();
-
-        int CurrentDepth = 0;
-
-        while (CurrentEntity != EndOfEntities)
-        {
-            auto pHierarchyFacet = CurrentEntity->GetHierarchyFacet();
-
-            Dt::CEntity* pEntity = &*CurrentEntity;
-
-            if (pHierarchyFacet->GetParent() == nullptr)
-            {
-                RecursiveTree(pEntity, CurrentDepth);
-            }
-
-            CurrentEntity = CurrentEntity.Next();
+            BuildModel();
         }
 
         // -----------------------------------------------------------------------------
@@ -107,111 +87,136 @@ namespace GUI
 
         ImGui::Text("Scene: %s", Scenename.c_str());
 
-        ImGui::BeginChild("SCENE_GRAPH_PANEL_CHILD");
+        ImGui::PushItemWidth(-1);
+
+        if (ImGui::InputText("##SCENE_GRAPH_FILTER", m_Filter, s_MaxFilterLength))
+        {
+            m_IsRowsDirty = true;
+        }
 
-        int MaximumDepth = 1000;
+        ImGui::PopItemWidth();
 
-        for (auto[Depth, pEntity] : m_ItemState)
+        if (m_IsRowsDirty)
         {
-            if (Depth > MaximumDepth) continue;
+            BuildRows();
+        }
 
-            MaximumDepth = 1000;
+        ImGui::BeginChild("SCENE_GRAPH_PANEL_CHILD");
+
+        // -----------------------------------------------------------------------------
+        // Changes to the entities are applied after the list, because they
+        // invalidate the rows.
+        // -----------------------------------------------------------------------------
+        Dt::CEntity*     pDeletedEntity = nullptr;
+        Dt::CEntity::BID DraggedID      = Dt::CEntity::s_InvalidID;
+        Dt::CEntity::BID DropTargetID   = Dt::CEntity::s_InvalidID;
 
-            Dt::CEntity::BID CurrentID = pEntity->GetID();
+        const bool  IsFiltered    = m_Filter[0] != '\0';
+        const float RowHeight     = ImGui::GetFrameHeight();
+        const float IndentSpacing = ImGui::GetStyle().IndentSpacing;
 
-            ImGui::PushID(static_cast<int>(CurrentID));
+        ImGuiListClipper Clipper(static_cast<int>(m_Rows.size()), ImGui::GetFrameHeightWithSpacing());
 
-            for (int i = 0; i < Depth; ++ i)
+        while (Clipper.Step())
+        {
+            for (int IndexOfRow = Clipper.DisplayStart; IndexOfRow < Clipper.DisplayEnd; ++IndexOfRow)
             {
-                ImGui::Indent();
-            }
+                Dt::CEntity* pEntity = m_Rows[IndexOfRow].m_pEntity;
 
-            auto pHierarchyFacet = pEntity->GetHierarchyFacet();
+                Dt::CEntity::BID CurrentID = pEntity->GetID();
 
-            if (pHierarchyFacet->GetFirstChild() != nullptr)
-            {
-                char* Identifier = m_SelectionState[CurrentID] ? "+" : "-";
+                ImGui::PushID(static_cast<int>(CurrentID));
 
-                if (ImGui::Button(Identifier))
-                {
-                    m_SelectionState[CurrentID] = !m_SelectionState[CurrentID];
-                }
+                ImGui::SetCursorPosX(ImGui::GetCursorPosX() + m_Rows[IndexOfRow].m_Depth * IndentSpacing);
 
-                ImGui::SameLine();
-            }
+                auto pHierarchyFacet = pEntity->GetHierarchyFacet();
 
-            if (pHierarchyFacet->GetFirstChild() == nullptr)
-            {
-                ImGui::Indent();
-            }
+                if (!IsFiltered && pHierarchyFacet != nullptr && pHierarchyFacet->GetFirstChild() != nullptr)
+                {
+                    auto Node = m_Nodes.find(pEntity);
 
-            if (m_SelectionState[CurrentID]) MaximumDepth = Depth;
+                    const bool IsCollapsed = Node != m_Nodes.end() && Node->second.m_IsCollapsed;
 
-            if (ImGui::Selectable(pEntity->GetName().c_str()))
-            {
-                CInspectorPanel::GetInstance().InspectEntity(CurrentID);
+                    if (ImGui::Button(IsCollapsed ? "+" : "-"))
+                    {
+                        UpdateNode(*pEntity).m_IsCollapsed = !IsCollapsed;
 
-                Gfx::HighlightRenderer::HighlightEntity(CurrentID);
-            }
+                        m_IsRowsDirty = true;
+                    }
 
-            if (ImGui::BeginPopupContextItem())
-            {
-                if (ImGui::Button("Delete"))
+                    ImGui::SameLine();
+                }
+                else
                 {
-                    Dt::CEntityManager::GetInstance().MarkEntityAsDirty(*pEntity, Dt::CEntity::DirtyRemove | Dt::CEntity::DirtyDestroy);
+                    ImGui::SetCursorPosX(ImGui::GetCursorPosX() + IndentSpacing);
                 }
 
-                ImGui::EndPopup();
-            }
+                if (ImGui::Selectable(pEntity->GetName().c_str(), false, 0, ImVec2(0.0f, RowHeight)))
+                {
+                    CInspectorPanel::GetInstance().InspectEntity(CurrentID);
 
-            if (pHierarchyFacet->GetFirstChild() == nullptr)
-            {
-                ImGui::Unindent();
-            }
+                    Gfx::HighlightRenderer::HighlightEntity(CurrentID);
+                }
 
-            for (int i = 0; i < Depth; ++i)
-            {
-                ImGui::Unindent();
-            }
+                if (ImGui::BeginPopupContextItem())
+                {
+                    if (ImGui::Button("Delete"))
+                    {
+                        pDeletedEntity = pEntity;
+                    }
 
-            if (ImGui::BeginDragDropSource(ImGuiDragDropFlags_None))
-            {
-                ImGui::SetDragDropPayload("SCENE_GRAPH_DRAGDROP", &CurrentID, sizeof(Dt::CEntity::BID));
+                    ImGui::EndPopup();
+                }
 
-                ImGui::Text("%s", pEntity->GetName().c_str());
+                if (ImGui::BeginDragDropSource(ImGuiDragDropFlags_None))
+                {
+                    ImGui::SetDragDropPayload("SCENE_GRAPH_DRAGDROP", &CurrentID, sizeof(Dt::CEntity::BID));
 
-                ImGui::EndDragDropSource();
-            }
+                    ImGui::Text("%s", pEntity->GetName().c_str());
 
-            if (ImGui::BeginDragDropTarget())
-            {
-                if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("SCENE_GRAPH_DRAGDROP"))
+                    ImGui::EndDragDropSource();
+                }
+
+                if (ImGui::BeginDragDropTarget())
                 {
-                    assert(payload->DataSize == sizeof(Dt::CEntity::BID*));
+                    if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("SCENE_GRAPH_DRAGDROP"))
+                    {
+                        assert(payload->DataSize == sizeof(Dt::CEntity::BID));
 
-                    auto EntityIDDestination = *static_cast<const Dt::CEntity::BID*>(payload->Data);
+                        DraggedID    = *static_cast<const Dt::CEntity::BID*>(payload->Data);
+                        DropTargetID = CurrentID;
+                    }
 
-                    Dt::CEntity* pSourceEntity = Dt::CEntityManager::GetInstance().GetEntityByID(EntityIDDestination);
+                    ImGui::EndDragDropTarget();
+                }
 
-                    if (pSourceEntity == nullptr) return;
+                ImGui::PopID();
+            }
+        }
 
-                    pSourceEntity->Detach();
+        ImGui::EndChild();
 
-                    Dt::CEntity* pDestinationEntity = Dt::CEntityManager::GetInstance().GetEntityByID(CurrentID);
+        if (pDeletedEntity != nullptr)
+        {
+            Dt::CEntityManager::GetInstance().MarkEntityAsDirty(*pDeletedEntity, Dt::CEntity::DirtyRemove | Dt::CEntity::DirtyDestroy);
+        }
 
-                    pDestinationEntity->Attach(*pSourceEntity);
+        if (DraggedID != Dt::CEntity::s_InvalidID && DraggedID != DropTargetID)
+        {
+            Dt::CEntity* pSourceEntity      = Dt::CEntityManager::GetInstance().GetEntityByID(DraggedID);
+            Dt::CEntity* pDestinationEntity = Dt::CEntityManager::GetInstance().GetEntityByID(DropTargetID);
 
-                    Dt::CEntityManager::GetInstance().MarkEntityAsDirty(*pSourceEntity, Dt::CEntity::DirtyMove);
+            if (pSourceEntity != nullptr && pDestinationEntity != nullptr)
+            {
+                pSourceEntity->Detach();
 
-                    CEditState::GetInstance().SetDirty();
-                }
-                ImGui::EndDragDropTarget();
-            }
+                pDestinationEntity->Attach(*pSourceEntity);
 
-            ImGui::PopID();
-        }
+                Dt::CEntityManager::GetInstance().MarkEntityAsDirty(*pSourceEntity, Dt::CEntity::DirtyMove);
 
-        ImGui::EndChild();
+                CEditState::GetInstance().SetDirty();
+            }
+        }
 
         if (ImGui::BeginDragDropTarget())
         {
@@ -253,5 +258,197 @@ namespace GUI
     {
         return "Scene Graph";
     }
+
+    // -----------------------------------------------------------------------------
+
+    void CSceneGraphPanel::Reset()
+    {
+        m_Nodes       .clear();
+        m_RootEntities.clear();
+        m_Rows        .clear();
+
+        m_IsModelValid = false;
+        m_IsRowsDirty  = true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CSceneGraphPanel::OnDirtyEntity(Dt::CEntity* _pEntity)
+    {
+        if (!m_IsModelValid) return;
+
+        // -----------------------------------------------------------------------------
+        // Destroyed entities are already released, only the flags are valid.
+        // -----------------------------------------------------------------------------
+        const unsigned int DirtyFlags = _pEntity->GetDirtyFlags();
+
+        if ((DirtyFlags & (Dt::CEntity::DirtyRemove | Dt::CEntity::DirtyDestroy)) != 0 || !_pEntity->IsInMap())
+        {
+            RemoveNode(_pEntity);
+        }
+        else
+        {
+            UpdateNode(*_pEntity);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CSceneGraphPanel::BuildModel()
+    {
+        m_Nodes       .clear();
+        m_RootEntities.clear();
+
+        auto CurrentEntity = Dt::Map::EntitiesBegin();
+        auto EndOfEntities = Dt::Map::EntitiesEnd();
+
+        while (CurrentEntity != EndOfEntities)
+        {
+            UpdateNode(*CurrentEntity);
+
+            CurrentEntity = CurrentEntity.Next();
+        }
+
+        m_IsModelValid = true;
+        m_IsRowsDirty  = true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CSceneGraphPanel::SNode& CSceneGraphPanel::UpdateNode(Dt::CEntity& _rEntity)
+    {
+        auto Result = m_Nodes.try_emplace(&_rEntity);
+
+        SNode& rNode = Result.first->second;
+
+        auto pHierarchyFacet = _rEntity.GetHierarchyFacet();
+
+        Dt::CEntity* pParentEntity = pHierarchyFacet != nullptr ? pHierarchyFacet->GetParent() : nullptr;
+
+        std::string SearchName = GetSearchName(_rEntity.GetName());
+
+        // -----------------------------------------------------------------------------
+        // Moved entities are notified every frame while they are inspected,
+        // so rows are only flattened again if the tree or a name changed.
+        // -----------------------------------------------------------------------------
+        const bool HasChanged = Result.second || rNode.m_pParent != pParentEntity || rNode.m_SearchName != SearchName;
+
+        if (Result.second)
+        {
+            rNode.m_IsCollapsed = false;
+        }
+        else if (rNode.m_pParent == nullptr)
+        {
+            m_RootEntities.erase(rNode.m_ID);
+        }
+
+        rNode.m_ID         = _rEntity.GetID();
+        rNode.m_pParent    = pParentEntity;
+        rNode.m_SearchName = std::move(SearchName);
+
+        if (rNode.m_pParent == nullptr)
+        {
+            m_RootEntities[rNode.m_ID] = &_rEntity;
+        }
+
+        m_IsRowsDirty |= HasChanged;
+
+        return rNode;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CSceneGraphPanel::RemoveNode(Dt::CEntity* _pEntity)
+    {
+        auto Node = m_Nodes.find(_pEntity);
+
+        if (Node == m_Nodes.end()) return;
+
+        if (Node->second.m_pParent == nullptr)
+        {
+            m_RootEntities.erase(Node->second.m_ID);
+        }
+
+        m_Nodes.erase(Node);
+
+        m_IsRowsDirty = true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CSceneGraphPanel::BuildRows()
+    {
+        m_Rows.clear();
+
+        m_IsRowsDirty = false;
+
+        // -----------------------------------------------------------------------------
+        // A filter shows every matching entity as a flat list.
+        // -----------------------------------------------------------------------------
+        if (m_Filter[0] != '\0')
+        {
+            const std::string Filter = GetSearchName(m_Filter);
+
+            std::vector<std::pair<Dt::CEntity::BID, Dt::CEntity*>> Matches;
+
+            for (const auto& rNode : m_Nodes)
+            {
+                if (rNode.second.m_SearchName.find(Filter) != std::string::npos)
+                {
+                    Matches.push_back({ rNode.second.m_ID, rNode.first });
+                }
+            }
+
+            std::sort(Matches.begin(), Matches.end());
+
+            for (const auto& rMatch : Matches)
+            {
+                m_Rows.push_back({ rMatch.second, 0 });
+            }
+
+            return;
+        }
+
+        // -----------------------------------------------------------------------------
+        // Depth first through the expanded entities; children of collapsed
+        // entities are never visited.
+        // -----------------------------------------------------------------------------
+        std::vector<SRow> Stack;
+        std::vector<Dt::CEntity*> Children;
+
+        for (auto RootEntity = m_RootEntities.rbegin(); RootEntity != m_RootEntities.rend(); ++RootEntity)
+        {
+            Stack.push_back({ RootEntity->second, 0 });
+        }
+
+        while (!Stack.empty())
+        {
+            const SRow Row = Stack.back();
+
+            Stack.pop_back();
+
+            m_Rows.push_back(Row);
+
+            auto pHierarchyFacet = Row.m_pEntity->GetHierarchyFacet();
+
+            if (pHierarchyFacet == nullptr) continue;
+
+            auto Node = m_Nodes.find(Row.m_pEntity);
+
+            if (Node != m_Nodes.end() && Node->second.m_IsCollapsed) continue;
+
+            Children.clear();
+
+            for (Dt::CEntity* pChildEntity = pHierarchyFacet->GetFirstChild(); pChildEntity != nullptr && pChildEntity->GetHierarchyFacet() != nullptr; pChildEntity = pChildEntity->GetHierarchyFacet()->GetSibling())
+            {
+                Children.push_back(pChildEntity);
+            }
+
+            for (auto ChildEntity = Children.rbegin(); ChildEntity != Children.rend(); ++ChildEntity)
+            {
+                Stack.push_back({ *ChildEntity, Row.m_Depth + 1 });
+            }
+        }
+    }
 } // namespace GUI
 } // namespace Edit
\ No newline at end of file
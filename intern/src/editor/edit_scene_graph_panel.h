@@ -6,14 +6,22 @@
 #include "editor/edit_panel_interface.h"
 
 #include "engine/data/data_entity.h"
+#include "engine/data/data_entity_manager.h"
 
-#include <vector>
 #include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace Edit
 {
 namespace GUI
 {
+    // -----------------------------------------------------------------------------
+    // The tree model is kept up to date by the dirty entity notifications;
+    // rows are only flattened again if the model, the collapse state or the
+    // filter changed, and only the visible rows are submitted to ImGui.
+    // -----------------------------------------------------------------------------
     class CSceneGraphPanel : public IPanel
     {
         BASE_SINGLETON_FUNC(CSceneGraphPanel)
@@ -29,19 +37,57 @@ namespace GUI
 
         const char* GetName() override;
 
+        // -----------------------------------------------------------------------------
+        // Has to be called if entities were released without notification,
+        // e.g. after clearing the entity manager.
+        // -----------------------------------------------------------------------------
+        void Reset();
+
     private:
 
-        struct SItemState
+        struct SNode
+        {
+            Dt::CEntity::BID m_ID;
+            Dt::CEntity*     m_pParent;             //< Roots have no parent
+            std::string      m_SearchName;          //< Lower case name for the filter
+            bool             m_IsCollapsed;
+        };
+
+        struct SRow
         {
-            int Depth;
-            Dt::CEntity* pEntity;
+            Dt::CEntity* m_pEntity;
+            int          m_Depth;
         };
 
+        using CNodes        = std::unordered_map<Dt::CEntity*, SNode>;
+        using CRootEntities = std::map<Dt::CEntity::BID, Dt::CEntity*>;
+        using CRows         = std::vector<SRow>;
+
+    private:
+
+        static const int s_MaxFilterLength = 128;
+
+    private:
+
+        CNodes        m_Nodes;
+        CRootEntities m_RootEntities;               //< Sorted by ID to keep the order of creation
+        CRows         m_Rows;
+        char          m_Filter[s_MaxFilterLength];
+        bool          m_IsModelValid;
+        bool          m_IsRowsDirty;
+
+        Dt::CEntityManager::CEntityDelegate::HandleType m_OnDirtyEntityDelegate;
+
     private:
 
-        std::vector<SItemState> m_ItemState;
-        std::map<Dt::CEntity::BID, bool> m_SelectionState;
+        void OnDirtyEntity(Dt::CEntity* _pEntity);
+
+        void BuildModel();
+
+        SNode& UpdateNode(Dt::CEntity& _rEntity);
+        void RemoveNode(Dt::CEntity* _pEntity);
 
+        void BuildRows();
     };
 } // namespace GUI
-} // namespace Edit
\ No newline at end of file
+} // namespace Edit
@@ -0,0 +1,546 @@
+
+#include "editor/edit_precompiled.h"
+
+#include "base/base_crc.h"
+#include "base/base_defines.h"
+#include "base/base_exception.h"
+#include "base/base_serialize_text_reader.h"
+#include "base/base_serialize_text_writer.h"
+
+#include "editor/edit_scene_journal.h"
+
+#include "engine/core/core_asset_manager.h"
+#include "engine/core/core_console.h"
+
+#include "engine/data/data_component.h"
+#include "engine/data/data_hierarchy_facet.h"
+#include "engine/data/data_map.h"
+#include "engine/data/data_transformation_facet.h"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+#ifdef PLATFORM_WINDOWS
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+#include <filesystem>
+#endif
+
+namespace
+{
+    const char* g_JournalExtension   = ".journal";
+    const char* g_TemporaryExtension = ".tmp";
+
+    // -----------------------------------------------------------------------------
+    // The content goes into a temporary file first, which is then renamed over
+    // the target in one step. An interrupted write leaves either the old or
+    // the new file behind, never a broken or missing one.
+    // -----------------------------------------------------------------------------
+    bool ReplaceFile(const std::string& _rPathToFile, const std::string& _rContent)
+    {
+        const std::string PathToTemporaryFile = _rPathToFile + g_TemporaryExtension;
+
+        std::ofstream oStream;
+
+        oStream.open(PathToTemporaryFile);
+
+        if (!oStream.is_open()) return false;
+
+        oStream << _rContent;
+
+        oStream.close();
+
+        if (oStream.fail())
+        {
+            std::remove(PathToTemporaryFile.c_str());
+
+            return false;
+        }
+
+#ifdef PLATFORM_WINDOWS
+        // -----------------------------------------------------------------------------
+        // rename fails on Windows if the target exists
+        // -----------------------------------------------------------------------------
+        const std::filesystem::path From(PathToTemporaryFile);
+        const std::filesystem::path To(_rPathToFile);
+
+        return MoveFileExW(From.c_str(), To.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+#else
+        return std::rename(PathToTemporaryFile.c_str(), _rPathToFile.c_str()) == 0;
+#endif
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Base::BHash GetChecksum(const std::string& _rContent)
+    {
+        return ENC::CRC32(_rContent.data(), static_cast<unsigned int>(_rContent.size()));
+    }
+} // namespace
+
+namespace Edit
+{
+    CSceneJournal::CSceneJournal()
+        : m_Filename            ()
+        , m_HasSceneFile        (false)
+        , m_IsTracking          (false)
+        , m_HasUnsavedChanges   (false)
+        , m_HasStructuralChanges(false)
+        , m_HasJournal          (false)
+        , m_SceneChecksum       (0)
+    {
+        m_OnDirtyEntityDelegate    = Dt::CEntityManager::GetInstance().RegisterDirtyEntityHandler(std::bind(&CSceneJournal::OnDirtyEntity, this, std::placeholders::_1));
+        m_OnDirtyComponentDelegate = Dt::CComponentManager::GetInstance().RegisterDirtyComponentHandler(std::bind(&CSceneJournal::OnDirtyComponent, this, std::placeholders::_1));
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CSceneJournal::~CSceneJournal()
+    {
+        Wait();
+
+        m_OnDirtyEntityDelegate    = nullptr;
+        m_OnDirtyComponentDelegate = nullptr;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CSceneJournal::Begin(const std::string& _rFilename, bool _IsReadFromFile)
+    {
+        Wait();
+
+        m_Filename             = _rFilename;
+        m_HasSceneFile         = _IsReadFromFile;
+        m_HasUnsavedChanges    = false;
+        m_HasStructuralChanges = false;
+        m_HasJournal           = false;
+        m_SceneChecksum        = 0;
+
+        m_Entities  .clear();
+        m_Components.clear();
+        m_ParentIDs .clear();
+
+        // -----------------------------------------------------------------------------
+        // Parents are remembered to tell a reparented entity from a moved one.
+        // -----------------------------------------------------------------------------
+        auto CurrentEntity = Dt::Map::EntitiesBegin();
+        auto EndOfEntities = Dt::Map::EntitiesEnd();
+
+        for (; CurrentEntity != EndOfEntities; CurrentEntity = CurrentEntity.Next())
+        {
+            m_ParentIDs[CurrentEntity->GetID()] = GetParentID(*CurrentEntity);
+        }
+
+        const bool IsReplayed = _IsReadFromFile && Replay(Core::AssetManager::GetPathToAssets() + "/" + _rFilename);
+
+        m_IsTracking = true;
+
+        // -----------------------------------------------------------------------------
+        // A journal that was left behind by closing the scene with unsaved
+        // changes goes into the scene file right away.
+        // -----------------------------------------------------------------------------
+        if (IsReplayed && Flush() == Failed)
+        {
+            ENGINE_CONSOLE_ERRORV("Journal of scene '%s' could not be written into the scene file.", _rFilename.c_str());
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CSceneJournal::End()
+    {
+        m_IsTracking = false;
+
+        m_Entities  .clear();
+        m_Components.clear();
+        m_ParentIDs .clear();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CSceneJournal::ESaveResult CSceneJournal::Save(const std::string& _rFilename, bool _IsUnloading)
+    {
+        // -----------------------------------------------------------------------------
+        // The journal must not be written while a compaction removes it.
+        // -----------------------------------------------------------------------------
+        Wait();
+
+        const std::string PathToFile = Core::AssetManager::GetPathToAssets() + "/" + _rFilename;
+
+        const bool IsSceneFile = m_IsTracking && m_HasSceneFile && _rFilename == m_Filename;
+
+        if (IsSceneFile && !m_HasUnsavedChanges && !(_IsUnloading && m_HasJournal))
+        {
+            return Unchanged;
+        }
+
+        const size_t NumberOfRecords = m_Entities.size() + m_Components.size();
+
+        if (IsSceneFile && !_IsUnloading && !m_HasStructuralChanges && NumberOfRecords <= s_MaxNumberOfJournalRecords)
+        {
+            if (!WriteJournal(PathToFile)) return Failed;
+
+            m_HasUnsavedChanges = false;
+            m_HasJournal        = true;
+
+            return Journal;
+        }
+
+        if (!Compact(PathToFile)) return Failed;
+
+        m_Filename             = _rFilename;
+        m_HasSceneFile         = true;
+        m_HasUnsavedChanges    = false;
+        m_HasStructuralChanges = false;
+        m_HasJournal           = false;
+
+        m_Entities  .clear();
+        m_Components.clear();
+
+        return Compacted;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CSceneJournal::ESaveResult CSceneJournal::Flush()
+    {
+        Wait();
+
+        if (!m_IsTracking || !m_HasJournal) return Unchanged;
+
+        if (m_HasUnsavedChanges) return Journal;
+
+        if (!Compact(Core::AssetManager::GetPathToAssets() + "/" + m_Filename)) return Failed;
+
+        m_HasJournal = false;
+
+        m_Entities  .clear();
+        m_Components.clear();
+
+        return Compacted;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CSceneJournal::Wait()
+    {
+        if (m_CompactionThread.joinable())
+        {
+            m_CompactionThread.join();
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CSceneJournal::OnDirtyEntity(Dt::CEntity* _pEntity)
+    {
+        if (!m_IsTracking) return;
+
+        const unsigned int DirtyFlags = _pEntity->GetDirtyFlags();
+
+        const Dt::CEntity::BID ID = _pEntity->GetID();
+
+        m_HasUnsavedChanges = true;
+
+        // -----------------------------------------------------------------------------
+        // Destroyed entities are already released, only flags and ID are valid.
+        // -----------------------------------------------------------------------------
+        if ((DirtyFlags & Dt::CEntity::DirtyDestroy) != 0)
+        {
+            m_HasStructuralChanges = true;
+
+            m_ParentIDs.erase(ID);
+
+            return;
+        }
+
+        const Dt::CEntity::BID ParentID = GetParentID(*_pEntity);
+
+        auto Parent = m_ParentIDs.find(ID);
+
+        const bool IsReparented = Parent == m_ParentIDs.end() || Parent->second != ParentID;
+
+        if ((DirtyFlags & (Dt::CEntity::DirtyCreate | Dt::CEntity::DirtyAdd | Dt::CEntity::DirtyRemove | Dt::CEntity::DirtyComponent)) != 0 || IsReparented)
+        {
+            m_HasStructuralChanges = true;
+
+            m_ParentIDs[ID] = ParentID;
+
+            return;
+        }
+
+        m_Entities.insert(ID);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CSceneJournal::OnDirtyComponent(Dt::IComponent* _pComponent)
+    {
+        if (!m_IsTracking) return;
+
+        m_HasUnsavedChanges = true;
+
+        if ((_pComponent->GetDirtyFlags() & (Dt::IComponent::DirtyCreate | Dt::IComponent::DirtyDestroy)) != 0)
+        {
+            m_HasStructuralChanges = true;
+
+            return;
+        }
+
+        m_Components.insert(_pComponent->GetID());
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Dt::CEntity::BID CSceneJournal::GetParentID(Dt::CEntity& _rEntity) const
+    {
+        Dt::CHierarchyFacet* pHierarchyFacet = _rEntity.GetHierarchyFacet();
+
+        if (pHierarchyFacet == nullptr || pHierarchyFacet->GetParent() == nullptr) return Dt::CEntity::s_InvalidID;
+
+        return pHierarchyFacet->GetParent()->GetID();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CSceneJournal::Replay(const std::string& _rPathToFile)
+    {
+        // -----------------------------------------------------------------------------
+        // Read like it was written (in text mode), so the checksum is the one
+        // of the serialized scene.
+        // -----------------------------------------------------------------------------
+        {
+            std::ifstream iSceneStream(_rPathToFile);
+
+            m_SceneChecksum = GetChecksum(std::string(std::istreambuf_iterator<char>(iSceneStream), std::istreambuf_iterator<char>()));
+        }
+
+        std::ifstream iStream;
+
+        iStream.open(_rPathToFile + g_JournalExtension);
+
+        if (!iStream.is_open()) return false;
+
+        try
+        {
+            Base::CTextReader Reader(iStream, 1);
+
+            // -----------------------------------------------------------------------------
+            // A journal belongs to the scene file it was written for. If the
+            // scene file was written after it (e.g. a compaction that could
+            // not remove the journal anymore), replaying it would revert the
+            // newer changes.
+            // -----------------------------------------------------------------------------
+            Base::BHash SceneChecksum = 0;
+
+            Reader >> SceneChecksum;
+
+            if (SceneChecksum != m_SceneChecksum)
+            {
+                ENGINE_CONSOLE_WARNINGV("Journal of scene '%s' belongs to an older scene file and is ignored.", m_Filename.c_str());
+
+                return false;
+            }
+
+            // -----------------------------------------------------------------------------
+            // Components
+            // -----------------------------------------------------------------------------
+            size_t NumberOfComponents = 0;
+
+            Reader >> NumberOfComponents;
+
+            for (size_t IndexOfComponent = 0; IndexOfComponent < NumberOfComponents; ++IndexOfComponent)
+            {
+                Base::ID ID = 0;
+
+                Reader >> ID;
+
+                auto pComponent = Dt::CComponentManager::GetInstance().GetComponent<Dt::IComponent>(ID);
+
+                if (pComponent == nullptr) BASE_THROWM("Journal contains a component that is missing in the scene.");
+
+                Reader >> *pComponent;
+
+                Dt::CComponentManager::GetInstance().MarkComponentAsDirty(*pComponent, Dt::IComponent::DirtyInfo);
+
+                m_Components.insert(ID);
+            }
+
+            // -----------------------------------------------------------------------------
+            // Entities
+            // -----------------------------------------------------------------------------
+            size_t NumberOfEntities = 0;
+
+            Reader >> NumberOfEntities;
+
+            for (size_t IndexOfEntity = 0; IndexOfEntity < NumberOfEntities; ++IndexOfEntity)
+            {
+                Dt::CEntity::BID ID = 0;
+
+                Reader >> ID;
+
+                auto pEntity = Dt::CEntityManager::GetInstance().GetEntityByID(ID);
+
+                if (pEntity == nullptr) BASE_THROWM("Journal contains an entity that is missing in the scene.");
+
+                // -----------------------------------------------------------------------------
+                // Name, bounds and flags (active, category, layer, ...) like in
+                // the scene file
+                // -----------------------------------------------------------------------------
+                pEntity->Read(Reader);
+
+                bool HasTransformationFacet = false;
+
+                Reader >> HasTransformationFacet;
+
+                if (HasTransformationFacet)
+                {
+                    if (pEntity->GetTransformationFacet() == nullptr) BASE_THROWM("Journal contains a transformation for an entity without one.");
+
+                    Reader >> *pEntity->GetTransformationFacet();
+                }
+
+                Dt::CEntityManager::GetInstance().MarkEntityAsDirty(*pEntity, Dt::CEntity::DirtyMove);
+
+                m_Entities.insert(ID);
+            }
+
+            ENGINE_CONSOLE_INFOV("Replayed %i changes from the journal of scene '%s'.", static_cast<int>(NumberOfComponents + NumberOfEntities), m_Filename.c_str());
+
+            m_HasJournal = true;
+
+            return true;
+        }
+        catch (...)
+        {
+            ENGINE_CONSOLE_ERRORV("Journal of scene '%s' could not be replayed completely.", m_Filename.c_str());
+
+            // -----------------------------------------------------------------------------
+            // Whatever has been replayed is written into the scene file with
+            // the next save.
+            // -----------------------------------------------------------------------------
+            m_HasUnsavedChanges    = true;
+            m_HasStructuralChanges = true;
+
+            return false;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CSceneJournal::WriteJournal(const std::string& _rPathToFile)
+    {
+        std::vector<Dt::IComponent*> Components;
+        std::vector<Dt::CEntity*>    Entities;
+
+        Components.reserve(m_Components.size());
+        Entities  .reserve(m_Entities.size());
+
+        for (Base::ID ID : m_Components)
+        {
+            auto pComponent = Dt::CComponentManager::GetInstance().GetComponent<Dt::IComponent>(ID);
+
+            if (pComponent != nullptr) Components.push_back(pComponent);
+        }
+
+        for (Dt::CEntity::BID ID : m_Entities)
+        {
+            auto pEntity = Dt::CEntityManager::GetInstance().GetEntityByID(ID);
+
+            if (pEntity != nullptr) Entities.push_back(pEntity);
+        }
+
+        // -----------------------------------------------------------------------------
+        // The journal always holds the latest state of everything that changed
+        // since the scene file was written, so it is replaced as a whole.
+        // -----------------------------------------------------------------------------
+        std::ostringstream oStream;
+
+        {
+            Base::CTextWriter Writer(oStream, 1);
+
+            Writer << m_SceneChecksum;
+
+            Writer << Components.size();
+
+            for (Dt::IComponent* pComponent : Components)
+            {
+                Writer << pComponent->GetID();
+
+                Writer << *pComponent;
+            }
+
+            Writer << Entities.size();
+
+            for (Dt::CEntity* pEntity : Entities)
+            {
+                Writer << pEntity->GetID();
+
+                pEntity->Write(Writer);
+
+                const bool HasTransformationFacet = pEntity->GetTransformationFacet() != nullptr;
+
+                Writer << HasTransformationFacet;
+
+                if (HasTransformationFacet) Writer << *pEntity->GetTransformationFacet();
+            }
+        }
+
+        return ReplaceFile(_rPathToFile + g_JournalExtension, oStream.str());
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CSceneJournal::Compact(const std::string& _rPathToFile)
+    {
+        // -----------------------------------------------------------------------------
+        // Check the folder up front to report a failure while the user is
+        // still looking.
+        // -----------------------------------------------------------------------------
+        {
+            std::ofstream oProbe;
+
+            oProbe.open(_rPathToFile + g_TemporaryExtension);
+
+            if (!oProbe.is_open()) return false;
+        }
+
+        // -----------------------------------------------------------------------------
+        // The scene has to be serialized here, writing the file does not.
+        // -----------------------------------------------------------------------------
+        std::ostringstream oStream;
+
+        {
+            Base::CTextWriter Writer(oStream, 1);
+
+            Dt::CComponentManager::GetInstance().Write(Writer);
+            Dt::Map::Write(Writer);
+            Dt::CEntityManager::GetInstance().Write(Writer);
+        }
+
+        std::string Content = oStream.str();
+
+        m_SceneChecksum = GetChecksum(Content);
+
+        m_CompactionThread = std::thread([PathToFile = _rPathToFile, Content = std::move(Content)]()
+        {
+            if (!ReplaceFile(PathToFile, Content))
+            {
+                ENGINE_CONSOLE_ERRORV("Scene file '%s' could not be written.", PathToFile.c_str());
+
+                return;
+            }
+
+            std::remove((PathToFile + g_JournalExtension).c_str());
+        });
+
+        return true;
+    }
+} // namespace Edit
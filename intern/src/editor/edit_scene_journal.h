@@ -0,0 +1,112 @@
+
+#pragma once
+
+#include "base/base_defines.h"
+#include "base/base_singleton.h"
+#include "base/base_typedef.h"
+#include "base/base_uncopyable.h"
+
+#include "engine/data/data_component_manager.h"
+#include "engine/data/data_entity.h"
+#include "engine/data/data_entity_manager.h"
+
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Edit
+{
+    // -----------------------------------------------------------------------------
+    // Tracks the entities and components that changed since the scene file
+    // was written completely. Property changes are saved as a small journal
+    // next to the scene file that is replayed after loading. New, deleted or
+    // reparented objects, long journals and unloading the scene compact
+    // everything into the scene file again, which is written by a background
+    // thread. Only the editor replays journals; the app reads the scene file.
+    // -----------------------------------------------------------------------------
+    class CSceneJournal : private Base::CUncopyable
+    {
+        BASE_SINGLETON_FUNC(CSceneJournal)
+
+    public:
+
+        enum ESaveResult
+        {
+            Unchanged,
+            Journal,
+            Compacted,
+            Failed
+        };
+
+    public:
+
+        CSceneJournal();
+       ~CSceneJournal();
+
+    public:
+
+        // -----------------------------------------------------------------------------
+        // Starts tracking after a scene has been created or read. A scene that
+        // was read from file gets its journal replayed first.
+        // -----------------------------------------------------------------------------
+        void Begin(const std::string& _rFilename, bool _IsReadFromFile);
+        void End();
+
+        // -----------------------------------------------------------------------------
+        // A scene that is unloaded is always written completely, so the scene
+        // file holds every saved change without its journal.
+        // -----------------------------------------------------------------------------
+        ESaveResult Save(const std::string& _rFilename, bool _IsUnloading);
+
+        // -----------------------------------------------------------------------------
+        // Compacts the journal of a scene that is unloaded without saving. Not
+        // possible with unsaved changes, whose state is not in the journal;
+        // the journal is kept then and compacted when the scene is read again.
+        // -----------------------------------------------------------------------------
+        ESaveResult Flush();
+
+        // -----------------------------------------------------------------------------
+        // Blocks until a pending compaction has been written.
+        // -----------------------------------------------------------------------------
+        void Wait();
+
+    private:
+
+        static const size_t s_MaxNumberOfJournalRecords = 1024;
+
+    private:
+
+        using CIDs       = std::unordered_set<Base::ID>;
+        using CParentIDs = std::unordered_map<Dt::CEntity::BID, Dt::CEntity::BID>;
+
+    private:
+
+        std::string m_Filename;                         //< Scene file the journal belongs to
+        bool        m_HasSceneFile;
+        bool        m_IsTracking;
+        bool        m_HasUnsavedChanges;
+        bool        m_HasStructuralChanges;
+        bool        m_HasJournal;                       //< The scene file is not complete without the journal
+        Base::BHash m_SceneChecksum;                    //< Of the scene file, stamped into the journal
+        CIDs        m_Entities;                         //< Changed since the scene file was written
+        CIDs        m_Components;
+        CParentIDs  m_ParentIDs;
+        std::thread m_CompactionThread;
+
+        Dt::CEntityManager::CEntityDelegate::HandleType       m_OnDirtyEntityDelegate;
+        Dt::CComponentManager::CComponentDelegate::HandleType m_OnDirtyComponentDelegate;
+
+    private:
+
+        void OnDirtyEntity(Dt::CEntity* _pEntity);
+        void OnDirtyComponent(Dt::IComponent* _pComponent);
+
+        Dt::CEntity::BID GetParentID(Dt::CEntity& _rEntity) const;
+
+        bool Replay(const std::string& _rPathToFile);
+
+        bool WriteJournal(const std::string& _rPathToFile);
+        bool Compact(const std::string& _rPathToFile);
+    };
+} // namespace Edit
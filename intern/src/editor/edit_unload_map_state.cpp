@@ -1,6 +1,8 @@
 
 #include "editor/edit_precompiled.h"
 
+#include "editor/edit_scene_graph_panel.h"
+#include "editor/edit_scene_journal.h"
 #include "editor/edit_unload_map_state.h"
 
 #include "engine/core/core_asset_manager.h"
@@ -60,47 +62,66 @@ namespace Edit
     
     void CUnloadMapState::InternOnEnter()
     {
+        const bool IsUnloading = m_NextState == CState::Exit || m_NextState == CState::LoadMap;
+
         // -----------------------------------------------------------------------------
         // Save
         // -----------------------------------------------------------------------------
         if (!m_PreventSaving)
         {
-            std::ofstream oStream;
-
-            oStream.open(Core::AssetManager::GetPathToAssets() + "/" + m_Filename);
+            CSceneJournal::ESaveResult Result = CSceneJournal::GetInstance().Save(m_Filename, IsUnloading);
 
-            if (oStream.is_open())
+            if (Result != CSceneJournal::Failed)
             {
-                Base::CTextWriter Writer(oStream, 1);
-
-                Dt::CComponentManager::GetInstance().Write(Writer);
-                Dt::Map::Write(Writer);
-                Dt::CEntityManager::GetInstance().Write(Writer);
-
-                oStream.close();
-
                 Core::CProgramParameters::GetInstance().Set("application:last_scene", m_Filename);
-
-                ENGINE_CONSOLE_INFOV("Scene '%s' has been saved succesfully.", m_Filename.c_str());
             }
-            else
+
+            switch (Result)
             {
+            case CSceneJournal::Unchanged:
+                ENGINE_CONSOLE_INFOV("Scene '%s' is unchanged and has not been written.", m_Filename.c_str());
+                break;
+            case CSceneJournal::Journal:
+                ENGINE_CONSOLE_INFOV("Changes of scene '%s' have been saved to its journal.", m_Filename.c_str());
+                break;
+            case CSceneJournal::Compacted:
+                ENGINE_CONSOLE_INFOV("Scene '%s' has been saved succesfully.", m_Filename.c_str());
+                break;
+            case CSceneJournal::Failed:
                 ENGINE_CONSOLE_ERROR("Scene cannot be saved because the file could not be created or is already in use. Maybe the folder is missing?");
+                break;
             }
         }
         else
         {
             ENGINE_CONSOLE_INFOV("Scene '%s' has not been saved.", m_Filename.c_str());
+
+            // -----------------------------------------------------------------------------
+            // Changes that were saved before may still be in the journal only
+            // -----------------------------------------------------------------------------
+            if (IsUnloading && CSceneJournal::GetInstance().Flush() == CSceneJournal::Failed)
+            {
+                ENGINE_CONSOLE_ERRORV("Journal of scene '%s' could not be written into the scene file.", m_Filename.c_str());
+            }
         }
 
         // -----------------------------------------------------------------------------
         // Unload?
         // -----------------------------------------------------------------------------
-        if (m_NextState == CState::Exit || m_NextState == CState::LoadMap)
+        if (IsUnloading)
         {
+            CSceneJournal::GetInstance().End();
+
             Dt::Map::FreeMap();
             Dt::CEntityManager::GetInstance().Clear();
             Dt::CComponentManager::GetInstance().Clear();
+
+            GUI::CSceneGraphPanel::GetInstance().Reset();
+        }
+
+        if (m_NextState == CState::Exit)
+        {
+            CSceneJournal::GetInstance().Wait();
         }
     }
     
@@ -3,14 +3,204 @@
 
 #include "engine/core/core_console.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <stdarg.h>
 
 #if PLATFORM_ANDROID
 #include "android/log.h"
 #endif // PLATFORM_ANDROID
 
+namespace
+{
+    // -----------------------------------------------------------------------------
+    // Call sites are function-local statics and may be destroyed before the
+    // console; they flush their records while the console is still alive.
+    // -----------------------------------------------------------------------------
+    std::atomic<bool> g_IsConsoleAlive(false);
+
+    // -----------------------------------------------------------------------------
+
+    Base::U64 GetTimeStamp()
+    {
+        return static_cast<Base::U64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // -----------------------------------------------------------------------------
+
+    size_t Align(size_t _NumberOfBytes)
+    {
+        return (_NumberOfBytes + 7) & ~static_cast<size_t>(7);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<typename T>
+    void Write(Base::U8*& _rpCursor, const T& _rValue)
+    {
+        memcpy(_rpCursor, &_rValue, sizeof(T));
+
+        _rpCursor += sizeof(T);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<typename T>
+    T Read(const Base::U8*& _rpCursor)
+    {
+        T Value;
+
+        memcpy(&Value, _rpCursor, sizeof(T));
+
+        _rpCursor += sizeof(T);
+
+        return Value;
+    }
+} // namespace
+
+namespace Core
+{
+    CConsole::CCallSite::CCallSite(EConsoleLevel _Level, const char* _pFormat, bool _IsRateLimited)
+        : m_Level                    (_Level)
+        , m_pFormat                  (_pFormat)
+        , m_Segments                 ()
+        , m_IsDeferred               (true)
+        , m_IsRateLimited            (_IsRateLimited)
+        , m_Window                   (0)
+        , m_NumberOfEntries          (0)
+        , m_NumberOfSuppressedEntries(0)
+    {
+        assert(_pFormat != nullptr);
+
+        // -----------------------------------------------------------------------------
+        // Split the format into pieces with one conversion each, so the flusher
+        // can format every stored argument on its own.
+        // -----------------------------------------------------------------------------
+        const char* pCursor = _pFormat;
+
+        std::string Literal;
+
+        while (*pCursor != '\0')
+        {
+            if (*pCursor != '%')
+            {
+                Literal += *pCursor++;
+
+                continue;
+            }
+
+            if (pCursor[1] == '%')
+            {
+                Literal += '%';
+
+                pCursor += 2;
+
+                continue;
+            }
+
+            const char* pConversion = pCursor++;
+
+            while (*pCursor != '\0' && strchr("-+ #0", *pCursor) != nullptr) ++pCursor;
+
+            if (*pCursor == '*') m_IsDeferred = false;
+
+            while (*pCursor == '*' || (*pCursor >= '0' && *pCursor <= '9')) ++pCursor;
+
+            if (*pCursor == '.')
+            {
+                ++pCursor;
+
+                if (*pCursor == '*') m_IsDeferred = false;
+
+                while (*pCursor == '*' || (*pCursor >= '0' && *pCursor <= '9')) ++pCursor;
+            }
+
+            char Length = '\0';
+
+            if      (pCursor[0] == 'h' && pCursor[1] == 'h') { Length = 'h'; pCursor += 2; }
+            else if (pCursor[0] == 'l' && pCursor[1] == 'l') { Length = 'q'; pCursor += 2; }
+            else if (*pCursor != '\0' && strchr("hlzjtL", *pCursor) != nullptr) { Length = *pCursor++; }
+
+            EArgument Argument = None;
+
+            switch (*pCursor)
+            {
+            case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+                switch (Length)
+                {
+                case 'l': Argument = Long; break;
+                case 'q': case 'j': Argument = LongLong; break;
+                case 'z': case 't': Argument = SizeT; break;
+                default:  Argument = Int; break;
+                }
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                Argument = Length == 'L' ? LongDouble : Double;
+                break;
+            case 's':
+                Argument = Length == 'l' ? None : String;
+                break;
+            case 'p':
+                Argument = Pointer;
+                break;
+            default:
+                break;
+            }
+
+            if (Argument == None)
+            {
+                m_IsDeferred = false;
+
+                break;
+            }
+
+            ++pCursor;
+
+            m_Segments.push_back({ Literal, std::string(pConversion, pCursor), Argument });
+
+            Literal.clear();
+        }
+
+        if (!Literal.empty()) m_Segments.push_back({ Literal, std::string(), None });
+
+        assert(m_Segments.size() * sizeof(long double) < s_MaxNumberOfFormatCharacters / 2);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CConsole::CCallSite::~CCallSite()
+    {
+        if (g_IsConsoleAlive) CConsole::GetInstance().Flush();
+    }
+} // namespace Core
+
+namespace Core
+{
+    CConsole::CStreamEntry::CStreamEntry(CCallSite& _rCallSite)
+        : m_rCallSite(_rCallSite)
+        , m_rStream  ([]() -> std::ostringstream& { static thread_local std::ostringstream s_Stream; return s_Stream; }())
+    {
+        m_rStream.str(std::string());
+        m_rStream.clear();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CConsole::CStreamEntry::~CStreamEntry()
+    {
+        const std::string& rText = m_rStream.str();
+
+        CConsole::GetInstance().Entry(&m_rCallSite, rText.c_str());
+    }
+} // namespace Core
+
 namespace Core
 {
+    const unsigned int CConsole::s_FlushIntervalInMs;
+
+    // -----------------------------------------------------------------------------
 
     CConsole& CConsole::GetInstance()
     {
@@ -22,34 +212,165 @@ namespace Core
     // -----------------------------------------------------------------------------
 
     CConsole::CConsole()
-        : m_OutputStream  ( )
-        , m_Clock         ( )
-        , m_VerbosityLevel(3)
+        : m_VerbosityLevel        (3)
+        , m_MaxEntriesPerSecond   (s_DefaultMaxEntriesPerSecond)
+        , m_NumberOfDroppedEntries(0)
+        , m_IsRunning             (true)
+#if PLATFORM_ANDROID
+        , m_pOutputFile           (nullptr)
+#else
+        , m_pOutputFile           (stdout)
+#endif // PLATFORM_ANDROID
+        , m_ThreadBuffers         ()
+        , m_ThreadBuffersMutex    ()
+        , m_FlushMutex            ()
+        , m_FlushCondition        ()
+        , m_FlushThread           ()
+        , m_Entries               ()
+        , m_Output                ()
+        , m_Delegates             ()
+        , m_PendingEntries        ()
+        , m_PendingEntriesMutex   ()
+        , m_HasDelegates          (false)
     {
+        m_FlushThread = std::thread(&CConsole::Run, this);
+
+        g_IsConsoleAlive = true;
     }
 
     // -----------------------------------------------------------------------------
 
-    CConsole::~CConsole() 
+    CConsole::~CConsole()
     {
-        Out(Info, m_OutputStream.str().c_str());
+        g_IsConsoleAlive = false;
+
+        m_IsRunning = false;
+
+        m_FlushCondition.notify_one();
+
+        if (m_FlushThread.joinable()) m_FlushThread.join();
+
+        Flush();
     }
-    
+
     // -----------------------------------------------------------------------------
-    
+
+    void CConsole::Entry(CCallSite* _pCallSite, ...)
+    {
+        assert(_pCallSite != nullptr);
+
+        unsigned int NumberOfSuppressedEntries = 0;
+
+        if (!IsAccepted(*_pCallSite, NumberOfSuppressedEntries)) return;
+
+        if (NumberOfSuppressedEntries > 0)
+        {
+            char Buffer[64];
+
+            int NumberOfCharacters = snprintf(Buffer, sizeof(Buffer), "(%u similar entries were suppressed)", NumberOfSuppressedEntries);
+
+            Push(_pCallSite, Text, reinterpret_cast<Base::U8*>(Buffer), static_cast<size_t>(NumberOfCharacters) + 1);
+        }
+
+        Base::U8 Payload[s_MaxNumberOfFormatCharacters];
+
+        va_list pArguments;
+
+        va_start(pArguments, _pCallSite);
+
+        if (!_pCallSite->m_IsDeferred)
+        {
+            // -----------------------------------------------------------------------------
+            // Conversions we cannot store are formatted right away
+            // -----------------------------------------------------------------------------
+            char* pBuffer = reinterpret_cast<char*>(Payload);
+
+#if PLATFORM_ANDROID
+            vsnprintf(pBuffer, s_MaxNumberOfFormatCharacters, _pCallSite->m_pFormat, pArguments);
+#else
+            vsnprintf_s(pBuffer, s_MaxNumberOfFormatCharacters, _TRUNCATE, _pCallSite->m_pFormat, pArguments);
+#endif
+
+            va_end(pArguments);
+
+            Push(_pCallSite, Text, Payload, strlen(pBuffer) + 1);
+
+            return;
+        }
+
+        // -----------------------------------------------------------------------------
+        // Store raw arguments; strings are copied since they may not outlive
+        // the call.
+        // -----------------------------------------------------------------------------
+        Base::U8* pCursor = Payload;
+        Base::U8* pEnd    = Payload + s_MaxNumberOfFormatCharacters;
+
+        for (const CCallSite::SSegment& rSegment : _pCallSite->m_Segments)
+        {
+            switch (rSegment.m_Argument)
+            {
+            case CCallSite::Int:        Write(pCursor, va_arg(pArguments, int)); break;
+            case CCallSite::Long:       Write(pCursor, va_arg(pArguments, long)); break;
+            case CCallSite::LongLong:   Write(pCursor, va_arg(pArguments, long long)); break;
+            case CCallSite::SizeT:      Write(pCursor, va_arg(pArguments, size_t)); break;
+            case CCallSite::Double:     Write(pCursor, va_arg(pArguments, double)); break;
+            case CCallSite::LongDouble: Write(pCursor, va_arg(pArguments, long double)); break;
+            case CCallSite::Pointer:    Write(pCursor, va_arg(pArguments, void*)); break;
+            case CCallSite::String:
+                {
+                    const char* pString = va_arg(pArguments, const char*);
+
+                    if (pString == nullptr) pString = "(null)";
+
+                    // -----------------------------------------------------------------------------
+                    // Keep room for the remaining fixed size arguments
+                    // -----------------------------------------------------------------------------
+                    size_t Reserved  = sizeof(Base::U32) + _pCallSite->m_Segments.size() * sizeof(long double);
+                    size_t Available = static_cast<size_t>(pEnd - pCursor);
+
+                    Base::U32 Length = static_cast<Base::U32>(std::min(strlen(pString), Available > Reserved ? Available - Reserved : 0));
+
+                    Write(pCursor, Length);
+
+                    memcpy(pCursor, pString, Length);
+
+                    pCursor += Length;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        va_end(pArguments);
+
+        Push(_pCallSite, Deferred, Payload, static_cast<size_t>(pCursor - Payload));
+    }
+
+    // -----------------------------------------------------------------------------
+
     void CConsole::Entry(EConsoleLevel _ConsoleLevel, const char* _pText)
     {
-        if (m_VerbosityLevel >= _ConsoleLevel)
+        if (IsEnabled(_ConsoleLevel))
         {
-            Out(_ConsoleLevel, _pText);
+            static CCallSite s_CallSites[] =
+            {
+                { Default, "%s", false },
+                { Error  , "%s", false },
+                { Warning, "%s", false },
+                { Info   , "%s", false },
+                { Debug  , "%s", false },
+            };
+
+            Entry(&s_CallSites[_ConsoleLevel], _pText);
         }
     }
-    
+
     // -----------------------------------------------------------------------------
-    
+
     void CConsole::Entry(EConsoleLevel _ConsoleLevel, char*, const char* _pFormat, ...)
     {
-        if (m_VerbosityLevel >= _ConsoleLevel)
+        if (IsEnabled(_ConsoleLevel))
         {
             va_list pArguments;
 
@@ -65,40 +386,33 @@ namespace Core
 
             va_end(pArguments);
 
-            Out(_ConsoleLevel, Buffer);
+            Entry(_ConsoleLevel, Buffer);
         }
     }
 
     // -----------------------------------------------------------------------------
 
-    std::ostringstream& CConsole::StreamEntry(EConsoleLevel _ConsoleLevel)
+    void CConsole::SetVerbosityLevel(int _Level)
     {
-        if (m_VerbosityLevel >= _ConsoleLevel)
-        {
-            // -----------------------------------------------------------------------------
-            // Get current time stamp
-            // -----------------------------------------------------------------------------
-            m_Clock.OnFrame();
+        assert(_Level >= -1 && _Level < 6);
 
-            double      CurrentTime = m_Clock.GetTime();
-            std::string LogString = GetLogLevelString(_ConsoleLevel);
+        m_VerbosityLevel = _Level;
+    }
 
-            // -----------------------------------------------------------------------------
-            // Init new Console entry with timestamp and Console level
-            // -----------------------------------------------------------------------------
-            m_OutputStream << "(" << CurrentTime << " sec.) " << LogString << ": ";
-        }
+    // -----------------------------------------------------------------------------
 
-        return m_OutputStream;
+    void CConsole::SetMaxEntriesPerSecond(unsigned int _MaxEntriesPerSecond)
+    {
+        m_MaxEntriesPerSecond = _MaxEntriesPerSecond;
     }
-    
+
     // -----------------------------------------------------------------------------
 
-    void CConsole::SetVerbosityLevel(int _Level)
+    void CConsole::SetOutputFile(FILE* _pFile)
     {
-        assert(_Level >= -1 && _Level < 6);
+        std::lock_guard<std::mutex> Lock(m_FlushMutex);
 
-        m_VerbosityLevel = _Level;
+        m_pOutputFile = _pFile;
     }
 
     // -----------------------------------------------------------------------------
@@ -106,6 +420,35 @@ namespace Core
     void CConsole::RegisterHandler(CEntryDelegate _NewDelegate)
     {
         m_Delegates.push_back(_NewDelegate);
+
+        m_HasDelegates = true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CConsole::Flush()
+    {
+        std::lock_guard<std::mutex> Lock(m_FlushMutex);
+
+        Drain();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CConsole::Update()
+    {
+        CEntries Entries;
+
+        {
+            std::lock_guard<std::mutex> Lock(m_PendingEntriesMutex);
+
+            std::swap(Entries, m_PendingEntries);
+        }
+
+        for (const SEntry& rEntry : Entries)
+        {
+            for (auto& rDelegate : m_Delegates) rDelegate(rEntry.m_Level, rEntry.m_Text);
+        }
     }
 
     // -----------------------------------------------------------------------------
@@ -126,24 +469,331 @@ namespace Core
 
     // -----------------------------------------------------------------------------
 
-    void CConsole::Out(EConsoleLevel _ConsoleLevel, const char* _pText) const
+    void CConsole::Run()
     {
-#ifdef PLATFORM_ANDROID
-        static const int s_LogLevel[] =
+        std::unique_lock<std::mutex> Lock(m_FlushMutex);
+
+        while (m_IsRunning)
         {
-            ANDROID_LOG_DEFAULT,
-            ANDROID_LOG_ERROR,
-            ANDROID_LOG_WARN,
-            ANDROID_LOG_INFO,
-            ANDROID_LOG_DEBUG,
-    };
+            m_FlushCondition.wait_for(Lock, std::chrono::milliseconds(s_FlushIntervalInMs));
 
-        __android_log_print(s_LogLevel[_ConsoleLevel], "Base.Console", "%s\n", _pText);
-#else
-        fprintf(stdout, "[%s] %s\n", GetLogLevelString(_ConsoleLevel).c_str(), _pText);
-        fflush(stdout);
+            Drain();
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // The buffer is shared with the console, so entries of a thread that
+    // already ended are still written.
+    // -----------------------------------------------------------------------------
+    CConsole::SThreadBuffer& CConsole::GetThreadBuffer()
+    {
+        struct SThreadBufferOwner
+        {
+            CThreadBufferPtr m_BufferPtr;
+
+            ~SThreadBufferOwner()
+            {
+                if (m_BufferPtr != nullptr) m_BufferPtr->m_IsDetached = true;
+            }
+        };
+
+        static thread_local SThreadBufferOwner s_Owner;
+
+        if (s_Owner.m_BufferPtr == nullptr)
+        {
+            CThreadBufferPtr BufferPtr = std::make_shared<SThreadBuffer>();
+
+            BufferPtr->m_Head       = 0;
+            BufferPtr->m_Tail       = 0;
+            BufferPtr->m_IsDetached = false;
+
+            BufferPtr->m_Bytes.resize(s_SizeOfThreadBuffer);
+
+            std::lock_guard<std::mutex> Lock(m_ThreadBuffersMutex);
+
+            m_ThreadBuffers.push_back(BufferPtr);
+
+            s_Owner.m_BufferPtr = BufferPtr;
+        }
+
+        return *s_Owner.m_BufferPtr;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CConsole::IsAccepted(CCallSite& _rCallSite, unsigned int& _rNumberOfSuppressedEntries)
+    {
+        unsigned int MaxEntriesPerSecond = m_MaxEntriesPerSecond.load(std::memory_order_relaxed);
+
+        if (!_rCallSite.m_IsRateLimited || MaxEntriesPerSecond == 0) return true;
+
+        // -----------------------------------------------------------------------------
+        // The first entry of a new second starts the window again and reports
+        // what was suppressed in the last one.
+        // -----------------------------------------------------------------------------
+        Base::U64 Window     = GetTimeStamp() / 1000000000ull;
+        Base::U64 LastWindow = _rCallSite.m_Window.load(std::memory_order_relaxed);
+
+        if (Window != LastWindow && _rCallSite.m_Window.compare_exchange_strong(LastWindow, Window))
+        {
+            _rCallSite.m_NumberOfEntries = 0;
+
+            _rNumberOfSuppressedEntries = _rCallSite.m_NumberOfSuppressedEntries.exchange(0);
+        }
+
+        if (_rCallSite.m_NumberOfEntries.fetch_add(1, std::memory_order_relaxed) >= MaxEntriesPerSecond)
+        {
+            _rCallSite.m_NumberOfSuppressedEntries.fetch_add(1, std::memory_order_relaxed);
+
+            return false;
+        }
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CConsole::Push(const CCallSite* _pCallSite, ERecord _Record, const Base::U8* _pPayload, size_t _NumberOfBytes)
+    {
+        SThreadBuffer& rBuffer = GetThreadBuffer();
+
+        const size_t Capacity = rBuffer.m_Bytes.size();
+
+        size_t Size = Align(sizeof(SRecordHeader) + _NumberOfBytes);
+
+        assert(Size <= Capacity / 2);
+
+        // -----------------------------------------------------------------------------
+        // Records never wrap; the rest of the buffer is skipped instead.
+        // Errors wait for the flusher, everything else is dropped if the
+        // buffer is full.
+        // -----------------------------------------------------------------------------
+        size_t Head   = rBuffer.m_Head.load(std::memory_order_relaxed);
+        size_t Offset = Head % Capacity;
+        size_t Rest   = Capacity - Offset;
+        size_t Needed = Rest < Size ? Rest + Size : Size;
+
+        while (Capacity - (Head - rBuffer.m_Tail.load(std::memory_order_acquire)) < Needed)
+        {
+            if (_pCallSite->m_Level != Error || !m_IsRunning)
+            {
+                m_NumberOfDroppedEntries.fetch_add(1, std::memory_order_relaxed);
+
+                m_FlushCondition.notify_one();
+
+                return;
+            }
+
+            m_FlushCondition.notify_one();
+
+            std::this_thread::yield();
+        }
+
+        if (Rest < Size)
+        {
+            if (Rest >= sizeof(SRecordHeader))
+            {
+                SRecordHeader Padding = { static_cast<Base::U32>(Rest), static_cast<Base::U16>(CConsole::Padding), 0, 0, nullptr };
+
+                memcpy(&rBuffer.m_Bytes[Offset], &Padding, sizeof(Padding));
+            }
+
+            Head  += Rest;
+            Offset = 0;
+        }
+
+        SRecordHeader Header = { static_cast<Base::U32>(Size), static_cast<Base::U16>(_Record), static_cast<Base::U16>(_pCallSite->m_Level), GetTimeStamp(), _pCallSite };
+
+        memcpy(&rBuffer.m_Bytes[Offset], &Header, sizeof(Header));
+
+        memcpy(&rBuffer.m_Bytes[Offset + sizeof(Header)], _pPayload, _NumberOfBytes);
+
+        rBuffer.m_Head.store(Head + Size, std::memory_order_release);
+
+        // -----------------------------------------------------------------------------
+        // Errors are written before returning, so the last lines in front of
+        // an assert or a crash do not stay in the buffer.
+        // -----------------------------------------------------------------------------
+        if (_pCallSite->m_Level == Error)
+        {
+            Flush();
+
+            return;
+        }
+
+        if (Capacity - (Head + Size - rBuffer.m_Tail.load(std::memory_order_relaxed)) < Capacity / 2) m_FlushCondition.notify_one();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CConsole::Drain()
+    {
+        m_Entries.clear();
+
+        {
+            std::lock_guard<std::mutex> Lock(m_ThreadBuffersMutex);
+
+            for (auto BufferIterator = m_ThreadBuffers.begin(); BufferIterator != m_ThreadBuffers.end(); )
+            {
+                SThreadBuffer& rBuffer = **BufferIterator;
+
+                const size_t Capacity = rBuffer.m_Bytes.size();
+
+                bool IsDetached = rBuffer.m_IsDetached.load(std::memory_order_acquire);
+
+                size_t Tail = rBuffer.m_Tail.load(std::memory_order_relaxed);
+                size_t Head = rBuffer.m_Head.load(std::memory_order_acquire);
+
+                while (Tail != Head)
+                {
+                    size_t Offset = Tail % Capacity;
+
+                    if (Capacity - Offset < sizeof(SRecordHeader))
+                    {
+                        Tail += Capacity - Offset;
+
+                        continue;
+                    }
+
+                    SRecordHeader Header;
+
+                    memcpy(&Header, &rBuffer.m_Bytes[Offset], sizeof(Header));
+
+                    if (Header.m_Record != Padding)
+                    {
+                        m_Entries.push_back({ Header.m_TimeStamp, static_cast<EConsoleLevel>(Header.m_Level), std::string() });
+
+                        Format(Header, &rBuffer.m_Bytes[Offset + sizeof(Header)], m_Entries.back().m_Text);
+                    }
+
+                    Tail += Header.m_Size;
+                }
+
+                rBuffer.m_Tail.store(Tail, std::memory_order_release);
+
+                if (IsDetached)
+                {
+                    BufferIterator = m_ThreadBuffers.erase(BufferIterator);
+                }
+                else
+                {
+                    ++BufferIterator;
+                }
+            }
+        }
+
+        unsigned int NumberOfDroppedEntries = m_NumberOfDroppedEntries.exchange(0);
+
+        if (NumberOfDroppedEntries > 0)
+        {
+            m_Entries.push_back({ GetTimeStamp(), Warning, std::to_string(NumberOfDroppedEntries) + " console entries were dropped" });
+        }
+
+        if (m_Entries.empty()) return;
+
+        std::stable_sort(m_Entries.begin(), m_Entries.end(), [](const SEntry& _rLeft, const SEntry& _rRight) { return _rLeft.m_TimeStamp < _rRight.m_TimeStamp; });
+
+        Out(m_Entries);
+
+        if (m_HasDelegates)
+        {
+            std::lock_guard<std::mutex> Lock(m_PendingEntriesMutex);
+
+            m_PendingEntries.insert(m_PendingEntries.end(), m_Entries.begin(), m_Entries.end());
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CConsole::Format(const SRecordHeader& _rHeader, const Base::U8* _pPayload, std::string& _rText) const
+    {
+        if (_rHeader.m_Record == Text)
+        {
+            _rText = reinterpret_cast<const char*>(_pPayload);
+
+            return;
+        }
+
+        char Buffer[s_MaxNumberOfFormatCharacters];
+
+        const Base::U8* pCursor = _pPayload;
+
+        for (const CCallSite::SSegment& rSegment : _rHeader.m_pCallSite->m_Segments)
+        {
+            _rText += rSegment.m_Literal;
+
+            const char* pConversion = rSegment.m_Conversion.c_str();
+
+            int NumberOfCharacters = 0;
+
+            switch (rSegment.m_Argument)
+            {
+            case CCallSite::Int:        NumberOfCharacters = snprintf(Buffer, sizeof(Buffer), pConversion, Read<int>(pCursor)); break;
+            case CCallSite::Long:       NumberOfCharacters = snprintf(Buffer, sizeof(Buffer), pConversion, Read<long>(pCursor)); break;
+            case CCallSite::LongLong:   NumberOfCharacters = snprintf(Buffer, sizeof(Buffer), pConversion, Read<long long>(pCursor)); break;
+            case CCallSite::SizeT:      NumberOfCharacters = snprintf(Buffer, sizeof(Buffer), pConversion, Read<size_t>(pCursor)); break;
+            case CCallSite::Double:     NumberOfCharacters = snprintf(Buffer, sizeof(Buffer), pConversion, Read<double>(pCursor)); break;
+            case CCallSite::LongDouble: NumberOfCharacters = snprintf(Buffer, sizeof(Buffer), pConversion, Read<long double>(pCursor)); break;
+            case CCallSite::Pointer:    NumberOfCharacters = snprintf(Buffer, sizeof(Buffer), pConversion, Read<void*>(pCursor)); break;
+            case CCallSite::String:
+                {
+                    Base::U32 Length = Read<Base::U32>(pCursor);
+
+                    std::string String(reinterpret_cast<const char*>(pCursor), Length);
+
+                    pCursor += Length;
+
+                    NumberOfCharacters = snprintf(Buffer, sizeof(Buffer), pConversion, String.c_str());
+                }
+                break;
+            default:
+                break;
+            }
+
+            if (NumberOfCharacters > 0) _rText.append(Buffer, std::min(static_cast<size_t>(NumberOfCharacters), sizeof(Buffer) - 1));
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CConsole::Out(const CEntries& _rEntries)
+    {
+        if (m_pOutputFile == nullptr)
+        {
+#if PLATFORM_ANDROID
+            static const int s_LogLevel[] =
+            {
+                ANDROID_LOG_DEFAULT,
+                ANDROID_LOG_ERROR,
+                ANDROID_LOG_WARN,
+                ANDROID_LOG_INFO,
+                ANDROID_LOG_DEBUG,
+            };
+
+            for (const SEntry& rEntry : _rEntries)
+            {
+                __android_log_print(s_LogLevel[rEntry.m_Level], "Base.Console", "%s\n", rEntry.m_Text.c_str());
+            }
 #endif // PLATFORM_ANDROID
 
-        for (auto& rDelegate : m_Delegates) rDelegate(_ConsoleLevel, _pText);
+            return;
+        }
+
+        // -----------------------------------------------------------------------------
+        // One write and flush per batch
+        // -----------------------------------------------------------------------------
+        m_Output.clear();
+
+        for (const SEntry& rEntry : _rEntries)
+        {
+            m_Output += "[";
+            m_Output += GetLogLevelString(rEntry.m_Level);
+            m_Output += "] ";
+            m_Output += rEntry.m_Text;
+            m_Output += "\n";
+        }
+
+        fwrite(m_Output.data(), 1, m_Output.size(), m_pOutputFile);
+        fflush(m_pOutputFile);
     }
-} // namespace Core
\ No newline at end of file
+} // namespace Core
@@ -3,37 +3,76 @@
 
 #include "engine/engine_config.h"
 
-#include "base/base_clock.h"
 #include "base/base_defines.h"
+#include "base/base_typedef.h"
 #include "base/base_uncopyable.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <string>
+#include <thread>
 #include <vector>
 
-#define ENGINE_CONSOLE_DEFAULT(_Message) ::Core::CConsole::GetInstance().Entry(::Core::CConsole::Default, _Message);
-#define ENGINE_CONSOLE_ERROR(  _Message) ::Core::CConsole::GetInstance().Entry(::Core::CConsole::Error  , _Message);
-#define ENGINE_CONSOLE_WARNING(_Message) ::Core::CConsole::GetInstance().Entry(::Core::CConsole::Warning, _Message);
-#define ENGINE_CONSOLE_INFO(   _Message) ::Core::CConsole::GetInstance().Entry(::Core::CConsole::Info   , _Message);
-#define ENGINE_CONSOLE_DEBUG(  _Message) ::Core::CConsole::GetInstance().Entry(::Core::CConsole::Debug  , _Message);
+// -----------------------------------------------------------------------------
+// Every log statement owns a static call site with the parsed format and its
+// rate limit. Arguments are only evaluated if the level passes the filter.
+// Formats of the V macros have to be string literals.
+// -----------------------------------------------------------------------------
+#define ENGINE_CONSOLE_ENTRYV(_Level, _Format, ...)                                                 \
+    do                                                                                              \
+    {                                                                                               \
+        if (::Core::CConsole::GetInstance().IsEnabled(_Level))                                      \
+        {                                                                                           \
+            static ::Core::CConsole::CCallSite s_CallSite(_Level, _Format);                         \
+            ::Core::CConsole::GetInstance().Entry(&s_CallSite, __VA_ARGS__);                        \
+        }                                                                                           \
+    } while (false)
 
-#define ENGINE_CONSOLE_DEFAULTV(_Format, ...) ::Core::CConsole::GetInstance().Entry(::Core::CConsole::Default, 0, _Format, __VA_ARGS__);
-#define ENGINE_CONSOLE_ERRORV(  _Format, ...) ::Core::CConsole::GetInstance().Entry(::Core::CConsole::Error  , 0, _Format, __VA_ARGS__);
-#define ENGINE_CONSOLE_WARNINGV(_Format, ...) ::Core::CConsole::GetInstance().Entry(::Core::CConsole::Warning, 0, _Format, __VA_ARGS__);
-#define ENGINE_CONSOLE_INFOV(   _Format, ...) ::Core::CConsole::GetInstance().Entry(::Core::CConsole::Info   , 0, _Format, __VA_ARGS__);
-#define ENGINE_CONSOLE_DEBUGV(  _Format, ...) ::Core::CConsole::GetInstance().Entry(::Core::CConsole::Debug  , 0, _Format, __VA_ARGS__);
+#define ENGINE_CONSOLE_STREAMENTRY(_Level, _StreamData)                                             \
+    do                                                                                              \
+    {                                                                                               \
+        if (::Core::CConsole::GetInstance().IsEnabled(_Level))                                      \
+        {                                                                                           \
+            static ::Core::CConsole::CCallSite s_CallSite(_Level, "%s");                            \
+            ::Core::CConsole::CStreamEntry(s_CallSite) << _StreamData;                              \
+        }                                                                                           \
+    } while (false)
 
-#define ENGINE_CONSOLE_STREAMDEFAULT(_StreamData) ::Core::CConsole::GetInstance().StreamEntry(::Core::CConsole::Default) << _StreamData << std::endl;
-#define ENGINE_CONSOLE_STREAMERROR(  _StreamData) ::Core::CConsole::GetInstance().StreamEntry(::Core::CConsole::Error  ) << _StreamData << std::endl;
-#define ENGINE_CONSOLE_STREAMWARNING(_StreamData) ::Core::CConsole::GetInstance().StreamEntry(::Core::CConsole::Warning) << _StreamData << std::endl;
-#define ENGINE_CONSOLE_STREAMINFO(   _StreamData) ::Core::CConsole::GetInstance().StreamEntry(::Core::CConsole::Info   ) << _StreamData << std::endl;
-#define ENGINE_CONSOLE_STREAMDEBUG(  _StreamData) ::Core::CConsole::GetInstance().StreamEntry(::Core::CConsole::Debug  ) << _StreamData << std::endl;
+#define ENGINE_CONSOLE_DEFAULT(_Message) ENGINE_CONSOLE_ENTRYV(::Core::CConsole::Default, "%s", static_cast<const char*>(_Message));
+#define ENGINE_CONSOLE_ERROR(  _Message) ENGINE_CONSOLE_ENTRYV(::Core::CConsole::Error  , "%s", static_cast<const char*>(_Message));
+#define ENGINE_CONSOLE_WARNING(_Message) ENGINE_CONSOLE_ENTRYV(::Core::CConsole::Warning, "%s", static_cast<const char*>(_Message));
+#define ENGINE_CONSOLE_INFO(   _Message) ENGINE_CONSOLE_ENTRYV(::Core::CConsole::Info   , "%s", static_cast<const char*>(_Message));
+#define ENGINE_CONSOLE_DEBUG(  _Message) ENGINE_CONSOLE_ENTRYV(::Core::CConsole::Debug  , "%s", static_cast<const char*>(_Message));
+
+#define ENGINE_CONSOLE_DEFAULTV(_Format, ...) ENGINE_CONSOLE_ENTRYV(::Core::CConsole::Default, _Format, __VA_ARGS__);
+#define ENGINE_CONSOLE_ERRORV(  _Format, ...) ENGINE_CONSOLE_ENTRYV(::Core::CConsole::Error  , _Format, __VA_ARGS__);
+#define ENGINE_CONSOLE_WARNINGV(_Format, ...) ENGINE_CONSOLE_ENTRYV(::Core::CConsole::Warning, _Format, __VA_ARGS__);
+#define ENGINE_CONSOLE_INFOV(   _Format, ...) ENGINE_CONSOLE_ENTRYV(::Core::CConsole::Info   , _Format, __VA_ARGS__);
+#define ENGINE_CONSOLE_DEBUGV(  _Format, ...) ENGINE_CONSOLE_ENTRYV(::Core::CConsole::Debug  , _Format, __VA_ARGS__);
+
+#define ENGINE_CONSOLE_STREAMDEFAULT(_StreamData) ENGINE_CONSOLE_STREAMENTRY(::Core::CConsole::Default, _StreamData);
+#define ENGINE_CONSOLE_STREAMERROR(  _StreamData) ENGINE_CONSOLE_STREAMENTRY(::Core::CConsole::Error  , _StreamData);
+#define ENGINE_CONSOLE_STREAMWARNING(_StreamData) ENGINE_CONSOLE_STREAMENTRY(::Core::CConsole::Warning, _StreamData);
+#define ENGINE_CONSOLE_STREAMINFO(   _StreamData) ENGINE_CONSOLE_STREAMENTRY(::Core::CConsole::Info   , _StreamData);
+#define ENGINE_CONSOLE_STREAMDEBUG(  _StreamData) ENGINE_CONSOLE_STREAMENTRY(::Core::CConsole::Debug  , _StreamData);
 
 namespace Core
 {
+    // -----------------------------------------------------------------------------
+    // Entries are written into a lock-free ring buffer of the calling thread
+    // as format id plus raw arguments. A background thread formats them and
+    // writes the output in batches; errors are written synchronously by the
+    // calling thread. Delegates are called by Update() on the thread that
+    // owns them.
+    // -----------------------------------------------------------------------------
     class ENGINE_API CConsole : public Base::CUncopyable
     {
-    
+
     public:
 
         enum EConsoleLevel
@@ -49,25 +88,156 @@ namespace Core
 
         typedef std::function<void(EConsoleLevel _Level, const std::string _Entry)> CEntryDelegate;
 
+    public:
+
+        class ENGINE_API CCallSite : public Base::CUncopyable
+        {
+        public:
+
+            CCallSite(EConsoleLevel _Level, const char* _pFormat, bool _IsRateLimited = true);
+           ~CCallSite();
+
+        private:
+
+            enum EArgument
+            {
+                None,
+                Int,
+                Long,
+                LongLong,
+                SizeT,
+                Double,
+                LongDouble,
+                Pointer,
+                String,
+            };
+
+            struct SSegment
+            {
+                std::string m_Literal;              //< Text in front of the conversion without escapes
+                std::string m_Conversion;
+                EArgument   m_Argument;
+            };
+
+            typedef std::vector<SSegment> CSegments;
+
+        private:
+
+            EConsoleLevel          m_Level;
+            const char*            m_pFormat;
+            CSegments              m_Segments;
+            bool                   m_IsDeferred;    //< False for conversions that cannot be stored (%n, *)
+            bool                   m_IsRateLimited;
+            std::atomic<Base::U64> m_Window;
+            std::atomic<unsigned>  m_NumberOfEntries;
+            std::atomic<unsigned>  m_NumberOfSuppressedEntries;
+
+        private:
+
+            friend class CConsole;
+        };
+
+        class ENGINE_API CStreamEntry : public Base::CUncopyable
+        {
+        public:
+
+            CStreamEntry(CCallSite& _rCallSite);
+           ~CStreamEntry();
+
+            template<typename T>
+            CStreamEntry& operator << (const T& _rValue)
+            {
+                m_rStream << _rValue;
+
+                return *this;
+            }
+
+        private:
+
+            CCallSite&          m_rCallSite;
+            std::ostringstream& m_rStream;
+        };
+
+    public:
+
+        static const unsigned int s_DefaultMaxEntriesPerSecond = 100;
+
     public:
 
         static CConsole& GetInstance();
 
     public:
 
+        bool IsEnabled(EConsoleLevel _ConsoleLevel) const
+        {
+            return m_VerbosityLevel.load(std::memory_order_relaxed) >= _ConsoleLevel;
+        }
+
+        void Entry(CCallSite* _pCallSite, ...);
+
         void Entry(EConsoleLevel _ConsoleLevel, const char* _pText);
         void Entry(EConsoleLevel _ConsoleLevel, char*, const char* _pFormat, ...);
-        std::ostringstream& StreamEntry(EConsoleLevel _ConsoleLevel);
 
         void SetVerbosityLevel(int _Level);
 
+        void SetMaxEntriesPerSecond(unsigned int _MaxEntriesPerSecond);
+
+        void SetOutputFile(FILE* _pFile);
+
         void RegisterHandler(CEntryDelegate _NewDelegate);
 
+        // -----------------------------------------------------------------------------
+        // Writes every pending entry before returning; Update() passes new
+        // entries to the delegates.
+        // -----------------------------------------------------------------------------
+        void Flush();
+        void Update();
+
         const std::string& GetLogLevelString(EConsoleLevel _ConsoleLevel) const;
-        
+
     private:
-        
+
         static const unsigned int s_MaxNumberOfFormatCharacters = 2048;
+        static const unsigned int s_SizeOfThreadBuffer          = 64 * 1024;
+        static const unsigned int s_FlushIntervalInMs           = 10;
+
+    private:
+
+        enum ERecord
+        {
+            Padding,
+            Deferred,
+            Text,
+        };
+
+        struct SRecordHeader
+        {
+            Base::U32        m_Size;
+            Base::U16        m_Record;
+            Base::U16        m_Level;
+            Base::U64        m_TimeStamp;
+            const CCallSite* m_pCallSite;
+        };
+
+        struct SThreadBuffer
+        {
+            std::atomic<size_t>   m_Head;           //< Written by the owning thread only
+            std::atomic<size_t>   m_Tail;           //< Written by the flusher only
+            std::atomic<bool>     m_IsDetached;
+            std::vector<Base::U8> m_Bytes;
+        };
+
+        struct SEntry
+        {
+            Base::U64     m_TimeStamp;
+            EConsoleLevel m_Level;
+            std::string   m_Text;
+        };
+
+        typedef std::shared_ptr<SThreadBuffer> CThreadBufferPtr;
+        typedef std::vector<CThreadBufferPtr> CThreadBuffers;
+        typedef std::vector<SEntry> CEntries;
+        typedef std::vector<CEntryDelegate> CDelegates;
 
     private:
 
@@ -76,17 +246,41 @@ namespace Core
 
     private:
 
-        std::ostringstream      m_OutputStream;
-        Base::CPerformanceClock m_Clock;
-        
-        int m_VerbosityLevel;
+        std::atomic<int>      m_VerbosityLevel;
+        std::atomic<unsigned> m_MaxEntriesPerSecond;
+        std::atomic<unsigned> m_NumberOfDroppedEntries;
+        std::atomic<bool>     m_IsRunning;
+        FILE*                 m_pOutputFile;        //< Null writes to the system log on Android
+
+        CThreadBuffers        m_ThreadBuffers;
+        std::mutex            m_ThreadBuffersMutex;
+
+        std::mutex            m_FlushMutex;
+        std::condition_variable m_FlushCondition;
+        std::thread           m_FlushThread;
 
-        std::vector<CEntryDelegate> m_Delegates;
+        CEntries              m_Entries;            //< Drained entries of one flush, sorted by time
+        std::string           m_Output;
+
+        CDelegates            m_Delegates;
+        CEntries              m_PendingEntries;     //< Waiting for the delegates
+        std::mutex            m_PendingEntriesMutex;
+        std::atomic<bool>     m_HasDelegates;
 
     private:
 
-        void Out(EConsoleLevel _ConsoleLevel, const char* _pText) const;
+        void Run();
+
+        SThreadBuffer& GetThreadBuffer();
+
+        bool IsAccepted(CCallSite& _rCallSite, unsigned int& _rNumberOfSuppressedEntries);
+
+        void Push(const CCallSite* _pCallSite, ERecord _Record, const Base::U8* _pPayload, size_t _NumberOfBytes);
+
+        void Drain();
+        void Format(const SRecordHeader& _rHeader, const Base::U8* _pPayload, std::string& _rText) const;
+
+        void Out(const CEntries& _rEntries);
     };
 
 } // namespace Core
-
@@ -0,0 +1,131 @@
+
+#include "engine/engine_precompiled.h"
+
+#include "base/base_singleton.h"
+#include "base/base_uncopyable.h"
+
+#include "engine/core/core_console.h"
+#include "engine/core/core_memory.h"
+
+namespace
+{
+    class CMemoryManager : private Base::CUncopyable
+    {
+        BASE_SINGLETON_FUNC(CMemoryManager)
+
+    public:
+
+        CMemoryManager();
+       ~CMemoryManager();
+
+    public:
+
+        void OnStart();
+        void OnExit();
+        void Update();
+
+        Base::CMemoryArena& GetFrameArena();
+
+    private:
+
+        static const Base::Size s_NumberOfBytesPerFrameBlock = 1024 * 1024;
+
+    private:
+
+        Base::CMemoryArena m_FrameArena;
+    };
+} // namespace
+
+namespace
+{
+    CMemoryManager::CMemoryManager()
+        : m_FrameArena(s_NumberOfBytesPerFrameBlock, Base::CMemory::Frame)
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CMemoryManager::~CMemoryManager()
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMemoryManager::OnStart()
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMemoryManager::OnExit()
+    {
+        for (int IndexOfTag = 0; IndexOfTag < Base::CMemory::NumberOfTags; ++IndexOfTag)
+        {
+            Base::CMemory::ETag Tag = static_cast<Base::CMemory::ETag>(IndexOfTag);
+
+            Base::CMemory::SStatistics Statistics = Base::CMemory::GetStatistics(Tag);
+
+            if (Statistics.m_NumberOfAllocations == 0) continue;
+
+            ENGINE_CONSOLE_INFOV("Memory %s: %llu allocations, peak of %llu bytes, %llu bytes still allocated", Base::CMemory::GetTagName(Tag),
+                static_cast<unsigned long long>(Statistics.m_NumberOfAllocations),
+                static_cast<unsigned long long>(Statistics.m_PeakNumberOfBytes),
+                static_cast<unsigned long long>(Statistics.m_NumberOfBytes));
+        }
+
+        m_FrameArena.Reset();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMemoryManager::Update()
+    {
+        m_FrameArena.Reset();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Base::CMemoryArena& CMemoryManager::GetFrameArena()
+    {
+        return m_FrameArena;
+    }
+} // namespace
+
+namespace Core
+{
+namespace Memory
+{
+    void OnStart()
+    {
+        CMemoryManager::GetInstance().OnStart();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void OnExit()
+    {
+        CMemoryManager::GetInstance().OnExit();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void Update()
+    {
+        CMemoryManager::GetInstance().Update();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Base::CMemoryArena& GetFrameArena()
+    {
+        return CMemoryManager::GetInstance().GetFrameArena();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Base::CMemory::SStatistics GetStatistics(Base::CMemory::ETag _Tag)
+    {
+        return Base::CMemory::GetStatistics(_Tag);
+    }
+} // namespace Memory
+} // namespace Core
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "engine/engine_config.h"
+
+#include "base/base_memory.h"
+#include "base/base_memory_arena.h"
+
+namespace Core
+{
+namespace Memory
+{
+    ENGINE_API void OnStart();
+    ENGINE_API void OnExit();
+
+    // -----------------------------------------------------------------------------
+    // Releases the memory of the last frame
+    // -----------------------------------------------------------------------------
+    ENGINE_API void Update();
+
+    // -----------------------------------------------------------------------------
+    // Memory that lives until the next update of the engine. Only the main
+    // thread may use the frame arena.
+    // -----------------------------------------------------------------------------
+    ENGINE_API Base::CMemoryArena& GetFrameArena();
+
+    // -----------------------------------------------------------------------------
+    // Tagged allocations of the engine module
+    // -----------------------------------------------------------------------------
+    ENGINE_API Base::CMemory::SStatistics GetStatistics(Base::CMemory::ETag _Tag);
+} // namespace Memory
+} // namespace Core
@@ -220,6 +220,22 @@ namespace Dt
     // -----------------------------------------------------------------------------
 
     void CEntityManager::MarkEntityAsDirty(CEntity& _rEntity, unsigned int _DirtyFlags)
+    {
+        // -----------------------------------------------------------------------------
+        // World matrices of the whole subtree are computed in one batch, so
+        // every handler already sees the new matrices of parents and children.
+        // -----------------------------------------------------------------------------
+        if (_rEntity.GetHierarchyFacet() != nullptr)
+        {
+            UpdateWorldMatrices(_rEntity);
+        }
+
+        MarkSubtreeAsDirty(_rEntity, _DirtyFlags);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CEntityManager::MarkSubtreeAsDirty(CEntity& _rEntity, unsigned int _DirtyFlags)
     {
         // -----------------------------------------------------------------------------
         // Set current entity dirty flag
@@ -248,7 +264,7 @@ namespace Dt
 
             if (pChildHierarchyFacet != nullptr)
             {
-                MarkEntityAsDirty(*pChildEntity, _DirtyFlags);
+                MarkSubtreeAsDirty(*pChildEntity, _DirtyFlags);
 
                 pChildEntity = pChildHierarchyFacet->GetSibling();
             }
@@ -412,23 +428,8 @@ namespace Dt
 
         const Base::U64 TimeStamp = Core::Time::GetNumberOfFrame();
 
-        // -----------------------------------------------------------------------------
-        // Update world matrix
-        // -----------------------------------------------------------------------------
         pHierarchicalFacet = _rEntity.GetHierarchyFacet();
 
-        if (pHierarchicalFacet != nullptr)
-        {
-            if (pHierarchicalFacet->GetTimeStamp() >= TimeStamp)
-            {
-                UpdateWorldMatrix(_rEntity, true);
-            }
-        }
-        else
-        {
-            UpdateWorldMatrix(_rEntity, false);
-        }
-
         // -----------------------------------------------------------------------------
         // Update entity in map
         // -----------------------------------------------------------------------------        
@@ -458,13 +459,12 @@ namespace Dt
 
     // -----------------------------------------------------------------------------
 
-    template<typename THasHierarchy>
-    void CEntityManager::UpdateWorldMatrix(CEntity& _rEntity, THasHierarchy _HasHierarchy)
+    void CEntityManager::UpdateWorldMatrices(CEntity& _rEntity)
     {
         CHierarchyFacet*      pHierarchyFacet;
         CTransformationFacet* pTransformationFacet;
         CEntity*              pParentEntity;
-        CTransformationFacet* pParentTransformationFacet;
+        CEntity*              pChildEntity;
 
         // -----------------------------------------------------------------------------
         // Check if entity has a transformation facet.
@@ -477,63 +477,74 @@ namespace Dt
         }
 
         // -----------------------------------------------------------------------------
-        // Calculate the world matrix of the entity in SRT order.
+        // The parent is not part of the dirty subtree, so its world matrix is
+        // already up to date.
         // -----------------------------------------------------------------------------
-        glm::mat4 WorldMatrix;
-
-        WorldMatrix = glm::scale(pTransformationFacet->GetScale());
+        glm::mat4 RootMatrix(1.0f);
 
-        glm::mat4 RotationMatrix;
+        pParentEntity = _rEntity.GetHierarchyFacet()->GetParent();
 
-        RotationMatrix = glm::toMat4(pTransformationFacet->GetRotation());
-
-        WorldMatrix = RotationMatrix * WorldMatrix;
+        if (pParentEntity != nullptr && pParentEntity->GetTransformationFacet() != nullptr)
+        {
+            RootMatrix = pParentEntity->GetTransformationFacet()->GetWorldMatrix();
+        }
 
         // -----------------------------------------------------------------------------
-        // Check for an animation hierarchy.
+        // Collect the subtree breadth first, so every depth level is one
+        // contiguous range behind the level of its parents.
         // -----------------------------------------------------------------------------
-        if (_HasHierarchy)
-        {
-            pHierarchyFacet = _rEntity.GetHierarchyFacet();
+        m_TransformationBatch.Clear();
 
-            assert(pHierarchyFacet != nullptr);
+        m_BatchEntities.clear();
 
-            pParentEntity = pHierarchyFacet->GetParent();
+        m_TransformationBatch.BeginLevel();
 
-            // -----------------------------------------------------------------------------
-            // In case of an hierarchy we use the position relative to the parent.
-            // -----------------------------------------------------------------------------
-            WorldMatrix[3] = glm::vec4(pTransformationFacet->GetPosition(), 1.0f);
+        m_TransformationBatch.AddTransformation(pTransformationFacet->GetPosition(), pTransformationFacet->GetRotation(), pTransformationFacet->GetScale(), CTransformationBatch::s_NoParent);
+
+        m_BatchEntities.push_back(&_rEntity);
 
-            if (pParentEntity != nullptr)
+        for (int Begin = 0, End = 1; Begin < End; Begin = End, End = static_cast<int>(m_BatchEntities.size()))
+        {
+            const int NumberOfLevels = m_TransformationBatch.GetNumberOfLevels();
+
+            for (int IndexOfParent = Begin; IndexOfParent < End; ++IndexOfParent)
             {
-                // -----------------------------------------------------------------------------
-                // Ensure that the parent world matrix is calculated before the child.
-                // -----------------------------------------------------------------------------
-                UpdateEntity(*pParentEntity);
+                pHierarchyFacet = m_BatchEntities[IndexOfParent]->GetHierarchyFacet();
+
+                pChildEntity = pHierarchyFacet->GetFirstChild();
+
+                for (; pChildEntity != nullptr && pChildEntity->GetHierarchyFacet() != nullptr; pChildEntity = pChildEntity->GetHierarchyFacet()->GetSibling())
+                {
+                    pTransformationFacet = pChildEntity->GetTransformationFacet();
+
+                    if (pTransformationFacet == nullptr) continue;
 
-                pParentTransformationFacet = pParentEntity->GetTransformationFacet();
+                    if (m_TransformationBatch.GetNumberOfLevels() == NumberOfLevels)
+                    {
+                        m_TransformationBatch.BeginLevel();
+                    }
+
+                    m_TransformationBatch.AddTransformation(pTransformationFacet->GetPosition(), pTransformationFacet->GetRotation(), pTransformationFacet->GetScale(), IndexOfParent);
 
-                WorldMatrix = pParentTransformationFacet->GetWorldMatrix() * WorldMatrix;
+                    m_BatchEntities.push_back(pChildEntity);
+                }
             }
         }
-        else
-        {
-            // -----------------------------------------------------------------------------
-            // If the entity does not have a parent then use the absolute world position.
-            // -----------------------------------------------------------------------------
-            WorldMatrix[3] = glm::vec4(_rEntity.GetWorldPosition(), 1.0f);
-        }
 
-        pTransformationFacet->SetWorldMatrix(WorldMatrix);
+        m_TransformationBatch.Update(RootMatrix);
 
         // -----------------------------------------------------------------------------
-        // Extract the world space position of the entity from the world matrix.
+        // Write back world matrices and extract the world space positions.
         // -----------------------------------------------------------------------------
-        glm::vec3 WorldPosition;
+        for (size_t IndexOfEntity = 0; IndexOfEntity < m_BatchEntities.size(); ++IndexOfEntity)
+        {
+            CEntity& rEntity = *m_BatchEntities[IndexOfEntity];
 
-        WorldPosition = WorldMatrix[3];
+            glm::mat4 WorldMatrix = m_TransformationBatch.GetWorldMatrix(static_cast<int>(IndexOfEntity));
 
-        _rEntity.SetWorldPosition(WorldPosition);
+            rEntity.GetTransformationFacet()->SetWorldMatrix(WorldMatrix);
+
+            rEntity.SetWorldPosition(glm::vec3(WorldMatrix[3]));
+        }
     }
 } // namespace Dt
\ No newline at end of file
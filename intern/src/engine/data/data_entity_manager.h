@@ -16,6 +16,7 @@
 #include "engine/data/data_map.h"
 #include "engine/data/data_material_component.h"
 #include "engine/data/data_mesh_component.h"
+#include "engine/data/data_transformation_batch.h"
 #include "engine/data/data_transformation_facet.h"
 
 #include <functional>
@@ -125,9 +126,13 @@ namespace Dt
 
         CEntityDelegate m_EntityDelegate;
 
+        CTransformationBatch  m_TransformationBatch;
+        std::vector<CEntity*> m_BatchEntities;
+
+        void MarkSubtreeAsDirty(CEntity& _rEntity, unsigned int _DirtyFlags);
+
         void UpdateEntity(CEntity& _rEntity);
 
-        template<typename THasHierarchy>
-        void UpdateWorldMatrix(CEntity& _rEntity, THasHierarchy _HasHierarchy);
+        void UpdateWorldMatrices(CEntity& _rEntity);
     };
 } // namespace Dt
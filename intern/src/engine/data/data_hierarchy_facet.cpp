@@ -95,7 +95,7 @@ namespace Dt
 
     // -----------------------------------------------------------------------------
 
-    Base::U64 CHierarchyFacet::GetTimeStamp()
+    Base::U64 CHierarchyFacet::GetTimeStamp() const
     {
         return m_TimeStamp;
     }
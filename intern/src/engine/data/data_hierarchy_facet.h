@@ -29,7 +29,7 @@ namespace Dt
         const CEntity* GetSibling() const;
 
         void SetTimeStamp(Base::U64 _TimeStamp);
-        Base::U64 GetTimeStamp();
+        Base::U64 GetTimeStamp() const;
 
     public:
 
@@ -169,7 +169,7 @@ namespace
             // -----------------------------------------------------------------------------
             // Create the region array.
             // -----------------------------------------------------------------------------
-            m_pRegions = static_cast<CRegion*>(Base::CMemory::Allocate(m_NumberOfRegions * sizeof(*m_pRegions)));
+            m_pRegions = static_cast<CRegion*>(Base::CMemory::Allocate(m_NumberOfRegions * sizeof(*m_pRegions), Base::CMemory::Map));
 
             // -----------------------------------------------------------------------------
             // Setup the regions.
@@ -270,7 +270,7 @@ namespace
                 Base::CMemory::DestructObject(&rRegion);
             }
 
-            Base::CMemory::Free(m_pRegions);
+            Base::CMemory::Free(m_pRegions, Base::CMemory::Map);
 
             m_NumberOfRegionsX = 0;
             m_NumberOfRegionsY = 0;
@@ -0,0 +1,301 @@
+
+#include "engine/engine_precompiled.h"
+
+#include "base/base_simd.h"
+#include "base/base_thread_pool.h"
+
+#include "engine/data/data_transformation_batch.h"
+
+#include <cassert>
+
+namespace
+{
+    // -----------------------------------------------------------------------------
+    // Same result as glm::toMat4(Rotation) * glm::scale(Scale) for a unit
+    // quaternion, written out per element so four transformations can be
+    // computed side by side.
+    // -----------------------------------------------------------------------------
+    template<typename TValue, typename TOperations>
+    void ComputeRotationScale(TValue _X, TValue _Y, TValue _Z, TValue _W, TValue _ScaleX, TValue _ScaleY, TValue _ScaleZ, TValue* _pMatrix)
+    {
+        const TValue One = TOperations::Set(1.0f);
+        const TValue Two = TOperations::Set(2.0f);
+
+        const TValue X2 = TOperations::Mul(_X, Two);
+        const TValue Y2 = TOperations::Mul(_Y, Two);
+        const TValue Z2 = TOperations::Mul(_Z, Two);
+
+        const TValue XX = TOperations::Mul(_X, X2);
+        const TValue YY = TOperations::Mul(_Y, Y2);
+        const TValue ZZ = TOperations::Mul(_Z, Z2);
+        const TValue XY = TOperations::Mul(_X, Y2);
+        const TValue XZ = TOperations::Mul(_X, Z2);
+        const TValue YZ = TOperations::Mul(_Y, Z2);
+        const TValue WX = TOperations::Mul(_W, X2);
+        const TValue WY = TOperations::Mul(_W, Y2);
+        const TValue WZ = TOperations::Mul(_W, Z2);
+
+        _pMatrix[0] = TOperations::Mul(TOperations::Sub(One, TOperations::Add(YY, ZZ)), _ScaleX);
+        _pMatrix[1] = TOperations::Mul(TOperations::Add(XY, WZ), _ScaleX);
+        _pMatrix[2] = TOperations::Mul(TOperations::Sub(XZ, WY), _ScaleX);
+
+        _pMatrix[3] = TOperations::Mul(TOperations::Sub(XY, WZ), _ScaleY);
+        _pMatrix[4] = TOperations::Mul(TOperations::Sub(One, TOperations::Add(XX, ZZ)), _ScaleY);
+        _pMatrix[5] = TOperations::Mul(TOperations::Add(YZ, WX), _ScaleY);
+
+        _pMatrix[6] = TOperations::Mul(TOperations::Add(XZ, WY), _ScaleZ);
+        _pMatrix[7] = TOperations::Mul(TOperations::Sub(YZ, WX), _ScaleZ);
+        _pMatrix[8] = TOperations::Mul(TOperations::Sub(One, TOperations::Add(XX, YY)), _ScaleZ);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    struct SSIMDOperations
+    {
+        static Base::SIMD::Float4 Set(float _Value) { return Base::SIMD::Set(_Value); }
+
+        static Base::SIMD::Float4 Add(Base::SIMD::Float4 _Left, Base::SIMD::Float4 _Right) { return Base::SIMD::Add(_Left, _Right); }
+        static Base::SIMD::Float4 Sub(Base::SIMD::Float4 _Left, Base::SIMD::Float4 _Right) { return Base::SIMD::Sub(_Left, _Right); }
+        static Base::SIMD::Float4 Mul(Base::SIMD::Float4 _Left, Base::SIMD::Float4 _Right) { return Base::SIMD::Mul(_Left, _Right); }
+    };
+
+    // -----------------------------------------------------------------------------
+
+    struct SScalarOperations
+    {
+        static float Set(float _Value) { return _Value; }
+
+        static float Add(float _Left, float _Right) { return _Left + _Right; }
+        static float Sub(float _Left, float _Right) { return _Left - _Right; }
+        static float Mul(float _Left, float _Right) { return _Left * _Right; }
+    };
+
+    // -----------------------------------------------------------------------------
+    // Parent * Local for an affine local matrix (last row is 0, 0, 0, 1)
+    // -----------------------------------------------------------------------------
+    void MultiplyAffine(const glm::mat4& _rParent, glm::mat4& _rLocal)
+    {
+        const Base::SIMD::Float4 Parent0 = Base::SIMD::Load(&_rParent[0][0]);
+        const Base::SIMD::Float4 Parent1 = Base::SIMD::Load(&_rParent[1][0]);
+        const Base::SIMD::Float4 Parent2 = Base::SIMD::Load(&_rParent[2][0]);
+        const Base::SIMD::Float4 Parent3 = Base::SIMD::Load(&_rParent[3][0]);
+
+        for (int IndexOfColumn = 0; IndexOfColumn < 4; ++IndexOfColumn)
+        {
+            const glm::vec4& rColumn = _rLocal[IndexOfColumn];
+
+            Base::SIMD::Float4 Result = IndexOfColumn == 3 ? Parent3 : Base::SIMD::Zero();
+
+            Result = Base::SIMD::MulAdd(Parent0, Base::SIMD::Set(rColumn[0]), Result);
+            Result = Base::SIMD::MulAdd(Parent1, Base::SIMD::Set(rColumn[1]), Result);
+            Result = Base::SIMD::MulAdd(Parent2, Base::SIMD::Set(rColumn[2]), Result);
+
+            Base::SIMD::Store(&_rLocal[IndexOfColumn][0], Result);
+        }
+    }
+} // namespace
+
+namespace Dt
+{
+    CTransformationBatch::CTransformationBatch()
+        : m_NumberOfTransformations(0)
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CTransformationBatch::~CTransformationBatch()
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CTransformationBatch::Clear()
+    {
+        m_PositionX.clear();
+        m_PositionY.clear();
+        m_PositionZ.clear();
+        m_RotationX.clear();
+        m_RotationY.clear();
+        m_RotationZ.clear();
+        m_RotationW.clear();
+        m_ScaleX   .clear();
+        m_ScaleY   .clear();
+        m_ScaleZ   .clear();
+        m_Parents  .clear();
+
+        m_LevelBegins.clear();
+
+        m_NumberOfTransformations = 0;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CTransformationBatch::BeginLevel()
+    {
+        m_LevelBegins.push_back(m_NumberOfTransformations);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CTransformationBatch::AddTransformation(const glm::vec3& _rPosition, const glm::quat& _rRotation, const glm::vec3& _rScale, int _Parent)
+    {
+        assert(!m_LevelBegins.empty());
+        assert(_Parent < m_LevelBegins.back());
+
+        m_PositionX.push_back(_rPosition.x);
+        m_PositionY.push_back(_rPosition.y);
+        m_PositionZ.push_back(_rPosition.z);
+        m_RotationX.push_back(_rRotation.x);
+        m_RotationY.push_back(_rRotation.y);
+        m_RotationZ.push_back(_rRotation.z);
+        m_RotationW.push_back(_rRotation.w);
+        m_ScaleX   .push_back(_rScale.x);
+        m_ScaleY   .push_back(_rScale.y);
+        m_ScaleZ   .push_back(_rScale.z);
+        m_Parents  .push_back(_Parent);
+
+        return m_NumberOfTransformations++;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CTransformationBatch::Update(const glm::mat4& _rRootMatrix)
+    {
+        m_WorldMatrices.resize(m_NumberOfTransformations);
+
+        // -----------------------------------------------------------------------------
+        // Local matrices do not depend on each other
+        // -----------------------------------------------------------------------------
+        if (m_NumberOfTransformations < s_MinTransformationsPerTask)
+        {
+            BuildLocalMatrices(0, m_NumberOfTransformations);
+        }
+        else
+        {
+            Base::CThreadPool::GetInstance().ParallelFor(m_NumberOfTransformations, s_MinTransformationsPerTask, [&](int _Begin, int _End)
+            {
+                BuildLocalMatrices(_Begin, _End);
+            });
+        }
+
+        // -----------------------------------------------------------------------------
+        // Every level only reads the finished levels above it
+        // -----------------------------------------------------------------------------
+        for (size_t IndexOfLevel = 0; IndexOfLevel < m_LevelBegins.size(); ++IndexOfLevel)
+        {
+            const int Begin = m_LevelBegins[IndexOfLevel];
+            const int End   = IndexOfLevel + 1 < m_LevelBegins.size() ? m_LevelBegins[IndexOfLevel + 1] : m_NumberOfTransformations;
+
+            if (End - Begin < s_MinTransformationsPerTask)
+            {
+                MultiplyParentMatrices(Begin, End, _rRootMatrix);
+            }
+            else
+            {
+                Base::CThreadPool::GetInstance().ParallelFor(End - Begin, s_MinTransformationsPerTask, [&](int _Begin, int _End)
+                {
+                    MultiplyParentMatrices(Begin + _Begin, Begin + _End, _rRootMatrix);
+                });
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CTransformationBatch::GetNumberOfTransformations() const
+    {
+        return m_NumberOfTransformations;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CTransformationBatch::GetNumberOfLevels() const
+    {
+        return static_cast<int>(m_LevelBegins.size());
+    }
+
+    // -----------------------------------------------------------------------------
+
+    const glm::mat4& CTransformationBatch::GetWorldMatrix(int _Index) const
+    {
+        assert(_Index >= 0 && _Index < m_NumberOfTransformations);
+
+        return m_WorldMatrices[_Index];
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CTransformationBatch::BuildLocalMatrices(int _Begin, int _End)
+    {
+        int IndexOfTransformation = _Begin;
+
+        // -----------------------------------------------------------------------------
+        // Four transformations per step; the rotation and scale part is
+        // transposed back into the matrices afterwards.
+        // -----------------------------------------------------------------------------
+        for (; IndexOfTransformation + 4 <= _End; IndexOfTransformation += 4)
+        {
+            Base::SIMD::Float4 Elements[9];
+
+            ComputeRotationScale<Base::SIMD::Float4, SSIMDOperations>(
+                Base::SIMD::Load(&m_RotationX[IndexOfTransformation]),
+                Base::SIMD::Load(&m_RotationY[IndexOfTransformation]),
+                Base::SIMD::Load(&m_RotationZ[IndexOfTransformation]),
+                Base::SIMD::Load(&m_RotationW[IndexOfTransformation]),
+                Base::SIMD::Load(&m_ScaleX   [IndexOfTransformation]),
+                Base::SIMD::Load(&m_ScaleY   [IndexOfTransformation]),
+                Base::SIMD::Load(&m_ScaleZ   [IndexOfTransformation]),
+                Elements);
+
+            float Values[9][4];
+
+            for (int IndexOfElement = 0; IndexOfElement < 9; ++IndexOfElement)
+            {
+                Base::SIMD::Store(Values[IndexOfElement], Elements[IndexOfElement]);
+            }
+
+            for (int IndexOfLane = 0; IndexOfLane < 4; ++IndexOfLane)
+            {
+                const int Index = IndexOfTransformation + IndexOfLane;
+
+                glm::mat4& rMatrix = m_WorldMatrices[Index];
+
+                rMatrix[0] = glm::vec4(Values[0][IndexOfLane], Values[1][IndexOfLane], Values[2][IndexOfLane], 0.0f);
+                rMatrix[1] = glm::vec4(Values[3][IndexOfLane], Values[4][IndexOfLane], Values[5][IndexOfLane], 0.0f);
+                rMatrix[2] = glm::vec4(Values[6][IndexOfLane], Values[7][IndexOfLane], Values[8][IndexOfLane], 0.0f);
+                rMatrix[3] = glm::vec4(m_PositionX[Index], m_PositionY[Index], m_PositionZ[Index], 1.0f);
+            }
+        }
+
+        for (; IndexOfTransformation < _End; ++IndexOfTransformation)
+        {
+            const int Index = IndexOfTransformation;
+
+            float Values[9];
+
+            ComputeRotationScale<float, SScalarOperations>(m_RotationX[Index], m_RotationY[Index], m_RotationZ[Index], m_RotationW[Index], m_ScaleX[Index], m_ScaleY[Index], m_ScaleZ[Index], Values);
+
+            glm::mat4& rMatrix = m_WorldMatrices[Index];
+
+            rMatrix[0] = glm::vec4(Values[0], Values[1], Values[2], 0.0f);
+            rMatrix[1] = glm::vec4(Values[3], Values[4], Values[5], 0.0f);
+            rMatrix[2] = glm::vec4(Values[6], Values[7], Values[8], 0.0f);
+            rMatrix[3] = glm::vec4(m_PositionX[Index], m_PositionY[Index], m_PositionZ[Index], 1.0f);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CTransformationBatch::MultiplyParentMatrices(int _Begin, int _End, const glm::mat4& _rRootMatrix)
+    {
+        for (int IndexOfTransformation = _Begin; IndexOfTransformation < _End; ++IndexOfTransformation)
+        {
+            const int Parent = m_Parents[IndexOfTransformation];
+
+            const glm::mat4& rParentMatrix = Parent == s_NoParent ? _rRootMatrix : m_WorldMatrices[Parent];
+
+            MultiplyAffine(rParentMatrix, m_WorldMatrices[IndexOfTransformation]);
+        }
+    }
+} // namespace Dt
@@ -0,0 +1,83 @@
+
+#pragma once
+
+#include "engine/engine_config.h"
+
+#include "base/base_include_glm.h"
+
+#include <vector>
+
+namespace Dt
+{
+    // -----------------------------------------------------------------------------
+    // Computes the world matrices of a hierarchy of local transformations.
+    // Scale, rotation and position are kept as structure of arrays and added
+    // level by level (parents before their children), so every level can be
+    // built with SIMD kernels four transformations at a time and multiplied
+    // with the already finished level above it in parallel.
+    // -----------------------------------------------------------------------------
+    class ENGINE_API CTransformationBatch
+    {
+    public:
+
+        static const int s_NoParent = -1;
+
+        static const int s_MinTransformationsPerTask = 256;
+
+    public:
+
+        void Clear();
+
+        // -----------------------------------------------------------------------------
+        // Starts a new depth level; parents of the following transformations
+        // have to be part of an earlier level.
+        // -----------------------------------------------------------------------------
+        void BeginLevel();
+
+        int AddTransformation(const glm::vec3& _rPosition, const glm::quat& _rRotation, const glm::vec3& _rScale, int _Parent);
+
+        // -----------------------------------------------------------------------------
+        // Transformations without a parent inside of the batch are relative to
+        // the given root matrix.
+        // -----------------------------------------------------------------------------
+        void Update(const glm::mat4& _rRootMatrix);
+
+        int GetNumberOfTransformations() const;
+        int GetNumberOfLevels() const;
+
+        const glm::mat4& GetWorldMatrix(int _Index) const;
+
+    public:
+
+        CTransformationBatch();
+        ~CTransformationBatch();
+
+    private:
+
+        using CFloats   = std::vector<float>;
+        using CIndices  = std::vector<int>;
+        using CMatrices = std::vector<glm::mat4>;
+
+    private:
+
+        CFloats   m_PositionX;
+        CFloats   m_PositionY;
+        CFloats   m_PositionZ;
+        CFloats   m_RotationX;
+        CFloats   m_RotationY;
+        CFloats   m_RotationZ;
+        CFloats   m_RotationW;
+        CFloats   m_ScaleX;
+        CFloats   m_ScaleY;
+        CFloats   m_ScaleZ;
+        CIndices  m_Parents;
+        CIndices  m_LevelBegins;            //< First transformation of every level
+        CMatrices m_WorldMatrices;          //< Local matrices until the level is finished
+        int       m_NumberOfTransformations;
+
+    private:
+
+        void BuildLocalMatrices(int _Begin, int _End);
+        void MultiplyParentMatrices(int _Begin, int _End, const glm::mat4& _rRootMatrix);
+    };
+} // namespace Dt
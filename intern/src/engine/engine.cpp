@@ -9,6 +9,8 @@
 
 #include "engine/camera/cam_control_manager.h"
 
+#include "engine/core/core_console.h"
+#include "engine/core/core_memory.h"
 #include "engine/core/core_plugin_manager.h"
 #include "engine/core/core_program_parameters.h"
 #include "engine/core/core_time.h"
@@ -76,6 +78,8 @@ namespace
 
     void CEngine::Startup()
     {
+        Core::Memory::OnStart();
+
         Core::Time::OnStart();
 
         Scpt::ScriptManager::OnStart();
@@ -112,12 +116,16 @@ namespace
         Gfx::Pipeline::OnExit();
 
         Core::Time::OnExit();
+
+        Core::Memory::OnExit();
     }
 
     // -----------------------------------------------------------------------------
 
     void CEngine::Update()
     {
+        Core::Memory::Update();
+
         Core::PluginManager::Update();
 
         Core::Time::Update();
@@ -136,6 +144,8 @@ namespace
 
         Gfx::Pipeline::Render();
 
+        Core::CConsole::GetInstance().Update();
+
         RaiseEvent(EEvent::Engine_OnUpdate);
     }
 
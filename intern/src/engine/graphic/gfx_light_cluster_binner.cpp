@@ -0,0 +1,385 @@
+
+#include "engine/engine_precompiled.h"
+
+#include "base/base_thread_pool.h"
+
+#include "engine/graphic/gfx_light_cluster_binner.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+    const int g_LightsPerTask = 8;
+
+    // -----------------------------------------------------------------------------
+
+    bool IsSphereIntersectingBox(const glm::vec3& _rCenter, float _Radius, const glm::vec3& _rMin, const glm::vec3& _rMax)
+    {
+        const glm::vec3 Distance = glm::max(glm::max(_rMin - _rCenter, _rCenter - _rMax), glm::vec3(0.0f));
+
+        return glm::dot(Distance, Distance) <= _Radius * _Radius;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Conservative cone vs. sphere test as shown by Bart Wronski in "Cull that
+    // cone!". The sphere is the bounding sphere of a cluster.
+    // -----------------------------------------------------------------------------
+    bool IsSphereIntersectingCone(const glm::vec3& _rCenter, float _Radius, const Gfx::CLightClusterBinner::SLight& _rLight)
+    {
+        const glm::vec3 Direction = _rCenter - _rLight.m_Position;
+
+        const float DistanceSquared    = glm::dot(Direction, Direction);
+        const float DistanceAlongAxis  = glm::dot(Direction, _rLight.m_Direction);
+        const float SinHalfAngle       = std::sqrt(std::max(1.0f - _rLight.m_CosHalfAngle * _rLight.m_CosHalfAngle, 0.0f));
+        const float DistanceToAxis     = std::sqrt(std::max(DistanceSquared - DistanceAlongAxis * DistanceAlongAxis, 0.0f));
+        const float DistanceToCone     = _rLight.m_CosHalfAngle * DistanceToAxis - DistanceAlongAxis * SinHalfAngle;
+
+        const bool IsOutsideAngle = DistanceToCone > _Radius;
+        const bool IsInFront      = DistanceAlongAxis > _Radius + _rLight.m_Radius;
+        const bool IsBehind       = DistanceAlongAxis < -_Radius;
+
+        return !(IsOutsideAngle || IsInFront || IsBehind);
+    }
+} // namespace
+
+namespace Gfx
+{
+    CLightClusterBinner::CLightClusterBinner()
+        : m_Grid               (s_DefaultNumberOfTilesX, s_DefaultNumberOfTilesY, s_DefaultNumberOfSlices)
+        , m_ProjectionMatrix   (glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f))
+        , m_Near               (0.1f)
+        , m_Far                (100.0f)
+        , m_SliceScale         (0.0f)
+        , m_SliceBias          (0.0f)
+        , m_MaxLightsPerCluster(s_DefaultMaxLightsPerCluster)
+        , m_ClusterBounds      ()
+        , m_ChunkPairs         ()
+        , m_Clusters           ()
+        , m_LightIndices       ()
+    {
+        UpdateClusterBounds();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CLightClusterBinner::~CLightClusterBinner()
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CLightClusterBinner::SetGrid(int _NumberOfTilesX, int _NumberOfTilesY, int _NumberOfSlices)
+    {
+        assert(_NumberOfTilesX > 0 && _NumberOfTilesY > 0 && _NumberOfSlices > 0);
+
+        const glm::ivec3 Grid(_NumberOfTilesX, _NumberOfTilesY, _NumberOfSlices);
+
+        if (Grid == m_Grid) return;
+
+        m_Grid = Grid;
+
+        UpdateClusterBounds();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CLightClusterBinner::SetProjection(const glm::mat4& _rProjectionMatrix, float _Near, float _Far)
+    {
+        assert(_Near > 0.0f && _Far > _Near);
+
+        if (_rProjectionMatrix == m_ProjectionMatrix && _Near == m_Near && _Far == m_Far) return;
+
+        m_ProjectionMatrix = _rProjectionMatrix;
+        m_Near             = _Near;
+        m_Far              = _Far;
+
+        UpdateClusterBounds();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CLightClusterBinner::SetMaxLightsPerCluster(int _MaxLightsPerCluster)
+    {
+        assert(_MaxLightsPerCluster > 0);
+
+        m_MaxLightsPerCluster = _MaxLightsPerCluster;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CLightClusterBinner::Bin(const SLight* _pLights, int _NumberOfLights)
+    {
+        assert(_pLights != nullptr || _NumberOfLights == 0);
+
+        const int NumberOfClusters = GetNumberOfClusters();
+        const int NumberOfChunks   = (_NumberOfLights + g_LightsPerTask - 1) / g_LightsPerTask;
+
+        // -----------------------------------------------------------------------------
+        // Every task writes (cluster, light) pairs into its own list. The lists
+        // keep their capacity from frame to frame.
+        // -----------------------------------------------------------------------------
+        if (static_cast<int>(m_ChunkPairs.size()) < NumberOfChunks)
+        {
+            m_ChunkPairs.resize(NumberOfChunks);
+        }
+
+        Base::CThreadPool::GetInstance().ParallelFor(_NumberOfLights, g_LightsPerTask, [&](int _Begin, int _End)
+        {
+            CPairs& rPairs = m_ChunkPairs[_Begin / g_LightsPerTask];
+
+            rPairs.clear();
+
+            for (int IndexOfLight = _Begin; IndexOfLight < _End; ++IndexOfLight)
+            {
+                BinLight(static_cast<uint32_t>(IndexOfLight), _pLights[IndexOfLight], rPairs);
+            }
+        });
+
+        // -----------------------------------------------------------------------------
+        // Count, prefix sum and scatter. Chunks are visited in order, so the
+        // lights of a cluster stay sorted and the first ones win if a cluster
+        // is full.
+        // -----------------------------------------------------------------------------
+        m_Clusters.assign(NumberOfClusters, SCluster{ 0, 0 });
+
+        for (int IndexOfChunk = 0; IndexOfChunk < NumberOfChunks; ++IndexOfChunk)
+        {
+            for (uint64_t Pair : m_ChunkPairs[IndexOfChunk])
+            {
+                SCluster& rCluster = m_Clusters[static_cast<uint32_t>(Pair >> 32)];
+
+                if (rCluster.m_NumberOfLights < static_cast<uint32_t>(m_MaxLightsPerCluster)) ++rCluster.m_NumberOfLights;
+            }
+        }
+
+        uint32_t Offset = 0;
+
+        for (SCluster& rCluster : m_Clusters)
+        {
+            rCluster.m_Offset = Offset;
+
+            Offset += rCluster.m_NumberOfLights;
+
+            rCluster.m_NumberOfLights = 0;
+        }
+
+        m_LightIndices.resize(Offset);
+
+        for (int IndexOfChunk = 0; IndexOfChunk < NumberOfChunks; ++IndexOfChunk)
+        {
+            for (uint64_t Pair : m_ChunkPairs[IndexOfChunk])
+            {
+                SCluster& rCluster = m_Clusters[static_cast<uint32_t>(Pair >> 32)];
+
+                if (rCluster.m_NumberOfLights == static_cast<uint32_t>(m_MaxLightsPerCluster)) continue;
+
+                m_LightIndices[rCluster.m_Offset + rCluster.m_NumberOfLights] = static_cast<uint32_t>(Pair);
+
+                ++rCluster.m_NumberOfLights;
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CLightClusterBinner::GetClusterIndex(int _TileX, int _TileY, int _Slice) const
+    {
+        return (_Slice * m_Grid.y + _TileY) * m_Grid.x + _TileX;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CLightClusterBinner::GetClusterIndex(const glm::vec3& _rViewPosition) const
+    {
+        const glm::vec4 ClipPosition = m_ProjectionMatrix * glm::vec4(_rViewPosition, 1.0f);
+
+        const int TileX = GetTile(ClipPosition.x / ClipPosition.w, m_Grid.x);
+        const int TileY = GetTile(ClipPosition.y / ClipPosition.w, m_Grid.y);
+        const int Slice = GetSlice(-_rViewPosition.z);
+
+        return GetClusterIndex(TileX, TileY, Slice);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    const glm::ivec3& CLightClusterBinner::GetGrid() const
+    {
+        return m_Grid;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CLightClusterBinner::GetNumberOfClusters() const
+    {
+        return m_Grid.x * m_Grid.y * m_Grid.z;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CLightClusterBinner::GetMaxLightsPerCluster() const
+    {
+        return m_MaxLightsPerCluster;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    float CLightClusterBinner::GetSliceScale() const
+    {
+        return m_SliceScale;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    float CLightClusterBinner::GetSliceBias() const
+    {
+        return m_SliceBias;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    const CLightClusterBinner::CClusters& CLightClusterBinner::GetClusters() const
+    {
+        return m_Clusters;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    const CLightClusterBinner::CLightIndices& CLightClusterBinner::GetLightIndices() const
+    {
+        return m_LightIndices;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Bounds of every cluster in view space (camera looks along -z). A point at
+    // depth d with NDC x has the view space x = (NDC + P[2][0]) * d / P[0][0].
+    // -----------------------------------------------------------------------------
+    void CLightClusterBinner::UpdateClusterBounds()
+    {
+        const float LogDepthRange = std::log(m_Far / m_Near);
+
+        m_SliceScale = static_cast<float>(m_Grid.z) / LogDepthRange;
+        m_SliceBias  = -static_cast<float>(m_Grid.z) * std::log(m_Near) / LogDepthRange;
+
+        m_ClusterBounds.resize(GetNumberOfClusters());
+
+        for (int Slice = 0; Slice < m_Grid.z; ++Slice)
+        {
+            const float NearDepth = m_Near * std::pow(m_Far / m_Near, static_cast<float>(Slice    ) / m_Grid.z);
+            const float FarDepth  = m_Near * std::pow(m_Far / m_Near, static_cast<float>(Slice + 1) / m_Grid.z);
+
+            for (int TileY = 0; TileY < m_Grid.y; ++TileY)
+            {
+                for (int TileX = 0; TileX < m_Grid.x; ++TileX)
+                {
+                    SClusterBounds& rBounds = m_ClusterBounds[GetClusterIndex(TileX, TileY, Slice)];
+
+                    rBounds.m_Min = glm::vec3( FLT_MAX);
+                    rBounds.m_Max = glm::vec3(-FLT_MAX);
+
+                    for (int Corner = 0; Corner < 8; ++Corner)
+                    {
+                        const float NDCX  = (static_cast<float>(TileX + ((Corner >> 0) & 1)) / m_Grid.x) * 2.0f - 1.0f;
+                        const float NDCY  = (static_cast<float>(TileY + ((Corner >> 1) & 1)) / m_Grid.y) * 2.0f - 1.0f;
+                        const float Depth = (Corner >> 2) & 1 ? FarDepth : NearDepth;
+
+                        const glm::vec3 Position((NDCX + m_ProjectionMatrix[2][0]) * Depth / m_ProjectionMatrix[0][0], (NDCY + m_ProjectionMatrix[2][1]) * Depth / m_ProjectionMatrix[1][1], -Depth);
+
+                        rBounds.m_Min = glm::min(rBounds.m_Min, Position);
+                        rBounds.m_Max = glm::max(rBounds.m_Max, Position);
+                    }
+
+                    rBounds.m_Center = (rBounds.m_Min + rBounds.m_Max) * 0.5f;
+                    rBounds.m_Radius = glm::length(rBounds.m_Max - rBounds.m_Center);
+                }
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // Only the clusters covered by the screen and depth range of the sphere are
+    // tested against the light.
+    // -----------------------------------------------------------------------------
+    void CLightClusterBinner::BinLight(uint32_t _IndexOfLight, const SLight& _rLight, CPairs& _rPairs) const
+    {
+        const glm::vec3& rCenter = _rLight.m_Position;
+        const float      Radius  = _rLight.m_Radius;
+
+        float MinDepth = -rCenter.z - Radius;
+        float MaxDepth = -rCenter.z + Radius;
+
+        if (MaxDepth < m_Near || MinDepth > m_Far) return;
+
+        MinDepth = std::max(MinDepth, m_Near);
+        MaxDepth = std::min(MaxDepth, m_Far);
+
+        // -----------------------------------------------------------------------------
+        // NDC = x * P[0][0] / d - P[2][0] is monotonic in x and 1/d, so the
+        // corners of the bounding box give the screen space bounds.
+        // -----------------------------------------------------------------------------
+        float MinNDCX =  FLT_MAX, MaxNDCX = -FLT_MAX;
+        float MinNDCY =  FLT_MAX, MaxNDCY = -FLT_MAX;
+
+        for (int Corner = 0; Corner < 8; ++Corner)
+        {
+            const float X     = rCenter.x + ((Corner & 1) ? Radius : -Radius);
+            const float Y     = rCenter.y + ((Corner & 2) ? Radius : -Radius);
+            const float Depth = (Corner & 4) ? MaxDepth : MinDepth;
+
+            MinNDCX = std::min(MinNDCX, X * m_ProjectionMatrix[0][0] / Depth - m_ProjectionMatrix[2][0]);
+            MaxNDCX = std::max(MaxNDCX, X * m_ProjectionMatrix[0][0] / Depth - m_ProjectionMatrix[2][0]);
+            MinNDCY = std::min(MinNDCY, Y * m_ProjectionMatrix[1][1] / Depth - m_ProjectionMatrix[2][1]);
+            MaxNDCY = std::max(MaxNDCY, Y * m_ProjectionMatrix[1][1] / Depth - m_ProjectionMatrix[2][1]);
+        }
+
+        if (MaxNDCX < -1.0f || MinNDCX > 1.0f || MaxNDCY < -1.0f || MinNDCY > 1.0f) return;
+
+        const int MinTileX = GetTile(MinNDCX, m_Grid.x);
+        const int MaxTileX = GetTile(MaxNDCX, m_Grid.x);
+        const int MinTileY = GetTile(MinNDCY, m_Grid.y);
+        const int MaxTileY = GetTile(MaxNDCY, m_Grid.y);
+        const int MinSlice = GetSlice(MinDepth);
+        const int MaxSlice = GetSlice(MaxDepth);
+
+        const bool IsSpotLight = _rLight.m_CosHalfAngle > 0.0f;
+
+        for (int Slice = MinSlice; Slice <= MaxSlice; ++Slice)
+        {
+            for (int TileY = MinTileY; TileY <= MaxTileY; ++TileY)
+            {
+                for (int TileX = MinTileX; TileX <= MaxTileX; ++TileX)
+                {
+                    const int IndexOfCluster = GetClusterIndex(TileX, TileY, Slice);
+
+                    const SClusterBounds& rBounds = m_ClusterBounds[IndexOfCluster];
+
+                    if (!IsSphereIntersectingBox(rCenter, Radius, rBounds.m_Min, rBounds.m_Max)) continue;
+
+                    if (IsSpotLight && !IsSphereIntersectingCone(rBounds.m_Center, rBounds.m_Radius, _rLight)) continue;
+
+                    _rPairs.push_back(static_cast<uint64_t>(IndexOfCluster) << 32 | _IndexOfLight);
+                }
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CLightClusterBinner::GetSlice(float _Depth) const
+    {
+        const float Slice = std::floor(std::log(std::max(_Depth, m_Near)) * m_SliceScale + m_SliceBias);
+
+        return glm::clamp(static_cast<int>(Slice), 0, m_Grid.z - 1);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CLightClusterBinner::GetTile(float _NDC, int _NumberOfTiles) const
+    {
+        const float Tile = std::floor((glm::clamp(_NDC, -1.0f, 1.0f) * 0.5f + 0.5f) * _NumberOfTiles);
+
+        return glm::clamp(static_cast<int>(Tile), 0, _NumberOfTiles - 1);
+    }
+} // namespace Gfx
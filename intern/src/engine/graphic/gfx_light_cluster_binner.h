@@ -0,0 +1,120 @@
+
+#pragma once
+
+#include "engine/engine_config.h"
+
+#include "base/base_include_glm.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Gfx
+{
+    // -----------------------------------------------------------------------------
+    // Assigns point and spot lights to the clusters of a view space froxel grid
+    // (screen tiles times exponential depth slices). Lights are binned in
+    // parallel; the result is one compact list of light indices and an
+    // (offset, count) pair per cluster, ready to be uploaded as they are.
+    //
+    // Everything is done on the CPU, so the binner works without a context.
+    // -----------------------------------------------------------------------------
+    class ENGINE_API CLightClusterBinner
+    {
+    public:
+
+        static const int s_DefaultNumberOfTilesX = 16;
+        static const int s_DefaultNumberOfTilesY = 9;
+        static const int s_DefaultNumberOfSlices = 24;
+
+        static const int s_DefaultMaxLightsPerCluster = 64;
+
+        // -----------------------------------------------------------------------------
+        // Position and direction in view space. Lights with a cosine of the
+        // half outer angle <= 0 are treated as point lights.
+        // -----------------------------------------------------------------------------
+        struct SLight
+        {
+            glm::vec3 m_Position;
+            float     m_Radius;
+            glm::vec3 m_Direction;
+            float     m_CosHalfAngle;
+        };
+
+        struct SCluster
+        {
+            uint32_t m_Offset;
+            uint32_t m_NumberOfLights;
+        };
+
+        using CClusters     = std::vector<SCluster>;
+        using CLightIndices = std::vector<uint32_t>;
+
+    public:
+
+        void SetGrid(int _NumberOfTilesX, int _NumberOfTilesY, int _NumberOfSlices);
+        void SetProjection(const glm::mat4& _rProjectionMatrix, float _Near, float _Far);
+        void SetMaxLightsPerCluster(int _MaxLightsPerCluster);
+
+        void Bin(const SLight* _pLights, int _NumberOfLights);
+
+        int GetClusterIndex(int _TileX, int _TileY, int _Slice) const;
+        int GetClusterIndex(const glm::vec3& _rViewPosition) const;
+
+        const glm::ivec3& GetGrid() const;
+        int GetNumberOfClusters() const;
+        int GetMaxLightsPerCluster() const;
+
+        // -----------------------------------------------------------------------------
+        // Slice of a view space depth d is floor(log(d) * Scale + Bias).
+        // -----------------------------------------------------------------------------
+        float GetSliceScale() const;
+        float GetSliceBias() const;
+
+        const CClusters& GetClusters() const;
+        const CLightIndices& GetLightIndices() const;
+
+    public:
+
+        CLightClusterBinner();
+       ~CLightClusterBinner();
+
+    private:
+
+        struct SClusterBounds
+        {
+            glm::vec3 m_Min;
+            glm::vec3 m_Max;
+            glm::vec3 m_Center;
+            float     m_Radius;
+        };
+
+        using CClusterBounds = std::vector<SClusterBounds>;
+        using CPairs         = std::vector<uint64_t>;
+        using CChunkPairs    = std::vector<CPairs>;
+
+    private:
+
+        void UpdateClusterBounds();
+
+        void BinLight(uint32_t _IndexOfLight, const SLight& _rLight, CPairs& _rPairs) const;
+
+        int GetSlice(float _Depth) const;
+        int GetTile(float _NDC, int _NumberOfTiles) const;
+
+    private:
+
+        glm::ivec3 m_Grid;
+        glm::mat4  m_ProjectionMatrix;
+        float      m_Near;
+        float      m_Far;
+        float      m_SliceScale;
+        float      m_SliceBias;
+        int        m_MaxLightsPerCluster;
+
+        CClusterBounds m_ClusterBounds;
+        CChunkPairs    m_ChunkPairs;
+
+        CClusters     m_Clusters;
+        CLightIndices m_LightIndices;
+    };
+} // namespace Gfx
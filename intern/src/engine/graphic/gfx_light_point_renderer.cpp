@@ -6,6 +6,7 @@
 #include "base/base_uncopyable.h"
 
 #include "engine/core/core_console.h"
+#include "engine/core/core_program_parameters.h"
 
 #include "engine/data/data_component.h"
 #include "engine/data/data_component_facet.h"
@@ -19,6 +20,7 @@
 #include "engine/graphic/gfx_context_manager.h"
 #include "engine/graphic/gfx_debug_renderer.h"
 #include "engine/graphic/gfx_histogram_renderer.h"
+#include "engine/graphic/gfx_light_cluster_binner.h"
 #include "engine/graphic/gfx_light_point_renderer.h"
 #include "engine/graphic/gfx_main.h"
 #include "engine/graphic/gfx_mesh.h"
@@ -96,10 +98,30 @@ namespace
             Dt::CPointLightComponent*  m_pDtComponent;
             Gfx::CPointLight* m_pGfxComponent;
         };
+
+        struct SClusterProperties
+        {
+            glm::uvec4 m_Grid; // TilesX, TilesY, Slices, ExposureHistoryIndex
+            glm::vec4  m_SliceParams; // Scale, Bias, Unused, Unused
+        };
+
+        struct SClusteredLight
+        {
+            glm::vec4 m_LightPosition;
+            glm::vec4 m_LightDirection;
+            glm::vec4 m_LightColor;
+            glm::vec4 m_LightSettings; // InvSqrAttenuationRadius, AngleScale, AngleOffset, Unused
+        };
         
     private:
         
         typedef std::vector<SRenderJob> CRenderJobs;
+        typedef std::vector<CLightClusterBinner::SLight> CBinnerLights;
+        typedef std::vector<SClusteredLight> CClusteredLights;
+
+    private:
+
+        static const int s_MaxNumberOfClusteredLights = 1024;
         
     private:
         
@@ -112,11 +134,28 @@ namespace
         CShaderPtr        m_PunctualLightShaderPSPtr;
 
         CRenderJobs       m_PunctualLightRenderJobs;
+
+        bool              m_UseClusteredLighting;
+
+        CShaderPtr        m_FullscreenShaderVSPtr;
+        CShaderPtr        m_ClusteredLightShaderPSPtr;
+
+        CBufferPtr        m_ClusterPropertiesBufferPtr;
+        CBufferPtr        m_ClusteredLightBufferPtr;
+        CBufferPtr        m_ClusterBufferPtr;
+        CBufferPtr        m_LightIndexBufferPtr;
+
+        CRenderJobs         m_ClusteredLightRenderJobs;
+        CBinnerLights       m_BinnerLights;
+        CClusteredLights    m_ClusteredLights;
+        CLightClusterBinner m_ClusterBinner;
         
     private:
         
         void RenderDirectLight();
+        void RenderClusteredLight();
         void BuildRenderJobs();
+        void BinClusteredLights();
     };
 } // namespace
 
@@ -128,6 +167,17 @@ namespace
         , m_PunctualLightPSBufferPtr  ()
         , m_PunctualLightShaderPSPtr  ()
         , m_PunctualLightRenderJobs   ()
+        , m_UseClusteredLighting      (true)
+        , m_FullscreenShaderVSPtr     ()
+        , m_ClusteredLightShaderPSPtr ()
+        , m_ClusterPropertiesBufferPtr()
+        , m_ClusteredLightBufferPtr   ()
+        , m_ClusterBufferPtr          ()
+        , m_LightIndexBufferPtr       ()
+        , m_ClusteredLightRenderJobs  ()
+        , m_BinnerLights              ()
+        , m_ClusteredLights           ()
+        , m_ClusterBinner             ()
     {
     }
     
@@ -142,6 +192,9 @@ namespace
     
     void CGfxPointLightRenderer::OnStart()
     {
+        m_UseClusteredLighting = Core::CProgramParameters::GetInstance().Get("graphics:clustered_lighting:enable", true);
+
+        m_ClusterBinner.SetMaxLightsPerCluster(Core::CProgramParameters::GetInstance().Get("graphics:clustered_lighting:max_lights_per_cluster", CLightClusterBinner::s_DefaultMaxLightsPerCluster));
     }
     
     // -----------------------------------------------------------------------------
@@ -152,8 +205,16 @@ namespace
         m_MainVSBufferPtr          = 0;
         m_PunctualLightPSBufferPtr = 0;
         m_PunctualLightShaderPSPtr = 0;
+
+        m_FullscreenShaderVSPtr      = 0;
+        m_ClusteredLightShaderPSPtr  = 0;
+        m_ClusterPropertiesBufferPtr = 0;
+        m_ClusteredLightBufferPtr    = 0;
+        m_ClusterBufferPtr           = 0;
+        m_LightIndexBufferPtr        = 0;
         
         m_PunctualLightRenderJobs.clear();
+        m_ClusteredLightRenderJobs.clear();
     }
     
     // -----------------------------------------------------------------------------
@@ -161,6 +222,10 @@ namespace
     void CGfxPointLightRenderer::OnSetupShader()
     {
         m_PunctualLightShaderPSPtr = ShaderManager::CompilePS("punctual_light/fs_light_punctuallight.glsl", "main");
+
+        m_FullscreenShaderVSPtr = ShaderManager::CompileVS("system/vs_fullscreen.glsl", "main");
+
+        m_ClusteredLightShaderPSPtr = ShaderManager::CompilePS("punctual_light/fs_light_clustered.glsl", "main");
     }
     
     // -----------------------------------------------------------------------------
@@ -241,6 +306,44 @@ namespace
         m_MainVSBufferPtr                   = BufferManager::CreateBufferSet(PerDrawCallConstantBuffer);
         
         m_PunctualLightPSBufferPtr          = BufferManager::CreateBufferSet(CameraBuffer, PointLightBuffer, HistogramExposureHistoryBufferPtr);
+
+        // -----------------------------------------------------------------------------
+        // Clustered lighting: the light list, one (offset, count) pair per
+        // cluster and the compact light indices are uploaded once per frame
+        // -----------------------------------------------------------------------------
+        ConstanteBufferDesc.m_Stride        = 0;
+        ConstanteBufferDesc.m_Usage         = CBuffer::GPUReadWrite;
+        ConstanteBufferDesc.m_Binding       = CBuffer::ConstantBuffer;
+        ConstanteBufferDesc.m_Access        = CBuffer::CPUWrite;
+        ConstanteBufferDesc.m_NumberOfBytes = sizeof(SClusterProperties);
+        ConstanteBufferDesc.m_pBytes        = 0;
+        ConstanteBufferDesc.m_pClassKey     = 0;
+
+        m_ClusterPropertiesBufferPtr = BufferManager::CreateBuffer(ConstanteBufferDesc);
+
+        // -----------------------------------------------------------------------------
+
+        ConstanteBufferDesc.m_Stride        = 0;
+        ConstanteBufferDesc.m_Usage         = CBuffer::GPURead;
+        ConstanteBufferDesc.m_Binding       = CBuffer::ResourceBuffer;
+        ConstanteBufferDesc.m_Access        = CBuffer::CPUWrite;
+        ConstanteBufferDesc.m_NumberOfBytes = sizeof(SClusteredLight) * s_MaxNumberOfClusteredLights;
+        ConstanteBufferDesc.m_pBytes        = 0;
+        ConstanteBufferDesc.m_pClassKey     = 0;
+
+        m_ClusteredLightBufferPtr = BufferManager::CreateBuffer(ConstanteBufferDesc);
+
+        // -----------------------------------------------------------------------------
+
+        ConstanteBufferDesc.m_NumberOfBytes = sizeof(CLightClusterBinner::SCluster) * m_ClusterBinner.GetNumberOfClusters();
+
+        m_ClusterBufferPtr = BufferManager::CreateBuffer(ConstanteBufferDesc);
+
+        // -----------------------------------------------------------------------------
+
+        ConstanteBufferDesc.m_NumberOfBytes = sizeof(uint32_t) * m_ClusterBinner.GetNumberOfClusters() * m_ClusterBinner.GetMaxLightsPerCluster();
+
+        m_LightIndexBufferPtr = BufferManager::CreateBuffer(ConstanteBufferDesc);
     }
     
     // -----------------------------------------------------------------------------
@@ -293,6 +396,11 @@ namespace
         // Build render jobs
         // -----------------------------------------------------------------------------
         BuildRenderJobs();
+
+        // -----------------------------------------------------------------------------
+        // Assign lights without shadows to clusters
+        // -----------------------------------------------------------------------------
+        BinClusteredLights();
     }
     
     // -----------------------------------------------------------------------------
@@ -301,6 +409,8 @@ namespace
     {
         Performance::BeginEvent("Punctual Lights");
 
+        RenderClusteredLight();
+
         RenderDirectLight();
 
         Performance::EndEvent();
@@ -429,7 +539,7 @@ namespace
             {
                 assert(pGfxComponent->GetCamera().IsValid());
 
-                LightBuffer.m_LightViewProjection = pGfxComponent->GetCamera()->GetViewProjectionMatrix();
+                LightBuffer.m_LightViewProjection = pGfxComponent->GetShadowMatrix();
             }
             
             BufferManager::UploadBufferData(m_PunctualLightPSBufferPtr->GetBuffer(1), &LightBuffer);
@@ -484,9 +594,111 @@ namespace
     
     // -----------------------------------------------------------------------------
     
+    void CGfxPointLightRenderer::RenderClusteredLight()
+    {
+        if (m_ClusteredLightRenderJobs.size() == 0) return;
+
+        Performance::BeginEvent("Clustered");
+
+        // -----------------------------------------------------------------------------
+        // Upload data
+        // -----------------------------------------------------------------------------
+        const glm::ivec3& rGrid = m_ClusterBinner.GetGrid();
+
+        SClusterProperties ClusterProperties;
+
+        ClusterProperties.m_Grid        = glm::uvec4(rGrid.x, rGrid.y, rGrid.z, HistogramRenderer::GetLastExposureHistoryIndex());
+        ClusterProperties.m_SliceParams = glm::vec4(m_ClusterBinner.GetSliceScale(), m_ClusterBinner.GetSliceBias(), 0.0f, 0.0f);
+
+        BufferManager::UploadBufferData(m_ClusterPropertiesBufferPtr, &ClusterProperties);
+
+        BufferManager::UploadBufferData(m_ClusteredLightBufferPtr, m_ClusteredLights.data(), 0, static_cast<unsigned int>(sizeof(SClusteredLight) * m_ClusteredLights.size()));
+
+        const CLightClusterBinner::CClusters&     rClusters     = m_ClusterBinner.GetClusters();
+        const CLightClusterBinner::CLightIndices& rLightIndices = m_ClusterBinner.GetLightIndices();
+
+        BufferManager::UploadBufferData(m_ClusterBufferPtr, rClusters.data(), 0, static_cast<unsigned int>(sizeof(CLightClusterBinner::SCluster) * rClusters.size()));
+
+        if (rLightIndices.size() > 0)
+        {
+            BufferManager::UploadBufferData(m_LightIndexBufferPtr, rLightIndices.data(), 0, static_cast<unsigned int>(sizeof(uint32_t) * rLightIndices.size()));
+        }
+
+        // -----------------------------------------------------------------------------
+        // One full screen pass shading every light of the cluster of a pixel
+        // -----------------------------------------------------------------------------
+        ContextManager::SetTargetSet(TargetSetManager::GetLightAccumulationTargetSet());
+
+        ContextManager::SetViewPortSet(ViewManager::GetViewPortSet());
+
+        ContextManager::SetBlendState(StateManager::GetBlendState(CBlendState::AdditionBlend));
+
+        ContextManager::SetDepthStencilState(StateManager::GetDepthStencilState(CDepthStencilState::NoDepth));
+
+        ContextManager::SetRasterizerState(StateManager::GetRasterizerState(CRasterizerState::NoCull));
+
+        ContextManager::SetSampler(0, SamplerManager::GetSampler(CSampler::MinMagMipPointClamp));
+        ContextManager::SetSampler(1, SamplerManager::GetSampler(CSampler::MinMagMipPointClamp));
+        ContextManager::SetSampler(2, SamplerManager::GetSampler(CSampler::MinMagMipPointClamp));
+        ContextManager::SetSampler(3, SamplerManager::GetSampler(CSampler::MinMagMipPointClamp));
+
+        ContextManager::SetTopology(STopology::TriangleList);
+
+        ContextManager::SetShaderVS(m_FullscreenShaderVSPtr);
+
+        ContextManager::SetShaderPS(m_ClusteredLightShaderPSPtr);
+
+        ContextManager::SetConstantBuffer(0, Main::GetPerFrameConstantBuffer());
+
+        ContextManager::SetConstantBuffer(1, m_ClusterPropertiesBufferPtr);
+
+        ContextManager::SetResourceBuffer(0, HistogramRenderer::GetExposureHistoryBuffer());
+        ContextManager::SetResourceBuffer(1, m_ClusteredLightBufferPtr);
+        ContextManager::SetResourceBuffer(2, m_ClusterBufferPtr);
+        ContextManager::SetResourceBuffer(3, m_LightIndexBufferPtr);
+
+        ContextManager::SetTexture(0, TargetSetManager::GetDeferredTargetSet()->GetRenderTarget(0));
+        ContextManager::SetTexture(1, TargetSetManager::GetDeferredTargetSet()->GetRenderTarget(1));
+        ContextManager::SetTexture(2, TargetSetManager::GetDeferredTargetSet()->GetRenderTarget(2));
+        ContextManager::SetTexture(3, TargetSetManager::GetDeferredTargetSet()->GetDepthStencilTarget());
+
+        ContextManager::Draw(3, 0);
+
+        ContextManager::ResetTexture(0);
+        ContextManager::ResetTexture(1);
+        ContextManager::ResetTexture(2);
+        ContextManager::ResetTexture(3);
+
+        ContextManager::ResetConstantBuffer(0);
+        ContextManager::ResetConstantBuffer(1);
+
+        ContextManager::ResetResourceBuffer(0);
+        ContextManager::ResetResourceBuffer(1);
+        ContextManager::ResetResourceBuffer(2);
+        ContextManager::ResetResourceBuffer(3);
+
+        ContextManager::ResetShaderVS();
+
+        ContextManager::ResetShaderPS();
+
+        ContextManager::ResetTopology();
+
+        ContextManager::ResetSampler(0);
+        ContextManager::ResetSampler(1);
+        ContextManager::ResetSampler(2);
+        ContextManager::ResetSampler(3);
+
+        ContextManager::ResetRenderContext();
+
+        Performance::EndEvent();
+    }
+    
+    // -----------------------------------------------------------------------------
+    
     void CGfxPointLightRenderer::BuildRenderJobs()
     {
         m_PunctualLightRenderJobs.clear();
+        m_ClusteredLightRenderJobs.clear();
 
         auto DataComponents = Dt::CComponentManager::GetInstance().GetComponents<Dt::CPointLightComponent>();
 
@@ -503,8 +715,61 @@ namespace
             NewRenderJob.m_pDtComponent  = pDtComponent;
             NewRenderJob.m_pGfxComponent = pGfxComponent;
 
-            m_PunctualLightRenderJobs.push_back(NewRenderJob);
+            // -----------------------------------------------------------------------------
+            // Lights with shadows need their own shadow map and keep a pass of
+            // their own; so do lights beyond the capacity of the light buffer.
+            // -----------------------------------------------------------------------------
+            const bool HasShadows = pDtComponent->GetShadowType() != Dt::CPointLightComponent::NoShadows;
+
+            if (m_UseClusteredLighting && !HasShadows && m_ClusteredLightRenderJobs.size() < s_MaxNumberOfClusteredLights)
+            {
+                m_ClusteredLightRenderJobs.push_back(NewRenderJob);
+            }
+            else
+            {
+                m_PunctualLightRenderJobs.push_back(NewRenderJob);
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CGfxPointLightRenderer::BinClusteredLights()
+    {
+        if (m_ClusteredLightRenderJobs.size() == 0) return;
+
+        CCameraPtr CameraPtr = ViewManager::GetMainCamera();
+
+        const glm::mat4& rViewMatrix = CameraPtr->GetView()->GetViewMatrix();
+
+        m_ClusterBinner.SetProjection(CameraPtr->GetProjectionMatrix(), CameraPtr->GetNear(), CameraPtr->GetFar());
+
+        m_BinnerLights   .resize(m_ClusteredLightRenderJobs.size());
+        m_ClusteredLights.resize(m_ClusteredLightRenderJobs.size());
+
+        for (size_t IndexOfLight = 0; IndexOfLight < m_ClusteredLightRenderJobs.size(); ++IndexOfLight)
+        {
+            Dt::CPointLightComponent* pDtComponent = m_ClusteredLightRenderJobs[IndexOfLight].m_pDtComponent;
+
+            const glm::vec3 Position  = pDtComponent->GetHostEntity()->GetWorldPosition();
+            const glm::vec3 Direction = glm::normalize(pDtComponent->GetDirection());
+
+            CLightClusterBinner::SLight& rBinnerLight = m_BinnerLights[IndexOfLight];
+
+            rBinnerLight.m_Position     = glm::vec3(rViewMatrix * glm::vec4(Position, 1.0f));
+            rBinnerLight.m_Radius       = pDtComponent->GetAttenuationRadius();
+            rBinnerLight.m_Direction    = glm::normalize(glm::vec3(rViewMatrix * glm::vec4(Direction, 0.0f)));
+            rBinnerLight.m_CosHalfAngle = glm::cos(pDtComponent->GetOuterConeAngle() / 2.0f);
+
+            SClusteredLight& rClusteredLight = m_ClusteredLights[IndexOfLight];
+
+            rClusteredLight.m_LightPosition  = glm::vec4(Position, 1.0f);
+            rClusteredLight.m_LightDirection = glm::vec4(Direction, 0.0f);
+            rClusteredLight.m_LightColor     = glm::vec4(pDtComponent->GetLightness(), 1.0f);
+            rClusteredLight.m_LightSettings  = glm::vec4(pDtComponent->GetReciprocalSquaredAttenuationRadius(), pDtComponent->GetAngleScale(), pDtComponent->GetAngleOffset(), 0.0f);
         }
+
+        m_ClusterBinner.Bin(m_BinnerLights.data(), static_cast<int>(m_BinnerLights.size()));
     }
 } // namespace
 
@@ -1275,7 +1275,7 @@ namespace
             {
                 assert(pGfxComponent->GetCamera().IsValid());
 
-                LightBuffer[IndexOfLight].m_LightViewProjection = pGfxComponent->GetCamera()->GetViewProjectionMatrix();
+                LightBuffer[IndexOfLight].m_LightViewProjection = pGfxComponent->GetShadowMatrix();
             }
 
             // -----------------------------------------------------------------------------
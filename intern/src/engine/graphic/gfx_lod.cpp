@@ -7,6 +7,7 @@ namespace Gfx
 {
     CLOD::CLOD()
         : m_Surface(0)
+        , m_Error  (0.0f)
     {
     }
     
@@ -23,4 +24,11 @@ namespace Gfx
     {
         return m_Surface;
     }
+
+    // -----------------------------------------------------------------------------
+
+    float CLOD::GetError() const
+    {
+        return m_Error;
+    }
 } // namespace Gfx
\ No newline at end of file
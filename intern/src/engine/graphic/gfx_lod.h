@@ -19,6 +19,12 @@ namespace Gfx
     public:
         
         CSurfacePtr GetSurface() const;
+
+        // -----------------------------------------------------------------------------
+        // Distance to the surface of the first LOD in model units (zero for
+        // the first LOD itself)
+        // -----------------------------------------------------------------------------
+        float GetError() const;
         
     protected:
         
@@ -28,6 +34,7 @@ namespace Gfx
     protected:
         
         CSurfacePtr m_Surface;
+        float       m_Error;
     };
 } // namespace Gfx
 
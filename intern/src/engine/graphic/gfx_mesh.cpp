@@ -3,6 +3,11 @@
 
 #include "engine/graphic/gfx_mesh.h"
 
+namespace
+{
+    const float s_CoarserLODFactor = 0.5f;
+} // namespace
+
 namespace Gfx
 {
     CMesh::CMesh()
@@ -39,4 +44,26 @@ namespace Gfx
     {
         return m_AABB;
     }
+
+    // -----------------------------------------------------------------------------
+
+    unsigned int CMesh::SelectLOD(float _PixelsPerUnit, float _MaxErrorInPixels, unsigned int _CurrentLOD) const
+    {
+        unsigned int AllowedLOD = 0;
+        unsigned int CoarserLOD = 0;
+
+        for (unsigned int IndexOfLOD = 1; IndexOfLOD < m_NumberOfLODs; ++IndexOfLOD)
+        {
+            const float ErrorInPixels = m_LODs[IndexOfLOD]->GetError() * _PixelsPerUnit;
+
+            if (ErrorInPixels <= _MaxErrorInPixels) AllowedLOD = IndexOfLOD;
+
+            if (ErrorInPixels <= _MaxErrorInPixels * s_CoarserLODFactor) CoarserLOD = IndexOfLOD;
+        }
+
+        if (_CurrentLOD > AllowedLOD) return AllowedLOD;
+        if (_CurrentLOD < CoarserLOD) return CoarserLOD;
+
+        return _CurrentLOD;
+    }
 } // namespace Gfx
\ No newline at end of file
@@ -24,6 +24,13 @@ namespace Gfx
         
         Base::AABB3Float GetAABB() const;
 
+        // -----------------------------------------------------------------------------
+        // Coarsest LOD whose error covers at most the given number of pixels.
+        // A coarser LOD than the current one has to stay below half of that,
+        // so meshes close to a threshold do not flip between two LODs.
+        // -----------------------------------------------------------------------------
+        unsigned int SelectLOD(float _PixelsPerUnit, float _MaxErrorInPixels, unsigned int _CurrentLOD) const;
+
     public:
 
         CMesh();
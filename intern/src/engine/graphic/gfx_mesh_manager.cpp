@@ -6,12 +6,14 @@
 #include "base/base_exception.h"
 #include "base/base_include_glm.h"
 #include "base/base_memory.h"
+#include "base/base_memory_arena.h"
 #include "base/base_singleton.h"
 #include "base/base_uncopyable.h"
 
 #include "engine/core/core_asset_importer.h"
 #include "engine/core/core_asset_manager.h"
 #include "engine/core/core_console.h"
+#include "engine/core/core_program_parameters.h"
 
 #include "engine/data/data_component.h"
 #include "engine/data/data_component_manager.h"
@@ -23,6 +25,8 @@
 #include "engine/graphic/gfx_material_manager.h"
 #include "engine/graphic/gfx_mesh.h"
 #include "engine/graphic/gfx_mesh_manager.h"
+#include "engine/graphic/gfx_mesh_optimizer.h"
+#include "engine/graphic/gfx_mesh_simplifier.h"
 #include "engine/graphic/gfx_shader.h"
 #include "engine/graphic/gfx_shader_manager.h"
 
@@ -33,6 +37,7 @@
 #include <array>
 #include <unordered_map>
 #include <functional>
+#include <vector>
 
 using namespace Gfx;
 using namespace Gfx::MeshManager;
@@ -129,6 +134,18 @@ namespace
         { true, true, false, false, true },
         { true, true, true,  true,  true },
     };
+
+    // -----------------------------------------------------------------------------
+    // Meshes below this size are drawn fast enough without LODs; a LOD that
+    // keeps more than this ratio of the previous triangles ends the chain.
+    // -----------------------------------------------------------------------------
+    const unsigned int s_MinNumberOfTrianglesForLODs = 1024;
+    const float        s_MaxTriangleRatioOfLOD       = 0.8f;
+
+    // -----------------------------------------------------------------------------
+    // Overdraw may cost this ratio of the optimized cache misses
+    // -----------------------------------------------------------------------------
+    const float s_OverdrawThreshold = 1.05f;
 }
 
 namespace
@@ -185,6 +202,8 @@ namespace
         using CSurfaces = Base::CManagedPool<CInternSurface, 1024, 1>;
         
         using CMeshByHash = std::unordered_map<Base::BHash, CInternMesh*>;
+
+        using CTriangleRatios = std::vector<float>;
         
     private:
         
@@ -194,12 +213,23 @@ namespace
         
         CMeshByHash m_ModelByHash;
 
+        CMeshSimplifier m_MeshSimplifier;
+        CTriangleRatios m_LODTriangleRatios;        //< Of the first LOD for every further LOD
+        float           m_LODMaxError;              //< Relative to the size of the mesh
+
+        CMeshOptimizer  m_MeshOptimizer;
+        bool            m_IsMeshOptimizerEnabled;   //< Reorders imported meshes for the vertex cache, overdraw and fetch
+
         Dt::CComponentManager::CComponentDelegate::HandleType m_OnDirtyComponentDelegate;
 
     private:
 
         void SetVertexShaderOfSurface(CInternSurface& _rSurface);
 
+        void SetAABBFromVertices(CInternMesh& _rMesh, const void* _pVertices, unsigned int _NumberOfVertices, unsigned int _Stride);
+
+        void CreateSimplifiedLODs(CInternMesh& _rMesh, const CInternSurface& _rSurface, const float* _pPositions, unsigned int _NumberOfVertices, unsigned int _Stride, const unsigned int* _pIndices, unsigned int _NumberOfIndices);
+
         void OnDirtyComponent(Dt::IComponent* _pComponent);
 
         void FillMeshFromFile(CInternMesh* _pMesh, const std::string& _rFilename, int _GenFlag, int _MeshIndex);
@@ -211,10 +241,15 @@ namespace
 namespace
 {
     CGfxMeshManager::CGfxMeshManager()
-        : m_Meshes     ()
-        , m_LODs       ()
-        , m_Surfaces   ()
-        , m_ModelByHash()
+        : m_Meshes                ()
+        , m_LODs                  ()
+        , m_Surfaces              ()
+        , m_ModelByHash           ()
+        , m_MeshSimplifier        ()
+        , m_LODTriangleRatios     ()
+        , m_LODMaxError           (0.0f)
+        , m_MeshOptimizer         ()
+        , m_IsMeshOptimizerEnabled(true)
     {
         m_ModelByHash.reserve(64);
     }
@@ -231,6 +266,11 @@ namespace
     void CGfxMeshManager::OnStart()
     {
         m_OnDirtyComponentDelegate = Dt::CComponentManager::GetInstance().RegisterDirtyComponentHandler(std::bind(&CGfxMeshManager::OnDirtyComponent, this, std::placeholders::_1));
+
+        m_LODTriangleRatios = Core::CProgramParameters::GetInstance().Get<CTriangleRatios>("graphics:lod:triangle_ratios", { 0.5f, 0.25f, 0.125f });
+        m_LODMaxError       = Core::CProgramParameters::GetInstance().Get("graphics:lod:max_error", 0.02f);
+
+        m_IsMeshOptimizerEnabled = Core::CProgramParameters::GetInstance().Get("graphics:mesh_optimizer:enable", true);
     }
     
     // -----------------------------------------------------------------------------
@@ -333,6 +373,8 @@ namespace
         rSurface.m_VertexBufferPtr = BufferManager::CreateBuffer(BufferDesc);
         rSurface.m_NumberOfVertices = static_cast<unsigned>(_NumberOfVertices);
 
+        SetAABBFromVertices(rModel, _rVertices, static_cast<unsigned>(_NumberOfVertices), static_cast<unsigned>(_SizeOfVertex));
+
         // -----------------------------------------------------------------------------
 
         BufferDesc.m_Stride = 0;
@@ -407,8 +449,10 @@ namespace
 
         unsigned int NumberOfBytes = (2 * sizeof(glm::vec3) + sizeof(glm::vec2)) * NumberOfVertices;
 
-        auto* pVertices = static_cast<float*>(Base::CMemory::Allocate(NumberOfBytes));
-        auto* pIndices  = static_cast<unsigned int*>(Base::CMemory::Allocate(sizeof(unsigned int) * NumberOfIndices));
+        Base::CScratchScope Scratch;
+
+        auto* pVertices = static_cast<float*>(Scratch.Allocate(NumberOfBytes));
+        auto* pIndices  = static_cast<unsigned int*>(Scratch.Allocate(sizeof(unsigned int) * NumberOfIndices));
 
         assert(pVertices);
         assert(pIndices);
@@ -497,6 +541,8 @@ namespace
         
         rSurface.m_VertexBufferPtr  = BufferManager::CreateBuffer(BufferDesc);
         rSurface.m_NumberOfVertices = NumberOfVertices;
+
+        SetAABBFromVertices(rModel, pVertices, NumberOfVertices, NumberOfBytes / NumberOfVertices);
         
         // -----------------------------------------------------------------------------
         
@@ -521,12 +567,6 @@ namespace
         // -----------------------------------------------------------------------------
         rSurface.m_MaterialPtr = Gfx::MaterialManager::GetDefaultMaterial();
         
-        // -----------------------------------------------------------------------------
-        // Remove allocated memory after uploading to buffer
-        // -----------------------------------------------------------------------------
-        Base::CMemory::Free(pVertices);
-        Base::CMemory::Free(pIndices);
-        
         return CMeshPtr(ModelPtr);
     }
     
@@ -575,8 +615,10 @@ namespace
         unsigned int NumberOfVertices = (Height - 2) * Width + 2;
         unsigned int NumberOfIndices  = ((Height - 2) * (Width - 1) * 2) * 3;
         
-        auto* pVertices = static_cast<glm::vec3*>(Base::CMemory::Allocate(sizeof(glm::vec3) * NumberOfVertices * 2));
-        auto* pIndices  = static_cast<unsigned int*>(Base::CMemory::Allocate(sizeof(unsigned int) * NumberOfIndices));
+        Base::CScratchScope Scratch;
+
+        auto* pVertices = static_cast<glm::vec3*>(Scratch.Allocate(sizeof(glm::vec3) * NumberOfVertices * 2));
+        auto* pIndices  = static_cast<unsigned int*>(Scratch.Allocate(sizeof(unsigned int) * NumberOfIndices));
         
         assert(pVertices);
         assert(pIndices);
@@ -678,6 +720,8 @@ namespace
 
         rSurface.m_VertexBufferPtr  = BufferManager::CreateBuffer(BufferDesc);
         rSurface.m_NumberOfVertices = NumberOfVertices;
+
+        SetAABBFromVertices(rModel, pVertices, NumberOfVertices, 2 * sizeof(glm::vec3));
         
         // -----------------------------------------------------------------------------
         
@@ -702,12 +746,6 @@ namespace
         // -----------------------------------------------------------------------------
         rSurface.m_MaterialPtr = Gfx::MaterialManager::GetDefaultMaterial();
 
-        // -----------------------------------------------------------------------------
-        // Remove allocated memory after uploading to buffer
-        // -----------------------------------------------------------------------------
-        Base::CMemory::Free(pVertices);
-        Base::CMemory::Free(pIndices);
-        
         return CMeshPtr(MeshPtr);
     }
 
@@ -840,6 +878,8 @@ namespace
 
         rSurface.m_VertexBufferPtr  = BufferManager::CreateBuffer(BufferDesc);
         rSurface.m_NumberOfVertices = static_cast<unsigned int>(VerticesNormal.size()) / 2;
+
+        SetAABBFromVertices(rModel, VerticesNormal.data(), rSurface.m_NumberOfVertices, 2 * sizeof(glm::vec3));
         
         // -----------------------------------------------------------------------------
         
@@ -911,8 +951,10 @@ namespace
         unsigned int NumberOfVertices = 3 + _Slices;
         unsigned int NumberOfIndices = _Slices * 6;
 
-        auto* pVertices = static_cast<glm::vec3*>(Base::CMemory::Allocate(sizeof(glm::vec3) * NumberOfVertices * 2));
-        auto* pIndices = static_cast<unsigned int*>(Base::CMemory::Allocate(sizeof(unsigned int) * NumberOfIndices));
+        Base::CScratchScope Scratch;
+
+        auto* pVertices = static_cast<glm::vec3*>(Scratch.Allocate(sizeof(glm::vec3) * NumberOfVertices * 2));
+        auto* pIndices = static_cast<unsigned int*>(Scratch.Allocate(sizeof(unsigned int) * NumberOfIndices));
 
         assert(pVertices);
         assert(pIndices);
@@ -989,6 +1031,8 @@ namespace
         
         rSurface.m_VertexBufferPtr  = BufferManager::CreateBuffer(BufferDesc);
         rSurface.m_NumberOfVertices = NumberOfVertices;
+
+        SetAABBFromVertices(rModel, pVertices, NumberOfVertices, 2 * sizeof(glm::vec3));
         
         // -----------------------------------------------------------------------------
         
@@ -1013,12 +1057,6 @@ namespace
         // -----------------------------------------------------------------------------
         rSurface.m_MaterialPtr = Gfx::MaterialManager::GetDefaultMaterial();
         
-        // -----------------------------------------------------------------------------
-        // Remove allocated memory after uploading to buffer
-        // -----------------------------------------------------------------------------
-        Base::CMemory::Free(pVertices);
-        Base::CMemory::Free(pIndices);
-        
         return CMeshPtr(ModelPtr);
     }
     
@@ -1066,8 +1104,10 @@ namespace
         unsigned int NumberOfVertices = 4;
         unsigned int NumberOfIndices  = 6;
         
-        auto* pVertices = static_cast<glm::vec2*>(Base::CMemory::Allocate(sizeof(glm::vec2) * NumberOfVertices));
-        auto* pIndices  = static_cast<unsigned int*>(Base::CMemory::Allocate(sizeof(unsigned int) * NumberOfIndices));
+        Base::CScratchScope Scratch;
+
+        auto* pVertices = static_cast<glm::vec2*>(Scratch.Allocate(sizeof(glm::vec2) * NumberOfVertices));
+        auto* pIndices  = static_cast<unsigned int*>(Scratch.Allocate(sizeof(unsigned int) * NumberOfIndices));
         
         // -----------------------------------------------------------------------------
         // Create vertices's of a cone.
@@ -1124,13 +1164,110 @@ namespace
         rSurface.m_IndexBufferPtr  = BufferManager::CreateBuffer(BufferDesc);
         rSurface.m_NumberOfIndices = NumberOfIndices;
         
+        return CMeshPtr(ModelPtr);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    // -----------------------------------------------------------------------------
+    // Bounding box in object space from the position at the start of every
+    // vertex; needed for culling (e.g. of shadow casters).
+    // -----------------------------------------------------------------------------
+    void CGfxMeshManager::SetAABBFromVertices(CInternMesh& _rMesh, const void* _pVertices, unsigned int _NumberOfVertices, unsigned int _Stride)
+    {
+        if (_pVertices == nullptr || _NumberOfVertices == 0) return;
+
+        const char* pBytes = static_cast<const char*>(_pVertices);
+
+        glm::vec3 Min = *reinterpret_cast<const glm::vec3*>(pBytes);
+        glm::vec3 Max = Min;
+
+        for (unsigned int IndexOfVertex = 1; IndexOfVertex < _NumberOfVertices; ++IndexOfVertex)
+        {
+            const glm::vec3& rPosition = *reinterpret_cast<const glm::vec3*>(pBytes + IndexOfVertex * _Stride);
+
+            Min = glm::min(Min, rPosition);
+            Max = glm::max(Max, rPosition);
+        }
+
+        _rMesh.m_AABB = Base::AABB3Float(Min, Max);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CGfxMeshManager::CreateSimplifiedLODs(CInternMesh& _rMesh, const CInternSurface& _rSurface, const float* _pPositions, unsigned int _NumberOfVertices, unsigned int _Stride, const unsigned int* _pIndices, unsigned int _NumberOfIndices)
+    {
+        if (_NumberOfIndices < 3 * s_MinNumberOfTrianglesForLODs) return;
+
+        const glm::vec3 Size = _rMesh.m_AABB.GetMax() - _rMesh.m_AABB.GetMin();
+
+        const float MaxError = m_LODMaxError * glm::max(glm::max(Size.x, Size.y), Size.z);
+
+        Base::CScratchScope Scratch;
+
+        auto* pIndices = static_cast<unsigned int*>(Scratch.Allocate(sizeof(unsigned int) * _NumberOfIndices));
+
+        unsigned int NumberOfIndices = _NumberOfIndices;
+
         // -----------------------------------------------------------------------------
-        // Remove allocated memory after uploading to buffer
+        // Every LOD is simplified from the full mesh, so its error is the
+        // distance to the original surface and not to the previous LOD.
         // -----------------------------------------------------------------------------
-        Base::CMemory::Free(pVertices);
-        Base::CMemory::Free(pIndices);
-        
-        return CMeshPtr(ModelPtr);
+        for (unsigned int IndexOfLOD = 1; IndexOfLOD < CMesh::s_NumberOfLODs && IndexOfLOD <= m_LODTriangleRatios.size(); ++IndexOfLOD)
+        {
+            const unsigned int TargetNumberOfIndices = static_cast<unsigned int>(_NumberOfIndices * m_LODTriangleRatios[IndexOfLOD - 1]) / 3 * 3;
+
+            const CMeshSimplifier::SResult Result = m_MeshSimplifier.Simplify(_pPositions, _NumberOfVertices, _Stride, _pIndices, _NumberOfIndices, TargetNumberOfIndices, MaxError, pIndices);
+
+            if (Result.m_NumberOfIndices == 0 || Result.m_NumberOfIndices > NumberOfIndices * s_MaxTriangleRatioOfLOD) break;
+
+            NumberOfIndices = Result.m_NumberOfIndices;
+
+            // -----------------------------------------------------------------------------
+            // The vertices are shared, so only the triangles are reordered
+            // -----------------------------------------------------------------------------
+            if (m_IsMeshOptimizerEnabled)
+            {
+                m_MeshOptimizer.OptimizeVertexCache(pIndices, NumberOfIndices, _NumberOfVertices, pIndices);
+            }
+
+            // -----------------------------------------------------------------------------
+            // Surface with the vertices, shaders and material of the first LOD
+            // -----------------------------------------------------------------------------
+            CLODs::CPtr LODPtr = m_LODs.Allocate();
+
+            CInternLOD& rLOD = *LODPtr;
+
+            CSurfaces::CPtr SurfacePtr = m_Surfaces.Allocate();
+
+            CInternSurface& rSurface = *SurfacePtr;
+
+            rSurface.m_SurfaceKey         = _rSurface.m_SurfaceKey;
+            rSurface.m_VertexShaderPtr    = _rSurface.m_VertexShaderPtr;
+            rSurface.m_MVPVertexShaderPtr = _rSurface.m_MVPVertexShaderPtr;
+            rSurface.m_VertexBufferPtr    = _rSurface.m_VertexBufferPtr;
+            rSurface.m_MaterialPtr        = _rSurface.m_MaterialPtr;
+            rSurface.m_NumberOfVertices   = _rSurface.m_NumberOfVertices;
+            rSurface.m_NumberOfIndices    = NumberOfIndices;
+
+            SBufferDescriptor IndexBufferDesc;
+
+            IndexBufferDesc.m_Stride        = 0;
+            IndexBufferDesc.m_Usage         = CBuffer::GPURead;
+            IndexBufferDesc.m_Binding       = CBuffer::IndexBuffer;
+            IndexBufferDesc.m_Access        = CBuffer::CPUWrite;
+            IndexBufferDesc.m_NumberOfBytes = sizeof(unsigned int) * NumberOfIndices;
+            IndexBufferDesc.m_pBytes        = pIndices;
+            IndexBufferDesc.m_pClassKey     = nullptr;
+
+            rSurface.m_IndexBufferPtr = BufferManager::CreateBuffer(IndexBufferDesc);
+
+            rLOD.m_Surface = &rSurface;
+            rLOD.m_Error   = Result.m_Error;
+
+            _rMesh.m_LODs[IndexOfLOD] = LODPtr;
+            _rMesh.m_NumberOfLODs     = IndexOfLOD + 1;
+        }
     }
 
     // -----------------------------------------------------------------------------
@@ -1174,7 +1311,9 @@ namespace
         {
             SInputElementDescriptorSetting InputLayoutDesc = g_InputLayoutDescriptor[VSIndex];
 
-            auto* pDescriptor = static_cast<Gfx::SInputElementDescriptor*>(Base::CMemory::Allocate(sizeof(Gfx::SInputElementDescriptor) * InputLayoutDesc.m_NumberOfElements));
+            Base::CScratchScope Scratch;
+
+            auto* pDescriptor = static_cast<Gfx::SInputElementDescriptor*>(Scratch.Allocate(sizeof(Gfx::SInputElementDescriptor) * InputLayoutDesc.m_NumberOfElements));
 
             unsigned int IndexOfRenderInputDesc = InputLayoutDesc.m_Offset;
 
@@ -1186,15 +1325,15 @@ namespace
             }
 
             Gfx::ShaderManager::CreateInputLayout(pDescriptor, InputLayoutDesc.m_NumberOfElements, VSShader);
-
-            Base::CMemory::Free(pDescriptor);
         }
 
         if (VSMVPShader->GetInputLayout() == nullptr)
         {
             SInputElementDescriptorSetting InputLayoutDesc = g_InputLayoutDescriptor[VSIndex];
 
-            auto* pDescriptor = static_cast<Gfx::SInputElementDescriptor*>(Base::CMemory::Allocate(sizeof(Gfx::SInputElementDescriptor) * InputLayoutDesc.m_NumberOfElements));
+            Base::CScratchScope Scratch;
+
+            auto* pDescriptor = static_cast<Gfx::SInputElementDescriptor*>(Scratch.Allocate(sizeof(Gfx::SInputElementDescriptor) * InputLayoutDesc.m_NumberOfElements));
 
             unsigned int IndexOfRenderInputDesc = InputLayoutDesc.m_Offset;
 
@@ -1206,8 +1345,6 @@ namespace
             }
 
             Gfx::ShaderManager::CreateInputLayout(pDescriptor, InputLayoutDesc.m_NumberOfElements, VSMVPShader);
-
-            Base::CMemory::Free(pDescriptor);
         }
 
 
@@ -1311,189 +1448,214 @@ namespace
             // -----------------------------------------------------------------------------
             _pMesh->m_NumberOfLODs = 1;
 
-            for (unsigned int IndexOfLOD = 0; IndexOfLOD < _pMesh->m_NumberOfLODs; IndexOfLOD++)
+            // -----------------------------------------------------------------------------
+            // Create first LOD
+            // -----------------------------------------------------------------------------
+            CLODs::CPtr LODPtr = m_LODs.Allocate();
+
+            CInternLOD& rInternLOD = *LODPtr;
+
+            // -----------------------------------------------------------------------------
+            // Link
+            // -----------------------------------------------------------------------------
+            _pMesh->m_LODs[0] = LODPtr;
+
+            // -----------------------------------------------------------------------------
+            // Create surface
+            // -----------------------------------------------------------------------------
+            CSurfaces::CPtr SurfacePtr = m_Surfaces.Allocate();
+
+            CInternSurface& rSurface = *SurfacePtr;
+
+            rSurface.m_SurfaceKey.m_HasPosition = true;
+
+            assert(_pAssimpMesh->mVertices != nullptr);
+
+            rSurface.m_SurfaceKey.m_HasNormal = (_pAssimpMesh->mNormals != nullptr);
+            rSurface.m_SurfaceKey.m_HasTangent = (_pAssimpMesh->mTangents != nullptr);
+            rSurface.m_SurfaceKey.m_HasBitangent = (_pAssimpMesh->mBitangents != nullptr);
+            rSurface.m_SurfaceKey.m_HasTexCoords = (_pAssimpMesh->mTextureCoords[0] != nullptr);
+
+            // -----------------------------------------------------------------------------
+            // Set vertex shader
+            // -----------------------------------------------------------------------------
+            SetVertexShaderOfSurface(rSurface);
+
+            // -----------------------------------------------------------------------------
+            // Link
+            // -----------------------------------------------------------------------------
+            rInternLOD.m_Surface = &rSurface;
+
+            // -----------------------------------------------------------------------------
+            // Data
+            // -----------------------------------------------------------------------------
+            unsigned int NumberOfVertices = _pAssimpMesh->mNumVertices;
+            unsigned int NumberOfFaces = _pAssimpMesh->mNumFaces;
+            unsigned int NumberOfIndicesPerFace = _pAssimpMesh->mFaces->mNumIndices;
+            unsigned int NumberOfIndices = NumberOfFaces * NumberOfIndicesPerFace;
+            unsigned int NumberOfNormals = NumberOfVertices * rSurface.m_SurfaceKey.m_HasNormal;
+            unsigned int NumberOfTagents = NumberOfVertices * rSurface.m_SurfaceKey.m_HasTangent;
+            unsigned int NumberOfBitangents = NumberOfVertices * rSurface.m_SurfaceKey.m_HasBitangent;
+            unsigned int NumberOfTexCoords = NumberOfVertices * (rSurface.m_SurfaceKey.m_HasTexCoords >= 1);
+            unsigned int NumberOfVerticeElements = 3 * rSurface.m_SurfaceKey.m_HasPosition;
+            unsigned int NumberOfNormalElements = 3 * rSurface.m_SurfaceKey.m_HasNormal;
+            unsigned int NumberOfTagentsElements = 3 * rSurface.m_SurfaceKey.m_HasTangent;
+            unsigned int NumberOfBitangentsElements = 3 * rSurface.m_SurfaceKey.m_HasBitangent;
+            unsigned int NumberOfTexCoordElements = 2 * (rSurface.m_SurfaceKey.m_HasTexCoords >= 1);
+            unsigned int NumberOfVertexElements = NumberOfVertices * NumberOfVerticeElements + NumberOfNormals * NumberOfNormalElements + NumberOfTagents * NumberOfTagentsElements + NumberOfBitangents * NumberOfBitangentsElements + NumberOfTexCoords * NumberOfTexCoordElements;
+
+            assert(NumberOfIndicesPerFace == 3);
+
+            Base::CScratchScope Scratch;
+
+            auto* pUploadIndexData  = static_cast<unsigned int*>(Scratch.Allocate(sizeof(unsigned int) * NumberOfIndices));
+            auto* pUploadVertexData = static_cast<float*>(Scratch.Allocate(sizeof(float) * NumberOfVertexElements));
+
+            // -----------------------------------------------------------------------------
+            // Get data from file
+            // -----------------------------------------------------------------------------
+            aiVector3D* pVertexData = _pAssimpMesh->mVertices;
+            aiVector3D* pNormalData = _pAssimpMesh->mNormals;
+            aiVector3D* pTangentData = _pAssimpMesh->mTangents;
+            aiVector3D* pBitangentData = _pAssimpMesh->mBitangents;
+            aiVector3D* pTextureData = _pAssimpMesh->mTextureCoords[0];
+
+            // -----------------------------------------------------------------------------
+            // Setup surface
+            // -----------------------------------------------------------------------------
+            for (unsigned int IndexOfFace = 0; IndexOfFace < NumberOfFaces; ++IndexOfFace)
+            {
+                aiFace CurrentFace = _pAssimpMesh->mFaces[IndexOfFace];
+
+                for (unsigned int IndexOfIndice = 0; IndexOfIndice < NumberOfIndicesPerFace; ++IndexOfIndice)
+                {
+                    pUploadIndexData[IndexOfFace * NumberOfIndicesPerFace + IndexOfIndice] = CurrentFace.mIndices[IndexOfIndice];
+                }
+            }
+
+            unsigned int VertexDataIndex = 0;
+
+            for (unsigned int CurrentVertex = 0; CurrentVertex < NumberOfVertices; ++CurrentVertex)
             {
-                // -----------------------------------------------------------------------------
-                // Create LOD
-                // -----------------------------------------------------------------------------
-                CLODs::CPtr LODPtr = m_LODs.Allocate();
-
-                CInternLOD& rInternLOD = *LODPtr;
-
-                // -----------------------------------------------------------------------------
-                // Link
-                // -----------------------------------------------------------------------------
-                _pMesh->m_LODs[IndexOfLOD] = LODPtr;
-
-                // -----------------------------------------------------------------------------
-                // Create surface
-                // -----------------------------------------------------------------------------
-                CSurfaces::CPtr SurfacePtr = m_Surfaces.Allocate();
-
-                CInternSurface& rSurface = *SurfacePtr;
-
-                rSurface.m_SurfaceKey.m_HasPosition = true;
-
-                assert(_pAssimpMesh->mVertices != nullptr);
-
-                rSurface.m_SurfaceKey.m_HasNormal = (_pAssimpMesh->mNormals != nullptr);
-                rSurface.m_SurfaceKey.m_HasTangent = (_pAssimpMesh->mTangents != nullptr);
-                rSurface.m_SurfaceKey.m_HasBitangent = (_pAssimpMesh->mBitangents != nullptr);
-                rSurface.m_SurfaceKey.m_HasTexCoords = (_pAssimpMesh->mTextureCoords[0] != nullptr);
-
-                // -----------------------------------------------------------------------------
-                // Set vertex shader
-                // -----------------------------------------------------------------------------
-                SetVertexShaderOfSurface(rSurface);
-
-                // -----------------------------------------------------------------------------
-                // Link
-                // -----------------------------------------------------------------------------
-                rInternLOD.m_Surface = &rSurface;
-
-                // -----------------------------------------------------------------------------
-                // Data
-                // -----------------------------------------------------------------------------
-                unsigned int NumberOfVertices = _pAssimpMesh->mNumVertices;
-                unsigned int NumberOfFaces = _pAssimpMesh->mNumFaces;
-                unsigned int NumberOfIndicesPerFace = _pAssimpMesh->mFaces->mNumIndices;
-                unsigned int NumberOfIndices = NumberOfFaces * NumberOfIndicesPerFace;
-                unsigned int NumberOfNormals = NumberOfVertices * rSurface.m_SurfaceKey.m_HasNormal;
-                unsigned int NumberOfTagents = NumberOfVertices * rSurface.m_SurfaceKey.m_HasTangent;
-                unsigned int NumberOfBitangents = NumberOfVertices * rSurface.m_SurfaceKey.m_HasBitangent;
-                unsigned int NumberOfTexCoords = NumberOfVertices * (rSurface.m_SurfaceKey.m_HasTexCoords >= 1);
-                unsigned int NumberOfVerticeElements = 3 * rSurface.m_SurfaceKey.m_HasPosition;
-                unsigned int NumberOfNormalElements = 3 * rSurface.m_SurfaceKey.m_HasNormal;
-                unsigned int NumberOfTagentsElements = 3 * rSurface.m_SurfaceKey.m_HasTangent;
-                unsigned int NumberOfBitangentsElements = 3 * rSurface.m_SurfaceKey.m_HasBitangent;
-                unsigned int NumberOfTexCoordElements = 2 * (rSurface.m_SurfaceKey.m_HasTexCoords >= 1);
-                unsigned int NumberOfVertexElements = NumberOfVertices * NumberOfVerticeElements + NumberOfNormals * NumberOfNormalElements + NumberOfTagents * NumberOfTagentsElements + NumberOfBitangents * NumberOfBitangentsElements + NumberOfTexCoords * NumberOfTexCoordElements;
-
-                assert(NumberOfIndicesPerFace == 3);
-
-                auto* pUploadIndexData  = static_cast<unsigned int*>(Base::CMemory::Allocate(sizeof(unsigned int) * NumberOfIndices));
-                auto* pUploadVertexData = static_cast<float*>(Base::CMemory::Allocate(sizeof(float) * NumberOfVertexElements));
-
-                // -----------------------------------------------------------------------------
-                // Get data from file
-                // -----------------------------------------------------------------------------
-                aiVector3D* pVertexData = _pAssimpMesh->mVertices;
-                aiVector3D* pNormalData = _pAssimpMesh->mNormals;
-                aiVector3D* pTangentData = _pAssimpMesh->mTangents;
-                aiVector3D* pBitangentData = _pAssimpMesh->mBitangents;
-                aiVector3D* pTextureData = _pAssimpMesh->mTextureCoords[0];
-
-                // -----------------------------------------------------------------------------
-                // Setup surface
-                // -----------------------------------------------------------------------------
-                for (unsigned int IndexOfFace = 0; IndexOfFace < NumberOfFaces; ++IndexOfFace)
+                pUploadVertexData[VertexDataIndex + 0] = pVertexData[CurrentVertex].x;
+                pUploadVertexData[VertexDataIndex + 1] = pVertexData[CurrentVertex].y;
+                pUploadVertexData[VertexDataIndex + 2] = pVertexData[CurrentVertex].z;
+
+                VertexDataIndex += 3;
+
+                if (rSurface.m_SurfaceKey.m_HasNormal)
                 {
-                    aiFace CurrentFace = _pAssimpMesh->mFaces[IndexOfFace];
+                    pUploadVertexData[VertexDataIndex + 0] = pNormalData[CurrentVertex].x;
+                    pUploadVertexData[VertexDataIndex + 1] = pNormalData[CurrentVertex].y;
+                    pUploadVertexData[VertexDataIndex + 2] = pNormalData[CurrentVertex].z;
 
-                    for (unsigned int IndexOfIndice = 0; IndexOfIndice < NumberOfIndicesPerFace; ++IndexOfIndice)
-                    {
-                        pUploadIndexData[IndexOfFace * NumberOfIndicesPerFace + IndexOfIndice] = CurrentFace.mIndices[IndexOfIndice];
-                    }
+                    VertexDataIndex += 3;
                 }
 
-                unsigned int VertexDataIndex = 0;
+                if (rSurface.m_SurfaceKey.m_HasTangent)
+                {
+                    assert(pTangentData != nullptr);
+
+                    pUploadVertexData[VertexDataIndex + 0] = pTangentData[CurrentVertex].x;
+                    pUploadVertexData[VertexDataIndex + 1] = pTangentData[CurrentVertex].y;
+                    pUploadVertexData[VertexDataIndex + 2] = pTangentData[CurrentVertex].z;
+
+                    VertexDataIndex += 3;
+                }
 
-                for (unsigned int CurrentVertex = 0; CurrentVertex < NumberOfVertices; ++CurrentVertex)
+                if (rSurface.m_SurfaceKey.m_HasBitangent)
                 {
-                    pUploadVertexData[VertexDataIndex + 0] = pVertexData[CurrentVertex].x;
-                    pUploadVertexData[VertexDataIndex + 1] = pVertexData[CurrentVertex].y;
-                    pUploadVertexData[VertexDataIndex + 2] = pVertexData[CurrentVertex].z;
+                    assert(pBitangentData != nullptr);
+
+                    pUploadVertexData[VertexDataIndex + 0] = pBitangentData[CurrentVertex].x;
+                    pUploadVertexData[VertexDataIndex + 1] = pBitangentData[CurrentVertex].y;
+                    pUploadVertexData[VertexDataIndex + 2] = pBitangentData[CurrentVertex].z;
 
                     VertexDataIndex += 3;
+                }
 
-                    if (rSurface.m_SurfaceKey.m_HasNormal)
-                    {
-                        pUploadVertexData[VertexDataIndex + 0] = pNormalData[CurrentVertex].x;
-                        pUploadVertexData[VertexDataIndex + 1] = pNormalData[CurrentVertex].y;
-                        pUploadVertexData[VertexDataIndex + 2] = pNormalData[CurrentVertex].z;
+                if (rSurface.m_SurfaceKey.m_HasTexCoords)
+                {
+                    pUploadVertexData[VertexDataIndex + 0] = pTextureData[CurrentVertex].x;
+                    pUploadVertexData[VertexDataIndex + 1] = pTextureData[CurrentVertex].y;
 
-                        VertexDataIndex += 3;
-                    }
+                    VertexDataIndex += 2;
+                }
+            }
 
-                    if (rSurface.m_SurfaceKey.m_HasTangent)
-                    {
-                        assert(pTangentData != nullptr);
+            assert(VertexDataIndex == NumberOfVertexElements);
 
-                        pUploadVertexData[VertexDataIndex + 0] = pTangentData[CurrentVertex].x;
-                        pUploadVertexData[VertexDataIndex + 1] = pTangentData[CurrentVertex].y;
-                        pUploadVertexData[VertexDataIndex + 2] = pTangentData[CurrentVertex].z;
+            // -----------------------------------------------------------------------------
+            // Files keep the order of the tool that wrote them (e.g. scans
+            // or CAD exports), which is often bad for the GPU. The triangles
+            // are reordered for the vertex cache and against overdraw, then
+            // the vertices in the order they are fetched.
+            // -----------------------------------------------------------------------------
+            const unsigned int SizeOfVertex = sizeof(float) * (NumberOfVerticeElements + NumberOfNormalElements + NumberOfTagentsElements + NumberOfBitangentsElements + NumberOfTexCoordElements);
 
-                        VertexDataIndex += 3;
-                    }
+            if (m_IsMeshOptimizerEnabled && NumberOfIndices > 0)
+            {
+                const CMeshOptimizer::SStatistics Before = m_MeshOptimizer.AnalyzeVertexCache(pUploadIndexData, NumberOfIndices, NumberOfVertices);
 
-                    if (rSurface.m_SurfaceKey.m_HasBitangent)
-                    {
-                        assert(pBitangentData != nullptr);
+                m_MeshOptimizer.OptimizeVertexCache(pUploadIndexData, NumberOfIndices, NumberOfVertices, pUploadIndexData);
 
-                        pUploadVertexData[VertexDataIndex + 0] = pBitangentData[CurrentVertex].x;
-                        pUploadVertexData[VertexDataIndex + 1] = pBitangentData[CurrentVertex].y;
-                        pUploadVertexData[VertexDataIndex + 2] = pBitangentData[CurrentVertex].z;
+                m_MeshOptimizer.OptimizeOverdraw(pUploadIndexData, NumberOfIndices, pUploadVertexData, NumberOfVertices, SizeOfVertex, s_OverdrawThreshold, pUploadIndexData);
 
-                        VertexDataIndex += 3;
-                    }
+                NumberOfVertices = m_MeshOptimizer.OptimizeVertexFetch(pUploadVertexData, NumberOfVertices, SizeOfVertex, pUploadIndexData, NumberOfIndices);
 
-                    if (rSurface.m_SurfaceKey.m_HasTexCoords)
-                    {
-                        pUploadVertexData[VertexDataIndex + 0] = pTextureData[CurrentVertex].x;
-                        pUploadVertexData[VertexDataIndex + 1] = pTextureData[CurrentVertex].y;
+                NumberOfVertexElements = NumberOfVertices * SizeOfVertex / sizeof(float);
 
-                        VertexDataIndex += 2;
-                    }
-                }
+                const CMeshOptimizer::SStatistics After = m_MeshOptimizer.AnalyzeVertexCache(pUploadIndexData, NumberOfIndices, NumberOfVertices);
 
-                assert(VertexDataIndex == NumberOfVertexElements);
-
-                // -----------------------------------------------------------------------------
-                // Create buffer with vertices's and indices (setup surface data)
-                // -----------------------------------------------------------------------------
-                SBufferDescriptor VertexBufferDesc;
-
-                VertexBufferDesc.m_Stride = 0;
-                VertexBufferDesc.m_Usage = CBuffer::GPURead;
-                VertexBufferDesc.m_Binding = CBuffer::VertexBuffer;
-                VertexBufferDesc.m_Access = CBuffer::CPUWrite;
-                VertexBufferDesc.m_NumberOfBytes = sizeof(float) * NumberOfVertexElements;
-                VertexBufferDesc.m_pBytes = pUploadVertexData;
-                VertexBufferDesc.m_pClassKey = nullptr;
-
-                rSurface.m_VertexBufferPtr = BufferManager::CreateBuffer(VertexBufferDesc);
-
-                // -----------------------------------------------------------------------------
-
-                SBufferDescriptor IndexBufferDesc;
-
-                IndexBufferDesc.m_Stride = 0;
-                IndexBufferDesc.m_Usage = CBuffer::GPURead;
-                IndexBufferDesc.m_Binding = CBuffer::IndexBuffer;
-                IndexBufferDesc.m_Access = CBuffer::CPUWrite;
-                IndexBufferDesc.m_NumberOfBytes = sizeof(unsigned int) * NumberOfIndices;
-                IndexBufferDesc.m_pBytes = pUploadIndexData;
-                IndexBufferDesc.m_pClassKey = nullptr;
-
-                rSurface.m_IndexBufferPtr = BufferManager::CreateBuffer(IndexBufferDesc);
-
-                // -----------------------------------------------------------------------------
-                // Set last data information of the surface
-                // -----------------------------------------------------------------------------
-                rSurface.m_NumberOfVertices = NumberOfVertices;
-                rSurface.m_NumberOfIndices = NumberOfIndices;
-
-                // -----------------------------------------------------------------------------
-                // Delete allocated memory
-                // -----------------------------------------------------------------------------
-                Base::CMemory::Free(pUploadIndexData);
-                Base::CMemory::Free(pUploadVertexData);
-
-                // -----------------------------------------------------------------------------
-                // Load default material from material manager
-                // -----------------------------------------------------------------------------
-                rSurface.m_MaterialPtr = MaterialManager::GetDefaultMaterial();
+                ENGINE_CONSOLE_INFOV("Optimized mesh '%s' (%u triangles): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", _pAssimpMesh->mName.C_Str(), NumberOfIndices / 3, Before.m_ACMR, After.m_ACMR, Before.m_ATVR, After.m_ATVR);
             }
+
+            // -----------------------------------------------------------------------------
+            // Create buffer with vertices's and indices (setup surface data)
+            // -----------------------------------------------------------------------------
+            SBufferDescriptor VertexBufferDesc;
+
+            VertexBufferDesc.m_Stride = 0;
+            VertexBufferDesc.m_Usage = CBuffer::GPURead;
+            VertexBufferDesc.m_Binding = CBuffer::VertexBuffer;
+            VertexBufferDesc.m_Access = CBuffer::CPUWrite;
+            VertexBufferDesc.m_NumberOfBytes = sizeof(float) * NumberOfVertexElements;
+            VertexBufferDesc.m_pBytes = pUploadVertexData;
+            VertexBufferDesc.m_pClassKey = nullptr;
+
+            rSurface.m_VertexBufferPtr = BufferManager::CreateBuffer(VertexBufferDesc);
+
+            // -----------------------------------------------------------------------------
+
+            SBufferDescriptor IndexBufferDesc;
+
+            IndexBufferDesc.m_Stride = 0;
+            IndexBufferDesc.m_Usage = CBuffer::GPURead;
+            IndexBufferDesc.m_Binding = CBuffer::IndexBuffer;
+            IndexBufferDesc.m_Access = CBuffer::CPUWrite;
+            IndexBufferDesc.m_NumberOfBytes = sizeof(unsigned int) * NumberOfIndices;
+            IndexBufferDesc.m_pBytes = pUploadIndexData;
+            IndexBufferDesc.m_pClassKey = nullptr;
+
+            rSurface.m_IndexBufferPtr = BufferManager::CreateBuffer(IndexBufferDesc);
+
+            // -----------------------------------------------------------------------------
+            // Set last data information of the surface
+            // -----------------------------------------------------------------------------
+            rSurface.m_NumberOfVertices = NumberOfVertices;
+            rSurface.m_NumberOfIndices = NumberOfIndices;
+
+            SetAABBFromVertices(*_pMesh, pUploadVertexData, NumberOfVertices, SizeOfVertex);
+
+            // -----------------------------------------------------------------------------
+            // Load default material from material manager
+            // -----------------------------------------------------------------------------
+            rSurface.m_MaterialPtr = MaterialManager::GetDefaultMaterial();
+
+            // -----------------------------------------------------------------------------
+            // Simplified LODs share the vertices of the first one
+            // -----------------------------------------------------------------------------
+            CreateSimplifiedLODs(*_pMesh, rSurface, pUploadVertexData, NumberOfVertices, SizeOfVertex, pUploadIndexData, NumberOfIndices);
         };
 
         // -----------------------------------------------------------------------------
@@ -0,0 +1,520 @@
+#include "engine/engine_precompiled.h"
+
+#include "engine/graphic/gfx_mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const unsigned int s_InvalidIndex = ~0u;
+
+    // -----------------------------------------------------------------------------
+    // Scoring of Forsyth's vertex cache optimization. The modelled cache is
+    // an LRU cache larger than the FIFO of the hardware, so the order does
+    // not depend on the exact size of it.
+    // -----------------------------------------------------------------------------
+    const unsigned int s_ScoreCacheSize    = 32;
+    const float        s_LastTriangleScore = 0.75f;
+    const float        s_CacheDecayPower   = 1.5f;
+    const float        s_ValenceBoostScale = 2.0f;
+    const float        s_ValenceBoostPower = 0.5f;
+    const unsigned int s_MaxValence        = 32;    //< Larger valences score like this one
+
+    // -----------------------------------------------------------------------------
+    // The scores only depend on the position in the cache and the number of
+    // remaining triangles, so they are looked up instead of calculated for
+    // every vertex around the cache after every triangle.
+    // -----------------------------------------------------------------------------
+    struct SScoreTables
+    {
+        float m_ScoreOfCachePosition[s_ScoreCacheSize];
+        float m_ScoreOfValence      [s_MaxValence + 1];
+
+        SScoreTables()
+        {
+            for (unsigned int CachePosition = 0; CachePosition < s_ScoreCacheSize; ++CachePosition)
+            {
+                m_ScoreOfCachePosition[CachePosition] = CachePosition < 3 ? s_LastTriangleScore : std::pow(1.0f - static_cast<float>(CachePosition - 3) / (s_ScoreCacheSize - 3), s_CacheDecayPower);
+            }
+
+            m_ScoreOfValence[0] = 0.0f;
+
+            for (unsigned int Valence = 1; Valence <= s_MaxValence; ++Valence)
+            {
+                m_ScoreOfValence[Valence] = s_ValenceBoostScale * std::pow(static_cast<float>(Valence), -s_ValenceBoostPower);
+            }
+        }
+    };
+
+    const SScoreTables s_ScoreTables;
+} // namespace
+
+namespace Gfx
+{
+    CMeshOptimizer::CMeshOptimizer()
+        : m_Indices              ()
+        , m_TriangleOffsets      ()
+        , m_Triangles            ()
+        , m_NumberOfLiveTriangles()
+        , m_CachePositions       ()
+        , m_VertexScores         ()
+        , m_IsEmitted            ()
+        , m_Cache                ()
+        , m_NextCache            ()
+        , m_CacheTimestamps      ()
+        , m_CacheTimestamp       (0)
+        , m_Boundaries           ()
+        , m_Clusters             ()
+        , m_Remap                ()
+        , m_Vertices             ()
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CMeshOptimizer::~CMeshOptimizer()
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMeshOptimizer::OptimizeVertexCache(const unsigned int* _pIndices, unsigned int _NumberOfIndices, unsigned int _NumberOfVertices, unsigned int* _pResult)
+    {
+        assert(_pIndices != nullptr && _pResult != nullptr);
+        assert(_NumberOfIndices % 3 == 0);
+
+        const unsigned int NumberOfTriangles = _NumberOfIndices / 3;
+
+        m_Indices.assign(_pIndices, _pIndices + _NumberOfIndices);
+
+        BuildAdjacency(m_Indices.data(), _NumberOfIndices, _NumberOfVertices);
+
+        m_CachePositions.assign(_NumberOfVertices, s_InvalidIndex);
+        m_VertexScores  .resize(_NumberOfVertices);
+        m_IsEmitted     .assign(NumberOfTriangles, 0);
+
+        for (unsigned int IndexOfVertex = 0; IndexOfVertex < _NumberOfVertices; ++IndexOfVertex)
+        {
+            m_VertexScores[IndexOfVertex] = GetVertexScore(IndexOfVertex);
+        }
+
+        auto GetTriangleScore = [&](unsigned int _Triangle)
+        {
+            const unsigned int* pTriangle = &m_Indices[_Triangle * 3];
+
+            return m_VertexScores[pTriangle[0]] + m_VertexScores[pTriangle[1]] + m_VertexScores[pTriangle[2]];
+        };
+
+        // -----------------------------------------------------------------------------
+        // Without a cache the valence decides: the first triangle is one with
+        // few neighbours (e.g. at a border or in a corner).
+        // -----------------------------------------------------------------------------
+        unsigned int BestTriangle = s_InvalidIndex;
+
+        float BestScore = -1.0f;
+
+        for (unsigned int IndexOfTriangle = 0; IndexOfTriangle < NumberOfTriangles; ++IndexOfTriangle)
+        {
+            const float Score = GetTriangleScore(IndexOfTriangle);
+
+            if (Score > BestScore)
+            {
+                BestScore    = Score;
+                BestTriangle = IndexOfTriangle;
+            }
+        }
+
+        m_Cache.clear();
+
+        unsigned int NextTriangleOfInput = 0;
+
+        for (unsigned int IndexOfOutput = 0; IndexOfOutput < NumberOfTriangles; ++IndexOfOutput)
+        {
+            // -----------------------------------------------------------------------------
+            // Continue in the order of the input if no triangle around the
+            // cache is left (the mesh has several parts)
+            // -----------------------------------------------------------------------------
+            if (BestTriangle == s_InvalidIndex)
+            {
+                while (m_IsEmitted[NextTriangleOfInput]) ++NextTriangleOfInput;
+
+                BestTriangle = NextTriangleOfInput;
+            }
+
+            const unsigned int* pTriangle = &m_Indices[BestTriangle * 3];
+
+            std::copy(pTriangle, pTriangle + 3, _pResult + IndexOfOutput * 3);
+
+            m_IsEmitted[BestTriangle] = 1;
+
+            // -----------------------------------------------------------------------------
+            // The vertices of the triangle lose it and move to the front of
+            // the cache, the other entries move back.
+            // -----------------------------------------------------------------------------
+            m_NextCache.clear();
+
+            for (unsigned int IndexOfCorner = 0; IndexOfCorner < 3; ++IndexOfCorner)
+            {
+                const unsigned int Vertex = pTriangle[IndexOfCorner];
+
+                unsigned int* pTriangles = &m_Triangles[m_TriangleOffsets[Vertex]];
+                unsigned int* pEnd       = pTriangles + m_NumberOfLiveTriangles[Vertex];
+
+                *std::find(pTriangles, pEnd, BestTriangle) = pEnd[-1];
+
+                -- m_NumberOfLiveTriangles[Vertex];
+
+                if (std::find(m_NextCache.begin(), m_NextCache.end(), Vertex) == m_NextCache.end()) m_NextCache.push_back(Vertex);
+            }
+
+            for (unsigned int Vertex : m_Cache)
+            {
+                if (Vertex != pTriangle[0] && Vertex != pTriangle[1] && Vertex != pTriangle[2]) m_NextCache.push_back(Vertex);
+            }
+
+            // -----------------------------------------------------------------------------
+            // Scores change for every vertex that is or was in the cache and
+            // for the remaining triangles around them; the best of those is
+            // the next one.
+            // -----------------------------------------------------------------------------
+            for (unsigned int IndexOfEntry = 0; IndexOfEntry < m_NextCache.size(); ++IndexOfEntry)
+            {
+                const unsigned int Vertex = m_NextCache[IndexOfEntry];
+
+                m_CachePositions[Vertex] = IndexOfEntry < s_ScoreCacheSize ? IndexOfEntry : s_InvalidIndex;
+                m_VertexScores  [Vertex] = GetVertexScore(Vertex);
+            }
+
+            BestTriangle = s_InvalidIndex;
+            BestScore    = -1.0f;
+
+            for (unsigned int Vertex : m_NextCache)
+            {
+                const unsigned int* pTriangles = &m_Triangles[m_TriangleOffsets[Vertex]];
+
+                for (unsigned int IndexOfTriangle = 0; IndexOfTriangle < m_NumberOfLiveTriangles[Vertex]; ++IndexOfTriangle)
+                {
+                    const float Score = GetTriangleScore(pTriangles[IndexOfTriangle]);
+
+                    if (Score > BestScore)
+                    {
+                        BestScore    = Score;
+                        BestTriangle = pTriangles[IndexOfTriangle];
+                    }
+                }
+            }
+
+            if (m_NextCache.size() > s_ScoreCacheSize) m_NextCache.resize(s_ScoreCacheSize);
+
+            m_Cache.swap(m_NextCache);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMeshOptimizer::OptimizeOverdraw(const unsigned int* _pIndices, unsigned int _NumberOfIndices, const float* _pPositions, unsigned int _NumberOfVertices, unsigned int _Stride, float _Threshold, unsigned int* _pResult)
+    {
+        assert(_pIndices != nullptr && _pPositions != nullptr && _pResult != nullptr);
+        assert(_NumberOfIndices % 3 == 0 && _Stride >= 3 * sizeof(float));
+
+        const unsigned int NumberOfTriangles = _NumberOfIndices / 3;
+
+        m_Indices.assign(_pIndices, _pIndices + _NumberOfIndices);
+
+        auto GetPosition = [&](unsigned int _Vertex) -> const glm::vec3&
+        {
+            return *reinterpret_cast<const glm::vec3*>(reinterpret_cast<const char*>(_pPositions) + static_cast<size_t>(_Vertex) * _Stride);
+        };
+
+        // -----------------------------------------------------------------------------
+        // Hard boundaries: the vertex cache optimization started again from
+        // an empty cache where all vertices of a triangle are missing.
+        // -----------------------------------------------------------------------------
+        ResetCache(_NumberOfVertices);
+
+        m_Boundaries.clear();
+
+        for (unsigned int IndexOfTriangle = 0; IndexOfTriangle < NumberOfTriangles; ++IndexOfTriangle)
+        {
+            const unsigned int NumberOfMisses = CountCacheMisses(&m_Indices[IndexOfTriangle * 3]);
+
+            if (IndexOfTriangle == 0 || NumberOfMisses == 3) m_Boundaries.push_back(IndexOfTriangle);
+        }
+
+        m_Boundaries.push_back(NumberOfTriangles);
+
+        // -----------------------------------------------------------------------------
+        // Soft boundaries: a hard cluster is split as soon as the part in
+        // front of the split is as cache friendly as the threshold allows.
+        // Every cluster starts from an empty cache, so any order of the
+        // clusters keeps the ACMR below the threshold.
+        // -----------------------------------------------------------------------------
+        m_Clusters.clear();
+
+        for (unsigned int IndexOfBoundary = 0; IndexOfBoundary + 1 < m_Boundaries.size(); ++IndexOfBoundary)
+        {
+            const unsigned int Start = m_Boundaries[IndexOfBoundary];
+            const unsigned int End   = m_Boundaries[IndexOfBoundary + 1];
+
+            unsigned int NumberOfMisses = 0;
+
+            FlushCache();
+
+            for (unsigned int IndexOfTriangle = Start; IndexOfTriangle < End; ++IndexOfTriangle)
+            {
+                NumberOfMisses += CountCacheMisses(&m_Indices[IndexOfTriangle * 3]);
+            }
+
+            const float Threshold = _Threshold * NumberOfMisses / (End - Start);
+
+            unsigned int StartOfCluster = Start;
+
+            NumberOfMisses = 0;
+
+            FlushCache();
+
+            for (unsigned int IndexOfTriangle = Start; IndexOfTriangle < End; ++IndexOfTriangle)
+            {
+                NumberOfMisses += CountCacheMisses(&m_Indices[IndexOfTriangle * 3]);
+
+                if (IndexOfTriangle + 1 < End && NumberOfMisses <= Threshold * (IndexOfTriangle + 1 - StartOfCluster))
+                {
+                    m_Clusters.push_back({ StartOfCluster, IndexOfTriangle + 1, glm::vec3(0.0f), glm::vec3(0.0f), 0.0f });
+
+                    StartOfCluster = IndexOfTriangle + 1;
+                    NumberOfMisses = 0;
+
+                    FlushCache();
+                }
+            }
+
+            m_Clusters.push_back({ StartOfCluster, End, glm::vec3(0.0f), glm::vec3(0.0f), 0.0f });
+        }
+
+        // -----------------------------------------------------------------------------
+        // Clusters far out in the direction they face are drawn first: on
+        // a convex mesh those occlude the others from most views.
+        // -----------------------------------------------------------------------------
+        glm::vec3 CenterOfMesh(0.0f);
+
+        float AreaOfMesh = 0.0f;
+
+        for (SCluster& rCluster : m_Clusters)
+        {
+            glm::vec3 Normal(0.0f);
+            glm::vec3 Center(0.0f);
+
+            float Area = 0.0f;
+
+            for (unsigned int IndexOfTriangle = rCluster.m_Start; IndexOfTriangle < rCluster.m_End; ++IndexOfTriangle)
+            {
+                const glm::vec3& rA = GetPosition(m_Indices[IndexOfTriangle * 3 + 0]);
+                const glm::vec3& rB = GetPosition(m_Indices[IndexOfTriangle * 3 + 1]);
+                const glm::vec3& rC = GetPosition(m_Indices[IndexOfTriangle * 3 + 2]);
+
+                const glm::vec3 Cross = glm::cross(rB - rA, rC - rA);
+
+                const float AreaOfTriangle = glm::length(Cross);
+
+                Normal += Cross;
+                Center += (rA + rB + rC) * (AreaOfTriangle / 3.0f);
+                Area   += AreaOfTriangle;
+            }
+
+            const float LengthOfNormal = glm::length(Normal);
+
+            rCluster.m_Center = Area > 0.0f ? Center / Area : glm::vec3(0.0f);
+            rCluster.m_Normal = LengthOfNormal > 0.0f ? Normal / LengthOfNormal : glm::vec3(0.0f);
+
+            CenterOfMesh += Center;
+            AreaOfMesh   += Area;
+        }
+
+        if (AreaOfMesh > 0.0f) CenterOfMesh /= AreaOfMesh;
+
+        for (SCluster& rCluster : m_Clusters)
+        {
+            rCluster.m_SortKey = glm::dot(rCluster.m_Center - CenterOfMesh, rCluster.m_Normal);
+        }
+
+        std::stable_sort(m_Clusters.begin(), m_Clusters.end(), [](const SCluster& _rLeft, const SCluster& _rRight)
+        {
+            return _rLeft.m_SortKey > _rRight.m_SortKey;
+        });
+
+        unsigned int IndexOfOutput = 0;
+
+        for (const SCluster& rCluster : m_Clusters)
+        {
+            const unsigned int NumberOfIndices = (rCluster.m_End - rCluster.m_Start) * 3;
+
+            std::copy(&m_Indices[rCluster.m_Start * 3], &m_Indices[rCluster.m_Start * 3] + NumberOfIndices, _pResult + IndexOfOutput);
+
+            IndexOfOutput += NumberOfIndices;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    unsigned int CMeshOptimizer::OptimizeVertexFetch(void* _pVertices, unsigned int _NumberOfVertices, unsigned int _Stride, unsigned int* _pIndices, unsigned int _NumberOfIndices)
+    {
+        assert(_pVertices != nullptr && _pIndices != nullptr);
+
+        unsigned int NumberOfVertices = 0;
+
+        m_Remap.assign(_NumberOfVertices, s_InvalidIndex);
+
+        for (unsigned int IndexOfIndex = 0; IndexOfIndex < _NumberOfIndices; ++IndexOfIndex)
+        {
+            unsigned int& rIndex = _pIndices[IndexOfIndex];
+
+            if (m_Remap[rIndex] == s_InvalidIndex) m_Remap[rIndex] = NumberOfVertices ++;
+
+            rIndex = m_Remap[rIndex];
+        }
+
+        char* pVertices = static_cast<char*>(_pVertices);
+
+        m_Vertices.assign(pVertices, pVertices + static_cast<size_t>(_NumberOfVertices) * _Stride);
+
+        for (unsigned int IndexOfVertex = 0; IndexOfVertex < _NumberOfVertices; ++IndexOfVertex)
+        {
+            if (m_Remap[IndexOfVertex] == s_InvalidIndex) continue;
+
+            std::memcpy(pVertices + static_cast<size_t>(m_Remap[IndexOfVertex]) * _Stride, &m_Vertices[static_cast<size_t>(IndexOfVertex) * _Stride], _Stride);
+        }
+
+        return NumberOfVertices;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CMeshOptimizer::SStatistics CMeshOptimizer::AnalyzeVertexCache(const unsigned int* _pIndices, unsigned int _NumberOfIndices, unsigned int _NumberOfVertices)
+    {
+        assert(_pIndices != nullptr && _NumberOfIndices % 3 == 0);
+
+        const unsigned int NumberOfTriangles = _NumberOfIndices / 3;
+
+        unsigned int NumberOfMisses = 0;
+
+        ResetCache(_NumberOfVertices);
+
+        for (unsigned int IndexOfTriangle = 0; IndexOfTriangle < NumberOfTriangles; ++IndexOfTriangle)
+        {
+            NumberOfMisses += CountCacheMisses(_pIndices + IndexOfTriangle * 3);
+        }
+
+        // -----------------------------------------------------------------------------
+        // Vertices that were never loaded still have no timestamp
+        // -----------------------------------------------------------------------------
+        const unsigned int NumberOfUsedVertices = static_cast<unsigned int>(_NumberOfVertices - std::count(m_CacheTimestamps.begin(), m_CacheTimestamps.end(), 0u));
+
+        SStatistics Statistics;
+
+        Statistics.m_ACMR = NumberOfTriangles    > 0 ? static_cast<float>(NumberOfMisses) / NumberOfTriangles    : 0.0f;
+        Statistics.m_ATVR = NumberOfUsedVertices > 0 ? static_cast<float>(NumberOfMisses) / NumberOfUsedVertices : 0.0f;
+
+        return Statistics;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMeshOptimizer::BuildAdjacency(const unsigned int* _pIndices, unsigned int _NumberOfIndices, unsigned int _NumberOfVertices)
+    {
+        m_NumberOfLiveTriangles.assign(_NumberOfVertices, 0);
+
+        for (unsigned int IndexOfIndex = 0; IndexOfIndex < _NumberOfIndices; ++IndexOfIndex)
+        {
+            assert(_pIndices[IndexOfIndex] < _NumberOfVertices);
+
+            ++ m_NumberOfLiveTriangles[_pIndices[IndexOfIndex]];
+        }
+
+        m_TriangleOffsets.resize(_NumberOfVertices + 1);
+
+        unsigned int Offset = 0;
+
+        for (unsigned int IndexOfVertex = 0; IndexOfVertex < _NumberOfVertices; ++IndexOfVertex)
+        {
+            m_TriangleOffsets[IndexOfVertex] = Offset;
+
+            Offset += m_NumberOfLiveTriangles[IndexOfVertex];
+
+            m_NumberOfLiveTriangles[IndexOfVertex] = 0;
+        }
+
+        m_TriangleOffsets[_NumberOfVertices] = Offset;
+
+        // -----------------------------------------------------------------------------
+        // The counts are built up again while the triangles are filled in
+        // -----------------------------------------------------------------------------
+        m_Triangles.resize(_NumberOfIndices);
+
+        for (unsigned int IndexOfIndex = 0; IndexOfIndex < _NumberOfIndices; ++IndexOfIndex)
+        {
+            const unsigned int Vertex = _pIndices[IndexOfIndex];
+
+            m_Triangles[m_TriangleOffsets[Vertex] + m_NumberOfLiveTriangles[Vertex] ++] = IndexOfIndex / 3;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // Vertices in the cache score by their position, the most recent triangle
+    // a bit less than the entries behind it; vertices with few remaining
+    // triangles are boosted so that no single triangles are left behind.
+    // -----------------------------------------------------------------------------
+    float CMeshOptimizer::GetVertexScore(unsigned int _Vertex) const
+    {
+        const unsigned int NumberOfLiveTriangles = m_NumberOfLiveTriangles[_Vertex];
+
+        if (NumberOfLiveTriangles == 0) return -1.0f;
+
+        const unsigned int CachePosition = m_CachePositions[_Vertex];
+
+        const float Score = CachePosition != s_InvalidIndex ? s_ScoreTables.m_ScoreOfCachePosition[CachePosition] : 0.0f;
+
+        return Score + s_ScoreTables.m_ScoreOfValence[std::min(NumberOfLiveTriangles, s_MaxValence)];
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMeshOptimizer::ResetCache(unsigned int _NumberOfVertices)
+    {
+        m_CacheTimestamps.assign(_NumberOfVertices, 0);
+
+        m_CacheTimestamp = s_CacheSize + 1;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Every entry gets too old at once
+    // -----------------------------------------------------------------------------
+    void CMeshOptimizer::FlushCache()
+    {
+        m_CacheTimestamp += s_CacheSize + 1;
+    }
+
+    // -----------------------------------------------------------------------------
+    // A vertex is in the FIFO as long as less than the size of it were loaded
+    // after it; hits do not change the order.
+    // -----------------------------------------------------------------------------
+    unsigned int CMeshOptimizer::CountCacheMisses(const unsigned int* _pTriangle)
+    {
+        unsigned int NumberOfMisses = 0;
+
+        for (unsigned int IndexOfCorner = 0; IndexOfCorner < 3; ++IndexOfCorner)
+        {
+            const unsigned int Vertex = _pTriangle[IndexOfCorner];
+
+            if (m_CacheTimestamp - m_CacheTimestamps[Vertex] > s_CacheSize)
+            {
+                m_CacheTimestamps[Vertex] = m_CacheTimestamp ++;
+
+                ++ NumberOfMisses;
+            }
+        }
+
+        return NumberOfMisses;
+    }
+} // namespace Gfx
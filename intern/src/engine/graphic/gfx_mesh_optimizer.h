@@ -0,0 +1,108 @@
+
+#pragma once
+
+#include "engine/engine_config.h"
+
+#include "base/base_include_glm.h"
+
+#include <vector>
+
+namespace Gfx
+{
+    // -----------------------------------------------------------------------------
+    // CPU side reordering of indexed triangle lists for the GPU: triangles
+    // for the post transform vertex cache and against overdraw, vertices in
+    // the order they are fetched. The passes only change the order, never
+    // the geometry, and the result depends on nothing but the input.
+    // -----------------------------------------------------------------------------
+    class ENGINE_API CMeshOptimizer
+    {
+    public:
+
+        struct SStatistics
+        {
+            float m_ACMR;                       //< Average cache miss ratio: transformed vertices per triangle (0.5 .. 3)
+            float m_ATVR;                       //< Average transform to vertex ratio: transformed vertices per used vertex (1 ..)
+        };
+
+    public:
+
+        static const unsigned int s_CacheSize = 16;     //< FIFO entries of the cache model used by the analysis and overdraw
+
+    public:
+
+        // -----------------------------------------------------------------------------
+        // Orders the triangles so that their vertices are still in the cache
+        // (Forsyth's linear speed optimization). The result may be the input.
+        // -----------------------------------------------------------------------------
+        void OptimizeVertexCache(const unsigned int* _pIndices, unsigned int _NumberOfIndices, unsigned int _NumberOfVertices, unsigned int* _pResult);
+
+        // -----------------------------------------------------------------------------
+        // Splits cache optimized triangles into clusters wherever the cache
+        // misses stay below the threshold (e.g. 1.05 of the ACMR) and draws
+        // the clusters that face away from the center first (Sander et al.).
+        // The positions are read as three floats every stride bytes; the
+        // result may be the input.
+        // -----------------------------------------------------------------------------
+        void OptimizeOverdraw(const unsigned int* _pIndices, unsigned int _NumberOfIndices, const float* _pPositions, unsigned int _NumberOfVertices, unsigned int _Stride, float _Threshold, unsigned int* _pResult);
+
+        // -----------------------------------------------------------------------------
+        // Moves the vertices in the order of their first use and remaps the
+        // indices in place. Unused vertices are dropped; returns the number
+        // of vertices that are left.
+        // -----------------------------------------------------------------------------
+        unsigned int OptimizeVertexFetch(void* _pVertices, unsigned int _NumberOfVertices, unsigned int _Stride, unsigned int* _pIndices, unsigned int _NumberOfIndices);
+
+        SStatistics AnalyzeVertexCache(const unsigned int* _pIndices, unsigned int _NumberOfIndices, unsigned int _NumberOfVertices);
+
+    public:
+
+        CMeshOptimizer();
+       ~CMeshOptimizer();
+
+    private:
+
+        struct SCluster
+        {
+            unsigned int m_Start;               //< First triangle
+            unsigned int m_End;
+            glm::vec3    m_Center;              //< Weighted by the area of the triangles
+            glm::vec3    m_Normal;
+            float        m_SortKey;
+        };
+
+        using CIndices  = std::vector<unsigned int>;
+        using CScores   = std::vector<float>;
+        using CFlags    = std::vector<unsigned char>;
+        using CClusters = std::vector<SCluster>;
+        using CBytes    = std::vector<char>;
+
+    private:
+
+        void BuildAdjacency(const unsigned int* _pIndices, unsigned int _NumberOfIndices, unsigned int _NumberOfVertices);
+
+        float GetVertexScore(unsigned int _Vertex) const;
+
+        void ResetCache(unsigned int _NumberOfVertices);
+        void FlushCache();
+        unsigned int CountCacheMisses(const unsigned int* _pTriangle);
+
+    private:
+
+        CIndices     m_Indices;                 //< Copy of the input, so the result may overwrite it
+        CIndices     m_TriangleOffsets;         //< Triangles around every vertex
+        CIndices     m_Triangles;
+        CIndices     m_NumberOfLiveTriangles;
+        CIndices     m_CachePositions;
+        CScores      m_VertexScores;
+        CFlags       m_IsEmitted;
+        CIndices     m_Cache;
+        CIndices     m_NextCache;
+        CIndices     m_CacheTimestamps;         //< Of the FIFO cache model
+        unsigned int m_CacheTimestamp;
+        CIndices     m_Boundaries;
+        CClusters    m_Clusters;
+        CIndices     m_Remap;
+        CBytes       m_Vertices;
+    };
+} // namespace Gfx
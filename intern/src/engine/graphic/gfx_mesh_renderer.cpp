@@ -5,11 +5,14 @@
 #include "base/base_uncopyable.h"
 
 #include "engine/core/core_console.h"
+#include "engine/core/core_memory.h"
+#include "engine/core/core_program_parameters.h"
 
 #include "engine/data/data_component.h"
 #include "engine/data/data_component_facet.h"
 #include "engine/data/data_component_manager.h"
 #include "engine/data/data_entity.h"
+#include "engine/data/data_entity_manager.h"
 #include "engine/data/data_light_probe_component.h"
 #include "engine/data/data_map.h"
 #include "engine/data/data_material_component.h"
@@ -43,7 +46,9 @@
 
 #include <algorithm>
 #include <array>
-#include <vector>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
 
 using namespace Gfx;
 
@@ -121,7 +126,7 @@ namespace
         {
             unsigned int     m_SurfaceAttributes;
             Base::ID         m_EntityID;
-            CSurfacePtr      m_SurfacePtr;
+            CSurface*        m_pSurface;                    //< Owned by the LOD for the whole frame
             const CMaterial* m_SurfaceMaterialPtr;
             glm::mat4        m_ModelMatrix;
         };
@@ -133,9 +138,64 @@ namespace
             CTexturePtr m_DiffuseTexturePtr;
         };
 
+        // -----------------------------------------------------------------------------
+        // Jobs of the current frame in the frame arena of the engine. They are
+        // built by Update() and drawn by the passes of the same frame, so
+        // nothing has to be released.
+        // -----------------------------------------------------------------------------
+        class CRenderJobs
+        {
+        public:
+
+            CRenderJobs()
+                : m_pJobs       (nullptr)
+                , m_NumberOfJobs(0)
+            {
+            }
+
+        public:
+
+            void Allocate(Base::Size _MaxNumberOfJobs)
+            {
+                m_pJobs        = Core::Memory::GetFrameArena().AllocateArray<SRenderJob>(_MaxNumberOfJobs);
+                m_NumberOfJobs = 0;
+            }
+
+            void Clear()
+            {
+                m_pJobs        = nullptr;
+                m_NumberOfJobs = 0;
+            }
+
+            void PushBack(const SRenderJob& _rJob)
+            {
+                new (m_pJobs + m_NumberOfJobs) SRenderJob(_rJob);
+
+                ++m_NumberOfJobs;
+            }
+
+            bool IsEmpty() const
+            {
+                return m_NumberOfJobs == 0;
+            }
+
+            SRenderJob* begin() { return m_pJobs; }
+            SRenderJob* end()   { return m_pJobs + m_NumberOfJobs; }
+
+            const SRenderJob* begin() const { return m_pJobs; }
+            const SRenderJob* end()   const { return m_pJobs + m_NumberOfJobs; }
+
+        private:
+
+            SRenderJob* m_pJobs;
+            Base::Size  m_NumberOfJobs;
+        };
+
+        static_assert(std::is_trivially_destructible<SRenderJob>::value, "Render jobs are released with the frame arena");
+
     private:
 
-        using CRenderJobs = std::vector<SRenderJob>;
+        using CLODOfEntities = std::unordered_map<Base::ID, unsigned int>;
 
     private:
 
@@ -149,10 +209,17 @@ namespace
         CRenderJobs       m_ForwardRenderJobs;
         CRenderJobs       m_HitproxyRenderJobs;
         SLightJob         m_ForwardLightTextures;
+        CLODOfEntities    m_LODOfEntities;                  //< LOD of the last frame
+        float             m_MaxLODErrorInPixels;
+
+        Dt::CEntityManager::CEntityDelegate::HandleType m_OnDirtyEntityDelegate;
 
     private:
 
+        void OnDirtyEntity(Dt::CEntity* _pEntity);
+
         void BuildRenderJobs();
+        unsigned int SelectLOD(const CMesh& _rMesh, const Dt::CEntity& _rEntity, const glm::vec3& _rCameraPosition, float _PixelsPerUnit);
         void UpdateLightProperties();
     };
 } // namespace
@@ -168,14 +235,12 @@ namespace
         , m_HitProxyShaderPtr       ()
         , m_DeferredRenderJobs      ()
         , m_ForwardRenderJobs       ()
+        , m_HitproxyRenderJobs      ()
         , m_ForwardLightTextures    ()
+        , m_LODOfEntities           ()
+        , m_MaxLODErrorInPixels     (0.0f)
+        , m_OnDirtyEntityDelegate   ()
     {
-        // -----------------------------------------------------------------------------
-        // Reserve some jobs
-        // -----------------------------------------------------------------------------
-        m_DeferredRenderJobs.reserve(256);
-        m_ForwardRenderJobs.reserve(32);
-        m_HitproxyRenderJobs.reserve(512);
     }
 
     // -----------------------------------------------------------------------------
@@ -189,7 +254,9 @@ namespace
 
     void CGfxMeshRenderer::OnStart()
     {
+        m_MaxLODErrorInPixels = Core::CProgramParameters::GetInstance().Get("graphics:lod:max_error_in_pixels", 1.0f);
 
+        m_OnDirtyEntityDelegate = Dt::CEntityManager::GetInstance().RegisterDirtyEntityHandler(std::bind(&CGfxMeshRenderer::OnDirtyEntity, this, std::placeholders::_1));
     }
 
     // -----------------------------------------------------------------------------
@@ -203,33 +270,9 @@ namespace
         m_LightPropertiesBufferPtr = nullptr;
         m_HitProxyShaderPtr        = nullptr;
 
-        // -----------------------------------------------------------------------------
-        // Iterate throw render jobs to release managed pointer
-        // -----------------------------------------------------------------------------
-        for (auto& rCurrentRenderJob : m_DeferredRenderJobs)
-        {
-            rCurrentRenderJob.m_SurfacePtr = nullptr;
-        }
-
-        m_DeferredRenderJobs.clear();
-
-        // -----------------------------------------------------------------------------
-
-        for (auto& rCurrentRenderJob : m_ForwardRenderJobs)
-        {
-            rCurrentRenderJob.m_SurfacePtr = nullptr;
-        }
-
-        m_ForwardRenderJobs.clear();
-
-        // -----------------------------------------------------------------------------
-
-        for (auto& rCurrentRenderJob : m_HitproxyRenderJobs)
-        {
-            rCurrentRenderJob.m_SurfacePtr = nullptr;
-        }
-
-        m_HitproxyRenderJobs.clear();
+        m_DeferredRenderJobs.Clear();
+        m_ForwardRenderJobs .Clear();
+        m_HitproxyRenderJobs.Clear();
 
         // -----------------------------------------------------------------------------
 
@@ -240,6 +283,10 @@ namespace
 
         m_ForwardLightTextures.m_DiffuseTexturePtr  = nullptr;
         m_ForwardLightTextures.m_SpecularTexturePtr = nullptr;
+
+        m_LODOfEntities.clear();
+
+        m_OnDirtyEntityDelegate = nullptr;
     }
 
     // -----------------------------------------------------------------------------
@@ -388,7 +435,20 @@ namespace
 
     void CGfxMeshRenderer::OnUnloadMap()
     {
+        m_LODOfEntities.clear();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CGfxMeshRenderer::OnDirtyEntity(Dt::CEntity* _pEntity)
+    {
+        // -----------------------------------------------------------------------------
+        // A removed entity is not drawn anymore and the ID of a destroyed one
+        // may be reused, so neither keeps the LOD of its last frame.
+        // -----------------------------------------------------------------------------
+        if ((_pEntity->GetDirtyFlags() & (Dt::CEntity::DirtyRemove | Dt::CEntity::DirtyDestroy)) == 0) return;
 
+        m_LODOfEntities.erase(_pEntity->GetID());
     }
 
     // -----------------------------------------------------------------------------
@@ -412,7 +472,7 @@ namespace
 
     void CGfxMeshRenderer::Render()
     {
-        if (m_DeferredRenderJobs.empty()) return;
+        if (m_DeferredRenderJobs.IsEmpty()) return;
 
         Performance::BeginEvent("Meshes");
 
@@ -434,7 +494,7 @@ namespace
         // -----------------------------------------------------------------------------
         for (const auto& rCurrentRenderJob : m_DeferredRenderJobs)
         {
-            CSurfacePtr SurfacePtr = rCurrentRenderJob.m_SurfacePtr;
+            CSurfacePtr SurfacePtr = rCurrentRenderJob.m_pSurface;
 
             const CMaterial* pMaterial = rCurrentRenderJob.m_SurfaceMaterialPtr;
 
@@ -535,7 +595,7 @@ namespace
 
     void CGfxMeshRenderer::RenderForward()
     {
-        if (m_ForwardRenderJobs.empty()) return;
+        if (m_ForwardRenderJobs.IsEmpty()) return;
 
         Performance::BeginEvent("Transparent Meshes");
 
@@ -623,7 +683,7 @@ namespace
             // -----------------------------------------------------------------------------
             // Surface
             // -----------------------------------------------------------------------------
-            CSurfacePtr SurfacePtr = rRenderJob.m_SurfacePtr;
+            CSurfacePtr SurfacePtr = rRenderJob.m_pSurface;
 
             // -----------------------------------------------------------------------------
             // Set shader
@@ -701,7 +761,7 @@ namespace
 
     void CGfxMeshRenderer::RenderHitProxy()
     {
-        if (m_DeferredRenderJobs.empty()) return;
+        if (m_DeferredRenderJobs.IsEmpty()) return;
 
         Performance::BeginEvent("Mesh Hit Proxy");
 
@@ -711,7 +771,7 @@ namespace
         {
             for (auto CurrentRenderJob : _ListOfJobs)
             {
-                CSurfacePtr  SurfacePtr = CurrentRenderJob.m_SurfacePtr;
+                CSurfacePtr  SurfacePtr = CurrentRenderJob.m_pSurface;
 
                 // -----------------------------------------------------------------------------
                 // Upload data to buffer
@@ -792,15 +852,23 @@ namespace
         } DistanceSortObject;
 
         // -----------------------------------------------------------------------------
-        // Clear current render jobs
+        // Pixels covered by one unit at a distance of one unit in the main view
         // -----------------------------------------------------------------------------
-        m_DeferredRenderJobs.clear();
+        CCameraPtr MainCameraPtr = ViewManager::GetMainCamera();
 
-        m_ForwardRenderJobs.clear();
+        const glm::vec3 CameraPosition = MainCameraPtr->GetView()->GetPosition();
 
-        m_HitproxyRenderJobs.clear();
+        const float PixelsPerUnit = MainCameraPtr->GetProjectionMatrix()[1][1] * 0.5f * static_cast<float>(Main::GetActiveWindowSize()[1]);
 
-        auto DataMeshComponents = Dt::CComponentManager::GetInstance().GetComponents<Dt::CMeshComponent>();
+        const auto& DataMeshComponents = Dt::CComponentManager::GetInstance().GetComponents<Dt::CMeshComponent>();
+
+        // -----------------------------------------------------------------------------
+        // Every mesh component adds at most one job to each list; the memory
+        // of the last frame was released by the engine.
+        // -----------------------------------------------------------------------------
+        m_DeferredRenderJobs.Allocate(DataMeshComponents.size());
+        m_ForwardRenderJobs .Allocate(DataMeshComponents.size());
+        m_HitproxyRenderJobs.Allocate(DataMeshComponents.size());
 
         for (auto Component : DataMeshComponents)
         {
@@ -819,7 +887,9 @@ namespace
                 // -----------------------------------------------------------------------------
                 if (pGfxComponent->GetLOD(0) == nullptr) continue;
 
-                CSurfacePtr SurfacePtr = pGfxComponent->GetLOD(0)->GetSurface();
+                const unsigned int IndexOfLOD = SelectLOD(*pGfxComponent, rCurrentEntity, CameraPosition, PixelsPerUnit);
+
+                CSurfacePtr SurfacePtr = pGfxComponent->GetLOD(IndexOfLOD)->GetSurface();
 
                 if (SurfacePtr == nullptr) continue;
 
@@ -844,17 +914,17 @@ namespace
 
                 NewRenderJob.m_SurfaceAttributes  = SurfacePtr->GetKey().m_Key;
                 NewRenderJob.m_EntityID           = rCurrentEntity.GetID();
-                NewRenderJob.m_SurfacePtr         = SurfacePtr;
+                NewRenderJob.m_pSurface           = SurfacePtr.GetPtr();
                 NewRenderJob.m_SurfaceMaterialPtr = pMaterial;
                 NewRenderJob.m_ModelMatrix        = rCurrentEntity.GetTransformationFacet()->GetWorldMatrix();
 
                 if (!pMaterial->HasRefraction())
                 {
-                    if (pMaterial->HasAlpha()) m_ForwardRenderJobs.push_back(NewRenderJob);
-                    else                       m_DeferredRenderJobs.push_back(NewRenderJob);
+                    if (pMaterial->HasAlpha()) m_ForwardRenderJobs.PushBack(NewRenderJob);
+                    else                       m_DeferredRenderJobs.PushBack(NewRenderJob);
                 }
 
-                m_HitproxyRenderJobs.push_back(NewRenderJob);
+                m_HitproxyRenderJobs.PushBack(NewRenderJob);
             }
         }
 
@@ -868,6 +938,33 @@ namespace
 
     // -----------------------------------------------------------------------------
 
+    unsigned int CGfxMeshRenderer::SelectLOD(const CMesh& _rMesh, const Dt::CEntity& _rEntity, const glm::vec3& _rCameraPosition, float _PixelsPerUnit)
+    {
+        if (_rMesh.GetNumberOfLODs() < 2) return 0;
+
+        // -----------------------------------------------------------------------------
+        // The error is measured at the closest point of the bounding sphere;
+        // from inside of the sphere the first LOD is drawn.
+        // -----------------------------------------------------------------------------
+        const glm::mat4& rWorldMatrix = _rEntity.GetTransformationFacet()->GetWorldMatrix();
+
+        const Base::AABB3Float AABB = _rMesh.GetAABB();
+
+        const float Scale = glm::max(glm::max(glm::length(glm::vec3(rWorldMatrix[0])), glm::length(glm::vec3(rWorldMatrix[1]))), glm::length(glm::vec3(rWorldMatrix[2])));
+
+        const glm::vec3 Center = glm::vec3(rWorldMatrix * glm::vec4((AABB.GetMin() + AABB.GetMax()) * 0.5f, 1.0f));
+
+        const float Distance = glm::distance(_rCameraPosition, Center) - 0.5f * glm::length(AABB.GetMax() - AABB.GetMin()) * Scale;
+
+        unsigned int& rLOD = m_LODOfEntities[_rEntity.GetID()];
+
+        rLOD = Distance > 0.0f ? _rMesh.SelectLOD(Scale * _PixelsPerUnit / Distance, m_MaxLODErrorInPixels, rLOD) : 0;
+
+        return rLOD;
+    }
+
+    // -----------------------------------------------------------------------------
+
     void CGfxMeshRenderer::UpdateLightProperties()
     {
         SLightProperties LightProperties[s_MaxNumberOfLights];
@@ -958,7 +1055,7 @@ namespace
             {
                 assert(pGfxComponent->GetCamera().IsValid());
 
-                LightProperties[IndexOfLight].m_LightViewProjection = pGfxComponent->GetCamera()->GetViewProjectionMatrix();
+                LightProperties[IndexOfLight].m_LightViewProjection = pGfxComponent->GetShadowMatrix();
             }
 
             // -----------------------------------------------------------------------------
@@ -0,0 +1,585 @@
+#include "engine/engine_precompiled.h"
+
+#include "engine/graphic/gfx_mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const unsigned int s_InvalidIndex = ~0u;
+
+    // -----------------------------------------------------------------------------
+    // Open edges add a plane perpendicular to their triangle, weighted higher
+    // than the surface so the outline of a mesh is kept as long as possible.
+    // -----------------------------------------------------------------------------
+    const float s_BorderWeight = 10.0f;
+
+    // -----------------------------------------------------------------------------
+    // A collapse is refused if a triangle turns by more than ~80 degrees
+    // -----------------------------------------------------------------------------
+    const float s_MinNormalCosine = 0.15f;
+} // namespace
+
+namespace
+{
+    template<typename TQuadric>
+    void AddPlane(TQuadric& _rQuadric, const glm::vec3& _rNormal, float _Distance, float _Weight)
+    {
+        _rQuadric.m_A00 += _Weight * _rNormal.x * _rNormal.x;
+        _rQuadric.m_A11 += _Weight * _rNormal.y * _rNormal.y;
+        _rQuadric.m_A22 += _Weight * _rNormal.z * _rNormal.z;
+        _rQuadric.m_A01 += _Weight * _rNormal.x * _rNormal.y;
+        _rQuadric.m_A02 += _Weight * _rNormal.x * _rNormal.z;
+        _rQuadric.m_A12 += _Weight * _rNormal.y * _rNormal.z;
+        _rQuadric.m_B0  += _Weight * _rNormal.x * _Distance;
+        _rQuadric.m_B1  += _Weight * _rNormal.y * _Distance;
+        _rQuadric.m_B2  += _Weight * _rNormal.z * _Distance;
+        _rQuadric.m_C   += _Weight * _Distance * _Distance;
+
+        _rQuadric.m_Weight += _Weight;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<typename TQuadric>
+    void AddQuadric(TQuadric& _rQuadric, const TQuadric& _rOther)
+    {
+        _rQuadric.m_A00 += _rOther.m_A00;
+        _rQuadric.m_A11 += _rOther.m_A11;
+        _rQuadric.m_A22 += _rOther.m_A22;
+        _rQuadric.m_A01 += _rOther.m_A01;
+        _rQuadric.m_A02 += _rOther.m_A02;
+        _rQuadric.m_A12 += _rOther.m_A12;
+        _rQuadric.m_B0  += _rOther.m_B0;
+        _rQuadric.m_B1  += _rOther.m_B1;
+        _rQuadric.m_B2  += _rOther.m_B2;
+        _rQuadric.m_C   += _rOther.m_C;
+
+        _rQuadric.m_Weight += _rOther.m_Weight;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Weighted mean of the squared distances to all planes of the quadric
+    // -----------------------------------------------------------------------------
+    template<typename TQuadric>
+    float GetQuadricError(const TQuadric& _rQuadric, const glm::vec3& _rPosition)
+    {
+        const float X = _rPosition.x;
+        const float Y = _rPosition.y;
+        const float Z = _rPosition.z;
+
+        float Error = _rQuadric.m_C;
+
+        Error += 2.0f * (_rQuadric.m_B0 * X + _rQuadric.m_B1 * Y + _rQuadric.m_B2 * Z);
+        Error += _rQuadric.m_A00 * X * X + _rQuadric.m_A11 * Y * Y + _rQuadric.m_A22 * Z * Z;
+        Error += 2.0f * (_rQuadric.m_A01 * X * Y + _rQuadric.m_A02 * X * Z + _rQuadric.m_A12 * Y * Z);
+
+        return _rQuadric.m_Weight > 0.0f ? std::abs(Error) / _rQuadric.m_Weight : 0.0f;
+    }
+} // namespace
+
+namespace Gfx
+{
+    CMeshSimplifier::CMeshSimplifier()
+        : m_Positions                 ()
+        , m_PositionOfVertex          ()
+        , m_Indices                   ()
+        , m_TriangleOffsets           ()
+        , m_Triangles                 ()
+        , m_Kinds                     ()
+        , m_BorderNext                ()
+        , m_BorderPrevious            ()
+        , m_Quadrics                  ()
+        , m_Collapses                 ()
+        , m_Remap                     ()
+        , m_IsTouched                 ()
+        , m_SortedVertices            ()
+        , m_NumberOfVerticesOfPosition()
+        , m_Error                     (0.0f)
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CMeshSimplifier::~CMeshSimplifier()
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CMeshSimplifier::SResult CMeshSimplifier::Simplify(const float* _pPositions, unsigned int _NumberOfVertices, unsigned int _Stride, const unsigned int* _pIndices, unsigned int _NumberOfIndices, unsigned int _TargetNumberOfIndices, float _MaxError, unsigned int* _pResult)
+    {
+        assert(_pPositions != nullptr && _pIndices != nullptr && _pResult != nullptr);
+        assert(_NumberOfIndices % 3 == 0 && _Stride >= 3 * sizeof(float));
+
+        SResult Result = { _NumberOfIndices, 0.0f };
+
+        m_Indices.assign(_pIndices, _pIndices + _NumberOfIndices);
+
+        // -----------------------------------------------------------------------------
+        // Errors are computed on positions scaled into the unit cube
+        // -----------------------------------------------------------------------------
+        const float Extent = WeldPositions(_pPositions, _NumberOfVertices, _Stride);
+
+        if (Extent > 0.0f)
+        {
+            const float MaxError = _MaxError / Extent;
+
+            m_Error = 0.0f;
+
+            m_Remap.resize(_NumberOfVertices);
+
+            for (unsigned int IndexOfVertex = 0; IndexOfVertex < _NumberOfVertices; ++IndexOfVertex) m_Remap[IndexOfVertex] = IndexOfVertex;
+
+            RemoveDegenerateTriangles();
+
+            BuildAdjacency();
+
+            ClassifyVertices();
+
+            ComputeQuadrics();
+
+            // -----------------------------------------------------------------------------
+            // Every pass collapses independent edges (no shared triangles), so
+            // the adjacency stays valid until the pass is done.
+            // -----------------------------------------------------------------------------
+            while (m_Indices.size() > _TargetNumberOfIndices)
+            {
+                RankCollapses();
+
+                const unsigned int NumberOfTrianglesToRemove = (static_cast<unsigned int>(m_Indices.size()) - _TargetNumberOfIndices + 2) / 3;
+
+                if (PerformCollapses(NumberOfTrianglesToRemove, MaxError * MaxError) == 0) break;
+
+                RemoveDegenerateTriangles();
+
+                BuildAdjacency();
+
+                ClassifyVertices();
+            }
+
+            Result.m_NumberOfIndices = static_cast<unsigned int>(m_Indices.size());
+            Result.m_Error           = std::sqrt(m_Error) * Extent;
+        }
+
+        std::copy(m_Indices.begin(), m_Indices.end(), _pResult);
+
+        return Result;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    float CMeshSimplifier::WeldPositions(const float* _pPositions, unsigned int _NumberOfVertices, unsigned int _Stride)
+    {
+        auto GetPosition = [&](unsigned int _Index)
+        {
+            const float* pPosition = reinterpret_cast<const float*>(reinterpret_cast<const char*>(_pPositions) + static_cast<Base::Size>(_Index) * _Stride);
+
+            return glm::vec3(pPosition[0], pPosition[1], pPosition[2]);
+        };
+
+        // -----------------------------------------------------------------------------
+        // Vertices with the same position share one position in the topology
+        // -----------------------------------------------------------------------------
+        m_SortedVertices.resize(_NumberOfVertices);
+
+        for (unsigned int IndexOfVertex = 0; IndexOfVertex < _NumberOfVertices; ++IndexOfVertex) m_SortedVertices[IndexOfVertex] = IndexOfVertex;
+
+        std::sort(m_SortedVertices.begin(), m_SortedVertices.end(), [&](unsigned int _Left, unsigned int _Right)
+        {
+            const glm::vec3 Left  = GetPosition(_Left);
+            const glm::vec3 Right = GetPosition(_Right);
+
+            if (Left.x != Right.x) return Left.x < Right.x;
+            if (Left.y != Right.y) return Left.y < Right.y;
+
+            return Left.z < Right.z;
+        });
+
+        m_Positions.clear();
+        m_NumberOfVerticesOfPosition.clear();
+
+        m_PositionOfVertex.resize(_NumberOfVertices);
+
+        glm::vec3 Min(0.0f);
+        glm::vec3 Max(0.0f);
+
+        for (unsigned int IndexOfSorted = 0; IndexOfSorted < _NumberOfVertices; ++IndexOfSorted)
+        {
+            const unsigned int IndexOfVertex = m_SortedVertices[IndexOfSorted];
+
+            const glm::vec3 Position = GetPosition(IndexOfVertex);
+
+            if (m_Positions.empty() || m_Positions.back() != Position)
+            {
+                Min = m_Positions.empty() ? Position : glm::min(Min, Position);
+                Max = m_Positions.empty() ? Position : glm::max(Max, Position);
+
+                m_Positions.push_back(Position);
+                m_NumberOfVerticesOfPosition.push_back(0);
+            }
+
+            m_PositionOfVertex[IndexOfVertex] = static_cast<unsigned int>(m_Positions.size()) - 1;
+
+            ++m_NumberOfVerticesOfPosition.back();
+        }
+
+        const float Extent = glm::max(glm::max(Max.x - Min.x, Max.y - Min.y), Max.z - Min.z);
+
+        if (Extent <= 0.0f) return 0.0f;
+
+        for (glm::vec3& rPosition : m_Positions) rPosition = (rPosition - Min) / Extent;
+
+        return Extent;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMeshSimplifier::BuildAdjacency()
+    {
+        const unsigned int NumberOfPositions = static_cast<unsigned int>(m_Positions.size());
+        const unsigned int NumberOfIndices   = static_cast<unsigned int>(m_Indices.size());
+
+        m_TriangleOffsets.assign(NumberOfPositions + 1, 0);
+
+        for (unsigned int Index : m_Indices) ++m_TriangleOffsets[m_PositionOfVertex[Index]];
+
+        for (unsigned int IndexOfPosition = 1; IndexOfPosition < NumberOfPositions; ++IndexOfPosition)
+        {
+            m_TriangleOffsets[IndexOfPosition] += m_TriangleOffsets[IndexOfPosition - 1];
+        }
+
+        m_TriangleOffsets[NumberOfPositions] = NumberOfIndices;
+
+        m_Triangles.resize(NumberOfIndices);
+
+        // -----------------------------------------------------------------------------
+        // The offsets point behind every range; filling from the back moves
+        // them to the first triangle of their position.
+        // -----------------------------------------------------------------------------
+        for (unsigned int IndexOfIndex = NumberOfIndices; IndexOfIndex-- > 0; )
+        {
+            m_Triangles[--m_TriangleOffsets[m_PositionOfVertex[m_Indices[IndexOfIndex]]]] = IndexOfIndex / 3;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMeshSimplifier::ClassifyVertices()
+    {
+        const unsigned int NumberOfPositions = static_cast<unsigned int>(m_Positions.size());
+
+        m_Kinds         .assign(NumberOfPositions, Manifold);
+        m_BorderNext    .assign(NumberOfPositions, s_InvalidIndex);
+        m_BorderPrevious.assign(NumberOfPositions, s_InvalidIndex);
+
+        for (unsigned int IndexOfPosition = 0; IndexOfPosition < NumberOfPositions; ++IndexOfPosition)
+        {
+            if (m_NumberOfVerticesOfPosition[IndexOfPosition] > 1) m_Kinds[IndexOfPosition] = Locked;
+        }
+
+        // -----------------------------------------------------------------------------
+        // An edge without its opposite is open; an edge used twice in the same
+        // direction is non manifold.
+        // -----------------------------------------------------------------------------
+        for (unsigned int IndexOfIndex = 0; IndexOfIndex < m_Indices.size(); ++IndexOfIndex)
+        {
+            const unsigned int IndexOfNext = IndexOfIndex % 3 == 2 ? IndexOfIndex - 2 : IndexOfIndex + 1;
+
+            const unsigned int From = m_PositionOfVertex[m_Indices[IndexOfIndex]];
+            const unsigned int To   = m_PositionOfVertex[m_Indices[IndexOfNext]];
+
+            const unsigned int NumberOfEdges    = CountEdges(From, To);
+            const unsigned int NumberOfOpposite = CountEdges(To, From);
+
+            if (NumberOfEdges > 1 || NumberOfOpposite > 1)
+            {
+                m_Kinds[From] = Locked;
+                m_Kinds[To]   = Locked;
+            }
+            else if (NumberOfOpposite == 0)
+            {
+                if (m_BorderNext[From]   != s_InvalidIndex) m_Kinds[From] = Locked;
+                if (m_BorderPrevious[To] != s_InvalidIndex) m_Kinds[To]   = Locked;
+
+                m_BorderNext[From]   = To;
+                m_BorderPrevious[To] = From;
+            }
+        }
+
+        for (unsigned int IndexOfPosition = 0; IndexOfPosition < NumberOfPositions; ++IndexOfPosition)
+        {
+            if (m_Kinds[IndexOfPosition] == Locked) continue;
+
+            const bool HasNext     = m_BorderNext[IndexOfPosition]     != s_InvalidIndex;
+            const bool HasPrevious = m_BorderPrevious[IndexOfPosition] != s_InvalidIndex;
+
+            if (HasNext && HasPrevious)     m_Kinds[IndexOfPosition] = Border;
+            else if (HasNext || HasPrevious) m_Kinds[IndexOfPosition] = Locked;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMeshSimplifier::ComputeQuadrics()
+    {
+        m_Quadrics.resize(m_Positions.size());
+
+        std::memset(m_Quadrics.data(), 0, sizeof(SQuadric) * m_Quadrics.size());
+
+        for (unsigned int IndexOfIndex = 0; IndexOfIndex < m_Indices.size(); IndexOfIndex += 3)
+        {
+            const unsigned int Positions[3] =
+            {
+                m_PositionOfVertex[m_Indices[IndexOfIndex + 0]],
+                m_PositionOfVertex[m_Indices[IndexOfIndex + 1]],
+                m_PositionOfVertex[m_Indices[IndexOfIndex + 2]],
+            };
+
+            const glm::vec3& rP0 = m_Positions[Positions[0]];
+            const glm::vec3& rP1 = m_Positions[Positions[1]];
+            const glm::vec3& rP2 = m_Positions[Positions[2]];
+
+            glm::vec3 Normal = glm::cross(rP1 - rP0, rP2 - rP0);
+
+            const float Length = glm::length(Normal);
+
+            if (Length == 0.0f) continue;
+
+            Normal /= Length;
+
+            // -----------------------------------------------------------------------------
+            // Plane of the triangle weighted by its area
+            // -----------------------------------------------------------------------------
+            for (unsigned int Position : Positions)
+            {
+                AddPlane(m_Quadrics[Position], Normal, -glm::dot(Normal, rP0), 0.5f * Length);
+            }
+
+            // -----------------------------------------------------------------------------
+            // Planes through the open edges
+            // -----------------------------------------------------------------------------
+            for (unsigned int IndexOfEdge = 0; IndexOfEdge < 3; ++IndexOfEdge)
+            {
+                const unsigned int From = Positions[IndexOfEdge];
+                const unsigned int To   = Positions[(IndexOfEdge + 1) % 3];
+
+                if (CountEdges(To, From) != 0) continue;
+
+                const glm::vec3 Edge = m_Positions[To] - m_Positions[From];
+
+                const float EdgeLength = glm::length(Edge);
+
+                if (EdgeLength == 0.0f) continue;
+
+                const glm::vec3 EdgeNormal = glm::normalize(glm::cross(Edge / EdgeLength, Normal));
+
+                const float Distance = -glm::dot(EdgeNormal, m_Positions[From]);
+
+                AddPlane(m_Quadrics[From], EdgeNormal, Distance, s_BorderWeight * EdgeLength * EdgeLength);
+                AddPlane(m_Quadrics[To]  , EdgeNormal, Distance, s_BorderWeight * EdgeLength * EdgeLength);
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMeshSimplifier::RankCollapses()
+    {
+        m_Collapses.clear();
+
+        for (unsigned int IndexOfIndex = 0; IndexOfIndex < m_Indices.size(); ++IndexOfIndex)
+        {
+            const unsigned int IndexOfNext = IndexOfIndex % 3 == 2 ? IndexOfIndex - 2 : IndexOfIndex + 1;
+
+            const unsigned int Vertex0 = m_Indices[IndexOfIndex];
+            const unsigned int Vertex1 = m_Indices[IndexOfNext];
+
+            const unsigned int Position0 = m_PositionOfVertex[Vertex0];
+            const unsigned int Position1 = m_PositionOfVertex[Vertex1];
+
+            // -----------------------------------------------------------------------------
+            // Inner edges are seen from both triangles; rank them once
+            // -----------------------------------------------------------------------------
+            if (Position0 > Position1 && CountEdges(Position1, Position0) != 0) continue;
+
+            const bool CanCollapse0 = CanCollapse(Position0, Position1);
+            const bool CanCollapse1 = CanCollapse(Position1, Position0);
+
+            if (!CanCollapse0 && !CanCollapse1) continue;
+
+            const float Error0 = CanCollapse0 ? GetQuadricError(m_Quadrics[Position0], m_Positions[Position1]) : 0.0f;
+            const float Error1 = CanCollapse1 ? GetQuadricError(m_Quadrics[Position1], m_Positions[Position0]) : 0.0f;
+
+            if (CanCollapse0 && (!CanCollapse1 || Error0 <= Error1))
+            {
+                m_Collapses.push_back({ Vertex0, Vertex1, Error0 });
+            }
+            else
+            {
+                m_Collapses.push_back({ Vertex1, Vertex0, Error1 });
+            }
+        }
+
+        std::sort(m_Collapses.begin(), m_Collapses.end(), [](const SCollapse& _rLeft, const SCollapse& _rRight)
+        {
+            return _rLeft.m_Error < _rRight.m_Error;
+        });
+    }
+
+    // -----------------------------------------------------------------------------
+
+    unsigned int CMeshSimplifier::PerformCollapses(unsigned int _NumberOfTrianglesToRemove, float _MaxError)
+    {
+        const unsigned int NumberOfVertices = static_cast<unsigned int>(m_PositionOfVertex.size());
+
+        for (unsigned int IndexOfVertex = 0; IndexOfVertex < NumberOfVertices; ++IndexOfVertex) m_Remap[IndexOfVertex] = IndexOfVertex;
+
+        m_IsTouched.assign(m_Positions.size(), 0);
+
+        unsigned int NumberOfCollapses = 0;
+        unsigned int NumberOfTriangles = 0;
+
+        for (const SCollapse& rCollapse : m_Collapses)
+        {
+            if (rCollapse.m_Error > _MaxError || NumberOfTriangles >= _NumberOfTrianglesToRemove) break;
+
+            const unsigned int Source = m_PositionOfVertex[rCollapse.m_Source];
+            const unsigned int Target = m_PositionOfVertex[rCollapse.m_Target];
+
+            // -----------------------------------------------------------------------------
+            // The triangles around the source have to be untouched by this pass,
+            // otherwise the adjacency and the flip test are out of date.
+            // -----------------------------------------------------------------------------
+            bool IsTouched = false;
+
+            for (unsigned int IndexOfTriangle = m_TriangleOffsets[Source]; IndexOfTriangle < m_TriangleOffsets[Source + 1] && !IsTouched; ++IndexOfTriangle)
+            {
+                const unsigned int* pTriangle = &m_Indices[m_Triangles[IndexOfTriangle] * 3];
+
+                IsTouched = m_IsTouched[m_PositionOfVertex[pTriangle[0]]] || m_IsTouched[m_PositionOfVertex[pTriangle[1]]] || m_IsTouched[m_PositionOfVertex[pTriangle[2]]];
+            }
+
+            if (IsTouched || HasFlippedTriangles(Source, Target)) continue;
+
+            for (unsigned int IndexOfTriangle = m_TriangleOffsets[Source]; IndexOfTriangle < m_TriangleOffsets[Source + 1]; ++IndexOfTriangle)
+            {
+                const unsigned int* pTriangle = &m_Indices[m_Triangles[IndexOfTriangle] * 3];
+
+                m_IsTouched[m_PositionOfVertex[pTriangle[0]]] = 1;
+                m_IsTouched[m_PositionOfVertex[pTriangle[1]]] = 1;
+                m_IsTouched[m_PositionOfVertex[pTriangle[2]]] = 1;
+            }
+
+            m_Remap[rCollapse.m_Source] = rCollapse.m_Target;
+
+            AddQuadric(m_Quadrics[Target], m_Quadrics[Source]);
+
+            m_Error = std::max(m_Error, rCollapse.m_Error);
+
+            NumberOfTriangles += m_Kinds[Source] == Border ? 1 : 2;
+
+            ++NumberOfCollapses;
+        }
+
+        return NumberOfCollapses;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMeshSimplifier::RemoveDegenerateTriangles()
+    {
+        unsigned int NumberOfIndices = 0;
+
+        for (unsigned int IndexOfIndex = 0; IndexOfIndex < m_Indices.size(); IndexOfIndex += 3)
+        {
+            const unsigned int Vertex0 = m_Remap[m_Indices[IndexOfIndex + 0]];
+            const unsigned int Vertex1 = m_Remap[m_Indices[IndexOfIndex + 1]];
+            const unsigned int Vertex2 = m_Remap[m_Indices[IndexOfIndex + 2]];
+
+            const unsigned int Position0 = m_PositionOfVertex[Vertex0];
+            const unsigned int Position1 = m_PositionOfVertex[Vertex1];
+            const unsigned int Position2 = m_PositionOfVertex[Vertex2];
+
+            if (Position0 == Position1 || Position0 == Position2 || Position1 == Position2) continue;
+
+            m_Indices[NumberOfIndices + 0] = Vertex0;
+            m_Indices[NumberOfIndices + 1] = Vertex1;
+            m_Indices[NumberOfIndices + 2] = Vertex2;
+
+            NumberOfIndices += 3;
+        }
+
+        m_Indices.resize(NumberOfIndices);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    unsigned int CMeshSimplifier::CountEdges(unsigned int _From, unsigned int _To) const
+    {
+        unsigned int NumberOfEdges = 0;
+
+        for (unsigned int IndexOfTriangle = m_TriangleOffsets[_From]; IndexOfTriangle < m_TriangleOffsets[_From + 1]; ++IndexOfTriangle)
+        {
+            const unsigned int* pTriangle = &m_Indices[m_Triangles[IndexOfTriangle] * 3];
+
+            for (unsigned int IndexOfCorner = 0; IndexOfCorner < 3; ++IndexOfCorner)
+            {
+                if (m_PositionOfVertex[pTriangle[IndexOfCorner]] != _From) continue;
+
+                NumberOfEdges += m_PositionOfVertex[pTriangle[(IndexOfCorner + 1) % 3]] == _To;
+            }
+        }
+
+        return NumberOfEdges;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CMeshSimplifier::CanCollapse(unsigned int _Source, unsigned int _Target) const
+    {
+        switch (m_Kinds[_Source])
+        {
+        case Manifold: return true;
+        case Border:   return m_BorderNext[_Source] == _Target || m_BorderPrevious[_Source] == _Target;
+        default:       return false;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CMeshSimplifier::HasFlippedTriangles(unsigned int _Source, unsigned int _Target) const
+    {
+        for (unsigned int IndexOfTriangle = m_TriangleOffsets[_Source]; IndexOfTriangle < m_TriangleOffsets[_Source + 1]; ++IndexOfTriangle)
+        {
+            const unsigned int* pTriangle = &m_Indices[m_Triangles[IndexOfTriangle] * 3];
+
+            unsigned int Positions[3] =
+            {
+                m_PositionOfVertex[pTriangle[0]],
+                m_PositionOfVertex[pTriangle[1]],
+                m_PositionOfVertex[pTriangle[2]],
+            };
+
+            // -----------------------------------------------------------------------------
+            // Triangles along the edge disappear
+            // -----------------------------------------------------------------------------
+            if (Positions[0] == _Target || Positions[1] == _Target || Positions[2] == _Target) continue;
+
+            const glm::vec3 Normal = glm::cross(m_Positions[Positions[1]] - m_Positions[Positions[0]], m_Positions[Positions[2]] - m_Positions[Positions[0]]);
+
+            for (unsigned int& rPosition : Positions)
+            {
+                if (rPosition == _Source) rPosition = _Target;
+            }
+
+            const glm::vec3 NewNormal = glm::cross(m_Positions[Positions[1]] - m_Positions[Positions[0]], m_Positions[Positions[2]] - m_Positions[Positions[0]]);
+
+            if (glm::dot(Normal, NewNormal) <= s_MinNormalCosine * glm::length(Normal) * glm::length(NewNormal)) return true;
+        }
+
+        return false;
+    }
+} // namespace Gfx
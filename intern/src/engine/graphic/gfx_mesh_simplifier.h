@@ -0,0 +1,108 @@
+
+#pragma once
+
+#include "engine/engine_config.h"
+
+#include "base/base_include_glm.h"
+
+#include <vector>
+
+namespace Gfx
+{
+    // -----------------------------------------------------------------------------
+    // CPU side quadric error simplifier for indexed triangle lists. Edges are
+    // collapsed onto one of their vertices, so the result indexes the vertices
+    // of the input and a LOD can share the vertex buffer of the full mesh.
+    // Open borders only slide along themselves; vertices that share their
+    // position with other vertices (seams of normals or UVs) never move.
+    // -----------------------------------------------------------------------------
+    class ENGINE_API CMeshSimplifier
+    {
+    public:
+
+        struct SResult
+        {
+            unsigned int m_NumberOfIndices;
+            float        m_Error;               //< Largest distance to the original surface in units of the positions (quadric estimate)
+        };
+
+    public:
+
+        // -----------------------------------------------------------------------------
+        // Collapses edges with the smallest error first until the number of
+        // indices reaches the target or the next collapse would exceed the
+        // given error. The positions are read as three floats every stride
+        // bytes; the result needs space for as many indices as the input.
+        // -----------------------------------------------------------------------------
+        SResult Simplify(const float* _pPositions, unsigned int _NumberOfVertices, unsigned int _Stride, const unsigned int* _pIndices, unsigned int _NumberOfIndices, unsigned int _TargetNumberOfIndices, float _MaxError, unsigned int* _pResult);
+
+    public:
+
+        CMeshSimplifier();
+       ~CMeshSimplifier();
+
+    private:
+
+        enum EVertexKind
+        {
+            Manifold,
+            Border,                             //< Exactly one open edge in and out
+            Locked,                             //< Seams and non manifold vertices
+        };
+
+        struct SQuadric
+        {
+            float m_A00, m_A11, m_A22;
+            float m_A01, m_A02, m_A12;
+            float m_B0, m_B1, m_B2;
+            float m_C;
+            float m_Weight;
+        };
+
+        struct SCollapse
+        {
+            unsigned int m_Source;
+            unsigned int m_Target;
+            float        m_Error;
+        };
+
+        using CPositions  = std::vector<glm::vec3>;
+        using CIndices    = std::vector<unsigned int>;
+        using CKinds      = std::vector<unsigned char>;
+        using CQuadrics   = std::vector<SQuadric>;
+        using CCollapses  = std::vector<SCollapse>;
+
+    private:
+
+        float WeldPositions(const float* _pPositions, unsigned int _NumberOfVertices, unsigned int _Stride);
+        void BuildAdjacency();
+        void ClassifyVertices();
+        void ComputeQuadrics();
+
+        void RankCollapses();
+        unsigned int PerformCollapses(unsigned int _NumberOfTrianglesToRemove, float _MaxError);
+        void RemoveDegenerateTriangles();
+
+        unsigned int CountEdges(unsigned int _From, unsigned int _To) const;
+        bool CanCollapse(unsigned int _Source, unsigned int _Target) const;
+        bool HasFlippedTriangles(unsigned int _Source, unsigned int _Target) const;
+
+    private:
+
+        CPositions m_Positions;                 //< One per welded position
+        CIndices   m_PositionOfVertex;
+        CIndices   m_Indices;                   //< Current triangles (vertex indices)
+        CIndices   m_TriangleOffsets;           //< Triangles around every welded position
+        CIndices   m_Triangles;
+        CKinds     m_Kinds;
+        CIndices   m_BorderNext;
+        CIndices   m_BorderPrevious;
+        CQuadrics  m_Quadrics;
+        CCollapses m_Collapses;
+        CIndices   m_Remap;
+        CKinds     m_IsTouched;
+        CIndices   m_SortedVertices;
+        CIndices   m_NumberOfVerticesOfPosition;
+        float      m_Error;                     //< Largest squared error of all collapses
+    };
+} // namespace Gfx
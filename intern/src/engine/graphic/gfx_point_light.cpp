@@ -9,6 +9,7 @@ namespace Gfx
         : m_TextureSMPtr ()
         , m_TextureRSMPtr()
         , m_CameraPtr    (0)
+        , m_ShadowMatrix (1.0f)
         , m_ShadowmapSize(0)
         , m_TimeStamp    (static_cast<Base::U64>(-1))
     {
@@ -46,6 +47,13 @@ namespace Gfx
 
     // -----------------------------------------------------------------------------
 
+    const glm::mat4& CPointLight::GetShadowMatrix() const
+    {
+        return m_ShadowMatrix;
+    }
+
+    // -----------------------------------------------------------------------------
+
     unsigned int CPointLight::GetShadowmapSize() const
     {
         return m_ShadowmapSize;
@@ -19,6 +19,12 @@ namespace Gfx
 
         CCameraPtr GetCamera() const;
 
+        // -----------------------------------------------------------------------------
+        // World space into the shadow map; includes the tile inside of the shadow
+        // atlas, so shaders have to use this instead of the camera matrices.
+        // -----------------------------------------------------------------------------
+        const glm::mat4& GetShadowMatrix() const;
+
         unsigned int GetShadowmapSize() const;
 
         Base::U64 GetTimeStamp() const;
@@ -28,6 +34,7 @@ namespace Gfx
         CTextureSetPtr m_TextureSMPtr;
         CTextureSetPtr m_TextureRSMPtr;
         CCameraPtr     m_CameraPtr;
+        glm::mat4      m_ShadowMatrix;
         unsigned int   m_ShadowmapSize;
         Base::U64      m_TimeStamp;
     };
@@ -6,6 +6,7 @@
 #include "base/base_singleton.h"
 #include "base/base_uncopyable.h"
 
+#include "engine/core/core_program_parameters.h"
 #include "engine/core/core_time.h"
 
 #include "engine/data/data_component.h"
@@ -13,6 +14,7 @@
 #include "engine/data/data_component_manager.h"
 #include "engine/data/data_entity.h"
 #include "engine/data/data_entity_manager.h"
+#include "engine/data/data_hierarchy_facet.h"
 #include "engine/data/data_map.h"
 #include "engine/data/data_material_component.h"
 #include "engine/data/data_mesh_component.h"
@@ -29,12 +31,17 @@
 #include "engine/graphic/gfx_point_light_manager.h"
 #include "engine/graphic/gfx_sampler_manager.h"
 #include "engine/graphic/gfx_shader_manager.h"
+#include "engine/graphic/gfx_shadow_atlas_allocator.h"
+#include "engine/graphic/gfx_shadow_caster_cache.h"
 #include "engine/graphic/gfx_state_manager.h"
 #include "engine/graphic/gfx_target_set.h"
 #include "engine/graphic/gfx_target_set_manager.h"
 #include "engine/graphic/gfx_texture_manager.h"
 #include "engine/graphic/gfx_view_manager.h"
 
+#include <cfloat>
+#include <vector>
+
 using namespace Gfx;
 
 namespace 
@@ -87,6 +94,13 @@ namespace
 
             CRenderContextPtr m_RenderContextPtr;
             Dt::CPointLightComponent::EShadowType m_CurrentShadowType;
+            CShadowCasterCache m_ShadowCasterCache;
+            CTextureSetPtr m_StaticTextureSetPtr;       //< Static casters only; created as soon as dynamic casters are visible
+            CTargetSetPtr m_StaticTargetSetPtr;
+            CViewPortSetPtr m_StaticViewPortSetPtr;
+            bool m_IsStaticCacheValid;
+            int m_AtlasTile;                            //< Hard shadows are rendered into a tile of the shadow atlas
+            unsigned int m_MaxShadowmapSize;            //< Size of the shadow quality; the tile never gets bigger
 
         private:
 
@@ -97,9 +111,33 @@ namespace
 
         typedef Base::CManagedPool<CInternObject, 32, 0> CPointLights;
 
+        typedef std::vector<CShadowCasterCache::SCaster> CShadowCasters;
+        typedef std::vector<Dt::CMeshComponent*> CShadowCasterComponents;
+
+        typedef std::vector<CShadowAtlasAllocator::SRequest> CAtlasRequests;
+        typedef std::vector<unsigned int> CAtlasTileSizes;
+        typedef std::vector<int> CAtlasTiles;
+        typedef std::vector<CInternObject*> CAtlasLights;
+
+    private:
+
+        static const unsigned int s_AtlasTileBorder = 4;     //< Texels around every tile that stay cleared for filtering
+
     private:
 
         CPointLights m_PointLights;
+        CShadowCasters m_ShadowCasters;
+        CShadowCasterComponents m_ShadowCasterComponents;
+        bool m_HasChangedShadowCasters;
+        CShadowAtlasAllocator m_ShadowAtlas;
+        CTextureSetPtr m_ShadowAtlasTextureSetPtr;
+        CTargetSetPtr m_ShadowAtlasTargetSetPtr;
+        unsigned int m_MaxAtlasTileSize;
+        Base::U64 m_AtlasTexelBudget;
+        CAtlasRequests m_AtlasRequests;
+        CAtlasTileSizes m_AtlasTileSizes;
+        CAtlasTiles m_AtlasTiles;
+        CAtlasLights m_AtlasLights;
         CShaderPtr m_ShadowSMShaderPSPtr;
         CShaderPtr m_ShadowRSMShaderPSPtr;
         CShaderPtr m_ShadowRSMTexShaderPSPtr;
@@ -120,16 +158,39 @@ namespace
 
         void CreateSM(unsigned int _Size, CInternObject* _pInternLight);
 
-        void RenderShadows(CInternObject& _rInternLight, const Dt::CPointLightComponent* _pDtPointLight, const glm::vec3& _rLightPosition);
+        void CreateStaticShadowCache(CInternObject& _rInternLight);
+
+        void UpdateShadowCamera(CInternObject& _rInternLight, const Dt::CPointLightComponent* _pDtPointLight);
+
+        void UpdateShadowAtlas();
+
+        void SetAtlasTile(CInternObject& _rInternLight, int _Tile);
+
+        void ReleaseAtlasTile(CInternObject& _rInternLight);
+
+        void UpdateShadowMatrix(CInternObject& _rInternLight);
+
+        void GatherShadowCasters();
+
+        void RenderShadows(CInternObject& _rInternLight, const Dt::CPointLightComponent* _pDtPointLight, unsigned int _DirtyFlags);
+
+        void RenderShadowCasters(CInternObject& _rInternLight, const Dt::CPointLightComponent* _pDtPointLight, CTargetSetPtr _TargetSetPtr, CViewPortSetPtr _ViewPortSetPtr, bool _ClearTargetSet, const CShadowCasterCache::CIndices& _rCasters);
     };
 } // namespace 
 
 namespace 
 {
     CGfxPointLightManager::CInternObject::CInternObject()
-        : CPointLight        ()
-        , m_RenderContextPtr ()
-        , m_CurrentShadowType(Dt::CPointLightComponent::NoShadows)
+        : CPointLight           ()
+        , m_RenderContextPtr    ()
+        , m_CurrentShadowType   (Dt::CPointLightComponent::NoShadows)
+        , m_ShadowCasterCache   ()
+        , m_StaticTextureSetPtr ()
+        , m_StaticTargetSetPtr  ()
+        , m_StaticViewPortSetPtr()
+        , m_IsStaticCacheValid  (false)
+        , m_AtlasTile           (CShadowAtlasAllocator::s_InvalidTile)
+        , m_MaxShadowmapSize    (0)
     {
 
     }
@@ -138,19 +199,34 @@ namespace
 
     CGfxPointLightManager::CInternObject::~CInternObject()
     {
-        m_RenderContextPtr = 0;
+        m_RenderContextPtr     = 0;
+        m_StaticTextureSetPtr  = 0;
+        m_StaticTargetSetPtr   = 0;
+        m_StaticViewPortSetPtr = 0;
     }
 } // namespace 
 
 namespace 
 {
     CGfxPointLightManager::CGfxPointLightManager()
-        : m_PointLights            ()
-        , m_ShadowSMShaderPSPtr    ()
-        , m_ShadowRSMShaderPSPtr   ()
-        , m_ShadowRSMTexShaderPSPtr()
-        , m_LightCameraVSBufferPtr ()
-        , m_RSMPSBuffer            ()
+        : m_PointLights             ()
+        , m_ShadowCasters           ()
+        , m_ShadowCasterComponents  ()
+        , m_HasChangedShadowCasters (false)
+        , m_ShadowAtlas             ()
+        , m_ShadowAtlasTextureSetPtr()
+        , m_ShadowAtlasTargetSetPtr ()
+        , m_MaxAtlasTileSize        (0)
+        , m_AtlasTexelBudget        (0)
+        , m_AtlasRequests           ()
+        , m_AtlasTileSizes          ()
+        , m_AtlasTiles              ()
+        , m_AtlasLights             ()
+        , m_ShadowSMShaderPSPtr     ()
+        , m_ShadowRSMShaderPSPtr    ()
+        , m_ShadowRSMTexShaderPSPtr ()
+        , m_LightCameraVSBufferPtr  ()
+        , m_RSMPSBuffer             ()
     {
 
     }
@@ -229,6 +305,42 @@ namespace
         m_RSMPSBuffer            = BufferManager::CreateBufferSet(MaterialBuffer, PointLightBufferPtr);
 
         m_LightCameraVSBufferPtr = BufferManager::CreateBufferSet(PerLightConstantBuffer, PerDrawCallConstantBuffer);
+
+        // -----------------------------------------------------------------------------
+        // Shadow atlas shared by every point light with hard shadows
+        // -----------------------------------------------------------------------------
+        unsigned int AtlasSize   = Core::CProgramParameters::GetInstance().Get("graphics:shadow_atlas:size", 4096u);
+        unsigned int MinTileSize = Core::CProgramParameters::GetInstance().Get("graphics:shadow_atlas:min_tile_size", 128u);
+        float        Budget      = Core::CProgramParameters::GetInstance().Get("graphics:shadow_atlas:budget", 1.0f);
+
+        m_MaxAtlasTileSize = glm::min(Core::CProgramParameters::GetInstance().Get("graphics:shadow_atlas:max_tile_size", 2048u), AtlasSize);
+
+        m_ShadowAtlas.Initialize(AtlasSize, MinTileSize);
+
+        m_AtlasTexelBudget = static_cast<Base::U64>(static_cast<double>(AtlasSize) * AtlasSize * glm::clamp(Budget, 0.0f, 1.0f));
+
+        STextureDescriptor AtlasDescriptor;
+
+        AtlasDescriptor.m_NumberOfPixelsU  = AtlasSize;
+        AtlasDescriptor.m_NumberOfPixelsV  = AtlasSize;
+        AtlasDescriptor.m_NumberOfPixelsW  = 1;
+        AtlasDescriptor.m_NumberOfMipMaps  = 1;
+        AtlasDescriptor.m_NumberOfTextures = 1;
+        AtlasDescriptor.m_Access           = CTexture::CPUWrite;
+        AtlasDescriptor.m_Usage            = CTexture::GPURead;
+        AtlasDescriptor.m_Semantic         = CTexture::Diffuse;
+        AtlasDescriptor.m_pFileName        = 0;
+        AtlasDescriptor.m_pPixels          = 0;
+        AtlasDescriptor.m_Binding          = CTexture::DepthStencilTarget | CTexture::RenderTarget;
+        AtlasDescriptor.m_Format           = CTexture::R32_FLOAT;
+
+        CTexturePtr AtlasTexturePtr = TextureManager::CreateTexture2D(AtlasDescriptor);
+
+        m_ShadowAtlasTextureSetPtr = TextureManager::CreateTextureSet(AtlasTexturePtr);
+
+        m_ShadowAtlasTargetSetPtr = TargetSetManager::CreateTargetSet(AtlasTexturePtr);
+
+        TargetSetManager::ClearTargetSet(m_ShadowAtlasTargetSetPtr, 1.0f);
         
         // -----------------------------------------------------------------------------
         // Register dirty entity handler for automatic sky creation
@@ -244,6 +356,19 @@ namespace
     {
         m_PointLights.Clear();
 
+        m_ShadowCasters         .clear();
+        m_ShadowCasterComponents.clear();
+
+        m_ShadowAtlas.Clear();
+
+        m_AtlasRequests .clear();
+        m_AtlasTileSizes.clear();
+        m_AtlasTiles    .clear();
+        m_AtlasLights   .clear();
+
+        m_ShadowAtlasTextureSetPtr = 0;
+        m_ShadowAtlasTargetSetPtr  = 0;
+
         m_ShadowSMShaderPSPtr     = 0;
         m_ShadowRSMShaderPSPtr    = 0;
         m_ShadowRSMTexShaderPSPtr = 0;
@@ -255,6 +380,16 @@ namespace
 
     void CGfxPointLightManager::Update()
     {
+        // -----------------------------------------------------------------------------
+        // Casters are gathered once and shared by every light
+        // -----------------------------------------------------------------------------
+        GatherShadowCasters();
+
+        // -----------------------------------------------------------------------------
+        // Tiles follow the screen coverage of the lights
+        // -----------------------------------------------------------------------------
+        UpdateShadowAtlas();
+
         // -----------------------------------------------------------------------------
         // Iterate throw every entity inside this map
         // -----------------------------------------------------------------------------
@@ -268,46 +403,46 @@ namespace
 
             CInternObject* pGfxPointLight = static_cast<CInternObject*>(pDtComponent->GetFacet(Dt::CPointLightComponent::Graphic));
 
+            if (pGfxPointLight->m_CurrentShadowType == Dt::CPointLightComponent::NoShadows) continue;
+
+            if (m_HasChangedShadowCasters) pGfxPointLight->m_ShadowCasterCache.Invalidate();
+
+            // -----------------------------------------------------------------------------
+            // Static lights are only rendered again if the light itself changed
+            // -----------------------------------------------------------------------------
             if (pDtComponent->GetRefreshMode() == Dt::CPointLightComponent::Dynamic)
             {
-                // -----------------------------------------------------------------------------
-                // Update views
-                // -----------------------------------------------------------------------------
-                Gfx::CViewPtr   ShadowViewPtr   = pGfxPointLight->m_RenderContextPtr->GetCamera()->GetView();
-                Gfx::CCameraPtr ShadowCameraPtr = pGfxPointLight->m_RenderContextPtr->GetCamera();
-
-                glm::vec3 LightPosition  = pDtComponent->GetHostEntity()->GetWorldPosition();
-                glm::vec3 LightDirection = pDtComponent->GetDirection();
+                UpdateShadowCamera(*pGfxPointLight, pDtComponent);
+            }
 
-                // -----------------------------------------------------------------------------
-                // Set view
-                // -----------------------------------------------------------------------------
-                glm::mat3 RotationMatrix = glm::mat3(1.0f);
+            UpdateShadowMatrix(*pGfxPointLight);
 
-                RotationMatrix = glm::lookAt(LightPosition, LightPosition + LightDirection, glm::vec3(0.0f, 0.0f, 1.0f));
+            if (pDtComponent->GetRefreshMode() != Dt::CPointLightComponent::Dynamic && pGfxPointLight->m_ShadowCasterCache.IsValid())
+            {
+                continue;
+            }
 
-                ShadowViewPtr->SetPosition(LightPosition);
-                ShadowViewPtr->SetRotationMatrix(glm::transpose(RotationMatrix));
+            // -----------------------------------------------------------------------------
+            // Lights without a tile are skipped until the atlas has room again
+            // -----------------------------------------------------------------------------
+            if (pGfxPointLight->m_CurrentShadowType == Dt::CPointLightComponent::HardShadows && pGfxPointLight->m_AtlasTile == CShadowAtlasAllocator::s_InvalidTile)
+            {
+                continue;
+            }
 
-                // -----------------------------------------------------------------------------
-                // Calculate near and far plane
-                // -----------------------------------------------------------------------------
-                float Near = 0.1f;
-                float Far = pDtComponent->GetAttenuationRadius() + Near;
+            // -----------------------------------------------------------------------------
+            // Render if the light or one of the visible casters changed
+            // -----------------------------------------------------------------------------
+            const glm::mat4& rViewProjectionMatrix = pGfxPointLight->m_RenderContextPtr->GetCamera()->GetViewProjectionMatrix();
 
-                // -----------------------------------------------------------------------------
-                // Set matrix
-                // -----------------------------------------------------------------------------
-                ShadowCameraPtr->SetFieldOfView(glm::degrees(pDtComponent->GetOuterConeAngle()), 1.0f, Near, Far);
+            unsigned int DirtyFlags = pGfxPointLight->m_ShadowCasterCache.Update(rViewProjectionMatrix, m_ShadowCasters.data(), static_cast<int>(m_ShadowCasters.size()));
 
-                ShadowViewPtr->Update();
+            if (DirtyFlags == 0) continue;
 
-                // -----------------------------------------------------------------------------
-                // Render
-                // -----------------------------------------------------------------------------
-                RenderShadows(*pGfxPointLight, pDtComponent, LightPosition);
-            }
+            RenderShadows(*pGfxPointLight, pDtComponent, DirtyFlags);
         }
+
+        m_HasChangedShadowCasters = false;
     }
 
     // -----------------------------------------------------------------------------
@@ -335,6 +470,17 @@ namespace
 
     void CGfxPointLightManager::OnDirtyComponent(Dt::IComponent* _pComponent)
     {
+        // -----------------------------------------------------------------------------
+        // The caster caches only track movements; a new mesh or material of a
+        // caster has to be rendered again as well.
+        // -----------------------------------------------------------------------------
+        if (_pComponent->GetTypeInfo() == Base::CTypeInfo::Get<Dt::CMeshComponent>() || _pComponent->GetTypeInfo() == Base::CTypeInfo::Get<Dt::CMaterialComponent>())
+        {
+            m_HasChangedShadowCasters = true;
+
+            return;
+        }
+
         if (_pComponent->GetTypeInfo() != Base::CTypeInfo::Get<Dt::CPointLightComponent>()) return;
 
         Dt::CPointLightComponent* pPointLightComponent = static_cast<Dt::CPointLightComponent*>(_pComponent);
@@ -374,7 +520,8 @@ namespace
             // -----------------------------------------------------------------------------
             // Set variables
             // -----------------------------------------------------------------------------
-            pGfxPointLightFacet->m_ShadowmapSize = ShadowmapSize;
+            pGfxPointLightFacet->m_ShadowmapSize    = ShadowmapSize;
+            pGfxPointLightFacet->m_MaxShadowmapSize = ShadowmapSize;
 
             pGfxPointLightFacet->m_CurrentShadowType = ShadowType;
 
@@ -393,9 +540,10 @@ namespace
 
             ShadowType = pPointLightComponent->GetShadowType();
 
-            if (ShadowmapSize != pGfxPointLightFacet->m_ShadowmapSize || ShadowType != pGfxPointLightFacet->m_CurrentShadowType)
+            if (ShadowmapSize != pGfxPointLightFacet->m_MaxShadowmapSize || ShadowType != pGfxPointLightFacet->m_CurrentShadowType)
             {
-                pGfxPointLightFacet->m_ShadowmapSize = ShadowmapSize;
+                pGfxPointLightFacet->m_ShadowmapSize    = ShadowmapSize;
+                pGfxPointLightFacet->m_MaxShadowmapSize = ShadowmapSize;
 
                 pGfxPointLightFacet->m_CurrentShadowType = ShadowType;
 
@@ -403,6 +551,7 @@ namespace
                 {
                 case Dt::CPointLightComponent::HardShadows:        CreateSM(ShadowmapSize, pGfxPointLightFacet); break;
                 case Dt::CPointLightComponent::GlobalIllumination: CreateRSM(ShadowmapSize, pGfxPointLightFacet); break;
+                default:                                           ReleaseAtlasTile(*pGfxPointLightFacet); break;
                 }
             }
         }
@@ -410,6 +559,8 @@ namespace
         {
             pGfxPointLightFacet = static_cast<CInternObject*>(pPointLightComponent->GetFacet(Dt::CPointLightComponent::Graphic));
 
+            if (pGfxPointLightFacet != 0) ReleaseAtlasTile(*pGfxPointLightFacet);
+
             pGfxPointLightFacet = 0;
 
             return;
@@ -424,41 +575,11 @@ namespace
         if (pPointLightComponent->GetShadowType() != Dt::CPointLightComponent::NoShadows)
         {
             // -----------------------------------------------------------------------------
-            // Update views
-            // -----------------------------------------------------------------------------
-            Gfx::CViewPtr   ShadowViewPtr = pGfxPointLightFacet->m_RenderContextPtr->GetCamera()->GetView();
-            Gfx::CCameraPtr ShadowCameraPtr = pGfxPointLightFacet->m_RenderContextPtr->GetCamera();
-
-            glm::vec3 LightPosition = pPointLightComponent->GetHostEntity()->GetWorldPosition();
-            glm::vec3 LightDirection = glm::normalize(pPointLightComponent->GetDirection());
-
-            // -----------------------------------------------------------------------------
-            // Set view
-            // -----------------------------------------------------------------------------
-            glm::mat3 RotationMatrix = glm::mat3(1.0f);
-
-            RotationMatrix = glm::lookAt(LightPosition, LightPosition + LightDirection, glm::vec3(0.0f, 0.0f, 1.0f));
-
-            ShadowViewPtr->SetPosition(LightPosition);
-            ShadowViewPtr->SetRotationMatrix(glm::transpose(RotationMatrix));
-
-            // -----------------------------------------------------------------------------
-            // Calculate near and far plane
-            // -----------------------------------------------------------------------------
-            float Near = 0.1f;
-            float Far = pPointLightComponent->GetAttenuationRadius() + Near;
-
-            // -----------------------------------------------------------------------------
-            // Set matrix
+            // Shadows are rendered with the next update
             // -----------------------------------------------------------------------------
-            ShadowCameraPtr->SetFieldOfView(glm::degrees(pPointLightComponent->GetOuterConeAngle()), 1.0f, Near, Far);
-
-            ShadowViewPtr->Update();
+            UpdateShadowCamera(*pGfxPointLightFacet, pPointLightComponent);
 
-            // -----------------------------------------------------------------------------
-            // Render shadows
-            // -----------------------------------------------------------------------------
-            RenderShadows(*pGfxPointLightFacet, pPointLightComponent, LightPosition);
+            pGfxPointLightFacet->m_ShadowCasterCache.Invalidate();
         }
 
         // -----------------------------------------------------------------------------
@@ -519,6 +640,12 @@ namespace
         _pInternLight->m_TextureSMPtr = TextureManager::CreateTextureSet(ShadowRenderbuffer[3]);
 
         _pInternLight->m_TextureRSMPtr = TextureManager::CreateTextureSet(ShadowRenderbuffer, 4);
+
+        _pInternLight->m_StaticTextureSetPtr  = 0;
+        _pInternLight->m_StaticTargetSetPtr   = 0;
+        _pInternLight->m_StaticViewPortSetPtr = 0;
+
+        ReleaseAtlasTile(*_pInternLight);
         
         // -----------------------------------------------------------------------------
         // Create target set for shadow mapping
@@ -574,35 +701,20 @@ namespace
         unsigned int NumberOfShadowMapPixel = _Size;
         
         // -----------------------------------------------------------------------------
-        // Create texture for shadow mapping
+        // Hard shadows are rendered into the shadow atlas; the tile is assigned
+        // with the next update.
         // -----------------------------------------------------------------------------
-        CTexturePtr ShadowRenderbuffer[1];
-        
-        STextureDescriptor RendertargetDescriptor;
-        
-        RendertargetDescriptor.m_NumberOfPixelsU  = NumberOfShadowMapPixel;
-        RendertargetDescriptor.m_NumberOfPixelsV  = NumberOfShadowMapPixel;
-        RendertargetDescriptor.m_NumberOfPixelsW  = 1;
-        RendertargetDescriptor.m_NumberOfMipMaps  = 1;
-        RendertargetDescriptor.m_NumberOfTextures = 1;
-        RendertargetDescriptor.m_Access           = CTexture::CPUWrite;
-        RendertargetDescriptor.m_Usage            = CTexture::GPURead;
-        RendertargetDescriptor.m_Semantic         = CTexture::Diffuse;
-        RendertargetDescriptor.m_pFileName        = 0;
-        RendertargetDescriptor.m_pPixels          = 0;
-        RendertargetDescriptor.m_Binding          = CTexture::DepthStencilTarget | CTexture::RenderTarget;
-        RendertargetDescriptor.m_Format           = CTexture::R32_FLOAT;
-        
-        ShadowRenderbuffer[0] = TextureManager::CreateTexture2D(RendertargetDescriptor); // Depth only
-        
-        _pInternLight->m_TextureSMPtr  = TextureManager::CreateTextureSet(ShadowRenderbuffer, 1);
+        ReleaseAtlasTile(*_pInternLight);
+
+        _pInternLight->m_TextureSMPtr  = m_ShadowAtlasTextureSetPtr;
 
         _pInternLight->m_TextureRSMPtr = 0;
+
+        _pInternLight->m_StaticTextureSetPtr  = 0;
+        _pInternLight->m_StaticTargetSetPtr   = 0;
+        _pInternLight->m_StaticViewPortSetPtr = 0;
         
-        // -----------------------------------------------------------------------------
-        // Create target set for shadow mapping
-        // -----------------------------------------------------------------------------
-        CTargetSetPtr ShadowTargetSetPtr = TargetSetManager::CreateTargetSet(ShadowRenderbuffer, 1);
+        CTargetSetPtr ShadowTargetSetPtr = m_ShadowAtlasTargetSetPtr;
         
         // -----------------------------------------------------------------------------
         // Create view and camera
@@ -646,21 +758,405 @@ namespace
 
     // -----------------------------------------------------------------------------
 
-    void CGfxPointLightManager::RenderShadows(CInternObject& _rInternLight, const Dt::CPointLightComponent* _pDtPointLight, const glm::vec3& _rLightPosition)
+    void CGfxPointLightManager::CreateStaticShadowCache(CInternObject& _rInternLight)
+    {
+        CTextureSetPtr ShadowTextureSetPtr = _rInternLight.m_TextureRSMPtr != nullptr ? _rInternLight.m_TextureRSMPtr : _rInternLight.m_TextureSMPtr;
+
+        bool IsAtlasTile = _rInternLight.m_AtlasTile != CShadowAtlasAllocator::s_InvalidTile;
+
+        // -----------------------------------------------------------------------------
+        // Same layout as the shadow map itself; atlas lights only need their tile
+        // -----------------------------------------------------------------------------
+        CTexturePtr StaticRenderbuffer[4];
+
+        unsigned int NumberOfTextures = ShadowTextureSetPtr->GetNumberOfTextures();
+
+        assert(NumberOfTextures <= 4);
+
+        for (unsigned int IndexOfTexture = 0; IndexOfTexture < NumberOfTextures; ++IndexOfTexture)
+        {
+            CTexturePtr ShadowTexturePtr = ShadowTextureSetPtr->GetTexture(IndexOfTexture);
+
+            STextureDescriptor RendertargetDescriptor;
+
+            RendertargetDescriptor.m_NumberOfPixelsU  = IsAtlasTile ? _rInternLight.m_ShadowmapSize : ShadowTexturePtr->GetNumberOfPixelsU();
+            RendertargetDescriptor.m_NumberOfPixelsV  = IsAtlasTile ? _rInternLight.m_ShadowmapSize : ShadowTexturePtr->GetNumberOfPixelsV();
+            RendertargetDescriptor.m_NumberOfPixelsW  = 1;
+            RendertargetDescriptor.m_NumberOfMipMaps  = 1;
+            RendertargetDescriptor.m_NumberOfTextures = 1;
+            RendertargetDescriptor.m_Access           = CTexture::CPUWrite;
+            RendertargetDescriptor.m_Usage            = CTexture::GPURead;
+            RendertargetDescriptor.m_Semantic         = CTexture::Diffuse;
+            RendertargetDescriptor.m_pFileName        = 0;
+            RendertargetDescriptor.m_pPixels          = 0;
+            RendertargetDescriptor.m_Binding          = ShadowTexturePtr->GetBinding();
+            RendertargetDescriptor.m_Format           = ShadowTexturePtr->GetFormat();
+
+            StaticRenderbuffer[IndexOfTexture] = TextureManager::CreateTexture2D(RendertargetDescriptor);
+        }
+
+        _rInternLight.m_StaticTextureSetPtr = TextureManager::CreateTextureSet(StaticRenderbuffer, NumberOfTextures);
+
+        _rInternLight.m_StaticTargetSetPtr = TargetSetManager::CreateTargetSet(StaticRenderbuffer, NumberOfTextures);
+
+        _rInternLight.m_StaticViewPortSetPtr = _rInternLight.m_RenderContextPtr->GetViewPortSet();
+
+        if (IsAtlasTile)
+        {
+            SViewPortDescriptor ViewPortDesc;
+
+            ViewPortDesc.m_TopLeftX = static_cast<float>(s_AtlasTileBorder);
+            ViewPortDesc.m_TopLeftY = static_cast<float>(s_AtlasTileBorder);
+            ViewPortDesc.m_Width    = static_cast<float>(_rInternLight.m_ShadowmapSize - 2 * s_AtlasTileBorder);
+            ViewPortDesc.m_Height   = static_cast<float>(_rInternLight.m_ShadowmapSize - 2 * s_AtlasTileBorder);
+            ViewPortDesc.m_MinDepth = 0.0f;
+            ViewPortDesc.m_MaxDepth = 1.0f;
+
+            _rInternLight.m_StaticViewPortSetPtr = ViewManager::CreateViewPortSet(ViewManager::CreateViewPort(ViewPortDesc));
+        }
+
+        _rInternLight.m_IsStaticCacheValid = false;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CGfxPointLightManager::UpdateShadowCamera(CInternObject& _rInternLight, const Dt::CPointLightComponent* _pDtPointLight)
+    {
+        Gfx::CViewPtr   ShadowViewPtr   = _rInternLight.m_RenderContextPtr->GetCamera()->GetView();
+        Gfx::CCameraPtr ShadowCameraPtr = _rInternLight.m_RenderContextPtr->GetCamera();
+
+        glm::vec3 LightPosition  = _pDtPointLight->GetHostEntity()->GetWorldPosition();
+        glm::vec3 LightDirection = glm::normalize(_pDtPointLight->GetDirection());
+
+        // -----------------------------------------------------------------------------
+        // Set view
+        // -----------------------------------------------------------------------------
+        glm::mat3 RotationMatrix = glm::mat3(1.0f);
+
+        RotationMatrix = glm::lookAt(LightPosition, LightPosition + LightDirection, glm::vec3(0.0f, 0.0f, 1.0f));
+
+        ShadowViewPtr->SetPosition(LightPosition);
+        ShadowViewPtr->SetRotationMatrix(glm::transpose(RotationMatrix));
+
+        // -----------------------------------------------------------------------------
+        // Calculate near and far plane
+        // -----------------------------------------------------------------------------
+        float Near = 0.1f;
+        float Far  = _pDtPointLight->GetAttenuationRadius() + Near;
+
+        // -----------------------------------------------------------------------------
+        // Set matrix
+        // -----------------------------------------------------------------------------
+        ShadowCameraPtr->SetFieldOfView(glm::degrees(_pDtPointLight->GetOuterConeAngle()), 1.0f, Near, Far);
+
+        ShadowViewPtr->Update();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CGfxPointLightManager::UpdateShadowAtlas()
+    {
+        m_AtlasRequests.clear();
+        m_AtlasTiles   .clear();
+        m_AtlasLights  .clear();
+
+        CCameraPtr MainCameraPtr = ViewManager::GetMainCamera();
+
+        const glm::vec3& rCameraPosition = MainCameraPtr->GetView()->GetPosition();
+
+        float ProjectionScale = MainCameraPtr->GetProjectionMatrix()[1][1];
+
+        auto DataComponents = Dt::CComponentManager::GetInstance().GetComponents<Dt::CPointLightComponent>();
+
+        for (auto Component : DataComponents)
+        {
+            Dt::CPointLightComponent* pDtComponent = static_cast<Dt::CPointLightComponent*>(Component);
+
+            CInternObject* pGfxPointLight = static_cast<CInternObject*>(pDtComponent->GetFacet(Dt::CPointLightComponent::Graphic));
+
+            if (pGfxPointLight == 0) continue;
+
+            if (pDtComponent->IsActiveAndUsable() == false || pGfxPointLight->m_CurrentShadowType != Dt::CPointLightComponent::HardShadows)
+            {
+                ReleaseAtlasTile(*pGfxPointLight);
+
+                continue;
+            }
+
+            // -----------------------------------------------------------------------------
+            // Projected height of the light sphere relative to the screen; the
+            // shadow quality of the light caps the resolution.
+            // -----------------------------------------------------------------------------
+            float Radius   = pDtComponent->GetAttenuationRadius();
+            float Distance = glm::distance(rCameraPosition, pDtComponent->GetHostEntity()->GetWorldPosition());
+
+            CShadowAtlasAllocator::SRequest Request;
+
+            Request.m_Coverage    = Distance > Radius ? Radius * ProjectionScale / Distance : 1.0f;
+            Request.m_Importance  = static_cast<float>(pGfxPointLight->m_MaxShadowmapSize) / static_cast<float>(m_MaxAtlasTileSize);
+            Request.m_CurrentSize = pGfxPointLight->m_AtlasTile != CShadowAtlasAllocator::s_InvalidTile ? m_ShadowAtlas.GetTile(pGfxPointLight->m_AtlasTile).m_Size : 0;
+
+            m_AtlasRequests.push_back(Request);
+            m_AtlasTiles   .push_back(pGfxPointLight->m_AtlasTile);
+            m_AtlasLights  .push_back(pGfxPointLight);
+        }
+
+        if (m_AtlasLights.empty()) return;
+
+        int NumberOfLights = static_cast<int>(m_AtlasLights.size());
+
+        m_AtlasTileSizes.resize(m_AtlasLights.size());
+
+        m_ShadowAtlas.SelectTileSizes(m_AtlasRequests.data(), NumberOfLights, m_MaxAtlasTileSize, m_AtlasTexelBudget, m_AtlasTileSizes.data());
+
+        m_ShadowAtlas.UpdateTiles(m_AtlasTileSizes.data(), NumberOfLights, m_AtlasTiles.data());
+
+        // -----------------------------------------------------------------------------
+        // Moved or resized tiles have to be rendered again
+        // -----------------------------------------------------------------------------
+        for (int IndexOfLight = 0; IndexOfLight < NumberOfLights; ++IndexOfLight)
+        {
+            if (m_AtlasTiles[IndexOfLight] == m_AtlasLights[IndexOfLight]->m_AtlasTile) continue;
+
+            SetAtlasTile(*m_AtlasLights[IndexOfLight], m_AtlasTiles[IndexOfLight]);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CGfxPointLightManager::SetAtlasTile(CInternObject& _rInternLight, int _Tile)
+    {
+        _rInternLight.m_AtlasTile = _Tile;
+
+        _rInternLight.m_StaticTextureSetPtr  = 0;
+        _rInternLight.m_StaticTargetSetPtr   = 0;
+        _rInternLight.m_StaticViewPortSetPtr = 0;
+        _rInternLight.m_IsStaticCacheValid   = false;
+
+        _rInternLight.m_ShadowCasterCache.Invalidate();
+
+        if (_Tile == CShadowAtlasAllocator::s_InvalidTile) return;
+
+        // -----------------------------------------------------------------------------
+        // Casters are rendered inside of the border, so filtering at the edge of
+        // the tile never reads a neighbour.
+        // -----------------------------------------------------------------------------
+        CShadowAtlasAllocator::STile Tile = m_ShadowAtlas.GetTile(_Tile);
+
+        SViewPortDescriptor ViewPortDesc;
+
+        ViewPortDesc.m_TopLeftX = static_cast<float>(Tile.m_Offset.x + s_AtlasTileBorder);
+        ViewPortDesc.m_TopLeftY = static_cast<float>(Tile.m_Offset.y + s_AtlasTileBorder);
+        ViewPortDesc.m_Width    = static_cast<float>(Tile.m_Size - 2 * s_AtlasTileBorder);
+        ViewPortDesc.m_Height   = static_cast<float>(Tile.m_Size - 2 * s_AtlasTileBorder);
+        ViewPortDesc.m_MinDepth = 0.0f;
+        ViewPortDesc.m_MaxDepth = 1.0f;
+
+        _rInternLight.m_RenderContextPtr->SetViewPortSet(ViewManager::CreateViewPortSet(ViewManager::CreateViewPort(ViewPortDesc)));
+
+        _rInternLight.m_ShadowmapSize = Tile.m_Size;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CGfxPointLightManager::ReleaseAtlasTile(CInternObject& _rInternLight)
+    {
+        if (_rInternLight.m_AtlasTile == CShadowAtlasAllocator::s_InvalidTile) return;
+
+        m_ShadowAtlas.Free(_rInternLight.m_AtlasTile);
+
+        _rInternLight.m_AtlasTile = CShadowAtlasAllocator::s_InvalidTile;
+
+        _rInternLight.m_StaticTextureSetPtr  = 0;
+        _rInternLight.m_StaticTargetSetPtr   = 0;
+        _rInternLight.m_StaticViewPortSetPtr = 0;
+        _rInternLight.m_IsStaticCacheValid   = false;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Maps the clip space of the light camera onto the inner rectangle of its
+    // tile, so shaders can keep the usual [-1, 1] to [0, 1] conversion.
+    // -----------------------------------------------------------------------------
+    void CGfxPointLightManager::UpdateShadowMatrix(CInternObject& _rInternLight)
+    {
+        const glm::mat4& rViewProjectionMatrix = _rInternLight.m_RenderContextPtr->GetCamera()->GetViewProjectionMatrix();
+
+        if (_rInternLight.m_AtlasTile == CShadowAtlasAllocator::s_InvalidTile)
+        {
+            _rInternLight.m_ShadowMatrix = rViewProjectionMatrix;
+
+            return;
+        }
+
+        CShadowAtlasAllocator::STile Tile = m_ShadowAtlas.GetTile(_rInternLight.m_AtlasTile);
+
+        float AtlasSize = static_cast<float>(m_ShadowAtlas.GetSize());
+        float InnerSize = static_cast<float>(Tile.m_Size - 2 * s_AtlasTileBorder);
+
+        glm::vec2 InnerMin = glm::vec2(Tile.m_Offset) + static_cast<float>(s_AtlasTileBorder);
+
+        glm::mat4 TileMatrix(1.0f);
+
+        TileMatrix[0][0] = InnerSize / AtlasSize;
+        TileMatrix[1][1] = InnerSize / AtlasSize;
+        TileMatrix[3][0] = (2.0f * InnerMin.x + InnerSize) / AtlasSize - 1.0f;
+        TileMatrix[3][1] = (2.0f * InnerMin.y + InnerSize) / AtlasSize - 1.0f;
+
+        _rInternLight.m_ShadowMatrix = TileMatrix * rViewProjectionMatrix;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CGfxPointLightManager::GatherShadowCasters()
+    {
+        m_ShadowCasters         .clear();
+        m_ShadowCasterComponents.clear();
+
+        auto DataMeshComponents = Dt::CComponentManager::GetInstance().GetComponents<Dt::CMeshComponent>();
+
+        for (auto Component : DataMeshComponents)
+        {
+            Dt::CMeshComponent* pDtComponent = static_cast<Dt::CMeshComponent*>(Component);
+
+            if (pDtComponent->IsActiveAndUsable() == false) continue;
+
+            CMesh* pMesh = static_cast<CMesh*>(pDtComponent->GetFacet(Dt::CMeshComponent::Graphic));
+
+            if (pMesh == nullptr || pMesh->GetNumberOfLODs() == 0) continue;
+
+            const Dt::CEntity* pEntity = pDtComponent->GetHostEntity();
+
+            CShadowCasterCache::SCaster Caster;
+
+            Caster.m_ID        = pEntity->GetID();
+            Caster.m_TimeStamp = pEntity->GetHierarchyFacet() != nullptr ? pEntity->GetHierarchyFacet()->GetTimeStamp() : 0;
+            Caster.m_IsStatic  = pEntity->IsDynamic() == false;
+
+            // -----------------------------------------------------------------------------
+            // World space bounds of the mesh; meshes without bounds are never culled
+            // -----------------------------------------------------------------------------
+            const Base::AABB3Float AABB = pMesh->GetAABB();
+
+            if (AABB.GetMin() == AABB.GetMax())
+            {
+                Caster.m_Min = glm::vec3(-FLT_MAX);
+                Caster.m_Max = glm::vec3( FLT_MAX);
+            }
+            else
+            {
+                const glm::mat4& rWorldMatrix = pEntity->GetTransformationFacet()->GetWorldMatrix();
+
+                Caster.m_Min = glm::vec3( FLT_MAX);
+                Caster.m_Max = glm::vec3(-FLT_MAX);
+
+                for (int IndexOfCorner = 0; IndexOfCorner < 8; ++IndexOfCorner)
+                {
+                    glm::vec3 Corner;
+
+                    Corner.x = (IndexOfCorner & 1) != 0 ? AABB.GetMax().x : AABB.GetMin().x;
+                    Corner.y = (IndexOfCorner & 2) != 0 ? AABB.GetMax().y : AABB.GetMin().y;
+                    Corner.z = (IndexOfCorner & 4) != 0 ? AABB.GetMax().z : AABB.GetMin().z;
+
+                    const glm::vec3 WSCorner = glm::vec3(rWorldMatrix * glm::vec4(Corner, 1.0f));
+
+                    Caster.m_Min = glm::min(Caster.m_Min, WSCorner);
+                    Caster.m_Max = glm::max(Caster.m_Max, WSCorner);
+                }
+            }
+
+            m_ShadowCasters         .push_back(Caster);
+            m_ShadowCasterComponents.push_back(pDtComponent);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CGfxPointLightManager::RenderShadows(CInternObject& _rInternLight, const Dt::CPointLightComponent* _pDtPointLight, unsigned int _DirtyFlags)
     {
-        if (_rInternLight.m_CurrentShadowType == Dt::CPointLightComponent::NoShadows) return;
+        const CShadowCasterCache& rShadowCasterCache = _rInternLight.m_ShadowCasterCache;
+
+        CTargetSetPtr   ShadowTargetSetPtr   = _rInternLight.m_RenderContextPtr->GetTargetSet();
+        CViewPortSetPtr ShadowViewPortSetPtr = _rInternLight.m_RenderContextPtr->GetViewPortSet();
 
         Performance::BeginEvent("Point Light Shadows");
-        
+
+        if (rShadowCasterCache.HasDynamicCasters() == false)
+        {
+            // -----------------------------------------------------------------------------
+            // Only static casters are visible, so they go straight into the map
+            // -----------------------------------------------------------------------------
+            RenderShadowCasters(_rInternLight, _pDtPointLight, ShadowTargetSetPtr, ShadowViewPortSetPtr, true, rShadowCasterCache.GetStaticCasters());
+
+            _rInternLight.m_IsStaticCacheValid = false;
+        }
+        else
+        {
+            // -----------------------------------------------------------------------------
+            // Static casters are kept in their own map and only rendered if they
+            // changed; the dynamic casters are drawn on top of a copy of it.
+            // -----------------------------------------------------------------------------
+            if (_rInternLight.m_StaticTargetSetPtr == nullptr) CreateStaticShadowCache(_rInternLight);
+
+            if ((_DirtyFlags & CShadowCasterCache::DirtyStatic) != 0 || _rInternLight.m_IsStaticCacheValid == false)
+            {
+                RenderShadowCasters(_rInternLight, _pDtPointLight, _rInternLight.m_StaticTargetSetPtr, _rInternLight.m_StaticViewPortSetPtr, true, rShadowCasterCache.GetStaticCasters());
+
+                _rInternLight.m_IsStaticCacheValid = true;
+            }
+
+            CTextureSetPtr ShadowTextureSetPtr = _rInternLight.m_TextureRSMPtr != nullptr ? _rInternLight.m_TextureRSMPtr : _rInternLight.m_TextureSMPtr;
+
+            if (_rInternLight.m_AtlasTile != CShadowAtlasAllocator::s_InvalidTile)
+            {
+                CShadowAtlasAllocator::STile Tile = m_ShadowAtlas.GetTile(_rInternLight.m_AtlasTile);
+
+                TextureManager::CopyTexture(_rInternLight.m_StaticTextureSetPtr->GetTexture(0), ShadowTextureSetPtr->GetTexture(0), glm::ivec2(0), glm::ivec2(Tile.m_Offset), glm::ivec2(Tile.m_Size));
+            }
+            else
+            {
+                for (unsigned int IndexOfTexture = 0; IndexOfTexture < ShadowTextureSetPtr->GetNumberOfTextures(); ++IndexOfTexture)
+                {
+                    TextureManager::CopyTexture(_rInternLight.m_StaticTextureSetPtr->GetTexture(IndexOfTexture), ShadowTextureSetPtr->GetTexture(IndexOfTexture));
+                }
+            }
+
+            RenderShadowCasters(_rInternLight, _pDtPointLight, ShadowTargetSetPtr, ShadowViewPortSetPtr, false, rShadowCasterCache.GetDynamicCasters());
+        }
+
+        Performance::EndEvent();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CGfxPointLightManager::RenderShadowCasters(CInternObject& _rInternLight, const Dt::CPointLightComponent* _pDtPointLight, CTargetSetPtr _TargetSetPtr, CViewPortSetPtr _ViewPortSetPtr, bool _ClearTargetSet, const CShadowCasterCache::CIndices& _rCasters)
+    {
+        glm::vec3 LightPosition = _pDtPointLight->GetHostEntity()->GetWorldPosition();
+
         // -----------------------------------------------------------------------------
         // Prepare shadow
         // -----------------------------------------------------------------------------
-        TargetSetManager::ClearTargetSet(_rInternLight.m_RenderContextPtr->GetTargetSet());
+        if (_ClearTargetSet)
+        {
+            if (_TargetSetPtr == m_ShadowAtlasTargetSetPtr)
+            {
+                CShadowAtlasAllocator::STile Tile = m_ShadowAtlas.GetTile(_rInternLight.m_AtlasTile);
+
+                TargetSetManager::ClearTargetSet(_TargetSetPtr, 1.0f, Base::AABB2UInt(Tile.m_Offset, Tile.m_Offset + Tile.m_Size));
+            }
+            else
+            {
+                TargetSetManager::ClearTargetSet(_TargetSetPtr);
+            }
+        }
             
         // -----------------------------------------------------------------------------
         // Set light as render target
         // -----------------------------------------------------------------------------
         ContextManager::SetRenderContext(_rInternLight.m_RenderContextPtr);
+
+        ContextManager::SetTargetSet(_TargetSetPtr);
+
+        ContextManager::SetViewPortSet(_ViewPortSetPtr);
    
         // -----------------------------------------------------------------------------
         // Upload data light view projection matrix
@@ -673,15 +1169,11 @@ namespace
         BufferManager::UploadBufferData(m_LightCameraVSBufferPtr->GetBuffer(0), &ViewBuffer);
             
         // -----------------------------------------------------------------------------
-        // Iterate throw every component inside this map
+        // Iterate throw every visible caster
         // -----------------------------------------------------------------------------
-        auto DataMeshComponents = Dt::CComponentManager::GetInstance().GetComponents<Dt::CMeshComponent>();
-
-        for (auto Component : DataMeshComponents)
+        for (int IndexOfCaster : _rCasters)
         {
-            Dt::CMeshComponent* pDtComponent = static_cast<Dt::CMeshComponent*>(Component);
-
-            if (pDtComponent->IsActiveAndUsable() == false) continue;
+            Dt::CMeshComponent* pDtComponent = m_ShadowCasterComponents[IndexOfCaster];
 
             CMesh* pMesh = static_cast<CMesh*>(pDtComponent->GetFacet(Dt::CMeshComponent::Graphic));
 
@@ -750,7 +1242,7 @@ namespace
                 float AngleScale = _pDtPointLight->GetAngleScale();
                 float AngleOffset = _pDtPointLight->GetAngleOffset();
 
-                PunctualLightProperties.m_LightPosition  = glm::vec4(_rLightPosition, 1.0f);
+                PunctualLightProperties.m_LightPosition  = glm::vec4(LightPosition, 1.0f);
                 PunctualLightProperties.m_LightDirection = glm::normalize(glm::vec4(_pDtPointLight->GetDirection(), 0.0f));
                 PunctualLightProperties.m_LightColor     = glm::vec4(_pDtPointLight->GetLightness(), 1.0f);
                 PunctualLightProperties.m_LightSettings  = glm::vec4(InvSqrAttenuationRadius, AngleScale, AngleOffset, 0.0f);
@@ -806,8 +1298,6 @@ namespace
         ContextManager::ResetShaderPS();
             
         ContextManager::ResetRenderContext();
-
-        Performance::EndEvent();
     }
 } // namespace 
 
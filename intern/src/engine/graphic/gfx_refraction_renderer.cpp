@@ -935,7 +935,7 @@ namespace
             {
                 assert(pGfxComponent->GetCamera().IsValid());
 
-                LightProperties[IndexOfLight].m_LightViewProjection = pGfxComponent->GetCamera()->GetViewProjectionMatrix();
+                LightProperties[IndexOfLight].m_LightViewProjection = pGfxComponent->GetShadowMatrix();
             }
 
             // -----------------------------------------------------------------------------
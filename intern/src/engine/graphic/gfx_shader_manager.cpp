@@ -3,8 +3,10 @@
 
 #include "base/base_crc.h"
 #include "base/base_exception.h"
+#include "base/base_json.h"
 #include "base/base_managed_pool.h"
 #include "base/base_singleton.h"
+#include "base/base_thread_pool.h"
 #include "base/base_uncopyable.h"
 
 #include "engine/core/core_asset_manager.h"
@@ -17,10 +19,25 @@
 #include "engine/graphic/gfx_shader_manager.h"
 
 #include <assert.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <exception>
 #include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#ifdef PLATFORM_ANDROID
+#include <sys/stat.h>
+#else
+#include <filesystem>
+#endif
 
 using namespace Gfx;
 using namespace Gfx::ShaderManager;
@@ -28,6 +45,105 @@ using namespace Gfx::ShaderManager;
 namespace
 {
     static const char* g_PathToDataShader = "/graphic/shaders/";
+
+    static const char* g_PathToShaderCache = "/shader_cache/";
+
+    static const char* g_ManifestFileName = "manifest.json";
+
+    static const char g_IncludeDirective[] = "#include";
+
+    static const char* g_VersionOpenGL = "#version 450 \n";
+
+    static const char* g_VersionOpenGLES =
+        "#version 320 es \n"
+        "precision highp float; \n"
+        "precision lowp sampler2DShadow; \n"
+        "precision lowp uimage2D; \n"
+        "precision lowp image3D; \n"
+        "precision lowp image2D; \n"
+        "precision lowp samplerCube; \n"
+        "precision lowp sampler3D; \n"
+        "precision lowp sampler2D; \n";
+
+    static const uint32_t g_ProgramBinaryMagic = 0x31425053;
+
+    // -----------------------------------------------------------------------------
+    // Head of a program binary file. The file name is only a 32 bit hash, so
+    // the complete key is stored and compared on load: the length and a 64 bit
+    // hash of the source and the driver string that follows the header.
+    // -----------------------------------------------------------------------------
+    struct SProgramBinaryHeader
+    {
+        uint32_t m_Magic;
+        uint32_t m_SourceLength;
+        uint64_t m_SourceHash;
+        uint32_t m_DriverInfoLength;
+        uint32_t m_BinaryFormat;
+    };
+} // namespace
+
+namespace
+{
+    uint64_t GetSourceHash(const std::string& _rSource)
+    {
+        uint64_t Hash = 14695981039346656037ull;
+
+        for (unsigned char Character : _rSource)
+        {
+            Hash = (Hash ^ Character) * 1099511628211ull;
+        }
+
+        return Hash;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    std::string GetPathToShaderFile(const std::string& _rFileName)
+    {
+#ifdef PLATFORM_ANDROID
+        return Core::AssetManager::GetPathToData() + g_PathToDataShader + _rFileName;
+#else
+        std::filesystem::path PathToFile(Core::AssetManager::GetPathToData() + g_PathToDataShader + _rFileName);
+
+        return PathToFile.lexically_normal().generic_string();
+#endif
+    }
+
+    // -----------------------------------------------------------------------------
+    // Returns zero if the time is not available, so such files are never
+    // considered as changed.
+    // -----------------------------------------------------------------------------
+    long long GetModificationTime(const std::string& _rPathToFile)
+    {
+#ifdef PLATFORM_ANDROID
+        struct stat FileStatus;
+
+        return stat(_rPathToFile.c_str(), &FileStatus) == 0 ? static_cast<long long>(FileStatus.st_mtime) : 0;
+#else
+        std::error_code ErrorCode;
+
+        std::filesystem::file_time_type ModificationTime = std::filesystem::last_write_time(_rPathToFile, ErrorCode);
+
+        return ErrorCode ? 0 : static_cast<long long>(ModificationTime.time_since_epoch().count());
+#endif
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool MakeDirectory(const std::string& _rPathToDirectory)
+    {
+#ifdef PLATFORM_ANDROID
+        struct stat DirectoryStatus;
+
+        return stat(_rPathToDirectory.c_str(), &DirectoryStatus) == 0 || mkdir(_rPathToDirectory.c_str(), 0755) == 0;
+#else
+        std::error_code ErrorCode;
+
+        std::filesystem::create_directories(_rPathToDirectory, ErrorCode);
+
+        return std::filesystem::is_directory(_rPathToDirectory, ErrorCode);
+#endif
+    }
 } // namespace
 
 namespace
@@ -118,6 +234,51 @@ namespace
 
         typedef std::unordered_map<unsigned int, CShaderPtr> CShaderByIDs;
 
+    private:
+
+        // -----------------------------------------------------------------------------
+        // Content of a shader file on disk. It is read again only if the
+        // modification time of the file changed.
+        // -----------------------------------------------------------------------------
+        struct SShaderFile
+        {
+            std::string m_Content;
+            long long   m_ModificationTime;
+        };
+
+        // -----------------------------------------------------------------------------
+        // Complete source of one permutation (file, shader name, defines and API)
+        // together with every file it was built from.
+        // -----------------------------------------------------------------------------
+        struct SPreprocessedShader
+        {
+            typedef std::pair<std::string, long long> CDependency;
+
+            std::string              m_Source;
+            std::vector<CDependency> m_Dependencies;
+        };
+
+        // -----------------------------------------------------------------------------
+        // Every permutation compiled from a file is recorded, so the next start
+        // can compile all of them before the first frame instead of on demand.
+        // -----------------------------------------------------------------------------
+        struct SManifestEntry
+        {
+            CShader::EType m_Type;
+            std::string    m_FileName;
+            std::string    m_ShaderName;
+            std::string    m_ShaderDefines;
+            bool           m_HasAlpha;
+            bool           m_Debug;
+        };
+
+        typedef std::shared_ptr<const SShaderFile>                    CShaderFilePtr;
+        typedef std::unordered_map<std::string, CShaderFilePtr>       CShaderFiles;
+        typedef std::unordered_map<std::string, SPreprocessedShader>  CPreprocessedShaders;
+        typedef std::unordered_set<std::string>                       CIncludedFiles;
+        typedef std::vector<SManifestEntry>                           CManifest;
+        typedef std::unordered_set<unsigned int>                      CManifestHashes;
+
     private:
 
         CInputLayouts m_InputLayouts;
@@ -125,13 +286,56 @@ namespace
 
         CShaderByIDs    m_ShaderByID;
 
+        CShaderFiles         m_ShaderFiles;
+        CPreprocessedShaders m_PreprocessedShaders;
+
+        std::mutex m_CacheMutex;
+
+        std::vector<std::string> m_Errors;      //< Of the worker threads, reported on the main thread
+
+        CManifest       m_Manifest;
+        CManifestHashes m_ManifestHashes;
+        bool            m_IsManifestDirty;
+
+        std::string  m_PathToCache;
+        unsigned int m_DriverHash;
+        std::string  m_DriverInfo;
+        bool         m_UseShaderCache;
+        bool         m_UseProgramBinaries;
+
     private:
 
         CShaderPtr InternCompileShader(CShader::EType _Type, const Base::Char* _pFileName, const Base::Char* _pShaderName, const Base::Char* _pShaderDefines, const Base::Char* _pShaderDescription, unsigned int _Categories, bool _HasAlpha, bool _Debug, bool _IsCode);
 
         void InternReloadShader(CInternShader* _pInternShader);
 
-        void PreprocessorShader(std::string& _rShaderContent, bool _AddVersion);
+        unsigned int GetShaderHash(CShader::EType _Type, const Base::Char* _pFileName, const Base::Char* _pShaderName, const Base::Char* _pShaderDefines) const;
+
+        CShaderPtr RegisterShader(CShader::EType _Type, unsigned int _Hash, const Base::Char* _pFileName, const Base::Char* _pShaderName, const Base::Char* _pShaderDefines, bool _HasAlpha, bool _Debug, GLuint _NativeProgram);
+
+        GLuint CompileProgram(CShader::EType _Type, const std::string& _rSource, const std::string& _rLabel);
+        GLuint BeginCompile(CShader::EType _Type, const char* _pSource, const std::string& _rLabel);
+        GLuint EndCompile(GLuint _NativeShader, const char* _pSource, const std::string& _rLabel);
+
+        unsigned int GetBinaryHash(const std::string& _rSource) const;
+        GLuint LoadProgramBinary(unsigned int _BinaryHash, const std::string& _rSource);
+        void SaveProgramBinary(unsigned int _BinaryHash, const std::string& _rSource, GLuint _NativeProgram);
+
+        void LoadManifest();
+        void SaveManifest();
+        void RecordManifestEntry(unsigned int _Hash, CShader::EType _Type, const Base::Char* _pFileName, const Base::Char* _pShaderName, const Base::Char* _pShaderDefines, bool _HasAlpha, bool _Debug);
+
+        void WarmUpShaders();
+
+        const SPreprocessedShader* PreprocessorShader(const std::string& _rFileName, const std::string& _rShaderName, const std::string& _rShaderDefines, bool& _rIsUpToDate);
+
+        void ExpandIncludes(const std::string& _rContent, std::string& _rOutput, CIncludedFiles& _rIncludedFiles, SPreprocessedShader& _rShader);
+
+        CShaderFilePtr LoadShaderFile(const std::string& _rPathToFile);
+
+        bool IsUpToDate(const SPreprocessedShader& _rShader) const;
+
+        void ReportErrors();
 
         int ConvertShaderType(CShader::EType _Type);
 
@@ -144,11 +348,25 @@ namespace
 namespace
 {
     CGfxShaderManager::CGfxShaderManager()
-        : m_InputLayouts()
-        , m_Shaders     ()
-        , m_ShaderByID  ()
+        : m_InputLayouts       ()
+        , m_Shaders            ()
+        , m_ShaderByID         ()
+        , m_ShaderFiles        ()
+        , m_PreprocessedShaders()
+        , m_CacheMutex         ()
+        , m_Errors             ()
+        , m_Manifest           ()
+        , m_ManifestHashes     ()
+        , m_IsManifestDirty    (false)
+        , m_PathToCache        ()
+        , m_DriverHash         (0)
+        , m_DriverInfo         ()
+        , m_UseShaderCache     (false)
+        , m_UseProgramBinaries (false)
     {
         m_ShaderByID.reserve(128);
+        m_ShaderFiles.reserve(128);
+        m_PreprocessedShaders.reserve(128);
     }
 
     // -----------------------------------------------------------------------------
@@ -161,6 +379,48 @@ namespace
 
     void CGfxShaderManager::OnStart()
     {
+        m_UseShaderCache = Core::CProgramParameters::GetInstance().Get("graphics:shader_cache:enable", true);
+
+        if (!m_UseShaderCache) return;
+
+        m_PathToCache = Core::AssetManager::GetPathToFiles() + g_PathToShaderCache;
+
+        if (!MakeDirectory(m_PathToCache))
+        {
+            ENGINE_CONSOLE_WARNINGV("Shader cache folder %s could not be created. Shaders are compiled on demand.", m_PathToCache.c_str());
+
+            m_UseShaderCache = false;
+
+            return;
+        }
+
+        // -----------------------------------------------------------------------------
+        // Program binaries are only valid for exactly the same driver, so the
+        // driver identification is part of the key of every binary.
+        // -----------------------------------------------------------------------------
+        const CGraphicsInfo::EGraphicAPI GraphicsAPI = Main::GetGraphicsAPI().m_GraphicsAPI;
+
+        m_DriverInfo = GraphicsAPI == CGraphicsInfo::OpenGLES ? "OpenGLES" : "OpenGL";
+
+        for (GLenum Name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+        {
+            const char* pInfo = reinterpret_cast<const char*>(glGetString(Name));
+
+            m_DriverInfo += '\n';
+            m_DriverInfo += pInfo != nullptr ? pInfo : "";
+        }
+
+        m_DriverHash = Base::CRC32(m_DriverInfo.c_str(), static_cast<unsigned int>(m_DriverInfo.length()));
+
+        GLint NumberOfBinaryFormats = 0;
+
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &NumberOfBinaryFormats);
+
+        m_UseProgramBinaries = NumberOfBinaryFormats > 0;
+
+        LoadManifest();
+
+        WarmUpShaders();
     }
 
     // -----------------------------------------------------------------------------
@@ -169,8 +429,21 @@ namespace
     {
         unsigned int ShaderType;
 
+        if (m_UseShaderCache && m_IsManifestDirty)
+        {
+            SaveManifest();
+        }
+
+        m_Manifest.clear();
+        m_ManifestHashes.clear();
+
+        m_IsManifestDirty = false;
+
         m_ShaderByID.clear();
 
+        m_ShaderFiles.clear();
+        m_PreprocessedShaders.clear();
+
         m_InputLayouts.Clear();
 
         for (ShaderType = 0; ShaderType < CShader::NumberOfTypes; ++ ShaderType)
@@ -335,14 +608,7 @@ namespace
         // -----------------------------------------------------------------------------
         // Create hash and try to take an existing shader
         // -----------------------------------------------------------------------------
-        unsigned int Hash = Base::CRC32(_pFileName, static_cast<unsigned int>(strlen(_pFileName)));
-        Hash              = Base::CRC32(Hash, _pShaderName, static_cast<unsigned int>(strlen(_pShaderName)));
-        Hash              = Base::CRC32(Hash, &_Type, sizeof(CShader::EType));
-
-        if (_pShaderDefines != 0)
-        {
-            Hash = Base::CRC32(Hash, _pShaderDefines, static_cast<unsigned int>(strlen(_pShaderDefines)));
-        }
+        unsigned int Hash = GetShaderHash(_Type, _pFileName, _pShaderName, _pShaderDefines);
 
         if (m_ShaderByID.find(Hash) != m_ShaderByID.end())
         {
@@ -350,146 +616,107 @@ namespace
         }
 
         // -----------------------------------------------------------------------------
-        // Load file data from given filename
+        // Load file data from given filename. Files and complete sources are
+        // cached, so permutations of the same file share all disk accesses.
         // -----------------------------------------------------------------------------
-        std::string ShaderContent;
-        std::string ShaderLabel;
+        GLuint NativeProgramHandle = 0;
 
         if (_IsCode)
         {
-            ShaderContent = std::string(_pFileName);
-
-            ShaderLabel = "Internal Shader : " + std::string(_pShaderName);
-        }
-        else
-        {
-            std::string PathToShader = Core::AssetManager::GetPathToData() + g_PathToDataShader + _pFileName;
+            std::string ShaderCode;
 
-            std::ifstream ShaderFile(PathToShader.c_str());
-
-            if (!ShaderFile.is_open())
+            if (_pShaderDefines != 0)
             {
-                BASE_THROWV("Shader '%s' can't be opened!", PathToShader.c_str());
+                ShaderCode = std::string(_pShaderDefines) + "\n";
             }
 
-            ShaderContent = std::string((std::istreambuf_iterator<char>(ShaderFile)), std::istreambuf_iterator<char>());
-
-            ShaderLabel = std::string(_pFileName) + " : " + std::string(_pShaderName);
-        }
-
-        if (_pShaderDefines != 0)
-        {
-            ShaderContent = std::string(_pShaderDefines) + "\n" + ShaderContent;
-        }
+            ShaderCode += _pFileName;
 
-        if (!_IsCode)
-        {
-            ShaderContent = "#define " + std::string(_pShaderName) + " main\n" + ShaderContent;
+            std::string ShaderLabel = "Internal Shader : " + std::string(_pShaderName);
 
-            PreprocessorShader(ShaderContent, true);
+            NativeProgramHandle = EndCompile(BeginCompile(_Type, ShaderCode.c_str(), ShaderLabel), ShaderCode.c_str(), ShaderLabel);
         }
-
-        const char* pRAW = ShaderContent.c_str();
-
-        // -----------------------------------------------------------------------------
-        // Create and compile shader
-        //
-        // Warning: When linking shaders with separable programs, your shaders must
-        // redeclare the gl_PerVertex interface block if you attempt to use any of
-        // the variables defined within it.
-        // -----------------------------------------------------------------------------
-        GLuint NativeProgramHandle = 0;
-        GLuint NativeShaderHandle  = 0;
-        GLint  Error;
-
-        NativeShaderHandle = glCreateShader(ConvertShaderType(_Type));
-
-        if (NativeShaderHandle != 0)
+        else
         {
-            glObjectLabel(GL_SHADER, NativeShaderHandle, -1, ShaderLabel.c_str());
+            bool IsUpToDate;
 
-            glShaderSource(NativeShaderHandle, 1, &pRAW, NULL);
-
-            glCompileShader(NativeShaderHandle);
+            const SPreprocessedShader* pPreprocessedShader = PreprocessorShader(_pFileName, _pShaderName, _pShaderDefines != 0 ? _pShaderDefines : "", IsUpToDate);
 
-            glGetShaderiv(NativeShaderHandle, GL_COMPILE_STATUS, &Error);
+            ReportErrors();
 
-            if (!Error)
+            if (pPreprocessedShader == nullptr)
             {
-                GLint InfoLength = 0;
-                glGetShaderiv(NativeShaderHandle, GL_INFO_LOG_LENGTH, &InfoLength);
-
-                char* pErrorInfo = new char[InfoLength];
-                glGetShaderInfoLog(NativeShaderHandle, InfoLength, &InfoLength, pErrorInfo);
-
-                ENGINE_CONSOLE_ERRORV("Error creating shader '%s' with error log:\n%s\n", ShaderLabel.c_str(), pErrorInfo);
-
-// #define GFX_SHADER_SHOW_SOURCE_ON_ERROR
-#ifdef GFX_SHADER_SHOW_SOURCE_ON_ERROR
-                ENGINE_CONSOLE_INFO("Full source code of shader:");
-                std::stringstream Line;
-                int LineNumber = 0;
+                BASE_THROWV("Shader '%s' can't be opened!", GetPathToShaderFile(_pFileName).c_str());
+            }
 
-                for (int i = 0; i < strlen(pRAW); ++i)
-                {
-                    if (pRAW[i] == '\n')
-                    {
-                        ENGINE_CONSOLE_INFOV("%i: %s", LineNumber, Line.str().c_str());
+            NativeProgramHandle = CompileProgram(_Type, pPreprocessedShader->m_Source, std::string(_pFileName) + " : " + std::string(_pShaderName));
 
-                        Line.str("");
+            RecordManifestEntry(Hash, _Type, _pFileName, _pShaderName, _pShaderDefines, _HasAlpha, _Debug);
+        }
 
-                        LineNumber ++;
+        return RegisterShader(_Type, Hash, _pFileName, _pShaderName, _pShaderDefines, _HasAlpha, _Debug, NativeProgramHandle);
+    }
 
-                        continue;
-                    }
+    // -----------------------------------------------------------------------------
 
-                    Line << pRAW[i];
-                }
-#endif
+    void CGfxShaderManager::InternReloadShader(CInternShader* _pInternShader)
+    {
+        assert(_pInternShader != nullptr);
 
-                delete[] pErrorInfo;
-            }
+        CInternShader& rShader = *_pInternShader;
 
-            NativeProgramHandle = glCreateProgram();
+        // -----------------------------------------------------------------------------
+        // Load file data from given filename
+        // -----------------------------------------------------------------------------
+        bool IsUpToDate;
 
-            if (NativeProgramHandle != 0)
-            {
-                GLint CompileStatus;
+        const SPreprocessedShader* pPreprocessedShader = PreprocessorShader(rShader.m_FileName, rShader.m_ShaderName, rShader.m_ShaderDefines, IsUpToDate);
 
-                glGetShaderiv(NativeShaderHandle, GL_COMPILE_STATUS, &CompileStatus);
+        ReportErrors();
 
-                glProgramParameteri(NativeProgramHandle, GL_PROGRAM_SEPARABLE, GL_TRUE);
+        if (pPreprocessedShader == nullptr)
+        {
+            ENGINE_CONSOLE_ERRORV("Shader '%s' can't be opened!", GetPathToShaderFile(rShader.m_FileName).c_str());
 
-                if (CompileStatus != 0)
-                {
-                    glAttachShader(NativeProgramHandle, NativeShaderHandle);
+            return;
+        }
 
-                    glLinkProgram(NativeProgramHandle);
+        // -----------------------------------------------------------------------------
+        // Nothing to do if none of the files changed since the last compile
+        // -----------------------------------------------------------------------------
+        if (IsUpToDate && rShader.m_NativeShader != 0)
+        {
+            return;
+        }
 
-                    glDetachShader(NativeProgramHandle, NativeShaderHandle);
-                }
+        // -----------------------------------------------------------------------------
+        // Remove old shader and setup the engine shader
+        // -----------------------------------------------------------------------------
+        glDeleteProgram(rShader.m_NativeShader);
 
-                glGetProgramiv(NativeProgramHandle, GL_LINK_STATUS, &Error);
+        rShader.m_NativeShader = CompileProgram(rShader.m_Type, pPreprocessedShader->m_Source, rShader.m_FileName + " : " + rShader.m_ShaderName);
+    }
 
-                if (!Error)
-                {
-                    GLint InfoLength = 0;
-                    glGetProgramiv(NativeProgramHandle, GL_INFO_LOG_LENGTH, &InfoLength);
+    // -----------------------------------------------------------------------------
 
-                    char* pErrorInfo = new char[InfoLength];
-                    glGetProgramInfoLog(NativeProgramHandle, InfoLength, &InfoLength, pErrorInfo);
+    unsigned int CGfxShaderManager::GetShaderHash(CShader::EType _Type, const Base::Char* _pFileName, const Base::Char* _pShaderName, const Base::Char* _pShaderDefines) const
+    {
+        unsigned int Hash = Base::CRC32(_pFileName, static_cast<unsigned int>(strlen(_pFileName)));
+        Hash              = Base::CRC32(Hash, _pShaderName, static_cast<unsigned int>(strlen(_pShaderName)));
+        Hash              = Base::CRC32(Hash, &_Type, sizeof(CShader::EType));
 
-                    ENGINE_CONSOLE_ERRORV("Error creating a shader program for '%s' and linking shader: \n %s", ShaderLabel.c_str(), pErrorInfo);
+        if (_pShaderDefines != 0)
+        {
+            Hash = Base::CRC32(Hash, _pShaderDefines, static_cast<unsigned int>(strlen(_pShaderDefines)));
+        }
 
-                    delete[] pErrorInfo;
+        return Hash;
+    }
 
-                    glDeleteProgram(NativeProgramHandle);
-                }
-            }
-        }
-    
-        glDeleteShader(NativeShaderHandle);
+    // -----------------------------------------------------------------------------
 
+    CShaderPtr CGfxShaderManager::RegisterShader(CShader::EType _Type, unsigned int _Hash, const Base::Char* _pFileName, const Base::Char* _pShaderName, const Base::Char* _pShaderDefines, bool _HasAlpha, bool _Debug, GLuint _NativeProgram)
+    {
         // -----------------------------------------------------------------------------
         // Create shader
         // -----------------------------------------------------------------------------
@@ -506,17 +733,17 @@ namespace
         rShader.m_ShaderName     = _pShaderName;
         rShader.m_Type           = _Type;
         rShader.m_Debug          = _Debug;
-        rShader.m_Hash           = Hash;
-        rShader.m_NativeShader   = NativeProgramHandle;
+        rShader.m_Hash           = _Hash;
+        rShader.m_NativeShader   = _NativeProgram;
 
         if (_pShaderDefines != 0) rShader.m_ShaderDefines = _pShaderDefines;
 
         // -----------------------------------------------------------------------------
         // Set current shader into hash map
         // -----------------------------------------------------------------------------
-        if (Hash != 0)
+        if (_Hash != 0)
         {
-            m_ShaderByID[Hash] = ShaderPtr;
+            m_ShaderByID[_Hash] = ShaderPtr;
         }
 
         return ShaderPtr;
@@ -524,181 +751,668 @@ namespace
 
     // -----------------------------------------------------------------------------
 
-    void CGfxShaderManager::InternReloadShader(CInternShader* _pInternShader)
+    GLuint CGfxShaderManager::CompileProgram(CShader::EType _Type, const std::string& _rSource, const std::string& _rLabel)
     {
-        assert(_pInternShader != nullptr);
+        const unsigned int BinaryHash = GetBinaryHash(_rSource);
 
-        CInternShader& rShader = *_pInternShader;
+        GLuint NativeProgramHandle = LoadProgramBinary(BinaryHash, _rSource);
 
-        // -----------------------------------------------------------------------------
-        // Remove old shader
-        // -----------------------------------------------------------------------------
-        glDeleteProgram(rShader.m_NativeShader);
+        if (NativeProgramHandle == 0)
+        {
+            NativeProgramHandle = EndCompile(BeginCompile(_Type, _rSource.c_str(), _rLabel), _rSource.c_str(), _rLabel);
 
-        // -----------------------------------------------------------------------------
-        // Build path to shader in file system
-        // -----------------------------------------------------------------------------
-        std::string PathToShader = Core::AssetManager::GetPathToData() + g_PathToDataShader + _pInternShader->GetFileName();
+            SaveProgramBinary(BinaryHash, _rSource, NativeProgramHandle);
+        }
 
-        // -----------------------------------------------------------------------------
-        // Load file data from given filename
-        // -----------------------------------------------------------------------------
-        Base::Size ShaderLength;
+        return NativeProgramHandle;
+    }
 
-        std::ifstream ShaderFile(PathToShader.c_str());
+    // -----------------------------------------------------------------------------
+    // Compiling is split into submitting the source and querying the result.
+    // Drivers compile in the background until the status is requested, so a
+    // batch of submits followed by a batch of queries overlaps the compiles.
+    // -----------------------------------------------------------------------------
+    GLuint CGfxShaderManager::BeginCompile(CShader::EType _Type, const char* _pSource, const std::string& _rLabel)
+    {
+        GLuint NativeShaderHandle = glCreateShader(ConvertShaderType(_Type));
 
-        assert(ShaderFile.is_open());
+        if (NativeShaderHandle != 0)
+        {
+            glObjectLabel(GL_SHADER, NativeShaderHandle, -1, _rLabel.c_str());
 
-        std::string ShaderFileContent((std::istreambuf_iterator<char>(ShaderFile)), std::istreambuf_iterator<char>());
+            glShaderSource(NativeShaderHandle, 1, &_pSource, NULL);
 
-        if (rShader.m_ShaderDefines.length() > 0)
-        {
-            ShaderFileContent = rShader.m_ShaderDefines + "\n" + ShaderFileContent;
+            glCompileShader(NativeShaderHandle);
         }
 
-        ShaderFileContent = "#define " + rShader.m_ShaderName + " main\n" + ShaderFileContent;
+        return NativeShaderHandle;
+    }
 
-        PreprocessorShader(ShaderFileContent, true);
-        
-        ShaderLength = ShaderFileContent.size();
+    // -----------------------------------------------------------------------------
 
-        const char* pRAW = ShaderFileContent.c_str();
+    GLuint CGfxShaderManager::EndCompile(GLuint _NativeShader, const char* _pSource, const std::string& _rLabel)
+    {
+        BASE_UNUSED(_pSource);
+
+        if (_NativeShader == 0) return 0;
 
         // -----------------------------------------------------------------------------
-        // Create and compile shader
+        // Create and link program
         //
         // Warning: When linking shaders with separable programs, your shaders must
         // redeclare the gl_PerVertex interface block if you attempt to use any of
         // the variables defined within it.
         // -----------------------------------------------------------------------------
         GLuint NativeProgramHandle = 0;
-        GLuint NativeShaderHandle = 0;
         GLint  Error;
 
-        NativeShaderHandle = glCreateShader(ConvertShaderType(rShader.m_Type));
+        glGetShaderiv(_NativeShader, GL_COMPILE_STATUS, &Error);
 
-        if (NativeShaderHandle != 0)
+        if (!Error)
         {
-            glObjectLabel(GL_SHADER, NativeShaderHandle, -1, (rShader.m_FileName + " : " + rShader.m_ShaderName).c_str());
+            GLint InfoLength = 0;
+            glGetShaderiv(_NativeShader, GL_INFO_LOG_LENGTH, &InfoLength);
 
-            glShaderSource(NativeShaderHandle, 1, &pRAW, NULL);
+            char* pErrorInfo = new char[InfoLength];
+            glGetShaderInfoLog(_NativeShader, InfoLength, &InfoLength, pErrorInfo);
 
-            glCompileShader(NativeShaderHandle);
+            ENGINE_CONSOLE_ERRORV("Error creating shader '%s' with error log:\n%s\n", _rLabel.c_str(), pErrorInfo);
+
+// #define GFX_SHADER_SHOW_SOURCE_ON_ERROR
+#ifdef GFX_SHADER_SHOW_SOURCE_ON_ERROR
+            ENGINE_CONSOLE_INFO("Full source code of shader:");
+            std::stringstream Line;
+            int LineNumber = 0;
+
+            for (int i = 0; i < strlen(_pSource); ++i)
+            {
+                if (_pSource[i] == '\n')
+                {
+                    ENGINE_CONSOLE_INFOV("%i: %s", LineNumber, Line.str().c_str());
+
+                    Line.str("");
+
+                    LineNumber ++;
+
+                    continue;
+                }
+
+                Line << _pSource[i];
+            }
+#endif
+
+            delete[] pErrorInfo;
+        }
+
+        NativeProgramHandle = glCreateProgram();
+
+        if (NativeProgramHandle != 0)
+        {
+            GLint CompileStatus;
 
-            glGetShaderiv(NativeShaderHandle, GL_COMPILE_STATUS, &Error);
+            glGetShaderiv(_NativeShader, GL_COMPILE_STATUS, &CompileStatus);
+
+            glProgramParameteri(NativeProgramHandle, GL_PROGRAM_SEPARABLE, GL_TRUE);
+
+            if (m_UseProgramBinaries)
+            {
+                glProgramParameteri(NativeProgramHandle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            }
+
+            if (CompileStatus != 0)
+            {
+                glAttachShader(NativeProgramHandle, _NativeShader);
+
+                glLinkProgram(NativeProgramHandle);
+
+                glDetachShader(NativeProgramHandle, _NativeShader);
+            }
+
+            glGetProgramiv(NativeProgramHandle, GL_LINK_STATUS, &Error);
 
             if (!Error)
             {
                 GLint InfoLength = 0;
-                glGetShaderiv(NativeShaderHandle, GL_INFO_LOG_LENGTH, &InfoLength);
+                glGetProgramiv(NativeProgramHandle, GL_INFO_LOG_LENGTH, &InfoLength);
 
                 char* pErrorInfo = new char[InfoLength];
-                glGetShaderInfoLog(NativeShaderHandle, InfoLength, &InfoLength, pErrorInfo);
+                glGetProgramInfoLog(NativeProgramHandle, InfoLength, &InfoLength, pErrorInfo);
 
-                ENGINE_CONSOLE_ERRORV("Error creating shader '%s' with info: \n %s", PathToShader.c_str(), pErrorInfo);
+                ENGINE_CONSOLE_ERRORV("Error creating a shader program for '%s' and linking shader: \n %s", _rLabel.c_str(), pErrorInfo);
 
                 delete[] pErrorInfo;
+
+                glDeleteProgram(NativeProgramHandle);
+
+                NativeProgramHandle = 0;
             }
+        }
+
+        glDeleteShader(_NativeShader);
+
+        return NativeProgramHandle;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    unsigned int CGfxShaderManager::GetBinaryHash(const std::string& _rSource) const
+    {
+        return Base::CRC32(m_DriverHash, _rSource.c_str(), static_cast<unsigned int>(_rSource.length()));
+    }
+
+    // -----------------------------------------------------------------------------
+    // A binary file holds the header, the driver string and the program
+    // binary. Binaries of another source or driver are ignored, and drivers
+    // may still reject binaries of an older version. In both cases the
+    // program is compiled from source again.
+    // -----------------------------------------------------------------------------
+    GLuint CGfxShaderManager::LoadProgramBinary(unsigned int _BinaryHash, const std::string& _rSource)
+    {
+        if (!m_UseProgramBinaries) return 0;
+
+        char FileName[16];
+
+        snprintf(FileName, sizeof(FileName), "%08x.bin", _BinaryHash);
+
+        std::ifstream BinaryFile((m_PathToCache + FileName).c_str(), std::ios::binary);
+
+        if (!BinaryFile.is_open()) return 0;
+
+        SProgramBinaryHeader Header;
+
+        if (!BinaryFile.read(reinterpret_cast<char*>(&Header), sizeof(Header))) return 0;
+
+        if (Header.m_Magic != g_ProgramBinaryMagic) return 0;
+        if (Header.m_SourceLength != _rSource.length() || Header.m_SourceHash != GetSourceHash(_rSource)) return 0;
+        if (Header.m_DriverInfoLength != m_DriverInfo.length()) return 0;
+
+        std::string DriverInfo(Header.m_DriverInfoLength, '\0');
+
+        if (!BinaryFile.read(&DriverInfo[0], DriverInfo.length()) || DriverInfo != m_DriverInfo) return 0;
+
+        std::vector<char> Binary((std::istreambuf_iterator<char>(BinaryFile)), std::istreambuf_iterator<char>());
+
+        if (!BinaryFile.good() && !BinaryFile.eof()) return 0;
+
+        if (Binary.empty()) return 0;
+
+        GLuint NativeProgramHandle = glCreateProgram();
+
+        if (NativeProgramHandle == 0) return 0;
+
+        glProgramParameteri(NativeProgramHandle, GL_PROGRAM_SEPARABLE, GL_TRUE);
+
+        glProgramBinary(NativeProgramHandle, Header.m_BinaryFormat, Binary.data(), static_cast<GLsizei>(Binary.size()));
+
+        GLint LinkStatus;
+
+        glGetProgramiv(NativeProgramHandle, GL_LINK_STATUS, &LinkStatus);
+
+        if (!LinkStatus)
+        {
+            glDeleteProgram(NativeProgramHandle);
+
+            return 0;
+        }
+
+        return NativeProgramHandle;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CGfxShaderManager::SaveProgramBinary(unsigned int _BinaryHash, const std::string& _rSource, GLuint _NativeProgram)
+    {
+        if (!m_UseProgramBinaries || _NativeProgram == 0) return;
+
+        GLint BinaryLength = 0;
+
+        glGetProgramiv(_NativeProgram, GL_PROGRAM_BINARY_LENGTH, &BinaryLength);
+
+        if (BinaryLength <= 0) return;
+
+        std::vector<char> Binary(BinaryLength);
+
+        GLenum BinaryFormat = 0;
+
+        glGetProgramBinary(_NativeProgram, BinaryLength, &BinaryLength, &BinaryFormat, Binary.data());
+
+        SProgramBinaryHeader Header;
+
+        Header.m_Magic            = g_ProgramBinaryMagic;
+        Header.m_SourceLength     = static_cast<uint32_t>(_rSource.length());
+        Header.m_SourceHash       = GetSourceHash(_rSource);
+        Header.m_DriverInfoLength = static_cast<uint32_t>(m_DriverInfo.length());
+        Header.m_BinaryFormat     = BinaryFormat;
 
-            NativeProgramHandle = glCreateProgram();
+        char FileName[16];
 
-            if (NativeProgramHandle != 0)
+        snprintf(FileName, sizeof(FileName), "%08x.bin", _BinaryHash);
+
+        std::ofstream BinaryFile((m_PathToCache + FileName).c_str(), std::ios::binary | std::ios::trunc);
+
+        if (!BinaryFile.is_open()) return;
+
+        BinaryFile.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+        BinaryFile.write(m_DriverInfo.data(), m_DriverInfo.length());
+        BinaryFile.write(Binary.data(), BinaryLength);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CGfxShaderManager::LoadManifest()
+    {
+        std::ifstream ManifestFile((m_PathToCache + g_ManifestFileName).c_str());
+
+        if (!ManifestFile.is_open()) return;
+
+        try
+        {
+            nlohmann::json Manifest = nlohmann::json::parse(ManifestFile);
+
+            for (const nlohmann::json& rEntry : Manifest)
             {
-                GLint CompileStatus;
+                SManifestEntry Entry;
+
+                Entry.m_Type          = static_cast<CShader::EType>(rEntry.at("type").get<int>());
+                Entry.m_FileName      = rEntry.at("file").get<std::string>();
+                Entry.m_ShaderName    = rEntry.at("name").get<std::string>();
+                Entry.m_ShaderDefines = rEntry.at("defines").get<std::string>();
+                Entry.m_HasAlpha      = rEntry.at("alpha").get<bool>();
+                Entry.m_Debug         = rEntry.at("debug").get<bool>();
 
-                glGetShaderiv(NativeShaderHandle, GL_COMPILE_STATUS, &CompileStatus);
+                if (Entry.m_Type < 0 || Entry.m_Type >= CShader::NumberOfTypes) continue;
 
-                glProgramParameteri(NativeProgramHandle, GL_PROGRAM_SEPARABLE, GL_TRUE);
+                unsigned int Hash = GetShaderHash(Entry.m_Type, Entry.m_FileName.c_str(), Entry.m_ShaderName.c_str(), Entry.m_ShaderDefines.c_str());
 
-                if (CompileStatus != 0)
+                if (m_ManifestHashes.insert(Hash).second)
                 {
-                    glAttachShader(NativeProgramHandle, NativeShaderHandle);
+                    m_Manifest.push_back(std::move(Entry));
+                }
+            }
+        }
+        catch (const std::exception& _rException)
+        {
+            ENGINE_CONSOLE_WARNINGV("Shader manifest could not be read (%s). Shaders are compiled on demand.", _rException.what());
 
-                    glLinkProgram(NativeProgramHandle);
+            m_Manifest.clear();
+            m_ManifestHashes.clear();
+        }
+    }
 
-                    glDetachShader(NativeProgramHandle, NativeShaderHandle);
-                }
+    // -----------------------------------------------------------------------------
 
-                glGetProgramiv(NativeProgramHandle, GL_LINK_STATUS, &Error);
+    void CGfxShaderManager::SaveManifest()
+    {
+        nlohmann::json Manifest = nlohmann::json::array();
 
-                if (!Error)
-                {
-                    GLint InfoLength = 0;
-                    glGetProgramiv(NativeProgramHandle, GL_INFO_LOG_LENGTH, &InfoLength);
+        for (const SManifestEntry& rEntry : m_Manifest)
+        {
+            Manifest.push_back(
+            {
+                { "type"   , static_cast<int>(rEntry.m_Type) },
+                { "file"   , rEntry.m_FileName },
+                { "name"   , rEntry.m_ShaderName },
+                { "defines", rEntry.m_ShaderDefines },
+                { "alpha"  , rEntry.m_HasAlpha },
+                { "debug"  , rEntry.m_Debug },
+            });
+        }
 
-                    char* pErrorInfo = new char[InfoLength];
-                    glGetProgramInfoLog(NativeProgramHandle, InfoLength, &InfoLength, pErrorInfo);
+        std::ofstream ManifestFile((m_PathToCache + g_ManifestFileName).c_str());
 
-                    ENGINE_CONSOLE_ERRORV("Error creating a shader program for '%s' and linking shader: \n %s", PathToShader.c_str(), pErrorInfo);
+        if (ManifestFile.is_open())
+        {
+            ManifestFile << std::setw(4) << Manifest << std::endl;
+        }
+        else
+        {
+            ENGINE_CONSOLE_ERRORV("Shader manifest %s could not be written.", (m_PathToCache + g_ManifestFileName).c_str());
+        }
+    }
 
-                    delete[] pErrorInfo;
+    // -----------------------------------------------------------------------------
 
-                    glDeleteProgram(NativeProgramHandle);
-                }
+    void CGfxShaderManager::RecordManifestEntry(unsigned int _Hash, CShader::EType _Type, const Base::Char* _pFileName, const Base::Char* _pShaderName, const Base::Char* _pShaderDefines, bool _HasAlpha, bool _Debug)
+    {
+        if (!m_UseShaderCache || !m_ManifestHashes.insert(_Hash).second) return;
+
+        SManifestEntry Entry;
+
+        Entry.m_Type          = _Type;
+        Entry.m_FileName      = _pFileName;
+        Entry.m_ShaderName    = _pShaderName;
+        Entry.m_ShaderDefines = _pShaderDefines != 0 ? _pShaderDefines : "";
+        Entry.m_HasAlpha      = _HasAlpha;
+        Entry.m_Debug         = _Debug;
+
+        m_Manifest.push_back(std::move(Entry));
+
+        m_IsManifestDirty = true;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Creates every shader of the manifest before the first frame. Sources are
+    // preprocessed on the worker threads (disk and string work only), then all
+    // programs without a valid binary are submitted before the first result is
+    // queried.
+    // -----------------------------------------------------------------------------
+    void CGfxShaderManager::WarmUpShaders()
+    {
+        const int NumberOfEntries = static_cast<int>(m_Manifest.size());
+
+        if (NumberOfEntries == 0) return;
+
+        auto StartTime = std::chrono::high_resolution_clock::now();
+
+        std::vector<const SPreprocessedShader*> PreprocessedShaders(NumberOfEntries, nullptr);
+
+        Base::CThreadPool::GetInstance().ParallelFor(NumberOfEntries, 1, [&](int _Begin, int _End)
+        {
+            for (int IndexOfEntry = _Begin; IndexOfEntry < _End; ++IndexOfEntry)
+            {
+                const SManifestEntry& rEntry = m_Manifest[IndexOfEntry];
+
+                bool IsUpToDate;
+
+                PreprocessedShaders[IndexOfEntry] = PreprocessorShader(rEntry.m_FileName, rEntry.m_ShaderName, rEntry.m_ShaderDefines, IsUpToDate);
+            }
+        });
+
+        ReportErrors();
+
+        std::vector<GLuint>       NativeShaders (NumberOfEntries, 0);
+        std::vector<GLuint>       NativePrograms(NumberOfEntries, 0);
+        std::vector<unsigned int> BinaryHashes  (NumberOfEntries, 0);
+
+        int NumberOfBinaries = 0;
+
+        for (int IndexOfEntry = 0; IndexOfEntry < NumberOfEntries; ++IndexOfEntry)
+        {
+            const SManifestEntry& rEntry = m_Manifest[IndexOfEntry];
+
+            if (PreprocessedShaders[IndexOfEntry] == nullptr) continue;
+
+            const std::string& rSource = PreprocessedShaders[IndexOfEntry]->m_Source;
+
+            BinaryHashes  [IndexOfEntry] = GetBinaryHash(rSource);
+            NativePrograms[IndexOfEntry] = LoadProgramBinary(BinaryHashes[IndexOfEntry], rSource);
+
+            if (NativePrograms[IndexOfEntry] != 0)
+            {
+                ++NumberOfBinaries;
+
+                continue;
             }
+
+            NativeShaders[IndexOfEntry] = BeginCompile(rEntry.m_Type, rSource.c_str(), rEntry.m_FileName + " : " + rEntry.m_ShaderName);
         }
 
-        glDeleteShader(NativeShaderHandle);
+        // -----------------------------------------------------------------------------
+        // Entries whose file is gone are dropped from the manifest
+        // -----------------------------------------------------------------------------
+        CManifest Manifest;
+
+        Manifest.reserve(NumberOfEntries);
+
+        for (int IndexOfEntry = 0; IndexOfEntry < NumberOfEntries; ++IndexOfEntry)
+        {
+            SManifestEntry& rEntry = m_Manifest[IndexOfEntry];
+
+            if (PreprocessedShaders[IndexOfEntry] == nullptr)
+            {
+                m_IsManifestDirty = true;
+
+                continue;
+            }
+
+            if (NativeShaders[IndexOfEntry] != 0)
+            {
+                NativePrograms[IndexOfEntry] = EndCompile(NativeShaders[IndexOfEntry], PreprocessedShaders[IndexOfEntry]->m_Source.c_str(), rEntry.m_FileName + " : " + rEntry.m_ShaderName);
+
+                SaveProgramBinary(BinaryHashes[IndexOfEntry], PreprocessedShaders[IndexOfEntry]->m_Source, NativePrograms[IndexOfEntry]);
+            }
+
+            const char* pShaderDefines = rEntry.m_ShaderDefines.empty() ? nullptr : rEntry.m_ShaderDefines.c_str();
+
+            unsigned int Hash = GetShaderHash(rEntry.m_Type, rEntry.m_FileName.c_str(), rEntry.m_ShaderName.c_str(), pShaderDefines);
+
+            RegisterShader(rEntry.m_Type, Hash, rEntry.m_FileName.c_str(), rEntry.m_ShaderName.c_str(), pShaderDefines, rEntry.m_HasAlpha, rEntry.m_Debug, NativePrograms[IndexOfEntry]);
+
+            Manifest.push_back(std::move(rEntry));
+        }
+
+        m_Manifest.swap(Manifest);
+
+        auto Duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - StartTime);
+
+        ENGINE_CONSOLE_INFOV("Warmed up %i shaders (%i from program binaries) in %i ms.", static_cast<int>(m_Manifest.size()), NumberOfBinaries, static_cast<int>(Duration.count()));
+    }
+
+    // -----------------------------------------------------------------------------
+
+    const CGfxShaderManager::SPreprocessedShader* CGfxShaderManager::PreprocessorShader(const std::string& _rFileName, const std::string& _rShaderName, const std::string& _rShaderDefines, bool& _rIsUpToDate)
+    {
+        const CGraphicsInfo::EGraphicAPI GraphicsAPI = Main::GetGraphicsAPI().m_GraphicsAPI;
 
         // -----------------------------------------------------------------------------
-        // Setup the engine shader
+        // The permutation itself is the key. The parts are separated by a
+        // character that can not appear in any of them, so different inputs
+        // never share a key.
+        // -----------------------------------------------------------------------------
+        std::string Key;
+
+        Key.reserve(_rFileName.length() + _rShaderName.length() + _rShaderDefines.length() + 4);
+
+        Key += _rFileName;
+        Key += '\0';
+        Key += _rShaderName;
+        Key += '\0';
+        Key += _rShaderDefines;
+        Key += '\0';
+        Key += static_cast<char>('0' + GraphicsAPI);
+
+        {
+            std::lock_guard<std::mutex> Lock(m_CacheMutex);
+
+            CPreprocessedShaders::iterator Iterator = m_PreprocessedShaders.find(Key);
+
+            _rIsUpToDate = Iterator != m_PreprocessedShaders.end() && IsUpToDate(Iterator->second);
+
+            if (_rIsUpToDate)
+            {
+                return &Iterator->second;
+            }
+        }
+
+        std::string PathToShader = GetPathToShaderFile(_rFileName);
+
+        CShaderFilePtr ShaderFilePtr = LoadShaderFile(PathToShader);
+
+        if (ShaderFilePtr == nullptr)
+        {
+            return nullptr;
+        }
+
+        // -----------------------------------------------------------------------------
+        // The source is built outside of the lock, so several permutations can
+        // be preprocessed at the same time.
+        // -----------------------------------------------------------------------------
+        SPreprocessedShader Shader;
+
+        Shader.m_Dependencies.emplace_back(PathToShader, ShaderFilePtr->m_ModificationTime);
+
+        // -----------------------------------------------------------------------------
+        // Version, entry point and defines go first, then the file with all of its
+        // includes is written into the same buffer.
         // -----------------------------------------------------------------------------
-        rShader.m_NativeShader = NativeProgramHandle;
+        std::string& rSource = Shader.m_Source;
+
+        rSource.reserve(ShaderFilePtr->m_Content.size() * 2);
+
+        rSource += GraphicsAPI == CGraphicsInfo::OpenGLES ? g_VersionOpenGLES : g_VersionOpenGL;
+
+        rSource += "#define ";
+        rSource += _rShaderName;
+        rSource += " main\n";
+
+        if (!_rShaderDefines.empty())
+        {
+            rSource += _rShaderDefines;
+            rSource += "\n";
+        }
+
+        CIncludedFiles IncludedFiles;
+
+        IncludedFiles.insert(PathToShader);
+
+        ExpandIncludes(ShaderFilePtr->m_Content, rSource, IncludedFiles, Shader);
+
+        std::lock_guard<std::mutex> Lock(m_CacheMutex);
+
+        SPreprocessedShader& rShader = m_PreprocessedShaders[Key];
+
+        rShader = std::move(Shader);
+
+        return &rShader;
     }
 
     // -----------------------------------------------------------------------------
 
-    void CGfxShaderManager::PreprocessorShader(std::string& _rShaderContent, bool _AddVersion)
+    void CGfxShaderManager::ExpandIncludes(const std::string& _rContent, std::string& _rOutput, CIncludedFiles& _rIncludedFiles, SPreprocessedShader& _rShader)
     {
-        Base::Size FoundPosition     = 0;
-        Base::Size UndefinedPosition = std::string::npos;
+        const Base::Size DirectiveLength = sizeof(g_IncludeDirective) - 1;
 
-        while (FoundPosition != UndefinedPosition)
+        Base::Size CopyPosition  = 0;
+        Base::Size FoundPosition = _rContent.find(g_IncludeDirective);
+
+        while (FoundPosition != std::string::npos)
         {
-            FoundPosition = _rShaderContent.find("#include", FoundPosition);
+            // -----------------------------------------------------------------------------
+            // Only directives at the beginning of a line are expanded, so includes
+            // mentioned in comments are left as they are.
+            // -----------------------------------------------------------------------------
+            Base::Size BeginOfLine = FoundPosition;
 
-            if (FoundPosition != UndefinedPosition)
+            while (BeginOfLine > 0 && (_rContent[BeginOfLine - 1] == ' ' || _rContent[BeginOfLine - 1] == '\t'))
             {
-                Base::Size BeginOfInclude = _rShaderContent.find('\"', FoundPosition) + 1;
-                Base::Size EndOfInclude   = _rShaderContent.find('\"', BeginOfInclude);
+                --BeginOfLine;
+            }
 
-                std::string IncludeFile  = Core::AssetManager::GetPathToData() + g_PathToDataShader + _rShaderContent.substr(BeginOfInclude, EndOfInclude - BeginOfInclude);
+            Base::Size EndOfLine      = _rContent.find('\n', FoundPosition);
+            Base::Size BeginOfInclude = _rContent.find('\"', FoundPosition);
+            Base::Size EndOfInclude   = BeginOfInclude != std::string::npos ? _rContent.find('\"', BeginOfInclude + 1) : std::string::npos;
+
+            if ((BeginOfLine > 0 && _rContent[BeginOfLine - 1] != '\n') || EndOfInclude == std::string::npos || EndOfInclude > EndOfLine)
+            {
+                FoundPosition = _rContent.find(g_IncludeDirective, FoundPosition + DirectiveLength);
 
-                // -----------------------------------------------------------------------------
-                // Load included file and replace include directive with new file
-                // content. Furthermore check new file content on include directives.
-                // -----------------------------------------------------------------------------
-                std::ifstream ShaderFile(IncludeFile.c_str());
+                continue;
+            }
 
-                std::string ShaderFileContent((std::istreambuf_iterator<char>(ShaderFile)), std::istreambuf_iterator<char>());
+            _rOutput.append(_rContent, CopyPosition, FoundPosition - CopyPosition);
 
-                PreprocessorShader(ShaderFileContent, false);
+            CopyPosition  = EndOfInclude + 1;
+            FoundPosition = _rContent.find(g_IncludeDirective, CopyPosition);
 
-                _rShaderContent.replace(FoundPosition, EndOfInclude - FoundPosition + 1, ShaderFileContent);
+            std::string PathToInclude = GetPathToShaderFile(_rContent.substr(BeginOfInclude + 1, EndOfInclude - BeginOfInclude - 1));
 
-                FoundPosition += 1;
+            // -----------------------------------------------------------------------------
+            // Every file is included once per shader
+            // -----------------------------------------------------------------------------
+            if (!_rIncludedFiles.insert(PathToInclude).second)
+            {
+                continue;
             }
+
+            CShaderFilePtr IncludeFilePtr = LoadShaderFile(PathToInclude);
+
+            if (IncludeFilePtr == nullptr)
+            {
+                std::lock_guard<std::mutex> Lock(m_CacheMutex);
+
+                m_Errors.push_back("Shader include '" + PathToInclude + "' can't be opened!");
+
+                continue;
+            }
+
+            _rShader.m_Dependencies.emplace_back(PathToInclude, IncludeFilePtr->m_ModificationTime);
+
+            ExpandIncludes(IncludeFilePtr->m_Content, _rOutput, _rIncludedFiles, _rShader);
         }
 
-        if (_AddVersion)
+        _rOutput.append(_rContent, CopyPosition, std::string::npos);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CGfxShaderManager::CShaderFilePtr CGfxShaderManager::LoadShaderFile(const std::string& _rPathToFile)
+    {
+        long long ModificationTime = GetModificationTime(_rPathToFile);
+
         {
-            if (Main::GetGraphicsAPI().m_GraphicsAPI == CGraphicsInfo::OpenGLES)
+            std::lock_guard<std::mutex> Lock(m_CacheMutex);
+
+            CShaderFiles::iterator Iterator = m_ShaderFiles.find(_rPathToFile);
+
+            if (Iterator != m_ShaderFiles.end() && Iterator->second->m_ModificationTime == ModificationTime)
             {
-                _rShaderContent = "precision lowp sampler2D; \n" + _rShaderContent;
-                _rShaderContent = "precision lowp sampler3D; \n" + _rShaderContent;
-                _rShaderContent = "precision lowp samplerCube; \n" + _rShaderContent;
-                _rShaderContent = "precision lowp image2D; \n" + _rShaderContent;
-                _rShaderContent = "precision lowp image3D; \n" + _rShaderContent;
-                _rShaderContent = "precision lowp uimage2D; \n" + _rShaderContent;
-                _rShaderContent = "precision lowp sampler2DShadow; \n" + _rShaderContent;
-                _rShaderContent = "precision highp float; \n" + _rShaderContent;
-                _rShaderContent = "#version 320 es \n" + _rShaderContent;
+                return Iterator->second;
             }
-            else
+        }
+
+        std::ifstream ShaderFile(_rPathToFile.c_str());
+
+        if (!ShaderFile.is_open())
+        {
+            return nullptr;
+        }
+
+        std::shared_ptr<SShaderFile> ShaderFilePtr = std::make_shared<SShaderFile>();
+
+        ShaderFilePtr->m_Content.assign(std::istreambuf_iterator<char>(ShaderFile), std::istreambuf_iterator<char>());
+        ShaderFilePtr->m_ModificationTime = ModificationTime;
+
+        std::lock_guard<std::mutex> Lock(m_CacheMutex);
+
+        m_ShaderFiles[_rPathToFile] = ShaderFilePtr;
+
+        return ShaderFilePtr;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CGfxShaderManager::IsUpToDate(const SPreprocessedShader& _rShader) const
+    {
+        for (const SPreprocessedShader::CDependency& rDependency : _rShader.m_Dependencies)
+        {
+            if (GetModificationTime(rDependency.first) != rDependency.second)
             {
-                _rShaderContent = "#version 450 \n" + _rShaderContent;
+                return false;
             }
         }
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Preprocessing runs on the worker threads during the warm up, but the
+    // console delegates of the editor expect the main thread. Errors are
+    // collected there and written from here.
+    // -----------------------------------------------------------------------------
+    void CGfxShaderManager::ReportErrors()
+    {
+        std::vector<std::string> Errors;
+
+        {
+            std::lock_guard<std::mutex> Lock(m_CacheMutex);
+
+            Errors.swap(m_Errors);
+        }
+
+        for (const std::string& rError : Errors)
+        {
+            ENGINE_CONSOLE_ERRORV("%s", rError.c_str());
+        }
     }
 
     // -----------------------------------------------------------------------------
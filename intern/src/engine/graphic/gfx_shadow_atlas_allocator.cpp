@@ -0,0 +1,415 @@
+
+#include "engine/engine_precompiled.h"
+
+#include "engine/graphic/gfx_shadow_atlas_allocator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // -----------------------------------------------------------------------------
+    // A tile keeps its size while the wanted resolution stays inside of this
+    // band; prevents lights from flipping between two sizes every frame.
+    // -----------------------------------------------------------------------------
+    const float s_UpgradeFactor   = 1.75f;
+    const float s_DowngradeFactor = 0.4f;
+
+    // -----------------------------------------------------------------------------
+
+    bool IsPowerOfTwo(unsigned int _Value)
+    {
+        return _Value != 0 && (_Value & (_Value - 1)) == 0;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    unsigned int RoundToPowerOfTwo(float _Value)
+    {
+        if (_Value <= 1.0f) return 1;
+
+        const int Exponent = std::min(static_cast<int>(std::round(std::log2(_Value))), 31);
+
+        return 1u << Exponent;
+    }
+} // namespace
+
+namespace Gfx
+{
+    CShadowAtlasAllocator::CShadowAtlasAllocator()
+        : m_Size              (0)
+        , m_MinTileSize       (0)
+        , m_NumberOfLevels    (0)
+        , m_NumberOfUsedTexels(0)
+        , m_States            ()
+        , m_FreeNodes         ()
+        , m_PendingTiles      ()
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CShadowAtlasAllocator::~CShadowAtlasAllocator()
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CShadowAtlasAllocator::Initialize(unsigned int _Size, unsigned int _MinTileSize)
+    {
+        assert(IsPowerOfTwo(_Size) && IsPowerOfTwo(_MinTileSize) && _MinTileSize <= _Size);
+
+        m_Size           = _Size;
+        m_MinTileSize    = _MinTileSize;
+        m_NumberOfLevels = GetLevelOfSize(_MinTileSize) + 1;
+
+        m_States   .resize(GetFirstNodeOfLevel(m_NumberOfLevels));
+        m_FreeNodes.resize(m_NumberOfLevels);
+
+        Clear();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CShadowAtlasAllocator::Clear()
+    {
+        std::fill(m_States.begin(), m_States.end(), static_cast<Base::U8>(NodeUnused));
+
+        for (auto& rFreeNodes : m_FreeNodes) rFreeNodes.clear();
+
+        m_NumberOfUsedTexels = 0;
+
+        if (m_NumberOfLevels == 0) return;
+
+        m_States[0] = NodeFree;
+
+        m_FreeNodes[0].push_back(0);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CShadowAtlasAllocator::Allocate(unsigned int _Size)
+    {
+        assert(IsPowerOfTwo(_Size) && _Size >= m_MinTileSize && _Size <= m_Size);
+
+        const int Level = GetLevelOfSize(_Size);
+
+        const int Node = FindFreeNode(Level);
+
+        if (Node < 0) return s_InvalidTile;
+
+        const int Tile = GetFirstNodeOfLevel(Level) + Node;
+
+        m_States[Tile] = NodeUsed;
+
+        m_NumberOfUsedTexels += static_cast<Base::U64>(_Size) * _Size;
+
+        return Tile;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CShadowAtlasAllocator::Free(int _Tile)
+    {
+        assert(_Tile >= 0 && _Tile < static_cast<int>(m_States.size()) && m_States[_Tile] == NodeUsed);
+
+        int Level = GetLevelOfNode(_Tile);
+        int Node  = _Tile - GetFirstNodeOfLevel(Level);
+
+        const Base::U64 Size = m_Size >> Level;
+
+        m_NumberOfUsedTexels -= Size * Size;
+
+        // -----------------------------------------------------------------------------
+        // Merge with the siblings as long as all of them are free
+        // -----------------------------------------------------------------------------
+        for (; Level > 0; --Level)
+        {
+            const int FirstNode = GetFirstNodeOfLevel(Level);
+            const int Side      = 1 << Level;
+            const int ParentX   = (Node % Side) / 2;
+            const int ParentY   = (Node / Side) / 2;
+
+            int Siblings[4];
+
+            bool AreSiblingsFree = true;
+
+            for (int IndexOfChild = 0; IndexOfChild < 4; ++IndexOfChild)
+            {
+                Siblings[IndexOfChild] = (ParentY * 2 + IndexOfChild / 2) * Side + ParentX * 2 + IndexOfChild % 2;
+
+                AreSiblingsFree &= Siblings[IndexOfChild] == Node || m_States[FirstNode + Siblings[IndexOfChild]] == NodeFree;
+            }
+
+            if (!AreSiblingsFree) break;
+
+            std::vector<int>& rFreeNodes = m_FreeNodes[Level];
+
+            for (int Sibling : Siblings)
+            {
+                m_States[FirstNode + Sibling] = NodeUnused;
+
+                if (Sibling == Node) continue;
+
+                auto Position = std::find(rFreeNodes.begin(), rFreeNodes.end(), Sibling);
+
+                assert(Position != rFreeNodes.end());
+
+                *Position = rFreeNodes.back();
+
+                rFreeNodes.pop_back();
+            }
+
+            Node = ParentY * (Side / 2) + ParentX;
+        }
+
+        m_States[GetFirstNodeOfLevel(Level) + Node] = NodeFree;
+
+        m_FreeNodes[Level].push_back(Node);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CShadowAtlasAllocator::STile CShadowAtlasAllocator::GetTile(int _Tile) const
+    {
+        assert(_Tile >= 0 && _Tile < static_cast<int>(m_States.size()));
+
+        const int Level = GetLevelOfNode(_Tile);
+        const int Node  = _Tile - GetFirstNodeOfLevel(Level);
+        const int Side  = 1 << Level;
+
+        STile Tile;
+
+        Tile.m_Size   = m_Size >> Level;
+        Tile.m_Offset = glm::uvec2(Node % Side, Node / Side) * Tile.m_Size;
+
+        return Tile;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CShadowAtlasAllocator::UpdateTiles(const unsigned int* _pSizes, int _NumberOfTiles, int* _pTiles)
+    {
+        assert((_pSizes != nullptr && _pTiles != nullptr) || _NumberOfTiles == 0);
+
+        m_PendingTiles.clear();
+
+        for (int IndexOfTile = 0; IndexOfTile < _NumberOfTiles; ++IndexOfTile)
+        {
+            int& rTile = _pTiles[IndexOfTile];
+
+            if (rTile != s_InvalidTile && GetTile(rTile).m_Size != _pSizes[IndexOfTile])
+            {
+                Free(rTile);
+
+                rTile = s_InvalidTile;
+            }
+
+            if (rTile == s_InvalidTile) m_PendingTiles.push_back(IndexOfTile);
+        }
+
+        if (AllocateTiles(_pSizes, _pTiles)) return true;
+
+        // -----------------------------------------------------------------------------
+        // Too fragmented: pack everything again
+        // -----------------------------------------------------------------------------
+        Clear();
+
+        m_PendingTiles.clear();
+
+        for (int IndexOfTile = 0; IndexOfTile < _NumberOfTiles; ++IndexOfTile)
+        {
+            _pTiles[IndexOfTile] = s_InvalidTile;
+
+            m_PendingTiles.push_back(IndexOfTile);
+        }
+
+        return AllocateTiles(_pSizes, _pTiles);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    unsigned int CShadowAtlasAllocator::GetSize() const
+    {
+        return m_Size;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    unsigned int CShadowAtlasAllocator::GetMinTileSize() const
+    {
+        return m_MinTileSize;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Base::U64 CShadowAtlasAllocator::GetNumberOfUsedTexels() const
+    {
+        return m_NumberOfUsedTexels;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CShadowAtlasAllocator::SelectTileSizes(const SRequest* _pRequests, int _NumberOfRequests, unsigned int _MaxTileSize, Base::U64 _TexelBudget, unsigned int* _pSizes) const
+    {
+        assert((_pRequests != nullptr && _pSizes != nullptr) || _NumberOfRequests == 0);
+
+        const unsigned int MaxTileSize = std::max(std::min(_MaxTileSize, m_Size), m_MinTileSize);
+
+        auto GetWantedSize = [&](const SRequest& _rRequest)
+        {
+            return static_cast<float>(MaxTileSize) * std::min(std::max(_rRequest.m_Coverage, 0.0f), 1.0f) * _rRequest.m_Importance;
+        };
+
+        // -----------------------------------------------------------------------------
+        // Size of every light on its own
+        // -----------------------------------------------------------------------------
+        Base::U64 NumberOfTexels = 0;
+
+        for (int IndexOfRequest = 0; IndexOfRequest < _NumberOfRequests; ++IndexOfRequest)
+        {
+            const SRequest& rRequest = _pRequests[IndexOfRequest];
+
+            const float WantedSize = GetWantedSize(rRequest);
+
+            unsigned int Size = rRequest.m_CurrentSize;
+
+            if (Size == 0 || WantedSize >= Size * s_UpgradeFactor || WantedSize <= Size * s_DowngradeFactor)
+            {
+                Size = RoundToPowerOfTwo(WantedSize);
+            }
+
+            Size = std::min(std::max(Size, m_MinTileSize), MaxTileSize);
+
+            _pSizes[IndexOfRequest] = Size;
+
+            NumberOfTexels += static_cast<Base::U64>(Size) * Size;
+        }
+
+        // -----------------------------------------------------------------------------
+        // Halve the tile that has the most texels compared to its wanted size
+        // until everything fits into the budget
+        // -----------------------------------------------------------------------------
+        while (NumberOfTexels > _TexelBudget)
+        {
+            int   BestRequest = -1;
+            float BestRatio   = 0.0f;
+
+            for (int IndexOfRequest = 0; IndexOfRequest < _NumberOfRequests; ++IndexOfRequest)
+            {
+                if (_pSizes[IndexOfRequest] <= m_MinTileSize) continue;
+
+                const float Ratio = static_cast<float>(_pSizes[IndexOfRequest]) / std::max(GetWantedSize(_pRequests[IndexOfRequest]), 1.0f);
+
+                if (BestRequest < 0 || Ratio > BestRatio || (Ratio == BestRatio && _pSizes[IndexOfRequest] > _pSizes[BestRequest]))
+                {
+                    BestRequest = IndexOfRequest;
+                    BestRatio   = Ratio;
+                }
+            }
+
+            if (BestRequest < 0) break;
+
+            const Base::U64 Size = _pSizes[BestRequest];
+
+            NumberOfTexels -= Size * Size - (Size / 2) * (Size / 2);
+
+            _pSizes[BestRequest] /= 2;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CShadowAtlasAllocator::FindFreeNode(int _Level)
+    {
+        std::vector<int>& rFreeNodes = m_FreeNodes[_Level];
+
+        if (!rFreeNodes.empty())
+        {
+            const int Node = rFreeNodes.back();
+
+            rFreeNodes.pop_back();
+
+            return Node;
+        }
+
+        if (_Level == 0) return -1;
+
+        // -----------------------------------------------------------------------------
+        // Split a free node of the level above
+        // -----------------------------------------------------------------------------
+        const int Parent = FindFreeNode(_Level - 1);
+
+        if (Parent < 0) return -1;
+
+        m_States[GetFirstNodeOfLevel(_Level - 1) + Parent] = NodeSplit;
+
+        const int FirstNode = GetFirstNodeOfLevel(_Level);
+        const int Side      = 1 << _Level;
+        const int ParentX   = Parent % (Side / 2);
+        const int ParentY   = Parent / (Side / 2);
+
+        for (int IndexOfChild = 3; IndexOfChild > 0; --IndexOfChild)
+        {
+            const int Child = (ParentY * 2 + IndexOfChild / 2) * Side + ParentX * 2 + IndexOfChild % 2;
+
+            m_States[FirstNode + Child] = NodeFree;
+
+            rFreeNodes.push_back(Child);
+        }
+
+        return ParentY * 2 * Side + ParentX * 2;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Biggest tiles first; that way an empty atlas can always take all tiles as
+    // long as their texels fit into it.
+    // -----------------------------------------------------------------------------
+    bool CShadowAtlasAllocator::AllocateTiles(const unsigned int* _pSizes, int* _pTiles)
+    {
+        std::stable_sort(m_PendingTiles.begin(), m_PendingTiles.end(), [&](int _Left, int _Right)
+        {
+            return _pSizes[_Left] > _pSizes[_Right];
+        });
+
+        bool HasAllTiles = true;
+
+        for (int IndexOfTile : m_PendingTiles)
+        {
+            _pTiles[IndexOfTile] = Allocate(_pSizes[IndexOfTile]);
+
+            HasAllTiles &= _pTiles[IndexOfTile] != s_InvalidTile;
+        }
+
+        return HasAllTiles;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CShadowAtlasAllocator::GetLevelOfSize(unsigned int _Size) const
+    {
+        int Level = 0;
+
+        for (unsigned int Size = m_Size; Size > _Size; Size /= 2) ++Level;
+
+        return Level;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CShadowAtlasAllocator::GetLevelOfNode(int _Node) const
+    {
+        int Level = 0;
+
+        while (Level + 1 < m_NumberOfLevels && _Node >= GetFirstNodeOfLevel(Level + 1)) ++Level;
+
+        return Level;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CShadowAtlasAllocator::GetFirstNodeOfLevel(int _Level)
+    {
+        return ((1 << (2 * _Level)) - 1) / 3;
+    }
+} // namespace Gfx
@@ -0,0 +1,108 @@
+
+#pragma once
+
+#include "engine/engine_config.h"
+
+#include "base/base_include_glm.h"
+#include "base/base_typedef.h"
+
+#include <vector>
+
+namespace Gfx
+{
+    // -----------------------------------------------------------------------------
+    // CPU side quadtree over a square shadow atlas. Tiles are squares with a
+    // power of two size between the minimum tile size and the atlas size; a
+    // tile keeps its place until it is freed, so lights can reuse the content
+    // of their tile over several frames.
+    // -----------------------------------------------------------------------------
+    class ENGINE_API CShadowAtlasAllocator
+    {
+    public:
+
+        static const int s_InvalidTile = -1;
+
+        struct STile
+        {
+            glm::uvec2   m_Offset;
+            unsigned int m_Size;
+        };
+
+        struct SRequest
+        {
+            float        m_Coverage;            //< Projected size on screen (1 = the whole screen)
+            float        m_Importance;          //< Scales the wanted resolution
+            unsigned int m_CurrentSize;         //< Size of the last frame or 0
+        };
+
+    public:
+
+        void Initialize(unsigned int _Size, unsigned int _MinTileSize);
+
+        void Clear();
+
+        int Allocate(unsigned int _Size);
+        void Free(int _Tile);
+
+        STile GetTile(int _Tile) const;
+
+        // -----------------------------------------------------------------------------
+        // Brings the tiles of a set of lights to the given sizes. Tiles with an
+        // unchanged size keep their place; if the free space is too fragmented
+        // every tile is packed again. Returns false if the sizes do not fit.
+        // -----------------------------------------------------------------------------
+        bool UpdateTiles(const unsigned int* _pSizes, int _NumberOfTiles, int* _pTiles);
+
+        unsigned int GetSize() const;
+        unsigned int GetMinTileSize() const;
+
+        Base::U64 GetNumberOfUsedTexels() const;
+
+        // -----------------------------------------------------------------------------
+        // Picks a power of two size for every request. Sizes only change if the
+        // wanted resolution left a band around the current size and are halved
+        // (worst resolved first) until the sum of texels fits the budget.
+        // -----------------------------------------------------------------------------
+        void SelectTileSizes(const SRequest* _pRequests, int _NumberOfRequests, unsigned int _MaxTileSize, Base::U64 _TexelBudget, unsigned int* _pSizes) const;
+
+    public:
+
+        CShadowAtlasAllocator();
+       ~CShadowAtlasAllocator();
+
+    private:
+
+        enum ENodeState
+        {
+            NodeUnused,                         //< Part of a bigger node
+            NodeFree,
+            NodeSplit,
+            NodeUsed,
+        };
+
+        using CStates    = std::vector<Base::U8>;
+        using CFreeNodes = std::vector<std::vector<int>>;
+        using CIndices   = std::vector<int>;
+
+    private:
+
+        int FindFreeNode(int _Level);
+
+        bool AllocateTiles(const unsigned int* _pSizes, int* _pTiles);
+
+        int GetLevelOfSize(unsigned int _Size) const;
+        int GetLevelOfNode(int _Node) const;
+
+        static int GetFirstNodeOfLevel(int _Level);
+
+    private:
+
+        unsigned int m_Size;
+        unsigned int m_MinTileSize;
+        int          m_NumberOfLevels;
+        Base::U64    m_NumberOfUsedTexels;
+        CStates      m_States;
+        CFreeNodes   m_FreeNodes;                //< Free nodes per level (index inside of the level)
+        CIndices     m_PendingTiles;
+    };
+} // namespace Gfx
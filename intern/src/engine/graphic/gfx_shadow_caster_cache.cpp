@@ -0,0 +1,164 @@
+
+#include "engine/engine_precompiled.h"
+
+#include "engine/graphic/gfx_shadow_caster_cache.h"
+
+namespace Gfx
+{
+    bool CShadowCasterCache::SEntry::operator == (const SEntry& _rOther) const
+    {
+        return m_ID == _rOther.m_ID && m_TimeStamp == _rOther.m_TimeStamp;
+    }
+} // namespace Gfx
+
+namespace Gfx
+{
+    CShadowCasterCache::CShadowCasterCache()
+        : m_ViewProjectionMatrix(1.0f)
+        , m_IsValid             (false)
+        , m_StaticEntries       ()
+        , m_DynamicEntries      ()
+        , m_NewStaticEntries    ()
+        , m_NewDynamicEntries   ()
+        , m_StaticCasters       ()
+        , m_DynamicCasters      ()
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CShadowCasterCache::~CShadowCasterCache()
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CShadowCasterCache::Invalidate()
+    {
+        m_IsValid = false;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CShadowCasterCache::IsValid() const
+    {
+        return m_IsValid;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    unsigned int CShadowCasterCache::Update(const glm::mat4& _rViewProjectionMatrix, const SCaster* _pCasters, int _NumberOfCasters)
+    {
+        assert(_pCasters != nullptr || _NumberOfCasters == 0);
+
+        // -----------------------------------------------------------------------------
+        // Frustum planes (Gribb/Hartmann); normals point inside
+        // -----------------------------------------------------------------------------
+        const glm::mat4 Transposed = glm::transpose(_rViewProjectionMatrix);
+
+        const glm::vec4 Planes[6] =
+        {
+            Transposed[3] + Transposed[0],
+            Transposed[3] - Transposed[0],
+            Transposed[3] + Transposed[1],
+            Transposed[3] - Transposed[1],
+            Transposed[3] + Transposed[2],
+            Transposed[3] - Transposed[2],
+        };
+
+        // -----------------------------------------------------------------------------
+        // Cull casters
+        // -----------------------------------------------------------------------------
+        m_StaticCasters .clear();
+        m_DynamicCasters.clear();
+
+        m_NewStaticEntries .clear();
+        m_NewDynamicEntries.clear();
+
+        for (int IndexOfCaster = 0; IndexOfCaster < _NumberOfCasters; ++IndexOfCaster)
+        {
+            const SCaster& rCaster = _pCasters[IndexOfCaster];
+
+            if (!IsIntersectingFrustum(Planes, rCaster)) continue;
+
+            if (rCaster.m_IsStatic)
+            {
+                m_StaticCasters.push_back(IndexOfCaster);
+
+                m_NewStaticEntries.push_back({ rCaster.m_ID, rCaster.m_TimeStamp });
+            }
+            else
+            {
+                m_DynamicCasters.push_back(IndexOfCaster);
+
+                m_NewDynamicEntries.push_back({ rCaster.m_ID, rCaster.m_TimeStamp });
+            }
+        }
+
+        // -----------------------------------------------------------------------------
+        // Compare with the state of the last update. Casters that left the
+        // frustum change the list as well, so they are covered too.
+        // -----------------------------------------------------------------------------
+        unsigned int DirtyFlags = 0;
+
+        if (!m_IsValid || _rViewProjectionMatrix != m_ViewProjectionMatrix || m_NewStaticEntries != m_StaticEntries)
+        {
+            DirtyFlags = DirtyStatic | DirtyDynamic;
+        }
+        else if (m_NewDynamicEntries != m_DynamicEntries)
+        {
+            DirtyFlags = DirtyDynamic;
+        }
+
+        m_ViewProjectionMatrix = _rViewProjectionMatrix;
+        m_IsValid              = true;
+
+        std::swap(m_StaticEntries , m_NewStaticEntries);
+        std::swap(m_DynamicEntries, m_NewDynamicEntries);
+
+        return DirtyFlags;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    const CShadowCasterCache::CIndices& CShadowCasterCache::GetStaticCasters() const
+    {
+        return m_StaticCasters;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    const CShadowCasterCache::CIndices& CShadowCasterCache::GetDynamicCasters() const
+    {
+        return m_DynamicCasters;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CShadowCasterCache::HasDynamicCasters() const
+    {
+        return !m_DynamicCasters.empty();
+    }
+
+    // -----------------------------------------------------------------------------
+    // The box is outside if its corner furthest along a plane normal is behind
+    // that plane.
+    // -----------------------------------------------------------------------------
+    bool CShadowCasterCache::IsIntersectingFrustum(const glm::vec4* _pPlanes, const SCaster& _rCaster)
+    {
+        for (int IndexOfPlane = 0; IndexOfPlane < 6; ++IndexOfPlane)
+        {
+            const glm::vec4& rPlane = _pPlanes[IndexOfPlane];
+
+            float Distance = rPlane.w;
+
+            Distance += rPlane.x * (rPlane.x > 0.0f ? _rCaster.m_Max.x : _rCaster.m_Min.x);
+            Distance += rPlane.y * (rPlane.y > 0.0f ? _rCaster.m_Max.y : _rCaster.m_Min.y);
+            Distance += rPlane.z * (rPlane.z > 0.0f ? _rCaster.m_Max.z : _rCaster.m_Min.z);
+
+            if (Distance < 0.0f) return false;
+        }
+
+        return true;
+    }
+} // namespace Gfx
@@ -0,0 +1,93 @@
+
+#pragma once
+
+#include "engine/engine_config.h"
+
+#include "base/base_include_glm.h"
+#include "base/base_typedef.h"
+
+#include <vector>
+
+namespace Gfx
+{
+    // -----------------------------------------------------------------------------
+    // Decides whether the shadow map of a light has to be rendered again. The
+    // casters are culled against the frustum of the light; the map is only
+    // dirty if the light moved or the set of visible casters or one of their
+    // time stamps changed since the last update.
+    //
+    // Static and dynamic casters are tracked separately, so a cached map of the
+    // static casters can be reused while only the dynamic ones are redrawn.
+    // -----------------------------------------------------------------------------
+    class ENGINE_API CShadowCasterCache
+    {
+    public:
+
+        enum EDirtyFlags
+        {
+            DirtyStatic  = 0x01,        //< Static casters (and therefore everything) have to be rendered
+            DirtyDynamic = 0x02,        //< Dynamic casters have to be rendered on top of the static ones
+        };
+
+        struct SCaster
+        {
+            Base::ID  m_ID;
+            glm::vec3 m_Min;            //< World space bounds; use +-FLT_MAX if unknown
+            glm::vec3 m_Max;
+            Base::U64 m_TimeStamp;      //< Changes whenever the caster moved
+            bool      m_IsStatic;
+        };
+
+        using CIndices = std::vector<int>;
+
+    public:
+
+        void Invalidate();
+
+        bool IsValid() const;
+
+        unsigned int Update(const glm::mat4& _rViewProjectionMatrix, const SCaster* _pCasters, int _NumberOfCasters);
+
+        // -----------------------------------------------------------------------------
+        // Indices into the casters of the last update that intersect the frustum
+        // -----------------------------------------------------------------------------
+        const CIndices& GetStaticCasters() const;
+        const CIndices& GetDynamicCasters() const;
+
+        bool HasDynamicCasters() const;
+
+    public:
+
+        CShadowCasterCache();
+       ~CShadowCasterCache();
+
+    private:
+
+        struct SEntry
+        {
+            Base::ID  m_ID;
+            Base::U64 m_TimeStamp;
+
+            bool operator == (const SEntry& _rOther) const;
+        };
+
+        using CEntries = std::vector<SEntry>;
+
+    private:
+
+        static bool IsIntersectingFrustum(const glm::vec4* _pPlanes, const SCaster& _rCaster);
+
+    private:
+
+        glm::mat4 m_ViewProjectionMatrix;
+        bool      m_IsValid;
+
+        CEntries m_StaticEntries;
+        CEntries m_DynamicEntries;
+        CEntries m_NewStaticEntries;
+        CEntries m_NewDynamicEntries;
+
+        CIndices m_StaticCasters;
+        CIndices m_DynamicCasters;
+    };
+} // namespace Gfx
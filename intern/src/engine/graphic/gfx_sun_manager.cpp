@@ -15,6 +15,7 @@
 #include "engine/data/data_component_manager.h"
 #include "engine/data/data_entity.h"
 #include "engine/data/data_entity_manager.h"
+#include "engine/data/data_hierarchy_facet.h"
 #include "engine/data/data_map.h"
 #include "engine/data/data_mesh_component.h"
 #include "engine/data/data_sun_component.h"
@@ -27,6 +28,7 @@
 #include "engine/graphic/gfx_performance.h"
 #include "engine/graphic/gfx_sampler_manager.h"
 #include "engine/graphic/gfx_shader_manager.h"
+#include "engine/graphic/gfx_shadow_caster_cache.h"
 #include "engine/graphic/gfx_state_manager.h"
 #include "engine/graphic/gfx_sun.h"
 #include "engine/graphic/gfx_sun_manager.h"
@@ -35,7 +37,9 @@
 #include "engine/graphic/gfx_texture_manager.h"
 #include "engine/graphic/gfx_view_manager.h"
 
+#include <cfloat>
 #include <map>
+#include <vector>
 
 using namespace Gfx;
 
@@ -80,6 +84,10 @@ namespace
         public:
 
             CRenderContextPtr m_RenderContextPtr;
+            CShadowCasterCache m_ShadowCasterCache;
+            CTexturePtr m_StaticTexturePtr;             //< Static casters only; created as soon as dynamic casters are visible
+            CTargetSetPtr m_StaticTargetSetPtr;
+            bool m_IsStaticCacheValid;
 
         private:
 
@@ -90,10 +98,17 @@ namespace
 
         typedef Base::CManagedPool<CInternSunComponent, 4, 0> CSuns;
 
+        typedef std::vector<CShadowCasterCache::SCaster> CShadowCasters;
+        typedef std::vector<Dt::CMeshComponent*> CShadowCasterComponents;
+
     private:
 
         CSuns m_Suns;
 
+        CShadowCasters m_ShadowCasters;
+        CShadowCasterComponents m_ShadowCasterComponents;
+        bool m_HasChangedShadowCasters;
+
         CShaderPtr m_ShadowSMShaderPSPtr;
         
         CBufferSetPtr m_LightCameraVSBufferPtr;
@@ -110,15 +125,27 @@ namespace
 
         void CreateSM(unsigned int _Size, CInternSunComponent* _pInternLight);
 
-        void RenderShadows(CInternSunComponent* _pInternLight);
+        void CreateStaticShadowCache(CInternSunComponent* _pInternLight);
+
+        void UpdateShadowCamera(CInternSunComponent* _pInternLight, const Dt::CSunComponent* _pDtSun);
+
+        void GatherShadowCasters();
+
+        void RenderShadows(CInternSunComponent* _pInternLight, unsigned int _DirtyFlags);
+
+        void RenderShadowCasters(CInternSunComponent* _pInternLight, CTargetSetPtr _TargetSetPtr, bool _ClearTargetSet, const CShadowCasterCache::CIndices& _rCasters);
     };
 } // namespace
 
 namespace
 {
     CGfxSunManager::CInternSunComponent::CInternSunComponent()
-        : CSun              ()
-        , m_RenderContextPtr()
+        : CSun                ()
+        , m_RenderContextPtr  ()
+        , m_ShadowCasterCache ()
+        , m_StaticTexturePtr  ()
+        , m_StaticTargetSetPtr()
+        , m_IsStaticCacheValid(false)
     {
         
     }
@@ -127,16 +154,21 @@ namespace
 
     CGfxSunManager::CInternSunComponent::~CInternSunComponent()
     {
-        m_RenderContextPtr = 0;
+        m_RenderContextPtr   = 0;
+        m_StaticTexturePtr   = 0;
+        m_StaticTargetSetPtr = 0;
     }
 } // namespace 
 
 namespace
 {
     CGfxSunManager::CGfxSunManager()
-        : m_Suns                  ()
-        , m_ShadowSMShaderPSPtr   ()
-        , m_LightCameraVSBufferPtr()
+        : m_Suns                   ()
+        , m_ShadowCasters          ()
+        , m_ShadowCasterComponents ()
+        , m_HasChangedShadowCasters(false)
+        , m_ShadowSMShaderPSPtr    ()
+        , m_LightCameraVSBufferPtr ()
     {
     }
     
@@ -198,6 +230,9 @@ namespace
     {
         m_Suns.Clear();
 
+        m_ShadowCasters         .clear();
+        m_ShadowCasterComponents.clear();
+
         m_ShadowSMShaderPSPtr    = 0;
         m_LightCameraVSBufferPtr = 0;
     }
@@ -206,6 +241,8 @@ namespace
 
     void CGfxSunManager::Update()
     {
+        GatherShadowCasters();
+
         auto DataComponents = Dt::CComponentManager::GetInstance().GetComponents<Dt::CSunComponent>();
 
         for (auto Component : DataComponents)
@@ -218,39 +255,31 @@ namespace
 
             assert(pGfxSunFacet != nullptr);
 
-            if (pDtComponent->GetRefreshMode() == Dt::CSunComponent::Dynamic || pGfxSunFacet->GetTimeStamp() >= Core::Time::GetNumberOfFrame())
+            if (m_HasChangedShadowCasters || pGfxSunFacet->GetTimeStamp() >= Core::Time::GetNumberOfFrame())
             {
-                // -----------------------------------------------------------------------------
-                // Calculate near and far plane
-                // -----------------------------------------------------------------------------
-                float Radius = pDtComponent->GetCustomDistanceToOrigin();
-
-                if (Radius <= 0.0f) Radius = static_cast<float>(glm::max(Dt::Map::GetNumberOfMetersX(), Dt::Map::GetNumberOfMetersY()));
-
-                float Near   = 1.0f;
-                float Far    = Radius * 3.14f;
+                pGfxSunFacet->m_ShadowCasterCache.Invalidate();
+            }
 
-                pGfxSunFacet->m_RenderContextPtr->GetCamera()->SetOrthographic(-Radius, Radius, -Radius, Radius, Near, Far);
+            // -----------------------------------------------------------------------------
+            // Static suns are only rendered again if the sun itself changed
+            // -----------------------------------------------------------------------------
+            if (pDtComponent->GetRefreshMode() != Dt::CSunComponent::Dynamic && pGfxSunFacet->m_ShadowCasterCache.IsValid()) continue;
 
-                // -----------------------------------------------------------------------------
-                // Set view depending on direction of the sun
-                // -----------------------------------------------------------------------------
-                glm::vec3 SunPosition    = glm::vec3(Radius / 2.0f, Radius / 2.0f, 0.0f) - glm::normalize(pDtComponent->GetDirection()) * Radius;
-                glm::mat3 RotationMatrix = glm::lookAt(SunPosition, glm::vec3(Radius / 2.0f, Radius / 2.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+            UpdateShadowCamera(pGfxSunFacet, pDtComponent);
 
-                Gfx::CViewPtr ShadowViewPtr = pGfxSunFacet->m_RenderContextPtr->GetCamera()->GetView();
+            // -----------------------------------------------------------------------------
+            // Render if the sun or one of the visible casters changed
+            // -----------------------------------------------------------------------------
+            const glm::mat4& rViewProjectionMatrix = pGfxSunFacet->m_RenderContextPtr->GetCamera()->GetViewProjectionMatrix();
 
-                ShadowViewPtr->SetPosition(SunPosition);
-                ShadowViewPtr->SetRotationMatrix(glm::transpose(RotationMatrix));
+            unsigned int DirtyFlags = pGfxSunFacet->m_ShadowCasterCache.Update(rViewProjectionMatrix, m_ShadowCasters.data(), static_cast<int>(m_ShadowCasters.size()));
 
-                ShadowViewPtr->Update();
+            if (DirtyFlags == 0) continue;
 
-                // -----------------------------------------------------------------------------
-                // Render
-                // -----------------------------------------------------------------------------
-                RenderShadows(pGfxSunFacet);
-            }
+            RenderShadows(pGfxSunFacet, DirtyFlags);
         }
+
+        m_HasChangedShadowCasters = false;
     }
 
     // -----------------------------------------------------------------------------
@@ -278,6 +307,17 @@ namespace
 
     void CGfxSunManager::OnDirtyComponent(Dt::IComponent* _pComponent)
     {
+        // -----------------------------------------------------------------------------
+        // The caster caches only track movements; a new mesh of a caster has
+        // to be rendered again as well.
+        // -----------------------------------------------------------------------------
+        if (_pComponent->GetTypeInfo() == Base::CTypeInfo::Get<Dt::CMeshComponent>())
+        {
+            m_HasChangedShadowCasters = true;
+
+            return;
+        }
+
         if (_pComponent->GetTypeInfo() != Base::CTypeInfo::Get<Dt::CSunComponent>()) return;
 
         Dt::CSunComponent* pSunComponent = static_cast<Dt::CSunComponent*>(_pComponent);
@@ -398,19 +438,185 @@ namespace
 
     // -----------------------------------------------------------------------------
 
-    void CGfxSunManager::RenderShadows(CInternSunComponent* _pInternLight)
+    void CGfxSunManager::CreateStaticShadowCache(CInternSunComponent* _pInternLight)
+    {
+        STextureDescriptor RendertargetDescriptor;
+        
+        RendertargetDescriptor.m_NumberOfPixelsU  = _pInternLight->m_TextureSMPtr->GetNumberOfPixelsU();
+        RendertargetDescriptor.m_NumberOfPixelsV  = _pInternLight->m_TextureSMPtr->GetNumberOfPixelsV();
+        RendertargetDescriptor.m_NumberOfPixelsW  = 1;
+        RendertargetDescriptor.m_NumberOfMipMaps  = 1;
+        RendertargetDescriptor.m_NumberOfTextures = 1;
+        RendertargetDescriptor.m_Access           = CTexture::CPUWrite;
+        RendertargetDescriptor.m_Usage            = CTexture::GPURead;
+        RendertargetDescriptor.m_Semantic         = CTexture::Diffuse;
+        RendertargetDescriptor.m_pFileName        = 0;
+        RendertargetDescriptor.m_pPixels          = 0;
+        RendertargetDescriptor.m_Binding          = CTexture::DepthStencilTarget | CTexture::RenderTarget;
+        RendertargetDescriptor.m_Format           = CTexture::R32_FLOAT;
+        
+        _pInternLight->m_StaticTexturePtr = TextureManager::CreateTexture2D(RendertargetDescriptor); // Depth only
+
+        TextureManager::SetTextureLabel(_pInternLight->m_StaticTexturePtr, "Sun: Static shadowmap");
+
+        _pInternLight->m_StaticTargetSetPtr = TargetSetManager::CreateTargetSet(_pInternLight->m_StaticTexturePtr);
+
+        TargetSetManager::SetTargetSetLabel(_pInternLight->m_StaticTargetSetPtr, "Sun: Static shadowmap");
+
+        _pInternLight->m_IsStaticCacheValid = false;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CGfxSunManager::UpdateShadowCamera(CInternSunComponent* _pInternLight, const Dt::CSunComponent* _pDtSun)
     {
+        // -----------------------------------------------------------------------------
+        // Calculate near and far plane
+        // -----------------------------------------------------------------------------
+        float Radius = _pDtSun->GetCustomDistanceToOrigin();
+
+        if (Radius <= 0.0f) Radius = static_cast<float>(glm::max(Dt::Map::GetNumberOfMetersX(), Dt::Map::GetNumberOfMetersY()));
+
+        float Near   = 1.0f;
+        float Far    = Radius * 3.14f;
+
+        _pInternLight->m_RenderContextPtr->GetCamera()->SetOrthographic(-Radius, Radius, -Radius, Radius, Near, Far);
+
+        // -----------------------------------------------------------------------------
+        // Set view depending on direction of the sun
+        // -----------------------------------------------------------------------------
+        glm::vec3 SunPosition    = glm::vec3(Radius / 2.0f, Radius / 2.0f, 0.0f) - glm::normalize(_pDtSun->GetDirection()) * Radius;
+        glm::mat3 RotationMatrix = glm::lookAt(SunPosition, glm::vec3(Radius / 2.0f, Radius / 2.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+
+        Gfx::CViewPtr ShadowViewPtr = _pInternLight->m_RenderContextPtr->GetCamera()->GetView();
+
+        ShadowViewPtr->SetPosition(SunPosition);
+        ShadowViewPtr->SetRotationMatrix(glm::transpose(RotationMatrix));
+
+        ShadowViewPtr->Update();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CGfxSunManager::GatherShadowCasters()
+    {
+        m_ShadowCasters         .clear();
+        m_ShadowCasterComponents.clear();
+
+        auto DataMeshComponents = Dt::CComponentManager::GetInstance().GetComponents<Dt::CMeshComponent>();
+
+        for (auto Component : DataMeshComponents)
+        {
+            Dt::CMeshComponent* pDtComponent = static_cast<Dt::CMeshComponent*>(Component);
+
+            if (pDtComponent->IsActiveAndUsable() == false) continue;
+
+            CMeshPtr MeshPtr = static_cast<CMesh*>(pDtComponent->GetFacet(Dt::CMeshComponent::Graphic));
+
+            if (MeshPtr == nullptr || MeshPtr->GetLOD(0) == nullptr || MeshPtr->GetLOD(0)->GetSurface() == nullptr) continue;
+
+            const Dt::CEntity* pEntity = pDtComponent->GetHostEntity();
+
+            CShadowCasterCache::SCaster Caster;
+
+            Caster.m_ID        = pEntity->GetID();
+            Caster.m_TimeStamp = pEntity->GetHierarchyFacet() != nullptr ? pEntity->GetHierarchyFacet()->GetTimeStamp() : 0;
+            Caster.m_IsStatic  = pEntity->IsDynamic() == false;
+
+            // -----------------------------------------------------------------------------
+            // World space bounds of the mesh; meshes without bounds are never culled
+            // -----------------------------------------------------------------------------
+            const Base::AABB3Float AABB = MeshPtr->GetAABB();
+
+            if (AABB.GetMin() == AABB.GetMax())
+            {
+                Caster.m_Min = glm::vec3(-FLT_MAX);
+                Caster.m_Max = glm::vec3( FLT_MAX);
+            }
+            else
+            {
+                const glm::mat4& rWorldMatrix = pEntity->GetTransformationFacet()->GetWorldMatrix();
+
+                Caster.m_Min = glm::vec3( FLT_MAX);
+                Caster.m_Max = glm::vec3(-FLT_MAX);
+
+                for (int IndexOfCorner = 0; IndexOfCorner < 8; ++IndexOfCorner)
+                {
+                    glm::vec3 Corner;
+
+                    Corner.x = (IndexOfCorner & 1) != 0 ? AABB.GetMax().x : AABB.GetMin().x;
+                    Corner.y = (IndexOfCorner & 2) != 0 ? AABB.GetMax().y : AABB.GetMin().y;
+                    Corner.z = (IndexOfCorner & 4) != 0 ? AABB.GetMax().z : AABB.GetMin().z;
+
+                    const glm::vec3 WSCorner = glm::vec3(rWorldMatrix * glm::vec4(Corner, 1.0f));
+
+                    Caster.m_Min = glm::min(Caster.m_Min, WSCorner);
+                    Caster.m_Max = glm::max(Caster.m_Max, WSCorner);
+                }
+            }
+
+            m_ShadowCasters         .push_back(Caster);
+            m_ShadowCasterComponents.push_back(pDtComponent);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CGfxSunManager::RenderShadows(CInternSunComponent* _pInternLight, unsigned int _DirtyFlags)
+    {
+        const CShadowCasterCache& rShadowCasterCache = _pInternLight->m_ShadowCasterCache;
+
+        CTargetSetPtr ShadowTargetSetPtr = _pInternLight->m_RenderContextPtr->GetTargetSet();
+
         Performance::BeginEvent("Sun Shadows");
 
+        if (rShadowCasterCache.HasDynamicCasters() == false)
+        {
+            // -----------------------------------------------------------------------------
+            // Only static casters are visible, so they go straight into the map
+            // -----------------------------------------------------------------------------
+            RenderShadowCasters(_pInternLight, ShadowTargetSetPtr, true, rShadowCasterCache.GetStaticCasters());
+
+            _pInternLight->m_IsStaticCacheValid = false;
+        }
+        else
+        {
+            // -----------------------------------------------------------------------------
+            // Static casters are kept in their own map and only rendered if they
+            // changed; the dynamic casters are drawn on top of a copy of it.
+            // -----------------------------------------------------------------------------
+            if (_pInternLight->m_StaticTargetSetPtr == nullptr) CreateStaticShadowCache(_pInternLight);
+
+            if ((_DirtyFlags & CShadowCasterCache::DirtyStatic) != 0 || _pInternLight->m_IsStaticCacheValid == false)
+            {
+                RenderShadowCasters(_pInternLight, _pInternLight->m_StaticTargetSetPtr, true, rShadowCasterCache.GetStaticCasters());
+
+                _pInternLight->m_IsStaticCacheValid = true;
+            }
+
+            TextureManager::CopyTexture(_pInternLight->m_StaticTexturePtr, _pInternLight->m_TextureSMPtr);
+
+            RenderShadowCasters(_pInternLight, ShadowTargetSetPtr, false, rShadowCasterCache.GetDynamicCasters());
+        }
+
+        Performance::EndEvent();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CGfxSunManager::RenderShadowCasters(CInternSunComponent* _pInternLight, CTargetSetPtr _TargetSetPtr, bool _ClearTargetSet, const CShadowCasterCache::CIndices& _rCasters)
+    {
         // -----------------------------------------------------------------------------
         // Prepare shadow
         // -----------------------------------------------------------------------------
-        TargetSetManager::ClearTargetSet(_pInternLight->m_RenderContextPtr->GetTargetSet());
+        if (_ClearTargetSet) TargetSetManager::ClearTargetSet(_TargetSetPtr);
             
         // -----------------------------------------------------------------------------
         // Set light as render target
         // -----------------------------------------------------------------------------
         ContextManager::SetRenderContext(_pInternLight->m_RenderContextPtr);
+
+        ContextManager::SetTargetSet(_TargetSetPtr);
             
         // -----------------------------------------------------------------------------
         // Set shader
@@ -434,29 +640,19 @@ namespace
         BufferManager::UploadBufferData(m_LightCameraVSBufferPtr->GetBuffer(0), &ViewBuffer);
             
         // -----------------------------------------------------------------------------
-        // Iterate throw every entity inside this map
+        // Iterate throw every visible caster
         // -----------------------------------------------------------------------------
-        auto DataMeshComponents = Dt::CComponentManager::GetInstance().GetComponents<Dt::CMeshComponent>();
-
-        for (auto Component : DataMeshComponents)
+        for (int IndexOfCaster : _rCasters)
         {
-            Dt::CMeshComponent* pDtComponent = static_cast<Dt::CMeshComponent*>(Component);
-
-            if (pDtComponent->IsActiveAndUsable() == false) continue;
-
-            CMesh* pGfxComponent = static_cast<CMesh*>(pDtComponent->GetFacet(Dt::CMeshComponent::Graphic));
+            Dt::CMeshComponent* pDtComponent = m_ShadowCasterComponents[IndexOfCaster];
 
-            CMeshPtr MeshPtr = pGfxComponent;
+            CMeshPtr MeshPtr = static_cast<CMesh*>(pDtComponent->GetFacet(Dt::CMeshComponent::Graphic));
 
             // -----------------------------------------------------------------------------
             // Render every surface of this entity
             // -----------------------------------------------------------------------------
-            if (MeshPtr == nullptr || MeshPtr->GetLOD(0) == nullptr) continue;
-
             CSurfacePtr SurfacePtr = MeshPtr->GetLOD(0)->GetSurface();
 
-            if (SurfacePtr == nullptr) continue;
-
             // -----------------------------------------------------------------------------
             // Upload model matrix to buffer
             // -----------------------------------------------------------------------------
@@ -503,8 +699,6 @@ namespace
         ContextManager::ResetShaderPS();
             
         ContextManager::ResetRenderContext();
-
-        Performance::EndEvent();
     }
 } // namespace
 
@@ -41,6 +41,7 @@ namespace
         CTargetSetPtr CreateEmptyTargetSet(int _Width, int _Height, int _Layers);
         
         void ClearTargetSet(CTargetSetPtr _TargetPtr, float _Depth);
+        void ClearTargetSet(CTargetSetPtr _TargetPtr, float _Depth, const Base::AABB2UInt& _rRect);
         void ClearTargetSet(CTargetSetPtr _TargetPtr, const glm::vec4& _rColor);
         void ClearTargetSet(CTargetSetPtr _TargetPtr, const glm::vec4& _rColor, float _Depth);
 
@@ -443,6 +444,41 @@ namespace
 
     // -----------------------------------------------------------------------------
 
+    void CGfxTargetSetManager::ClearTargetSet(CTargetSetPtr _TargetPtr, float _Depth, const Base::AABB2UInt& _rRect)
+    {
+        CNativeTargetSet& rNativeTargetSet = *static_cast<CNativeTargetSet*>(_TargetPtr.GetPtr());
+
+        GLint OldFBO;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &OldFBO);
+
+        GLint OldScissorBox[4];
+        glGetIntegerv(GL_SCISSOR_BOX, OldScissorBox);
+
+        GLboolean IsScissorEnabled = glIsEnabled(GL_SCISSOR_TEST);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, rNativeTargetSet.m_NativeTargetSet);
+
+        // -----------------------------------------------------------------------------
+        // Clears respect the scissor rectangle, so only the given part is touched
+        // -----------------------------------------------------------------------------
+        glm::uvec2 Offset = _rRect[0];
+        glm::uvec2 Size   = _rRect[1] - _rRect[0];
+
+        glEnable(GL_SCISSOR_TEST);
+
+        glScissor(Offset[0], Offset[1], Size[0], Size[1]);
+
+        glClearBufferfv(GL_DEPTH, 0, &_Depth);
+
+        glScissor(OldScissorBox[0], OldScissorBox[1], OldScissorBox[2], OldScissorBox[3]);
+
+        if (IsScissorEnabled == GL_FALSE) glDisable(GL_SCISSOR_TEST);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, OldFBO);
+    }
+
+    // -----------------------------------------------------------------------------
+
     void CGfxTargetSetManager::ClearTargetSet(CTargetSetPtr _TargetPtr, const glm::vec4& _rColor)
     {
         CNativeTargetSet& rNativeTargetSet = *static_cast<CNativeTargetSet*>(_TargetPtr.GetPtr());
@@ -892,6 +928,13 @@ namespace TargetSetManager
     {
         CGfxTargetSetManager::GetInstance().ClearTargetSet(_TargetPtr, _Depth);
     }
+
+    // -----------------------------------------------------------------------------
+
+    void ClearTargetSet(CTargetSetPtr _TargetPtr, float _Depth, const Base::AABB2UInt& _rRect)
+    {
+        CGfxTargetSetManager::GetInstance().ClearTargetSet(_TargetPtr, _Depth, _rRect);
+    }
     
     // -----------------------------------------------------------------------------
     
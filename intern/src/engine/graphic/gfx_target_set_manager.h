@@ -2,6 +2,8 @@
 
 #include "engine/engine_config.h"
 
+#include "base/base_aabb2.h"
+
 #include "engine/graphic/gfx_target_set.h"
 #include "engine/graphic/gfx_texture.h"
 
@@ -29,6 +31,7 @@ namespace TargetSetManager
     ENGINE_API void ClearTargetSet(CTargetSetPtr _TargetPtr, const glm::vec4& _rColor, float _Depth);
     ENGINE_API void ClearTargetSet(CTargetSetPtr _TargetPtr, const glm::vec4& _rColor);
     ENGINE_API void ClearTargetSet(CTargetSetPtr _TargetPtr, float _Depth);
+    ENGINE_API void ClearTargetSet(CTargetSetPtr _TargetPtr, float _Depth, const Base::AABB2UInt& _rRect);
     ENGINE_API void ClearTargetSet(CTargetSetPtr _TargetPtr);
 
     ENGINE_API void SetTargetSetLabel(CTargetSetPtr _TargetSetPtr, const char* _pLabel);
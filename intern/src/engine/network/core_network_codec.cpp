@@ -0,0 +1,391 @@
+#include "engine/engine_precompiled.h"
+
+#include "base/base_exception.h"
+
+#include "engine/network/core_network_codec.h"
+
+#include <zlib.h>
+
+#include <cstring>
+
+namespace
+{
+    // -----------------------------------------------------------------------------
+    // Tags in front of the encoded data
+    // -----------------------------------------------------------------------------
+    const char g_ZlibTag = 'Z';
+    const char g_LZTag   = 'L';
+
+    // -----------------------------------------------------------------------------
+    // LZ77 blocks in the layout of LZ4: a token with the number of literals
+    // and the length of the match, the literals, and a 16 bit offset. The
+    // last sequence only has literals.
+    // -----------------------------------------------------------------------------
+    const Base::Size g_LZHashBits         = 12;
+    const Base::Size g_LZMinMatch         = 4;
+    const Base::Size g_LZMaxOffset        = 65535;
+    const Base::Size g_LZLastLiterals     = 5;
+    const Base::Size g_LZMinInputForMatch = 12;
+
+    // -----------------------------------------------------------------------------
+
+    uint32_t ReadU32(const Base::U8* _pData)
+    {
+        uint32_t Value;
+
+        memcpy(&Value, _pData, sizeof(Value));
+
+        return Value;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    uint32_t GetLZHash(uint32_t _Sequence)
+    {
+        return (_Sequence * 2654435761u) >> (32 - g_LZHashBits);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Base::U8* WriteLZLength(Base::U8* _pOutput, Base::Size _Length)
+    {
+        for (; _Length >= 255; _Length -= 255) *_pOutput++ = 255;
+
+        *_pOutput++ = static_cast<Base::U8>(_Length);
+
+        return _pOutput;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Base::U8* WriteLZSequence(Base::U8* _pOutput, Base::U8* _pOutputEnd, const Base::U8* _pLiterals, Base::Size _NumberOfLiterals, Base::Size _Offset, Base::Size _MatchLength)
+    {
+        // -----------------------------------------------------------------------------
+        // Worst case of the token, both lengths, the literals and the offset
+        // -----------------------------------------------------------------------------
+        const Base::Size MaxNumberOfBytes = 1 + (_NumberOfLiterals / 255 + 1) + _NumberOfLiterals + 2 + (_MatchLength / 255 + 1);
+
+        if (static_cast<Base::Size>(_pOutputEnd - _pOutput) < MaxNumberOfBytes) return nullptr;
+
+        Base::U8* pToken = _pOutput++;
+
+        *pToken = static_cast<Base::U8>((_NumberOfLiterals < 15 ? _NumberOfLiterals : 15) << 4);
+
+        if (_NumberOfLiterals >= 15) _pOutput = WriteLZLength(_pOutput, _NumberOfLiterals - 15);
+
+        memcpy(_pOutput, _pLiterals, _NumberOfLiterals);
+
+        _pOutput += _NumberOfLiterals;
+
+        if (_MatchLength == 0) return _pOutput;
+
+        *_pOutput++ = static_cast<Base::U8>(_Offset & 0xFF);
+        *_pOutput++ = static_cast<Base::U8>(_Offset >> 8);
+
+        const Base::Size MatchCode = _MatchLength - g_LZMinMatch;
+
+        *pToken |= static_cast<Base::U8>(MatchCode < 15 ? MatchCode : 15);
+
+        if (MatchCode >= 15) _pOutput = WriteLZLength(_pOutput, MatchCode - 15);
+
+        return _pOutput;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Returns the number of written bytes or zero if the output is too small
+    // -----------------------------------------------------------------------------
+    Base::Size CompressLZ(const Base::U8* _pInput, Base::Size _NumberOfBytes, Base::U8* _pOutput, Base::Size _MaxNumberOfBytes, uint32_t* _pHashTable)
+    {
+        Base::U8* pOutput    = _pOutput;
+        Base::U8* pOutputEnd = _pOutput + _MaxNumberOfBytes;
+
+        Base::Size Position = 0;
+        Base::Size Anchor   = 0;
+
+        if (_NumberOfBytes >= g_LZMinInputForMatch)
+        {
+            memset(_pHashTable, 0, sizeof(uint32_t) << g_LZHashBits);
+
+            const Base::Size MatchLimit = _NumberOfBytes - g_LZMinInputForMatch;
+
+            while (Position < MatchLimit)
+            {
+                const uint32_t Sequence = ReadU32(_pInput + Position);
+                const uint32_t Hash     = GetLZHash(Sequence);
+
+                const Base::Size Reference = _pHashTable[Hash];
+
+                _pHashTable[Hash] = static_cast<uint32_t>(Position);
+
+                if (Reference >= Position || Position - Reference > g_LZMaxOffset || ReadU32(_pInput + Reference) != Sequence)
+                {
+                    // -----------------------------------------------------------------------------
+                    // Incompressible data is skipped faster the longer it gets
+                    // -----------------------------------------------------------------------------
+                    Position += 1 + ((Position - Anchor) >> 6);
+
+                    continue;
+                }
+
+                Base::Size MatchLength = g_LZMinMatch;
+
+                while (Position + MatchLength < _NumberOfBytes - g_LZLastLiterals && _pInput[Reference + MatchLength] == _pInput[Position + MatchLength])
+                {
+                    ++ MatchLength;
+                }
+
+                pOutput = WriteLZSequence(pOutput, pOutputEnd, _pInput + Anchor, Position - Anchor, Position - Reference, MatchLength);
+
+                if (pOutput == nullptr) return 0;
+
+                Position += MatchLength;
+                Anchor    = Position;
+            }
+        }
+
+        pOutput = WriteLZSequence(pOutput, pOutputEnd, _pInput + Anchor, _NumberOfBytes - Anchor, 0, 0);
+
+        return pOutput != nullptr ? static_cast<Base::Size>(pOutput - _pOutput) : 0;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool ReadLZLength(const Base::U8*& _rpInput, const Base::U8* _pInputEnd, Base::Size& _rLength)
+    {
+        Base::U8 Byte;
+
+        do
+        {
+            if (_rpInput == _pInputEnd) return false;
+
+            Byte = *_rpInput++;
+
+            _rLength += Byte;
+        }
+        while (Byte == 255);
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool DecompressLZ(const Base::U8* _pInput, Base::Size _NumberOfBytes, Base::U8* _pOutput, Base::Size _NumberOfOutputBytes)
+    {
+        const Base::U8* pInput    = _pInput;
+        const Base::U8* pInputEnd = _pInput + _NumberOfBytes;
+
+        Base::U8* pOutput    = _pOutput;
+        Base::U8* pOutputEnd = _pOutput + _NumberOfOutputBytes;
+
+        while (pInput < pInputEnd)
+        {
+            const Base::U8 Token = *pInput++;
+
+            Base::Size NumberOfLiterals = Token >> 4;
+
+            if (NumberOfLiterals == 15 && !ReadLZLength(pInput, pInputEnd, NumberOfLiterals)) return false;
+
+            if (NumberOfLiterals > static_cast<Base::Size>(pInputEnd - pInput) || NumberOfLiterals > static_cast<Base::Size>(pOutputEnd - pOutput)) return false;
+
+            memcpy(pOutput, pInput, NumberOfLiterals);
+
+            pInput  += NumberOfLiterals;
+            pOutput += NumberOfLiterals;
+
+            if (pInput == pInputEnd) break;
+
+            if (pInputEnd - pInput < 2) return false;
+
+            const Base::Size Offset = pInput[0] | (pInput[1] << 8);
+
+            pInput += 2;
+
+            if (Offset == 0 || Offset > static_cast<Base::Size>(pOutput - _pOutput)) return false;
+
+            Base::Size MatchLength = Token & 15;
+
+            if (MatchLength == 15 && !ReadLZLength(pInput, pInputEnd, MatchLength)) return false;
+
+            MatchLength += g_LZMinMatch;
+
+            if (MatchLength > static_cast<Base::Size>(pOutputEnd - pOutput)) return false;
+
+            // -----------------------------------------------------------------------------
+            // Matches may overlap their own output
+            // -----------------------------------------------------------------------------
+            const Base::U8* pMatch = pOutput - Offset;
+
+            if (Offset >= MatchLength)
+            {
+                memcpy(pOutput, pMatch, MatchLength);
+
+                pOutput += MatchLength;
+            }
+            else
+            {
+                for (Base::Size Index = 0; Index < MatchLength; ++ Index) *pOutput++ = *pMatch++;
+            }
+        }
+
+        return pOutput == pOutputEnd;
+    }
+} // namespace
+
+namespace Net
+{
+    CEncoder::CEncoder(int _ZlibLevel)
+        : m_pZlibStream(new z_stream())
+        , m_HashTable  (1 << g_LZHashBits)
+    {
+        // -----------------------------------------------------------------------------
+        // Raw deflate, the messages already carry their sizes
+        // -----------------------------------------------------------------------------
+        if (deflateInit2(m_pZlibStream.get(), _ZlibLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            BASE_THROWM("Failed to initialize the zlib encoder");
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CEncoder::~CEncoder()
+    {
+        deflateEnd(m_pZlibStream.get());
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CEncoder::Reset()
+    {
+        deflateReset(m_pZlibStream.get());
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CEncoder::Encode(SCodec::Enum _Codec, const char* _pData, Base::Size _NumberOfBytes, std::vector<char>& _rEncodedData)
+    {
+        if (_Codec == SCodec::LZ)
+        {
+            // -----------------------------------------------------------------------------
+            // Only kept if it is smaller than the data
+            // -----------------------------------------------------------------------------
+            _rEncodedData.resize(_NumberOfBytes);
+
+            _rEncodedData[0] = g_LZTag;
+
+            const Base::Size NumberOfEncodedBytes = CompressLZ(reinterpret_cast<const Base::U8*>(_pData), _NumberOfBytes, reinterpret_cast<Base::U8*>(_rEncodedData.data() + 1), _NumberOfBytes - 1, m_HashTable.data());
+
+            if (NumberOfEncodedBytes == 0) return false;
+
+            _rEncodedData.resize(1 + NumberOfEncodedBytes);
+
+            return true;
+        }
+
+        if (_Codec == SCodec::Zlib)
+        {
+            z_stream& rStream = *m_pZlibStream;
+
+            _rEncodedData.resize(1 + deflateBound(&rStream, static_cast<uLong>(_NumberOfBytes)) + 16);
+
+            _rEncodedData[0] = g_ZlibTag;
+
+            rStream.next_in  = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(_pData));
+            rStream.avail_in = static_cast<uInt>(_NumberOfBytes);
+
+            Base::Size NumberOfEncodedBytes = 1;
+
+            // -----------------------------------------------------------------------------
+            // A sync flush ends the message on a byte boundary, so the peer can
+            // decode it completely without ending the stream.
+            // -----------------------------------------------------------------------------
+            do
+            {
+                if (NumberOfEncodedBytes == _rEncodedData.size()) _rEncodedData.resize(_rEncodedData.size() * 2);
+
+                rStream.next_out  = reinterpret_cast<Bytef*>(_rEncodedData.data() + NumberOfEncodedBytes);
+                rStream.avail_out = static_cast<uInt>(_rEncodedData.size() - NumberOfEncodedBytes);
+
+                deflate(&rStream, Z_SYNC_FLUSH);
+
+                NumberOfEncodedBytes = _rEncodedData.size() - rStream.avail_out;
+            }
+            while (rStream.avail_out == 0);
+
+            _rEncodedData.resize(NumberOfEncodedBytes);
+
+            return true;
+        }
+
+        return false;
+    }
+} // namespace Net
+
+namespace Net
+{
+    CDecoder::CDecoder()
+        : m_pZlibStream(new z_stream())
+    {
+        if (inflateInit2(m_pZlibStream.get(), -MAX_WBITS) != Z_OK)
+        {
+            BASE_THROWM("Failed to initialize the zlib decoder");
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CDecoder::~CDecoder()
+    {
+        inflateEnd(m_pZlibStream.get());
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CDecoder::Reset()
+    {
+        inflateReset(m_pZlibStream.get());
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CDecoder::Decode(const char* _pData, Base::Size _NumberOfBytes, char* _pDecodedData, Base::Size _NumberOfDecodedBytes)
+    {
+        if (_NumberOfBytes == 0) return false;
+
+        if (_pData[0] == g_LZTag)
+        {
+            return DecompressLZ(reinterpret_cast<const Base::U8*>(_pData + 1), _NumberOfBytes - 1, reinterpret_cast<Base::U8*>(_pDecodedData), _NumberOfDecodedBytes);
+        }
+
+        if (_pData[0] != g_ZlibTag) return false;
+
+        z_stream& rStream = *m_pZlibStream;
+
+        rStream.next_in   = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(_pData + 1));
+        rStream.avail_in  = static_cast<uInt>(_NumberOfBytes - 1);
+        rStream.next_out  = reinterpret_cast<Bytef*>(_pDecodedData);
+        rStream.avail_out = static_cast<uInt>(_NumberOfDecodedBytes);
+
+        const int Result = inflate(&rStream, Z_SYNC_FLUSH);
+
+        if (Result != Z_OK && Result != Z_STREAM_END && Result != Z_BUF_ERROR) return false;
+
+        if (rStream.avail_out != 0) return false;
+
+        // -----------------------------------------------------------------------------
+        // The empty block of the sync flush may be left once the output is
+        // full; it must not produce any output.
+        // -----------------------------------------------------------------------------
+        if (rStream.avail_in > 0)
+        {
+            Bytef Overflow;
+
+            rStream.next_out  = &Overflow;
+            rStream.avail_out = 1;
+
+            if (inflate(&rStream, Z_SYNC_FLUSH) != Z_OK || rStream.avail_out == 0) return false;
+        }
+
+        return rStream.avail_in == 0;
+    }
+} // namespace Net
@@ -0,0 +1,81 @@
+
+#pragma once
+
+#include "base/base_typedef.h"
+#include "base/base_uncopyable.h"
+
+#include "engine/engine_config.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct z_stream_s;
+
+namespace Net
+{
+    struct SCodec
+    {
+        enum Enum
+        {
+            None,
+            Zlib,               //< One deflate stream over all messages of a connection
+            LZ,                 //< Fast LZ77 blocks, every message on its own
+            NumberOfCodecs,
+        };
+    };
+
+    // -----------------------------------------------------------------------------
+    // Compresses the payloads of one connection. The contexts are kept for
+    // the next messages, the zlib stream even shares its window with them,
+    // so the messages have to be decoded in the order they were encoded.
+    // The first byte of an encoded payload names its codec.
+    // -----------------------------------------------------------------------------
+    class ENGINE_API CEncoder : private Base::CUncopyable
+    {
+    public:
+
+        CEncoder(int _ZlibLevel);
+        ~CEncoder();
+
+    public:
+
+        void Reset();
+
+        // -----------------------------------------------------------------------------
+        // Returns false if the payload has to be sent as it is. The zlib stream
+        // never refuses, because the peer has to see every encoded byte.
+        // -----------------------------------------------------------------------------
+        bool Encode(SCodec::Enum _Codec, const char* _pData, Base::Size _NumberOfBytes, std::vector<char>& _rEncodedData);
+
+    private:
+
+        std::unique_ptr<z_stream_s> m_pZlibStream;
+        std::vector<uint32_t> m_HashTable;
+    };
+
+    // -----------------------------------------------------------------------------
+    // Counterpart of CEncoder
+    // -----------------------------------------------------------------------------
+    class ENGINE_API CDecoder : private Base::CUncopyable
+    {
+    public:
+
+        CDecoder();
+        ~CDecoder();
+
+    public:
+
+        void Reset();
+
+        // -----------------------------------------------------------------------------
+        // Returns false if the data is corrupt, its first byte names no codec
+        // or it does not decode to exactly the given number of bytes.
+        // -----------------------------------------------------------------------------
+        bool Decode(const char* _pData, Base::Size _NumberOfBytes, char* _pDecodedData, Base::Size _NumberOfDecodedBytes);
+
+    private:
+
+        std::unique_ptr<z_stream_s> m_pZlibStream;
+    };
+} // namespace Net
@@ -4,19 +4,25 @@
 
 #include "engine/engine_config.h"
 
+#include "engine/network/core_network_payload.h"
+
 #include <atomic>
 #include <functional>
 #include <vector>
 
 namespace Net
 {
+    // -----------------------------------------------------------------------------
+    // Messages are moved through the socket; the payload is shared instead of
+    // copied. Handlers only get a read-only view.
+    // -----------------------------------------------------------------------------
     struct CMessage
     {
         int m_Category;
         int m_MessageType;
         int m_CompressedSize;
         int m_DecompressedSize;
-        std::vector<char> m_Payload;
+        CPayload m_Payload;
 
 		CMessage()
 			: m_Category(0)
@@ -27,7 +33,43 @@ namespace Net
 		{
 
 		}
+
+        CMessage(CMessage&& _rOther) = default;
+        CMessage& operator = (CMessage&& _rOther) = default;
+
+        CMessage(const CMessage&) = delete;
+        CMessage& operator = (const CMessage&) = delete;
     };
 
     using SocketHandle = int;
+
+    // -----------------------------------------------------------------------------
+    // What a session of a multi-client server socket does with a new message
+    // once its queue is full. Stale frames of slow viewers are dropped or
+    // replaced by newer ones of the same category.
+    // -----------------------------------------------------------------------------
+    struct SQueuePolicy
+    {
+        enum Enum
+        {
+            Refuse,             //< The new message is refused
+            DropOldest,         //< The oldest queued message is dropped
+            Coalesce,           //< The oldest queued message of the same category is dropped, without one the new message is refused
+        };
+    };
+
+    // -----------------------------------------------------------------------------
+    // How the main thread keeps up with the received messages of a socket.
+    // The durations are the time spent in the handlers.
+    // -----------------------------------------------------------------------------
+    struct SReceiveStatistics
+    {
+        Base::Size m_NumberOfQueuedMessages;        //< Waiting for the next update
+        Base::Size m_PeakNumberOfQueuedMessages;
+        Base::Size m_NumberOfHandledMessages;       //< In the last update
+        Base::Size m_NumberOfDeferredUpdates;       //< Updates that left messages for the next frame
+        Base::Size m_NumberOfStalls;                //< Times the queue was full and reading was paused
+        double     m_HandlerDurationInMs;           //< In the last update
+        double     m_MaxHandlerDurationInMs;
+    };
 } // namespace Net
\ No newline at end of file
@@ -11,19 +11,26 @@ namespace Net
 {
     void CNetworkManager::OnStart()
     {
-        m_IsRunning = true;
-        m_WorkerThread = std::thread(std::bind(&CNetworkManager::Run, this));
+        if (!m_WorkerThreads.empty()) return;
+
+        const int NumberOfThreads = std::max(Core::CProgramParameters::GetInstance().Get("network:io_threads", 1), 1);
+
+        m_pWork.reset(new asio::io_service::work(*m_pIOService));
+
+        for (int IndexOfThread = 0; IndexOfThread < NumberOfThreads; ++ IndexOfThread)
+        {
+            m_WorkerThreads.emplace_back(std::bind(&CNetworkManager::Run, this));
+        }
     }
 
     // -----------------------------------------------------------------------------
 
     void CNetworkManager::Run()
     {
-        while (m_IsRunning)
-        {
-            m_IOService.run();
-            m_IOService.reset();
-        }
+        // -----------------------------------------------------------------------------
+        // Blocks in the IO service until it is stopped
+        // -----------------------------------------------------------------------------
+        m_pIOService->run();
     }
 
     // -----------------------------------------------------------------------------
@@ -34,67 +41,95 @@ namespace Net
         {
             Iterator->second->Update();
         }
+
+        for (auto Iterator = m_Servers.begin(); Iterator != m_Servers.end(); ++ Iterator)
+        {
+            Iterator->second->Update();
+        }
     }
 
     // -----------------------------------------------------------------------------
 
     void CNetworkManager::OnExit()
     {
-        m_IsRunning = false;
-        m_IOService.stop();
-        m_WorkerThread.join();
+        m_pWork.reset();
+
+        m_pIOService->stop();
+
+        for (std::thread& rThread : m_WorkerThreads)
+        {
+            rThread.join();
+        }
+
+        m_WorkerThreads.clear();
 
         m_Sockets.clear();
+        m_Servers.clear();
+
+        // -----------------------------------------------------------------------------
+        // Handlers of the closed sockets may still be queued. They are destroyed
+        // without being called together with the IO service, so the manager
+        // can be started again.
+        // -----------------------------------------------------------------------------
+        m_pIOService.reset(new asio::io_service());
     }
 
     // -----------------------------------------------------------------------------
 
     bool CNetworkManager::IsConnected(SocketHandle _SocketHandle) const
     {
-        if (m_Sockets.count(_SocketHandle) != 0)
+        const CSocket* pSocket = FindSocket(_SocketHandle);
+
+        if (pSocket != nullptr)
         {
-            if (m_Sockets.at(_SocketHandle)->IsOpen())
-            {
-                return true;
-            }
+            return pSocket->IsOpen();
         }
 
-        return false;
+        const CServerSocket* pServer = FindServer(_SocketHandle);
+
+        return pServer != nullptr && pServer->HasSessions();
     }
 
     // -----------------------------------------------------------------------------
 
     int CNetworkManager::GetPort(SocketHandle _SocketHandle) const
     {
-        try
+        const CSocket* pSocket = FindSocket(_SocketHandle);
+
+        if (pSocket != nullptr)
         {
-            return m_Sockets.at(_SocketHandle)->GetPort();
+            return pSocket->GetPort();
         }
-        catch (...)
+
+        const CServerSocket* pServer = FindServer(_SocketHandle);
+
+        if (pServer != nullptr)
         {
-            throw Base::CException(__FILE__, __LINE__, "No socket was found for the given handle");
+            return pServer->GetPort();
         }
+
+        throw Base::CException(__FILE__, __LINE__, "No socket was found for the given handle");
     }
     
     // -----------------------------------------------------------------------------
     
     const std::string& CNetworkManager::GetIP(SocketHandle _SocketHandle) const
     {
-        try
-        {
-            return m_Sockets.at(_SocketHandle)->GetIP();
-        }
-        catch (...)
+        const CSocket* pSocket = FindSocket(_SocketHandle);
+
+        if (pSocket == nullptr)
         {
             throw Base::CException(__FILE__, __LINE__, "No socket was found for the given handle");
         }
+
+        return pSocket->GetIP();
     }
 
     // -----------------------------------------------------------------------------
 
     SocketHandle CNetworkManager::CreateServerSocket(int _Port)
     {
-        if (m_Sockets.count(_Port) == 0)
+        if (!IsPortInUse(_Port))
         {
             m_Sockets[_Port].reset(new CSocket(_Port));
         }
@@ -106,7 +141,7 @@ namespace Net
 
     SocketHandle CNetworkManager::CreateClientSocket(const std::string& _IP, int _Port)
     {
-        if (m_Sockets.count(_Port) == 0)
+        if (!IsPortInUse(_Port))
         {
             m_Sockets[_Port].reset(new CSocket(_IP, _Port));
         }
@@ -116,38 +151,227 @@ namespace Net
 
     // -----------------------------------------------------------------------------
 
+    SocketHandle CNetworkManager::CreateMultiClientServerSocket(int _Port)
+    {
+        if (!IsPortInUse(_Port))
+        {
+            m_Servers[_Port].reset(new CServerSocket(_Port));
+        }
+
+        return _Port;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    std::vector<SocketHandle> CNetworkManager::GetSessions(SocketHandle _ServerHandle) const
+    {
+        const CServerSocket* pServer = FindServer(_ServerHandle);
+
+        if (pServer == nullptr)
+        {
+            throw Base::CException(__FILE__, __LINE__, "No multi-client server socket was found for the given handle");
+        }
+
+        return pServer->GetSessionHandles();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Base::Size CNetworkManager::Broadcast(SocketHandle _ServerHandle, const CMessage& _rMessage)
+    {
+        CServerSocket* pServer = FindServer(_ServerHandle);
+
+        if (pServer == nullptr)
+        {
+            throw Base::CException(__FILE__, __LINE__, "Failed to broadcast message. No appropriate server socket found.");
+        }
+
+        return pServer->Broadcast(_rMessage);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CNetworkManager::SetSessionQueueLimit(SocketHandle _ServerHandle, Base::Size _MaxNumberOfMessages, SQueuePolicy::Enum _Policy)
+    {
+        CServerSocket* pServer = FindServer(_ServerHandle);
+
+        if (pServer == nullptr)
+        {
+            throw Base::CException(__FILE__, __LINE__, "Failed to set queue limit. No appropriate server socket found.");
+        }
+
+        pServer->SetQueueLimit(_MaxNumberOfMessages, _Policy);
+    }
+
+    // -----------------------------------------------------------------------------
+
     CNetworkManager::CMessageDelegate::HandleType CNetworkManager::RegisterMessageHandler(SocketHandle _SocketHandle, CMessageDelegate::FunctionType _Function)
     {
-        if (m_Sockets.count(_SocketHandle) == 0)
+        CServerSocket* pServer = FindServer(_SocketHandle);
+
+        if (pServer != nullptr)
+        {
+            return pServer->RegisterMessageHandler(_Function);
+        }
+
+        CSocket* pSocket = FindSocket(_SocketHandle);
+
+        if (pSocket == nullptr)
         {
             throw Base::CException(__FILE__, __LINE__, "Failed to register message handler. No appropriate socket found.");
         }
 
-        return m_Sockets[_SocketHandle]->RegisterMessageHandler(_Function);
+        return pSocket->RegisterMessageHandler(_Function);
     }
     
     // -----------------------------------------------------------------------------
 
-    bool CNetworkManager::SendMessage(SocketHandle _SocketHandle, const CMessage& _rMessage)
+    bool CNetworkManager::SendMessage(SocketHandle _SocketHandle, CMessage&& _rMessage)
     {
-        if (m_Sockets.count(_SocketHandle) == 0)
+        CSocket* pSocket = FindSocket(_SocketHandle);
+
+        if (pSocket == nullptr)
         {
-            throw Base::CException(__FILE__, __LINE__, "Failed to register message handler. No appropriate socket found.");
+            throw Base::CException(__FILE__, __LINE__, "Failed to send message. No appropriate socket found.");
         }
 
-        return m_Sockets[_SocketHandle]->SendMessage(_rMessage);
+        return pSocket->SendMessage(std::move(_rMessage));
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CNetworkManager::SetSendWatermarks(SocketHandle _SocketHandle, Base::Size _HighWatermark, Base::Size _LowWatermark)
+    {
+        CSocket* pSocket = FindSocket(_SocketHandle);
+
+        if (pSocket == nullptr)
+        {
+            throw Base::CException(__FILE__, __LINE__, "Failed to set send watermarks. No appropriate socket found.");
+        }
+
+        pSocket->SetSendWatermarks(_HighWatermark, _LowWatermark);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CNetworkManager::SetCodec(SocketHandle _SocketHandle, int _Category, SCodec::Enum _Codec)
+    {
+        CServerSocket* pServer = FindServer(_SocketHandle);
+
+        if (pServer != nullptr)
+        {
+            pServer->SetCodec(_Category, _Codec);
+
+            return;
+        }
+
+        CSocket* pSocket = FindSocket(_SocketHandle);
+
+        if (pSocket == nullptr)
+        {
+            throw Base::CException(__FILE__, __LINE__, "Failed to set codec. No appropriate socket found.");
+        }
+
+        pSocket->SetCodec(_Category, _Codec);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Base::Size CNetworkManager::GetNumberOfPendingBytes(SocketHandle _SocketHandle) const
+    {
+        const CSocket* pSocket = FindSocket(_SocketHandle);
+
+        if (pSocket == nullptr)
+        {
+            throw Base::CException(__FILE__, __LINE__, "No socket was found for the given handle");
+        }
+
+        return pSocket->GetNumberOfPendingBytes();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Base::Size CNetworkManager::GetNumberOfDroppedMessages(SocketHandle _SocketHandle) const
+    {
+        const CSocket* pSocket = FindSocket(_SocketHandle);
+
+        if (pSocket == nullptr)
+        {
+            throw Base::CException(__FILE__, __LINE__, "No socket was found for the given handle");
+        }
+
+        return pSocket->GetNumberOfDroppedMessages();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    SReceiveStatistics CNetworkManager::GetReceiveStatistics(SocketHandle _SocketHandle) const
+    {
+        const CSocket* pSocket = FindSocket(_SocketHandle);
+
+        if (pSocket == nullptr)
+        {
+            throw Base::CException(__FILE__, __LINE__, "No socket was found for the given handle");
+        }
+
+        return pSocket->GetReceiveStatistics();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CSocket* CNetworkManager::FindSocket(SocketHandle _SocketHandle) const
+    {
+        auto Iterator = m_Sockets.find(_SocketHandle);
+
+        if (Iterator != m_Sockets.end())
+        {
+            return Iterator->second.get();
+        }
+
+        // -----------------------------------------------------------------------------
+        // Sessions of the multi-client servers
+        // -----------------------------------------------------------------------------
+        for (auto& rServer : m_Servers)
+        {
+            CSocket* pSession = rServer.second->GetSession(_SocketHandle);
+
+            if (pSession != nullptr) return pSession;
+        }
+
+        return nullptr;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CServerSocket* CNetworkManager::FindServer(SocketHandle _SocketHandle) const
+    {
+        auto Iterator = m_Servers.find(_SocketHandle);
+
+        return Iterator != m_Servers.end() ? Iterator->second.get() : nullptr;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CNetworkManager::IsPortInUse(int _Port) const
+    {
+        return m_Sockets.count(_Port) != 0 || m_Servers.count(_Port) != 0;
     }
 
     // -----------------------------------------------------------------------------
 
     asio::io_service& CNetworkManager::GetIOService()
     {
-        return m_IOService;
+        return *m_pIOService;
     }
 
     // -----------------------------------------------------------------------------
 
     CNetworkManager::CNetworkManager()
+        : m_Sockets      ()
+        , m_Servers      ()
+        , m_WorkerThreads()
+        , m_pIOService   (new asio::io_service())
+        , m_pWork        ()
     {
 
     }
@@ -6,7 +6,9 @@
 #include "base/base_uncopyable.h"
 #include "base/base_singleton.h"
 
+#include "engine/network/core_network_codec.h"
 #include "engine/network/core_network_common.h"
+#include "engine/network/core_network_server_socket.h"
 #include "engine/network/core_network_socket.h"
 
 #include <atomic>
@@ -29,6 +31,12 @@ namespace Net
 
     public:
 
+        // -----------------------------------------------------------------------------
+        // The IO threads sleep until an operation completes. The number of
+        // threads is read from "network:io_threads"; the handlers of one
+        // socket never run concurrently. Starting a running manager again
+        // does nothing, so independent users can share it.
+        // -----------------------------------------------------------------------------
         void OnStart();
         void Update();
         void OnExit();
@@ -41,13 +49,66 @@ namespace Net
         SocketHandle CreateServerSocket(int _Port);
         SocketHandle CreateClientSocket(const std::string& _IP, int _Port);
 
+        // -----------------------------------------------------------------------------
+        // Keeps accepting viewers on the port. The server handle is the port,
+        // every connection gets its own session handle that can be used like
+        // the handle of a socket. Handlers are registered on the server.
+        // -----------------------------------------------------------------------------
+        SocketHandle CreateMultiClientServerSocket(int _Port);
+
+        std::vector<SocketHandle> GetSessions(SocketHandle _ServerHandle) const;
+
+        // -----------------------------------------------------------------------------
+        // Sends the message to all sessions of the server and returns how many
+        // took it. The payload is shared, not copied.
+        // -----------------------------------------------------------------------------
+        Base::Size Broadcast(SocketHandle _ServerHandle, const CMessage& _rMessage);
+
+        // -----------------------------------------------------------------------------
+        // Limits the queue of every session, so slow viewers lose stale frames
+        // instead of piling them up.
+        // -----------------------------------------------------------------------------
+        void SetSessionQueueLimit(SocketHandle _ServerHandle, Base::Size _MaxNumberOfMessages, SQueuePolicy::Enum _Policy);
+
         CMessageDelegate::HandleType RegisterMessageHandler(SocketHandle _SocketHandle, CMessageDelegate::FunctionType _Function);
-        bool SendMessage(SocketHandle _SocketHandle, const CMessage& _rMessage);
+
+        // -----------------------------------------------------------------------------
+        // Messages are moved into the queue and sent by the IO thread. A socket
+        // that is not open or whose queue is above the send watermarks refuses
+        // messages.
+        // -----------------------------------------------------------------------------
+        bool SendMessage(SocketHandle _SocketHandle, CMessage&& _rMessage);
+
+        void SetSendWatermarks(SocketHandle _SocketHandle, Base::Size _HighWatermark, Base::Size _LowWatermark);
+
+        // -----------------------------------------------------------------------------
+        // Selects the codec for the payloads of a category (LZ by default).
+        // Compression is only used with "network:compression:enabled" set on both
+        // sides; payloads below "network:compression:min_bytes" are never
+        // compressed. Set on a server it applies to all of its sessions.
+        // -----------------------------------------------------------------------------
+        void SetCodec(SocketHandle _SocketHandle, int _Category, SCodec::Enum _Codec);
+
+        Base::Size GetNumberOfPendingBytes(SocketHandle _SocketHandle) const;
+        Base::Size GetNumberOfDroppedMessages(SocketHandle _SocketHandle) const;
+
+        // -----------------------------------------------------------------------------
+        // Handlers of a socket get "network:receive:budget_ms" per update (zero
+        // for no limit); messages beyond it are handled in the next frame. The
+        // receive queue holds "network:receive:queue_size" messages.
+        // -----------------------------------------------------------------------------
+        SReceiveStatistics GetReceiveStatistics(SocketHandle _SocketHandle) const;
         
     private:
 
         void Run();
 
+        CSocket* FindSocket(SocketHandle _SocketHandle) const;
+        CServerSocket* FindServer(SocketHandle _SocketHandle) const;
+
+        bool IsPortInUse(int _Port) const;
+
+        friend class CServerSocket;
         friend class CSocket;
         
         asio::io_service& GetIOService();
@@ -67,12 +128,20 @@ namespace Net
             }
         };
         
+        struct ServerDeleter
+        {
+            void operator()(CServerSocket* _pServer)
+            {
+                delete _pServer;
+            }
+        };
+        
         std::map<SocketHandle, std::unique_ptr<CSocket, SocketDeleter>> m_Sockets;
+        std::map<SocketHandle, std::unique_ptr<CServerSocket, ServerDeleter>> m_Servers;
         
-        std::thread m_WorkerThread;
-
-        std::atomic_bool m_IsRunning;
+        std::vector<std::thread> m_WorkerThreads;
 
-        asio::io_service m_IOService;
+        std::unique_ptr<asio::io_service> m_pIOService;
+        std::unique_ptr<asio::io_service::work> m_pWork;        //< Keeps the IO threads waiting while no operation is pending
     };
 } // namespace Net
\ No newline at end of file
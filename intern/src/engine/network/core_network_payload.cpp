@@ -0,0 +1,112 @@
+#include "engine/engine_precompiled.h"
+
+#include "engine/network/core_network_payload.h"
+
+namespace Net
+{
+    CPayloadPool::CPayloadPool(Base::Size _MaxNumberOfBuffers)
+        : m_Mutex             ()
+        , m_FreeBuffers       ()
+        , m_MaxNumberOfBuffers(_MaxNumberOfBuffers)
+    {
+        m_FreeBuffers.reserve(_MaxNumberOfBuffers);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CPayloadPool::~CPayloadPool()
+    {
+        for (std::vector<char>* pBuffer : m_FreeBuffers)
+        {
+            delete pBuffer;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CPayloadPool::CBufferPtr CPayloadPool::Allocate(Base::Size _NumberOfBytes)
+    {
+        std::vector<char>* pBuffer = nullptr;
+
+        // -----------------------------------------------------------------------------
+        // Prefer the smallest free buffer that is large enough, otherwise the
+        // largest one is grown.
+        // -----------------------------------------------------------------------------
+        m_Mutex.lock();
+
+        if (!m_FreeBuffers.empty())
+        {
+            auto BestIterator = m_FreeBuffers.begin();
+
+            for (auto Iterator = m_FreeBuffers.begin(); Iterator != m_FreeBuffers.end(); ++ Iterator)
+            {
+                const Base::Size Capacity     = (*Iterator)->capacity();
+                const Base::Size BestCapacity = (*BestIterator)->capacity();
+
+                const bool IsLargeEnough     = Capacity >= _NumberOfBytes;
+                const bool IsBestLargeEnough = BestCapacity >= _NumberOfBytes;
+
+                if ((IsLargeEnough && (!IsBestLargeEnough || Capacity < BestCapacity)) || (!IsLargeEnough && !IsBestLargeEnough && Capacity > BestCapacity))
+                {
+                    BestIterator = Iterator;
+                }
+            }
+
+            pBuffer = *BestIterator;
+
+            m_FreeBuffers.erase(BestIterator);
+        }
+
+        m_Mutex.unlock();
+
+        if (pBuffer == nullptr)
+        {
+            pBuffer = new std::vector<char>();
+        }
+
+        pBuffer->resize(_NumberOfBytes);
+
+        std::weak_ptr<CPayloadPool> PoolPtr = shared_from_this();
+
+        return CBufferPtr(pBuffer, [PoolPtr](std::vector<char>* _pBuffer)
+        {
+            std::shared_ptr<CPayloadPool> LockedPoolPtr = PoolPtr.lock();
+
+            if (LockedPoolPtr != nullptr)
+            {
+                LockedPoolPtr->Release(_pBuffer);
+            }
+            else
+            {
+                delete _pBuffer;
+            }
+        });
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Base::Size CPayloadPool::GetNumberOfFreeBuffers() const
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+
+        return m_FreeBuffers.size();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CPayloadPool::Release(std::vector<char>* _pBuffer)
+    {
+        m_Mutex.lock();
+
+        if (m_FreeBuffers.size() < m_MaxNumberOfBuffers)
+        {
+            m_FreeBuffers.push_back(_pBuffer);
+
+            _pBuffer = nullptr;
+        }
+
+        m_Mutex.unlock();
+
+        delete _pBuffer;
+    }
+} // namespace Net
@@ -0,0 +1,212 @@
+
+#pragma once
+
+#include "base/base_serialize_std_vector.h"
+#include "base/base_typedef.h"
+#include "base/base_uncopyable.h"
+
+#include "engine/engine_config.h"
+
+#include <assert.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Net
+{
+    // -----------------------------------------------------------------------------
+    // Read-only view on a reference counted byte buffer. Copies and slices
+    // share the buffer, so a payload is never copied on its way through the
+    // socket. The bytes have to be written before they become a payload.
+    // -----------------------------------------------------------------------------
+    class CPayload
+    {
+    public:
+
+        using CBufferPtr = std::shared_ptr<const std::vector<char>>;
+
+    public:
+
+        inline CPayload();
+        inline CPayload(std::vector<char>&& _rBytes);
+        inline CPayload(CBufferPtr _BufferPtr);
+        inline CPayload(CBufferPtr _BufferPtr, Base::Size _Offset, Base::Size _NumberOfBytes);
+
+    public:
+
+        inline const char* GetData() const;
+        inline Base::Size GetNumberOfBytes() const;
+
+        inline bool IsEmpty() const;
+
+        inline const char& operator [] (Base::Size _Index) const;
+
+        inline CPayload GetSlice(Base::Size _Offset, Base::Size _NumberOfBytes) const;
+
+    private:
+
+        CBufferPtr m_BufferPtr;
+        Base::Size m_Offset;
+        Base::Size m_NumberOfBytes;
+    };
+} // namespace Net
+
+namespace Net
+{
+    // -----------------------------------------------------------------------------
+    // Keeps the buffers of released payloads for the next messages. Buffers
+    // go back to the pool once the last payload referencing them is gone,
+    // which may be on any thread; they are freed if the pool is gone. The
+    // pool has to be owned by a shared_ptr.
+    // -----------------------------------------------------------------------------
+    class ENGINE_API CPayloadPool : public std::enable_shared_from_this<CPayloadPool>, private Base::CUncopyable
+    {
+    public:
+
+        using CBufferPtr = std::shared_ptr<std::vector<char>>;
+
+    public:
+
+        CPayloadPool(Base::Size _MaxNumberOfBuffers);
+        ~CPayloadPool();
+
+    public:
+
+        // -----------------------------------------------------------------------------
+        // Returns a buffer with the requested size and undefined content
+        // -----------------------------------------------------------------------------
+        CBufferPtr Allocate(Base::Size _NumberOfBytes);
+
+        Base::Size GetNumberOfFreeBuffers() const;
+
+    private:
+
+        mutable std::mutex              m_Mutex;
+        std::vector<std::vector<char>*> m_FreeBuffers;
+        Base::Size                      m_MaxNumberOfBuffers;
+
+    private:
+
+        void Release(std::vector<char>* _pBuffer);
+    };
+} // namespace Net
+
+namespace SER
+{
+    // -----------------------------------------------------------------------------
+    // Same layout as a std::vector<char>, so recordings stay compatible
+    // -----------------------------------------------------------------------------
+    template<class TArchive>
+    inline void Write(TArchive& _rArchive, const Net::CPayload& _rPayload);
+
+    template<class TArchive>
+    inline void Read(TArchive& _rArchive, Net::CPayload& _rPayload);
+} // namespace SER
+
+namespace Net
+{
+    inline CPayload::CPayload()
+        : m_BufferPtr    ()
+        , m_Offset       (0)
+        , m_NumberOfBytes(0)
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline CPayload::CPayload(std::vector<char>&& _rBytes)
+        : m_BufferPtr    (std::make_shared<const std::vector<char>>(std::move(_rBytes)))
+        , m_Offset       (0)
+        , m_NumberOfBytes(m_BufferPtr->size())
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline CPayload::CPayload(CBufferPtr _BufferPtr)
+        : m_BufferPtr    (std::move(_BufferPtr))
+        , m_Offset       (0)
+        , m_NumberOfBytes(m_BufferPtr != nullptr ? m_BufferPtr->size() : 0)
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline CPayload::CPayload(CBufferPtr _BufferPtr, Base::Size _Offset, Base::Size _NumberOfBytes)
+        : m_BufferPtr    (std::move(_BufferPtr))
+        , m_Offset       (_Offset)
+        , m_NumberOfBytes(_NumberOfBytes)
+    {
+        assert(m_BufferPtr != nullptr || _NumberOfBytes == 0);
+        assert(m_BufferPtr == nullptr || _Offset + _NumberOfBytes <= m_BufferPtr->size());
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline const char* CPayload::GetData() const
+    {
+        return m_BufferPtr != nullptr ? m_BufferPtr->data() + m_Offset : nullptr;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline Base::Size CPayload::GetNumberOfBytes() const
+    {
+        return m_NumberOfBytes;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline bool CPayload::IsEmpty() const
+    {
+        return m_NumberOfBytes == 0;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline const char& CPayload::operator [] (Base::Size _Index) const
+    {
+        assert(_Index < m_NumberOfBytes);
+
+        return (*m_BufferPtr)[m_Offset + _Index];
+    }
+
+    // -----------------------------------------------------------------------------
+
+    inline CPayload CPayload::GetSlice(Base::Size _Offset, Base::Size _NumberOfBytes) const
+    {
+        assert(_Offset + _NumberOfBytes <= m_NumberOfBytes);
+
+        return CPayload(m_BufferPtr, m_Offset + _Offset, _NumberOfBytes);
+    }
+} // namespace Net
+
+namespace SER
+{
+    template<class TArchive>
+    inline void Write(TArchive& _rArchive, const Net::CPayload& _rPayload)
+    {
+        unsigned int NumberOfElements = static_cast<unsigned int>(_rPayload.GetNumberOfBytes());
+
+        _rArchive.template BeginCollection<char>(NumberOfElements);
+
+        if (NumberOfElements > 0)
+        {
+            _rArchive.WriteCollection(_rPayload.GetData(), NumberOfElements);
+        }
+
+        _rArchive.template EndCollection<char>();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    template<class TArchive>
+    inline void Read(TArchive& _rArchive, Net::CPayload& _rPayload)
+    {
+        std::vector<char> Bytes;
+
+        SER::Read(_rArchive, Bytes);
+
+        _rPayload = Net::CPayload(std::move(Bytes));
+    }
+} // namespace SER
@@ -0,0 +1,274 @@
+#include "engine/engine_precompiled.h"
+
+#include "base/base_exception.h"
+
+#include "engine/core/core_console.h"
+
+#include "engine/network/core_network_manager.h"
+#include "engine/network/core_network_server_socket.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+    // -----------------------------------------------------------------------------
+    // Sessions get handles above the port range, so they never collide with
+    // the handles of other sockets.
+    // -----------------------------------------------------------------------------
+    Net::SocketHandle g_NextSessionHandle = 1 << 16;
+} // namespace
+
+namespace Net
+{
+    CServerSocket::CServerSocket(int _Port)
+        : m_Port                     (_Port)
+        , m_Strand                   (CNetworkManager::GetInstance().GetIOService())
+        , m_pAcceptor                ()
+        , m_pPendingSocket           ()
+        , m_Mutex                    ()
+        , m_AcceptedSockets          ()
+        , m_Sessions                 ()
+        , m_ClosedSessions           ()
+        , m_MessageDelegate          ()
+        , m_MaxNumberOfQueuedMessages(0)
+        , m_QueuePolicy              (SQueuePolicy::Refuse)
+        , m_Codecs                   ()
+    {
+        try
+        {
+            asio::ip::tcp::endpoint Endpoint(asio::ip::tcp::v4(), static_cast<unsigned short>(m_Port));
+
+            m_pAcceptor = std::make_unique<asio::ip::tcp::acceptor>(CNetworkManager::GetInstance().GetIOService(), Endpoint);
+        }
+        catch (const std::exception& e)
+        {
+            throw Base::CException(__FILE__, __LINE__, e.what());
+        }
+
+        Accept();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CServerSocket::~CServerSocket()
+    {
+        m_pAcceptor->close();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CServerSocket::Update()
+    {
+        // -----------------------------------------------------------------------------
+        // Accepted connections become sessions on the main thread, so the
+        // sessions are never touched by the IO threads.
+        // -----------------------------------------------------------------------------
+        m_Mutex.lock();
+
+        std::vector<std::unique_ptr<asio::ip::tcp::socket>> AcceptedSockets = std::move(m_AcceptedSockets);
+
+        m_AcceptedSockets.clear();
+
+        m_Mutex.unlock();
+
+        for (std::unique_ptr<asio::ip::tcp::socket>& rpSocket : AcceptedSockets)
+        {
+            const SocketHandle SessionHandle = g_NextSessionHandle ++;
+
+            SSession Session = { std::unique_ptr<CSocket, void(*)(CSocket*)>(new CSocket(m_Port, SessionHandle, std::move(rpSocket)), &CServerSocket::DeleteSocket), nullptr };
+
+            Session.m_pSocket->SetQueueLimit(m_MaxNumberOfQueuedMessages, m_QueuePolicy);
+
+            for (const auto& rCodec : m_Codecs)
+            {
+                Session.m_pSocket->SetCodec(rCodec.first, rCodec.second);
+            }
+
+            Session.m_HandlerPtr = Session.m_pSocket->RegisterMessageHandler([this](const CMessage& _rMessage, SocketHandle _SessionHandle)
+            {
+                m_MessageDelegate.Notify(_rMessage, _SessionHandle);
+            });
+
+            ENGINE_CONSOLE_INFOV("Session %i connected on port %i", SessionHandle, m_Port);
+
+            m_Sessions.emplace(SessionHandle, std::move(Session));
+
+            CMessage Message;
+
+            Message.m_MessageType = 3;
+
+            m_MessageDelegate.Notify(Message, SessionHandle);
+        }
+
+        // -----------------------------------------------------------------------------
+        // A session that was closed before its update delivers all of its last
+        // messages, regardless of the budget, and is removed.
+        // -----------------------------------------------------------------------------
+        for (auto Iterator = m_Sessions.begin(); Iterator != m_Sessions.end(); )
+        {
+            CSocket& rSocket = *Iterator->second.m_pSocket;
+
+            const bool IsClosed = !rSocket.IsOpen();
+
+            rSocket.Update(IsClosed);
+
+            if (IsClosed)
+            {
+                m_ClosedSessions.emplace_back(std::move(Iterator->second));
+
+                Iterator = m_Sessions.erase(Iterator);
+            }
+            else
+            {
+                ++ Iterator;
+            }
+        }
+
+        m_ClosedSessions.erase(std::remove_if(m_ClosedSessions.begin(), m_ClosedSessions.end(), [](const SSession& _rSession)
+        {
+            return !_rSession.m_pSocket->HasPendingOperations();
+        }), m_ClosedSessions.end());
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CServerSocket::GetPort() const
+    {
+        return m_Port;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CServerSocket::HasSessions() const
+    {
+        return !m_Sessions.empty();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CSocket* CServerSocket::GetSession(SocketHandle _SessionHandle)
+    {
+        auto Iterator = m_Sessions.find(_SessionHandle);
+
+        return Iterator != m_Sessions.end() ? Iterator->second.m_pSocket.get() : nullptr;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    const CSocket* CServerSocket::GetSession(SocketHandle _SessionHandle) const
+    {
+        auto Iterator = m_Sessions.find(_SessionHandle);
+
+        return Iterator != m_Sessions.end() ? Iterator->second.m_pSocket.get() : nullptr;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    std::vector<SocketHandle> CServerSocket::GetSessionHandles() const
+    {
+        std::vector<SocketHandle> SessionHandles;
+
+        SessionHandles.reserve(m_Sessions.size());
+
+        for (const auto& rSession : m_Sessions)
+        {
+            SessionHandles.push_back(rSession.first);
+        }
+
+        return SessionHandles;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CServerSocket::CMessageDelegate::HandleType CServerSocket::RegisterMessageHandler(CMessageDelegate::FunctionType _Function)
+    {
+        return m_MessageDelegate.Register(_Function);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Base::Size CServerSocket::Broadcast(const CMessage& _rMessage)
+    {
+        Base::Size NumberOfSessions = 0;
+
+        for (auto& rSession : m_Sessions)
+        {
+            CMessage Message;
+
+            Message.m_Category         = _rMessage.m_Category;
+            Message.m_MessageType      = _rMessage.m_MessageType;
+            Message.m_CompressedSize   = _rMessage.m_CompressedSize;
+            Message.m_DecompressedSize = _rMessage.m_DecompressedSize;
+            Message.m_Payload          = _rMessage.m_Payload;
+
+            if (rSession.second.m_pSocket->SendMessage(std::move(Message)))
+            {
+                ++ NumberOfSessions;
+            }
+        }
+
+        return NumberOfSessions;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CServerSocket::SetQueueLimit(Base::Size _MaxNumberOfMessages, SQueuePolicy::Enum _Policy)
+    {
+        m_MaxNumberOfQueuedMessages = _MaxNumberOfMessages;
+        m_QueuePolicy               = _Policy;
+
+        for (auto& rSession : m_Sessions)
+        {
+            rSession.second.m_pSocket->SetQueueLimit(_MaxNumberOfMessages, _Policy);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CServerSocket::SetCodec(int _Category, SCodec::Enum _Codec)
+    {
+        m_Codecs[_Category] = _Codec;
+
+        for (auto& rSession : m_Sessions)
+        {
+            rSession.second.m_pSocket->SetCodec(_Category, _Codec);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CServerSocket::Accept()
+    {
+        m_pPendingSocket = std::make_unique<asio::ip::tcp::socket>(CNetworkManager::GetInstance().GetIOService());
+
+        m_pAcceptor->async_accept(*m_pPendingSocket, m_Strand.wrap(std::bind(&CServerSocket::OnAccept, this, std::placeholders::_1)));
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CServerSocket::OnAccept(const std::error_code& _rError)
+    {
+        if (_rError)
+        {
+            ENGINE_CONSOLE_DEBUG(_rError.message().c_str());
+
+            if (_rError == asio::error::operation_aborted) return;
+        }
+        else
+        {
+            std::lock_guard<std::mutex> Lock(m_Mutex);
+
+            m_AcceptedSockets.emplace_back(std::move(m_pPendingSocket));
+        }
+
+        Accept();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CServerSocket::DeleteSocket(CSocket* _pSocket)
+    {
+        delete _pSocket;
+    }
+} // namespace Net
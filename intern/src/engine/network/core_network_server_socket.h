@@ -0,0 +1,102 @@
+
+#pragma once
+
+#include "base/base_uncopyable.h"
+
+#include "engine/engine_config.h"
+
+#include "engine/network/core_network_codec.h"
+#include "engine/network/core_network_common.h"
+#include "engine/network/core_network_socket.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Net
+{
+    // -----------------------------------------------------------------------------
+    // Server socket that keeps accepting. Every connection becomes a session
+    // with its own handle; the messages of all sessions arrive at the handlers
+    // of the server together with the handle of their session. A new session
+    // is announced by a message of type 3, a closed one by type 2.
+    // -----------------------------------------------------------------------------
+    class ENGINE_API CServerSocket : private Base::CUncopyable
+    {
+    private:
+
+        using CMessageDelegate = CSocket::CMessageDelegate;
+
+    private:
+
+        friend class CNetworkManager;
+
+        void Update();
+
+        int GetPort() const;
+
+        bool HasSessions() const;
+
+        CSocket* GetSession(SocketHandle _SessionHandle);
+        const CSocket* GetSession(SocketHandle _SessionHandle) const;
+
+        std::vector<SocketHandle> GetSessionHandles() const;
+
+        CMessageDelegate::HandleType RegisterMessageHandler(CMessageDelegate::FunctionType _Function);
+
+        // -----------------------------------------------------------------------------
+        // The payload is shared by all sessions, only the header is written per
+        // session. Returns the number of sessions that took the message.
+        // -----------------------------------------------------------------------------
+        Base::Size Broadcast(const CMessage& _rMessage);
+
+        void SetQueueLimit(Base::Size _MaxNumberOfMessages, SQueuePolicy::Enum _Policy);
+
+        void SetCodec(int _Category, SCodec::Enum _Codec);
+
+    private:
+
+        struct SSession
+        {
+            std::unique_ptr<CSocket, void(*)(CSocket*)> m_pSocket;
+            CMessageDelegate::HandleType m_HandlerPtr;
+        };
+
+        using CSessions = std::map<SocketHandle, SSession>;
+
+    private:
+
+        int m_Port;
+
+        asio::io_service::strand m_Strand;
+
+        std::unique_ptr<asio::ip::tcp::acceptor> m_pAcceptor;
+        std::unique_ptr<asio::ip::tcp::socket> m_pPendingSocket;
+
+        std::mutex m_Mutex;
+        std::vector<std::unique_ptr<asio::ip::tcp::socket>> m_AcceptedSockets;      //< Handed from the IO thread to Update()
+
+        CSessions m_Sessions;
+        std::vector<SSession> m_ClosedSessions;                                    //< Destroyed once their handlers are done
+
+        CMessageDelegate m_MessageDelegate;
+
+        Base::Size m_MaxNumberOfQueuedMessages;
+        SQueuePolicy::Enum m_QueuePolicy;
+
+        std::map<int, SCodec::Enum> m_Codecs;                                      //< Applied to every new session
+
+    private:
+
+        void Accept();
+        void OnAccept(const std::error_code& _rError);
+
+        static void DeleteSocket(CSocket* _pSocket);
+
+    private:
+
+        CServerSocket(int _Port);
+        ~CServerSocket();
+    };
+} // namespace Net
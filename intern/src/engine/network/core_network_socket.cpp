@@ -2,42 +2,73 @@
 #include "engine/engine_precompiled.h"
 
 #include "base/base_exception.h"
+#include "base/base_memory.h"
 
 #include "engine/core/core_console.h"
+#include "engine/core/core_program_parameters.h"
 
 #include "engine/network/core_network_manager.h"
 #include "engine/network/core_network_socket.h"
 
+#include <algorithm>
+#include <chrono>
 #include <functional>
 #include <iostream>
 #include <memory>
 
 namespace Net
 {
-    void CSocket::Update()
+    const Base::Size CSocket::s_MaxNumberOfPooledPayloads;
+
+    // -----------------------------------------------------------------------------
+
+    void CSocket::Update(bool _IsFlush)
     {
-        if (m_IsConnectionLost)
+        if (m_IsConnectionLost.exchange(false))
         {
-            AsyncReconnect();
-            m_IsConnectionLost = false;
+            m_Strand.post(Track(std::bind(&CSocket::AsyncReconnect, this)));
         }
 
-        m_Mutex.lock();
+        // -----------------------------------------------------------------------------
+        // The handlers run without any lock, so a slow handler never blocks the
+        // IO thread. At least one message is handled per update.
+        // -----------------------------------------------------------------------------
+        const auto StartTime = std::chrono::steady_clock::now();
+        const auto EndTime   = StartTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(m_ReceiveBudgetInMs));
 
-        while (!m_MessageQueue.empty())
+        const bool IsBudgeted = !_IsFlush && m_ReceiveBudgetInMs > 0.0;
+
+        CMessage Message;
+
+        m_NumberOfHandledMessages = 0;
+
+        auto Time = StartTime;
+
+        while (m_ReceivedMessages.TryPop(Message))
         {
-            auto& rMessage = m_MessageQueue.front();
-            
-            m_MessageDelegate.Notify(rMessage, m_Port);
+            m_MessageDelegate.Notify(Message, m_Handle);
+
+            ++ m_NumberOfHandledMessages;
 
-            m_MessageQueue.pop();
+            Time = std::chrono::steady_clock::now();
+
+            if (IsBudgeted && Time >= EndTime)
+            {
+                if (!m_ReceivedMessages.IsEmpty()) ++ m_NumberOfDeferredUpdates;
+
+                break;
+            }
         }
 
-        m_Mutex.unlock();
+        m_HandlerDurationInMs    = std::chrono::duration<double, std::milli>(Time - StartTime).count();
+        m_MaxHandlerDurationInMs = std::max(m_MaxHandlerDurationInMs, m_HandlerDurationInMs);
 
-        if (!m_IsSending && !m_OutgoingMessages.empty())
+        // -----------------------------------------------------------------------------
+        // The queue has room again, so the IO thread moves its overflow over
+        // -----------------------------------------------------------------------------
+        if (m_HasOverflow.exchange(false))
         {
-            InternalSendMessage();
+            m_Strand.post(Track(std::bind(&CSocket::DrainOverflow, this)));
         }
     }
 
@@ -50,76 +81,382 @@ namespace Net
 
     // -----------------------------------------------------------------------------
 
-    void CSocket::OnSendComplete(std::shared_ptr<std::vector<char>> _Data)
+    void CSocket::OnSendComplete(const std::error_code& _rError, size_t _TransferredBytes)
     {
-        BASE_UNUSED(_Data);
+        BASE_UNUSED(_TransferredBytes);
 
-        CMessage Message;
-        Message.m_MessageType = 1;
-        
-        m_Mutex.lock();
+        // -----------------------------------------------------------------------------
+        // Every message of the batch is reported as sent
+        // -----------------------------------------------------------------------------
+        if (!_rError)
+        {
+            for (size_t IndexOfMessage = 0; IndexOfMessage < m_MessagesInFlight.size(); ++IndexOfMessage)
+            {
+                if (m_MessagesInFlight[IndexOfMessage].m_Category == s_HandshakeCategory) continue;
+
+                CMessage Message;
+                Message.m_MessageType = 1;
 
-        m_MessageQueue.push(Message);
+                EnqueueMessage(std::move(Message));
+            }
+        }
 
-        m_Mutex.unlock();
+        m_NumberOfPendingBytes -= m_NumberOfBytesInFlight;
+
+        m_MessagesInFlight.clear();
+
+        m_NumberOfBytesInFlight = 0;
 
         m_IsSending = false;
+
+        // -----------------------------------------------------------------------------
+        // Keep draining the queue from the IO thread
+        // -----------------------------------------------------------------------------
+        if (!_rError)
+        {
+            InternalSendMessage();
+        }
     }
 
     // -----------------------------------------------------------------------------
     
-    bool CSocket::SendMessage(const CMessage& _rMessage)
+    bool CSocket::SendMessage(CMessage&& _rMessage)
     {
-        if (IsOpen())
+        if (!IsOpen())
         {
-            m_OutgoingMessages.emplace_back(_rMessage);
+            return false;
+        }
+
+        // -----------------------------------------------------------------------------
+        // Backpressure: once the queue reached the high watermark, messages
+        // are refused until it drained below the low watermark.
+        // -----------------------------------------------------------------------------
+        const Base::Size NumberOfPendingBytes = m_NumberOfPendingBytes;
 
-            return true;
+        if (NumberOfPendingBytes >= m_HighWatermark)
+        {
+            m_IsThrottled = true;
         }
-        else
+        else if (NumberOfPendingBytes <= m_LowWatermark)
+        {
+            m_IsThrottled = false;
+        }
+
+        if (m_IsThrottled)
         {
             return false;
         }
+
+        m_SendMutex.lock();
+
+        // -----------------------------------------------------------------------------
+        // A full queue drops a stale message or refuses the new one
+        // -----------------------------------------------------------------------------
+        if (m_MaxNumberOfQueuedMessages > 0 && m_OutgoingMessages.size() >= m_MaxNumberOfQueuedMessages)
+        {
+            if (m_QueuePolicy == SQueuePolicy::Refuse)
+            {
+                m_SendMutex.unlock();
+
+                ++ m_NumberOfDroppedMessages;
+
+                return false;
+            }
+
+            auto StaleIterator = m_OutgoingMessages.begin();
+
+            if (m_QueuePolicy == SQueuePolicy::Coalesce)
+            {
+                StaleIterator = std::find_if(m_OutgoingMessages.begin(), m_OutgoingMessages.end(), [&](const CMessage& _rQueuedMessage) { return _rQueuedMessage.m_Category == _rMessage.m_Category; });
+
+                // -----------------------------------------------------------------------------
+                // Nothing of the same category to replace: messages of other
+                // categories are never dropped in favor of this one.
+                // -----------------------------------------------------------------------------
+                if (StaleIterator == m_OutgoingMessages.end())
+                {
+                    m_SendMutex.unlock();
+
+                    ++ m_NumberOfDroppedMessages;
+
+                    return false;
+                }
+            }
+
+            m_NumberOfPendingBytes -= GetNumberOfBytesOnWire(*StaleIterator) - s_HeaderSize;
+
+            m_OutgoingMessages.erase(StaleIterator);
+
+            ++ m_NumberOfDroppedMessages;
+        }
+
+        m_NumberOfPendingBytes += GetNumberOfBytesOnWire(_rMessage) - s_HeaderSize;
+
+        m_OutgoingMessages.emplace_back(std::move(_rMessage));
+
+        m_SendMutex.unlock();
+
+        // -----------------------------------------------------------------------------
+        // The IO thread is only woken up if it does not have a send pending
+        // -----------------------------------------------------------------------------
+        if (!m_IsSendScheduled.exchange(true))
+        {
+            m_Strand.post(Track(std::bind(&CSocket::OnScheduledSend, this)));
+        }
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CSocket::SetSendWatermarks(Base::Size _HighWatermark, Base::Size _LowWatermark)
+    {
+        assert(_LowWatermark <= _HighWatermark);
+
+        m_HighWatermark = _HighWatermark;
+        m_LowWatermark  = _LowWatermark;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CSocket::SetQueueLimit(Base::Size _MaxNumberOfMessages, SQueuePolicy::Enum _Policy)
+    {
+        std::lock_guard<std::mutex> Lock(m_SendMutex);
+
+        m_MaxNumberOfQueuedMessages = _MaxNumberOfMessages;
+        m_QueuePolicy               = _Policy;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CSocket::SetCodec(int _Category, SCodec::Enum _Codec)
+    {
+        std::lock_guard<std::mutex> Lock(m_SendMutex);
+
+        m_Codecs[_Category] = _Codec;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Base::Size CSocket::GetNumberOfPendingBytes() const
+    {
+        return m_NumberOfPendingBytes;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Base::Size CSocket::GetNumberOfDroppedMessages() const
+    {
+        return m_NumberOfDroppedMessages;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    SReceiveStatistics CSocket::GetReceiveStatistics() const
+    {
+        SReceiveStatistics Statistics;
+
+        Statistics.m_NumberOfQueuedMessages     = m_ReceivedMessages.GetSize();
+        Statistics.m_PeakNumberOfQueuedMessages = m_PeakNumberOfQueuedMessages.load(std::memory_order_relaxed);
+        Statistics.m_NumberOfHandledMessages    = m_NumberOfHandledMessages;
+        Statistics.m_NumberOfDeferredUpdates    = m_NumberOfDeferredUpdates;
+        Statistics.m_NumberOfStalls             = m_NumberOfStalls.load(std::memory_order_relaxed);
+        Statistics.m_HandlerDurationInMs        = m_HandlerDurationInMs;
+        Statistics.m_MaxHandlerDurationInMs     = m_MaxHandlerDurationInMs;
+
+        return Statistics;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CSocket::HasPendingOperations() const
+    {
+        if (m_OperationTokenPtr.use_count() > 1) return true;
+
+        // -----------------------------------------------------------------------------
+        // The last handler released its copy, so everything it wrote is visible
+        // -----------------------------------------------------------------------------
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        return false;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CSocket::OnScheduledSend()
+    {
+        m_IsSendScheduled = false;
+
+        InternalSendMessage();
     }
 
     // -----------------------------------------------------------------------------
 
     void CSocket::InternalSendMessage()
     {
-        if (!m_IsSending)
+        if (m_IsSending || !m_IsOpen) return;
+
+        // -----------------------------------------------------------------------------
+        // Take a batch of messages from the queue
+        // -----------------------------------------------------------------------------
+        Base::Size NumberOfBytesInBatch = 0;
+
+        m_SendMutex.lock();
+
+        while (!m_OutgoingMessages.empty() && m_MessagesInFlight.size() < s_MaxNumberOfMessagesPerWrite && (NumberOfBytesInBatch < s_MaxNumberOfBytesPerWrite || m_MessagesInFlight.empty()))
+        {
+            NumberOfBytesInBatch += GetNumberOfBytesOnWire(m_OutgoingMessages.front());
+
+            m_MessagesInFlight.emplace_back(std::move(m_OutgoingMessages.front()));
+
+            m_OutgoingMessages.pop_front();
+        }
+
+        m_CodecsInFlight.clear();
+
+        for (const CMessage& rMessage : m_MessagesInFlight)
+        {
+            m_CodecsInFlight.push_back(SelectCodec(rMessage));
+        }
+
+        m_SendMutex.unlock();
+
+        if (m_MessagesInFlight.empty()) return;
+
+        m_IsSending = true;
+
+        // -----------------------------------------------------------------------------
+        // The pending bytes are counted without compression, so the payloads
+        // are encoded after the batch was accounted for.
+        // -----------------------------------------------------------------------------
+        m_NumberOfBytesInFlight = NumberOfBytesInBatch - m_MessagesInFlight.size() * s_HeaderSize;
+
+        EncodePayloads();
+
+        // -----------------------------------------------------------------------------
+        // Headers and small payloads are coalesced in the staging buffer, large
+        // payloads are written from the shared buffers of the messages
+        // (scatter-gather) and never copied.
+        // -----------------------------------------------------------------------------
+        Base::Size NumberOfStagingBytes = 0;
+
+        for (const CMessage& rMessage : m_MessagesInFlight)
+        {
+            const Base::Size NumberOfPayloadBytes = GetNumberOfBytesOnWire(rMessage) - s_HeaderSize;
+
+            NumberOfStagingBytes += s_HeaderSize + (NumberOfPayloadBytes <= s_MaxNumberOfBytesToCoalesce ? NumberOfPayloadBytes : 0);
+        }
+
+        if (m_NumberOfSendBytes < NumberOfStagingBytes)
+        {
+            Base::CMemory::Free(m_pSendBytes, Base::CMemory::Network);
+
+            m_NumberOfSendBytes = NumberOfStagingBytes;
+            m_pSendBytes        = static_cast<char*>(Base::CMemory::Allocate(m_NumberOfSendBytes, Base::CMemory::Network));
+        }
+
+        m_SendBuffers.clear();
+
+        char* pStagingBegin = m_pSendBytes;
+        char* pStaging      = m_pSendBytes;
+
+        for (Base::Size IndexOfMessage = 0; IndexOfMessage < m_MessagesInFlight.size(); ++ IndexOfMessage)
         {
-            m_IsSending = true;
+            const CMessage& rMessage = m_MessagesInFlight[IndexOfMessage];
+
+            const Base::Size NumberOfPayloadBytes = GetNumberOfBytesOnWire(rMessage) - s_HeaderSize;
+
+            auto MessageID32 = static_cast<int32_t>(m_CodecsInFlight[IndexOfMessage] != SCodec::None ? rMessage.m_Category | s_EncodedCategoryFlag : rMessage.m_Category);
+            auto MessageLength32 = static_cast<int32_t>(NumberOfPayloadBytes);
+            auto DecompressedMessageLength32 = rMessage.m_DecompressedSize != 0 ? static_cast<int32_t>(rMessage.m_DecompressedSize) : MessageLength32;
 
-            const CMessage& Message = m_OutgoingMessages.front();
+            std::memcpy(pStaging, &MessageID32, sizeof(MessageID32));
+            std::memcpy(pStaging + sizeof(int32_t), &MessageLength32, sizeof(MessageLength32));
+            std::memcpy(pStaging + 2 * sizeof(int32_t), &DecompressedMessageLength32, sizeof(DecompressedMessageLength32));
 
-            int MessageLength = Message.m_CompressedSize;
-            const auto& Data = Message.m_Payload;
-            const int MessageCategory = Message.m_Category;
+            pStaging += s_HeaderSize;
 
-            if (MessageLength == 0)
+            if (NumberOfPayloadBytes <= s_MaxNumberOfBytesToCoalesce)
             {
-                MessageLength = static_cast<int>(Data.size());
+                std::memcpy(pStaging, rMessage.m_Payload.GetData(), NumberOfPayloadBytes);
+
+                pStaging += NumberOfPayloadBytes;
             }
+            else
+            {
+                m_SendBuffers.emplace_back(asio::buffer(pStagingBegin, pStaging - pStagingBegin));
+                m_SendBuffers.emplace_back(asio::buffer(rMessage.m_Payload.GetData(), NumberOfPayloadBytes));
+
+                pStagingBegin = pStaging;
+            }
+        }
 
-            int DataLength = MessageLength + 3 * sizeof(int32_t);
+        if (pStaging != pStagingBegin)
+        {
+            m_SendBuffers.emplace_back(asio::buffer(pStagingBegin, pStaging - pStagingBegin));
+        }
 
-            std::shared_ptr<std::vector<char>> pData = std::make_shared<std::vector<char>>();
+        asio::async_write(*m_pSocket, m_SendBuffers, m_Strand.wrap(Track(std::bind(&CSocket::OnSendComplete, this, std::placeholders::_1, std::placeholders::_2))));
+    }
 
-            pData->resize(DataLength);
+    // -----------------------------------------------------------------------------
 
-            auto MessageID32 = static_cast<int32_t>(MessageCategory);
-            auto MessageLength32 = static_cast<int32_t>(MessageLength);
+    SCodec::Enum CSocket::SelectCodec(const CMessage& _rMessage) const
+    {
+        if (!m_IsCompressionEnabled || _rMessage.m_Category == s_HandshakeCategory) return SCodec::None;
 
-            std::memcpy(pData->data(), &MessageID32, sizeof(MessageID32));
-            std::memcpy(pData->data() + sizeof(int32_t), &MessageLength32, sizeof(MessageLength32));
-            std::memcpy(pData->data() + 2 * sizeof(int32_t), &MessageLength32, sizeof(MessageLength32)); // TODO: Add compression
-            std::memcpy(pData->data() + 3 * sizeof(int32_t), Data.data(), MessageLength32);
+        // -----------------------------------------------------------------------------
+        // Payloads that were compressed by the application are not touched
+        // -----------------------------------------------------------------------------
+        if (_rMessage.m_CompressedSize != _rMessage.m_DecompressedSize) return SCodec::None;
 
-            asio::async_write(*m_pSocket, asio::buffer(*pData, DataLength), std::bind(&CSocket::OnSendComplete, this, pData));
+        if (_rMessage.m_Payload.GetNumberOfBytes() < m_MinNumberOfBytesToCompress) return SCodec::None;
 
-            m_OutgoingMessages.pop_front();
+        auto Iterator = m_Codecs.find(_rMessage.m_Category);
+
+        const SCodec::Enum Codec = Iterator != m_Codecs.end() ? Iterator->second : m_DefaultCodec;
+
+        return (m_PeerCodecs & (1 << Codec)) != 0 ? Codec : SCodec::None;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CSocket::EncodePayloads()
+    {
+        for (Base::Size IndexOfMessage = 0; IndexOfMessage < m_MessagesInFlight.size(); ++ IndexOfMessage)
+        {
+            if (m_CodecsInFlight[IndexOfMessage] == SCodec::None) continue;
+
+            CMessage& rMessage = m_MessagesInFlight[IndexOfMessage];
+
+            const Base::Size NumberOfBytes = rMessage.m_Payload.GetNumberOfBytes();
+
+            CPayloadPool::CBufferPtr EncodedBytesPtr = m_EncodedPayloadPoolPtr->Allocate(NumberOfBytes);
+
+            if (!m_Encoder.Encode(m_CodecsInFlight[IndexOfMessage], rMessage.m_Payload.GetData(), NumberOfBytes, *EncodedBytesPtr))
+            {
+                m_CodecsInFlight[IndexOfMessage] = SCodec::None;
+
+                continue;
+            }
+
+            rMessage.m_CompressedSize   = static_cast<int>(EncodedBytesPtr->size());
+            rMessage.m_DecompressedSize = static_cast<int>(NumberOfBytes);
+            rMessage.m_Payload          = CPayload(std::move(EncodedBytesPtr));
         }
-    };
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Base::Size CSocket::GetNumberOfBytesOnWire(const CMessage& _rMessage)
+    {
+        // -----------------------------------------------------------------------------
+        // The compressed size is sent if it is set, otherwise the whole payload
+        // -----------------------------------------------------------------------------
+        Base::Size NumberOfPayloadBytes = _rMessage.m_CompressedSize != 0 ? static_cast<Base::Size>(_rMessage.m_CompressedSize) : _rMessage.m_Payload.GetNumberOfBytes();
+
+        return s_HeaderSize + NumberOfPayloadBytes;
+    }
 
     // -----------------------------------------------------------------------------
 
@@ -141,15 +478,29 @@ namespace Net
 				BASE_THROWV("Length of compressed message is invalid (%i)", CompressedMessageLength);
             }
 
-			if (CompressedMessageLength < 1)
+			if (DecompressedMessageLength < 1)
 			{
 				BASE_THROWV("Length of decompressed message is invalid (%i)", DecompressedMessageLength);
 			}
 
-            m_PendingMessage.m_Payload.resize(CompressedMessageLength);
+            // -----------------------------------------------------------------------------
+            // Only peers that negotiated compression mark encoded payloads
+            // -----------------------------------------------------------------------------
+            m_IsPendingPayloadEncoded = m_IsCompressionEnabled && m_PeerCodecs != 0 && MessageID != s_HandshakeCategory && (MessageID & s_EncodedCategoryFlag) != 0;
 
-            auto Callback = std::bind(&CSocket::ReceivePayload, this, std::placeholders::_1, std::placeholders::_2);
-            asio::async_read(*m_pSocket, asio::buffer(m_PendingMessage.m_Payload), asio::transfer_exactly(CompressedMessageLength), Callback);
+            if (m_IsPendingPayloadEncoded)
+            {
+                MessageID &= ~s_EncodedCategoryFlag;
+            }
+
+            // -----------------------------------------------------------------------------
+            // The payload is read into a recycled buffer that becomes the
+            // payload of the message without another copy.
+            // -----------------------------------------------------------------------------
+            m_PendingBytesPtr = m_PayloadPoolPtr->Allocate(CompressedMessageLength);
+
+            auto Callback = m_Strand.wrap(Track(std::bind(&CSocket::ReceivePayload, this, std::placeholders::_1, std::placeholders::_2)));
+            asio::async_read(*m_pSocket, asio::buffer(*m_PendingBytesPtr), asio::transfer_exactly(CompressedMessageLength), Callback);
 
             m_PendingMessage.m_Category = MessageID;
             m_PendingMessage.m_MessageType = 0;
@@ -167,15 +518,68 @@ namespace Net
     void CSocket::ReceivePayload(const std::error_code& _rError, size_t _TransferredBytes)
     {
         BASE_UNUSED(_TransferredBytes);
-        
-        m_Mutex.lock();
-
-        m_MessageQueue.push(m_PendingMessage);
-
-        m_Mutex.unlock();
 
         if (!_rError)
         {
+            if (m_PendingMessage.m_Category == s_HandshakeCategory)
+            {
+                int32_t Codecs = 0;
+
+                std::memcpy(&Codecs, m_PendingBytesPtr->data(), std::min(sizeof(Codecs), m_PendingBytesPtr->size()));
+
+                m_PeerCodecs = Codecs;
+
+                m_PendingMessage = CMessage();
+
+                StartListening();
+
+                return;
+            }
+
+            // -----------------------------------------------------------------------------
+            // Encoded payloads are decoded on the IO thread, the handlers get
+            // the decompressed bytes. Payloads the peer application compressed
+            // itself are left to the handlers.
+            // -----------------------------------------------------------------------------
+            const char* pBytes = m_PendingBytesPtr->data();
+
+            if (m_IsPendingPayloadEncoded)
+            {
+                CPayloadPool::CBufferPtr DecodedBytesPtr = m_PayloadPoolPtr->Allocate(m_PendingMessage.m_DecompressedSize);
+
+                if (!m_Decoder.Decode(pBytes, m_PendingBytesPtr->size(), DecodedBytesPtr->data(), DecodedBytesPtr->size()))
+                {
+                    ENGINE_CONSOLE_ERRORV("Failed to decompress a message of category %i on port %i", m_PendingMessage.m_Category, m_Port);
+
+                    m_IsConnectionLost = true;
+
+                    return;
+                }
+
+                m_PendingBytesPtr = std::move(DecodedBytesPtr);
+
+                m_PendingMessage.m_CompressedSize = m_PendingMessage.m_DecompressedSize;
+            }
+
+            m_PendingMessage.m_Payload = CPayload(std::move(m_PendingBytesPtr));
+
+            EnqueueMessage(std::move(m_PendingMessage));
+
+            m_PendingMessage = CMessage();
+
+            // -----------------------------------------------------------------------------
+            // Reading stops while messages wait in the overflow, so a slow main
+            // thread slows down the peer through TCP instead of piling up memory.
+            // -----------------------------------------------------------------------------
+            if (!m_OverflowMessages.empty())
+            {
+                m_IsReceivePaused = true;
+
+                ++ m_NumberOfStalls;
+
+                return;
+            }
+
             StartListening();
         }
         else
@@ -186,6 +590,55 @@ namespace Net
 
     // -----------------------------------------------------------------------------
 
+    void CSocket::EnqueueMessage(CMessage&& _rMessage)
+    {
+        // -----------------------------------------------------------------------------
+        // Messages keep their order: once one waits in the overflow, all
+        // following ones do as well.
+        // -----------------------------------------------------------------------------
+        if (m_OverflowMessages.empty() && m_ReceivedMessages.TryPush(_rMessage))
+        {
+            const Base::Size NumberOfQueuedMessages = m_ReceivedMessages.GetSize();
+
+            if (NumberOfQueuedMessages > m_PeakNumberOfQueuedMessages.load(std::memory_order_relaxed))
+            {
+                m_PeakNumberOfQueuedMessages.store(NumberOfQueuedMessages, std::memory_order_relaxed);
+            }
+
+            return;
+        }
+
+        m_OverflowMessages.emplace_back(std::move(_rMessage));
+
+        m_HasOverflow = true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CSocket::DrainOverflow()
+    {
+        while (!m_OverflowMessages.empty() && m_ReceivedMessages.TryPush(m_OverflowMessages.front()))
+        {
+            m_OverflowMessages.pop_front();
+        }
+
+        if (!m_OverflowMessages.empty())
+        {
+            m_HasOverflow = true;
+
+            return;
+        }
+
+        if (m_IsReceivePaused)
+        {
+            m_IsReceivePaused = false;
+
+            StartListening();
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
     void CSocket::OnConnect(const std::system_error& _rError)
     {
         if (!_rError.code())
@@ -193,6 +646,7 @@ namespace Net
             m_IsOpen = true;
             ENGINE_CONSOLE_INFOV("Connected on port %i", m_Port);
             StartListening();
+            Handshake();
         }
         else
         {
@@ -203,9 +657,47 @@ namespace Net
     
     // -----------------------------------------------------------------------------
 
+    void CSocket::Handshake()
+    {
+        m_PeerCodecs = 0;
+
+        m_Encoder.Reset();
+        m_Decoder.Reset();
+
+        // -----------------------------------------------------------------------------
+        // Peers that do not negotiate never see a handshake and are never sent
+        // compressed payloads.
+        // -----------------------------------------------------------------------------
+        if (m_IsCompressionEnabled)
+        {
+            const int32_t Codecs = (1 << SCodec::Zlib) | (1 << SCodec::LZ);
+
+            std::vector<char> Payload(sizeof(Codecs));
+
+            std::memcpy(Payload.data(), &Codecs, sizeof(Codecs));
+
+            CMessage Message;
+
+            Message.m_Category = s_HandshakeCategory;
+            Message.m_Payload  = CPayload(std::move(Payload));
+
+            m_SendMutex.lock();
+
+            m_NumberOfPendingBytes += GetNumberOfBytesOnWire(Message) - s_HeaderSize;
+
+            m_OutgoingMessages.emplace_front(std::move(Message));
+
+            m_SendMutex.unlock();
+        }
+
+        InternalSendMessage();
+    }
+
+    // -----------------------------------------------------------------------------
+
     void CSocket::StartListening()
     {
-        auto Callback = std::bind(&CSocket::ReceiveHeader, this, std::placeholders::_1, std::placeholders::_2);
+        auto Callback = m_Strand.wrap(Track(std::bind(&CSocket::ReceiveHeader, this, std::placeholders::_1, std::placeholders::_2)));
         asio::async_read(*m_pSocket, asio::buffer(m_Header), asio::transfer_exactly(s_HeaderSize), Callback);
     }
 
@@ -225,7 +717,7 @@ namespace Net
 
                 m_Header.resize(s_HeaderSize);
 
-                m_pAcceptor->async_accept(*m_pSocket, *m_pEndpoint, std::bind(&CSocket::OnConnect, this, std::placeholders::_1));
+                m_pAcceptor->async_accept(*m_pSocket, *m_pEndpoint, m_Strand.wrap(Track(std::bind(&CSocket::OnConnect, this, std::placeholders::_1))));
             }
             else
             {
@@ -236,7 +728,7 @@ namespace Net
 
                 m_Header.resize(s_HeaderSize);
 
-                m_pSocket->async_connect(*m_pEndpoint, std::bind(&CSocket::OnConnect, this, std::placeholders::_1));
+                m_pSocket->async_connect(*m_pEndpoint, m_Strand.wrap(Track(std::bind(&CSocket::OnConnect, this, std::placeholders::_1))));
             }
         }
         catch (const std::exception& e)
@@ -249,8 +741,17 @@ namespace Net
 
     void CSocket::AsyncReconnect()
     {
+        m_SendMutex.lock();
+
+        for (const CMessage& rMessage : m_OutgoingMessages)
+        {
+            m_NumberOfPendingBytes -= GetNumberOfBytesOnWire(rMessage) - s_HeaderSize;
+        }
+
         m_OutgoingMessages.clear();
 
+        m_SendMutex.unlock();
+
         // Notify listener that the connection was lost
         CMessage Message;
         Message.m_Category = 0;
@@ -258,18 +759,23 @@ namespace Net
         Message.m_CompressedSize = 0;
         Message.m_DecompressedSize = 0;
 
-        m_Mutex.lock();
+        EnqueueMessage(std::move(Message));
 
-        m_MessageQueue.push(Message);
-
-        m_Mutex.unlock();
+        // -----------------------------------------------------------------------------
+        // The next connection starts reading on its own
+        // -----------------------------------------------------------------------------
+        m_IsReceivePaused = false;
 
         // Try to reconnect
         m_IsOpen = false;
-        m_IsSending = false;
         m_pSocket->close();
         ENGINE_CONSOLE_INFOV("Connection lost on port %i", m_Port);
 
+        // -----------------------------------------------------------------------------
+        // A session is closed for good, its server accepts the next viewer
+        // -----------------------------------------------------------------------------
+        if (m_IsSession) return;
+
         Connect();
     }
 
@@ -305,29 +811,154 @@ namespace Net
 
     CSocket::CSocket(int _Port)
         : m_Port(_Port)
+        , m_Handle(_Port)
         , m_IsOpen(false)
+        , m_Strand(CNetworkManager::GetInstance().GetIOService())
         , m_IsSending(false)
         , m_IsConnectionLost(false)
         , m_IsServer(true)
+        , m_IsSession(false)
+        , m_IsSendScheduled(false)
+        , m_NumberOfPendingBytes(0)
+        , m_NumberOfBytesInFlight(0)
+        , m_HighWatermark(Core::CProgramParameters::GetInstance().Get("network:send:high_watermark", s_DefaultHighWatermark))
+        , m_LowWatermark(Core::CProgramParameters::GetInstance().Get("network:send:low_watermark", s_DefaultLowWatermark))
+        , m_IsThrottled(false)
+        , m_MaxNumberOfQueuedMessages(0)
+        , m_QueuePolicy(SQueuePolicy::Refuse)
+        , m_NumberOfDroppedMessages(0)
+        , m_IsCompressionEnabled(Core::CProgramParameters::GetInstance().Get("network:compression:enabled", false))
+        , m_MinNumberOfBytesToCompress(Core::CProgramParameters::GetInstance().Get("network:compression:min_bytes", s_DefaultMinNumberOfBytesToCompress))
+        , m_DefaultCodec(SCodec::LZ)
+        , m_PeerCodecs(0)
+        , m_Encoder(Core::CProgramParameters::GetInstance().Get("network:compression:zlib_level", 1))
+        , m_Decoder()
+        , m_IsPendingPayloadEncoded(false)
+        , m_EncodedPayloadPoolPtr(std::make_shared<CPayloadPool>(s_MaxNumberOfPooledPayloads))
+        , m_pSendBytes(nullptr)
+        , m_NumberOfSendBytes(0)
+        , m_PayloadPoolPtr(std::make_shared<CPayloadPool>(s_MaxNumberOfPooledPayloads))
+        , m_ReceivedMessages(Core::CProgramParameters::GetInstance().Get("network:receive:queue_size", s_DefaultReceiveQueueSize))
+        , m_IsReceivePaused(false)
+        , m_HasOverflow(false)
+        , m_PeakNumberOfQueuedMessages(0)
+        , m_NumberOfStalls(0)
+        , m_ReceiveBudgetInMs(Core::CProgramParameters::GetInstance().Get("network:receive:budget_ms", 4.0))
+        , m_NumberOfHandledMessages(0)
+        , m_NumberOfDeferredUpdates(0)
+        , m_HandlerDurationInMs(0.0)
+        , m_MaxHandlerDurationInMs(0.0)
+        , m_OperationTokenPtr(std::make_shared<char>(0))
     {
         Connect();
     }
 
     CSocket::CSocket(const std::string& _IP, int _Port)
         : m_Port(_Port)
+        , m_Handle(_Port)
         , m_IP(_IP)
         , m_IsOpen(false)
+        , m_Strand(CNetworkManager::GetInstance().GetIOService())
         , m_IsSending(false)
         , m_IsConnectionLost(false)
         , m_IsServer(false)
+        , m_IsSession(false)
+        , m_IsSendScheduled(false)
+        , m_NumberOfPendingBytes(0)
+        , m_NumberOfBytesInFlight(0)
+        , m_HighWatermark(Core::CProgramParameters::GetInstance().Get("network:send:high_watermark", s_DefaultHighWatermark))
+        , m_LowWatermark(Core::CProgramParameters::GetInstance().Get("network:send:low_watermark", s_DefaultLowWatermark))
+        , m_IsThrottled(false)
+        , m_MaxNumberOfQueuedMessages(0)
+        , m_QueuePolicy(SQueuePolicy::Refuse)
+        , m_NumberOfDroppedMessages(0)
+        , m_IsCompressionEnabled(Core::CProgramParameters::GetInstance().Get("network:compression:enabled", false))
+        , m_MinNumberOfBytesToCompress(Core::CProgramParameters::GetInstance().Get("network:compression:min_bytes", s_DefaultMinNumberOfBytesToCompress))
+        , m_DefaultCodec(SCodec::LZ)
+        , m_PeerCodecs(0)
+        , m_Encoder(Core::CProgramParameters::GetInstance().Get("network:compression:zlib_level", 1))
+        , m_Decoder()
+        , m_IsPendingPayloadEncoded(false)
+        , m_EncodedPayloadPoolPtr(std::make_shared<CPayloadPool>(s_MaxNumberOfPooledPayloads))
+        , m_pSendBytes(nullptr)
+        , m_NumberOfSendBytes(0)
+        , m_PayloadPoolPtr(std::make_shared<CPayloadPool>(s_MaxNumberOfPooledPayloads))
+        , m_ReceivedMessages(Core::CProgramParameters::GetInstance().Get("network:receive:queue_size", s_DefaultReceiveQueueSize))
+        , m_IsReceivePaused(false)
+        , m_HasOverflow(false)
+        , m_PeakNumberOfQueuedMessages(0)
+        , m_NumberOfStalls(0)
+        , m_ReceiveBudgetInMs(Core::CProgramParameters::GetInstance().Get("network:receive:budget_ms", 4.0))
+        , m_NumberOfHandledMessages(0)
+        , m_NumberOfDeferredUpdates(0)
+        , m_HandlerDurationInMs(0.0)
+        , m_MaxHandlerDurationInMs(0.0)
+        , m_OperationTokenPtr(std::make_shared<char>(0))
     {
         Connect();
     }
 
     // -----------------------------------------------------------------------------
 
+    CSocket::CSocket(int _Port, SocketHandle _Handle, std::unique_ptr<asio::ip::tcp::socket> _pSocket)
+        : m_Port(_Port)
+        , m_Handle(_Handle)
+        , m_IsOpen(true)
+        , m_Strand(CNetworkManager::GetInstance().GetIOService())
+        , m_IsSending(false)
+        , m_IsConnectionLost(false)
+        , m_IsServer(true)
+        , m_IsSession(true)
+        , m_IsSendScheduled(false)
+        , m_NumberOfPendingBytes(0)
+        , m_NumberOfBytesInFlight(0)
+        , m_HighWatermark(Core::CProgramParameters::GetInstance().Get("network:send:high_watermark", s_DefaultHighWatermark))
+        , m_LowWatermark(Core::CProgramParameters::GetInstance().Get("network:send:low_watermark", s_DefaultLowWatermark))
+        , m_IsThrottled(false)
+        , m_MaxNumberOfQueuedMessages(0)
+        , m_QueuePolicy(SQueuePolicy::Refuse)
+        , m_NumberOfDroppedMessages(0)
+        , m_IsCompressionEnabled(Core::CProgramParameters::GetInstance().Get("network:compression:enabled", false))
+        , m_MinNumberOfBytesToCompress(Core::CProgramParameters::GetInstance().Get("network:compression:min_bytes", s_DefaultMinNumberOfBytesToCompress))
+        , m_DefaultCodec(SCodec::LZ)
+        , m_PeerCodecs(0)
+        , m_Encoder(Core::CProgramParameters::GetInstance().Get("network:compression:zlib_level", 1))
+        , m_Decoder()
+        , m_IsPendingPayloadEncoded(false)
+        , m_EncodedPayloadPoolPtr(std::make_shared<CPayloadPool>(s_MaxNumberOfPooledPayloads))
+        , m_pSendBytes(nullptr)
+        , m_NumberOfSendBytes(0)
+        , m_PayloadPoolPtr(std::make_shared<CPayloadPool>(s_MaxNumberOfPooledPayloads))
+        , m_ReceivedMessages(Core::CProgramParameters::GetInstance().Get("network:receive:queue_size", s_DefaultReceiveQueueSize))
+        , m_IsReceivePaused(false)
+        , m_HasOverflow(false)
+        , m_PeakNumberOfQueuedMessages(0)
+        , m_NumberOfStalls(0)
+        , m_ReceiveBudgetInMs(Core::CProgramParameters::GetInstance().Get("network:receive:budget_ms", 4.0))
+        , m_NumberOfHandledMessages(0)
+        , m_NumberOfDeferredUpdates(0)
+        , m_HandlerDurationInMs(0.0)
+        , m_MaxHandlerDurationInMs(0.0)
+        , m_OperationTokenPtr(std::make_shared<char>(0))
+    {
+        m_pSocket = std::move(_pSocket);
+
+        std::error_code Error;
+
+        m_IP = m_pSocket->remote_endpoint(Error).address().to_string();
+
+        m_Header.resize(s_HeaderSize);
+
+        m_Strand.post(Track(std::bind(&CSocket::StartListening, this)));
+        m_Strand.post(Track(std::bind(&CSocket::Handshake, this)));
+    }
+
+    // -----------------------------------------------------------------------------
+
     CSocket::~CSocket()
     {
         m_pSocket->close();
+
+        Base::CMemory::Free(m_pSendBytes, Base::CMemory::Network);
     }
 } // namespace Net
\ No newline at end of file
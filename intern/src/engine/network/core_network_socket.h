@@ -2,19 +2,21 @@
 #pragma once
 
 #include "base/base_delegate.h"
+#include "base/base_spsc_queue.h"
 
 #include "engine/engine_precompiled.h"
 
 #include "engine/engine_config.h"
 
+#include "engine/network/core_network_codec.h"
 #include "engine/network/core_network_common.h"
 #include "engine/network/core_network_manager.h"
 
 #include <atomic>
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
-#include <queue>
 
 namespace Net
 {
@@ -36,23 +38,65 @@ namespace Net
         int GetPort() const;
         const std::string& GetIP() const;
 
-        void Update();
+        // -----------------------------------------------------------------------------
+        // Runs the handlers of the received messages on the calling thread.
+        // Messages left when the time budget of the frame is used up are
+        // handled by the next update; a flush handles all of them.
+        // -----------------------------------------------------------------------------
+        void Update(bool _IsFlush = false);
 
         CMessageDelegate::HandleType RegisterMessageHandler(CMessageDelegate::FunctionType _Function);
-        bool SendMessage(const CMessage& _rMessage);
+        bool SendMessage(CMessage&& _rMessage);
+
+        void SetSendWatermarks(Base::Size _HighWatermark, Base::Size _LowWatermark);
+
+        // -----------------------------------------------------------------------------
+        // Limits the number of messages waiting to be sent (zero for no limit)
+        // -----------------------------------------------------------------------------
+        void SetQueueLimit(Base::Size _MaxNumberOfMessages, SQueuePolicy::Enum _Policy);
+
+        // -----------------------------------------------------------------------------
+        // Payloads of the category are compressed with the codec if the peer
+        // supports it. Tiny payloads are always sent as they are.
+        // -----------------------------------------------------------------------------
+        void SetCodec(int _Category, SCodec::Enum _Codec);
+
+        Base::Size GetNumberOfPendingBytes() const;
+        Base::Size GetNumberOfDroppedMessages() const;
+
+        SReceiveStatistics GetReceiveStatistics() const;
+
+        // -----------------------------------------------------------------------------
+        // True while a handler of the socket is queued or running. A closed
+        // session may only be destroyed once it has no pending operations.
+        // -----------------------------------------------------------------------------
+        bool HasPendingOperations() const;
 
     private:
 
         friend class CNetworkManager;
+        friend class CServerSocket;
+
+        template<typename THandler>
+        auto Track(THandler _Handler);
 
         void Connect();
 
         void OnConnect(const std::system_error& _rError);
-        void OnSendComplete(std::shared_ptr<std::vector<char>> _Data);
+        void Handshake();
+        void OnSendComplete(const std::error_code& _rError, size_t _TransferredBytes);
 
         int m_Port;
+
+        SocketHandle m_Handle;                  //< The port, or the handle of the session on a multi-client server
         
-        bool m_IsOpen;
+        std::atomic<bool> m_IsOpen;
+
+        // -----------------------------------------------------------------------------
+        // All handlers of the socket run through the strand, so they never run
+        // concurrently even if the network manager has several IO threads.
+        // -----------------------------------------------------------------------------
+        asio::io_service::strand m_Strand;
 
         std::unique_ptr<asio::ip::tcp::endpoint> m_pEndpoint;
         std::unique_ptr<asio::ip::tcp::acceptor> m_pAcceptor;
@@ -64,26 +108,118 @@ namespace Net
 
         std::vector<std::weak_ptr<CMessageDelegate>> m_Delegates;
 
-        std::mutex m_Mutex;
-
-        std::queue<CMessage> m_MessageQueue;
-
         std::string m_IP;
         const bool m_IsServer;
+        const bool m_IsSession;                 //< Accepted by a multi-client server, it does not reconnect
 
         CMessageDelegate m_MessageDelegate;
 
     private:
 
-        int s_HeaderSize = 12;
+        static const Base::Size s_HeaderSize = 12;
 
+        // -----------------------------------------------------------------------------
+        // Sending runs on the IO thread: a write takes a batch of queued
+        // messages and the next batch is started as soon as it completed.
+        // -----------------------------------------------------------------------------
+        static const Base::Size s_MaxNumberOfMessagesPerWrite = 256;
+        static const Base::Size s_MaxNumberOfBytesPerWrite    = 4 * 1024 * 1024;
+        static const Base::Size s_MaxNumberOfBytesToCoalesce  = 4 * 1024;         //< Smaller payloads are copied next to their header
+        static const Base::Size s_DefaultHighWatermark        = 64 * 1024 * 1024;
+        static const Base::Size s_DefaultLowWatermark         = 16 * 1024 * 1024;
+
+        static Base::Size GetNumberOfBytesOnWire(const CMessage& _rMessage);
+
+        void OnScheduledSend();
         void InternalSendMessage();
 
+        std::mutex m_SendMutex;
         std::deque<CMessage> m_OutgoingMessages;
+        std::vector<CMessage> m_MessagesInFlight;
+        std::vector<asio::const_buffer> m_SendBuffers;
         std::atomic<bool> m_IsSending;
+        std::atomic<bool> m_IsSendScheduled;
+
+        std::atomic<Base::Size> m_NumberOfPendingBytes;            //< Payload bytes queued or in flight
+        Base::Size m_NumberOfBytesInFlight;
+        Base::Size m_HighWatermark;
+        Base::Size m_LowWatermark;
+        bool m_IsThrottled;
+        Base::Size m_MaxNumberOfQueuedMessages;
+        SQueuePolicy::Enum m_QueuePolicy;
+        std::atomic<Base::Size> m_NumberOfDroppedMessages;
 
         std::atomic<bool> m_IsConnectionLost;
 
+        // -----------------------------------------------------------------------------
+        // Compression is negotiated: both sides send the codecs they support in
+        // a handshake and only compress with codecs of the peer. The codec
+        // contexts run on the IO thread and are reset on every connect.
+        // Encoded payloads are marked in the category of their header, so the
+        // sizes never decide and payloads the application compressed itself
+        // are passed on as they are.
+        // -----------------------------------------------------------------------------
+        static const int s_HandshakeCategory = -1;
+        static const int s_EncodedCategoryFlag = 1 << 30;          //< Only sent to peers that negotiated
+        static const Base::Size s_DefaultMinNumberOfBytesToCompress = 1024;
+
+        SCodec::Enum SelectCodec(const CMessage& _rMessage) const;
+
+        void EncodePayloads();
+
+        const bool m_IsCompressionEnabled;
+        const Base::Size m_MinNumberOfBytesToCompress;
+        SCodec::Enum m_DefaultCodec;
+        std::map<int, SCodec::Enum> m_Codecs;                       //< Codec per category, guarded by the send mutex
+        std::vector<SCodec::Enum> m_CodecsInFlight;
+        int m_PeerCodecs;                                           //< Bit mask of the codecs the peer decodes
+        CEncoder m_Encoder;
+        CDecoder m_Decoder;
+        bool m_IsPendingPayloadEncoded;
+        std::shared_ptr<CPayloadPool> m_EncodedPayloadPoolPtr;
+
+        char* m_pSendBytes;
+        Base::Size m_NumberOfSendBytes;
+
+        // -----------------------------------------------------------------------------
+        // Received payloads keep their buffer until the last handler released
+        // it, then the buffer is used for the next message.
+        // -----------------------------------------------------------------------------
+        static const Base::Size s_MaxNumberOfPooledPayloads = 8;
+
+        std::shared_ptr<CPayloadPool> m_PayloadPoolPtr;
+        CPayloadPool::CBufferPtr m_PendingBytesPtr;
+
+        // -----------------------------------------------------------------------------
+        // Received messages and notifications are handed from the IO thread to
+        // the main thread without a lock. If the main thread falls behind and
+        // the queue is full, messages wait in the overflow of the IO thread and
+        // reading from the socket is paused until the queue drained.
+        // -----------------------------------------------------------------------------
+        static const Base::Size s_DefaultReceiveQueueSize = 1024;
+
+        void EnqueueMessage(CMessage&& _rMessage);
+        void DrainOverflow();
+
+        Base::CSPSCQueue<CMessage> m_ReceivedMessages;
+        std::deque<CMessage> m_OverflowMessages;                   //< Touched on the IO thread only
+        bool m_IsReceivePaused;                                     //< Touched on the IO thread only
+        std::atomic<bool> m_HasOverflow;
+        std::atomic<Base::Size> m_PeakNumberOfQueuedMessages;
+        std::atomic<Base::Size> m_NumberOfStalls;
+
+        const double m_ReceiveBudgetInMs;                           //< Zero for no limit
+        Base::Size m_NumberOfHandledMessages;
+        Base::Size m_NumberOfDeferredUpdates;
+        double m_HandlerDurationInMs;
+        double m_MaxHandlerDurationInMs;
+
+        // -----------------------------------------------------------------------------
+        // Every handler handed to asio holds a copy, so the use count tells
+        // whether operations are pending.
+        // -----------------------------------------------------------------------------
+        std::shared_ptr<char> m_OperationTokenPtr;
+
         // shared_ptr cannot access the destructor so we use a custom deleter
         friend void SocketDeleter(Net::CSocket* _pSocket)
         {
@@ -92,6 +228,21 @@ namespace Net
 
         CSocket(int _Port);
         CSocket(const std::string& _IP, int _Port);
+        CSocket(int _Port, SocketHandle _Handle, std::unique_ptr<asio::ip::tcp::socket> _pSocket);
         ~CSocket();
     };
+} // namespace Net
+
+namespace Net
+{
+    template<typename THandler>
+    auto CSocket::Track(THandler _Handler)
+    {
+        std::shared_ptr<char> OperationTokenPtr = m_OperationTokenPtr;
+
+        return [OperationTokenPtr, _Handler](auto&&... _rArguments) mutable
+        {
+            _Handler(std::forward<decltype(_rArguments)>(_rArguments)...);
+        };
+    }
 } // namespace Net
\ No newline at end of file
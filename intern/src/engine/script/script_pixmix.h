@@ -79,30 +79,32 @@ namespace Scpt
             {
                 if (_rMessage.m_Category == 0)
                 {
-                    std::vector<char> Decompressed(_rMessage.m_DecompressedSize);
+                    std::vector<char> Decompressed;
+
+                    const char* pData = _rMessage.m_Payload.GetData();
 
                     if (_rMessage.m_CompressedSize != _rMessage.m_DecompressedSize)
                     {
+                        Decompressed.resize(_rMessage.m_DecompressedSize);
+
                         try
                         {
-                            Base::Decompress(_rMessage.m_Payload, Decompressed);
+                            Base::Decompress(pData, static_cast<int>(_rMessage.m_Payload.GetNumberOfBytes()), Decompressed);
                         }
                         catch (...)
                         {
                             ENGINE_CONSOLE_ERROR("Failed to decompress! Ignoring network message!");
                             return;
                         }
-                    }
-                    else
-                    {
-                        std::memcpy(Decompressed.data(), _rMessage.m_Payload.data(), Decompressed.size());
+
+                        pData = Decompressed.data();
                     }
 
-                    glm::ivec2 Size = *reinterpret_cast<glm::ivec2*>(Decompressed.data());
+                    glm::ivec2 Size = *reinterpret_cast<const glm::ivec2*>(pData);
 
                     std::vector<glm::u8vec4> RawData(Size.x * Size.y);
 
-                    std::memcpy(RawData.data(), Decompressed.data() + sizeof(glm::ivec2), sizeof(RawData[0]) * RawData.size());
+                    std::memcpy(RawData.data(), pData + sizeof(glm::ivec2), sizeof(RawData[0]) * RawData.size());
 
                     if (m_AlphaThreshold > 0)
                     {
@@ -133,15 +135,15 @@ namespace Scpt
                     Message.m_CompressedSize = static_cast<int>(Payload.size());
                     Message.m_DecompressedSize = static_cast<int>(Payload.size());
                     Message.m_MessageType = 0;
-                    Message.m_Payload = Payload;
+                    Message.m_Payload = std::move(Payload);
 
-                    Net::CNetworkManager::GetInstance().SendMessage(m_Socket, Message);
+                    Net::CNetworkManager::GetInstance().SendMessage(m_Socket, std::move(Message));
                 }
                 else if (_rMessage.m_Category == 1)
                 {
                     int Alpha;
 
-                    std::memcpy(&Alpha, _rMessage.m_Payload.data(), sizeof(Alpha));
+                    std::memcpy(&Alpha, _rMessage.m_Payload.GetData(), sizeof(Alpha));
 
                     m_AlphaThreshold = Alpha;
                 }
@@ -357,7 +357,7 @@ namespace LE
 		Message.m_MessageType = 0;
         Message.m_Payload = std::move(Payload);
 
-		Net::CNetworkManager::GetInstance().SendMessage(m_SocketHandle, Message);
+		Net::CNetworkManager::GetInstance().SendMessage(m_SocketHandle, std::move(Message));
 	}
 
 	// -----------------------------------------------------------------------------
@@ -376,13 +376,13 @@ namespace LE
         const char* pTexturePayload = nullptr;
         int Offset = 0;
 
-        std::memcpy(&ImageWidth, &_rMessage.m_Payload[0] + Offset, sizeof(int));
+        std::memcpy(&ImageWidth, _rMessage.m_Payload.GetData() + Offset, sizeof(int));
         Offset += sizeof(int);
 
-        std::memcpy(&ImageHeight, &_rMessage.m_Payload[0] + Offset, sizeof(int));
+        std::memcpy(&ImageHeight, _rMessage.m_Payload.GetData() + Offset, sizeof(int));
         Offset += sizeof(int);
 
-        pTexturePayload = &_rMessage.m_Payload[0] + Offset;
+        pTexturePayload = _rMessage.m_Payload.GetData() + Offset;
 
         if (ImageWidth != s_PanoramaWidth || ImageHeight != s_PanoramaHeight)
         {
@@ -0,0 +1,518 @@
+
+#include "plugin/slam/slam_precompiled.h"
+
+#include "base/base_simd.h"
+#include "base/base_thread_pool.h"
+
+#include "plugin/slam/mr_icp_tracker_cpu.h"
+
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+    const int g_TileSize2D = 16;
+
+    const float g_EpsilonDistance = 0.1f;
+    const float g_EpsilonAngle = 0.75f;
+
+    const float g_DefaultHuberThreshold = 0.01f;
+    const float g_DefaultConvergenceThreshold = 1e-5f;
+
+    int DivUp(int TotalCount, int GroupSize)
+    {
+        return (TotalCount + GroupSize - 1) / GroupSize;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Invalid map entries are stored as zero vectors. Testing all components keeps
+    // axis-aligned normals, which the shader's x-only test would reject.
+    // -----------------------------------------------------------------------------
+    bool IsValid(const glm::vec4& _rValue)
+    {
+        return _rValue.x != 0.0f || _rValue.y != 0.0f || _rValue.z != 0.0f;
+    }
+} // namespace
+
+namespace MR
+{
+    glm::mat4 CICPTrackerCPU::Track(const glm::mat4& _rPoseMatrix, const CPyramid& _rReferencePyramid, const CPyramid& _rRaycastPyramid)
+    {
+        assert(static_cast<int>(_rReferencePyramid.size()) >= m_PyramidLevelCount);
+        assert(static_cast<int>(_rRaycastPyramid.size()) >= m_PyramidLevelCount);
+
+        const glm::mat4 InvPoseMatrix = glm::inverse(_rPoseMatrix);
+
+        glm::mat4 IncPoseMatrix = _rPoseMatrix;
+
+        m_NumberOfIterations = 0;
+        m_NumberOfCorrespondences = 0;
+
+        for (int PyramidLevel = m_PyramidLevelCount - 1; PyramidLevel >= 0; --PyramidLevel)
+        {
+            for (int Iteration = 0; Iteration < m_Iterations[PyramidLevel]; ++Iteration)
+            {
+                double ICPValues[s_ICPValueCount];
+
+                DetermineSummands(PyramidLevel, IncPoseMatrix, InvPoseMatrix, _rReferencePyramid[PyramidLevel], _rRaycastPyramid[PyramidLevel]);
+
+                ReduceSum(ICPValues);
+
+                ++m_NumberOfIterations;
+
+                float Increment;
+
+                m_IsTrackingLost = !CalculatePoseMatrix(ICPValues, IncPoseMatrix, Increment);
+
+                if (m_IsTrackingLost)
+                {
+                    return glm::mat4(1.0f);
+                }
+
+                // -----------------------------------------------------------------------------
+                // Further iterations on this level would not change the pose anymore
+                // -----------------------------------------------------------------------------
+                if (Increment < m_ConvergenceThreshold)
+                {
+                    break;
+                }
+            }
+        }
+
+        return IncPoseMatrix;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CICPTrackerCPU::CreateReferencePyramid(const unsigned short* _pDepthBuffer, CPyramid& _rPyramid) const
+    {
+        assert(_pDepthBuffer != nullptr);
+
+        _rPyramid.resize(m_PyramidLevelCount);
+
+        std::vector<unsigned short> DepthBuffer(_pDepthBuffer, _pDepthBuffer + m_Width * m_Height);
+        std::vector<unsigned short> DownsampledDepthBuffer;
+
+        for (int PyramidLevel = 0; PyramidLevel < m_PyramidLevelCount; ++PyramidLevel)
+        {
+            const int Width = m_Width >> PyramidLevel;
+            const int Height = m_Height >> PyramidLevel;
+
+            const glm::vec2 FocalPoint = m_FocalPoint / static_cast<float>(1 << PyramidLevel);
+            const glm::vec2 InvFocalLength = static_cast<float>(1 << PyramidLevel) / m_FocalLength;
+
+            SPyramidLevel& rLevel = _rPyramid[PyramidLevel];
+
+            rLevel.m_Width = Width;
+            rLevel.m_Height = Height;
+            rLevel.m_VertexMap.resize(Width * Height);
+            rLevel.m_NormalMap.resize(Width * Height);
+
+            // -----------------------------------------------------------------------------
+            // Vertex map (see cs_vertex_map.glsl)
+            // -----------------------------------------------------------------------------
+            Base::CThreadPool::GetInstance().ParallelFor(Height, g_TileSize2D, [&](int _Begin, int _End)
+            {
+                for (int y = _Begin; y < _End; ++y)
+                {
+                    for (int x = 0; x < Width; ++x)
+                    {
+                        const float Depth = DepthBuffer[y * Width + x] / 1000.0f;
+
+                        glm::vec4 Vertex(0.0f);
+
+                        if (Depth > 0.0f)
+                        {
+                            Vertex.x = Depth * (x - FocalPoint.x) * InvFocalLength.x;
+                            Vertex.y = Depth * (y - FocalPoint.y) * InvFocalLength.y;
+                            Vertex.z = Depth;
+                            Vertex.w = 1.0f;
+                        }
+
+                        rLevel.m_VertexMap[y * Width + x] = Vertex;
+                    }
+                }
+            });
+
+            // -----------------------------------------------------------------------------
+            // Normal map (see cs_normal_map.glsl)
+            // -----------------------------------------------------------------------------
+            Base::CThreadPool::GetInstance().ParallelFor(Height, g_TileSize2D, [&](int _Begin, int _End)
+            {
+                for (int y = _Begin; y < _End; ++y)
+                {
+                    for (int x = 0; x < Width; ++x)
+                    {
+                        glm::vec4 Normal(0.0f);
+
+                        if (x + 1 < Width && y + 1 < Height)
+                        {
+                            const glm::vec4& rVertex0 = rLevel.m_VertexMap[y * Width + x];
+                            const glm::vec4& rVertex1 = rLevel.m_VertexMap[y * Width + x + 1];
+                            const glm::vec4& rVertex2 = rLevel.m_VertexMap[(y + 1) * Width + x];
+
+                            if (IsValid(rVertex0) && IsValid(rVertex1) && IsValid(rVertex2))
+                            {
+                                const glm::vec3 Cross = glm::cross(glm::vec3(rVertex1 - rVertex0), glm::vec3(rVertex2 - rVertex0));
+
+                                Normal = glm::vec4(glm::normalize(Cross), 0.0f);
+                            }
+                        }
+
+                        rLevel.m_NormalMap[y * Width + x] = Normal;
+                    }
+                }
+            });
+
+            // -----------------------------------------------------------------------------
+            // Depth of the next level (see cs_downsample_depth.glsl)
+            // -----------------------------------------------------------------------------
+            if (PyramidLevel + 1 < m_PyramidLevelCount)
+            {
+                const int NextWidth = Width / 2;
+                const int NextHeight = Height / 2;
+
+                DownsampledDepthBuffer.resize(NextWidth * NextHeight);
+
+                Base::CThreadPool::GetInstance().ParallelFor(NextHeight, g_TileSize2D, [&](int _Begin, int _End)
+                {
+                    for (int y = _Begin; y < _End; ++y)
+                    {
+                        for (int x = 0; x < NextWidth; ++x)
+                        {
+                            const int SampleX = x * 2;
+                            const int SampleY = y * 2;
+
+                            const float Center = DepthBuffer[SampleY * Width + SampleX];
+
+                            float Sum = 0.0f;
+                            int Count = 0;
+
+                            for (int j = glm::max(SampleY - 1, 0); j <= glm::min(SampleY + 1, Height - 1); ++j)
+                            {
+                                for (int i = glm::max(SampleX - 1, 0); i <= glm::min(SampleX + 1, Width - 1); ++i)
+                                {
+                                    const float Sample = DepthBuffer[j * Width + i];
+
+                                    if (std::abs(Sample - Center) < m_TruncatedDistance)
+                                    {
+                                        Sum += Sample;
+                                        ++Count;
+                                    }
+                                }
+                            }
+
+                            DownsampledDepthBuffer[y * NextWidth + x] = static_cast<unsigned short>(Sum / Count);
+                        }
+                    }
+                });
+
+                DepthBuffer.swap(DownsampledDepthBuffer);
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CICPTrackerCPU::SetIntrinsics(const glm::vec2& _rFocalLength, const glm::vec2& _rFocalPoint)
+    {
+        m_FocalLength = _rFocalLength;
+        m_FocalPoint = _rFocalPoint;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CICPTrackerCPU::SetHuberThreshold(float _Threshold)
+    {
+        m_HuberThreshold = _Threshold;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CICPTrackerCPU::SetConvergenceThreshold(float _Threshold)
+    {
+        m_ConvergenceThreshold = _Threshold;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CICPTrackerCPU::DetermineSummands(int _PyramidLevel, const glm::mat4& _rIncPoseMatrix, const glm::mat4& _rInvPoseMatrix, const SPyramidLevel& _rReference, const SPyramidLevel& _rRaycast)
+    {
+        const int Width = _rReference.m_Width;
+        const int Height = _rReference.m_Height;
+
+        assert(_rRaycast.m_Width == Width && _rRaycast.m_Height == Height);
+
+        const glm::vec2 FocalLength = m_FocalLength / static_cast<float>(1 << _PyramidLevel);
+        const glm::vec2 FocalPoint = m_FocalPoint / static_cast<float>(1 << _PyramidLevel);
+
+        const glm::mat3 IncRotation(_rIncPoseMatrix);
+        const glm::vec3 IncTranslation(_rIncPoseMatrix[3]);
+        const glm::mat3 InvRotation(_rInvPoseMatrix);
+        const glm::vec3 InvTranslation(_rInvPoseMatrix[3]);
+
+        const float HuberThreshold = m_HuberThreshold;
+
+        const int NumberOfTiles = DivUp(Height, g_TileSize2D);
+
+        m_TileReductions.resize(NumberOfTiles);
+
+        Base::CThreadPool::GetInstance().ParallelFor(NumberOfTiles, 1, [&](int _Begin, int _End)
+        {
+            using namespace Base::SIMD;
+
+            for (int Tile = _Begin; Tile < _End; ++Tile)
+            {
+                // -----------------------------------------------------------------------------
+                // Each accumulator row holds the products of one Jacobian entry with the
+                // whole (padded) row [J | r | 0], i.e. a 6x8 block of the normal equations.
+                // -----------------------------------------------------------------------------
+                Float4 Accumulator[6][2];
+
+                for (int Row = 0; Row < 6; ++Row)
+                {
+                    Accumulator[Row][0] = Zero();
+                    Accumulator[Row][1] = Zero();
+                }
+
+                int Correspondences = 0;
+
+                const int BeginY = Tile * g_TileSize2D;
+                const int EndY = glm::min(BeginY + g_TileSize2D, Height);
+
+                for (int y = BeginY; y < EndY; ++y)
+                {
+                    for (int x = 0; x < Width; ++x)
+                    {
+                        const glm::vec4& rVertex = _rReference.m_VertexMap[y * Width + x];
+
+                        if (!IsValid(rVertex)) continue;
+
+                        const glm::vec3 ReferenceVertex = IncRotation * glm::vec3(rVertex) + IncTranslation;
+                        const glm::vec3 CameraVertex = InvRotation * ReferenceVertex + InvTranslation;
+
+                        if (CameraVertex.z <= 0.0f) continue;
+
+                        const float CameraPlaneX = FocalLength.x * CameraVertex.x / CameraVertex.z + FocalPoint.x;
+                        const float CameraPlaneY = FocalLength.y * CameraVertex.y / CameraVertex.z + FocalPoint.y;
+
+                        if (CameraPlaneX < 0.0f || CameraPlaneX >= Width || CameraPlaneY < 0.0f || CameraPlaneY >= Height) continue;
+
+                        const glm::vec4& rNormal = _rReference.m_NormalMap[y * Width + x];
+
+                        if (!IsValid(rNormal)) continue;
+
+                        const glm::vec3 ReferenceNormal = IncRotation * glm::vec3(rNormal);
+
+                        const int RaycastIndex = static_cast<int>(CameraPlaneY) * Width + static_cast<int>(CameraPlaneX);
+
+                        const glm::vec4& rRaycastVertex = _rRaycast.m_VertexMap[RaycastIndex];
+                        const glm::vec4& rRaycastNormal = _rRaycast.m_NormalMap[RaycastIndex];
+
+                        if (!IsValid(rRaycastVertex) || !IsValid(rRaycastNormal)) continue;
+
+                        const glm::vec3 RaycastVertex(rRaycastVertex);
+                        const glm::vec3 RaycastNormal(rRaycastNormal);
+
+                        const float Distance = glm::distance(ReferenceVertex, RaycastVertex);
+                        const float Angle = glm::dot(ReferenceNormal, RaycastNormal);
+
+                        if (std::abs(Distance) > g_EpsilonDistance || std::abs(Angle) < g_EpsilonAngle) continue;
+
+                        const glm::vec3 Cross = glm::cross(ReferenceVertex, RaycastNormal);
+                        const float Residual = glm::dot(RaycastNormal, RaycastVertex - ReferenceVertex);
+
+                        if (std::isnan(Cross.x) || std::isnan(Cross.y) || std::isnan(Cross.z) || std::isnan(Residual)) continue;
+
+                        // -----------------------------------------------------------------------------
+                        // Huber weighting: quadratic near zero, linear for outliers
+                        // -----------------------------------------------------------------------------
+                        const float AbsResidual = std::abs(Residual);
+                        const float Weight = AbsResidual <= HuberThreshold ? 1.0f : HuberThreshold / AbsResidual;
+
+                        const float Row[6] = { Cross.x, Cross.y, Cross.z, RaycastNormal.x, RaycastNormal.y, RaycastNormal.z };
+
+                        const Float4 RowLow = Set(Row[0], Row[1], Row[2], Row[3]);
+                        const Float4 RowHigh = Set(Row[4], Row[5], Residual, 0.0f);
+
+                        for (int Index = 0; Index < 6; ++Index)
+                        {
+                            const Float4 WeightedEntry = Set(Weight * Row[Index]);
+
+                            Accumulator[Index][0] = MulAdd(WeightedEntry, RowLow, Accumulator[Index][0]);
+                            Accumulator[Index][1] = MulAdd(WeightedEntry, RowHigh, Accumulator[Index][1]);
+                        }
+
+                        ++Correspondences;
+                    }
+                }
+
+                // -----------------------------------------------------------------------------
+                // Keep the upper triangle in the same order as cs_determine_summands.glsl
+                // -----------------------------------------------------------------------------
+                SReduction& rReduction = m_TileReductions[Tile];
+
+                int ValueIndex = 0;
+
+                for (int Index = 0; Index < 6; ++Index)
+                {
+                    float Values[8];
+
+                    Store(Values, Accumulator[Index][0]);
+                    Store(Values + 4, Accumulator[Index][1]);
+
+                    for (int Column = Index; Column < 7; ++Column)
+                    {
+                        rReduction.m_ICPValues[ValueIndex++] = Values[Column];
+                    }
+                }
+
+                rReduction.m_Correspondences = Correspondences;
+            }
+        });
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CICPTrackerCPU::ReduceSum(double* _pICPValues)
+    {
+        for (int Index = 0; Index < s_ICPValueCount; ++Index)
+        {
+            _pICPValues[Index] = 0.0;
+        }
+
+        int Correspondences = 0;
+
+        for (const SReduction& rReduction : m_TileReductions)
+        {
+            for (int Index = 0; Index < s_ICPValueCount; ++Index)
+            {
+                _pICPValues[Index] += rReduction.m_ICPValues[Index];
+            }
+
+            Correspondences += rReduction.m_Correspondences;
+        }
+
+        m_NumberOfCorrespondences = Correspondences;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CICPTrackerCPU::CalculatePoseMatrix(const double* _pICPValues, glm::mat4& _rIncPoseMatrix, float& _rIncrement)
+    {
+        double A[36];
+        double b[6];
+
+        int ValueIndex = 0;
+        for (int i = 0; i < 6; ++i)
+        {
+            for (int j = i; j < 7; ++j)
+            {
+                const double Value = _pICPValues[ValueIndex++];
+
+                if (j == 6)
+                {
+                    b[i] = Value;
+                }
+                else
+                {
+                    A[j * 6 + i] = A[i * 6 + j] = Value;
+                }
+            }
+        }
+
+        // -----------------------------------------------------------------------------
+        // Cholesky decomposition A = L * L^T (column major like CICPTracker)
+        // -----------------------------------------------------------------------------
+        double L[36] = {};
+
+        for (int i = 0; i < 6; ++i)
+        {
+            for (int j = 0; j <= i; ++j)
+            {
+                double Sum = 0.0;
+                for (int k = 0; k < j; ++k)
+                {
+                    Sum += L[k * 6 + i] * L[k * 6 + j];
+                }
+                L[j * 6 + i] = i == j ? std::sqrt(A[i * 6 + i] - Sum) : ((1.0 / L[j * 6 + j]) * (A[j * 6 + i] - Sum));
+            }
+        }
+
+        double Det = 1.0;
+
+        for (int i = 0; i < 6; ++i)
+        {
+            Det *= L[i * 6 + i] * L[i * 6 + i];
+        }
+
+        if (std::isnan(Det) || std::abs(Det) < 1e-5)
+        {
+            return false;
+        }
+
+        double y[6];
+
+        for (int i = 0; i < 6; ++i)
+        {
+            double Sum = b[i];
+            for (int k = 0; k < i; ++k)
+            {
+                Sum -= L[k * 6 + i] * y[k];
+            }
+            y[i] = Sum / L[i * 6 + i];
+        }
+
+        double x[6];
+
+        for (int i = 5; i >= 0; --i)
+        {
+            double Sum = y[i];
+            for (int k = i + 1; k < 6; ++k)
+            {
+                Sum -= L[i * 6 + k] * x[k];
+            }
+            x[i] = Sum / L[i * 6 + i];
+        }
+
+        glm::mat4 Rotation = glm::eulerAngleXYZ(static_cast<float>(x[0]), static_cast<float>(x[1]), static_cast<float>(x[2]));
+        glm::mat4 Translation = glm::translate(glm::vec3(static_cast<float>(x[3]), static_cast<float>(x[4]), static_cast<float>(x[5])));
+
+        _rIncPoseMatrix = Translation * Rotation * _rIncPoseMatrix;
+
+        _rIncrement = 0.0f;
+
+        for (int i = 0; i < 6; ++i)
+        {
+            _rIncrement = glm::max(_rIncrement, static_cast<float>(std::abs(x[i])));
+        }
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CICPTrackerCPU::CICPTrackerCPU(int _Width, int _Height, const MR::SReconstructionSettings& _Settings)
+        : m_Width                  (_Width)
+        , m_Height                 (_Height)
+        , m_PyramidLevelCount      (_Settings.m_PyramidLevelCount)
+        , m_TruncatedDistance      (_Settings.m_TruncatedDistance)
+        , m_HuberThreshold         (g_DefaultHuberThreshold)
+        , m_ConvergenceThreshold   (g_DefaultConvergenceThreshold)
+        , m_IsTrackingLost         (true)
+        , m_NumberOfIterations     (0)
+        , m_NumberOfCorrespondences(0)
+        , m_FocalLength            (1.0f)
+        , m_FocalPoint             (0.0f)
+        , m_Iterations             (_Settings.m_PyramidLevelIterations)
+    {
+        assert(m_PyramidLevelCount > 0 && m_PyramidLevelCount <= 3);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CICPTrackerCPU::~CICPTrackerCPU()
+    {
+
+    }
+} // namespace MR
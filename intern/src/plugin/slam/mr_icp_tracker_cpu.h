@@ -0,0 +1,100 @@
+#pragma once
+
+#include "base/base_include_glm.h"
+
+#include "plugin/slam/mr_slam_reconstruction_settings.h"
+
+#include <vector>
+
+namespace MR
+{
+    // -----------------------------------------------------------------------------
+    // Point-to-plane ICP on CPU-side vertex/normal pyramids. It mirrors the
+    // compute path of CICPTracker (same correspondence test and linearization)
+    // but reduces the normal equations on the CPU, so it runs without a GPU and
+    // serves as a reference for the shader implementation.
+    // -----------------------------------------------------------------------------
+    class CICPTrackerCPU
+    {
+    public:
+
+        struct SPyramidLevel
+        {
+            int m_Width;
+            int m_Height;
+            std::vector<glm::vec4> m_VertexMap;
+            std::vector<glm::vec4> m_NormalMap;
+        };
+
+        using CPyramid = std::vector<SPyramidLevel>;
+
+    public:
+
+        glm::mat4 Track(const glm::mat4& _rPoseMatrix, const CPyramid& _rReferencePyramid, const CPyramid& _rRaycastPyramid);
+
+        void CreateReferencePyramid(const unsigned short* _pDepthBuffer, CPyramid& _rPyramid) const;
+
+        void SetIntrinsics(const glm::vec2& _rFocalLength, const glm::vec2& _rFocalPoint);
+
+        void SetHuberThreshold(float _Threshold);
+        void SetConvergenceThreshold(float _Threshold);
+
+        bool IsTrackingLost() const
+        {
+            return m_IsTrackingLost;
+        }
+
+        int GetNumberOfIterations() const
+        {
+            return m_NumberOfIterations;
+        }
+
+        int GetNumberOfCorrespondences() const
+        {
+            return m_NumberOfCorrespondences;
+        }
+
+    public:
+
+        CICPTrackerCPU(int _Width, int _Height, const MR::SReconstructionSettings& _Settings);
+       ~CICPTrackerCPU();
+
+    private:
+
+        static const int s_ICPValueCount = 27;
+
+        struct SReduction
+        {
+            float m_ICPValues[s_ICPValueCount];
+            int m_Correspondences;
+        };
+
+    private:
+
+        void DetermineSummands(int _PyramidLevel, const glm::mat4& _rIncPoseMatrix, const glm::mat4& _rInvPoseMatrix, const SPyramidLevel& _rReference, const SPyramidLevel& _rRaycast);
+        void ReduceSum(double* _pICPValues);
+        bool CalculatePoseMatrix(const double* _pICPValues, glm::mat4& _rIncPoseMatrix, float& _rIncrement);
+
+    private:
+
+        int m_Width;
+        int m_Height;
+        int m_PyramidLevelCount;
+
+        float m_TruncatedDistance;
+        float m_HuberThreshold;
+        float m_ConvergenceThreshold;
+
+        bool m_IsTrackingLost;
+
+        int m_NumberOfIterations;
+        int m_NumberOfCorrespondences;
+
+        glm::vec2 m_FocalLength;
+        glm::vec2 m_FocalPoint;
+
+        glm::ivec3 m_Iterations;
+
+        std::vector<SReduction> m_TileReductions;
+    };
+} // namespace MR
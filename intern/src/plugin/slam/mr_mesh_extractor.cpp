@@ -0,0 +1,890 @@
+
+#include "plugin/slam/slam_precompiled.h"
+
+#include "base/base_thread_pool.h"
+
+#include "plugin/slam/mr_mesh_extractor.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const int g_BrickResolution = MR::CMeshExtractor::s_BrickResolution;
+
+    // -----------------------------------------------------------------------------
+    // Samples of a brick plus a one voxel border on each side: cells need the
+    // following voxel, normals the previous and the following one.
+    // -----------------------------------------------------------------------------
+    const int g_SampleResolution = g_BrickResolution + 3;
+    const int g_SampleCount = g_SampleResolution * g_SampleResolution * g_SampleResolution;
+
+    // -----------------------------------------------------------------------------
+    // Edges are owned by the voxel at their lower end, which can be the first
+    // voxel of the following brick.
+    // -----------------------------------------------------------------------------
+    const int g_EdgeOriginResolution = g_BrickResolution + 1;
+    const int g_EdgeCacheSize = 3 * g_EdgeOriginResolution * g_EdgeOriginResolution * g_EdgeOriginResolution;
+
+    const int g_BricksPerTask = 4;
+
+    const float g_DefaultMinWeight = 1.0f;
+
+    // -----------------------------------------------------------------------------
+    // Corner and edge numbering of the classic marching cubes tables. A corner is
+    // inside (bit set in the cube index) if its TSDF is negative. Triangles are
+    // wound counter-clockwise when seen from the positive (free space) side.
+    // -----------------------------------------------------------------------------
+    const glm::ivec3 g_CornerOffsets[8] =
+    {
+        glm::ivec3(0, 0, 0), glm::ivec3(1, 0, 0), glm::ivec3(1, 1, 0), glm::ivec3(0, 1, 0),
+        glm::ivec3(0, 0, 1), glm::ivec3(1, 0, 1), glm::ivec3(1, 1, 1), glm::ivec3(0, 1, 1),
+    };
+
+    const int g_EdgeCorners[12][2] =
+    {
+        { 0, 1 }, { 1, 2 }, { 3, 2 }, { 0, 3 },
+        { 4, 5 }, { 5, 6 }, { 7, 6 }, { 4, 7 },
+        { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 },
+    };
+
+    const int g_EdgeAxis[12] =
+    {
+        0, 1, 0, 1,
+        0, 1, 0, 1,
+        2, 2, 2, 2,
+    };
+
+    const int g_EdgeTable[256] =
+    {
+        0x000, 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c, 0x80c, 0x905, 0xa0f, 0xb06, 0xc0a, 0xd03, 0xe09, 0xf00,
+        0x190, 0x099, 0x393, 0x29a, 0x596, 0x49f, 0x795, 0x69c, 0x99c, 0x895, 0xb9f, 0xa96, 0xd9a, 0xc93, 0xf99, 0xe90,
+        0x230, 0x339, 0x033, 0x13a, 0x636, 0x73f, 0x435, 0x53c, 0xa3c, 0xb35, 0x83f, 0x936, 0xe3a, 0xf33, 0xc39, 0xd30,
+        0x3a0, 0x2a9, 0x1a3, 0x0aa, 0x7a6, 0x6af, 0x5a5, 0x4ac, 0xbac, 0xaa5, 0x9af, 0x8a6, 0xfaa, 0xea3, 0xda9, 0xca0,
+        0x460, 0x569, 0x663, 0x76a, 0x066, 0x16f, 0x265, 0x36c, 0xc6c, 0xd65, 0xe6f, 0xf66, 0x86a, 0x963, 0xa69, 0xb60,
+        0x5f0, 0x4f9, 0x7f3, 0x6fa, 0x1f6, 0x0ff, 0x3f5, 0x2fc, 0xdfc, 0xcf5, 0xfff, 0xef6, 0x9fa, 0x8f3, 0xbf9, 0xaf0,
+        0x650, 0x759, 0x453, 0x55a, 0x256, 0x35f, 0x055, 0x15c, 0xe5c, 0xf55, 0xc5f, 0xd56, 0xa5a, 0xb53, 0x859, 0x950,
+        0x7c0, 0x6c9, 0x5c3, 0x4ca, 0x3c6, 0x2cf, 0x1c5, 0x0cc, 0xfcc, 0xec5, 0xdcf, 0xcc6, 0xbca, 0xac3, 0x9c9, 0x8c0,
+        0x8c0, 0x9c9, 0xac3, 0xbca, 0xcc6, 0xdcf, 0xec5, 0xfcc, 0x0cc, 0x1c5, 0x2cf, 0x3c6, 0x4ca, 0x5c3, 0x6c9, 0x7c0,
+        0x950, 0x859, 0xb53, 0xa5a, 0xd56, 0xc5f, 0xf55, 0xe5c, 0x15c, 0x055, 0x35f, 0x256, 0x55a, 0x453, 0x759, 0x650,
+        0xaf0, 0xbf9, 0x8f3, 0x9fa, 0xef6, 0xfff, 0xcf5, 0xdfc, 0x2fc, 0x3f5, 0x0ff, 0x1f6, 0x6fa, 0x7f3, 0x4f9, 0x5f0,
+        0xb60, 0xa69, 0x963, 0x86a, 0xf66, 0xe6f, 0xd65, 0xc6c, 0x36c, 0x265, 0x16f, 0x066, 0x76a, 0x663, 0x569, 0x460,
+        0xca0, 0xda9, 0xea3, 0xfaa, 0x8a6, 0x9af, 0xaa5, 0xbac, 0x4ac, 0x5a5, 0x6af, 0x7a6, 0x0aa, 0x1a3, 0x2a9, 0x3a0,
+        0xd30, 0xc39, 0xf33, 0xe3a, 0x936, 0x83f, 0xb35, 0xa3c, 0x53c, 0x435, 0x73f, 0x636, 0x13a, 0x033, 0x339, 0x230,
+        0xe90, 0xf99, 0xc93, 0xd9a, 0xa96, 0xb9f, 0x895, 0x99c, 0x69c, 0x795, 0x49f, 0x596, 0x29a, 0x393, 0x099, 0x190,
+        0xf00, 0xe09, 0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c, 0x70c, 0x605, 0x50f, 0x406, 0x30a, 0x203, 0x109, 0x000,
+    };
+
+    const int g_TriangleTable[256][16] =
+    {
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9,  1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  3,  8,  1,  8,  9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  1, 10,  2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  8,  1, 10,  2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9, 10,  0, 10,  2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  2,  3,  8,  2,  8,  9,  2,  9, 10, -1, -1, -1, -1, -1, -1, -1 },
+        {  2, 11,  3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  2, 11,  0, 11,  8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9,  1,  2, 11,  3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  2, 11,  1, 11,  8,  1,  8,  9, -1, -1, -1, -1, -1, -1, -1 },
+        {  1, 10, 11,  1, 11,  3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  1, 10,  0, 10, 11,  0, 11,  8, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9, 10,  0, 10, 11,  0, 11,  3, -1, -1, -1, -1, -1, -1, -1 },
+        {  8,  9, 10,  8, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  4,  8,  7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  7,  0,  7,  4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9,  1,  4,  8,  7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  3,  7,  1,  7,  4,  1,  4,  9, -1, -1, -1, -1, -1, -1, -1 },
+        {  1, 10,  2,  4,  8,  7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  7,  0,  7,  4,  1, 10,  2, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9, 10,  0, 10,  2,  4,  8,  7, -1, -1, -1, -1, -1, -1, -1 },
+        {  2,  3,  7,  2,  7,  4,  2,  4,  9,  2,  9, 10, -1, -1, -1, -1 },
+        {  2, 11,  3,  4,  8,  7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  2, 11,  0, 11,  7,  0,  7,  4, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9,  1,  2, 11,  3,  4,  8,  7, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  2, 11,  1, 11,  7,  1,  7,  4,  1,  4,  9, -1, -1, -1, -1 },
+        {  1, 10, 11,  1, 11,  3,  4,  8,  7, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  1, 10,  0, 10, 11,  0, 11,  7,  0,  7,  4, -1, -1, -1, -1 },
+        {  0,  9, 10,  0, 10, 11,  0, 11,  3,  4,  8,  7, -1, -1, -1, -1 },
+        {  4,  9, 10,  4, 10, 11,  4, 11,  7, -1, -1, -1, -1, -1, -1, -1 },
+        {  4,  5,  9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  8,  4,  5,  9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  4,  5,  0,  5,  1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  3,  8,  1,  8,  4,  1,  4,  5, -1, -1, -1, -1, -1, -1, -1 },
+        {  1, 10,  2,  4,  5,  9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  8,  1, 10,  2,  4,  5,  9, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  4,  5,  0,  5, 10,  0, 10,  2, -1, -1, -1, -1, -1, -1, -1 },
+        {  2,  3,  8,  2,  8,  4,  2,  4,  5,  2,  5, 10, -1, -1, -1, -1 },
+        {  2, 11,  3,  4,  5,  9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  2, 11,  0, 11,  8,  4,  5,  9, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  4,  5,  0,  5,  1,  2, 11,  3, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  2, 11,  1, 11,  8,  1,  8,  4,  1,  4,  5, -1, -1, -1, -1 },
+        {  1, 10, 11,  1, 11,  3,  4,  5,  9, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  1, 10,  0, 10, 11,  0, 11,  8,  4,  5,  9, -1, -1, -1, -1 },
+        {  0,  4,  5,  0,  5, 10,  0, 10, 11,  0, 11,  3, -1, -1, -1, -1 },
+        {  4,  5, 10,  4, 10, 11,  4, 11,  8, -1, -1, -1, -1, -1, -1, -1 },
+        {  5,  9,  8,  5,  8,  7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  7,  0,  7,  5,  0,  5,  9, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  8,  7,  0,  7,  5,  0,  5,  1, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  3,  7,  1,  7,  5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  1, 10,  2,  5,  9,  8,  5,  8,  7, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  7,  0,  7,  5,  0,  5,  9,  1, 10,  2, -1, -1, -1, -1 },
+        {  0,  8,  7,  0,  7,  5,  0,  5, 10,  0, 10,  2, -1, -1, -1, -1 },
+        {  2,  3,  7,  2,  7,  5,  2,  5, 10, -1, -1, -1, -1, -1, -1, -1 },
+        {  2, 11,  3,  5,  9,  8,  5,  8,  7, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  2, 11,  0, 11,  7,  0,  7,  5,  0,  5,  9, -1, -1, -1, -1 },
+        {  0,  8,  7,  0,  7,  5,  0,  5,  1,  2, 11,  3, -1, -1, -1, -1 },
+        {  1,  2, 11,  1, 11,  7,  1,  7,  5, -1, -1, -1, -1, -1, -1, -1 },
+        {  1, 10, 11,  1, 11,  3,  5,  9,  8,  5,  8,  7, -1, -1, -1, -1 },
+        {  0,  1, 10,  0, 10, 11,  0, 11,  7,  0,  7,  5,  0,  5,  9, -1 },
+        {  0,  8,  7,  0,  7,  5,  0,  5, 10,  0, 10, 11,  0, 11,  3, -1 },
+        {  5, 10, 11,  5, 11,  7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  5,  6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  8,  5,  6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9,  1,  5,  6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  3,  8,  1,  8,  9,  5,  6, 10, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  5,  6,  1,  6,  2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  8,  1,  5,  6,  1,  6,  2, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9,  5,  0,  5,  6,  0,  6,  2, -1, -1, -1, -1, -1, -1, -1 },
+        {  2,  3,  8,  2,  8,  9,  2,  9,  5,  2,  5,  6, -1, -1, -1, -1 },
+        {  2, 11,  3,  5,  6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  2, 11,  0, 11,  8,  5,  6, 10, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9,  1,  2, 11,  3,  5,  6, 10, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  2, 11,  1, 11,  8,  1,  8,  9,  5,  6, 10, -1, -1, -1, -1 },
+        {  1,  5,  6,  1,  6, 11,  1, 11,  3, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  1,  5,  0,  5,  6,  0,  6, 11,  0, 11,  8, -1, -1, -1, -1 },
+        {  0,  9,  5,  0,  5,  6,  0,  6, 11,  0, 11,  3, -1, -1, -1, -1 },
+        {  5,  6, 11,  5, 11,  8,  5,  8,  9, -1, -1, -1, -1, -1, -1, -1 },
+        {  4,  8,  7,  5,  6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  7,  0,  7,  4,  5,  6, 10, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9,  1,  4,  8,  7,  5,  6, 10, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  3,  7,  1,  7,  4,  1,  4,  9,  5,  6, 10, -1, -1, -1, -1 },
+        {  1,  5,  6,  1,  6,  2,  4,  8,  7, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  7,  0,  7,  4,  1,  5,  6,  1,  6,  2, -1, -1, -1, -1 },
+        {  0,  9,  5,  0,  5,  6,  0,  6,  2,  4,  8,  7, -1, -1, -1, -1 },
+        {  2,  3,  7,  2,  7,  4,  2,  4,  9,  2,  9,  5,  2,  5,  6, -1 },
+        {  2, 11,  3,  4,  8,  7,  5,  6, 10, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  2, 11,  0, 11,  7,  0,  7,  4,  5,  6, 10, -1, -1, -1, -1 },
+        {  0,  9,  1,  2, 11,  3,  4,  8,  7,  5,  6, 10, -1, -1, -1, -1 },
+        {  1,  2, 11,  1, 11,  7,  1,  7,  4,  1,  4,  9,  5,  6, 10, -1 },
+        {  1,  5,  6,  1,  6, 11,  1, 11,  3,  4,  8,  7, -1, -1, -1, -1 },
+        {  0,  1,  5,  0,  5,  6,  0,  6, 11,  0, 11,  7,  0,  7,  4, -1 },
+        {  0,  9,  5,  0,  5,  6,  0,  6, 11,  0, 11,  3,  4,  8,  7, -1 },
+        {  4,  9,  5,  4,  5,  6,  4,  6, 11,  4, 11,  7, -1, -1, -1, -1 },
+        {  4,  6, 10,  4, 10,  9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  8,  4,  6, 10,  4, 10,  9, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  4,  6,  0,  6, 10,  0, 10,  1, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  3,  8,  1,  8,  4,  1,  4,  6,  1,  6, 10, -1, -1, -1, -1 },
+        {  1,  9,  4,  1,  4,  6,  1,  6,  2, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  8,  1,  9,  4,  1,  4,  6,  1,  6,  2, -1, -1, -1, -1 },
+        {  0,  4,  6,  0,  6,  2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  2,  3,  8,  2,  8,  4,  2,  4,  6, -1, -1, -1, -1, -1, -1, -1 },
+        {  2, 11,  3,  4,  6, 10,  4, 10,  9, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  2, 11,  0, 11,  8,  4,  6, 10,  4, 10,  9, -1, -1, -1, -1 },
+        {  0,  4,  6,  0,  6, 10,  0, 10,  1,  2, 11,  3, -1, -1, -1, -1 },
+        {  1,  2, 11,  1, 11,  8,  1,  8,  4,  1,  4,  6,  1,  6, 10, -1 },
+        {  1,  9,  4,  1,  4,  6,  1,  6, 11,  1, 11,  3, -1, -1, -1, -1 },
+        {  0,  1,  9,  0,  9,  4,  0,  4,  6,  0,  6, 11,  0, 11,  8, -1 },
+        {  0,  4,  6,  0,  6, 11,  0, 11,  3, -1, -1, -1, -1, -1, -1, -1 },
+        {  4,  6, 11,  4, 11,  8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  6, 10,  9,  6,  9,  8,  6,  8,  7, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  7,  0,  7,  6,  0,  6, 10,  0, 10,  9, -1, -1, -1, -1 },
+        {  0,  8,  7,  0,  7,  6,  0,  6, 10,  0, 10,  1, -1, -1, -1, -1 },
+        {  1,  3,  7,  1,  7,  6,  1,  6, 10, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  9,  8,  1,  8,  7,  1,  7,  6,  1,  6,  2, -1, -1, -1, -1 },
+        {  0,  3,  7,  0,  7,  6,  0,  6,  2,  0,  2,  1,  0,  1,  9, -1 },
+        {  0,  8,  7,  0,  7,  6,  0,  6,  2, -1, -1, -1, -1, -1, -1, -1 },
+        {  2,  3,  7,  2,  7,  6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  2, 11,  3,  6, 10,  9,  6,  9,  8,  6,  8,  7, -1, -1, -1, -1 },
+        {  0,  2, 11,  0, 11,  7,  0,  7,  6,  0,  6, 10,  0, 10,  9, -1 },
+        {  0,  8,  7,  0,  7,  6,  0,  6, 10,  0, 10,  1,  2, 11,  3, -1 },
+        {  1,  2, 11,  1, 11,  7,  1,  7,  6,  1,  6, 10, -1, -1, -1, -1 },
+        {  1,  9,  8,  1,  8,  7,  1,  7,  6,  1,  6, 11,  1, 11,  3, -1 },
+        {  0,  1,  9,  6, 11,  7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  8,  7,  0,  7,  6,  0,  6, 11,  0, 11,  3, -1, -1, -1, -1 },
+        {  6, 11,  7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  6,  7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  8,  6,  7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9,  1,  6,  7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  3,  8,  1,  8,  9,  6,  7, 11, -1, -1, -1, -1, -1, -1, -1 },
+        {  1, 10,  2,  6,  7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  8,  1, 10,  2,  6,  7, 11, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9, 10,  0, 10,  2,  6,  7, 11, -1, -1, -1, -1, -1, -1, -1 },
+        {  2,  3,  8,  2,  8,  9,  2,  9, 10,  6,  7, 11, -1, -1, -1, -1 },
+        {  2,  6,  7,  2,  7,  3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  2,  6,  0,  6,  7,  0,  7,  8, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9,  1,  2,  6,  7,  2,  7,  3, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  2,  6,  1,  6,  7,  1,  7,  8,  1,  8,  9, -1, -1, -1, -1 },
+        {  1, 10,  6,  1,  6,  7,  1,  7,  3, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  1, 10,  0, 10,  6,  0,  6,  7,  0,  7,  8, -1, -1, -1, -1 },
+        {  0,  9, 10,  0, 10,  6,  0,  6,  7,  0,  7,  3, -1, -1, -1, -1 },
+        {  6,  7,  8,  6,  8,  9,  6,  9, 10, -1, -1, -1, -1, -1, -1, -1 },
+        {  4,  8, 11,  4, 11,  6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3, 11,  0, 11,  6,  0,  6,  4, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9,  1,  4,  8, 11,  4, 11,  6, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  3, 11,  1, 11,  6,  1,  6,  4,  1,  4,  9, -1, -1, -1, -1 },
+        {  1, 10,  2,  4,  8, 11,  4, 11,  6, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3, 11,  0, 11,  6,  0,  6,  4,  1, 10,  2, -1, -1, -1, -1 },
+        {  0,  9, 10,  0, 10,  2,  4,  8, 11,  4, 11,  6, -1, -1, -1, -1 },
+        {  2,  3, 11,  2, 11,  6,  2,  6,  4,  2,  4,  9,  2,  9, 10, -1 },
+        {  2,  6,  4,  2,  4,  8,  2,  8,  3, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  2,  6,  0,  6,  4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9,  1,  2,  6,  4,  2,  4,  8,  2,  8,  3, -1, -1, -1, -1 },
+        {  1,  2,  6,  1,  6,  4,  1,  4,  9, -1, -1, -1, -1, -1, -1, -1 },
+        {  1, 10,  6,  1,  6,  4,  1,  4,  8,  1,  8,  3, -1, -1, -1, -1 },
+        {  0,  1, 10,  0, 10,  6,  0,  6,  4, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9, 10,  0, 10,  6,  0,  6,  4,  0,  4,  8,  0,  8,  3, -1 },
+        {  4,  9, 10,  4, 10,  6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  4,  5,  9,  6,  7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  8,  4,  5,  9,  6,  7, 11, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  4,  5,  0,  5,  1,  6,  7, 11, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  3,  8,  1,  8,  4,  1,  4,  5,  6,  7, 11, -1, -1, -1, -1 },
+        {  1, 10,  2,  4,  5,  9,  6,  7, 11, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  8,  1, 10,  2,  4,  5,  9,  6,  7, 11, -1, -1, -1, -1 },
+        {  0,  4,  5,  0,  5, 10,  0, 10,  2,  6,  7, 11, -1, -1, -1, -1 },
+        {  2,  3,  8,  2,  8,  4,  2,  4,  5,  2,  5, 10,  6,  7, 11, -1 },
+        {  2,  6,  7,  2,  7,  3,  4,  5,  9, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  2,  6,  0,  6,  7,  0,  7,  8,  4,  5,  9, -1, -1, -1, -1 },
+        {  0,  4,  5,  0,  5,  1,  2,  6,  7,  2,  7,  3, -1, -1, -1, -1 },
+        {  1,  2,  6,  1,  6,  7,  1,  7,  8,  1,  8,  4,  1,  4,  5, -1 },
+        {  1, 10,  6,  1,  6,  7,  1,  7,  3,  4,  5,  9, -1, -1, -1, -1 },
+        {  0,  1, 10,  0, 10,  6,  0,  6,  7,  0,  7,  8,  4,  5,  9, -1 },
+        {  0,  4,  5,  0,  5, 10,  0, 10,  6,  0,  6,  7,  0,  7,  3, -1 },
+        {  4,  5, 10,  4, 10,  6,  4,  6,  7,  4,  7,  8, -1, -1, -1, -1 },
+        {  5,  9,  8,  5,  8, 11,  5, 11,  6, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3, 11,  0, 11,  6,  0,  6,  5,  0,  5,  9, -1, -1, -1, -1 },
+        {  0,  8, 11,  0, 11,  6,  0,  6,  5,  0,  5,  1, -1, -1, -1, -1 },
+        {  1,  3, 11,  1, 11,  6,  1,  6,  5, -1, -1, -1, -1, -1, -1, -1 },
+        {  1, 10,  2,  5,  9,  8,  5,  8, 11,  5, 11,  6, -1, -1, -1, -1 },
+        {  0,  3, 11,  0, 11,  6,  0,  6,  5,  0,  5,  9,  1, 10,  2, -1 },
+        {  0,  8, 11,  0, 11,  6,  0,  6,  5,  0,  5, 10,  0, 10,  2, -1 },
+        {  2,  3, 11,  2, 11,  6,  2,  6,  5,  2,  5, 10, -1, -1, -1, -1 },
+        {  2,  6,  5,  2,  5,  9,  2,  9,  8,  2,  8,  3, -1, -1, -1, -1 },
+        {  0,  2,  6,  0,  6,  5,  0,  5,  9, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  8,  3,  0,  3,  2,  0,  2,  6,  0,  6,  5,  0,  5,  1, -1 },
+        {  1,  2,  6,  1,  6,  5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  1, 10,  6,  1,  6,  5,  1,  5,  9,  1,  9,  8,  1,  8,  3, -1 },
+        {  0,  1, 10,  0, 10,  6,  0,  6,  5,  0,  5,  9, -1, -1, -1, -1 },
+        {  0,  8,  3,  5, 10,  6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  5, 10,  6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  5,  7, 11,  5, 11, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  8,  5,  7, 11,  5, 11, 10, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9,  1,  5,  7, 11,  5, 11, 10, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  3,  8,  1,  8,  9,  5,  7, 11,  5, 11, 10, -1, -1, -1, -1 },
+        {  1,  5,  7,  1,  7, 11,  1, 11,  2, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  8,  1,  5,  7,  1,  7, 11,  1, 11,  2, -1, -1, -1, -1 },
+        {  0,  9,  5,  0,  5,  7,  0,  7, 11,  0, 11,  2, -1, -1, -1, -1 },
+        {  2,  3,  8,  2,  8,  9,  2,  9,  5,  2,  5,  7,  2,  7, 11, -1 },
+        {  2, 10,  5,  2,  5,  7,  2,  7,  3, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  2, 10,  0, 10,  5,  0,  5,  7,  0,  7,  8, -1, -1, -1, -1 },
+        {  0,  9,  1,  2, 10,  5,  2,  5,  7,  2,  7,  3, -1, -1, -1, -1 },
+        {  1,  2, 10,  1, 10,  5,  1,  5,  7,  1,  7,  8,  1,  8,  9, -1 },
+        {  1,  5,  7,  1,  7,  3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  1,  5,  0,  5,  7,  0,  7,  8, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9,  5,  0,  5,  7,  0,  7,  3, -1, -1, -1, -1, -1, -1, -1 },
+        {  5,  7,  8,  5,  8,  9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  4,  8, 11,  4, 11, 10,  4, 10,  5, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3, 11,  0, 11, 10,  0, 10,  5,  0,  5,  4, -1, -1, -1, -1 },
+        {  0,  9,  1,  4,  8, 11,  4, 11, 10,  4, 10,  5, -1, -1, -1, -1 },
+        {  1,  3, 11,  1, 11, 10,  1, 10,  5,  1,  5,  4,  1,  4,  9, -1 },
+        {  1,  5,  4,  1,  4,  8,  1,  8, 11,  1, 11,  2, -1, -1, -1, -1 },
+        {  0,  3, 11,  0, 11,  2,  0,  2,  1,  0,  1,  5,  0,  5,  4, -1 },
+        {  0,  9,  5,  0,  5,  4,  0,  4,  8,  0,  8, 11,  0, 11,  2, -1 },
+        {  2,  3, 11,  4,  9,  5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  2, 10,  5,  2,  5,  4,  2,  4,  8,  2,  8,  3, -1, -1, -1, -1 },
+        {  0,  2, 10,  0, 10,  5,  0,  5,  4, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9,  1,  2, 10,  5,  2,  5,  4,  2,  4,  8,  2,  8,  3, -1 },
+        {  1,  2, 10,  1, 10,  5,  1,  5,  4,  1,  4,  9, -1, -1, -1, -1 },
+        {  1,  5,  4,  1,  4,  8,  1,  8,  3, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  1,  5,  0,  5,  4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  9,  5,  0,  5,  4,  0,  4,  8,  0,  8,  3, -1, -1, -1, -1 },
+        {  4,  9,  5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  4,  7, 11,  4, 11, 10,  4, 10,  9, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3,  8,  4,  7, 11,  4, 11, 10,  4, 10,  9, -1, -1, -1, -1 },
+        {  0,  4,  7,  0,  7, 11,  0, 11, 10,  0, 10,  1, -1, -1, -1, -1 },
+        {  1,  3,  8,  1,  8,  4,  1,  4,  7,  1,  7, 11,  1, 11, 10, -1 },
+        {  1,  9,  4,  1,  4,  7,  1,  7, 11,  1, 11,  2, -1, -1, -1, -1 },
+        {  0,  3,  8,  1,  9,  4,  1,  4,  7,  1,  7, 11,  1, 11,  2, -1 },
+        {  0,  4,  7,  0,  7, 11,  0, 11,  2, -1, -1, -1, -1, -1, -1, -1 },
+        {  2,  3,  8,  2,  8,  4,  2,  4,  7,  2,  7, 11, -1, -1, -1, -1 },
+        {  2, 10,  9,  2,  9,  4,  2,  4,  7,  2,  7,  3, -1, -1, -1, -1 },
+        {  0,  2, 10,  0, 10,  9,  0,  9,  4,  0,  4,  7,  0,  7,  8, -1 },
+        {  0,  4,  7,  0,  7,  3,  0,  3,  2,  0,  2, 10,  0, 10,  1, -1 },
+        {  1,  2, 10,  4,  7,  8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  9,  4,  1,  4,  7,  1,  7,  3, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  1,  9,  0,  9,  4,  0,  4,  7,  0,  7,  8, -1, -1, -1, -1 },
+        {  0,  4,  7,  0,  7,  3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  4,  7,  8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  8, 11, 10,  8, 10,  9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3, 11,  0, 11, 10,  0, 10,  9, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  8, 11,  0, 11, 10,  0, 10,  1, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  3, 11,  1, 11, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  9,  8,  1,  8, 11,  1, 11,  2, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  3, 11,  0, 11,  2,  0,  2,  1,  0,  1,  9, -1, -1, -1, -1 },
+        {  0,  8, 11,  0, 11,  2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  2,  3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  2, 10,  9,  2,  9,  8,  2,  8,  3, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  2, 10,  0, 10,  9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  8,  3,  0,  3,  2,  0,  2, 10,  0, 10,  1, -1, -1, -1, -1 },
+        {  1,  2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  1,  9,  8,  1,  8,  3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  1,  9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        {  0,  8,  3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+    };
+
+    // -----------------------------------------------------------------------------
+
+    int SampleIndex(int _X, int _Y, int _Z)
+    {
+        return ((_Z + 1) * g_SampleResolution + (_Y + 1)) * g_SampleResolution + (_X + 1);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int EdgeCacheIndex(const glm::ivec3& _rOrigin, int _Axis)
+    {
+        return ((_Axis * g_EdgeOriginResolution + _rOrigin.z) * g_EdgeOriginResolution + _rOrigin.y) * g_EdgeOriginResolution + _rOrigin.x;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Global voxel coordinates are packed with 20 bits per axis (+-2 km at 2 mm
+    // voxels) and the edge direction in the top bits.
+    // -----------------------------------------------------------------------------
+    uint64_t EdgeKey(const glm::ivec3& _rVoxel, int _Axis)
+    {
+        const uint64_t Bias = 1 << 19;
+        const uint64_t Mask = (1 << 20) - 1;
+
+        return ((static_cast<uint64_t>(_rVoxel.x) + Bias) & Mask)
+            | (((static_cast<uint64_t>(_rVoxel.y) + Bias) & Mask) << 20)
+            | (((static_cast<uint64_t>(_rVoxel.z) + Bias) & Mask) << 40)
+            | (static_cast<uint64_t>(_Axis) << 60);
+    }
+} // namespace
+
+namespace MR
+{
+    CMeshExtractor::CMeshExtractor(float _VoxelSize)
+        : m_VoxelSize        (_VoxelSize)
+        , m_MinWeight        (g_DefaultMinWeight)
+        , m_Bricks           ()
+        , m_DirtyKeys        ()
+        , m_IsMeshDirty      (false)
+        , m_NumberOfTriangles(0)
+        , m_Vertices         ()
+        , m_Indices          ()
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    CMeshExtractor::~CMeshExtractor()
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMeshExtractor::SetBrick(const glm::ivec3& _rKey, const SVoxel* _pVoxels)
+    {
+        assert(_pVoxels != nullptr);
+
+        auto Result = m_Bricks.try_emplace(_rKey);
+
+        SBrick& rBrick = Result.first->second;
+
+        if (Result.second)
+        {
+            rBrick.m_IsDirty = false;
+        }
+        else if (std::memcmp(rBrick.m_Voxels.data(), _pVoxels, sizeof(rBrick.m_Voxels)) == 0)
+        {
+            return;
+        }
+
+        std::memcpy(rBrick.m_Voxels.data(), _pVoxels, sizeof(rBrick.m_Voxels));
+
+        MarkDirty(_rKey);
+        MarkNeighboursDirty(_rKey);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CMeshExtractor::SetBricks(const SVolume& _rVolume, const glm::ivec3& _rRootOffset, int _RootPoolIndex)
+    {
+        // -----------------------------------------------------------------------------
+        // Walk the two grid levels below a root grid and unpack every allocated
+        // brick. Unchanged bricks cost nothing but the compare in SetBrick.
+        // -----------------------------------------------------------------------------
+        const int RootResolution = _rVolume.m_RootResolution;
+        const int Level1Resolution = _rVolume.m_Level1Resolution;
+
+        const int VoxelsPerRootGrid = RootResolution * RootResolution * RootResolution;
+        const int VoxelsPerLevel1Grid = Level1Resolution * Level1Resolution * Level1Resolution;
+
+        auto IndexToOffset = [](int _Index, int _Resolution)
+        {
+            return glm::ivec3(_Index % _Resolution, (_Index / _Resolution) % _Resolution, _Index / (_Resolution * _Resolution));
+        };
+
+        auto GetPoolIndex = [&](const char* _pPool, size_t _Index)
+        {
+            int32_t PoolIndex;
+
+            std::memcpy(&PoolIndex, _pPool + _Index * _rVolume.m_GridPoolItemSize, sizeof(PoolIndex));
+
+            return PoolIndex;
+        };
+
+        std::array<SVoxel, s_VoxelsPerBrick> Voxels;
+
+        int NumberOfBricks = 0;
+
+        for (int RootIndex = 0; RootIndex < VoxelsPerRootGrid; ++RootIndex)
+        {
+            const int Level1PoolIndex = GetPoolIndex(_rVolume.m_pRootGridPool, static_cast<size_t>(_RootPoolIndex) * VoxelsPerRootGrid + RootIndex);
+
+            if (Level1PoolIndex == -1)
+            {
+                continue;
+            }
+
+            for (int Level1Index = 0; Level1Index < VoxelsPerLevel1Grid; ++Level1Index)
+            {
+                const int TSDFPoolIndex = GetPoolIndex(_rVolume.m_pLevel1Pool, static_cast<size_t>(Level1PoolIndex) * VoxelsPerLevel1Grid + Level1Index);
+
+                if (TSDFPoolIndex == -1)
+                {
+                    continue;
+                }
+
+                // -----------------------------------------------------------------------------
+                // Unpack like UnpackVoxel: a float TSDF and RGBA8 with the weight in
+                // alpha, or the TSDF and the weight as two 16 bit snorms
+                // -----------------------------------------------------------------------------
+                const size_t FirstVoxel = static_cast<size_t>(TSDFPoolIndex) * s_VoxelsPerBrick;
+
+                for (int Index = 0; Index < s_VoxelsPerBrick; ++Index)
+                {
+                    SVoxel& rVoxel = Voxels[Index];
+
+                    if (_rVolume.m_CaptureColor)
+                    {
+                        const char* pItem = _rVolume.m_pTSDFPool + (FirstVoxel + Index) * 2 * sizeof(uint32_t);
+
+                        uint32_t Color;
+
+                        std::memcpy(&rVoxel.m_TSDF, pItem, sizeof(float));
+                        std::memcpy(&Color, pItem + sizeof(float), sizeof(uint32_t));
+
+                        rVoxel.m_Weight = (Color >> 24) / 255.0f * _rVolume.m_MaxWeight;
+                    }
+                    else
+                    {
+                        int16_t Item[2];
+
+                        std::memcpy(Item, _rVolume.m_pTSDFPool + (FirstVoxel + Index) * sizeof(Item), sizeof(Item));
+
+                        rVoxel.m_TSDF = std::max(Item[0] / 32767.0f, -1.0f);
+                        rVoxel.m_Weight = std::max(Item[1] / 32767.0f, 0.0f) * _rVolume.m_MaxWeight;
+                    }
+                }
+
+                const glm::ivec3 Key = (_rRootOffset * RootResolution + IndexToOffset(RootIndex, RootResolution)) * Level1Resolution + IndexToOffset(Level1Index, Level1Resolution);
+
+                SetBrick(Key, Voxels.data());
+
+                ++NumberOfBricks;
+            }
+        }
+
+        return NumberOfBricks;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMeshExtractor::RemoveBrick(const glm::ivec3& _rKey)
+    {
+        auto Iterator = m_Bricks.find(_rKey);
+
+        if (Iterator == m_Bricks.end())
+        {
+            return;
+        }
+
+        m_NumberOfTriangles -= static_cast<int>(Iterator->second.m_Indices.size() / 3);
+
+        m_Bricks.erase(Iterator);
+
+        MarkNeighboursDirty(_rKey);
+
+        m_IsMeshDirty = true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMeshExtractor::Clear()
+    {
+        m_Bricks.clear();
+        m_DirtyKeys.clear();
+
+        m_Vertices.clear();
+        m_Indices.clear();
+
+        m_NumberOfTriangles = 0;
+        m_IsMeshDirty = false;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CMeshExtractor::Extract()
+    {
+        std::vector<CBricks::value_type*> DirtyBricks;
+
+        DirtyBricks.reserve(m_DirtyKeys.size());
+
+        for (const glm::ivec3& rKey : m_DirtyKeys)
+        {
+            auto Iterator = m_Bricks.find(rKey);
+
+            if (Iterator != m_Bricks.end() && Iterator->second.m_IsDirty)
+            {
+                Iterator->second.m_IsDirty = false;
+
+                m_NumberOfTriangles -= static_cast<int>(Iterator->second.m_Indices.size() / 3);
+
+                DirtyBricks.push_back(&*Iterator);
+            }
+        }
+
+        m_DirtyKeys.clear();
+
+        const int NumberOfDirtyBricks = static_cast<int>(DirtyBricks.size());
+
+        if (NumberOfDirtyBricks == 0)
+        {
+            return 0;
+        }
+
+        // -----------------------------------------------------------------------------
+        // Bricks only read their neighbours, so they are meshed independently
+        // -----------------------------------------------------------------------------
+        Base::CThreadPool::GetInstance().ParallelFor(NumberOfDirtyBricks, g_BricksPerTask, [&](int _Begin, int _End)
+        {
+            std::vector<SVoxel> Samples(g_SampleCount);
+            std::vector<int> EdgeCache(g_EdgeCacheSize);
+
+            for (int Index = _Begin; Index < _End; ++Index)
+            {
+                ExtractBrick(DirtyBricks[Index]->first, DirtyBricks[Index]->second, Samples, EdgeCache);
+            }
+        });
+
+        for (CBricks::value_type* pBrick : DirtyBricks)
+        {
+            m_NumberOfTriangles += static_cast<int>(pBrick->second.m_Indices.size() / 3);
+        }
+
+        m_IsMeshDirty = true;
+
+        return NumberOfDirtyBricks;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMeshExtractor::GetMesh(CVertices& _rVertices, CIndices& _rIndices)
+    {
+        if (m_IsMeshDirty)
+        {
+            // -----------------------------------------------------------------------------
+            // Weld vertices on shared edges of neighbouring bricks
+            // -----------------------------------------------------------------------------
+            std::unordered_map<uint64_t, uint32_t> VertexByKey;
+
+            VertexByKey.reserve(m_Vertices.size());
+
+            m_Vertices.clear();
+            m_Indices.clear();
+
+            std::vector<uint32_t> Remap;
+
+            for (const auto& rPair : m_Bricks)
+            {
+                const SBrick& rBrick = rPair.second;
+
+                Remap.resize(rBrick.m_Vertices.size());
+
+                for (size_t Index = 0; Index < rBrick.m_Vertices.size(); ++Index)
+                {
+                    auto Result = VertexByKey.emplace(rBrick.m_VertexKeys[Index], static_cast<uint32_t>(m_Vertices.size()));
+
+                    if (Result.second)
+                    {
+                        m_Vertices.push_back(rBrick.m_Vertices[Index]);
+                    }
+
+                    Remap[Index] = Result.first->second;
+                }
+
+                for (uint32_t LocalIndex : rBrick.m_Indices)
+                {
+                    m_Indices.push_back(Remap[LocalIndex]);
+                }
+            }
+
+            m_IsMeshDirty = false;
+        }
+
+        _rVertices = m_Vertices;
+        _rIndices = m_Indices;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMeshExtractor::SetMinWeight(float _MinWeight)
+    {
+        m_MinWeight = _MinWeight;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CMeshExtractor::GetNumberOfBricks() const
+    {
+        return static_cast<int>(m_Bricks.size());
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CMeshExtractor::GetNumberOfDirtyBricks() const
+    {
+        return static_cast<int>(m_DirtyKeys.size());
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CMeshExtractor::GetNumberOfTriangles() const
+    {
+        return m_NumberOfTriangles;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMeshExtractor::MarkDirty(const glm::ivec3& _rKey)
+    {
+        auto Iterator = m_Bricks.find(_rKey);
+
+        if (Iterator != m_Bricks.end() && !Iterator->second.m_IsDirty)
+        {
+            Iterator->second.m_IsDirty = true;
+
+            m_DirtyKeys.push_back(_rKey);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // A brick reads the voxels of all 26 neighbours (positions on its upper
+    // border, normals on both borders), so changes have to be propagated.
+    // -----------------------------------------------------------------------------
+    void CMeshExtractor::MarkNeighboursDirty(const glm::ivec3& _rKey)
+    {
+        for (int z = -1; z <= 1; ++z)
+        {
+            for (int y = -1; y <= 1; ++y)
+            {
+                for (int x = -1; x <= 1; ++x)
+                {
+                    if (x != 0 || y != 0 || z != 0)
+                    {
+                        MarkDirty(_rKey + glm::ivec3(x, y, z));
+                    }
+                }
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void CMeshExtractor::ExtractBrick(const glm::ivec3& _rKey, SBrick& _rBrick, std::vector<SVoxel>& _rSamples, std::vector<int>& _rEdgeCache) const
+    {
+        // -----------------------------------------------------------------------------
+        // Gather the brick and the border of its neighbours. Missing voxels get
+        // a zero weight and are skipped like unobserved ones.
+        // -----------------------------------------------------------------------------
+        const SBrick* pNeighbours[3][3][3];
+
+        for (int z = 0; z < 3; ++z)
+        {
+            for (int y = 0; y < 3; ++y)
+            {
+                for (int x = 0; x < 3; ++x)
+                {
+                    auto Iterator = m_Bricks.find(_rKey + glm::ivec3(x - 1, y - 1, z - 1));
+
+                    pNeighbours[z][y][x] = Iterator != m_Bricks.end() ? &Iterator->second : nullptr;
+                }
+            }
+        }
+
+        for (int z = -1; z <= g_BrickResolution + 1; ++z)
+        {
+            const int BrickZ = z < 0 ? 0 : (z < g_BrickResolution ? 1 : 2);
+            const int LocalZ = z - (BrickZ - 1) * g_BrickResolution;
+
+            for (int y = -1; y <= g_BrickResolution + 1; ++y)
+            {
+                const int BrickY = y < 0 ? 0 : (y < g_BrickResolution ? 1 : 2);
+                const int LocalY = y - (BrickY - 1) * g_BrickResolution;
+
+                for (int x = -1; x <= g_BrickResolution + 1; ++x)
+                {
+                    const int BrickX = x < 0 ? 0 : (x < g_BrickResolution ? 1 : 2);
+                    const int LocalX = x - (BrickX - 1) * g_BrickResolution;
+
+                    const SBrick* pBrick = pNeighbours[BrickZ][BrickY][BrickX];
+
+                    SVoxel& rSample = _rSamples[SampleIndex(x, y, z)];
+
+                    if (pBrick != nullptr)
+                    {
+                        rSample = pBrick->m_Voxels[(LocalZ * g_BrickResolution + LocalY) * g_BrickResolution + LocalX];
+                    }
+                    else
+                    {
+                        rSample.m_TSDF = 0.0f;
+                        rSample.m_Weight = 0.0f;
+                    }
+                }
+            }
+        }
+
+        // -----------------------------------------------------------------------------
+
+        auto IsValid = [&](const SVoxel& _rSample)
+        {
+            return _rSample.m_Weight >= m_MinWeight && _rSample.m_Weight > 0.0f;
+        };
+
+        auto Gradient = [&](const glm::ivec3& _rVoxel)
+        {
+            const int Center = SampleIndex(_rVoxel.x, _rVoxel.y, _rVoxel.z);
+            const int Strides[3] = { 1, g_SampleResolution, g_SampleResolution * g_SampleResolution };
+
+            glm::vec3 Result;
+
+            for (int Axis = 0; Axis < 3; ++Axis)
+            {
+                const SVoxel& rNext = _rSamples[Center + Strides[Axis]];
+                const SVoxel& rPrevious = _rSamples[Center - Strides[Axis]];
+
+                const float Next = IsValid(rNext) ? rNext.m_TSDF : _rSamples[Center].m_TSDF;
+                const float Previous = IsValid(rPrevious) ? rPrevious.m_TSDF : _rSamples[Center].m_TSDF;
+
+                Result[Axis] = Next - Previous;
+            }
+
+            return Result;
+        };
+
+        // -----------------------------------------------------------------------------
+
+        _rBrick.m_Vertices.clear();
+        _rBrick.m_Indices.clear();
+        _rBrick.m_VertexKeys.clear();
+
+        std::fill(_rEdgeCache.begin(), _rEdgeCache.end(), -1);
+
+        const glm::ivec3 BrickVoxel = _rKey * g_BrickResolution;
+
+        for (int z = 0; z < g_BrickResolution; ++z)
+        {
+            for (int y = 0; y < g_BrickResolution; ++y)
+            {
+                for (int x = 0; x < g_BrickResolution; ++x)
+                {
+                    const glm::ivec3 Cell(x, y, z);
+
+                    const SVoxel* pCorners[8];
+
+                    int CubeIndex = 0;
+                    bool IsCellValid = true;
+
+                    for (int Corner = 0; Corner < 8 && IsCellValid; ++Corner)
+                    {
+                        const glm::ivec3 Voxel = Cell + g_CornerOffsets[Corner];
+
+                        pCorners[Corner] = &_rSamples[SampleIndex(Voxel.x, Voxel.y, Voxel.z)];
+
+                        IsCellValid = IsValid(*pCorners[Corner]);
+
+                        if (pCorners[Corner]->m_TSDF < 0.0f)
+                        {
+                            CubeIndex |= 1 << Corner;
+                        }
+                    }
+
+                    if (!IsCellValid || g_EdgeTable[CubeIndex] == 0)
+                    {
+                        continue;
+                    }
+
+                    int EdgeVertices[12];
+
+                    for (int Edge = 0; Edge < 12; ++Edge)
+                    {
+                        if ((g_EdgeTable[CubeIndex] & (1 << Edge)) == 0)
+                        {
+                            continue;
+                        }
+
+                        const int Axis = g_EdgeAxis[Edge];
+                        const glm::ivec3 Origin = Cell + g_CornerOffsets[g_EdgeCorners[Edge][0]];
+
+                        int& rCachedVertex = _rEdgeCache[EdgeCacheIndex(Origin, Axis)];
+
+                        if (rCachedVertex == -1)
+                        {
+                            // -----------------------------------------------------------------------------
+                            // Always interpolate from the lower voxel, so that both bricks
+                            // sharing this edge compute the exact same vertex.
+                            // -----------------------------------------------------------------------------
+                            const glm::ivec3 Target = Cell + g_CornerOffsets[g_EdgeCorners[Edge][1]];
+
+                            const float OriginTSDF = pCorners[g_EdgeCorners[Edge][0]]->m_TSDF;
+                            const float TargetTSDF = pCorners[g_EdgeCorners[Edge][1]]->m_TSDF;
+
+                            const float Lerp = OriginTSDF / (OriginTSDF - TargetTSDF);
+
+                            glm::vec3 Position(BrickVoxel + Origin);
+                            Position[Axis] += Lerp;
+
+                            const glm::vec3 Normal = glm::mix(Gradient(Origin), Gradient(Target), Lerp);
+                            const float NormalLength = glm::length(Normal);
+
+                            SVertex Vertex;
+
+                            Vertex.m_Position = Position * m_VoxelSize;
+                            Vertex.m_Normal = NormalLength > 0.0f ? Normal / NormalLength : glm::vec3(0.0f, 0.0f, 1.0f);
+                            Vertex.m_UV = glm::vec2(0.0f);
+
+                            rCachedVertex = static_cast<int>(_rBrick.m_Vertices.size());
+
+                            _rBrick.m_Vertices.push_back(Vertex);
+                            _rBrick.m_VertexKeys.push_back(EdgeKey(BrickVoxel + Origin, Axis));
+                        }
+
+                        EdgeVertices[Edge] = rCachedVertex;
+                    }
+
+                    for (const int* pEdge = g_TriangleTable[CubeIndex]; *pEdge != -1; ++pEdge)
+                    {
+                        _rBrick.m_Indices.push_back(static_cast<uint32_t>(EdgeVertices[*pEdge]));
+                    }
+                }
+            }
+        }
+    }
+} // namespace MR
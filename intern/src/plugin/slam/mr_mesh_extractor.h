@@ -0,0 +1,130 @@
+#pragma once
+
+#include "base/base_include_glm.h"
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace MR
+{
+    // -----------------------------------------------------------------------------
+    // Marching cubes over the TSDF bricks (8x8x8 voxels, the level 2 grids of the
+    // reconstruction). Bricks are fed in with SetBrick; only bricks whose voxels
+    // changed (and their neighbours sharing a seam) are re-meshed on Extract.
+    // Vertices on brick borders are welded by a hash of their voxel edge, so
+    // GetMesh returns a single indexed mesh ready for MeshManager::CreateMesh.
+    // -----------------------------------------------------------------------------
+    class CMeshExtractor
+    {
+    public:
+
+        static const int s_BrickResolution = 8;
+        static const int s_VoxelsPerBrick = s_BrickResolution * s_BrickResolution * s_BrickResolution;
+
+        struct SVoxel
+        {
+            float m_TSDF;
+            float m_Weight;
+        };
+
+        // -----------------------------------------------------------------------------
+        // Same layout as the surfaces created by MeshManager::CreateMesh
+        // (position, normal, texcoords).
+        // -----------------------------------------------------------------------------
+        struct SVertex
+        {
+            glm::vec3 m_Position;
+            glm::vec3 m_Normal;
+            glm::vec2 m_UV;
+        };
+
+        using CVertices = std::vector<SVertex>;
+        using CIndices = std::vector<uint32_t>;
+
+        // -----------------------------------------------------------------------------
+        // Mapped pools of the hierarchical volume. Grid pool items start with
+        // the pool index of the next level (-1 if not allocated), TSDF pool
+        // items are packed like in common_scalable.glsl.
+        // -----------------------------------------------------------------------------
+        struct SVolume
+        {
+            const char* m_pRootGridPool;
+            const char* m_pLevel1Pool;
+            const char* m_pTSDFPool;
+            int m_GridPoolItemSize;
+            int m_RootResolution;
+            int m_Level1Resolution;
+            bool m_CaptureColor;
+            float m_MaxWeight;
+        };
+
+    public:
+
+        void SetBrick(const glm::ivec3& _rKey, const SVoxel* _pVoxels);
+        int SetBricks(const SVolume& _rVolume, const glm::ivec3& _rRootOffset, int _RootPoolIndex);
+        void RemoveBrick(const glm::ivec3& _rKey);
+        void Clear();
+
+        int Extract();
+
+        void GetMesh(CVertices& _rVertices, CIndices& _rIndices);
+
+        void SetMinWeight(float _MinWeight);
+
+        int GetNumberOfBricks() const;
+        int GetNumberOfDirtyBricks() const;
+        int GetNumberOfTriangles() const;
+
+    public:
+
+        CMeshExtractor(float _VoxelSize);
+       ~CMeshExtractor();
+
+    private:
+
+        struct SBrickKeyHash
+        {
+            size_t operator()(const glm::ivec3& _rKey) const
+            {
+                return static_cast<size_t>(_rKey.x * 73856093 ^ _rKey.y * 19349663 ^ _rKey.z * 83492791);
+            }
+        };
+
+        struct SBrick
+        {
+            std::array<SVoxel, s_VoxelsPerBrick> m_Voxels;
+
+            CVertices m_Vertices;
+            CIndices m_Indices;
+            std::vector<uint64_t> m_VertexKeys;
+
+            bool m_IsDirty;
+        };
+
+        using CBricks = std::unordered_map<glm::ivec3, SBrick, SBrickKeyHash>;
+        using CBrickKeys = std::vector<glm::ivec3>;
+
+    private:
+
+        void MarkDirty(const glm::ivec3& _rKey);
+        void MarkNeighboursDirty(const glm::ivec3& _rKey);
+
+        void ExtractBrick(const glm::ivec3& _rKey, SBrick& _rBrick, std::vector<SVoxel>& _rSamples, std::vector<int>& _rEdgeCache) const;
+
+    private:
+
+        float m_VoxelSize;
+        float m_MinWeight;
+
+        CBricks m_Bricks;
+        CBrickKeys m_DirtyKeys;
+
+        bool m_IsMeshDirty;
+        int m_NumberOfTriangles;
+
+        CVertices m_Vertices;
+        CIndices m_Indices;
+    };
+} // namespace MR
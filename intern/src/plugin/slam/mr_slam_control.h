@@ -30,6 +30,7 @@
 #include "engine/core/core_asset_manager.h"
 
 #include "plugin/slam/mr_plane_colorizer.h"
+#include "plugin/slam/mr_slam_stream_parser.h"
 
 #include "engine/script/script_script.h"
 
@@ -45,29 +46,12 @@ namespace MR
     {
     private:
 
-        enum EMessageType
-        {
-            COMMAND,
-            TRANSFORM,
-            DEPTHFRAME,
-            COLORFRAME,
-            LIGHTESTIMATE,
-            PLANE
-        };
-
         enum EDATASOURCE
         {
             NETWORK,
             KINECT
         };
 
-        enum EPlaneAction
-        {
-            ADDPLANE,
-            UPDATEPLANE,
-            REMOVEPLANE
-        };
-
         struct SIntrinsics
         {
             glm::vec2 m_FocalLength;
@@ -156,16 +140,10 @@ namespace MR
         Gfx::CTexturePtr m_UnregisteredDepthTexture;
         Gfx::CTexturePtr m_ShiftLUTPtr;
 
-        struct SIntrinsicsMessage
-        {
-            glm::vec2  m_FocalLength;
-            glm::vec2  m_FocalPoint;
-            glm::ivec2 m_DepthSize;
-            glm::ivec2 m_ColorSize;
-            glm::ivec2 m_DeviceResolution;
-            glm::mat4  m_DeviceProjectionMatrix;
-            glm::mat4  m_RelativeCameraTransform;
-        };
+        using SIntrinsicsMessage = CSLAMStreamParser::SIntrinsicsMessage;
+
+        CSLAMStreamParser m_StreamParser;
+        CSLAMStreamParser::SMessage m_ParsedMessage;
 
         Net::SocketHandle m_SLAMSocket;
 
@@ -705,7 +683,7 @@ namespace MR
 						Indices.push_back(static_cast<uint16_t>(Index));
 					}
 
-					int32_t MessageID = PLANE;
+					int32_t MessageID = CSLAMStreamParser::PLANE;
 
 					int VerticesMemSize = VertexCount * sizeof(Vertices[0]);
 					int UVMemSize = VertexCount * sizeof(UV[0]);
@@ -766,7 +744,7 @@ namespace MR
 					Message.m_MessageType = 0;
 					Message.m_Payload = std::move(Payload);
 
-					Net::CNetworkManager::GetInstance().SendMessage(m_SLAMSocket, Message);
+					Net::CNetworkManager::GetInstance().SendMessage(m_SLAMSocket, std::move(Message));
 				}
 			}
 		}
@@ -865,7 +843,7 @@ namespace MR
 
                 std::vector<char> Compressed;
 
-                Base::Compress(static_cast<char*>(m_pGPUPixelData), m_PixelBufferSize, Compressed, 1);
+                Base::CompressParallel(static_cast<char*>(m_pGPUPixelData), m_PixelBufferSize, Compressed, 1);
 
                 Net::CMessage Message;
                 Message.m_Category = 0;
@@ -874,7 +852,7 @@ namespace MR
                 Message.m_MessageType = 0;
                 Message.m_Payload = std::move(Compressed);
 
-                //Net::CNetworkManager::GetInstance().SendMessage(m_SLAMSocket, Message);
+                //Net::CNetworkManager::GetInstance().SendMessage(m_SLAMSocket, std::move(Message));
             }
         }
 
@@ -882,30 +860,23 @@ namespace MR
 
         void HandleMessage(const Net::CMessage& _rMessage)
         {
-            std::vector<char> Decompressed(_rMessage.m_DecompressedSize);
-
-            if (_rMessage.m_CompressedSize != _rMessage.m_DecompressedSize)
-            {
-                try
-                {
-					Base::Decompress(_rMessage.m_Payload, Decompressed);
-                }
-                catch (...)
-                {
-					ENGINE_CONSOLE_ERRORV("Failed to decompress! Ignoring network message!");
-					return;
-                }
-            }
-            else
+            // -----------------------------------------------------------------------------
+            // Decompression and parsing are done by the stream parser, only the
+            // upload to the GPU and the reconstruction are left here.
+            // -----------------------------------------------------------------------------
+            if (!m_StreamParser.Parse(_rMessage, m_ParsedMessage))
             {
-                std::memcpy(Decompressed.data(), _rMessage.m_Payload.data(), Decompressed.size());
+                ENGINE_CONSOLE_ERRORV("Failed to decompress or parse! Ignoring network message!");
+                return;
             }
 
-            int32_t MessageType = *reinterpret_cast<int32_t*>(Decompressed.data());
+            const CSLAMStreamParser::SMessage& rMessage = m_ParsedMessage;
 
-            if (MessageType == COMMAND)
+            const int MessageType = rMessage.m_Type;
+
+            if (MessageType == CSLAMStreamParser::COMMAND)
             {
-                const int MessageID = *reinterpret_cast<int32_t*>(Decompressed.data() + sizeof(int32_t));
+                const int MessageID = rMessage.m_CommandID;
 
                 if (MessageID == 0 && m_IsReconstructorInitialized)
                 {
@@ -913,35 +884,30 @@ namespace MR
                 }
                 else if (MessageID == 1)
                 {
-                    InitializeSLAM(*reinterpret_cast<const SIntrinsicsMessage*>(Decompressed.data() + sizeof(int32_t) * 2));
+                    InitializeSLAM(rMessage.m_Intrinsics);
                 }
                 else if (MessageID == 2)
                 {
-                    auto ColorSize = *reinterpret_cast<const glm::ivec2*>(Decompressed.data() + 2 * sizeof(int32_t));
-
-                    EnableDiminishedReality(ColorSize);
+                    EnableDiminishedReality(rMessage.m_ColorSize);
                 }
             }
-            else if (MessageType == TRANSFORM)
+            else if (MessageType == CSLAMStreamParser::TRANSFORM)
             {
                 if (m_StreamState == STREAM_SLAM)
                 {
-                    m_PoseMatrix = *reinterpret_cast<glm::mat4*>(Decompressed.data() + sizeof(int32_t)) * glm::eulerAngleX(glm::pi<float>());
+                    m_PoseMatrix = rMessage.m_Transform * glm::eulerAngleX(glm::pi<float>());
                 }
                 else if (m_StreamState == STREAM_DIMINSIHED)
                 {
-                    m_PreliminaryPoseMatrix = *reinterpret_cast<glm::mat4*>(Decompressed.data() + sizeof(int32_t)) * glm::eulerAngleX(glm::pi<float>());
+                    m_PreliminaryPoseMatrix = rMessage.m_Transform * glm::eulerAngleX(glm::pi<float>());
                 }
             }
-            else if (MessageType == DEPTHFRAME)
+            else if (MessageType == CSLAMStreamParser::DEPTHFRAME)
             {
-                //int32_t Width = *reinterpret_cast<int32_t*>(Decompressed.data() + sizeof(int32_t));
-                //int32_t Height = *reinterpret_cast<int32_t*>(Decompressed.data() + 2 * sizeof(int32_t));
-
-                m_DepthIntrinsics.m_FocalLength = *reinterpret_cast<glm::vec2*>(Decompressed.data() + 3 * sizeof(int32_t));
-                m_DepthIntrinsics.m_FocalPoint = *reinterpret_cast<glm::vec2*>(Decompressed.data() + 3 * sizeof(int32_t) + sizeof(glm::vec2));
+                m_DepthIntrinsics.m_FocalLength = rMessage.m_DepthFrame.m_FocalLength;
+                m_DepthIntrinsics.m_FocalPoint = rMessage.m_DepthFrame.m_FocalPoint;
 
-                const uint16_t* RawBuffer = reinterpret_cast<uint16_t*>(Decompressed.data() + 7 * sizeof(int32_t));
+                const uint16_t* RawBuffer = rMessage.m_DepthFrame.m_pPixels;
 
                 Base::AABB2UInt TargetRect;
                 TargetRect = Base::AABB2UInt(glm::uvec2(0, 0), glm::uvec2(m_DepthSize));
@@ -961,9 +927,9 @@ namespace MR
                     m_Reconstructor.OnNewFrame(m_DepthTexture, nullptr, &m_PoseMatrix, m_DepthIntrinsics.m_FocalLength, m_DepthIntrinsics.m_FocalPoint);
                 }
             }
-            else if (MessageType == COLORFRAME && m_CaptureColor)
+            else if (MessageType == CSLAMStreamParser::COLORFRAME && m_CaptureColor)
             {
-                ExtractRGBAFrame(Decompressed);
+                ExtractRGBAFrame(rMessage.m_ColorFrame);
 
                 SRegisteringBuffer BufferData;
                 BufferData.m_ColorIntrinsics = m_ColorIntrinsics;
@@ -1021,55 +987,31 @@ namespace MR
                     m_PoseMatrix = m_PreliminaryPoseMatrix;
                 }
             }
-            else if (MessageType == LIGHTESTIMATE)
+            else if (MessageType == CSLAMStreamParser::LIGHTESTIMATE)
             {
-                const float AmbientIntensity = *reinterpret_cast<float*>(Decompressed.data() + sizeof(int32_t));
-                const float LightTemperature = *reinterpret_cast<float*>(Decompressed.data() + sizeof(int32_t) + sizeof(float));
+                // -----------------------------------------------------------------------------
+                // The light estimate is not used yet
+                // -----------------------------------------------------------------------------
             }
-            else if (MessageType == PLANE)
+            else if (MessageType == CSLAMStreamParser::PLANE)
             {
-                int Offset = sizeof(int32_t);
+                const CSLAMStreamParser::SPlane& rPlane = rMessage.m_Plane;
 
-				std::string PlaneID(Decompressed.data() + Offset, Decompressed.data() + Offset + 16);
+                const std::string& PlaneID = rPlane.m_ID;
+                const int PlaneAction = rPlane.m_Action;
 
-				Offset += static_cast<int>(PlaneID.size());
-                int PlaneAction = *reinterpret_cast<int*>(Decompressed.data() + Offset);
+                glm::mat4 PlaneTransform = glm::eulerAngleX(glm::half_pi<float>()) * rPlane.m_Transform;
 
-                Offset += sizeof(PlaneAction);
-                glm::mat4 PlaneTransform = *reinterpret_cast<glm::mat4*>(Decompressed.data() + Offset);
+                auto PlaneExtent = glm::vec2(rPlane.m_Extent.x, rPlane.m_Extent.z);
 
-                Offset += sizeof(PlaneTransform);
-                glm::vec4 RawPlaneExtent = *reinterpret_cast<glm::vec4*>(Decompressed.data() + Offset);
-
-                Offset += sizeof(RawPlaneExtent);
-
-                PlaneTransform = glm::eulerAngleX(glm::half_pi<float>()) * PlaneTransform;
-
-                auto PlaneExtent = glm::vec2(RawPlaneExtent.x, RawPlaneExtent.z);
-
-                if (Offset < Decompressed.size()) // Is there additional data (a mesh)?
+                if (rPlane.m_pVertices != nullptr) // Is there additional data (a mesh)?
                 {
-                    int VertexCount = *reinterpret_cast<int*>(Decompressed.data() + Offset);
-
-                    Offset += sizeof(VertexCount);
-                    glm::vec4* pVertices = reinterpret_cast<glm::vec4*>(Decompressed.data() + Offset);
+                    const int VertexCount = rPlane.m_NumberOfVertices;
+                    const int IndexCount = rPlane.m_NumberOfIndices;
 
-                    Offset += VertexCount * sizeof(pVertices[0]);
-                    int UVCount = *reinterpret_cast<int*>(Decompressed.data() + Offset);
-
-                    Offset += sizeof(UVCount);
-                    glm::vec2* pUV = reinterpret_cast<glm::vec2*>(Decompressed.data() + Offset);
-
-                    Offset += UVCount * sizeof(pUV[0]);
-                    int IndexCount = *reinterpret_cast<int*>(Decompressed.data() + Offset);
-
-                    Offset += sizeof(IndexCount);
-                    uint16_t* pIndices = reinterpret_cast<uint16_t*>(Decompressed.data() + Offset);
-
-                    Offset += IndexCount * sizeof(pIndices[0]);
-
-                    assert(UVCount == VertexCount);
-                    assert(IndexCount % 3 == 0);
+                    const glm::vec4* pVertices = rPlane.m_pVertices;
+                    const glm::vec2* pUV = rPlane.m_pUVs;
+                    const uint16_t* pIndices = rPlane.m_pIndices;
 
                     std::vector<CSLAMReconstructor::SPlaneVertex> Vertices;
                     std::vector<uint32_t> Indices;
@@ -1091,13 +1033,13 @@ namespace MR
 
                     switch (PlaneAction)
                     {
-                    case ADDPLANE:
+                    case CSLAMStreamParser::ADDPLANE:
                         m_Reconstructor.AddPlaneWithMesh(PlaneTransform, Vertices, Indices, PlaneID);
                         break;
-                    case UPDATEPLANE:
+                    case CSLAMStreamParser::UPDATEPLANE:
                         m_Reconstructor.UpdatePlaneWithMesh(PlaneTransform, Vertices, Indices, PlaneID);
                         break;
-                    case REMOVEPLANE:
+                    case CSLAMStreamParser::REMOVEPLANE:
                         m_Reconstructor.RemovePlane(PlaneID);
                         break;
                     }
@@ -1106,13 +1048,13 @@ namespace MR
                 {
                     switch (PlaneAction)
                     {
-                    case ADDPLANE:
+                    case CSLAMStreamParser::ADDPLANE:
                         m_Reconstructor.AddPlane(PlaneTransform, PlaneExtent, PlaneID);
                         break;
-                    case UPDATEPLANE:
+                    case CSLAMStreamParser::UPDATEPLANE:
                         m_Reconstructor.UpdatePlane(PlaneTransform, PlaneExtent, PlaneID);
                         break;
-                    case REMOVEPLANE:
+                    case CSLAMStreamParser::REMOVEPLANE:
                         m_Reconstructor.RemovePlane(PlaneID);
                         break;
                     }
@@ -1124,18 +1066,15 @@ namespace MR
 
         // -----------------------------------------------------------------------------
 
-        void ExtractRGBAFrame(const std::vector<char>& _rData)
+        void ExtractRGBAFrame(const CSLAMStreamParser::SColorFrame& _rFrame)
         {
-            const int32_t Width = *reinterpret_cast<const int32_t*>(_rData.data() + sizeof(int32_t));
-            const int32_t Height = *reinterpret_cast<const int32_t*>(_rData.data() + 2 * sizeof(int32_t));
+            m_ColorIntrinsics.m_FocalLength = _rFrame.m_FocalLength;
+            m_ColorIntrinsics.m_FocalPoint = _rFrame.m_FocalPoint;
 
-            m_ColorIntrinsics.m_FocalLength = *reinterpret_cast<const glm::vec2*>(_rData.data() + 3 * sizeof(int32_t));
-            m_ColorIntrinsics.m_FocalPoint = *reinterpret_cast<const glm::vec2*>(_rData.data() + 3 * sizeof(int32_t) + sizeof(glm::vec2));
+            m_DeviceProjectionMatrix = _rFrame.m_ProjectionMatrix;
 
-            m_DeviceProjectionMatrix = *reinterpret_cast<const glm::mat4*>(_rData.data() + 7 * sizeof(int32_t));
-
-            const char* YData = _rData.data() + 7 * sizeof(int32_t) + sizeof(glm::mat4);
-            const char* UVData = YData + Width * Height;
+            const char* YData = _rFrame.m_pY;
+            const char* UVData = _rFrame.m_pUV;
 
             Base::AABB2UInt TargetRect;
             TargetRect = Base::AABB2UInt(glm::uvec2(0, 0), glm::uvec2(m_ColorSize.x, m_ColorSize.y));
@@ -1388,7 +1327,7 @@ namespace MR
 
                 ENGINE_CONSOLE_INFO("Received inpainted plane");
                 auto TargetRect = Base::AABB2UInt(glm::uvec2(Min, Min), glm::uvec2(Max, Max));
-                Gfx::TextureManager::CopyToTexture2D(m_PlaneTexture, TargetRect, ScaledResolution * 4, const_cast<char*>(_rMessage.m_Payload.data()), true);
+                Gfx::TextureManager::CopyToTexture2D(m_PlaneTexture, TargetRect, ScaledResolution * 4, const_cast<char*>(_rMessage.m_Payload.GetData()), true);
 
                 const auto& AABB = Gfx::ReconstructionRenderer::GetSelectionBox();
                 Gfx::ReconstructionRenderer::SetInpaintedPlane(m_PlaneTexture, AABB);
@@ -1417,16 +1356,18 @@ namespace MR
                     return;
                 }
 
+                std::vector<char> Payload(m_PlaneResolution * m_PlaneResolution * 4);
+
+                Gfx::TextureManager::CopyTextureToCPU(m_PlaneTexture, Payload.data());
+
                 Net::CMessage Message;
 
                 Message.m_Category = 0;
-                Message.m_Payload = std::vector<char>(m_PlaneResolution * m_PlaneResolution * 4);
-                Message.m_CompressedSize = Message.m_DecompressedSize = static_cast<int>(Message.m_Payload.size());
+                Message.m_CompressedSize = Message.m_DecompressedSize = static_cast<int>(Payload.size());
                 Message.m_MessageType = 0;
+                Message.m_Payload = std::move(Payload);
 
-                Gfx::TextureManager::CopyTextureToCPU(m_PlaneTexture, Message.m_Payload.data());
-
-                Net::CNetworkManager::GetInstance().SendMessage(m_NeuralNetworkSocket, Message);
+                Net::CNetworkManager::GetInstance().SendMessage(m_NeuralNetworkSocket, std::move(Message));
             }
             else if (m_InpaintingMode == INPAINTING_PIXMIX)
             {
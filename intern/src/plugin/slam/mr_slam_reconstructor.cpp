@@ -23,8 +23,10 @@
 #include "engine/graphic/gfx_texture_manager.h"
 #include "engine/graphic/gfx_view_manager.h"
 
+#include "plugin/slam/mr_mesh_extractor.h"
 #include "plugin/slam/mr_slam_reconstructor.h"
 
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <memory>
@@ -2008,6 +2010,42 @@ namespace MR
 
     // -----------------------------------------------------------------------------
 
+    void CSLAMReconstructor::ReadBricks(CMeshExtractor& _rExtractor)
+    {
+        assert(m_ReconstructionSettings.m_VoxelsPerGrid[2] == CMeshExtractor::s_VoxelsPerBrick);
+
+        ContextManager::Barrier();
+
+        CMeshExtractor::SVolume Volume;
+
+        Volume.m_pRootGridPool = static_cast<const char*>(BufferManager::MapBuffer(m_VolumeBuffers.m_RootGridPoolPtr, CBuffer::EMap::Read));
+        Volume.m_pLevel1Pool = static_cast<const char*>(BufferManager::MapBuffer(m_VolumeBuffers.m_Level1PoolPtr, CBuffer::EMap::Read));
+        Volume.m_pTSDFPool = static_cast<const char*>(BufferManager::MapBuffer(m_VolumeBuffers.m_TSDFPoolPtr, CBuffer::EMap::Read));
+        Volume.m_GridPoolItemSize = sizeof(SGridPoolItem);
+        Volume.m_RootResolution = m_ReconstructionSettings.m_GridResolutions[0];
+        Volume.m_Level1Resolution = m_ReconstructionSettings.m_GridResolutions[1];
+        Volume.m_CaptureColor = m_ReconstructionSettings.m_CaptureColor;
+        Volume.m_MaxWeight = static_cast<float>(m_ReconstructionSettings.m_MaxIntegrationWeight);
+
+        static_assert(sizeof(STSDFColorPoolItem) == 2 * sizeof(uint32_t) && sizeof(STSDFPoolItem) == sizeof(uint32_t), "Pool items do not match the extractor");
+
+        for (const auto& rPair : m_RootVolumeMap)
+        {
+            const SRootVolume& rRootVolume = rPair.second;
+
+            if (rRootVolume.m_PoolIndex != -1)
+            {
+                _rExtractor.SetBricks(Volume, rRootVolume.m_Offset, rRootVolume.m_PoolIndex);
+            }
+        }
+
+        BufferManager::UnmapBuffer(m_VolumeBuffers.m_TSDFPoolPtr);
+        BufferManager::UnmapBuffer(m_VolumeBuffers.m_Level1PoolPtr);
+        BufferManager::UnmapBuffer(m_VolumeBuffers.m_RootGridPoolPtr);
+    }
+
+    // -----------------------------------------------------------------------------
+
     CSLAMReconstructor::CSLAMReconstructor(const SReconstructionSettings* pReconstructionSettings)
     {
         ////////////////////////////////////////////////////////////////////////////////
@@ -20,6 +20,7 @@
 
 namespace MR
 {
+    class CMeshExtractor;
     class IRGBDCameraControl;
 
     struct IndexCompare
@@ -221,6 +222,8 @@ namespace MR
 
         Gfx::CTexturePtr CreatePlaneTexture(const Base::AABB3Float& _rAABB);
 
+        void ReadBricks(CMeshExtractor& _rExtractor);
+
     private:
 
         glm::vec4 GetHessianNormalForm(const glm::vec3& rA, const glm::vec3& rB, const glm::vec3& rC);
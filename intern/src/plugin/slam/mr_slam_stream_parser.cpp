@@ -0,0 +1,277 @@
+
+#include "plugin/slam/slam_precompiled.h"
+
+#include "plugin/slam/mr_slam_stream_parser.h"
+
+#include <cstring>
+
+namespace
+{
+    // -----------------------------------------------------------------------------
+    // The device writes every field at a multiple of four bytes, so the arrays
+    // returned as views are aligned as long as the payload starts aligned.
+    // -----------------------------------------------------------------------------
+    const Base::Size g_Alignment = alignof(int32_t);
+
+    static_assert(alignof(glm::vec4) <= g_Alignment && alignof(glm::vec2) <= g_Alignment, "The views need a stricter alignment than the stream");
+
+    // -----------------------------------------------------------------------------
+    // Larger payloads are rejected before the buffer is reserved
+    // -----------------------------------------------------------------------------
+    const int g_MaxDecompressedSize = 64 * 1024 * 1024;
+
+    // -----------------------------------------------------------------------------
+    // Structures like the intrinsics are copied out of the payload instead of
+    // being viewed, so they do not depend on its alignment
+    // -----------------------------------------------------------------------------
+    template<typename TValue>
+    TValue ReadValue(const char* _pData, Base::Size _Offset)
+    {
+        TValue Value;
+
+        std::memcpy(&Value, _pData + _Offset, sizeof(Value));
+
+        return Value;
+    }
+} // namespace
+
+namespace MR
+{
+    CSLAMStreamParser::CSLAMStreamParser()
+        : m_Decompressor     ()
+        , m_DecompressedBytes()
+    {
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CSLAMStreamParser::Parse(const Net::CMessage& _rMessage, SMessage& _rResult)
+    {
+        const char* pData = nullptr;
+        Base::Size NumberOfBytes = 0;
+
+        if (!Decompress(_rMessage, pData, NumberOfBytes)) return false;
+
+        return ParsePayload(pData, NumberOfBytes, _rResult);
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CSLAMStreamParser::Decompress(const Net::CMessage& _rMessage, const char*& _rpData, Base::Size& _rNumberOfBytes)
+    {
+        // -----------------------------------------------------------------------------
+        // Uncompressed messages are read directly from the payload
+        // -----------------------------------------------------------------------------
+        _rpData = _rMessage.m_Payload.GetData();
+        _rNumberOfBytes = _rMessage.m_Payload.GetNumberOfBytes();
+
+        if (_rMessage.m_CompressedSize == _rMessage.m_DecompressedSize)
+        {
+            if (reinterpret_cast<uintptr_t>(_rpData) % g_Alignment == 0) return true;
+
+            // -----------------------------------------------------------------------------
+            // A payload that is a slice of a larger buffer may start anywhere,
+            // so it is copied to keep the views aligned
+            // -----------------------------------------------------------------------------
+            m_DecompressedBytes.assign(_rpData, _rpData + _rNumberOfBytes);
+
+            _rpData = m_DecompressedBytes.data();
+
+            return true;
+        }
+
+        if (_rMessage.m_DecompressedSize <= 0 || _rMessage.m_DecompressedSize > g_MaxDecompressedSize) return false;
+
+        m_DecompressedBytes.reserve(_rMessage.m_DecompressedSize);
+
+        try
+        {
+            m_Decompressor.Decompress(_rpData, _rNumberOfBytes, m_DecompressedBytes);
+        }
+        catch (...)
+        {
+            return false;
+        }
+
+        _rpData = m_DecompressedBytes.data();
+        _rNumberOfBytes = m_DecompressedBytes.size();
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool CSLAMStreamParser::ParsePayload(const char* _pData, Base::Size _NumberOfBytes, SMessage& _rResult) const
+    {
+        const Base::Size SizeOfHeader = sizeof(int32_t);
+        const Base::Size SizeOfFrameHeader = 3 * sizeof(int32_t) + 2 * sizeof(glm::vec2);
+
+        if (_NumberOfBytes < SizeOfHeader) return false;
+
+        const int32_t Type = ReadValue<int32_t>(_pData, 0);
+
+        if (Type < COMMAND || Type > PLANE) return false;
+
+        _rResult.m_Type = static_cast<EMessageType>(Type);
+
+        switch (_rResult.m_Type)
+        {
+        case COMMAND:
+        {
+            if (_NumberOfBytes < 2 * sizeof(int32_t)) return false;
+
+            _rResult.m_CommandID = ReadValue<int32_t>(_pData, SizeOfHeader);
+
+            if (_rResult.m_CommandID == 1)
+            {
+                if (_NumberOfBytes < 2 * sizeof(int32_t) + sizeof(SIntrinsicsMessage)) return false;
+
+                _rResult.m_Intrinsics = ReadValue<SIntrinsicsMessage>(_pData, 2 * sizeof(int32_t));
+            }
+            else if (_rResult.m_CommandID == 2)
+            {
+                if (_NumberOfBytes < 2 * sizeof(int32_t) + sizeof(glm::ivec2)) return false;
+
+                _rResult.m_ColorSize = ReadValue<glm::ivec2>(_pData, 2 * sizeof(int32_t));
+            }
+
+            return true;
+        }
+
+        case TRANSFORM:
+        {
+            if (_NumberOfBytes < SizeOfHeader + sizeof(glm::mat4)) return false;
+
+            _rResult.m_Transform = ReadValue<glm::mat4>(_pData, SizeOfHeader);
+
+            return true;
+        }
+
+        case DEPTHFRAME:
+        {
+            if (_NumberOfBytes < SizeOfFrameHeader) return false;
+
+            SDepthFrame& rFrame = _rResult.m_DepthFrame;
+
+            rFrame.m_Size.x        = ReadValue<int32_t>(_pData, SizeOfHeader);
+            rFrame.m_Size.y        = ReadValue<int32_t>(_pData, 2 * sizeof(int32_t));
+            rFrame.m_FocalLength   = ReadValue<glm::vec2>(_pData, 3 * sizeof(int32_t));
+            rFrame.m_FocalPoint    = ReadValue<glm::vec2>(_pData, 3 * sizeof(int32_t) + sizeof(glm::vec2));
+            rFrame.m_pPixels       = reinterpret_cast<const uint16_t*>(_pData + SizeOfFrameHeader);
+
+            if (rFrame.m_Size.x <= 0 || rFrame.m_Size.y <= 0) return false;
+
+            const Base::Size NumberOfPixels = static_cast<Base::Size>(rFrame.m_Size.x) * rFrame.m_Size.y;
+
+            return _NumberOfBytes >= SizeOfFrameHeader + NumberOfPixels * sizeof(uint16_t);
+        }
+
+        case COLORFRAME:
+        {
+            if (_NumberOfBytes < SizeOfFrameHeader + sizeof(glm::mat4)) return false;
+
+            SColorFrame& rFrame = _rResult.m_ColorFrame;
+
+            rFrame.m_Size.x           = ReadValue<int32_t>(_pData, SizeOfHeader);
+            rFrame.m_Size.y           = ReadValue<int32_t>(_pData, 2 * sizeof(int32_t));
+            rFrame.m_FocalLength      = ReadValue<glm::vec2>(_pData, 3 * sizeof(int32_t));
+            rFrame.m_FocalPoint       = ReadValue<glm::vec2>(_pData, 3 * sizeof(int32_t) + sizeof(glm::vec2));
+            rFrame.m_ProjectionMatrix = ReadValue<glm::mat4>(_pData, SizeOfFrameHeader);
+
+            if (rFrame.m_Size.x <= 0 || rFrame.m_Size.y <= 0) return false;
+
+            const Base::Size NumberOfPixels = static_cast<Base::Size>(rFrame.m_Size.x) * rFrame.m_Size.y;
+
+            rFrame.m_pY  = _pData + SizeOfFrameHeader + sizeof(glm::mat4);
+            rFrame.m_pUV = rFrame.m_pY + NumberOfPixels;
+
+            return _NumberOfBytes >= SizeOfFrameHeader + sizeof(glm::mat4) + NumberOfPixels + NumberOfPixels / 2;
+        }
+
+        case LIGHTESTIMATE:
+        {
+            if (_NumberOfBytes < SizeOfHeader + 2 * sizeof(float)) return false;
+
+            _rResult.m_AmbientIntensity = ReadValue<float>(_pData, SizeOfHeader);
+            _rResult.m_LightTemperature = ReadValue<float>(_pData, SizeOfHeader + sizeof(float));
+
+            return true;
+        }
+
+        case PLANE:
+        {
+            const Base::Size SizeOfID = 16;
+
+            SPlane& rPlane = _rResult.m_Plane;
+
+            Base::Size Offset = SizeOfHeader;
+
+            if (_NumberOfBytes < Offset + SizeOfID + sizeof(int32_t) + sizeof(glm::mat4) + sizeof(glm::vec4)) return false;
+
+            rPlane.m_ID.assign(_pData + Offset, SizeOfID);
+
+            Offset += SizeOfID;
+            rPlane.m_Action = ReadValue<int32_t>(_pData, Offset);
+
+            Offset += sizeof(int32_t);
+            rPlane.m_Transform = ReadValue<glm::mat4>(_pData, Offset);
+
+            Offset += sizeof(glm::mat4);
+            rPlane.m_Extent = ReadValue<glm::vec4>(_pData, Offset);
+
+            Offset += sizeof(glm::vec4);
+
+            rPlane.m_NumberOfVertices = 0;
+            rPlane.m_pVertices        = nullptr;
+            rPlane.m_pUVs             = nullptr;
+            rPlane.m_NumberOfIndices  = 0;
+            rPlane.m_pIndices         = nullptr;
+
+            if (Offset == _NumberOfBytes) return true;
+
+            // -----------------------------------------------------------------------------
+            // Additional data is a mesh with one UV per vertex
+            // -----------------------------------------------------------------------------
+            if (_NumberOfBytes < Offset + sizeof(int32_t)) return false;
+
+            const int NumberOfVertices = ReadValue<int32_t>(_pData, Offset);
+
+            if (NumberOfVertices < 0) return false;
+
+            Offset += sizeof(int32_t);
+            rPlane.m_pVertices = reinterpret_cast<const glm::vec4*>(_pData + Offset);
+
+            Offset += NumberOfVertices * sizeof(glm::vec4);
+
+            if (_NumberOfBytes < Offset + sizeof(int32_t)) return false;
+
+            if (ReadValue<int32_t>(_pData, Offset) != NumberOfVertices) return false;
+
+            Offset += sizeof(int32_t);
+            rPlane.m_pUVs = reinterpret_cast<const glm::vec2*>(_pData + Offset);
+
+            Offset += NumberOfVertices * sizeof(glm::vec2);
+
+            if (_NumberOfBytes < Offset + sizeof(int32_t)) return false;
+
+            const int NumberOfIndices = ReadValue<int32_t>(_pData, Offset);
+
+            if (NumberOfIndices < 0 || NumberOfIndices % 3 != 0) return false;
+
+            Offset += sizeof(int32_t);
+            rPlane.m_pIndices = reinterpret_cast<const uint16_t*>(_pData + Offset);
+
+            Offset += NumberOfIndices * sizeof(uint16_t);
+
+            if (_NumberOfBytes < Offset) return false;
+
+            rPlane.m_NumberOfVertices = NumberOfVertices;
+            rPlane.m_NumberOfIndices  = NumberOfIndices;
+
+            return true;
+        }
+        }
+
+        return false;
+    }
+} // namespace MR
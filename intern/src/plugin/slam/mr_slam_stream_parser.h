@@ -0,0 +1,130 @@
+
+#pragma once
+
+#include "base/base_compression.h"
+#include "base/base_include_glm.h"
+#include "base/base_typedef.h"
+
+#include "engine/network/core_network_common.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace MR
+{
+    // -----------------------------------------------------------------------------
+    // CPU side of the SLAM stream: payloads are decompressed into a buffer that
+    // is reused for every message and parsed into views of the frames. The
+    // views point into the payload or the buffer and stay valid until the next
+    // message. Nothing here touches the GPU, so the stream can be decoded
+    // without a context (e.g. by the replay benchmark).
+    // -----------------------------------------------------------------------------
+    class CSLAMStreamParser
+    {
+    public:
+
+        enum EMessageType
+        {
+            COMMAND,
+            TRANSFORM,
+            DEPTHFRAME,
+            COLORFRAME,
+            LIGHTESTIMATE,
+            PLANE
+        };
+
+        enum EPlaneAction
+        {
+            ADDPLANE,
+            UPDATEPLANE,
+            REMOVEPLANE
+        };
+
+        struct SIntrinsicsMessage
+        {
+            glm::vec2  m_FocalLength;
+            glm::vec2  m_FocalPoint;
+            glm::ivec2 m_DepthSize;
+            glm::ivec2 m_ColorSize;
+            glm::ivec2 m_DeviceResolution;
+            glm::mat4  m_DeviceProjectionMatrix;
+            glm::mat4  m_RelativeCameraTransform;
+        };
+
+        struct SDepthFrame
+        {
+            glm::ivec2      m_Size;
+            glm::vec2       m_FocalLength;
+            glm::vec2       m_FocalPoint;
+            const uint16_t* m_pPixels;
+        };
+
+        // -----------------------------------------------------------------------------
+        // Color arrives as YUV 4:2:0 with a full resolution Y and an
+        // interleaved UV plane of half the resolution.
+        // -----------------------------------------------------------------------------
+        struct SColorFrame
+        {
+            glm::ivec2  m_Size;
+            glm::vec2   m_FocalLength;
+            glm::vec2   m_FocalPoint;
+            glm::mat4   m_ProjectionMatrix;
+            const char* m_pY;
+            const char* m_pUV;
+        };
+
+        struct SPlane
+        {
+            std::string      m_ID;
+            int              m_Action;
+            glm::mat4        m_Transform;
+            glm::vec4        m_Extent;
+            int              m_NumberOfVertices;            //< Zero if the plane has no mesh
+            const glm::vec4* m_pVertices;
+            const glm::vec2* m_pUVs;
+            int              m_NumberOfIndices;
+            const uint16_t*  m_pIndices;
+        };
+
+        struct SMessage
+        {
+            EMessageType       m_Type;
+            int                m_CommandID;
+            SIntrinsicsMessage m_Intrinsics;                //< Command 1
+            glm::ivec2         m_ColorSize;                 //< Command 2
+            glm::mat4          m_Transform;
+            SDepthFrame        m_DepthFrame;
+            SColorFrame        m_ColorFrame;
+            float              m_AmbientIntensity;
+            float              m_LightTemperature;
+            SPlane             m_Plane;
+        };
+
+    public:
+
+        CSLAMStreamParser();
+
+    public:
+
+        // -----------------------------------------------------------------------------
+        // Returns false for payloads that cannot be decompressed, announce an
+        // implausible size or are too short for their type. The arrays of the
+        // frames and planes can be read as typed arrays because payloads that
+        // do not start aligned are copied first. The message is reused, so the ID of a plane
+        // keeps its memory.
+        // -----------------------------------------------------------------------------
+        bool Parse(const Net::CMessage& _rMessage, SMessage& _rResult);
+
+        // -----------------------------------------------------------------------------
+        // Both steps of Parse on their own, so they can be timed separately
+        // -----------------------------------------------------------------------------
+        bool Decompress(const Net::CMessage& _rMessage, const char*& _rpData, Base::Size& _rNumberOfBytes);
+        bool ParsePayload(const char* _pData, Base::Size _NumberOfBytes, SMessage& _rResult) const;
+
+    private:
+
+        Base::CDecompressor m_Decompressor;
+        std::vector<char> m_DecompressedBytes;
+    };
+} // namespace MR
@@ -0,0 +1,208 @@
+
+#include "test_precompiled.h"
+
+#include "base/base_test_defines.h"
+
+#include "base/base_compression.h"
+#include "base/base_exception.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+    std::vector<char> CreateNoise(Base::Size _NumberOfBytes, int _Seed)
+    {
+        std::vector<char> Noise(_NumberOfBytes);
+
+        std::mt19937 Generator(_Seed);
+
+        for (char& rByte : Noise) rByte = static_cast<char>(Generator());
+
+        return Noise;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    std::vector<char> CreateRamp(Base::Size _NumberOfBytes)
+    {
+        std::vector<char> Ramp(_NumberOfBytes);
+
+        for (Base::Size IndexOfByte = 0; IndexOfByte < _NumberOfBytes; ++ IndexOfByte)
+        {
+            Ramp[IndexOfByte] = static_cast<char>(IndexOfByte / 64);
+        }
+
+        return Ramp;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool Throws(const std::vector<char>& _rCompressed)
+    {
+        try
+        {
+            std::vector<char> Decompressed;
+
+            Base::Decompress(_rCompressed, Decompressed);
+        }
+        catch (const Base::CException&)
+        {
+            return true;
+        }
+
+        return false;
+    }
+} // namespace
+
+BASE_TEST(Test_Base_Compression_RoundTrip)
+{
+    const std::vector<char> Ramp  = CreateRamp(1 << 20);
+    const std::vector<char> Noise = CreateNoise(100000, 1);
+
+    // -----------------------------------------------------------------------------
+    // Neither output has to be presized, incompressible data grows
+    // -----------------------------------------------------------------------------
+    for (int Level = 0; Level < 4; ++ Level)
+    {
+        std::vector<char> Compressed;
+        std::vector<char> Decompressed;
+
+        Base::Compress(Ramp, Compressed, Level);
+        Base::Decompress(Compressed, Decompressed);
+
+        BASE_CHECK(Decompressed == Ramp);
+
+        Base::Compress(Noise, Compressed, Level);
+        Base::Decompress(Compressed, Decompressed);
+
+        BASE_CHECK(Compressed.size() > Noise.size());
+        BASE_CHECK(Decompressed == Noise);
+    }
+
+    // -----------------------------------------------------------------------------
+    // A presized output is a hint only
+    // -----------------------------------------------------------------------------
+    std::vector<char> Compressed;
+
+    Base::Compress(Ramp, Compressed, 1);
+
+    BASE_CHECK(Compressed.size() < Ramp.size() / 10);
+
+    std::vector<char> TooSmall(10);
+    std::vector<char> TooLarge(Ramp.size() * 2);
+
+    Base::Decompress(Compressed, TooSmall);
+    Base::Decompress(Compressed, TooLarge);
+
+    BASE_CHECK(TooSmall == Ramp);
+    BASE_CHECK(TooLarge == Ramp);
+
+    // -----------------------------------------------------------------------------
+    // Empty data is a valid stream
+    // -----------------------------------------------------------------------------
+    std::vector<char> Empty;
+
+    Base::Compress(std::vector<char>(), Compressed, 1);
+    Base::Decompress(Compressed, Empty);
+
+    BASE_CHECK(!Compressed.empty() && Empty.empty());
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Base_Compression_Stream)
+{
+    const std::vector<char> Ramp = CreateRamp(300000);
+
+    // -----------------------------------------------------------------------------
+    // Chunks of any size are fed one after another
+    // -----------------------------------------------------------------------------
+    Base::CCompressor Compressor(1);
+
+    std::vector<char> Compressed;
+
+    for (Base::Size Offset = 0; Offset < Ramp.size(); Offset += 7777)
+    {
+        Compressor.Write(Ramp.data() + Offset, std::min<Base::Size>(7777, Ramp.size() - Offset), Compressed);
+    }
+
+    Compressor.Finish(Compressed);
+
+    Base::CDecompressor Decompressor;
+
+    std::vector<char> Decompressed;
+
+    bool IsComplete = false;
+
+    for (Base::Size Offset = 0; Offset < Compressed.size(); Offset += 13)
+    {
+        BASE_CHECK(!IsComplete);
+
+        IsComplete = Decompressor.Write(Compressed.data() + Offset, std::min<Base::Size>(13, Compressed.size() - Offset), Decompressed);
+    }
+
+    BASE_CHECK(IsComplete);
+    BASE_CHECK(Decompressed == Ramp);
+
+    // -----------------------------------------------------------------------------
+    // Both contexts are reused for the next stream
+    // -----------------------------------------------------------------------------
+    const std::vector<char> Noise = CreateNoise(50000, 2);
+
+    std::vector<char> NextCompressed;
+
+    Compressor.Compress(Noise.data(), Noise.size(), NextCompressed);
+
+    Decompressor.Decompress(NextCompressed.data(), NextCompressed.size(), Decompressed);
+
+    BASE_CHECK(Decompressed == Noise);
+
+    // -----------------------------------------------------------------------------
+    // Truncated or corrupt data throws instead of returning garbage
+    // -----------------------------------------------------------------------------
+    std::vector<char> Truncated(Compressed.begin(), Compressed.begin() + Compressed.size() / 2);
+    std::vector<char> Corrupt = Compressed;
+
+    Corrupt[Corrupt.size() / 2] ^= 0x55;
+    Corrupt[Corrupt.size() / 2 + 1] ^= 0x55;
+
+    BASE_CHECK(Throws(Truncated));
+    BASE_CHECK(Throws(Corrupt));
+    BASE_CHECK(Throws(Noise));
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Base_Compression_Parallel)
+{
+    const std::vector<char> Ramp = CreateRamp(5 * 1024 * 1024 + 123);
+
+    // -----------------------------------------------------------------------------
+    // The blocks are members of one gzip stream
+    // -----------------------------------------------------------------------------
+    std::vector<char> Compressed;
+    std::vector<char> Decompressed;
+
+    Base::CompressParallel(Ramp.data(), Ramp.size(), Compressed, 1, 1024 * 1024);
+
+    Base::Decompress(Compressed, Decompressed);
+
+    BASE_CHECK(Decompressed == Ramp);
+
+    std::vector<char> Sequential;
+
+    Base::Compress(Ramp, Sequential, 1);
+
+    BASE_CHECK(Compressed.size() < Sequential.size() * 2);
+
+    // -----------------------------------------------------------------------------
+    // Small data is one block
+    // -----------------------------------------------------------------------------
+    Base::CompressParallel(Ramp.data(), 1000, Compressed, 1, 1024 * 1024);
+
+    Base::Decompress(Compressed, Decompressed);
+
+    BASE_CHECK(Decompressed == std::vector<char>(Ramp.begin(), Ramp.begin() + 1000));
+}
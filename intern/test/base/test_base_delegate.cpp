@@ -0,0 +1,243 @@
+
+#include "test_precompiled.h"
+
+#include "base/base_test_defines.h"
+
+#include "base/base_delegate.h"
+
+#include <array>
+#include <vector>
+
+namespace
+{
+    using CIntDelegate = Base::CDelegate<int>;
+
+    // -----------------------------------------------------------------------------
+    // Registers the given number of listeners and notifies them repeatedly.
+    // -----------------------------------------------------------------------------
+    class CNotifyBenchmark
+    {
+    public:
+
+        static const int s_NumberOfNotifies = 100000;
+
+    public:
+
+        CNotifyBenchmark(int _NumberOfListeners)
+            : m_Sum(0)
+        {
+            for (int IndexOfListener = 0; IndexOfListener < _NumberOfListeners; ++IndexOfListener)
+            {
+                m_Handles.push_back(m_Delegate.Register([this, IndexOfListener](int _Value) { m_Sum += _Value + IndexOfListener; }));
+            }
+        }
+
+        long long Run()
+        {
+            for (int IndexOfNotify = 0; IndexOfNotify < s_NumberOfNotifies; ++IndexOfNotify)
+            {
+                m_Delegate.Notify(IndexOfNotify & 1);
+            }
+
+            return m_Sum;
+        }
+
+    private:
+
+        CIntDelegate m_Delegate;
+        std::vector<CIntDelegate::HandleType> m_Handles;
+        long long m_Sum;
+    };
+} // namespace
+
+BASE_TEST(Test_Delegate_Notify)
+{
+    CIntDelegate Delegate;
+
+    int Sum = 0;
+
+    CIntDelegate::HandleType FirstHandle  = Delegate.Register([&](int _Value) { Sum += _Value; });
+    CIntDelegate::HandleType SecondHandle = Delegate.Register([&](int _Value) { Sum += 10 * _Value; });
+
+    Delegate.Notify(1);
+
+    BASE_CHECK(Sum == 11);
+    BASE_CHECK(Delegate.GetNumberOfListeners() == 2);
+
+    // -----------------------------------------------------------------------------
+    // Releasing a handle removes its listener
+    // -----------------------------------------------------------------------------
+    FirstHandle = nullptr;
+
+    Delegate.Notify(1);
+
+    BASE_CHECK(Sum == 21);
+    BASE_CHECK(Delegate.GetNumberOfListeners() == 1);
+
+    // -----------------------------------------------------------------------------
+    // Copies of a handle keep the listener alive
+    // -----------------------------------------------------------------------------
+    CIntDelegate::HandleType CopyOfHandle = SecondHandle;
+
+    SecondHandle = nullptr;
+
+    Delegate.Notify(1);
+
+    BASE_CHECK(Sum == 31);
+
+    CopyOfHandle = nullptr;
+
+    Delegate.Notify(1);
+
+    BASE_CHECK(Sum == 31);
+    BASE_CHECK(Delegate.GetNumberOfListeners() == 0);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Delegate_Reentrancy)
+{
+    CIntDelegate Delegate;
+
+    int NumberOfCalls = 0;
+
+    CIntDelegate::HandleType LateHandle;
+    CIntDelegate::HandleType SelfHandle;
+
+    // -----------------------------------------------------------------------------
+    // A listener that releases itself and registers a new one while notified
+    // -----------------------------------------------------------------------------
+    SelfHandle = Delegate.Register([&](int)
+    {
+        ++NumberOfCalls;
+
+        SelfHandle = nullptr;
+
+        LateHandle = Delegate.Register([&](int _Value)
+        {
+            NumberOfCalls += 100;
+
+            if (_Value > 0) Delegate.Notify(_Value - 1);
+        });
+    });
+
+    Delegate.Notify(1);
+
+    BASE_CHECK(NumberOfCalls == 1);
+    BASE_CHECK(Delegate.GetNumberOfListeners() == 1);
+
+    // -----------------------------------------------------------------------------
+    // Nested notifications reach the new listener exactly once per level
+    // -----------------------------------------------------------------------------
+    Delegate.Notify(2);
+
+    BASE_CHECK(NumberOfCalls == 301);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Delegate_Lifetime)
+{
+    CIntDelegate::HandleType Handle;
+
+    {
+        CIntDelegate Delegate;
+
+        Handle = Delegate.Register([](int) {});
+    }
+
+    // -----------------------------------------------------------------------------
+    // Handles may outlive their delegate
+    // -----------------------------------------------------------------------------
+    Handle = nullptr;
+
+    BASE_CHECK(Handle == nullptr);
+
+    // -----------------------------------------------------------------------------
+    // Functors that do not fit into the inline buffer are stored on the heap
+    // -----------------------------------------------------------------------------
+    CIntDelegate Delegate;
+
+    std::array<int, 64> Values = { };
+
+    int Sum = 0;
+
+    Handle = Delegate.Register([Values, &Sum](int _Value) { Sum += _Value + Values[0]; });
+
+    CIntDelegate::FunctionType Function([&Sum](int _Value) { Sum += _Value; });
+    CIntDelegate::FunctionType CopyOfFunction = Function;
+
+    CIntDelegate::HandleType SecondHandle = Delegate.Register(CopyOfFunction);
+
+    Delegate.Notify(2);
+
+    BASE_CHECK(Sum == 4);
+    BASE_CHECK(static_cast<bool>(Function));
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Delegate_Timing)
+{
+    long long Sum = 0;
+
+    {
+        CNotifyBenchmark Benchmark(1);
+
+        BASE_TIME_RESET();
+
+        Sum += Benchmark.Run();
+
+        BASE_TIME_LOG(Notify_100k_1_Listener);
+    }
+
+    {
+        CNotifyBenchmark Benchmark(4);
+
+        BASE_TIME_RESET();
+
+        Sum += Benchmark.Run();
+
+        BASE_TIME_LOG(Notify_100k_4_Listeners);
+    }
+
+    {
+        CNotifyBenchmark Benchmark(16);
+
+        BASE_TIME_RESET();
+
+        Sum += Benchmark.Run();
+
+        BASE_TIME_LOG(Notify_100k_16_Listeners);
+    }
+
+    {
+        CNotifyBenchmark Benchmark(64);
+
+        BASE_TIME_RESET();
+
+        Sum += Benchmark.Run();
+
+        BASE_TIME_LOG(Notify_100k_64_Listeners);
+    }
+
+    // -----------------------------------------------------------------------------
+    // Listeners coming and going between notifications
+    // -----------------------------------------------------------------------------
+    CIntDelegate Delegate;
+
+    std::vector<CIntDelegate::HandleType> Handles(64);
+
+    BASE_TIME_RESET();
+
+    for (int IndexOfNotify = 0; IndexOfNotify < CNotifyBenchmark::s_NumberOfNotifies; ++IndexOfNotify)
+    {
+        Handles[IndexOfNotify % Handles.size()] = Delegate.Register([&Sum](int _Value) { Sum += _Value; });
+
+        Delegate.Notify(1);
+    }
+
+    BASE_TIME_LOG(Notify_100k_With_Churn);
+
+    BASE_CHECK(Sum > 0);
+}
@@ -4,6 +4,11 @@
 #include "base/base_test_defines.h"
 
 #include "base/base_memory.h"
+#include "base/base_memory_arena.h"
+#include "base/base_pool.h"
+
+#include <cstdint>
+#include <thread>
 
 BASE_TEST(Test_Memory_Timing)
 {
@@ -43,4 +48,145 @@ BASE_TEST(Test_Memory_Timing)
     memcpy(pMemCopyBytes, pBytes, NumberOfBytes);
     
     BASE_TIME_LOG(Memcpy);
-}
\ No newline at end of file
+}
+
+BASE_TEST(Test_Memory_Tags)
+{
+    const Base::CMemory::SStatistics Before = Base::CMemory::GetStatistics(Base::CMemory::General);
+
+    void* pChunk1 = Base::CMemory::Allocate(100, Base::CMemory::General);
+    void* pChunk2 = Base::CMemory::Allocate(300, Base::CMemory::General);
+
+    BASE_CHECK(reinterpret_cast<std::uintptr_t>(pChunk1) % Base::CMemory::s_Alignment == 0);
+
+    Base::CMemory::SStatistics Statistics = Base::CMemory::GetStatistics(Base::CMemory::General);
+
+    BASE_CHECK(Statistics.m_NumberOfBytes == Before.m_NumberOfBytes + 400);
+    BASE_CHECK(Statistics.m_NumberOfAllocations == Before.m_NumberOfAllocations + 2);
+    BASE_CHECK(Statistics.m_NumberOfLiveAllocations == Before.m_NumberOfLiveAllocations + 2);
+    BASE_CHECK(Statistics.m_PeakNumberOfBytes >= Before.m_NumberOfBytes + 400);
+
+    Base::CMemory::Free(pChunk1, Base::CMemory::General);
+    Base::CMemory::Free(pChunk2, Base::CMemory::General);
+
+    Statistics = Base::CMemory::GetStatistics(Base::CMemory::General);
+
+    BASE_CHECK(Statistics.m_NumberOfBytes == Before.m_NumberOfBytes);
+    BASE_CHECK(Statistics.m_NumberOfLiveAllocations == Before.m_NumberOfLiveAllocations);
+
+    // -----------------------------------------------------------------------------
+    // Pages of pools are accounted
+    // -----------------------------------------------------------------------------
+    {
+        Base::CPool<int> Pool;
+
+        Pool.Allocate();
+
+        BASE_CHECK(Base::CMemory::GetStatistics(Base::CMemory::Pool).m_NumberOfLiveAllocations >= 2);
+    }
+
+    BASE_CHECK(Base::CMemory::GetStatistics(Base::CMemory::Pool).m_NumberOfBytes == 0);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Memory_Arena)
+{
+    Base::CMemoryArena Arena(1024, Base::CMemory::Frame);
+
+    BASE_CHECK(Arena.GetCapacity() == 0);
+
+    char* pBytes = static_cast<char*>(Arena.Allocate(3, 1));
+    float* pFloats = Arena.AllocateArray<float>(16);
+
+    BASE_CHECK(reinterpret_cast<std::uintptr_t>(pFloats) % Base::CMemory::s_Alignment == 0);
+    BASE_CHECK(pBytes + 3 <= reinterpret_cast<char*>(pFloats));
+    BASE_CHECK(Arena.GetCapacity() == 1024);
+
+    // -----------------------------------------------------------------------------
+    // Markers release everything behind them
+    // -----------------------------------------------------------------------------
+    Base::CMemoryArena::SMarker Marker = Arena.GetMarker();
+
+    void* pChunk = Arena.Allocate(100);
+
+    Arena.Reset(Marker);
+
+    BASE_CHECK(Arena.Allocate(100) == pChunk);
+
+    // -----------------------------------------------------------------------------
+    // Overflowing blocks are merged on reset
+    // -----------------------------------------------------------------------------
+    for (int IndexOfChunk = 0; IndexOfChunk < 10; ++IndexOfChunk)
+    {
+        Arena.Allocate(500);
+    }
+
+    void* pLargeChunk = Arena.Allocate(4096);
+
+    BASE_CHECK(pLargeChunk != nullptr);
+    BASE_CHECK(Arena.GetCapacity() > 4096);
+    BASE_CHECK(Arena.GetPeakNumberOfBytes() >= 9096);
+
+    const Base::Size Capacity = Arena.GetCapacity();
+
+    Arena.Reset();
+
+    BASE_CHECK(Arena.GetNumberOfBytes() == 0);
+    BASE_CHECK(Arena.GetCapacity() == Capacity);
+
+    const Base::Size NumberOfAllocations = Base::CMemory::GetStatistics(Base::CMemory::Frame).m_NumberOfAllocations;
+
+    for (int IndexOfChunk = 0; IndexOfChunk < 10; ++IndexOfChunk)
+    {
+        Arena.Allocate(500);
+    }
+
+    Arena.Allocate(4096);
+
+    BASE_CHECK(Base::CMemory::GetStatistics(Base::CMemory::Frame).m_NumberOfAllocations == NumberOfAllocations);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Memory_Scratch)
+{
+    void* pOuterChunk;
+    void* pInnerChunk;
+
+    {
+        Base::CScratchScope Scratch;
+
+        pOuterChunk = Scratch.Allocate(64);
+
+        {
+            Base::CScratchScope InnerScratch;
+
+            pInnerChunk = InnerScratch.AllocateArray<int>(1000);
+        }
+
+        BASE_CHECK(Scratch.Allocate(64) == pInnerChunk);
+    }
+
+    {
+        Base::CScratchScope Scratch;
+
+        BASE_CHECK(Scratch.Allocate(64) == pOuterChunk);
+    }
+
+    // -----------------------------------------------------------------------------
+    // Every thread has its own scratch memory
+    // -----------------------------------------------------------------------------
+    void* pOtherChunk = nullptr;
+
+    std::thread Thread([&pOtherChunk]()
+    {
+        Base::CScratchScope Scratch;
+
+        pOtherChunk = Scratch.Allocate(64);
+    });
+
+    Thread.join();
+
+    BASE_CHECK(pOtherChunk != nullptr && pOtherChunk != pOuterChunk);
+}
@@ -11,6 +11,9 @@
 #include "base/base_serialize_binary_writer.h"
 #include "base/base_type_info.h"
 
+#include <limits>
+#include <random>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -655,4 +658,163 @@ BASE_TEST(SerializeInterfaceWithText)
     // -----------------------------------------------------------------------------
     delete pBaseCompexClassATest;
     delete pBaseCompexClassBTest;
-}
\ No newline at end of file
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(SerializeNumbersWithText)
+{
+    // -----------------------------------------------------------------------------
+    // Values that were written exactly with the default stream precision
+    // have to produce the same text as before.
+    // -----------------------------------------------------------------------------
+    const float StreamValues[] = { 0.0f, -0.0f, 1.0f, -7.0f, 0.5f, 100.0f, 0.0001f, 2.5e-5f, 13.37f, 123456.0f, 1.0e8f, 1.0e20f };
+
+    for (float Value : StreamValues)
+    {
+        std::stringstream Stream;
+
+        {
+            Base::CTextWriter Writer(Stream, 1);
+
+            Writer << Value;
+        }
+
+        std::ostringstream Reference;
+
+        Reference << "Version 1\r" << Value << "\r";
+
+        BASE_CHECK(Stream.str() == Reference.str());
+    }
+
+    // -----------------------------------------------------------------------------
+    // Everything else has to read back to the same value.
+    // -----------------------------------------------------------------------------
+    std::mt19937 Generator(13);
+
+    std::uniform_real_distribution<double> Distribution(-1.0e6, 1.0e6);
+
+    std::vector<float>  Floats;
+    std::vector<double> Doubles;
+
+    for (int IndexOfValue = 0; IndexOfValue < 1000; ++IndexOfValue)
+    {
+        Floats .push_back(static_cast<float>(Distribution(Generator)));
+        Doubles.push_back(Distribution(Generator) * 1.0e-9);
+    }
+
+    Floats .push_back(std::numeric_limits<float>::max());
+    Floats .push_back(std::numeric_limits<float>::denorm_min());
+    Doubles.push_back(std::numeric_limits<double>::max());
+
+    const long long          Signed   = std::numeric_limits<long long>::min();
+    const unsigned long long Unsigned = std::numeric_limits<unsigned long long>::max();
+
+    std::stringstream Stream;
+
+    {
+        Base::CTextWriter Writer(Stream, 1);
+
+        Writer << Signed;
+        Writer << Unsigned;
+
+        Writer.WritePrimitives(Floats.data(), static_cast<unsigned int>(Floats.size()));
+
+        Base::Serialize(Writer, Doubles);
+    }
+
+    long long          SignedTest;
+    unsigned long long UnsignedTest;
+
+    std::vector<float>  FloatsTest(Floats.size());
+    std::vector<double> DoublesTest;
+
+    Base::CTextReader Reader(Stream, 1);
+
+    Reader >> SignedTest;
+    Reader >> UnsignedTest;
+
+    Reader.ReadPrimitives(FloatsTest.data(), static_cast<unsigned int>(FloatsTest.size()));
+
+    Base::Serialize(Reader, DoublesTest);
+
+    BASE_CHECK(Signed == SignedTest);
+    BASE_CHECK(Unsigned == UnsignedTest);
+    BASE_CHECK(Floats == FloatsTest);
+    BASE_CHECK(Doubles == DoublesTest);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(SerializeTextPerformance)
+{
+    // -----------------------------------------------------------------------------
+    // Roughly the number of floats of a large scene (positions, rotations,
+    // scales and material values of some ten thousand entities)
+    // -----------------------------------------------------------------------------
+    const unsigned int NumberOfValues = 1000000;
+
+    std::mt19937 Generator(17);
+
+    std::uniform_real_distribution<float> Distribution(-1000.0f, 1000.0f);
+
+    std::vector<float> Values(NumberOfValues);
+
+    for (float& rValue : Values) rValue = Distribution(Generator);
+
+    std::stringstream Stream;
+
+    BASE_TIME_RESET();
+
+    {
+        Base::CTextWriter Writer(Stream, 1);
+
+        Writer.WritePrimitives(Values.data(), NumberOfValues);
+    }
+
+    BASE_TIME_LOG(Write_1000000_Floats);
+
+    const std::string Text = Stream.str();
+
+    // -----------------------------------------------------------------------------
+    // Reference: every value parsed by the stream as the reader did before
+    // -----------------------------------------------------------------------------
+    std::vector<float> ValuesTest(NumberOfValues);
+
+    BASE_TIME_RESET();
+
+    {
+        std::istringstream iStream(Text);
+
+        unsigned int Version;
+
+        iStream.ignore(strlen("Version "));
+
+        iStream >> Version;
+
+        iStream.ignore(1);
+
+        for (float& rValue : ValuesTest)
+        {
+            iStream >> rValue;
+
+            iStream.ignore(1);
+        }
+    }
+
+    BASE_TIME_LOG(Parse_1000000_Floats_Stream);
+
+    BASE_TIME_RESET();
+
+    {
+        std::istringstream iStream(Text);
+
+        Base::CTextReader Reader(iStream, 1);
+
+        Reader.ReadPrimitives(ValuesTest.data(), NumberOfValues);
+    }
+
+    BASE_TIME_LOG(Parse_1000000_Floats_Reader);
+
+    BASE_CHECK(Values == ValuesTest);
+}
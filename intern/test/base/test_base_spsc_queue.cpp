@@ -0,0 +1,93 @@
+
+#include "test_precompiled.h"
+
+#include "base/base_spsc_queue.h"
+#include "base/base_test_defines.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+BASE_TEST(Test_Base_SPSCQueue_Bounded)
+{
+    Base::CSPSCQueue<std::unique_ptr<int>> Queue(5);
+
+    BASE_CHECK(Queue.GetCapacity() == 8);
+    BASE_CHECK(Queue.IsEmpty());
+
+    // -----------------------------------------------------------------------------
+    // A full queue leaves the item with the caller
+    // -----------------------------------------------------------------------------
+    for (int Index = 0; Index < 8; ++ Index)
+    {
+        std::unique_ptr<int> pItem(new int(Index));
+
+        BASE_CHECK(Queue.TryPush(pItem) && pItem == nullptr);
+    }
+
+    std::unique_ptr<int> pRefused(new int(8));
+
+    BASE_CHECK(!Queue.TryPush(pRefused) && pRefused != nullptr);
+    BASE_CHECK(Queue.GetSize() == 8);
+
+    // -----------------------------------------------------------------------------
+    // Items come out in order and the slots are reused
+    // -----------------------------------------------------------------------------
+    std::unique_ptr<int> pItem;
+
+    BASE_CHECK(Queue.TryPop(pItem) && *pItem == 0);
+    BASE_CHECK(Queue.TryPush(pRefused));
+
+    for (int Index = 1; Index < 9; ++ Index)
+    {
+        BASE_CHECK(Queue.TryPop(pItem) && *pItem == Index);
+    }
+
+    BASE_CHECK(!Queue.TryPop(pItem) && *pItem == 8);
+    BASE_CHECK(Queue.IsEmpty());
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Base_SPSCQueue_Threads)
+{
+    const int NumberOfItems = 200000;
+
+    Base::CSPSCQueue<std::vector<int>> Queue(64);
+
+    std::thread Producer([&]()
+    {
+        for (int Index = 0; Index < NumberOfItems; ++ Index)
+        {
+            std::vector<int> Item(3, Index);
+
+            while (!Queue.TryPush(Item)) std::this_thread::yield();
+        }
+    });
+
+    // -----------------------------------------------------------------------------
+    // Everything the producer wrote into an item is visible with the item
+    // -----------------------------------------------------------------------------
+    bool IsInOrder = true;
+
+    std::vector<int> Item;
+
+    for (int Index = 0; Index < NumberOfItems; )
+    {
+        if (!Queue.TryPop(Item))
+        {
+            std::this_thread::yield();
+
+            continue;
+        }
+
+        IsInOrder = IsInOrder && Item == std::vector<int>(3, Index);
+
+        ++ Index;
+    }
+
+    Producer.join();
+
+    BASE_CHECK(IsInOrder);
+    BASE_CHECK(Queue.IsEmpty());
+}
@@ -0,0 +1,237 @@
+
+#include "test_precompiled.h"
+
+#include "base/base_test_defines.h"
+
+#include "engine/core/core_console.h"
+
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct SReceivedEntries
+    {
+        std::mutex               m_Mutex;
+        std::vector<std::string> m_Entries;
+    };
+
+    // -----------------------------------------------------------------------------
+    // Delegates stay registered for the lifetime of the console, so the test
+    // keeps its entries in a shared object and quiet output in a temp file.
+    // -----------------------------------------------------------------------------
+    std::shared_ptr<SReceivedEntries> GetReceivedEntries()
+    {
+        static std::shared_ptr<SReceivedEntries> s_EntriesPtr;
+
+        if (s_EntriesPtr == nullptr)
+        {
+            s_EntriesPtr = std::make_shared<SReceivedEntries>();
+
+            std::shared_ptr<SReceivedEntries> EntriesPtr = s_EntriesPtr;
+
+            Core::CConsole::GetInstance().RegisterHandler([EntriesPtr](Core::CConsole::EConsoleLevel, const std::string _Entry)
+            {
+                std::lock_guard<std::mutex> Lock(EntriesPtr->m_Mutex);
+
+                EntriesPtr->m_Entries.push_back(_Entry);
+            });
+
+            static FILE* s_pFile = tmpfile();
+
+            if (s_pFile != nullptr) Core::CConsole::GetInstance().SetOutputFile(s_pFile);
+        }
+
+        return s_EntriesPtr;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    std::vector<std::string> TakeReceivedEntries()
+    {
+        Core::CConsole::GetInstance().Flush();
+        Core::CConsole::GetInstance().Update();
+
+        std::shared_ptr<SReceivedEntries> EntriesPtr = GetReceivedEntries();
+
+        std::lock_guard<std::mutex> Lock(EntriesPtr->m_Mutex);
+
+        std::vector<std::string> Entries;
+
+        std::swap(Entries, EntriesPtr->m_Entries);
+
+        return Entries;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    int CountEvaluation(int& _rNumberOfEvaluations)
+    {
+        return ++_rNumberOfEvaluations;
+    }
+} // namespace
+
+BASE_TEST(Test_Console_DeferredFormatting)
+{
+    TakeReceivedEntries();
+
+    Core::CConsole::GetInstance().SetVerbosityLevel(4);
+
+    // -----------------------------------------------------------------------------
+    // Arguments are stored and formatted by the flusher
+    // -----------------------------------------------------------------------------
+    std::string Temporary = "temporary";
+
+    ENGINE_CONSOLE_INFOV("%i|%5.2f|%s|%c|%llu|%zu|100%%", -7, 3.14159, Temporary.c_str(), 'x', 1ull << 40, static_cast<size_t>(12));
+
+    Temporary = "overwritten";
+
+    ENGINE_CONSOLE_WARNING("Plain % text");
+    ENGINE_CONSOLE_STREAMERROR("Stream " << 42 << " " << 0.5f);
+    ENGINE_CONSOLE_DEBUGV("Width %*i", 4, 2);
+
+    std::vector<std::string> Entries = TakeReceivedEntries();
+
+    BASE_CHECK(Entries.size() == 4);
+
+    if (Entries.size() == 4)
+    {
+        BASE_CHECK(Entries[0] == "-7| 3.14|temporary|x|1099511627776|12|100%");
+        BASE_CHECK(Entries[1] == "Plain % text");
+        BASE_CHECK(Entries[2] == "Stream 42 0.5");
+        BASE_CHECK(Entries[3] == "Width    2");
+    }
+
+    // -----------------------------------------------------------------------------
+    // Filtered levels do not evaluate their arguments
+    // -----------------------------------------------------------------------------
+    Core::CConsole::GetInstance().SetVerbosityLevel(1);
+
+    int NumberOfEvaluations = 0;
+
+    ENGINE_CONSOLE_INFOV("%i", CountEvaluation(NumberOfEvaluations));
+    ENGINE_CONSOLE_ERRORV("%i", CountEvaluation(NumberOfEvaluations));
+
+    BASE_CHECK(NumberOfEvaluations == 1);
+    BASE_CHECK(TakeReceivedEntries().size() == 1);
+
+    Core::CConsole::GetInstance().SetVerbosityLevel(3);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Console_RateLimit)
+{
+    TakeReceivedEntries();
+
+    Core::CConsole::GetInstance().SetVerbosityLevel(4);
+    Core::CConsole::GetInstance().SetMaxEntriesPerSecond(10);
+
+    for (int IndexOfEntry = 0; IndexOfEntry < 1000; ++IndexOfEntry)
+    {
+        ENGINE_CONSOLE_DEBUGV("Burst %i", IndexOfEntry);
+    }
+
+    std::vector<std::string> Entries = TakeReceivedEntries();
+
+    // -----------------------------------------------------------------------------
+    // At most two windows if the loop crossed a second
+    // -----------------------------------------------------------------------------
+    BASE_CHECK(Entries.size() >= 10 && Entries.size() <= 21);
+
+    Core::CConsole::GetInstance().SetMaxEntriesPerSecond(Core::CConsole::s_DefaultMaxEntriesPerSecond);
+    Core::CConsole::GetInstance().SetVerbosityLevel(3);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Console_Threads)
+{
+    TakeReceivedEntries();
+
+    Core::CConsole::GetInstance().SetVerbosityLevel(4);
+    Core::CConsole::GetInstance().SetMaxEntriesPerSecond(0);
+
+    const int NumberOfThreads = 4;
+    const int NumberOfEntries = 10000;
+
+    std::vector<std::thread> Threads;
+
+    BASE_TIME_RESET();
+
+    for (int IndexOfThread = 0; IndexOfThread < NumberOfThreads; ++IndexOfThread)
+    {
+        Threads.push_back(std::thread([IndexOfThread, NumberOfEntries]()
+        {
+            for (int IndexOfEntry = 0; IndexOfEntry < NumberOfEntries; ++IndexOfEntry)
+            {
+                ENGINE_CONSOLE_DEBUGV("Thread %i entry %i value %f", IndexOfThread, IndexOfEntry, IndexOfEntry * 0.5);
+            }
+        }));
+    }
+
+    for (std::thread& rThread : Threads) rThread.join();
+
+    BASE_TIME_LOG(Log_40000_Entries_4_Threads);
+
+    // -----------------------------------------------------------------------------
+    // Entries may be dropped if the flusher falls behind, but the ones that
+    // arrive are complete and in order per thread.
+    // -----------------------------------------------------------------------------
+    std::vector<std::string> Entries = TakeReceivedEntries();
+
+    std::vector<int> LastEntries(NumberOfThreads, -1);
+
+    int  NumberOfReceivedEntries = 0;
+    bool IsOrdered               = true;
+
+    for (const std::string& rEntry : Entries)
+    {
+        int   IndexOfThread = -1;
+        int   IndexOfEntry  = -1;
+        float Value         = 0.0f;
+
+        if (sscanf(rEntry.c_str(), "Thread %i entry %i value %f", &IndexOfThread, &IndexOfEntry, &Value) != 3) continue;
+
+        IsOrdered &= IndexOfThread >= 0 && IndexOfThread < NumberOfThreads && IndexOfEntry > LastEntries[IndexOfThread];
+        IsOrdered &= Value == IndexOfEntry * 0.5f;
+
+        if (IndexOfThread >= 0 && IndexOfThread < NumberOfThreads) LastEntries[IndexOfThread] = IndexOfEntry;
+
+        ++NumberOfReceivedEntries;
+    }
+
+    BASE_CHECK(NumberOfReceivedEntries > 0);
+    BASE_CHECK(IsOrdered);
+
+    Core::CConsole::GetInstance().SetMaxEntriesPerSecond(Core::CConsole::s_DefaultMaxEntriesPerSecond);
+    Core::CConsole::GetInstance().SetVerbosityLevel(3);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Console_SynchronousErrors)
+{
+    TakeReceivedEntries();
+
+    // -----------------------------------------------------------------------------
+    // An error is written before the call returns, so Update() sees it
+    // without a flush.
+    // -----------------------------------------------------------------------------
+    ENGINE_CONSOLE_ERRORV("Error %i", 7);
+
+    Core::CConsole::GetInstance().Update();
+
+    std::shared_ptr<SReceivedEntries> EntriesPtr = GetReceivedEntries();
+
+    std::lock_guard<std::mutex> Lock(EntriesPtr->m_Mutex);
+
+    BASE_CHECK(EntriesPtr->m_Entries.size() == 1);
+    BASE_CHECK(!EntriesPtr->m_Entries.empty() && EntriesPtr->m_Entries.back() == "Error 7");
+
+    EntriesPtr->m_Entries.clear();
+}
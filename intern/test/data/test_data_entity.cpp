@@ -0,0 +1,130 @@
+
+#include "test_precompiled.h"
+
+#include "base/base_include_glm.h"
+#include "base/base_serialize_text_reader.h"
+#include "base/base_serialize_text_writer.h"
+#include "base/base_test_defines.h"
+
+#include "engine/data/data_entity.h"
+#include "engine/data/data_transformation_facet.h"
+
+#include <sstream>
+
+namespace
+{
+    class CTestEntity : public Dt::CEntity
+    {
+    public:
+
+        CTestEntity(BID _ID)
+        {
+            m_ID = _ID;
+
+            SetTransformationFacet(&m_TransformationFacet);
+        }
+
+       ~CTestEntity()
+        {
+            SetTransformationFacet(nullptr);
+        }
+
+    private:
+
+        Dt::CTransformationFacet m_TransformationFacet;
+    };
+
+    // -----------------------------------------------------------------------------
+    // The record the scene journal writes for a changed entity
+    // -----------------------------------------------------------------------------
+    void WriteRecord(Base::CTextWriter& _rWriter, Dt::CEntity& _rEntity)
+    {
+        _rWriter << _rEntity.GetID();
+
+        _rEntity.Write(_rWriter);
+
+        const bool HasTransformationFacet = _rEntity.GetTransformationFacet() != nullptr;
+
+        _rWriter << HasTransformationFacet;
+
+        if (HasTransformationFacet) _rWriter << *_rEntity.GetTransformationFacet();
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void ReadRecord(Base::CTextReader& _rReader, Dt::CEntity& _rEntity)
+    {
+        Dt::CEntity::BID ID = 0;
+
+        _rReader >> ID;
+
+        BASE_CHECK(ID == _rEntity.GetID());
+
+        _rEntity.Read(_rReader);
+
+        bool HasTransformationFacet = false;
+
+        _rReader >> HasTransformationFacet;
+
+        BASE_CHECK(HasTransformationFacet == (_rEntity.GetTransformationFacet() != nullptr));
+
+        if (HasTransformationFacet) _rReader >> *_rEntity.GetTransformationFacet();
+    }
+} // namespace
+
+BASE_TEST(Test_Data_Entity_JournalRecord)
+{
+    CTestEntity Original(42);
+    CTestEntity Edited(42);
+
+    for (CTestEntity* pEntity : { &Original, &Edited })
+    {
+        pEntity->SetName("Crate");
+        pEntity->SetActive(true);
+        pEntity->SetCategory(Dt::SEntityCategory::Static);
+        pEntity->SetLayer(Dt::SEntityLayer::Default);
+        pEntity->SetDynamic(false);
+        pEntity->SetSelectable(true);
+    }
+
+    // -----------------------------------------------------------------------------
+    // Every flag the inspector can toggle, plus the name and the transformation
+    // -----------------------------------------------------------------------------
+    Edited.SetName("Crate (broken)");
+    Edited.SetActive(false);
+    Edited.SetCategory(Dt::SEntityCategory::Dynamic);
+    Edited.SetLayer(Dt::SEntityLayer::AR | Dt::SEntityLayer::ShadowOnly);
+    Edited.SetDynamic(true);
+    Edited.SetSelectable(false);
+
+    Edited.GetTransformationFacet()->SetPosition(glm::vec3(1.0f, 2.0f, 3.0f));
+    Edited.GetTransformationFacet()->SetScale(glm::vec3(0.5f));
+
+    std::stringstream Stream;
+
+    {
+        Base::CTextWriter Writer(Stream, 1);
+
+        WriteRecord(Writer, Edited);
+    }
+
+    // -----------------------------------------------------------------------------
+    // Replaying onto the entity as it is in the scene file restores the edit
+    // -----------------------------------------------------------------------------
+    {
+        Base::CTextReader Reader(Stream, 1);
+
+        ReadRecord(Reader, Original);
+    }
+
+    BASE_CHECK(Original.GetID() == 42);
+    BASE_CHECK(Original.GetName() == "Crate (broken)");
+    BASE_CHECK(Original.IsActive() == false);
+    BASE_CHECK(Original.GetCategory() == Dt::SEntityCategory::Dynamic);
+    BASE_CHECK(Original.GetLayer() == (Dt::SEntityLayer::AR | Dt::SEntityLayer::ShadowOnly));
+    BASE_CHECK(Original.IsDynamic() == true);
+    BASE_CHECK(Original.IsSelectable() == false);
+
+    BASE_CHECK(Original.GetTransformationFacet()->GetPosition() == glm::vec3(1.0f, 2.0f, 3.0f));
+    BASE_CHECK(Original.GetTransformationFacet()->GetScale() == glm::vec3(0.5f));
+}
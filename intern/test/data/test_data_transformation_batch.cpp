@@ -0,0 +1,219 @@
+
+#include "test_precompiled.h"
+
+#include "base/base_test_defines.h"
+
+#include "engine/data/data_transformation_batch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+    struct STransformation
+    {
+        glm::vec3 m_Position;
+        glm::quat m_Rotation;
+        glm::vec3 m_Scale;
+        int       m_Parent;
+    };
+
+    // -----------------------------------------------------------------------------
+    // Tree with the given fan out per level; parents are always in front of
+    // their children.
+    // -----------------------------------------------------------------------------
+    std::vector<STransformation> CreateHierarchy(int _NumberOfLevels, int _FanOut, std::vector<int>& _rLevelBegins)
+    {
+        std::mt19937 Generator(7);
+
+        std::uniform_real_distribution<float> Position(-10.0f, 10.0f);
+        std::uniform_real_distribution<float> Angle   (-3.14f, 3.14f);
+        std::uniform_real_distribution<float> Scale   ( 0.5f ,  2.0f);
+
+        std::vector<STransformation> Transformations;
+
+        _rLevelBegins.clear();
+
+        int ParentBegin = 0;
+        int ParentEnd   = 0;
+
+        for (int IndexOfLevel = 0; IndexOfLevel < _NumberOfLevels; ++IndexOfLevel)
+        {
+            _rLevelBegins.push_back(static_cast<int>(Transformations.size()));
+
+            const int NumberOfParents = IndexOfLevel == 0 ? 1 : ParentEnd - ParentBegin;
+
+            for (int IndexOfParent = 0; IndexOfParent < NumberOfParents; ++IndexOfParent)
+            {
+                const int NumberOfChildren = IndexOfLevel == 0 ? 1 : _FanOut;
+
+                for (int IndexOfChild = 0; IndexOfChild < NumberOfChildren; ++IndexOfChild)
+                {
+                    STransformation Transformation;
+
+                    Transformation.m_Position = glm::vec3(Position(Generator), Position(Generator), Position(Generator));
+                    Transformation.m_Rotation = glm::angleAxis(Angle(Generator), glm::normalize(glm::vec3(Position(Generator), Position(Generator), Position(Generator)) + glm::vec3(0.0f, 0.0f, 20.0f)));
+                    Transformation.m_Scale    = glm::vec3(Scale(Generator), Scale(Generator), Scale(Generator));
+                    Transformation.m_Parent   = IndexOfLevel == 0 ? Dt::CTransformationBatch::s_NoParent : ParentBegin + IndexOfParent;
+
+                    Transformations.push_back(Transformation);
+                }
+            }
+
+            ParentBegin = _rLevelBegins.back();
+            ParentEnd   = static_cast<int>(Transformations.size());
+        }
+
+        return Transformations;
+    }
+
+    // -----------------------------------------------------------------------------
+    // One matrix after another as done by the entity manager before
+    // -----------------------------------------------------------------------------
+    void ComputeReference(const std::vector<STransformation>& _rTransformations, const glm::mat4& _rRootMatrix, std::vector<glm::mat4>& _rWorldMatrices)
+    {
+        _rWorldMatrices.resize(_rTransformations.size());
+
+        for (size_t IndexOfTransformation = 0; IndexOfTransformation < _rTransformations.size(); ++IndexOfTransformation)
+        {
+            const STransformation& rTransformation = _rTransformations[IndexOfTransformation];
+
+            glm::mat4 WorldMatrix = glm::toMat4(rTransformation.m_Rotation) * glm::scale(rTransformation.m_Scale);
+
+            WorldMatrix[3] = glm::vec4(rTransformation.m_Position, 1.0f);
+
+            const glm::mat4& rParentMatrix = rTransformation.m_Parent == Dt::CTransformationBatch::s_NoParent ? _rRootMatrix : _rWorldMatrices[rTransformation.m_Parent];
+
+            _rWorldMatrices[IndexOfTransformation] = rParentMatrix * WorldMatrix;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void FillBatch(Dt::CTransformationBatch& _rBatch, const std::vector<STransformation>& _rTransformations, const std::vector<int>& _rLevelBegins)
+    {
+        _rBatch.Clear();
+
+        size_t IndexOfLevel = 0;
+
+        for (size_t IndexOfTransformation = 0; IndexOfTransformation < _rTransformations.size(); ++IndexOfTransformation)
+        {
+            if (IndexOfLevel < _rLevelBegins.size() && _rLevelBegins[IndexOfLevel] == static_cast<int>(IndexOfTransformation))
+            {
+                _rBatch.BeginLevel();
+
+                ++IndexOfLevel;
+            }
+
+            const STransformation& rTransformation = _rTransformations[IndexOfTransformation];
+
+            _rBatch.AddTransformation(rTransformation.m_Position, rTransformation.m_Rotation, rTransformation.m_Scale, rTransformation.m_Parent);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool IsEqual(const glm::mat4& _rLeft, const glm::mat4& _rRight)
+    {
+        for (int IndexOfColumn = 0; IndexOfColumn < 4; ++IndexOfColumn)
+        {
+            for (int IndexOfRow = 0; IndexOfRow < 4; ++IndexOfRow)
+            {
+                const float Tolerance = 1.0e-4f * std::max(1.0f, std::abs(_rRight[IndexOfColumn][IndexOfRow]));
+
+                if (std::abs(_rLeft[IndexOfColumn][IndexOfRow] - _rRight[IndexOfColumn][IndexOfRow]) > Tolerance) return false;
+            }
+        }
+
+        return true;
+    }
+} // namespace
+
+BASE_TEST(Test_TransformationBatch_Reference)
+{
+    const glm::mat4 RootMatrix = glm::translate(glm::vec3(1.0f, 2.0f, 3.0f)) * glm::toMat4(glm::angleAxis(0.5f, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+    std::vector<int> LevelBegins;
+
+    std::vector<glm::mat4> ReferenceMatrices;
+
+    Dt::CTransformationBatch Batch;
+
+    // -----------------------------------------------------------------------------
+    // Small levels run on the calling thread and partly through the scalar
+    // tail, the wide hierarchy spreads its levels over the thread pool.
+    // -----------------------------------------------------------------------------
+    const int Shapes[][2] = { { 1, 1 }, { 3, 3 }, { 5, 2 }, { 4, 9 } };
+
+    for (const auto& rShape : Shapes)
+    {
+        std::vector<STransformation> Transformations = CreateHierarchy(rShape[0], rShape[1], LevelBegins);
+
+        ComputeReference(Transformations, RootMatrix, ReferenceMatrices);
+
+        FillBatch(Batch, Transformations, LevelBegins);
+
+        Batch.Update(RootMatrix);
+
+        BASE_CHECK(Batch.GetNumberOfTransformations() == static_cast<int>(Transformations.size()));
+        BASE_CHECK(Batch.GetNumberOfLevels() == rShape[0]);
+
+        bool IsEqualToReference = true;
+
+        for (int IndexOfTransformation = 0; IndexOfTransformation < Batch.GetNumberOfTransformations(); ++IndexOfTransformation)
+        {
+            IsEqualToReference &= IsEqual(Batch.GetWorldMatrix(IndexOfTransformation), ReferenceMatrices[IndexOfTransformation]);
+        }
+
+        BASE_CHECK(IsEqualToReference);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_TransformationBatch_Performance)
+{
+    std::vector<int> LevelBegins;
+
+    std::vector<STransformation> Transformations = CreateHierarchy(5, 12, LevelBegins);
+
+    std::vector<glm::mat4> ReferenceMatrices;
+
+    Dt::CTransformationBatch Batch;
+
+    const glm::mat4 RootMatrix(1.0f);
+
+    const int NumberOfIterations = 20;
+
+    BASE_TIME_RESET();
+
+    for (int Iteration = 0; Iteration < NumberOfIterations; ++Iteration)
+    {
+        ComputeReference(Transformations, RootMatrix, ReferenceMatrices);
+    }
+
+    BASE_TIME_LOG(Reference_20x_22621_Transformations);
+
+    BASE_TIME_RESET();
+
+    for (int Iteration = 0; Iteration < NumberOfIterations; ++Iteration)
+    {
+        FillBatch(Batch, Transformations, LevelBegins);
+
+        Batch.Update(RootMatrix);
+    }
+
+    BASE_TIME_LOG(Batch_20x_22621_Transformations);
+
+    bool IsEqualToReference = true;
+
+    for (int IndexOfTransformation = 0; IndexOfTransformation < Batch.GetNumberOfTransformations(); ++IndexOfTransformation)
+    {
+        IsEqualToReference &= IsEqual(Batch.GetWorldMatrix(IndexOfTransformation), ReferenceMatrices[IndexOfTransformation]);
+    }
+
+    BASE_CHECK(Batch.GetNumberOfTransformations() == 22621);
+    BASE_CHECK(IsEqualToReference);
+}
@@ -0,0 +1,80 @@
+
+#pragma once
+
+#include "base/base_include_glm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace Base
+{
+    // -----------------------------------------------------------------------------
+    // Closed sphere without seams for tests and benchmarks: an icosahedron
+    // with every triangle split into four for the given number of times.
+    // The vertices and indices are appended to the given ones.
+    // -----------------------------------------------------------------------------
+    inline void AddIcosphere(float _Radius, unsigned int _Refinement, std::vector<glm::vec3>& _rVertices, std::vector<unsigned int>& _rIndices)
+    {
+        const float T = (1.0f + std::sqrt(5.0f)) / 2.0f;
+
+        std::vector<glm::vec3> Vertices =
+        {
+            { -1.0f,  T, 0.0f }, { 1.0f,  T, 0.0f }, { -1.0f, -T, 0.0f }, { 1.0f, -T, 0.0f },
+            { 0.0f, -1.0f,  T }, { 0.0f, 1.0f,  T }, { 0.0f, -1.0f, -T }, { 0.0f, 1.0f, -T },
+            {  T, 0.0f, -1.0f }, {  T, 0.0f, 1.0f }, { -T, 0.0f, -1.0f }, { -T, 0.0f, 1.0f },
+        };
+
+        std::vector<unsigned int> Indices =
+        {
+            0, 11, 5,   0, 5, 1,    0, 1, 7,    0, 7, 10,   0, 10, 11,
+            1, 5, 9,    5, 11, 4,   11, 10, 2,  10, 7, 6,   7, 1, 8,
+            3, 9, 4,    3, 4, 2,    3, 2, 6,    3, 6, 8,    3, 8, 9,
+            4, 9, 5,    2, 4, 11,   6, 2, 10,   8, 6, 7,    9, 8, 1,
+        };
+
+        for (glm::vec3& rVertex : Vertices) rVertex = glm::normalize(rVertex);
+
+        for (unsigned int IndexOfRefinement = 0; IndexOfRefinement < _Refinement; ++IndexOfRefinement)
+        {
+            std::map<std::pair<unsigned int, unsigned int>, unsigned int> Midpoints;
+
+            auto GetMidpoint = [&](unsigned int _Index0, unsigned int _Index1)
+            {
+                const auto Key = std::make_pair(std::min(_Index0, _Index1), std::max(_Index0, _Index1));
+
+                auto Midpoint = Midpoints.find(Key);
+
+                if (Midpoint != Midpoints.end()) return Midpoint->second;
+
+                Vertices.push_back(glm::normalize(Vertices[_Index0] + Vertices[_Index1]));
+
+                return Midpoints[Key] = static_cast<unsigned int>(Vertices.size()) - 1;
+            };
+
+            std::vector<unsigned int> RefinedIndices;
+
+            for (size_t IndexOfIndex = 0; IndexOfIndex < Indices.size(); IndexOfIndex += 3)
+            {
+                const unsigned int A = Indices[IndexOfIndex + 0];
+                const unsigned int B = Indices[IndexOfIndex + 1];
+                const unsigned int C = Indices[IndexOfIndex + 2];
+
+                const unsigned int AB = GetMidpoint(A, B);
+                const unsigned int BC = GetMidpoint(B, C);
+                const unsigned int CA = GetMidpoint(C, A);
+
+                RefinedIndices.insert(RefinedIndices.end(), { A, AB, CA, B, BC, AB, C, CA, BC, AB, BC, CA });
+            }
+
+            Indices.swap(RefinedIndices);
+        }
+
+        const unsigned int FirstVertex = static_cast<unsigned int>(_rVertices.size());
+
+        for (const glm::vec3& rVertex : Vertices) _rVertices.push_back(rVertex * _Radius);
+        for (unsigned int Index : Indices) _rIndices.push_back(FirstVertex + Index);
+    }
+} // namespace Base
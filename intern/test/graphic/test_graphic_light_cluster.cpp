@@ -0,0 +1,202 @@
+
+#include "test_precompiled.h"
+
+#include "base/base_test_defines.h"
+
+#include "engine/graphic/gfx_light_cluster_binner.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+    const float g_Near = 0.1f;
+    const float g_Far  = 200.0f;
+
+    // -----------------------------------------------------------------------------
+    // Point and spot lights scattered over the view frustum (view space, the
+    // camera looks along -z).
+    // -----------------------------------------------------------------------------
+    std::vector<Gfx::CLightClusterBinner::SLight> CreateLights(int _NumberOfLights, unsigned int _Seed)
+    {
+        std::mt19937 Generator(_Seed);
+
+        std::uniform_real_distribution<float> Depth(1.0f, 120.0f);
+        std::uniform_real_distribution<float> Side(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> Radius(1.0f, 12.0f);
+        std::uniform_real_distribution<float> Angle(0.2f, 1.4f);
+
+        std::vector<Gfx::CLightClusterBinner::SLight> Lights(_NumberOfLights);
+
+        for (int IndexOfLight = 0; IndexOfLight < _NumberOfLights; ++IndexOfLight)
+        {
+            Gfx::CLightClusterBinner::SLight& rLight = Lights[IndexOfLight];
+
+            const float Z = Depth(Generator);
+
+            rLight.m_Position     = glm::vec3(Side(Generator) * Z, Side(Generator) * Z * 0.6f, -Z);
+            rLight.m_Radius       = Radius(Generator);
+            rLight.m_Direction    = glm::normalize(glm::vec3(Side(Generator), Side(Generator), Side(Generator)) + glm::vec3(0.0f, 0.0f, 0.01f));
+            rLight.m_CosHalfAngle = IndexOfLight % 2 == 0 ? -1.0f : std::cos(Angle(Generator));
+        }
+
+        return Lights;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool IsLit(const Gfx::CLightClusterBinner::SLight& _rLight, const glm::vec3& _rPosition)
+    {
+        const glm::vec3 LightVector = _rPosition - _rLight.m_Position;
+
+        const float Distance = glm::length(LightVector);
+
+        if (Distance > _rLight.m_Radius) return false;
+
+        if (_rLight.m_CosHalfAngle <= 0.0f || Distance == 0.0f) return true;
+
+        return glm::dot(LightVector / Distance, _rLight.m_Direction) >= _rLight.m_CosHalfAngle;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void BinAndLog(Gfx::CLightClusterBinner& _rBinner, const std::vector<Gfx::CLightClusterBinner::SLight>& _rLights)
+    {
+        // -----------------------------------------------------------------------------
+        // Warm up once so the lists have their capacity
+        // -----------------------------------------------------------------------------
+        _rBinner.Bin(_rLights.data(), static_cast<int>(_rLights.size()));
+
+        BASE_TIME_RESET();
+
+        for (int Frame = 0; Frame < 100; ++Frame)
+        {
+            _rBinner.Bin(_rLights.data(), static_cast<int>(_rLights.size()));
+        }
+    }
+} // namespace
+
+BASE_TEST(Test_LightCluster_Conservative)
+{
+    Gfx::CLightClusterBinner Binner;
+
+    Binner.SetProjection(glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, g_Near, g_Far), g_Near, g_Far);
+    Binner.SetMaxLightsPerCluster(1024);
+
+    const std::vector<Gfx::CLightClusterBinner::SLight> Lights = CreateLights(256, 7);
+
+    Binner.Bin(Lights.data(), static_cast<int>(Lights.size()));
+
+    const Gfx::CLightClusterBinner::CClusters&     rClusters     = Binner.GetClusters();
+    const Gfx::CLightClusterBinner::CLightIndices& rLightIndices = Binner.GetLightIndices();
+
+    BASE_CHECK(static_cast<int>(rClusters.size()) == Binner.GetNumberOfClusters());
+
+    // -----------------------------------------------------------------------------
+    // Every light that reaches a visible point has to be in its cluster
+    // -----------------------------------------------------------------------------
+    std::mt19937 Generator(13);
+
+    std::uniform_real_distribution<float> NDC(-0.999f, 0.999f);
+    std::uniform_real_distribution<float> Depth(g_Near, 150.0f);
+
+    const glm::mat4 InverseProjection = glm::inverse(glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, g_Near, g_Far));
+
+    int NumberOfMissingLights = 0;
+    int NumberOfLitPoints     = 0;
+
+    for (int IndexOfPoint = 0; IndexOfPoint < 20000; ++IndexOfPoint)
+    {
+        glm::vec4 Direction = InverseProjection * glm::vec4(NDC(Generator), NDC(Generator), 1.0f, 1.0f);
+
+        Direction /= Direction.w;
+
+        const glm::vec3 Position = glm::vec3(Direction) * (Depth(Generator) / -Direction.z);
+
+        const Gfx::CLightClusterBinner::SCluster& rCluster = rClusters[Binner.GetClusterIndex(Position)];
+
+        for (int IndexOfLight = 0; IndexOfLight < static_cast<int>(Lights.size()); ++IndexOfLight)
+        {
+            if (!IsLit(Lights[IndexOfLight], Position)) continue;
+
+            ++NumberOfLitPoints;
+
+            bool IsInCluster = false;
+
+            for (uint32_t Index = 0; Index < rCluster.m_NumberOfLights; ++Index)
+            {
+                IsInCluster |= rLightIndices[rCluster.m_Offset + Index] == static_cast<uint32_t>(IndexOfLight);
+            }
+
+            if (!IsInCluster) ++NumberOfMissingLights;
+        }
+    }
+
+    BASE_CHECK(NumberOfLitPoints > 0);
+    BASE_CHECK(NumberOfMissingLights == 0);
+
+    // -----------------------------------------------------------------------------
+    // The lists are sorted by light and the cap per cluster is respected
+    // -----------------------------------------------------------------------------
+    Binner.SetMaxLightsPerCluster(4);
+
+    Binner.Bin(Lights.data(), static_cast<int>(Lights.size()));
+
+    bool IsSortedAndCapped = true;
+
+    for (const Gfx::CLightClusterBinner::SCluster& rCluster : Binner.GetClusters())
+    {
+        IsSortedAndCapped &= rCluster.m_NumberOfLights <= 4;
+
+        for (uint32_t Index = 1; Index < rCluster.m_NumberOfLights; ++Index)
+        {
+            IsSortedAndCapped &= Binner.GetLightIndices()[rCluster.m_Offset + Index - 1] < Binner.GetLightIndices()[rCluster.m_Offset + Index];
+        }
+    }
+
+    BASE_CHECK(IsSortedAndCapped);
+
+    // -----------------------------------------------------------------------------
+    // Lights behind the camera touch no cluster
+    // -----------------------------------------------------------------------------
+    Gfx::CLightClusterBinner::SLight BehindLight = { glm::vec3(0.0f, 0.0f, 20.0f), 5.0f, glm::vec3(0.0f, 0.0f, -1.0f), -1.0f };
+
+    Binner.Bin(&BehindLight, 1);
+
+    BASE_CHECK(Binner.GetLightIndices().empty());
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_LightCluster_Timing)
+{
+    Gfx::CLightClusterBinner Binner;
+
+    Binner.SetProjection(glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, g_Near, g_Far), g_Near, g_Far);
+
+    {
+        std::vector<Gfx::CLightClusterBinner::SLight> Lights = CreateLights(64, 1);
+
+        BinAndLog(Binner, Lights);
+
+        BASE_TIME_LOG(Bin_100_Frames_64_Lights);
+    }
+
+    {
+        std::vector<Gfx::CLightClusterBinner::SLight> Lights = CreateLights(256, 2);
+
+        BinAndLog(Binner, Lights);
+
+        BASE_TIME_LOG(Bin_100_Frames_256_Lights);
+    }
+
+    {
+        std::vector<Gfx::CLightClusterBinner::SLight> Lights = CreateLights(1024, 3);
+
+        BinAndLog(Binner, Lights);
+
+        BASE_TIME_LOG(Bin_100_Frames_1024_Lights);
+    }
+
+    BASE_CHECK(Binner.GetLightIndices().size() > 0);
+}
@@ -0,0 +1,186 @@
+
+#include "test_precompiled.h"
+
+#include "graphic/test_graphic_icosphere.h"
+
+#include "base/base_include_glm.h"
+#include "base/base_test_defines.h"
+
+#include "engine/graphic/gfx_mesh_optimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using CTriangle = std::array<unsigned int, 3>;
+
+    // -----------------------------------------------------------------------------
+    // Like a scanned mesh: the triangles of the sphere in random order
+    // -----------------------------------------------------------------------------
+    void ShuffleTriangles(std::vector<unsigned int>& _rIndices)
+    {
+        std::vector<CTriangle> Triangles(_rIndices.size() / 3);
+
+        std::copy(_rIndices.begin(), _rIndices.end(), &Triangles[0][0]);
+
+        std::shuffle(Triangles.begin(), Triangles.end(), std::mt19937(11));
+
+        std::copy(&Triangles[0][0], &Triangles[0][0] + _rIndices.size(), _rIndices.begin());
+    }
+
+    // -----------------------------------------------------------------------------
+    // The same triangles in any order, each with the same winding
+    // -----------------------------------------------------------------------------
+    bool HasSameTriangles(const std::vector<unsigned int>& _rIndices, const std::vector<unsigned int>& _rOther)
+    {
+        auto GetTriangles = [](const std::vector<unsigned int>& _rIndices)
+        {
+            std::vector<CTriangle> Triangles;
+
+            for (size_t IndexOfIndex = 0; IndexOfIndex < _rIndices.size(); IndexOfIndex += 3)
+            {
+                CTriangle Triangle = { _rIndices[IndexOfIndex], _rIndices[IndexOfIndex + 1], _rIndices[IndexOfIndex + 2] };
+
+                std::rotate(Triangle.begin(), std::min_element(Triangle.begin(), Triangle.end()), Triangle.end());
+
+                Triangles.push_back(Triangle);
+            }
+
+            std::sort(Triangles.begin(), Triangles.end());
+
+            return Triangles;
+        };
+
+        return _rIndices.size() == _rOther.size() && GetTriangles(_rIndices) == GetTriangles(_rOther);
+    }
+} // namespace
+
+BASE_TEST(Test_Graphic_MeshOptimizer_VertexCache)
+{
+    std::vector<glm::vec3>    Vertices;
+    std::vector<unsigned int> Indices;
+
+    Base::AddIcosphere(1.0f, 4, Vertices, Indices);
+
+    ShuffleTriangles(Indices);
+
+    const unsigned int NumberOfVertices = static_cast<unsigned int>(Vertices.size());
+    const unsigned int NumberOfIndices  = static_cast<unsigned int>(Indices.size());
+
+    Gfx::CMeshOptimizer Optimizer;
+
+    // -----------------------------------------------------------------------------
+    // A single triangle loads all of its vertices once
+    // -----------------------------------------------------------------------------
+    const Gfx::CMeshOptimizer::SStatistics Triangle = Optimizer.AnalyzeVertexCache(Indices.data(), 3, NumberOfVertices);
+
+    BASE_CHECK(Triangle.m_ACMR == 3.0f && Triangle.m_ATVR == 1.0f);
+
+    // -----------------------------------------------------------------------------
+    // Random order misses almost every vertex, the optimized order gets
+    // close to the ~0.7 of a 16 entry FIFO with the same triangles.
+    // -----------------------------------------------------------------------------
+    const Gfx::CMeshOptimizer::SStatistics Before = Optimizer.AnalyzeVertexCache(Indices.data(), NumberOfIndices, NumberOfVertices);
+
+    std::vector<unsigned int> Result(NumberOfIndices);
+
+    Optimizer.OptimizeVertexCache(Indices.data(), NumberOfIndices, NumberOfVertices, Result.data());
+
+    const Gfx::CMeshOptimizer::SStatistics After = Optimizer.AnalyzeVertexCache(Result.data(), NumberOfIndices, NumberOfVertices);
+
+    BASE_CHECK(HasSameTriangles(Indices, Result));
+    BASE_CHECK(Before.m_ACMR > 2.5f && Before.m_ATVR > 5.0f);
+    BASE_CHECK(After.m_ACMR < 0.75f && After.m_ATVR < 1.5f);
+
+    // -----------------------------------------------------------------------------
+    // Deterministic and also in place
+    // -----------------------------------------------------------------------------
+    Optimizer.OptimizeVertexCache(Indices.data(), NumberOfIndices, NumberOfVertices, Indices.data());
+
+    BASE_CHECK(Indices == Result);
+
+    // -----------------------------------------------------------------------------
+    // Vertices are moved in the order of first use, so every index is at
+    // most one larger than the largest one in front of it.
+    // -----------------------------------------------------------------------------
+    Vertices.push_back(glm::vec3(2.0f));
+
+    std::vector<glm::vec3> FetchedVertices = Vertices;
+
+    const unsigned int NumberOfFetchedVertices = Optimizer.OptimizeVertexFetch(FetchedVertices.data(), NumberOfVertices + 1, sizeof(glm::vec3), Result.data(), NumberOfIndices);
+
+    BASE_CHECK(NumberOfFetchedVertices == NumberOfVertices);
+
+    unsigned int NextVertex = 0;
+
+    for (unsigned int IndexOfIndex = 0; IndexOfIndex < NumberOfIndices; ++IndexOfIndex)
+    {
+        BASE_CHECK(Result[IndexOfIndex] <= NextVertex);
+        BASE_CHECK(FetchedVertices[Result[IndexOfIndex]] == Vertices[Indices[IndexOfIndex]]);
+
+        NextVertex = std::max(NextVertex, Result[IndexOfIndex] + 1);
+    }
+
+    BASE_CHECK(Optimizer.AnalyzeVertexCache(Result.data(), NumberOfIndices, NumberOfFetchedVertices).m_ACMR == After.m_ACMR);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Graphic_MeshOptimizer_Overdraw)
+{
+    std::vector<glm::vec3>    Vertices;
+    std::vector<unsigned int> Indices;
+
+    // -----------------------------------------------------------------------------
+    // A small sphere inside of a large one: from outside the inner one is
+    // hidden, so the outer one should be drawn first.
+    // -----------------------------------------------------------------------------
+    Base::AddIcosphere(0.5f, 3, Vertices, Indices);
+    Base::AddIcosphere(1.0f, 3, Vertices, Indices);
+
+    const unsigned int NumberOfVertices      = static_cast<unsigned int>(Vertices.size());
+    const unsigned int NumberOfIndices       = static_cast<unsigned int>(Indices.size());
+    const unsigned int NumberOfInnerVertices = NumberOfVertices / 2;
+
+    Gfx::CMeshOptimizer Optimizer;
+
+    std::vector<unsigned int> Result(NumberOfIndices);
+
+    Optimizer.OptimizeVertexCache(Indices.data(), NumberOfIndices, NumberOfVertices, Indices.data());
+
+    const Gfx::CMeshOptimizer::SStatistics Before = Optimizer.AnalyzeVertexCache(Indices.data(), NumberOfIndices, NumberOfVertices);
+
+    Optimizer.OptimizeOverdraw(Indices.data(), NumberOfIndices, &Vertices[0].x, NumberOfVertices, sizeof(glm::vec3), 1.05f, Result.data());
+
+    const Gfx::CMeshOptimizer::SStatistics After = Optimizer.AnalyzeVertexCache(Result.data(), NumberOfIndices, NumberOfVertices);
+
+    BASE_CHECK(HasSameTriangles(Indices, Result));
+
+    // -----------------------------------------------------------------------------
+    // Clusters are drawn by how far out they face. Large clusters of the
+    // outer sphere face less in one direction than small ones of the inner
+    // sphere, so only most of the outer sphere comes first.
+    // -----------------------------------------------------------------------------
+    double SumOfInnerPositions = 0.0;
+    double SumOfOuterPositions = 0.0;
+
+    for (unsigned int IndexOfIndex = 0; IndexOfIndex < NumberOfIndices; ++IndexOfIndex)
+    {
+        const bool IsInner = Result[IndexOfIndex] < NumberOfInnerVertices;
+
+        BASE_CHECK(!IsInner || IndexOfIndex >= NumberOfIndices / 4);
+
+        (IsInner ? SumOfInnerPositions : SumOfOuterPositions) += IndexOfIndex;
+    }
+
+    BASE_CHECK(SumOfOuterPositions < 0.75 * SumOfInnerPositions);
+
+    // -----------------------------------------------------------------------------
+    // The clusters start from an empty cache, which costs a bit of the
+    // vertex cache optimization
+    // -----------------------------------------------------------------------------
+    BASE_CHECK(After.m_ACMR >= Before.m_ACMR && After.m_ACMR <= 1.1f * Before.m_ACMR);
+}
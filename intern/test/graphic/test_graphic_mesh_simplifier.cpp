@@ -0,0 +1,196 @@
+
+#include "test_precompiled.h"
+
+#include "graphic/test_graphic_icosphere.h"
+
+#include "base/base_include_glm.h"
+#include "base/base_test_defines.h"
+
+#include "engine/graphic/gfx_mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    const float g_SphereArea = 4.0f * 3.14159265f;
+
+    // -----------------------------------------------------------------------------
+    // Flat square of N x N quads in the XZ plane. With a seam the middle column
+    // of vertices exists twice, like a UV seam.
+    // -----------------------------------------------------------------------------
+    void CreateGrid(unsigned int _N, bool _HasSeam, std::vector<glm::vec3>& _rVertices, std::vector<unsigned int>& _rIndices)
+    {
+        const unsigned int Seam = _N / 2;
+
+        _rVertices.clear();
+        _rIndices.clear();
+
+        for (unsigned int Z = 0; Z <= _N; ++Z)
+        {
+            for (unsigned int X = 0; X <= _N; ++X)
+            {
+                _rVertices.push_back(glm::vec3(X, 0.0f, Z) / static_cast<float>(_N));
+            }
+        }
+
+        for (unsigned int Z = 0; Z <= _N && _HasSeam; ++Z)
+        {
+            _rVertices.push_back(glm::vec3(Seam, 0.0f, Z) / static_cast<float>(_N));
+        }
+
+        auto GetVertex = [&](unsigned int _X, unsigned int _Z, unsigned int _Quad)
+        {
+            if (_HasSeam && _X == Seam && _Quad >= Seam) return (_N + 1) * (_N + 1) + _Z;
+
+            return _Z * (_N + 1) + _X;
+        };
+
+        for (unsigned int Z = 0; Z < _N; ++Z)
+        {
+            for (unsigned int X = 0; X < _N; ++X)
+            {
+                const unsigned int V00 = GetVertex(X    , Z    , X);
+                const unsigned int V10 = GetVertex(X + 1, Z    , X);
+                const unsigned int V01 = GetVertex(X    , Z + 1, X);
+                const unsigned int V11 = GetVertex(X + 1, Z + 1, X);
+
+                _rIndices.insert(_rIndices.end(), { V00, V01, V11, V00, V11, V10 });
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+
+    float GetArea(const std::vector<glm::vec3>& _rVertices, const std::vector<unsigned int>& _rIndices, unsigned int _NumberOfIndices)
+    {
+        float Area = 0.0f;
+
+        for (unsigned int IndexOfIndex = 0; IndexOfIndex < _NumberOfIndices; IndexOfIndex += 3)
+        {
+            const glm::vec3& rA = _rVertices[_rIndices[IndexOfIndex + 0]];
+            const glm::vec3& rB = _rVertices[_rIndices[IndexOfIndex + 1]];
+            const glm::vec3& rC = _rVertices[_rIndices[IndexOfIndex + 2]];
+
+            Area += 0.5f * glm::length(glm::cross(rB - rA, rC - rA));
+        }
+
+        return Area;
+    }
+} // namespace
+
+BASE_TEST(Test_Graphic_MeshSimplifier_Sphere)
+{
+    std::vector<glm::vec3>    Vertices;
+    std::vector<unsigned int> Indices;
+
+    Base::AddIcosphere(1.0f, 4, Vertices, Indices);
+
+    const unsigned int NumberOfVertices = static_cast<unsigned int>(Vertices.size());
+    const unsigned int NumberOfIndices  = static_cast<unsigned int>(Indices.size());
+
+    Gfx::CMeshSimplifier Simplifier;
+
+    std::vector<unsigned int> Result(NumberOfIndices);
+
+    // -----------------------------------------------------------------------------
+    // A chain of LODs with a generous error reaches every triangle ratio. The
+    // error grows with every LOD and the surface of the coarser spheres stays
+    // inside of it: the center of a triangle is the point farthest away from
+    // the sphere.
+    // -----------------------------------------------------------------------------
+    const float Ratios[] = { 0.5f, 0.25f, 0.125f, 0.02f };
+
+    float LastError = 0.0f;
+
+    for (float Ratio : Ratios)
+    {
+        const unsigned int Target = static_cast<unsigned int>(NumberOfIndices * Ratio) / 3 * 3;
+
+        const Gfx::CMeshSimplifier::SResult LOD = Simplifier.Simplify(&Vertices[0].x, NumberOfVertices, sizeof(glm::vec3), Indices.data(), NumberOfIndices, Target, 1.0f, Result.data());
+
+        BASE_CHECK(LOD.m_NumberOfIndices <= Target && LOD.m_NumberOfIndices > Target * 9 / 10);
+        BASE_CHECK(LOD.m_NumberOfIndices % 3 == 0);
+        BASE_CHECK(LOD.m_Error >= LastError && LOD.m_Error < 0.2f);
+
+        float MaxDistance = 0.0f;
+
+        for (unsigned int IndexOfIndex = 0; IndexOfIndex < LOD.m_NumberOfIndices; IndexOfIndex += 3)
+        {
+            const glm::vec3 Center = (Vertices[Result[IndexOfIndex]] + Vertices[Result[IndexOfIndex + 1]] + Vertices[Result[IndexOfIndex + 2]]) / 3.0f;
+
+            MaxDistance = glm::max(MaxDistance, 1.0f - glm::length(Center));
+        }
+
+        BASE_CHECK(MaxDistance <= 1.25f * LOD.m_Error);
+
+        // -----------------------------------------------------------------------------
+        // The simplified sphere is still closed and keeps its surface
+        // -----------------------------------------------------------------------------
+        const float Area = GetArea(Vertices, Result, LOD.m_NumberOfIndices);
+
+        BASE_CHECK(Area > 0.9f * g_SphereArea && Area <= g_SphereArea);
+
+        LastError = LOD.m_Error;
+    }
+
+    // -----------------------------------------------------------------------------
+    // A tight error stops before the target and stays below the error
+    // -----------------------------------------------------------------------------
+    const Gfx::CMeshSimplifier::SResult Limited = Simplifier.Simplify(&Vertices[0].x, NumberOfVertices, sizeof(glm::vec3), Indices.data(), NumberOfIndices, 0, 0.01f, Result.data());
+
+    BASE_CHECK(Limited.m_NumberOfIndices > NumberOfIndices / 50 && Limited.m_NumberOfIndices < NumberOfIndices);
+    BASE_CHECK(Limited.m_Error <= 0.01f);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Graphic_MeshSimplifier_Borders)
+{
+    std::vector<glm::vec3>    Vertices;
+    std::vector<unsigned int> Indices;
+
+    Gfx::CMeshSimplifier Simplifier;
+
+    for (bool HasSeam : { false, true })
+    {
+        CreateGrid(16, HasSeam, Vertices, Indices);
+
+        const unsigned int NumberOfVertices = static_cast<unsigned int>(Vertices.size());
+        const unsigned int NumberOfIndices  = static_cast<unsigned int>(Indices.size());
+
+        std::vector<unsigned int> Result(NumberOfIndices);
+
+        // -----------------------------------------------------------------------------
+        // A flat square collapses without error while the open border keeps
+        // its corners, so the area does not change.
+        // -----------------------------------------------------------------------------
+        const Gfx::CMeshSimplifier::SResult LOD = Simplifier.Simplify(&Vertices[0].x, NumberOfVertices, sizeof(glm::vec3), Indices.data(), NumberOfIndices, 0, 1.0e-4f, Result.data());
+
+        BASE_CHECK(LOD.m_Error < 1.0e-4f);
+        BASE_CHECK(std::abs(GetArea(Vertices, Result, LOD.m_NumberOfIndices) - 1.0f) < 1.0e-4f);
+
+        // -----------------------------------------------------------------------------
+        // Vertices of the seam never move, so both sides keep all of them
+        // -----------------------------------------------------------------------------
+        if (HasSeam)
+        {
+            auto IsUsed = [&](unsigned int _Vertex)
+            {
+                return std::find(Result.begin(), Result.begin() + LOD.m_NumberOfIndices, _Vertex) != Result.begin() + LOD.m_NumberOfIndices;
+            };
+
+            for (unsigned int Z = 0; Z <= 16; ++Z)
+            {
+                BASE_CHECK(IsUsed(Z * 17 + 8) && IsUsed(17 * 17 + Z));
+            }
+
+            BASE_CHECK(LOD.m_NumberOfIndices < NumberOfIndices / 4);
+        }
+        else
+        {
+            BASE_CHECK(LOD.m_NumberOfIndices <= 6);
+        }
+    }
+}
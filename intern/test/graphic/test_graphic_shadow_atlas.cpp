@@ -0,0 +1,262 @@
+
+#include "test_precompiled.h"
+
+#include "base/base_test_defines.h"
+
+#include "engine/graphic/gfx_shadow_atlas_allocator.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+    const unsigned int g_AtlasSize   = 4096;
+    const unsigned int g_MinTileSize = 128;
+
+    // -----------------------------------------------------------------------------
+    // Every tile lies inside of the atlas, is aligned to its size and does not
+    // overlap any other tile.
+    // -----------------------------------------------------------------------------
+    bool AreTilesDisjoint(const Gfx::CShadowAtlasAllocator& _rAllocator, const std::vector<int>& _rTiles)
+    {
+        for (size_t IndexOfTile = 0; IndexOfTile < _rTiles.size(); ++IndexOfTile)
+        {
+            if (_rTiles[IndexOfTile] == Gfx::CShadowAtlasAllocator::s_InvalidTile) continue;
+
+            const Gfx::CShadowAtlasAllocator::STile Tile = _rAllocator.GetTile(_rTiles[IndexOfTile]);
+
+            if (Tile.m_Offset.x + Tile.m_Size > _rAllocator.GetSize() || Tile.m_Offset.y + Tile.m_Size > _rAllocator.GetSize()) return false;
+
+            if (Tile.m_Offset.x % Tile.m_Size != 0 || Tile.m_Offset.y % Tile.m_Size != 0) return false;
+
+            for (size_t IndexOfOther = IndexOfTile + 1; IndexOfOther < _rTiles.size(); ++IndexOfOther)
+            {
+                if (_rTiles[IndexOfOther] == Gfx::CShadowAtlasAllocator::s_InvalidTile) continue;
+
+                const Gfx::CShadowAtlasAllocator::STile Other = _rAllocator.GetTile(_rTiles[IndexOfOther]);
+
+                const bool IsSeparatedX = Tile.m_Offset.x + Tile.m_Size <= Other.m_Offset.x || Other.m_Offset.x + Other.m_Size <= Tile.m_Offset.x;
+                const bool IsSeparatedY = Tile.m_Offset.y + Tile.m_Size <= Other.m_Offset.y || Other.m_Offset.y + Other.m_Size <= Tile.m_Offset.y;
+
+                if (!IsSeparatedX && !IsSeparatedY) return false;
+            }
+        }
+
+        return true;
+    }
+} // namespace
+
+BASE_TEST(Test_ShadowAtlas_Allocate)
+{
+    Gfx::CShadowAtlasAllocator Allocator;
+
+    Allocator.Initialize(g_AtlasSize, g_MinTileSize);
+
+    // -----------------------------------------------------------------------------
+    // Mixed sizes
+    // -----------------------------------------------------------------------------
+    std::vector<int> Tiles;
+
+    const unsigned int Sizes[] = { 2048, 128, 1024, 512, 128, 256, 1024, 512, 128 };
+
+    for (unsigned int Size : Sizes)
+    {
+        Tiles.push_back(Allocator.Allocate(Size));
+
+        BASE_CHECK(Tiles.back() != Gfx::CShadowAtlasAllocator::s_InvalidTile);
+        BASE_CHECK(Allocator.GetTile(Tiles.back()).m_Size == Size);
+    }
+
+    BASE_CHECK(AreTilesDisjoint(Allocator, Tiles));
+
+    for (int Tile : Tiles) Allocator.Free(Tile);
+
+    BASE_CHECK(Allocator.GetNumberOfUsedTexels() == 0);
+
+    // -----------------------------------------------------------------------------
+    // A full atlas rejects further tiles; freeing merges back to the root
+    // -----------------------------------------------------------------------------
+    Tiles.clear();
+
+    for (int IndexOfTile = 0; IndexOfTile < 64; ++IndexOfTile)
+    {
+        Tiles.push_back(Allocator.Allocate(512));
+    }
+
+    BASE_CHECK(AreTilesDisjoint(Allocator, Tiles));
+    BASE_CHECK(Allocator.GetNumberOfUsedTexels() == static_cast<Base::U64>(g_AtlasSize) * g_AtlasSize);
+    BASE_CHECK(Allocator.Allocate(g_MinTileSize) == Gfx::CShadowAtlasAllocator::s_InvalidTile);
+
+    for (int Tile : Tiles) Allocator.Free(Tile);
+
+    const int RootTile = Allocator.Allocate(g_AtlasSize);
+
+    BASE_CHECK(RootTile != Gfx::CShadowAtlasAllocator::s_InvalidTile);
+    BASE_CHECK(Allocator.GetTile(RootTile).m_Offset == glm::uvec2(0));
+
+    Allocator.Free(RootTile);
+
+    // -----------------------------------------------------------------------------
+    // Unchanged sizes keep their tiles
+    // -----------------------------------------------------------------------------
+    unsigned int TileSizes[4] = { 1024, 512, 512, 256 };
+    int          TileIDs  [4] = { -1, -1, -1, -1 };
+
+    BASE_CHECK(Allocator.UpdateTiles(TileSizes, 4, TileIDs));
+
+    const int KeptTile = TileIDs[0];
+
+    TileSizes[1] = 1024;
+
+    BASE_CHECK(Allocator.UpdateTiles(TileSizes, 4, TileIDs));
+    BASE_CHECK(TileIDs[0] == KeptTile);
+    BASE_CHECK(AreTilesDisjoint(Allocator, std::vector<int>(TileIDs, TileIDs + 4)));
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_ShadowAtlas_SelectTileSizes)
+{
+    Gfx::CShadowAtlasAllocator Allocator;
+
+    Allocator.Initialize(g_AtlasSize, g_MinTileSize);
+
+    // -----------------------------------------------------------------------------
+    // Coverage decides the size; small changes keep the current size
+    // -----------------------------------------------------------------------------
+    Gfx::CShadowAtlasAllocator::SRequest Request = { 0.25f, 1.0f, 0 };
+
+    unsigned int Size = 0;
+
+    Allocator.SelectTileSizes(&Request, 1, 2048, ~0ull, &Size);
+
+    BASE_CHECK(Size == 512);
+
+    Request.m_CurrentSize = 512;
+    Request.m_Coverage    = 0.4f;
+
+    Allocator.SelectTileSizes(&Request, 1, 2048, ~0ull, &Size);
+
+    BASE_CHECK(Size == 512);
+
+    Request.m_Coverage = 0.5f;
+
+    Allocator.SelectTileSizes(&Request, 1, 2048, ~0ull, &Size);
+
+    BASE_CHECK(Size == 1024);
+
+    Request.m_CurrentSize = 1024;
+    Request.m_Coverage    = 0.3f;
+
+    Allocator.SelectTileSizes(&Request, 1, 2048, ~0ull, &Size);
+
+    BASE_CHECK(Size == 1024);
+
+    Request.m_Coverage = 0.001f;
+
+    Allocator.SelectTileSizes(&Request, 1, 2048, ~0ull, &Size);
+
+    BASE_CHECK(Size == g_MinTileSize);
+
+    // -----------------------------------------------------------------------------
+    // The budget is respected and bigger lights keep more texels
+    // -----------------------------------------------------------------------------
+    std::vector<Gfx::CShadowAtlasAllocator::SRequest> Requests;
+
+    for (int IndexOfRequest = 0; IndexOfRequest < 32; ++IndexOfRequest)
+    {
+        Requests.push_back({ 1.0f - IndexOfRequest / 32.0f, 1.0f, 0 });
+    }
+
+    std::vector<unsigned int> Sizes(Requests.size());
+
+    const Base::U64 Budget = static_cast<Base::U64>(g_AtlasSize) * g_AtlasSize;
+
+    Allocator.SelectTileSizes(Requests.data(), static_cast<int>(Requests.size()), 2048, Budget, Sizes.data());
+
+    Base::U64 NumberOfTexels = 0;
+
+    bool IsSorted = true;
+
+    for (size_t IndexOfRequest = 0; IndexOfRequest < Sizes.size(); ++IndexOfRequest)
+    {
+        NumberOfTexels += static_cast<Base::U64>(Sizes[IndexOfRequest]) * Sizes[IndexOfRequest];
+
+        if (IndexOfRequest > 0) IsSorted &= Sizes[IndexOfRequest] <= Sizes[IndexOfRequest - 1];
+    }
+
+    BASE_CHECK(NumberOfTexels <= Budget);
+    BASE_CHECK(IsSorted);
+    BASE_CHECK(Sizes[0] > g_MinTileSize);
+
+    std::vector<int> Tiles(Sizes.size(), Gfx::CShadowAtlasAllocator::s_InvalidTile);
+
+    BASE_CHECK(Allocator.UpdateTiles(Sizes.data(), static_cast<int>(Sizes.size()), Tiles.data()));
+    BASE_CHECK(AreTilesDisjoint(Allocator, Tiles));
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_ShadowAtlas_Packing)
+{
+    Gfx::CShadowAtlasAllocator Allocator;
+
+    Allocator.Initialize(g_AtlasSize, g_MinTileSize);
+
+    std::mt19937 Generator(11);
+
+    std::uniform_real_distribution<float> Coverage(0.0f, 1.0f);
+    std::uniform_real_distribution<float> Change(-0.02f, 0.02f);
+
+    const int NumberOfLights = 64;
+
+    const Base::U64 Budget = static_cast<Base::U64>(g_AtlasSize) * g_AtlasSize;
+
+    std::vector<Gfx::CShadowAtlasAllocator::SRequest> Requests(NumberOfLights);
+    std::vector<unsigned int>                        Sizes   (NumberOfLights, 0);
+    std::vector<int>                                 Tiles   (NumberOfLights, Gfx::CShadowAtlasAllocator::s_InvalidTile);
+
+    for (auto& rRequest : Requests) rRequest = { Coverage(Generator), 1.0f, 0 };
+
+    // -----------------------------------------------------------------------------
+    // Lights move a bit every frame; count how many tiles have to be rendered
+    // again because they were resized or moved.
+    // -----------------------------------------------------------------------------
+    int  NumberOfChangedTiles = 0;
+    bool HasAllTiles          = true;
+
+    std::vector<int> LastTiles;
+
+    BASE_TIME_RESET();
+
+    for (int Frame = 0; Frame < 1000; ++Frame)
+    {
+        for (int IndexOfLight = 0; IndexOfLight < NumberOfLights; ++IndexOfLight)
+        {
+            Requests[IndexOfLight].m_Coverage    = glm::clamp(Requests[IndexOfLight].m_Coverage + Change(Generator), 0.0f, 1.0f);
+            Requests[IndexOfLight].m_CurrentSize = Sizes[IndexOfLight];
+        }
+
+        LastTiles = Tiles;
+
+        Allocator.SelectTileSizes(Requests.data(), NumberOfLights, 2048, Budget, Sizes.data());
+
+        HasAllTiles &= Allocator.UpdateTiles(Sizes.data(), NumberOfLights, Tiles.data());
+
+        for (int IndexOfLight = 0; IndexOfLight < NumberOfLights; ++IndexOfLight)
+        {
+            NumberOfChangedTiles += Tiles[IndexOfLight] != LastTiles[IndexOfLight] ? 1 : 0;
+        }
+    }
+
+    BASE_TIME_LOG(Pack_1000_Frames_64_Lights);
+
+    BASE_CHECK(HasAllTiles);
+    BASE_CHECK(AreTilesDisjoint(Allocator, Tiles));
+    BASE_CHECK(Allocator.GetNumberOfUsedTexels() <= Budget);
+
+    // -----------------------------------------------------------------------------
+    // Most tiles have to survive a frame, otherwise caching is pointless
+    // -----------------------------------------------------------------------------
+    BASE_CHECK(NumberOfChangedTiles < 1000 * NumberOfLights / 8);
+}
@@ -0,0 +1,170 @@
+
+#include "test_precompiled.h"
+
+#include "base/base_test_defines.h"
+
+#include "engine/graphic/gfx_shadow_caster_cache.h"
+
+#include <cfloat>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // -----------------------------------------------------------------------------
+    // Light at the origin looking along -z with a range of 100 meters
+    // -----------------------------------------------------------------------------
+    glm::mat4 CreateViewProjection(const glm::vec3& _rPosition)
+    {
+        return glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f) * glm::lookAt(_rPosition, _rPosition + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Gfx::CShadowCasterCache::SCaster CreateCaster(Base::ID _ID, const glm::vec3& _rCenter, bool _IsStatic)
+    {
+        Gfx::CShadowCasterCache::SCaster Caster;
+
+        Caster.m_ID        = _ID;
+        Caster.m_Min       = _rCenter - glm::vec3(1.0f);
+        Caster.m_Max       = _rCenter + glm::vec3(1.0f);
+        Caster.m_TimeStamp = 0;
+        Caster.m_IsStatic  = _IsStatic;
+
+        return Caster;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void Move(Gfx::CShadowCasterCache::SCaster& _rCaster, const glm::vec3& _rOffset, Base::U64 _Frame)
+    {
+        _rCaster.m_Min      += _rOffset;
+        _rCaster.m_Max      += _rOffset;
+        _rCaster.m_TimeStamp = _Frame;
+    }
+} // namespace
+
+BASE_TEST(Test_ShadowCasterCache_DirtyTracking)
+{
+    Gfx::CShadowCasterCache Cache;
+
+    std::vector<Gfx::CShadowCasterCache::SCaster> Casters;
+
+    Casters.push_back(CreateCaster(0, glm::vec3( 0.0f, 0.0f, -10.0f), true));
+    Casters.push_back(CreateCaster(1, glm::vec3( 5.0f, 0.0f, -20.0f), true));
+    Casters.push_back(CreateCaster(2, glm::vec3(-5.0f, 0.0f, -30.0f), false));
+    Casters.push_back(CreateCaster(3, glm::vec3( 0.0f, 0.0f,  10.0f), false));   // Behind the light
+
+    const int NumberOfCasters = static_cast<int>(Casters.size());
+
+    glm::mat4 ViewProjection = CreateViewProjection(glm::vec3(0.0f));
+
+    // -----------------------------------------------------------------------------
+    // First update renders everything; casters behind the light are culled
+    // -----------------------------------------------------------------------------
+    BASE_CHECK(Cache.IsValid() == false);
+
+    BASE_CHECK(Cache.Update(ViewProjection, Casters.data(), NumberOfCasters) == (Gfx::CShadowCasterCache::DirtyStatic | Gfx::CShadowCasterCache::DirtyDynamic));
+
+    BASE_CHECK(Cache.IsValid());
+    BASE_CHECK(Cache.GetStaticCasters().size() == 2);
+    BASE_CHECK(Cache.GetDynamicCasters().size() == 1);
+    BASE_CHECK(Cache.GetDynamicCasters()[0] == 2);
+
+    // -----------------------------------------------------------------------------
+    // Nothing changed
+    // -----------------------------------------------------------------------------
+    BASE_CHECK(Cache.Update(ViewProjection, Casters.data(), NumberOfCasters) == 0);
+
+    // -----------------------------------------------------------------------------
+    // A moving dynamic caster keeps the static casters
+    // -----------------------------------------------------------------------------
+    Move(Casters[2], glm::vec3(1.0f, 0.0f, 0.0f), 1);
+
+    BASE_CHECK(Cache.Update(ViewProjection, Casters.data(), NumberOfCasters) == Gfx::CShadowCasterCache::DirtyDynamic);
+    BASE_CHECK(Cache.Update(ViewProjection, Casters.data(), NumberOfCasters) == 0);
+
+    // -----------------------------------------------------------------------------
+    // Casters outside of the frustum do not matter
+    // -----------------------------------------------------------------------------
+    Move(Casters[3], glm::vec3(0.0f, 0.0f, 5.0f), 2);
+
+    BASE_CHECK(Cache.Update(ViewProjection, Casters.data(), NumberOfCasters) == 0);
+
+    // -----------------------------------------------------------------------------
+    // ...unless they enter or leave it
+    // -----------------------------------------------------------------------------
+    Move(Casters[2], glm::vec3(0.0f, 0.0f, 100.0f), 3);
+
+    BASE_CHECK(Cache.Update(ViewProjection, Casters.data(), NumberOfCasters) == Gfx::CShadowCasterCache::DirtyDynamic);
+    BASE_CHECK(Cache.HasDynamicCasters() == false);
+
+    Move(Casters[0], glm::vec3(0.0f, 0.0f, 100.0f), 4);
+
+    BASE_CHECK(Cache.Update(ViewProjection, Casters.data(), NumberOfCasters) == (Gfx::CShadowCasterCache::DirtyStatic | Gfx::CShadowCasterCache::DirtyDynamic));
+    BASE_CHECK(Cache.GetStaticCasters().size() == 1);
+
+    // -----------------------------------------------------------------------------
+    // A moving static caster or light renders everything again
+    // -----------------------------------------------------------------------------
+    Move(Casters[1], glm::vec3(0.0f, 1.0f, 0.0f), 5);
+
+    BASE_CHECK(Cache.Update(ViewProjection, Casters.data(), NumberOfCasters) == (Gfx::CShadowCasterCache::DirtyStatic | Gfx::CShadowCasterCache::DirtyDynamic));
+
+    ViewProjection = CreateViewProjection(glm::vec3(0.0f, 1.0f, 0.0f));
+
+    BASE_CHECK(Cache.Update(ViewProjection, Casters.data(), NumberOfCasters) == (Gfx::CShadowCasterCache::DirtyStatic | Gfx::CShadowCasterCache::DirtyDynamic));
+    BASE_CHECK(Cache.Update(ViewProjection, Casters.data(), NumberOfCasters) == 0);
+
+    // -----------------------------------------------------------------------------
+    // Invalidation and casters without bounds
+    // -----------------------------------------------------------------------------
+    Cache.Invalidate();
+
+    BASE_CHECK(Cache.Update(ViewProjection, Casters.data(), NumberOfCasters) == (Gfx::CShadowCasterCache::DirtyStatic | Gfx::CShadowCasterCache::DirtyDynamic));
+
+    Casters[3].m_Min = glm::vec3(-FLT_MAX);
+    Casters[3].m_Max = glm::vec3( FLT_MAX);
+
+    BASE_CHECK(Cache.Update(ViewProjection, Casters.data(), NumberOfCasters) == Gfx::CShadowCasterCache::DirtyDynamic);
+    BASE_CHECK(Cache.GetDynamicCasters().size() == 1);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_ShadowCasterCache_Timing)
+{
+    Gfx::CShadowCasterCache Cache;
+
+    std::mt19937 Generator(5);
+
+    std::uniform_real_distribution<float> Position(-100.0f, 100.0f);
+
+    std::vector<Gfx::CShadowCasterCache::SCaster> Casters;
+
+    for (int IndexOfCaster = 0; IndexOfCaster < 10000; ++IndexOfCaster)
+    {
+        Casters.push_back(CreateCaster(IndexOfCaster, glm::vec3(Position(Generator), Position(Generator), Position(Generator)), IndexOfCaster % 10 != 0));
+    }
+
+    const glm::mat4 ViewProjection = CreateViewProjection(glm::vec3(0.0f));
+
+    Cache.Update(ViewProjection, Casters.data(), static_cast<int>(Casters.size()));
+
+    // -----------------------------------------------------------------------------
+    // A still scene has to be cheap since it is checked every frame per light
+    // -----------------------------------------------------------------------------
+    unsigned int DirtyFlags = 0;
+
+    BASE_TIME_RESET();
+
+    for (int Frame = 0; Frame < 100; ++Frame)
+    {
+        DirtyFlags |= Cache.Update(ViewProjection, Casters.data(), static_cast<int>(Casters.size()));
+    }
+
+    BASE_TIME_LOG(Update_100_Frames_10000_Casters);
+
+    BASE_CHECK(DirtyFlags == 0);
+    BASE_CHECK(Cache.GetStaticCasters().empty() == false);
+}
@@ -0,0 +1,385 @@
+
+#include "test_precompiled.h"
+
+#include "base/base_compression.h"
+#include "base/base_test_defines.h"
+
+#include "engine/core/core_program_parameters.h"
+
+#include "engine/network/core_network_codec.h"
+#include "engine/network/core_network_manager.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const int g_Port = 47312;
+
+    const int32_t g_EncodedCategoryFlag = 1 << 30;     //< Marks the payloads the socket encoded
+
+    // -----------------------------------------------------------------------------
+    // Smooth 16 bit depth with a little noise, like the frames of the SLAM
+    // -----------------------------------------------------------------------------
+    std::vector<char> CreateDepthFrame(int _Width, int _Height, int _Seed)
+    {
+        std::vector<char> Frame(_Width * _Height * sizeof(uint16_t));
+
+        std::mt19937 Generator(_Seed);
+
+        for (int Y = 0; Y < _Height; ++ Y)
+        {
+            for (int X = 0; X < _Width; ++ X)
+            {
+                const uint16_t Depth = static_cast<uint16_t>(1000 + X + Y / 4 + (Generator() % 4 == 0 ? 1 : 0));
+
+                std::memcpy(Frame.data() + (Y * _Width + X) * sizeof(uint16_t), &Depth, sizeof(Depth));
+            }
+        }
+
+        return Frame;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    std::vector<char> CreateNoise(Base::Size _NumberOfBytes, int _Seed)
+    {
+        std::vector<char> Noise(_NumberOfBytes);
+
+        std::mt19937 Generator(_Seed);
+
+        for (char& rByte : Noise) rByte = static_cast<char>(Generator());
+
+        return Noise;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool RoundTrip(Net::CEncoder& _rEncoder, Net::CDecoder& _rDecoder, Net::SCodec::Enum _Codec, const std::vector<char>& _rData, Base::Size* _pNumberOfEncodedBytes = nullptr)
+    {
+        std::vector<char> Encoded;
+
+        if (!_rEncoder.Encode(_Codec, _rData.data(), _rData.size(), Encoded)) return false;
+
+        if (_pNumberOfEncodedBytes != nullptr) *_pNumberOfEncodedBytes = Encoded.size();
+
+        std::vector<char> Decoded(_rData.size());
+
+        return _rDecoder.Decode(Encoded.data(), Encoded.size(), Decoded.data(), Decoded.size()) && Decoded == _rData;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    bool UpdateUntil(const std::function<bool()>& _rCondition)
+    {
+        const auto EndTime = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+        while (!_rCondition())
+        {
+            if (std::chrono::steady_clock::now() > EndTime) return false;
+
+            Net::CNetworkManager::GetInstance().Update();
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    std::vector<char> ReadMessage(asio::ip::tcp::socket& _rSocket, int32_t (&_rHeader)[3])
+    {
+        asio::read(_rSocket, asio::buffer(_rHeader, sizeof(_rHeader)));
+
+        std::vector<char> Payload(_rHeader[1]);
+
+        asio::read(_rSocket, asio::buffer(Payload));
+
+        return Payload;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void WriteMessage(asio::ip::tcp::socket& _rSocket, int _Category, const std::vector<char>& _rPayload, Base::Size _NumberOfDecompressedBytes)
+    {
+        const int32_t Header[3] = { _Category, static_cast<int32_t>(_rPayload.size()), static_cast<int32_t>(_NumberOfDecompressedBytes) };
+
+        asio::write(_rSocket, asio::buffer(Header, sizeof(Header)));
+        asio::write(_rSocket, asio::buffer(_rPayload));
+    }
+} // namespace
+
+BASE_TEST(Test_Network_Codec_RoundTrip)
+{
+    Net::CEncoder Encoder(1);
+    Net::CDecoder Decoder;
+
+    const std::vector<char> Depth = CreateDepthFrame(320, 240, 1);
+    const std::vector<char> Zeros(100000, 0);
+    const std::vector<char> Text  = { 'a', 'b', 'c', 'a', 'b', 'c', 'a', 'b', 'c', 'a', 'b', 'c', 'a', 'b', 'c', 'a', 'b', 'c', 'x', 'y', 'z' };
+
+    for (Net::SCodec::Enum Codec : { Net::SCodec::LZ, Net::SCodec::Zlib })
+    {
+        Base::Size NumberOfEncodedBytes = 0;
+
+        BASE_CHECK(RoundTrip(Encoder, Decoder, Codec, Depth, &NumberOfEncodedBytes));
+        BASE_CHECK(NumberOfEncodedBytes < Depth.size() / 2);
+
+        BASE_CHECK(RoundTrip(Encoder, Decoder, Codec, Zeros, &NumberOfEncodedBytes));
+        BASE_CHECK(NumberOfEncodedBytes < Zeros.size() / 100);
+
+        BASE_CHECK(RoundTrip(Encoder, Decoder, Codec, Text));
+    }
+
+    // -----------------------------------------------------------------------------
+    // Noise does not shrink, LZ leaves it to be sent as it is
+    // -----------------------------------------------------------------------------
+    const std::vector<char> Noise = CreateNoise(4096, 2);
+
+    std::vector<char> Encoded;
+
+    BASE_CHECK(!Encoder.Encode(Net::SCodec::LZ, Noise.data(), Noise.size(), Encoded));
+    BASE_CHECK(!Encoder.Encode(Net::SCodec::None, Noise.data(), Noise.size(), Encoded));
+
+    BASE_CHECK(RoundTrip(Encoder, Decoder, Net::SCodec::Zlib, Noise));
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Network_Codec_Stream)
+{
+    Net::CEncoder Encoder(1);
+    Net::CDecoder Decoder;
+
+    // -----------------------------------------------------------------------------
+    // The zlib stream remembers the previous message, so a repeated frame
+    // costs almost nothing. The decoder has to see the messages in order.
+    // -----------------------------------------------------------------------------
+    const std::vector<char> Noise = CreateNoise(16 * 1024, 3);
+
+    Base::Size NumberOfFirstBytes  = 0;
+    Base::Size NumberOfSecondBytes = 0;
+
+    BASE_CHECK(RoundTrip(Encoder, Decoder, Net::SCodec::Zlib, Noise, &NumberOfFirstBytes));
+    BASE_CHECK(RoundTrip(Encoder, Decoder, Net::SCodec::Zlib, Noise, &NumberOfSecondBytes));
+
+    BASE_CHECK(NumberOfFirstBytes > Noise.size());
+    BASE_CHECK(NumberOfSecondBytes < Noise.size() / 10);
+
+    // -----------------------------------------------------------------------------
+    // Codecs can be mixed on one connection
+    // -----------------------------------------------------------------------------
+    for (int IndexOfFrame = 0; IndexOfFrame < 8; ++ IndexOfFrame)
+    {
+        const std::vector<char> Depth = CreateDepthFrame(64, 48, IndexOfFrame);
+
+        BASE_CHECK(RoundTrip(Encoder, Decoder, IndexOfFrame % 2 == 0 ? Net::SCodec::Zlib : Net::SCodec::LZ, Depth));
+    }
+
+    // -----------------------------------------------------------------------------
+    // After a reset both sides start a new stream
+    // -----------------------------------------------------------------------------
+    Encoder.Reset();
+    Decoder.Reset();
+
+    BASE_CHECK(RoundTrip(Encoder, Decoder, Net::SCodec::Zlib, Noise, &NumberOfFirstBytes));
+    BASE_CHECK(NumberOfFirstBytes > Noise.size());
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Network_Codec_Corrupt)
+{
+    Net::CEncoder Encoder(1);
+
+    const std::vector<char> Depth = CreateDepthFrame(64, 48, 4);
+
+    for (Net::SCodec::Enum Codec : { Net::SCodec::LZ, Net::SCodec::Zlib })
+    {
+        Net::CDecoder Decoder;
+
+        std::vector<char> Encoded;
+
+        BASE_CHECK(Encoder.Encode(Codec, Depth.data(), Depth.size(), Encoded));
+
+        std::vector<char> Decoded(Depth.size());
+
+        // -----------------------------------------------------------------------------
+        // Truncated data, a wrong size and garbage are refused
+        // -----------------------------------------------------------------------------
+        BASE_CHECK(!Decoder.Decode(Encoded.data(), Encoded.size() / 2, Decoded.data(), Decoded.size()));
+
+        Decoder.Reset();
+
+        BASE_CHECK(!Decoder.Decode(Encoded.data(), Encoded.size(), Decoded.data(), Decoded.size() - 1));
+
+        Decoder.Reset();
+
+        std::vector<char> Garbage = CreateNoise(Encoded.size(), 5);
+
+        Garbage[0] = Encoded[0];
+
+        BASE_CHECK(!Decoder.Decode(Garbage.data(), Garbage.size(), Decoded.data(), Decoded.size()));
+    }
+
+    // -----------------------------------------------------------------------------
+    // Data that does not start with a codec tag, like gzip, is refused
+    // -----------------------------------------------------------------------------
+    Net::CDecoder Decoder;
+
+    std::vector<char> Compressed;
+
+    Base::Compress(Depth, Compressed, 1);
+
+    std::vector<char> Decoded(Depth.size());
+
+    BASE_CHECK(!Decoder.Decode(Compressed.data(), Compressed.size(), Decoded.data(), Decoded.size()));
+    BASE_CHECK(!Decoder.Decode(Compressed.data(), 0, Decoded.data(), Decoded.size()));
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Network_Codec_Negotiation)
+{
+    Core::CProgramParameters::GetInstance().Set("network:compression:enabled", true);
+
+    Net::CNetworkManager& rNetworkManager = Net::CNetworkManager::GetInstance();
+
+    rNetworkManager.OnStart();
+
+    const Net::SocketHandle ServerHandle = rNetworkManager.CreateMultiClientServerSocket(g_Port);
+
+    rNetworkManager.SetCodec(ServerHandle, 4, Net::SCodec::Zlib);
+
+    std::vector<Net::CMessage> Messages;
+
+    auto HandlerPtr = rNetworkManager.RegisterMessageHandler(ServerHandle, [&](const Net::CMessage& _rMessage, Net::SocketHandle)
+    {
+        if (_rMessage.m_MessageType != 0) return;
+
+        Net::CMessage Message;
+
+        Message.m_Category         = _rMessage.m_Category;
+        Message.m_CompressedSize   = _rMessage.m_CompressedSize;
+        Message.m_DecompressedSize = _rMessage.m_DecompressedSize;
+        Message.m_Payload          = _rMessage.m_Payload;
+
+        Messages.emplace_back(std::move(Message));
+    });
+
+    asio::io_service IOService;
+
+    asio::ip::tcp::socket Viewer(IOService);
+
+    Viewer.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), g_Port));
+
+    BASE_CHECK(UpdateUntil([&]() { return rNetworkManager.GetSessions(ServerHandle).size() == 1; }));
+
+    // -----------------------------------------------------------------------------
+    // The session announces its codecs first. The handshake of the viewer is
+    // processed before the message behind it.
+    // -----------------------------------------------------------------------------
+    int32_t Header[3];
+
+    std::vector<char> Handshake = ReadMessage(Viewer, Header);
+
+    BASE_CHECK(Header[0] == -1 && Handshake.size() == sizeof(int32_t));
+
+    WriteMessage(Viewer, -1, Handshake, Handshake.size());
+    WriteMessage(Viewer, 7, { 'a', 'b', 'c' }, 3);
+
+    BASE_CHECK(UpdateUntil([&]() { return Messages.size() == 1; }));
+
+    BASE_CHECK(Messages[0].m_Category == 7);
+
+    // -----------------------------------------------------------------------------
+    // Large payloads are compressed with the codec of their category, small
+    // ones are sent as they are.
+    // -----------------------------------------------------------------------------
+    const std::vector<char> Depth = CreateDepthFrame(320, 240, 6);
+
+    Net::CMessage Message;
+
+    Message.m_Category = 4;
+    Message.m_Payload  = Net::CPayload(std::vector<char>(Depth));
+
+    BASE_CHECK(rNetworkManager.Broadcast(ServerHandle, Message) == 1);
+
+    Message.m_Category = 5;
+    Message.m_Payload  = Net::CPayload(std::vector<char>(Depth));
+
+    BASE_CHECK(rNetworkManager.Broadcast(ServerHandle, Message) == 1);
+
+    Message.m_Category = 6;
+    Message.m_Payload  = Net::CPayload(std::vector<char>(16, 1));
+
+    BASE_CHECK(rNetworkManager.Broadcast(ServerHandle, Message) == 1);
+
+    Net::CEncoder Encoder(1);
+    Net::CDecoder Decoder;
+
+    std::vector<char> Decoded(Depth.size());
+
+    std::vector<char> Payload = ReadMessage(Viewer, Header);
+
+    BASE_CHECK(Header[0] == (4 | g_EncodedCategoryFlag) && Header[1] < Header[2] && Header[2] == static_cast<int32_t>(Depth.size()) && Payload[0] == 'Z');
+    BASE_CHECK(Decoder.Decode(Payload.data(), Payload.size(), Decoded.data(), Decoded.size()) && Decoded == Depth);
+
+    Payload = ReadMessage(Viewer, Header);
+
+    BASE_CHECK(Header[0] == (5 | g_EncodedCategoryFlag) && Header[1] < Header[2] && Payload[0] == 'L');
+    BASE_CHECK(Decoder.Decode(Payload.data(), Payload.size(), Decoded.data(), Decoded.size()) && Decoded == Depth);
+
+    Payload = ReadMessage(Viewer, Header);
+
+    BASE_CHECK(Header[0] == 6 && Header[1] == 16 && Header[2] == 16);
+
+    // -----------------------------------------------------------------------------
+    // Compressed messages of the viewer arrive decompressed
+    // -----------------------------------------------------------------------------
+    std::vector<char> Encoded;
+
+    BASE_CHECK(Encoder.Encode(Net::SCodec::Zlib, Depth.data(), Depth.size(), Encoded));
+
+    WriteMessage(Viewer, 8 | g_EncodedCategoryFlag, Encoded, Depth.size());
+
+    BASE_CHECK(UpdateUntil([&]() { return Messages.size() == 2; }));
+
+    BASE_CHECK(Messages[1].m_Category == 8);
+    BASE_CHECK(Messages[1].m_CompressedSize == Messages[1].m_DecompressedSize);
+    BASE_CHECK(std::vector<char>(Messages[1].m_Payload.GetData(), Messages[1].m_Payload.GetData() + Messages[1].m_Payload.GetNumberOfBytes()) == Depth);
+
+    // -----------------------------------------------------------------------------
+    // Payloads the application compressed itself are not marked and reach
+    // the handlers as they are, even if they start with a codec tag
+    // -----------------------------------------------------------------------------
+    std::vector<char> Compressed;
+
+    Base::Compress(Depth, Compressed, 1);
+
+    Encoded[0] = 'L';
+
+    WriteMessage(Viewer, 9, Compressed, Depth.size());
+    WriteMessage(Viewer, 10, Encoded, Depth.size());
+
+    BASE_CHECK(UpdateUntil([&]() { return Messages.size() == 4; }));
+
+    BASE_CHECK(Messages[2].m_Category == 9);
+    BASE_CHECK(Messages[2].m_CompressedSize == static_cast<int>(Compressed.size()) && Messages[2].m_DecompressedSize == static_cast<int>(Depth.size()));
+    BASE_CHECK(std::vector<char>(Messages[2].m_Payload.GetData(), Messages[2].m_Payload.GetData() + Messages[2].m_Payload.GetNumberOfBytes()) == Compressed);
+
+    BASE_CHECK(Messages[3].m_Category == 10);
+    BASE_CHECK(std::vector<char>(Messages[3].m_Payload.GetData(), Messages[3].m_Payload.GetData() + Messages[3].m_Payload.GetNumberOfBytes()) == Encoded);
+
+    Viewer.close();
+
+    rNetworkManager.OnExit();
+
+    Core::CProgramParameters::GetInstance().Set("network:compression:enabled", false);
+}
@@ -0,0 +1,148 @@
+
+#include "test_precompiled.h"
+
+#include "base/base_serialize_binary_reader.h"
+#include "base/base_serialize_binary_writer.h"
+#include "base/base_test_defines.h"
+
+#include "engine/network/core_network_common.h"
+
+#include <memory>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+BASE_TEST(Test_Network_Payload_Share)
+{
+    std::vector<char> Bytes = { 'a', 'b', 'c', 'd', 'e', 'f' };
+
+    const char* pBytes = Bytes.data();
+
+    // -----------------------------------------------------------------------------
+    // Taking the bytes, copying the payload and slicing it do not copy data
+    // -----------------------------------------------------------------------------
+    Net::CPayload Payload(std::move(Bytes));
+
+    BASE_CHECK(Payload.GetData() == pBytes);
+    BASE_CHECK(Payload.GetNumberOfBytes() == 6);
+
+    Net::CPayload Copy = Payload;
+
+    BASE_CHECK(Copy.GetData() == pBytes);
+
+    Net::CPayload Slice = Payload.GetSlice(2, 3);
+
+    BASE_CHECK(Slice.GetData() == pBytes + 2);
+    BASE_CHECK(Slice.GetNumberOfBytes() == 3);
+    BASE_CHECK(Slice[0] == 'c' && Slice[2] == 'e');
+
+    Net::CPayload SliceOfSlice = Slice.GetSlice(1, 1);
+
+    BASE_CHECK(SliceOfSlice[0] == 'd');
+
+    // -----------------------------------------------------------------------------
+    // Messages are moved together with their payload
+    // -----------------------------------------------------------------------------
+    Net::CMessage Message;
+
+    Message.m_Category = 3;
+    Message.m_Payload  = Payload;
+
+    Net::CMessage MovedMessage = std::move(Message);
+
+    BASE_CHECK(MovedMessage.m_Category == 3);
+    BASE_CHECK(MovedMessage.m_Payload.GetData() == pBytes);
+
+    BASE_CHECK(Net::CPayload().IsEmpty());
+    BASE_CHECK(Net::CPayload().GetData() == nullptr);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Network_Payload_Pool)
+{
+    auto PoolPtr = std::make_shared<Net::CPayloadPool>(2);
+
+    const char* pFirstBytes = nullptr;
+
+    // -----------------------------------------------------------------------------
+    // Buffers come back once the last payload is gone
+    // -----------------------------------------------------------------------------
+    {
+        Net::CPayload Payload(PoolPtr->Allocate(1024));
+
+        pFirstBytes = Payload.GetData();
+
+        Net::CPayload Slice = Payload.GetSlice(10, 10);
+
+        Payload = Net::CPayload();
+
+        BASE_CHECK(PoolPtr->GetNumberOfFreeBuffers() == 0);
+    }
+
+    BASE_CHECK(PoolPtr->GetNumberOfFreeBuffers() == 1);
+
+    // -----------------------------------------------------------------------------
+    // Smaller requests reuse the buffer without reallocation
+    // -----------------------------------------------------------------------------
+    {
+        Net::CPayloadPool::CBufferPtr BufferPtr = PoolPtr->Allocate(512);
+
+        BASE_CHECK(BufferPtr->size() == 512);
+        BASE_CHECK(BufferPtr->data() == pFirstBytes);
+        BASE_CHECK(PoolPtr->GetNumberOfFreeBuffers() == 0);
+    }
+
+    // -----------------------------------------------------------------------------
+    // The pool keeps at most the given number of buffers
+    // -----------------------------------------------------------------------------
+    {
+        Net::CPayloadPool::CBufferPtr Buffers[] = { PoolPtr->Allocate(16), PoolPtr->Allocate(16), PoolPtr->Allocate(16) };
+    }
+
+    BASE_CHECK(PoolPtr->GetNumberOfFreeBuffers() == 2);
+
+    // -----------------------------------------------------------------------------
+    // Payloads may outlive their pool
+    // -----------------------------------------------------------------------------
+    Net::CPayload Payload(PoolPtr->Allocate(8));
+
+    PoolPtr.reset();
+
+    BASE_CHECK(Payload.GetNumberOfBytes() == 8);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Network_Payload_Serialization)
+{
+    std::vector<char> Bytes = { 1, 2, 3, 4 };
+
+    // -----------------------------------------------------------------------------
+    // Payloads are written like a std::vector<char>
+    // -----------------------------------------------------------------------------
+    std::stringstream Stream;
+
+    Base::CBinaryWriter Writer(Stream, 1);
+
+    Base::Write(Writer, Net::CPayload(std::vector<char>(Bytes)));
+
+    Base::CBinaryReader Reader(Stream, 1);
+
+    std::vector<char> ReadBytes;
+
+    Base::Read(Reader, ReadBytes);
+
+    BASE_CHECK(ReadBytes == Bytes);
+
+    Stream.clear();
+    Stream.seekg(0);
+
+    Base::CBinaryReader PayloadReader(Stream, 1);
+
+    Net::CPayload Payload;
+
+    Base::Read(PayloadReader, Payload);
+
+    BASE_CHECK(Payload.GetNumberOfBytes() == 4 && Payload[3] == 4);
+}
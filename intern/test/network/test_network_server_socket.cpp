@@ -0,0 +1,314 @@
+
+#include "test_precompiled.h"
+
+#include "base/base_test_defines.h"
+
+#include "engine/core/core_program_parameters.h"
+
+#include "engine/network/core_network_manager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const int g_Port = 47311;
+
+    // -----------------------------------------------------------------------------
+    // Updates the network manager until the condition holds or the time passed
+    // -----------------------------------------------------------------------------
+    bool UpdateUntil(const std::function<bool()>& _rCondition, int _TimeoutInMs = 1000)
+    {
+        const auto EndTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(_TimeoutInMs);
+
+        while (!_rCondition())
+        {
+            if (std::chrono::steady_clock::now() > EndTime) return false;
+
+            Net::CNetworkManager::GetInstance().Update();
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    std::vector<char> ReadMessage(asio::ip::tcp::socket& _rSocket)
+    {
+        int32_t Header[3];
+
+        asio::read(_rSocket, asio::buffer(Header, sizeof(Header)));
+
+        std::vector<char> Payload(Header[1]);
+
+        asio::read(_rSocket, asio::buffer(Payload));
+
+        return Payload;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    void WriteMessage(asio::ip::tcp::socket& _rSocket, int _Category, const std::vector<char>& _rPayload)
+    {
+        const int32_t Header[3] = { _Category, static_cast<int32_t>(_rPayload.size()), static_cast<int32_t>(_rPayload.size()) };
+
+        asio::write(_rSocket, asio::buffer(Header, sizeof(Header)));
+        asio::write(_rSocket, asio::buffer(_rPayload));
+    }
+} // namespace
+
+BASE_TEST(Test_Network_ServerSocket_Sessions)
+{
+    Net::CNetworkManager& rNetworkManager = Net::CNetworkManager::GetInstance();
+
+    rNetworkManager.OnStart();
+
+    const Net::SocketHandle ServerHandle = rNetworkManager.CreateMultiClientServerSocket(g_Port);
+
+    std::map<Net::SocketHandle, std::vector<int>> MessageTypes;
+    std::map<Net::SocketHandle, std::vector<char>> Payloads;
+
+    auto HandlerPtr = rNetworkManager.RegisterMessageHandler(ServerHandle, [&](const Net::CMessage& _rMessage, Net::SocketHandle _SessionHandle)
+    {
+        if (_rMessage.m_MessageType == 1) return;
+
+        MessageTypes[_SessionHandle].push_back(_rMessage.m_MessageType);
+
+        if (_rMessage.m_MessageType == 0)
+        {
+            Payloads[_SessionHandle].assign(_rMessage.m_Payload.GetData(), _rMessage.m_Payload.GetData() + _rMessage.m_Payload.GetNumberOfBytes());
+        }
+    });
+
+    // -----------------------------------------------------------------------------
+    // Every viewer gets its own session
+    // -----------------------------------------------------------------------------
+    asio::io_service IOService;
+
+    asio::ip::tcp::socket FirstViewer(IOService);
+    asio::ip::tcp::socket SecondViewer(IOService);
+
+    FirstViewer .connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), g_Port));
+    SecondViewer.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), g_Port));
+
+    BASE_CHECK(UpdateUntil([&]() { return rNetworkManager.GetSessions(ServerHandle).size() == 2; }));
+
+    const std::vector<Net::SocketHandle> Sessions = rNetworkManager.GetSessions(ServerHandle);
+
+    BASE_CHECK(Sessions.size() == 2 && Sessions[0] != Sessions[1]);
+    BASE_CHECK(Sessions.size() == 2 && Sessions[0] != ServerHandle && Sessions[1] != ServerHandle);
+    BASE_CHECK(rNetworkManager.IsConnected(ServerHandle));
+
+    for (Net::SocketHandle SessionHandle : Sessions)
+    {
+        BASE_CHECK(MessageTypes[SessionHandle].size() == 1 && MessageTypes[SessionHandle][0] == 3);
+        BASE_CHECK(rNetworkManager.IsConnected(SessionHandle));
+    }
+
+    // -----------------------------------------------------------------------------
+    // A broadcast reaches all viewers
+    // -----------------------------------------------------------------------------
+    Net::CMessage Message;
+
+    Message.m_Category = 5;
+    Message.m_Payload  = Net::CPayload(std::vector<char>(100, 9));
+
+    BASE_CHECK(rNetworkManager.Broadcast(ServerHandle, Message) == 2);
+
+    BASE_CHECK(ReadMessage(FirstViewer)  == std::vector<char>(100, 9));
+    BASE_CHECK(ReadMessage(SecondViewer) == std::vector<char>(100, 9));
+
+    // -----------------------------------------------------------------------------
+    // Messages of a viewer arrive with the handle of its session
+    // -----------------------------------------------------------------------------
+    WriteMessage(SecondViewer, 7, { 'a', 'b', 'c' });
+
+    BASE_CHECK(UpdateUntil([&]() { return Payloads.size() == 1; }));
+
+    const Net::SocketHandle SecondSession = Payloads.begin()->first;
+
+    BASE_CHECK(Payloads[SecondSession] == std::vector<char>({ 'a', 'b', 'c' }));
+
+    Net::CMessage Reply;
+
+    Reply.m_Category = 7;
+    Reply.m_Payload  = Net::CPayload(std::vector<char>(4, 1));
+
+    BASE_CHECK(rNetworkManager.SendMessage(SecondSession, std::move(Reply)));
+
+    BASE_CHECK(ReadMessage(SecondViewer) == std::vector<char>(4, 1));
+
+    // -----------------------------------------------------------------------------
+    // A viewer that leaves closes its session only
+    // -----------------------------------------------------------------------------
+    SecondViewer.close();
+
+    BASE_CHECK(UpdateUntil([&]() { return rNetworkManager.GetSessions(ServerHandle).size() == 1; }));
+
+    BASE_CHECK(MessageTypes[SecondSession].back() == 2);
+    BASE_CHECK(rNetworkManager.IsConnected(ServerHandle));
+
+    BASE_CHECK(rNetworkManager.Broadcast(ServerHandle, Message) == 1);
+
+    BASE_CHECK(ReadMessage(FirstViewer) == std::vector<char>(100, 9));
+
+    FirstViewer.close();
+
+    rNetworkManager.OnExit();
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Network_ServerSocket_QueueLimit)
+{
+    Net::CNetworkManager& rNetworkManager = Net::CNetworkManager::GetInstance();
+
+    rNetworkManager.OnStart();
+
+    const Net::SocketHandle ServerHandle = rNetworkManager.CreateMultiClientServerSocket(g_Port);
+
+    rNetworkManager.SetSessionQueueLimit(ServerHandle, 4, Net::SQueuePolicy::Coalesce);
+
+    asio::io_service IOService;
+
+    asio::ip::tcp::socket Viewer(IOService);
+
+    Viewer.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), g_Port));
+
+    BASE_CHECK(UpdateUntil([&]() { return rNetworkManager.GetSessions(ServerHandle).size() == 1; }));
+
+    // -----------------------------------------------------------------------------
+    // The viewer does not read, so its queue fills up once the socket buffers
+    // are full. Later frames replace stale ones instead of being queued.
+    // -----------------------------------------------------------------------------
+    const Net::CPayload Frame(std::vector<char>(1024 * 1024, 3));
+
+    for (int IndexOfFrame = 0; IndexOfFrame < 256; ++ IndexOfFrame)
+    {
+        Net::CMessage Message;
+
+        Message.m_Category = 1;
+        Message.m_Payload  = Frame;
+
+        BASE_CHECK(rNetworkManager.Broadcast(ServerHandle, Message) == 1);
+    }
+
+    const Net::SocketHandle SessionHandle = rNetworkManager.GetSessions(ServerHandle)[0];
+
+    BASE_CHECK(rNetworkManager.GetNumberOfDroppedMessages(SessionHandle) > 0);
+    BASE_CHECK(rNetworkManager.GetNumberOfPendingBytes(SessionHandle) <= 5 * Frame.GetNumberOfBytes() + 4 * 1024 * 1024);
+
+    // -----------------------------------------------------------------------------
+    // Only frames are queued, so a message of another category has nothing
+    // to replace and is refused instead of dropping one of them.
+    // -----------------------------------------------------------------------------
+    const Base::Size NumberOfDroppedMessages = rNetworkManager.GetNumberOfDroppedMessages(SessionHandle);
+
+    Net::CMessage Message;
+
+    Message.m_Category = 2;
+    Message.m_Payload  = Net::CPayload(std::vector<char>(16, 4));
+
+    BASE_CHECK(rNetworkManager.Broadcast(ServerHandle, Message) == 0);
+    BASE_CHECK(rNetworkManager.GetNumberOfDroppedMessages(SessionHandle) == NumberOfDroppedMessages + 1);
+
+    Viewer.close();
+
+    rNetworkManager.OnExit();
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_Network_ServerSocket_ReceiveBudget)
+{
+    Core::CProgramParameters::GetInstance().Set("network:receive:queue_size", 16);
+    Core::CProgramParameters::GetInstance().Set("network:receive:budget_ms", 2.0);
+
+    Net::CNetworkManager& rNetworkManager = Net::CNetworkManager::GetInstance();
+
+    rNetworkManager.OnStart();
+
+    const Net::SocketHandle ServerHandle = rNetworkManager.CreateMultiClientServerSocket(g_Port);
+
+    std::vector<int> Indices;
+
+    Base::Size MaxNumberOfMessagesPerUpdate = 0;
+
+    auto HandlerPtr = rNetworkManager.RegisterMessageHandler(ServerHandle, [&](const Net::CMessage& _rMessage, Net::SocketHandle)
+    {
+        if (_rMessage.m_MessageType != 0) return;
+
+        int32_t Index;
+
+        std::memcpy(&Index, _rMessage.m_Payload.GetData(), sizeof(Index));
+
+        Indices.push_back(Index);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    });
+
+    asio::io_service IOService;
+
+    asio::ip::tcp::socket Viewer(IOService);
+
+    Viewer.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), g_Port));
+
+    BASE_CHECK(UpdateUntil([&]() { return rNetworkManager.GetSessions(ServerHandle).size() == 1; }));
+
+    const Net::SocketHandle SessionHandle = rNetworkManager.GetSessions(ServerHandle)[0];
+
+    // -----------------------------------------------------------------------------
+    // The slow handler cannot keep up: the queue fills, reading pauses and
+    // every update stops at the budget. No message is lost or reordered.
+    // -----------------------------------------------------------------------------
+    const int NumberOfMessages = 100;
+
+    for (int32_t IndexOfMessage = 0; IndexOfMessage < NumberOfMessages; ++ IndexOfMessage)
+    {
+        std::vector<char> Payload(sizeof(IndexOfMessage));
+
+        std::memcpy(Payload.data(), &IndexOfMessage, sizeof(IndexOfMessage));
+
+        WriteMessage(Viewer, 7, Payload);
+    }
+
+    BASE_CHECK(UpdateUntil([&]()
+    {
+        MaxNumberOfMessagesPerUpdate = std::max(MaxNumberOfMessagesPerUpdate, rNetworkManager.GetReceiveStatistics(SessionHandle).m_NumberOfHandledMessages);
+
+        return Indices.size() == NumberOfMessages;
+    }, 10000));
+
+    bool IsInOrder = true;
+
+    for (int IndexOfMessage = 0; IndexOfMessage < static_cast<int>(Indices.size()); ++ IndexOfMessage)
+    {
+        IsInOrder = IsInOrder && Indices[IndexOfMessage] == IndexOfMessage;
+    }
+
+    BASE_CHECK(IsInOrder);
+
+    const Net::SReceiveStatistics Statistics = rNetworkManager.GetReceiveStatistics(SessionHandle);
+
+    BASE_CHECK(Statistics.m_NumberOfQueuedMessages == 0);
+    BASE_CHECK(Statistics.m_PeakNumberOfQueuedMessages <= 16);
+    BASE_CHECK(Statistics.m_NumberOfDeferredUpdates > 0);
+    BASE_CHECK(Statistics.m_NumberOfStalls > 0);
+    BASE_CHECK(Statistics.m_MaxHandlerDurationInMs >= 2.0);
+    BASE_CHECK(MaxNumberOfMessagesPerUpdate < 16);
+
+    Viewer.close();
+
+    rNetworkManager.OnExit();
+
+    Core::CProgramParameters::GetInstance().Set("network:receive:queue_size", 1024);
+    Core::CProgramParameters::GetInstance().Set("network:receive:budget_ms", 4.0);
+}
@@ -0,0 +1,117 @@
+
+#pragma once
+
+#include "base/base_include_glm.h"
+
+#include "plugin/slam/mr_icp_tracker_cpu.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace MR
+{
+    // -----------------------------------------------------------------------------
+    // Interior of a box seen from its center for the tracker tests and
+    // benchmarks. Every plane is given as normal and distance, so all six
+    // degrees of freedom are constrained.
+    // -----------------------------------------------------------------------------
+    inline bool IntersectBoxScene(const glm::vec3& _rOrigin, const glm::vec3& _rDirection, float& _rDistance, glm::vec3& _rNormal)
+    {
+        static const glm::vec4 s_Planes[] =
+        {
+            glm::vec4( 1.0f,  0.0f,  0.0f, 1.5f),
+            glm::vec4(-1.0f,  0.0f,  0.0f, 1.5f),
+            glm::vec4( 0.0f,  1.0f,  0.0f, 1.2f),
+            glm::vec4( 0.0f, -1.0f,  0.0f, 1.2f),
+            glm::vec4( 0.0f,  0.0f, -1.0f, 4.0f),
+        };
+
+        _rDistance = std::numeric_limits<float>::max();
+
+        for (const glm::vec4& rPlane : s_Planes)
+        {
+            const glm::vec3 Normal(rPlane);
+
+            const float Denominator = glm::dot(Normal, _rDirection);
+
+            if (std::abs(Denominator) < 1e-6f) continue;
+
+            const float Distance = -(glm::dot(Normal, _rOrigin) + rPlane.w) / Denominator;
+
+            if (Distance > 0.0f && Distance < _rDistance)
+            {
+                _rDistance = Distance;
+                _rNormal = Normal;
+            }
+        }
+
+        return _rDistance < std::numeric_limits<float>::max();
+    }
+
+    // -----------------------------------------------------------------------------
+    // Depth image in millimeters like the sensor delivers it
+    // -----------------------------------------------------------------------------
+    inline void RenderBoxDepth(const glm::mat4& _rPoseMatrix, const glm::vec2& _rFocalLength, const glm::vec2& _rFocalPoint, int _Width, int _Height, std::vector<unsigned short>& _rDepth)
+    {
+        const glm::mat3 Rotation(_rPoseMatrix);
+        const glm::vec3 Origin(_rPoseMatrix[3]);
+
+        _rDepth.resize(_Width * _Height);
+
+        for (int y = 0; y < _Height; ++y)
+        {
+            for (int x = 0; x < _Width; ++x)
+            {
+                const glm::vec3 Ray((x - _rFocalPoint.x) / _rFocalLength.x, (y - _rFocalPoint.y) / _rFocalLength.y, 1.0f);
+
+                float Distance;
+                glm::vec3 Normal;
+
+                IntersectBoxScene(Origin, Rotation * Ray, Distance, Normal);
+
+                _rDepth[y * _Width + x] = static_cast<unsigned short>(Distance * 1000.0f + 0.5f);
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // Exact vertices and normals in world space, like the raycast of the volume
+    // -----------------------------------------------------------------------------
+    inline void RenderBoxRaycastPyramid(const glm::mat4& _rPoseMatrix, const glm::vec2& _rFocalLength, const glm::vec2& _rFocalPoint, int _Width, int _Height, int _PyramidLevelCount, CICPTrackerCPU::CPyramid& _rPyramid)
+    {
+        const glm::mat3 Rotation(_rPoseMatrix);
+        const glm::vec3 Origin(_rPoseMatrix[3]);
+
+        _rPyramid.resize(_PyramidLevelCount);
+
+        for (int PyramidLevel = 0; PyramidLevel < _PyramidLevelCount; ++PyramidLevel)
+        {
+            const float Scale = static_cast<float>(1 << PyramidLevel);
+
+            CICPTrackerCPU::SPyramidLevel& rLevel = _rPyramid[PyramidLevel];
+
+            rLevel.m_Width = _Width >> PyramidLevel;
+            rLevel.m_Height = _Height >> PyramidLevel;
+            rLevel.m_VertexMap.resize(rLevel.m_Width * rLevel.m_Height);
+            rLevel.m_NormalMap.resize(rLevel.m_Width * rLevel.m_Height);
+
+            for (int y = 0; y < rLevel.m_Height; ++y)
+            {
+                for (int x = 0; x < rLevel.m_Width; ++x)
+                {
+                    const glm::vec3 Ray((x * Scale - _rFocalPoint.x) / _rFocalLength.x, (y * Scale - _rFocalPoint.y) / _rFocalLength.y, 1.0f);
+                    const glm::vec3 Direction = Rotation * Ray;
+
+                    float Distance;
+                    glm::vec3 Normal;
+
+                    IntersectBoxScene(Origin, Direction, Distance, Normal);
+
+                    rLevel.m_VertexMap[y * rLevel.m_Width + x] = glm::vec4(Origin + Distance * Direction, 1.0f);
+                    rLevel.m_NormalMap[y * rLevel.m_Width + x] = glm::vec4(Normal, 0.0f);
+                }
+            }
+        }
+    }
+} // namespace MR
@@ -0,0 +1,142 @@
+
+#include "test_precompiled.h"
+
+#include "slam/test_slam_box_scene.h"
+
+#include "base/base_test_defines.h"
+
+#include "plugin/slam/mr_icp_tracker_cpu.h"
+
+#include <vector>
+
+namespace
+{
+    const glm::vec2 g_FocalLength(300.0f, 300.0f);
+    const glm::vec2 g_FocalPoint(160.0f, 120.0f);
+
+    // -----------------------------------------------------------------------------
+
+    MR::SReconstructionSettings GetSettings()
+    {
+        MR::SReconstructionSettings Settings = {};
+
+        Settings.m_TruncatedDistance = 30.0f;
+        Settings.m_PyramidLevelCount = 3;
+        Settings.m_PyramidLevelIterations = glm::ivec3(10, 10, 10);
+
+        return Settings;
+    }
+} // namespace
+
+BASE_TEST(Test_SLAM_ICP_Tracker_CPU)
+{
+    const int Width = 320;
+    const int Height = 240;
+
+    const MR::SReconstructionSettings Settings = GetSettings();
+
+    const glm::mat4 PreviousPoseMatrix(1.0f);
+    const glm::mat4 CurrentPoseMatrix = glm::translate(glm::vec3(0.01f, -0.005f, 0.015f)) * glm::rotate(0.008f, glm::normalize(glm::vec3(0.3f, 1.0f, 0.2f)));
+
+    MR::CICPTrackerCPU Tracker(Width, Height, Settings);
+
+    Tracker.SetIntrinsics(g_FocalLength, g_FocalPoint);
+
+    std::vector<unsigned short> Depth;
+    MR::CICPTrackerCPU::CPyramid ReferencePyramid;
+    MR::CICPTrackerCPU::CPyramid RaycastPyramid;
+
+    MR::RenderBoxDepth(CurrentPoseMatrix, g_FocalLength, g_FocalPoint, Width, Height, Depth);
+
+    Tracker.CreateReferencePyramid(Depth.data(), ReferencePyramid);
+
+    MR::RenderBoxRaycastPyramid(PreviousPoseMatrix, g_FocalLength, g_FocalPoint, Width, Height, Settings.m_PyramidLevelCount, RaycastPyramid);
+
+    BASE_CHECK(ReferencePyramid.size() == 3);
+    BASE_CHECK(ReferencePyramid[2].m_Width == Width / 4);
+
+    const glm::mat4 TrackedPoseMatrix = Tracker.Track(PreviousPoseMatrix, ReferencePyramid, RaycastPyramid);
+
+    BASE_CHECK(!Tracker.IsTrackingLost());
+    BASE_CHECK(Tracker.GetNumberOfCorrespondences() > 0);
+
+    // -----------------------------------------------------------------------------
+    // Convergence should stop well before all 30 iterations are used
+    // -----------------------------------------------------------------------------
+    BASE_CHECK(Tracker.GetNumberOfIterations() < 30);
+
+    BASE_CHECK(glm::distance(glm::vec3(TrackedPoseMatrix[3]), glm::vec3(CurrentPoseMatrix[3])) < 0.003f);
+
+    for (int Column = 0; Column < 3; ++Column)
+    {
+        BASE_CHECK(glm::distance(glm::vec3(TrackedPoseMatrix[Column]), glm::vec3(CurrentPoseMatrix[Column])) < 0.003f);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_SLAM_ICP_Tracker_CPU_Lost)
+{
+    const int Width = 320;
+    const int Height = 240;
+
+    const MR::SReconstructionSettings Settings = GetSettings();
+
+    MR::CICPTrackerCPU Tracker(Width, Height, Settings);
+
+    Tracker.SetIntrinsics(g_FocalLength, g_FocalPoint);
+
+    std::vector<unsigned short> Depth(Width * Height, 0);
+    MR::CICPTrackerCPU::CPyramid ReferencePyramid;
+    MR::CICPTrackerCPU::CPyramid RaycastPyramid;
+
+    Tracker.CreateReferencePyramid(Depth.data(), ReferencePyramid);
+
+    MR::RenderBoxRaycastPyramid(glm::mat4(1.0f), g_FocalLength, g_FocalPoint, Width, Height, Settings.m_PyramidLevelCount, RaycastPyramid);
+
+    const glm::mat4 TrackedPoseMatrix = Tracker.Track(glm::mat4(1.0f), ReferencePyramid, RaycastPyramid);
+
+    BASE_CHECK(Tracker.IsTrackingLost());
+    BASE_CHECK(TrackedPoseMatrix == glm::mat4(1.0f));
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_SLAM_ICP_Tracker_CPU_Timing)
+{
+    const int Width = 640;
+    const int Height = 480;
+
+    const MR::SReconstructionSettings Settings = GetSettings();
+
+    const glm::mat4 CurrentPoseMatrix = glm::translate(glm::vec3(0.01f, 0.0f, 0.02f));
+
+    MR::CICPTrackerCPU Tracker(Width, Height, Settings);
+
+    const glm::vec2 FocalLength = g_FocalLength * 2.0f;
+    const glm::vec2 FocalPoint = g_FocalPoint * 2.0f;
+
+    Tracker.SetIntrinsics(FocalLength, FocalPoint);
+
+    std::vector<unsigned short> Depth;
+    MR::CICPTrackerCPU::CPyramid ReferencePyramid;
+    MR::CICPTrackerCPU::CPyramid RaycastPyramid;
+
+    MR::RenderBoxDepth(CurrentPoseMatrix, FocalLength, FocalPoint, Width, Height, Depth);
+
+    MR::RenderBoxRaycastPyramid(glm::mat4(1.0f), FocalLength, FocalPoint, Width, Height, Settings.m_PyramidLevelCount, RaycastPyramid);
+
+    BASE_TIME_RESET();
+
+    Tracker.CreateReferencePyramid(Depth.data(), ReferencePyramid);
+
+    BASE_TIME_LOG(Create_Reference_Pyramid_640x480);
+
+    BASE_TIME_RESET();
+
+    Tracker.Track(glm::mat4(1.0f), ReferencePyramid, RaycastPyramid);
+
+    BASE_TIME_LOG(Track_640x480);
+
+    BASE_CHECK(!Tracker.IsTrackingLost());
+}
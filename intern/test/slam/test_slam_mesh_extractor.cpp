@@ -0,0 +1,387 @@
+
+#include "test_precompiled.h"
+
+#include "slam/test_slam_sphere_bricks.h"
+
+#include "base/base_test_defines.h"
+
+#include "plugin/slam/mr_mesh_extractor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    const float g_VoxelSize = 0.01f;
+    const float g_TruncatedDistance = 0.04f;
+
+    const glm::vec3 g_SphereCenter(0.013f, -0.021f, 0.007f);
+
+    // -----------------------------------------------------------------------------
+    // Feeds all bricks within the truncation band of a sphere into the extractor
+    // -----------------------------------------------------------------------------
+    int AddSphere(MR::CMeshExtractor& _rExtractor, float _Radius)
+    {
+        std::vector<glm::ivec3> Keys;
+        std::vector<MR::CMeshExtractor::SVoxel> Voxels;
+
+        MR::CreateSphereBricks(g_SphereCenter, _Radius, g_VoxelSize, g_TruncatedDistance, Keys, Voxels);
+
+        for (size_t IndexOfBrick = 0; IndexOfBrick < Keys.size(); ++IndexOfBrick)
+        {
+            _rExtractor.SetBrick(Keys[IndexOfBrick], &Voxels[IndexOfBrick * MR::CMeshExtractor::s_VoxelsPerBrick]);
+        }
+
+        return static_cast<int>(Keys.size());
+    }
+
+    // -----------------------------------------------------------------------------
+    // Closed and consistently oriented: every directed edge appears exactly once
+    // and its opposite exists as well.
+    // -----------------------------------------------------------------------------
+    bool IsClosedManifold(const MR::CMeshExtractor::CIndices& _rIndices)
+    {
+        std::map<std::pair<uint32_t, uint32_t>, int> DirectedEdges;
+
+        for (size_t Index = 0; Index < _rIndices.size(); Index += 3)
+        {
+            for (int Edge = 0; Edge < 3; ++Edge)
+            {
+                const uint32_t From = _rIndices[Index + Edge];
+                const uint32_t To = _rIndices[Index + (Edge + 1) % 3];
+
+                if (From == To) continue;
+
+                ++DirectedEdges[std::make_pair(From, To)];
+            }
+        }
+
+        for (const auto& rEdge : DirectedEdges)
+        {
+            if (rEdge.second != 1) return false;
+
+            if (DirectedEdges.count(std::make_pair(rEdge.first.second, rEdge.first.first)) == 0) return false;
+        }
+
+        return !DirectedEdges.empty();
+    }
+} // namespace
+
+BASE_TEST(Test_SLAM_Mesh_Extractor_Sphere)
+{
+    const float Radius = 0.15f;
+
+    MR::CMeshExtractor Extractor(g_VoxelSize);
+
+    const int NumberOfBricks = AddSphere(Extractor, Radius);
+
+    BASE_CHECK(Extractor.GetNumberOfBricks() == NumberOfBricks);
+    BASE_CHECK(Extractor.Extract() == NumberOfBricks);
+
+    MR::CMeshExtractor::CVertices Vertices;
+    MR::CMeshExtractor::CIndices Indices;
+
+    Extractor.GetMesh(Vertices, Indices);
+
+    BASE_CHECK(!Vertices.empty());
+    BASE_CHECK(Indices.size() % 3 == 0);
+    BASE_CHECK(Extractor.GetNumberOfTriangles() == static_cast<int>(Indices.size() / 3));
+
+    // -----------------------------------------------------------------------------
+    // Welding across brick borders leaves no holes
+    // -----------------------------------------------------------------------------
+    BASE_CHECK(IsClosedManifold(Indices));
+
+    float MaxError = 0.0f;
+    float MinNormalDot = 1.0f;
+
+    for (const MR::CMeshExtractor::SVertex& rVertex : Vertices)
+    {
+        const glm::vec3 Direction = glm::normalize(rVertex.m_Position - g_SphereCenter);
+
+        MaxError = std::max(MaxError, std::abs(glm::distance(rVertex.m_Position, g_SphereCenter) - Radius));
+        MinNormalDot = std::min(MinNormalDot, glm::dot(rVertex.m_Normal, Direction));
+    }
+
+    BASE_CHECK(MaxError < 0.1f * g_VoxelSize);
+    BASE_CHECK(MinNormalDot > 0.99f);
+
+    // -----------------------------------------------------------------------------
+    // Triangles face the free space
+    // -----------------------------------------------------------------------------
+    bool IsFacingOutside = true;
+
+    for (size_t Index = 0; Index < Indices.size(); Index += 3)
+    {
+        const glm::vec3& rA = Vertices[Indices[Index + 0]].m_Position;
+        const glm::vec3& rB = Vertices[Indices[Index + 1]].m_Position;
+        const glm::vec3& rC = Vertices[Indices[Index + 2]].m_Position;
+
+        const glm::vec3 FaceNormal = glm::cross(rB - rA, rC - rA);
+
+        IsFacingOutside &= glm::dot(FaceNormal, (rA + rB + rC) / 3.0f - g_SphereCenter) >= 0.0f;
+    }
+
+    BASE_CHECK(IsFacingOutside);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_SLAM_Mesh_Extractor_Incremental)
+{
+    MR::CMeshExtractor Extractor(g_VoxelSize);
+
+    AddSphere(Extractor, 0.15f);
+
+    Extractor.Extract();
+
+    // -----------------------------------------------------------------------------
+    // Unchanged voxels do not cause any work
+    // -----------------------------------------------------------------------------
+    AddSphere(Extractor, 0.15f);
+
+    BASE_CHECK(Extractor.GetNumberOfDirtyBricks() == 0);
+    BASE_CHECK(Extractor.Extract() == 0);
+
+    // -----------------------------------------------------------------------------
+    // A changed brick re-meshes itself and its existing neighbours only
+    // -----------------------------------------------------------------------------
+    const int BrickResolution = MR::CMeshExtractor::s_BrickResolution;
+    const float Radius = 0.15f;
+    const glm::ivec3 Key = glm::ivec3(glm::floor((g_SphereCenter + glm::vec3(Radius, 0.0f, 0.0f)) / (BrickResolution * g_VoxelSize)));
+
+    MR::CMeshExtractor::SVoxel Voxels[MR::CMeshExtractor::s_VoxelsPerBrick];
+
+    for (int Index = 0; Index < MR::CMeshExtractor::s_VoxelsPerBrick; ++Index)
+    {
+        const glm::ivec3 Voxel(Index % BrickResolution, (Index / BrickResolution) % BrickResolution, Index / (BrickResolution * BrickResolution));
+        const glm::vec3 Position = glm::vec3(Key * BrickResolution + Voxel) * g_VoxelSize;
+
+        const float SDF = glm::distance(Position, g_SphereCenter) - (Radius + 0.003f);
+
+        Voxels[Index].m_TSDF = std::min(std::max(SDF / g_TruncatedDistance, -1.0f), 1.0f);
+        Voxels[Index].m_Weight = 10.0f;
+    }
+
+    Extractor.SetBrick(Key, Voxels);
+
+    const int NumberOfDirtyBricks = Extractor.Extract();
+
+    BASE_CHECK(NumberOfDirtyBricks > 1 && NumberOfDirtyBricks <= 27);
+
+    MR::CMeshExtractor::CVertices Vertices;
+    MR::CMeshExtractor::CIndices Indices;
+
+    Extractor.GetMesh(Vertices, Indices);
+
+    BASE_CHECK(Extractor.GetNumberOfTriangles() == static_cast<int>(Indices.size() / 3));
+
+    // -----------------------------------------------------------------------------
+    // Removing bricks opens the surface
+    // -----------------------------------------------------------------------------
+    Extractor.RemoveBrick(Key);
+    Extractor.Extract();
+    Extractor.GetMesh(Vertices, Indices);
+
+    BASE_CHECK(!IsClosedManifold(Indices));
+
+    Extractor.Clear();
+
+    BASE_CHECK(Extractor.GetNumberOfBricks() == 0);
+    BASE_CHECK(Extractor.GetNumberOfTriangles() == 0);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_SLAM_Mesh_Extractor_Volume)
+{
+    struct SGridPoolItem
+    {
+        int32_t m_PoolIndex;
+        int32_t m_NearSurface;
+    };
+
+    const int BrickResolution = MR::CMeshExtractor::s_BrickResolution;
+    const int VoxelsPerBrick = MR::CMeshExtractor::s_VoxelsPerBrick;
+    const int Resolution = 2;
+    const int VoxelsPerGrid = Resolution * Resolution * Resolution;
+    const float MaxWeight = 100.0f;
+    const float Radius = 0.09f;
+
+    const glm::ivec3 RootOffset(1, 0, -1);
+    const glm::vec3 Center(0.48f, 0.16f, -0.16f);
+
+    auto IndexToOffset = [](int _Index, int _Resolution)
+    {
+        return glm::ivec3(_Index % _Resolution, (_Index / _Resolution) % _Resolution, _Index / (_Resolution * _Resolution));
+    };
+
+    // -----------------------------------------------------------------------------
+    // Root grid 1 covers the bricks around the sphere, root grid 0 is empty.
+    // The bricks are packed in both layouts of the TSDF pool.
+    // -----------------------------------------------------------------------------
+    std::vector<SGridPoolItem> RootGridPool(2 * VoxelsPerGrid, SGridPoolItem{ -1, 0 });
+    std::vector<SGridPoolItem> Level1Pool;
+    std::vector<int16_t> TSDFPool;
+    std::vector<uint32_t> TSDFColorPool;
+
+    MR::CMeshExtractor Reference(g_VoxelSize);
+
+    MR::CMeshExtractor::SVoxel Voxels[VoxelsPerBrick];
+
+    int NumberOfBricks = 0;
+
+    for (int RootIndex = 0; RootIndex < VoxelsPerGrid; ++RootIndex)
+    {
+        RootGridPool[VoxelsPerGrid + RootIndex].m_PoolIndex = RootIndex;
+
+        for (int Level1Index = 0; Level1Index < VoxelsPerGrid; ++Level1Index)
+        {
+            const glm::ivec3 Key = (RootOffset * Resolution + IndexToOffset(RootIndex, Resolution)) * Resolution + IndexToOffset(Level1Index, Resolution);
+
+            bool IsNearSurface = false;
+
+            for (int Index = 0; Index < VoxelsPerBrick; ++Index)
+            {
+                const glm::vec3 Position = glm::vec3(Key * BrickResolution + IndexToOffset(Index, BrickResolution)) * g_VoxelSize;
+
+                const float SDF = glm::distance(Position, Center) - Radius;
+
+                Voxels[Index].m_TSDF = std::min(std::max(SDF / g_TruncatedDistance, -1.0f), 1.0f);
+                Voxels[Index].m_Weight = MaxWeight;
+
+                IsNearSurface |= std::abs(SDF) < g_TruncatedDistance;
+            }
+
+            if (!IsNearSurface)
+            {
+                Level1Pool.push_back(SGridPoolItem{ -1, 0 });
+
+                continue;
+            }
+
+            Level1Pool.push_back(SGridPoolItem{ NumberOfBricks++, 1 });
+
+            for (const MR::CMeshExtractor::SVoxel& rVoxel : Voxels)
+            {
+                uint32_t TSDF;
+
+                std::memcpy(&TSDF, &rVoxel.m_TSDF, sizeof(TSDF));
+
+                TSDFPool.push_back(static_cast<int16_t>(std::round(rVoxel.m_TSDF * 32767.0f)));
+                TSDFPool.push_back(32767);
+
+                TSDFColorPool.push_back(TSDF);
+                TSDFColorPool.push_back(0xFF808080);
+            }
+
+            Reference.SetBrick(Key, Voxels);
+        }
+    }
+
+    MR::CMeshExtractor::SVolume Volume;
+
+    Volume.m_pRootGridPool = reinterpret_cast<const char*>(RootGridPool.data());
+    Volume.m_pLevel1Pool = reinterpret_cast<const char*>(Level1Pool.data());
+    Volume.m_pTSDFPool = reinterpret_cast<const char*>(TSDFColorPool.data());
+    Volume.m_GridPoolItemSize = sizeof(SGridPoolItem);
+    Volume.m_RootResolution = Resolution;
+    Volume.m_Level1Resolution = Resolution;
+    Volume.m_CaptureColor = true;
+    Volume.m_MaxWeight = MaxWeight;
+
+    MR::CMeshExtractor::CVertices ReferenceVertices;
+    MR::CMeshExtractor::CIndices ReferenceIndices;
+
+    Reference.Extract();
+    Reference.GetMesh(ReferenceVertices, ReferenceIndices);
+
+    // -----------------------------------------------------------------------------
+    // Colour layout: the same voxels as the reference, so the same mesh
+    // -----------------------------------------------------------------------------
+    MR::CMeshExtractor Extractor(g_VoxelSize);
+
+    BASE_CHECK(Extractor.SetBricks(Volume, glm::ivec3(0), 0) == 0);
+    BASE_CHECK(Extractor.SetBricks(Volume, RootOffset, 1) == NumberOfBricks);
+    BASE_CHECK(Extractor.GetNumberOfBricks() == NumberOfBricks);
+    BASE_CHECK(Extractor.Extract() == NumberOfBricks);
+
+    MR::CMeshExtractor::CVertices Vertices;
+    MR::CMeshExtractor::CIndices Indices;
+
+    Extractor.GetMesh(Vertices, Indices);
+
+    BASE_CHECK(IsClosedManifold(Indices));
+    BASE_CHECK(Vertices.size() == ReferenceVertices.size() && Indices.size() == ReferenceIndices.size());
+
+    // -----------------------------------------------------------------------------
+    // Snorm layout: the same bricks, the surface moves by the quantization only
+    // -----------------------------------------------------------------------------
+    Volume.m_pTSDFPool = reinterpret_cast<const char*>(TSDFPool.data());
+    Volume.m_CaptureColor = false;
+
+    Extractor.Clear();
+
+    BASE_CHECK(Extractor.SetBricks(Volume, RootOffset, 1) == NumberOfBricks);
+    BASE_CHECK(Extractor.Extract() == NumberOfBricks);
+
+    Extractor.GetMesh(Vertices, Indices);
+
+    BASE_CHECK(IsClosedManifold(Indices));
+
+    float MaxError = 0.0f;
+
+    for (const MR::CMeshExtractor::SVertex& rVertex : Vertices)
+    {
+        MaxError = std::max(MaxError, std::abs(glm::distance(rVertex.m_Position, Center) - Radius));
+    }
+
+    BASE_CHECK(MaxError < 0.1f * g_VoxelSize);
+
+    // -----------------------------------------------------------------------------
+    // Reading the same volume again changes nothing
+    // -----------------------------------------------------------------------------
+    Extractor.SetBricks(Volume, RootOffset, 1);
+
+    BASE_CHECK(Extractor.GetNumberOfDirtyBricks() == 0);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_SLAM_Mesh_Extractor_Timing)
+{
+    MR::CMeshExtractor Extractor(g_VoxelSize);
+
+    const int NumberOfBricks = AddSphere(Extractor, 0.6f);
+
+    BASE_CHECK(NumberOfBricks > 1000);
+
+    BASE_TIME_RESET();
+
+    Extractor.Extract();
+
+    BASE_TIME_LOG(Extract_Sphere_Bricks);
+
+    MR::CMeshExtractor::CVertices Vertices;
+    MR::CMeshExtractor::CIndices Indices;
+
+    BASE_TIME_RESET();
+
+    Extractor.GetMesh(Vertices, Indices);
+
+    BASE_TIME_LOG(Weld_Sphere_Bricks);
+
+    BASE_TIME_RESET();
+
+    AddSphere(Extractor, 0.6f);
+
+    Extractor.Extract();
+
+    BASE_TIME_LOG(Extract_Unchanged_Sphere_Bricks);
+
+    BASE_CHECK(Extractor.GetNumberOfTriangles() == static_cast<int>(Indices.size() / 3));
+}
@@ -0,0 +1,69 @@
+
+#pragma once
+
+#include "base/base_include_glm.h"
+
+#include "plugin/slam/mr_mesh_extractor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace MR
+{
+    // -----------------------------------------------------------------------------
+    // All bricks within the truncation band of a sphere for the mesh extractor
+    // tests and benchmarks. The voxels of the brick with the n-th key start at
+    // n * CMeshExtractor::s_VoxelsPerBrick.
+    // -----------------------------------------------------------------------------
+    inline void CreateSphereBricks(const glm::vec3& _rCenter, float _Radius, float _VoxelSize, float _TruncatedDistance, std::vector<glm::ivec3>& _rKeys, std::vector<CMeshExtractor::SVoxel>& _rVoxels)
+    {
+        const int BrickResolution = CMeshExtractor::s_BrickResolution;
+        const float BrickSize = BrickResolution * _VoxelSize;
+
+        const glm::ivec3 MinKey = glm::ivec3(glm::floor((_rCenter - _Radius - _TruncatedDistance) / BrickSize));
+        const glm::ivec3 MaxKey = glm::ivec3(glm::floor((_rCenter + _Radius + _TruncatedDistance) / BrickSize));
+
+        CMeshExtractor::SVoxel Voxels[CMeshExtractor::s_VoxelsPerBrick];
+
+        for (int BrickZ = MinKey.z; BrickZ <= MaxKey.z; ++BrickZ)
+        {
+            for (int BrickY = MinKey.y; BrickY <= MaxKey.y; ++BrickY)
+            {
+                for (int BrickX = MinKey.x; BrickX <= MaxKey.x; ++BrickX)
+                {
+                    const glm::ivec3 Key(BrickX, BrickY, BrickZ);
+
+                    bool IsNearSurface = false;
+
+                    for (int z = 0; z < BrickResolution; ++z)
+                    {
+                        for (int y = 0; y < BrickResolution; ++y)
+                        {
+                            for (int x = 0; x < BrickResolution; ++x)
+                            {
+                                const glm::vec3 Position = glm::vec3(Key * BrickResolution + glm::ivec3(x, y, z)) * _VoxelSize;
+
+                                const float SDF = glm::distance(Position, _rCenter) - _Radius;
+
+                                CMeshExtractor::SVoxel& rVoxel = Voxels[(z * BrickResolution + y) * BrickResolution + x];
+
+                                rVoxel.m_TSDF = std::min(std::max(SDF / _TruncatedDistance, -1.0f), 1.0f);
+                                rVoxel.m_Weight = 10.0f;
+
+                                IsNearSurface |= std::abs(SDF) < _TruncatedDistance;
+                            }
+                        }
+                    }
+
+                    if (IsNearSurface)
+                    {
+                        _rKeys.push_back(Key);
+
+                        _rVoxels.insert(_rVoxels.end(), Voxels, Voxels + CMeshExtractor::s_VoxelsPerBrick);
+                    }
+                }
+            }
+        }
+    }
+} // namespace MR
@@ -0,0 +1,229 @@
+
+#include "test_precompiled.h"
+
+#include "base/base_compression.h"
+#include "base/base_test_defines.h"
+
+#include "plugin/slam/mr_slam_stream_parser.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    using CParser = MR::CSLAMStreamParser;
+
+    template<typename TValue>
+    void Append(std::vector<char>& _rBytes, const TValue& _rValue)
+    {
+        const char* pValue = reinterpret_cast<const char*>(&_rValue);
+
+        _rBytes.insert(_rBytes.end(), pValue, pValue + sizeof(_rValue));
+    }
+
+    // -----------------------------------------------------------------------------
+
+    Net::CMessage CreateMessage(const std::vector<char>& _rBytes, bool _IsCompressed)
+    {
+        Net::CMessage Message;
+
+        std::vector<char> Payload = _rBytes;
+
+        if (_IsCompressed)
+        {
+            Base::Compress(_rBytes, Payload, 1);
+        }
+
+        Message.m_CompressedSize   = static_cast<int>(Payload.size());
+        Message.m_DecompressedSize = static_cast<int>(_rBytes.size());
+        Message.m_Payload          = Net::CPayload(std::move(Payload));
+
+        return Message;
+    }
+
+    // -----------------------------------------------------------------------------
+
+    std::vector<char> CreateDepthFrame(int _Width, int _Height)
+    {
+        std::vector<char> Bytes;
+
+        Append(Bytes, static_cast<int32_t>(CParser::DEPTHFRAME));
+        Append(Bytes, static_cast<int32_t>(_Width));
+        Append(Bytes, static_cast<int32_t>(_Height));
+        Append(Bytes, glm::vec2(525.0f, 526.0f));
+        Append(Bytes, glm::vec2(320.0f, 240.0f));
+
+        for (int IndexOfPixel = 0; IndexOfPixel < _Width * _Height; ++IndexOfPixel)
+        {
+            Append(Bytes, static_cast<uint16_t>(1000 + IndexOfPixel));
+        }
+
+        return Bytes;
+    }
+} // namespace
+
+BASE_TEST(Test_SLAM_StreamParser_Frames)
+{
+    CParser Parser;
+
+    CParser::SMessage Message;
+
+    // -----------------------------------------------------------------------------
+    // Depth frames are read in place or from the decompressed bytes. The
+    // views of the result stay valid as long as the message.
+    // -----------------------------------------------------------------------------
+    const std::vector<char> Depth = CreateDepthFrame(8, 4);
+
+    for (bool IsCompressed : { false, true })
+    {
+        const Net::CMessage DepthMessage = CreateMessage(Depth, IsCompressed);
+
+        BASE_CHECK(Parser.Parse(DepthMessage, Message));
+
+        BASE_CHECK(Message.m_Type == CParser::DEPTHFRAME);
+        BASE_CHECK(Message.m_DepthFrame.m_Size == glm::ivec2(8, 4));
+        BASE_CHECK(Message.m_DepthFrame.m_FocalLength == glm::vec2(525.0f, 526.0f));
+        BASE_CHECK(Message.m_DepthFrame.m_FocalPoint == glm::vec2(320.0f, 240.0f));
+        BASE_CHECK(Message.m_DepthFrame.m_pPixels[0] == 1000 && Message.m_DepthFrame.m_pPixels[31] == 1031);
+    }
+
+    // -----------------------------------------------------------------------------
+    // The UV plane of a color frame follows the full resolution Y plane
+    // -----------------------------------------------------------------------------
+    std::vector<char> Color;
+
+    Append(Color, static_cast<int32_t>(CParser::COLORFRAME));
+    Append(Color, static_cast<int32_t>(4));
+    Append(Color, static_cast<int32_t>(2));
+    Append(Color, glm::vec2(500.0f));
+    Append(Color, glm::vec2(2.0f, 1.0f));
+    Append(Color, glm::mat4(2.0f));
+
+    Color.insert(Color.end(), 8, 'y');
+    Color.insert(Color.end(), 4, 'u');
+
+    const Net::CMessage ColorMessage = CreateMessage(Color, false);
+
+    BASE_CHECK(Parser.Parse(ColorMessage, Message));
+
+    BASE_CHECK(Message.m_Type == CParser::COLORFRAME);
+    BASE_CHECK(Message.m_ColorFrame.m_Size == glm::ivec2(4, 2));
+    BASE_CHECK(Message.m_ColorFrame.m_ProjectionMatrix == glm::mat4(2.0f));
+    BASE_CHECK(Message.m_ColorFrame.m_pY[0] == 'y' && Message.m_ColorFrame.m_pY[7] == 'y');
+    BASE_CHECK(Message.m_ColorFrame.m_pUV[0] == 'u' && Message.m_ColorFrame.m_pUV[3] == 'u');
+
+    // -----------------------------------------------------------------------------
+    // Planes have an ID of 16 characters and an optional mesh
+    // -----------------------------------------------------------------------------
+    std::vector<char> Plane;
+
+    Append(Plane, static_cast<int32_t>(CParser::PLANE));
+
+    Plane.insert(Plane.end(), 16, 'p');
+
+    Append(Plane, static_cast<int32_t>(CParser::UPDATEPLANE));
+    Append(Plane, glm::mat4(1.0f));
+    Append(Plane, glm::vec4(1.0f, 0.0f, 2.0f, 0.0f));
+
+    BASE_CHECK(Parser.Parse(CreateMessage(Plane, false), Message));
+
+    BASE_CHECK(Message.m_Plane.m_ID == std::string(16, 'p'));
+    BASE_CHECK(Message.m_Plane.m_Action == CParser::UPDATEPLANE);
+    BASE_CHECK(Message.m_Plane.m_Extent == glm::vec4(1.0f, 0.0f, 2.0f, 0.0f));
+    BASE_CHECK(Message.m_Plane.m_NumberOfVertices == 0 && Message.m_Plane.m_pVertices == nullptr);
+
+    Append(Plane, static_cast<int32_t>(3));
+
+    for (int IndexOfVertex = 0; IndexOfVertex < 3; ++IndexOfVertex) Append(Plane, glm::vec4(static_cast<float>(IndexOfVertex)));
+
+    Append(Plane, static_cast<int32_t>(3));
+
+    for (int IndexOfVertex = 0; IndexOfVertex < 3; ++IndexOfVertex) Append(Plane, glm::vec2(0.5f));
+
+    Append(Plane, static_cast<int32_t>(3));
+
+    for (uint16_t Index = 0; Index < 3; ++Index) Append(Plane, Index);
+
+    const Net::CMessage PlaneMessage = CreateMessage(Plane, true);
+
+    BASE_CHECK(Parser.Parse(PlaneMessage, Message));
+
+    BASE_CHECK(Message.m_Plane.m_NumberOfVertices == 3 && Message.m_Plane.m_NumberOfIndices == 3);
+    BASE_CHECK(Message.m_Plane.m_pVertices[2] == glm::vec4(2.0f));
+    BASE_CHECK(Message.m_Plane.m_pUVs[1] == glm::vec2(0.5f));
+    BASE_CHECK(Message.m_Plane.m_pIndices[2] == 2);
+
+    // -----------------------------------------------------------------------------
+    // A plane that is a slice at an odd offset is copied, so its views are
+    // still aligned
+    // -----------------------------------------------------------------------------
+    std::vector<char> Shifted(1, 0);
+
+    Shifted.insert(Shifted.end(), Plane.begin(), Plane.end());
+
+    Net::CMessage ShiftedMessage;
+
+    ShiftedMessage.m_CompressedSize   = static_cast<int>(Plane.size());
+    ShiftedMessage.m_DecompressedSize = static_cast<int>(Plane.size());
+    ShiftedMessage.m_Payload          = Net::CPayload(std::make_shared<const std::vector<char>>(Shifted), 1, Plane.size());
+
+    BASE_CHECK(Parser.Parse(ShiftedMessage, Message));
+
+    BASE_CHECK(reinterpret_cast<uintptr_t>(Message.m_Plane.m_pVertices) % alignof(glm::vec4) == 0);
+    BASE_CHECK(Message.m_Plane.m_pVertices[2] == glm::vec4(2.0f));
+    BASE_CHECK(Message.m_Plane.m_pIndices[2] == 2);
+}
+
+// -----------------------------------------------------------------------------
+
+BASE_TEST(Test_SLAM_StreamParser_Invalid)
+{
+    CParser Parser;
+
+    CParser::SMessage Message;
+
+    // -----------------------------------------------------------------------------
+    // Truncated frames, unknown types and corrupt data are refused
+    // -----------------------------------------------------------------------------
+    std::vector<char> Depth = CreateDepthFrame(8, 4);
+
+    Depth.pop_back();
+
+    BASE_CHECK(!Parser.Parse(CreateMessage(Depth, false), Message));
+    BASE_CHECK(!Parser.Parse(CreateMessage(std::vector<char>(2, 0), false), Message));
+
+    std::vector<char> Unknown;
+
+    Append(Unknown, static_cast<int32_t>(42));
+
+    BASE_CHECK(!Parser.Parse(CreateMessage(Unknown, false), Message));
+
+    Net::CMessage Corrupt = CreateMessage(CreateDepthFrame(8, 4), false);
+
+    Corrupt.m_DecompressedSize *= 2;
+
+    BASE_CHECK(!Parser.Parse(Corrupt, Message));
+
+    // -----------------------------------------------------------------------------
+    // The decompressed size comes from the network and is checked before
+    // anything is reserved for it
+    // -----------------------------------------------------------------------------
+    Net::CMessage Oversized = CreateMessage(CreateDepthFrame(8, 4), true);
+
+    for (int DecompressedSize : { -1, 0x7FFFFFFF })
+    {
+        Oversized.m_DecompressedSize = DecompressedSize;
+
+        BASE_CHECK(!Parser.Parse(Oversized, Message));
+    }
+
+    // -----------------------------------------------------------------------------
+    // The parser is still usable afterwards
+    // -----------------------------------------------------------------------------
+    const Net::CMessage DepthMessage = CreateMessage(CreateDepthFrame(2, 2), true);
+
+    BASE_CHECK(Parser.Parse(DepthMessage, Message));
+    BASE_CHECK(Message.m_DepthFrame.m_pPixels[3] == 1003);
+}